@@ -6,7 +6,7 @@
 #define _XRESPROTO_H
 
 #define XRES_MAJOR_VERSION 1
-#define XRES_MINOR_VERSION 2
+#define XRES_MINOR_VERSION 3
 
 #define XRES_NAME "X-Resource"
 
@@ -24,6 +24,9 @@
 #define X_XResQueryClientIds          4
 #define X_XResQueryResourceBytes      5
 
+/* v1.3 */
+#define X_XResQueryClientStats        6
+
 typedef struct {
    CARD32 resource_base;
    CARD32 resource_mask;
@@ -224,4 +227,37 @@ typedef struct {
 } xXResQueryResourceBytesReply;
 #define sz_xXResQueryResourceBytesReply  32
 
+/* v1.3 XResQueryClientStats */
+
+typedef struct _XResQueryClientStats {
+   CARD8   reqType;
+   CARD8   XResReqType;
+   CARD16  length;
+   CARD32  xid;
+} xXResQueryClientStatsReq;
+#define sz_xXResQueryClientStatsReq 8
+
+typedef struct {
+   CARD32  resource_type;
+   CARD32  count;
+   CARD32  bytes;
+   CARD32  bytes_overflow;
+} xXResTypeBytes;
+#define sz_xXResTypeBytes 16
+
+typedef struct {
+   CARD8   type;
+   CARD8   pad1;
+   CARD16  sequenceNumber;
+   CARD32  length;
+   CARD32  numTypes;
+   CARD32  requests;
+   CARD32  time;               /* microseconds spent in its requests */
+   CARD32  time_overflow;
+   CARD32  outputPending;      /* bytes queued for the client */
+   CARD32  outputSize;         /* bytes of output buffer */
+   // followed by numTypes times XResTypeBytes
+} xXResQueryClientStatsReply;
+#define sz_xXResQueryClientStatsReply  32
+
 #endif /* _XRESPROTO_H */
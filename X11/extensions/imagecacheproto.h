@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * IMAGE-CACHE: PutImage by content key.
+ *
+ * The server keeps, for each client, the images that client sent with
+ * ImageCachePutImage, under a 128-bit key of the client's choosing
+ * (normally a hash of the image data).  A later ImageCachePutImage with
+ * the same key and no data draws the stored image, so an image the client
+ * has sent before costs 40 bytes on the wire instead of its full size.
+ *
+ * The client can tell which keys the server holds without asking.  Each
+ * client's cache changes only through its own requests, and is trimmed
+ * deterministically: an entry costs the length of its (padded) image
+ * data; before an entry is added, least recently used entries are dropped
+ * until it fits in the budget reported by ImageCacheQueryVersion; an
+ * entry larger than the budget is not kept; and drawing an entry makes it
+ * the most recently used.  A client replaying these rules knows the
+ * server's cache contents exactly.  Should the two ever disagree, a
+ * key-only request for a missing key fails with ImageCacheBadKey, and
+ * ImageCacheReset empties the cache so both sides can start over.
+ */
+
+#ifndef _IMAGECACHEPROTO_H_
+#define _IMAGECACHEPROTO_H_
+
+#include <X11/Xmd.h>
+
+#define IMAGECACHE_NAME			"IMAGE-CACHE"
+#define IMAGECACHE_MAJOR		1
+#define IMAGECACHE_MINOR		0
+
+#define X_ImageCacheQueryVersion	0
+#define X_ImageCachePutImage		1
+#define X_ImageCacheReset		2
+
+#define ImageCacheNumberEvents		0
+
+#define ImageCacheBadKey		0
+#define ImageCacheNumberErrors		(ImageCacheBadKey + 1)
+
+typedef struct {
+    CARD8	reqType;
+    CARD8	imageCacheReqType;	/* X_ImageCacheQueryVersion */
+    CARD16	length;
+    CARD32	majorVersion;
+    CARD32	minorVersion;
+} xImageCacheQueryVersionReq;
+#define sz_xImageCacheQueryVersionReq	12
+
+typedef struct {
+    BYTE	type;			/* X_Reply */
+    CARD8	pad0;
+    CARD16	sequenceNumber;
+    CARD32	length;
+    CARD32	majorVersion;
+    CARD32	minorVersion;
+    CARD32	budget;			/* bytes of image data per client */
+    CARD32	pad1;
+    CARD32	pad2;
+    CARD32	pad3;
+} xImageCacheQueryVersionReply;
+#define sz_xImageCacheQueryVersionReply	32
+
+/*
+ * Followed by the image data, laid out as for PutImage, to store it under
+ * key and draw it; or by nothing, to draw the image stored under key.
+ */
+typedef struct {
+    CARD8	reqType;
+    CARD8	imageCacheReqType;	/* X_ImageCachePutImage */
+    CARD16	length;
+    CARD32	drawable;
+    CARD32	gc;
+    CARD16	width;
+    CARD16	height;
+    INT16	dstX;
+    INT16	dstY;
+    CARD8	format;
+    CARD8	depth;
+    CARD8	leftPad;
+    CARD8	pad;
+    CARD32	key0;
+    CARD32	key1;
+    CARD32	key2;
+    CARD32	key3;
+} xImageCachePutImageReq;
+#define sz_xImageCachePutImageReq	40
+
+typedef struct {
+    CARD8	reqType;
+    CARD8	imageCacheReqType;	/* X_ImageCacheReset */
+    CARD16	length;
+} xImageCacheResetReq;
+#define sz_xImageCacheResetReq		4
+
+#endif /* _IMAGECACHEPROTO_H_ */
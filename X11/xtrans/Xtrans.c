@@ -87,6 +87,8 @@ from The Open Group.
 #define TRANS_SOCKET_INET6_INDEX	14
 #define TRANS_LOCAL_PIPE_INDEX		15
 #define TRANS_HYPERV_INDEX		16
+#define TRANS_SOCKET_TCPZ_INDEX		17
+#define TRANS_SOCKET_TLS_INDEX		18
 
 
 static
@@ -97,6 +99,12 @@ Xtransport_table Xtransports[] = {
     { &TRANS(SocketINET6Funcs),	TRANS_SOCKET_INET6_INDEX },
 #endif /* IPv6 */
     { &TRANS(SocketINETFuncs),	TRANS_SOCKET_INET_INDEX },
+#if defined(TCPZCONN)
+    { &TRANS(SocketTCPZFuncs),	TRANS_SOCKET_TCPZ_INDEX },
+#endif /* TCPZCONN */
+#if defined(TLSCONN)
+    { &TRANS(SocketTLSFuncs),	TRANS_SOCKET_TLS_INDEX },
+#endif /* TLSCONN */
 #endif /* TCPCONN */
 #if defined(UNIXCONN)
 #if !defined(LOCALCONN)
@@ -817,6 +825,15 @@ int TRANS(SetHyperVPortNo)(char * sport)
 
 #endif //HYPERV
 
+#if defined(TCPCONN) && defined(TLSCONN)
+
+int TRANS(SetTLSCertificate)(const char *certfile, const char *keyfile)
+{
+    return TRANS(TlsSetCertificate)(certfile, keyfile);
+}
+
+#endif /* TLSCONN */
+
 int
 TRANS(IsListening) (const char * protocol)
 {
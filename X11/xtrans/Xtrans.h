@@ -304,6 +304,15 @@ int TRANS(SetHyperVPortNo)(
 
 #endif //HYPERV
 
+#ifdef TLSCONN
+
+int TRANS(SetTLSCertificate)(
+    const char *certfile,
+    const char *keyfile
+);
+
+#endif /* TLSCONN */
+
 #endif /* TRANS_SERVER */
 
 #ifdef TRANS_CLIENT
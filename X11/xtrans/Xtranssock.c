@@ -157,6 +157,13 @@ static unsigned int vsockPort = 106000;
 
 #endif //HYPERV
 
+/* Loopback TCP connections skip most of the TCP/IP stack when both ends
+ * enable this before connecting or listening (Windows 8 and later).
+ */
+#ifndef SIO_LOOPBACK_FAST_PATH
+#define SIO_LOOPBACK_FAST_PATH _WSAIOW(IOC_VENDOR, 16)
+#endif
+
 #endif /* WIN32 */
 
 #if defined(SO_DONTLINGER) && defined(SO_LINGER)
@@ -206,6 +213,12 @@ static Sockettrans2dev Sockettrans2devtab[] = {
     {"tcp",AF_INET,SOCK_STREAM,SOCK_DGRAM,0}, /* fallback */
     {"inet6",AF_INET6,SOCK_STREAM,SOCK_DGRAM,0},
 #endif
+#ifdef TCPZCONN
+    {"tcpz",AF_INET,SOCK_STREAM,SOCK_DGRAM,0},
+#endif
+#ifdef TLSCONN
+    {"tls",AF_INET,SOCK_STREAM,SOCK_DGRAM,0},
+#endif
 #endif /* TCPCONN */
 #ifdef UNIXCONN
     {"unix",AF_UNIX,SOCK_STREAM,SOCK_DGRAM,0},
@@ -868,6 +881,18 @@ TRANS(SocketOpen) (int i, int type)
 	int tmp = 1;
 	setsockopt (ciptr->fd, IPPROTO_TCP, TCP_NODELAY,
 	    (char *) &tmp, sizeof (int));
+#ifdef WIN32
+	{
+	    /*
+	     * Accepted sockets inherit this from the listener, so local
+	     * clients doing the same get the loopback fast path
+	     */
+	    DWORD bytes;
+
+	    WSAIoctl ((SOCKET) ciptr->fd, SIO_LOOPBACK_FAST_PATH,
+		&tmp, sizeof (int), NULL, 0, &bytes, NULL, NULL);
+	}
+#endif
     }
 #endif
 
@@ -2669,6 +2694,33 @@ TRANS(SocketWritev) (XtransConnInfo ciptr, struct iovec *buf, int size)
             discardFd(&ciptr->send_fds, cf, 0);
         return i;
     }
+#endif
+#if defined(WIN32)
+    /*
+     * Hand the whole vector to Winsock in one call, rather than one
+     * send() per piece as the generic writev emulation does.
+     */
+    {
+	WSABUF	wsabuf[16];
+	DWORD	sent;
+	int	i;
+
+	if (size <= (int) (sizeof(wsabuf) / sizeof(wsabuf[0])))
+	{
+	    for (i = 0; i < size; i++)
+	    {
+		wsabuf[i].buf = buf[i].iov_base;
+		wsabuf[i].len = buf[i].iov_len;
+	    }
+	    if (WSASend ((SOCKET)ciptr->fd, wsabuf, size, &sent, 0,
+			 NULL, NULL) == SOCKET_ERROR)
+	    {
+		errno = WSAGetLastError();
+		return -1;
+	    }
+	    return sent;
+	}
+    }
 #endif
     return WRITEV (ciptr, buf, size);
 }
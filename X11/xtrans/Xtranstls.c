@@ -0,0 +1,508 @@
+/*
+ * TLS transport ("tls").
+ *
+ * A TCP connection, IPv4 only, on X_TLS_PORT + display, with OpenSSL on
+ * top.  Only TLS 1.3 is accepted.  The server hands out session tickets,
+ * and a client that connects to the same host and port again offers the
+ * last ticket it got, so reconnects skip the certificate exchange.
+ *
+ * The server side needs a certificate and key, loaded by
+ * TRANS(SetTLSCertificate) before the listeners are created.  Clients
+ * verify the server against the default OpenSSL trust store, or against
+ * the CA file named by XTRANS_TLS_CA.
+ *
+ * The handshake is driven by the first reads and writes, so Accept never
+ * blocks on a slow client.  OpenSSL picks AES-NI (or the platform's other
+ * accelerated AES code) for the record layer by itself; the cipher suites
+ * are ordered so AES-GCM is preferred.
+ */
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#ifdef X11_t
+#define X_TLS_PORT	7200
+#endif
+
+#define TLS_CIPHERSUITES \
+    "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256"
+
+/* Writev gathers up to this much into one SSL_write() */
+#define TLS_GATHER_SIZE	(64 * 1024)
+
+typedef struct _TlsConn {
+    SSL		*ssl;
+    char	*gather;
+} TlsConn;
+
+#define TLSPRIV(ciptr)	((TlsConn *) (ciptr)->priv)
+
+#ifdef TRANS_SERVER
+static SSL_CTX *tls_server_ctx;
+#endif
+#ifdef TRANS_CLIENT
+static SSL_CTX *tls_client_ctx;
+static SSL_SESSION *tls_client_session;
+static char tls_client_peer[MAXHOSTNAMELEN + PORTBUFSIZE];
+#endif
+
+static void
+TRANS(TlsLogErrors) (const char *where)
+
+{
+    unsigned long err;
+    char	buf[256];
+
+    while ((err = ERR_get_error ()) != 0)
+    {
+	ERR_error_string_n (err, buf, sizeof (buf));
+	prmsg (1, "%s: %s\n", where, buf);
+    }
+}
+
+static int
+TRANS(TlsFixupPort) (const char *port, char *portbuf, int size)
+
+{
+#ifdef X11_t
+    /* a display number, not a service name */
+    if (port && is_numeric (port))
+    {
+	long tmpport = X_TLS_PORT - X_TCP_PORT + strtol (port, NULL, 10);
+	snprintf (portbuf, size, "%ld", tmpport);
+	return 1;
+    }
+#endif
+    return 0;
+}
+
+static SSL_CTX *
+TRANS(TlsNewContext) (const SSL_METHOD *method)
+
+{
+    SSL_CTX	*ctx;
+
+    if ((ctx = SSL_CTX_new (method)) == NULL)
+	return NULL;
+
+    SSL_CTX_set_min_proto_version (ctx, TLS1_3_VERSION);
+    SSL_CTX_set_ciphersuites (ctx, TLS_CIPHERSUITES);
+    /* a client that just goes away is a closed connection, not an error */
+    SSL_CTX_set_options (ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+    SSL_CTX_set_mode (ctx, SSL_MODE_ENABLE_PARTIAL_WRITE |
+			   SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER |
+			   SSL_MODE_RELEASE_BUFFERS);
+    return ctx;
+}
+
+static int
+TRANS(TlsAttach) (XtransConnInfo ciptr, SSL_CTX *ctx)
+
+{
+    TlsConn	*t;
+
+    if ((t = calloc (1, sizeof (TlsConn))) == NULL)
+	return -1;
+    if ((t->ssl = SSL_new (ctx)) == NULL)
+    {
+	free (t);
+	return -1;
+    }
+    SSL_set_fd (t->ssl, ciptr->fd);
+    ciptr->priv = (char *) t;
+    return 0;
+}
+
+static void
+TRANS(TlsDetach) (XtransConnInfo ciptr)
+
+{
+    TlsConn	*t = TLSPRIV(ciptr);
+
+    if (!t)
+	return;
+
+    /* best effort close_notify, the socket may well be non-blocking */
+    if (SSL_is_init_finished (t->ssl))
+	SSL_shutdown (t->ssl);
+    SSL_free (t->ssl);
+    free (t->gather);
+    free (t);
+    ciptr->priv = NULL;
+}
+
+/*
+ * Map an SSL_read/SSL_write result onto what the socket calls would have
+ * returned.
+ */
+
+static int
+TRANS(TlsResult) (TlsConn *t, int ret, const char *where)
+
+{
+    if (ret > 0)
+	return ret;
+
+    switch (SSL_get_error (t->ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+	errno = EAGAIN;
+	return -1;
+    case SSL_ERROR_ZERO_RETURN:
+	return 0;
+    case SSL_ERROR_SYSCALL:
+	TRANS(TlsLogErrors) (where);
+#ifdef WIN32
+	errno = WSAGetLastError ();
+#endif
+	if (errno == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+	    errno = ECONNRESET;
+	return -1;
+    default:
+	TRANS(TlsLogErrors) (where);
+	errno = ECONNRESET;
+	return -1;
+    }
+}
+
+static int
+TRANS(TlsRead) (XtransConnInfo ciptr, char *buf, int size)
+
+{
+    TlsConn	*t = TLSPRIV(ciptr);
+
+    prmsg (2,"TlsRead(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    ERR_clear_error ();
+    return TRANS(TlsResult) (t, SSL_read (t->ssl, buf, size), "TlsRead");
+}
+
+static int
+TRANS(TlsReadv) (XtransConnInfo ciptr, struct iovec *buf, int size)
+
+{
+    int		total = 0;
+    int		i;
+
+    for (i = 0; i < size; i++)
+    {
+	int n;
+
+	if (buf[i].iov_len == 0)
+	    continue;
+	n = TRANS(TlsRead) (ciptr, buf[i].iov_base, buf[i].iov_len);
+	if (n <= 0)
+	    return total > 0 ? total : n;
+	total += n;
+	if (n < (int) buf[i].iov_len)
+	    break;
+    }
+    return total;
+}
+
+static int
+TRANS(TlsWrite) (XtransConnInfo ciptr, char *buf, int size)
+
+{
+    TlsConn	*t = TLSPRIV(ciptr);
+
+    prmsg (2,"TlsWrite(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    if (size == 0)
+	return 0;
+
+    ERR_clear_error ();
+    return TRANS(TlsResult) (t, SSL_write (t->ssl, buf, size), "TlsWrite");
+}
+
+/*
+ * SSL has no gather write, and one record per iovec would add a record
+ * header to every reply pad.  Small vectors are copied into one buffer;
+ * a retry after EAGAIN passes the same bytes again, which is all
+ * SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER asks for.
+ */
+
+static int
+TRANS(TlsWritev) (XtransConnInfo ciptr, struct iovec *buf, int size)
+
+{
+    TlsConn	*t = TLSPRIV(ciptr);
+    int		total = 0;
+    int		i;
+
+    for (i = 0; i < size; i++)
+	total += buf[i].iov_len;
+
+    if (size > 1 && total <= TLS_GATHER_SIZE)
+    {
+	char *p;
+
+	if (!t->gather && (t->gather = malloc (TLS_GATHER_SIZE)) == NULL)
+	{
+	    errno = ENOMEM;
+	    return -1;
+	}
+	for (i = 0, p = t->gather; i < size; i++)
+	{
+	    memcpy (p, buf[i].iov_base, buf[i].iov_len);
+	    p += buf[i].iov_len;
+	}
+	return TRANS(TlsWrite) (ciptr, t->gather, total);
+    }
+
+    total = 0;
+    for (i = 0; i < size; i++)
+    {
+	int n;
+
+	if (buf[i].iov_len == 0)
+	    continue;
+	n = TRANS(TlsWrite) (ciptr, buf[i].iov_base, buf[i].iov_len);
+	if (n <= 0)
+	    return total > 0 ? total : n;
+	total += n;
+	if (n < (int) buf[i].iov_len)
+	    break;
+    }
+    return total;
+}
+
+static int
+TRANS(TlsBytesReadable) (XtransConnInfo ciptr, BytesReadable_t *pend)
+
+{
+    TlsConn	*t = TLSPRIV(ciptr);
+    int		pending = SSL_pending (t->ssl);
+
+    if (pending > 0)
+    {
+	*pend = pending;
+	return 0;
+    }
+    return TRANS(SocketBytesReadable) (ciptr, pend);
+}
+
+static int
+TRANS(TlsDisconnect) (XtransConnInfo ciptr)
+
+{
+    TRANS(TlsDetach) (ciptr);
+    return TRANS(SocketDisconnect) (ciptr);
+}
+
+static int
+TRANS(TlsClose) (XtransConnInfo ciptr)
+
+{
+    TRANS(TlsDetach) (ciptr);
+    return TRANS(SocketINETClose) (ciptr);
+}
+
+#ifdef TRANS_SERVER
+
+static int
+TRANS(TlsSetCertificate) (const char *certfile, const char *keyfile)
+
+{
+    SSL_CTX	*ctx;
+
+    prmsg (2, "TlsSetCertificate(%s,%s)\n", certfile, keyfile);
+
+    if ((ctx = TRANS(TlsNewContext) (TLS_server_method ())) == NULL)
+    {
+	TRANS(TlsLogErrors) ("TlsSetCertificate");
+	return -1;
+    }
+
+    if (SSL_CTX_use_certificate_chain_file (ctx, certfile) != 1 ||
+	SSL_CTX_use_PrivateKey_file (ctx, keyfile, SSL_FILETYPE_PEM) != 1 ||
+	SSL_CTX_check_private_key (ctx) != 1)
+    {
+	TRANS(TlsLogErrors) ("TlsSetCertificate");
+	SSL_CTX_free (ctx);
+	return -1;
+    }
+
+    /*
+     * Stateless tickets: resumption works without a server side session
+     * cache, and the ticket keys are per process, so a restarted server
+     * simply falls back to a full handshake.
+     */
+    SSL_CTX_set_session_cache_mode (ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_num_tickets (ctx, 1);
+    SSL_CTX_set_timeout (ctx, 12 * 60 * 60);
+
+    if (tls_server_ctx)
+	SSL_CTX_free (tls_server_ctx);
+    tls_server_ctx = ctx;
+    return 0;
+}
+
+static int
+TRANS(TlsCreateListener) (XtransConnInfo ciptr, const char *port,
+			  unsigned int flags)
+
+{
+    char	portbuf[PORTBUFSIZE];
+
+    if (!tls_server_ctx)
+    {
+	prmsg (1, "TlsCreateListener: no certificate loaded\n");
+	return TRANS_CREATE_LISTENER_FAILED;
+    }
+
+    if (TRANS(TlsFixupPort) (port, portbuf, sizeof (portbuf)))
+	port = portbuf;
+    return TRANS(SocketINETCreateListener) (ciptr, port, flags);
+}
+
+static XtransConnInfo
+TRANS(TlsAccept) (XtransConnInfo ciptr, int *status)
+
+{
+    XtransConnInfo	newciptr;
+
+    if ((newciptr = TRANS(SocketINETAccept) (ciptr, status)) == NULL)
+	return NULL;
+
+    if (TRANS(TlsAttach) (newciptr, tls_server_ctx) < 0)
+    {
+	prmsg (1, "TlsAccept: cannot create SSL connection\n");
+	close (newciptr->fd);
+	free (newciptr->addr);
+	free (newciptr->peeraddr);
+	free (newciptr);
+	*status = TRANS_ACCEPT_BAD_MALLOC;
+	return NULL;
+    }
+    SSL_set_accept_state (TLSPRIV(newciptr)->ssl);
+
+    return newciptr;
+}
+
+#endif /* TRANS_SERVER */
+
+#ifdef TRANS_CLIENT
+
+static int
+TRANS(TlsNewSession) (SSL *ssl, SSL_SESSION *session)
+
+{
+    /* TLS 1.3 tickets arrive after the handshake, keep the latest */
+    if (tls_client_session)
+	SSL_SESSION_free (tls_client_session);
+    tls_client_session = session;
+    return 1;
+}
+
+static int
+TRANS(TlsConnect) (XtransConnInfo ciptr, const char *host, const char *port)
+
+{
+    char	portbuf[PORTBUFSIZE];
+    char	peer[sizeof (tls_client_peer)];
+    const char	*cafile;
+    SSL		*ssl;
+    int		ret;
+
+    if (TRANS(TlsFixupPort) (port, portbuf, sizeof (portbuf)))
+	port = portbuf;
+
+    if ((ret = TRANS(SocketINETConnect) (ciptr, host, port)) < 0)
+	return ret;
+
+    if (!tls_client_ctx)
+    {
+	if ((tls_client_ctx = TRANS(TlsNewContext) (TLS_client_method ()))
+	    == NULL)
+	{
+	    TRANS(TlsLogErrors) ("TlsConnect");
+	    return TRANS_CONNECT_FAILED;
+	}
+	if ((cafile = getenv ("XTRANS_TLS_CA")) != NULL)
+	    SSL_CTX_load_verify_locations (tls_client_ctx, cafile, NULL);
+	else
+	    SSL_CTX_set_default_verify_paths (tls_client_ctx);
+	SSL_CTX_set_verify (tls_client_ctx, SSL_VERIFY_PEER, NULL);
+	SSL_CTX_set_session_cache_mode (tls_client_ctx,
+					SSL_SESS_CACHE_CLIENT |
+					SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb (tls_client_ctx, TRANS(TlsNewSession));
+    }
+
+    if (TRANS(TlsAttach) (ciptr, tls_client_ctx) < 0)
+    {
+	prmsg (1, "TlsConnect: cannot create SSL connection\n");
+	return TRANS_CONNECT_FAILED;
+    }
+    ssl = TLSPRIV(ciptr)->ssl;
+
+    if (host && *host)
+    {
+	SSL_set_tlsext_host_name (ssl, host);
+	SSL_set1_host (ssl, host);
+    }
+
+    /* only offer the ticket back to the server that issued it */
+    snprintf (peer, sizeof (peer), "%s:%s", host ? host : "", port);
+    if (tls_client_session && strcmp (peer, tls_client_peer) == 0)
+	SSL_set_session (ssl, tls_client_session);
+    else if (tls_client_session)
+    {
+	SSL_SESSION_free (tls_client_session);
+	tls_client_session = NULL;
+    }
+    strcpy (tls_client_peer, peer);
+
+    /* the socket is still blocking here, as for the X connection setup */
+    ERR_clear_error ();
+    if (SSL_connect (ssl) != 1)
+    {
+	TRANS(TlsLogErrors) ("TlsConnect");
+	TRANS(TlsDetach) (ciptr);
+	return TRANS_CONNECT_FAILED;
+    }
+
+    prmsg (2, "TlsConnect: %s, %s%s\n", SSL_get_version (ssl),
+	   SSL_get_cipher_name (ssl),
+	   SSL_session_reused (ssl) ? ", resumed" : "");
+    return 0;
+}
+
+#endif /* TRANS_CLIENT */
+
+Xtransport	TRANS(SocketTLSFuncs) = {
+	/* TLS over TCP */
+	"tls",
+	0,
+#ifdef TRANS_CLIENT
+	TRANS(SocketOpenCOTSClient),
+#endif /* TRANS_CLIENT */
+#ifdef TRANS_SERVER
+	NULL,
+	TRANS(SocketOpenCOTSServer),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_REOPEN
+	NULL,					/* ReopenCOTSServer */
+#endif
+	TRANS(SocketSetOption),
+#ifdef TRANS_SERVER
+	TRANS(TlsCreateListener),
+	NULL,		       			/* ResetListener */
+	TRANS(TlsAccept),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_CLIENT
+	TRANS(TlsConnect),
+#endif /* TRANS_CLIENT */
+	TRANS(TlsBytesReadable),
+	TRANS(TlsRead),
+	TRANS(TlsWrite),
+	TRANS(TlsReadv),
+	TRANS(TlsWritev),
+	TRANS(SocketSendFdInvalid),
+	TRANS(SocketRecvFdInvalid),
+	TRANS(TlsDisconnect),
+	TRANS(TlsClose),
+	TRANS(TlsClose),
+	};
@@ -0,0 +1,900 @@
+/*
+ * zlib compressed TCP transport ("tcpz").
+ *
+ * The connection is a plain TCP stream that starts with a short hello
+ * exchange, after which each side runs its own deflate stream.  Every
+ * Write/Writev call becomes one or more frames:
+ *
+ *	CARD8	type		TCPZ_FRAME_RAW or TCPZ_FRAME_DEFLATE
+ *	CARD24	length		payload bytes, most significant byte first
+ *	...	payload
+ *
+ * Deflate frames end on a Z_SYNC_FLUSH boundary, so the receiver can hand
+ * out everything it has been sent without waiting for more input.  Raw
+ * frames carry data that was not run through deflate at all and are used
+ * while the sender's compression level is 0.
+ *
+ * Hello, client to server:
+ *
+ *	"XZ" TCPZ_VERSION level 0 0 0 0
+ *
+ * level is the compression level (0-9) the client wants the server to use
+ * for replies and events, or TCPZ_LEVEL_ADAPTIVE.  The server answers with
+ * the same eight bytes, level being the one it is going to use.  Both
+ * directions then switch to framing.
+ *
+ * With an adaptive level, the sender measures how fast the socket drains
+ * and picks the level from that: the more the link holds it back, the
+ * harder it compresses, and it backs off towards raw frames when the link
+ * keeps up.
+ *
+ * The transport listens on X_TCPZ_PORT + display, IPv4 only, and is only
+ * built where TCPCONN and TCPZCONN are both defined.
+ */
+
+#include <zlib.h>
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+
+#ifdef X11_t
+#define X_TCPZ_PORT	7000
+#endif
+
+#define TCPZ_VERSION		1
+#define TCPZ_HELLO_SIZE		8
+#define TCPZ_LEVEL_ADAPTIVE	0xff
+#define TCPZ_LEVEL_START	6
+
+#define TCPZ_FRAME_RAW		0
+#define TCPZ_FRAME_DEFLATE	1
+#define TCPZ_HEADER_SIZE	4
+#define TCPZ_FRAME_MAX		0xffffff
+
+/* Input bytes per deflate frame; deflateBound() of this fits in CARD24 */
+#define TCPZ_FRAME_INPUT	(1 << 20)
+
+#define TCPZ_INBUF_SIZE		(64 * 1024)
+#define TCPZ_OUTBUF_SLACK	(64 * 1024)
+
+/* Interval over which the link throughput is measured, in ms */
+#define TCPZ_ADAPT_INTERVAL	500
+#define TCPZ_ADAPT_MIN_BYTES	(64 * 1024)
+
+#define TCPZ_WOULDBLOCK(err)	((err) == EAGAIN || (err) == EWOULDBLOCK)
+
+typedef struct _TcpzConn {
+    z_stream	deflater;
+    z_stream	inflater;
+    int		handshake_done;
+    int		level;		/* current deflate level, 0 means raw */
+    int		adaptive;
+
+    /* receive side */
+    unsigned char *inbuf;
+    int		inpos;
+    int		inlen;
+    int		frame_type;
+    int		frame_left;	/* payload bytes of the frame not read yet */
+    int		inflate_full;	/* inflate may hold more output */
+
+    /* send side */
+    unsigned char *outbuf;
+    int		outpos;
+    int		outlen;
+    int		outsize;
+    int		owed;		/* input queued but not yet reported */
+
+    /* adaptive level */
+    unsigned long window_start;
+    unsigned long window_sent;
+    int		window_blocked;
+} TcpzConn;
+
+#define TCPZ(ciptr)	((TcpzConn *) (ciptr)->priv)
+
+static unsigned long
+TRANS(TcpzMsec) (void)
+
+{
+#ifdef WIN32
+    return GetTickCount ();
+#else
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+static int
+TRANS(TcpzFixupPort) (const char *port, char *portbuf, int size)
+
+{
+#ifdef X11_t
+    /*
+     * SocketINET{CreateListener,Connect} add X_TCP_PORT to a bare display
+     * number, so shift it by the distance between the two base ports.
+     */
+    if (port && is_numeric (port))
+    {
+	long tmpport = X_TCPZ_PORT - X_TCP_PORT + strtol (port, NULL, 10);
+	snprintf (portbuf, size, "%ld", tmpport);
+	return 1;
+    }
+#endif
+    return 0;
+}
+
+static TcpzConn *
+TRANS(TcpzCreate) (int level)
+
+{
+    TcpzConn	*z;
+
+    if ((z = calloc (1, sizeof (TcpzConn))) == NULL)
+	return NULL;
+
+    if ((z->inbuf = malloc (TCPZ_INBUF_SIZE)) == NULL)
+    {
+	free (z);
+	return NULL;
+    }
+
+    z->adaptive = (level == TCPZ_LEVEL_ADAPTIVE);
+    z->level = z->adaptive ? TCPZ_LEVEL_START : level;
+
+    if (deflateInit (&z->deflater,
+		     z->level > 0 ? z->level : Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+	free (z->inbuf);
+	free (z);
+	return NULL;
+    }
+    if (inflateInit (&z->inflater) != Z_OK)
+    {
+	deflateEnd (&z->deflater);
+	free (z->inbuf);
+	free (z);
+	return NULL;
+    }
+
+    z->window_start = TRANS(TcpzMsec) ();
+
+    return z;
+}
+
+static void
+TRANS(TcpzDestroy) (XtransConnInfo ciptr)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+
+    if (!z)
+	return;
+
+    deflateEnd (&z->deflater);
+    inflateEnd (&z->inflater);
+    free (z->inbuf);
+    free (z->outbuf);
+    free (z);
+    ciptr->priv = NULL;
+}
+
+/*
+ * Only called between frames, after a sync flush, so deflateParams() has
+ * nothing left to emit.
+ */
+
+static void
+TRANS(TcpzSetLevel) (TcpzConn *z, int level)
+
+{
+    if (level > 0)
+    {
+	z->deflater.next_out = Z_NULL;
+	z->deflater.avail_out = 0;
+	deflateParams (&z->deflater, level, Z_DEFAULT_STRATEGY);
+    }
+    z->level = level;
+}
+
+/*
+ * Make room for at least size more bytes at the end of the send queue.
+ */
+
+static int
+TRANS(TcpzReserve) (TcpzConn *z, int size)
+
+{
+    unsigned char *buf;
+    int		newsize;
+
+    if (z->outpos > 0 && z->outpos == z->outlen)
+	z->outpos = z->outlen = 0;
+
+    if (z->outsize - z->outlen >= size)
+	return 0;
+
+    newsize = z->outlen + size + TCPZ_OUTBUF_SLACK;
+    if ((buf = realloc (z->outbuf, newsize)) == NULL)
+	return -1;
+
+    z->outbuf = buf;
+    z->outsize = newsize;
+    return 0;
+}
+
+static void
+TRANS(TcpzPutHeader) (TcpzConn *z, int pos, int type, int length)
+
+{
+    z->outbuf[pos] = type;
+    z->outbuf[pos + 1] = (length >> 16) & 0xff;
+    z->outbuf[pos + 2] = (length >> 8) & 0xff;
+    z->outbuf[pos + 3] = length & 0xff;
+}
+
+static int
+TRANS(TcpzQueueRaw) (TcpzConn *z, const char *data, int size)
+
+{
+    while (size > 0)
+    {
+	int len = size > TCPZ_FRAME_MAX ? TCPZ_FRAME_MAX : size;
+
+	if (TRANS(TcpzReserve) (z, TCPZ_HEADER_SIZE + len) < 0)
+	    return -1;
+	TRANS(TcpzPutHeader) (z, z->outlen, TCPZ_FRAME_RAW, len);
+	memcpy (z->outbuf + z->outlen + TCPZ_HEADER_SIZE, data, len);
+	z->outlen += TCPZ_HEADER_SIZE + len;
+	data += len;
+	size -= len;
+    }
+    return 0;
+}
+
+static int
+TRANS(TcpzDeflate) (TcpzConn *z, int flush)
+
+{
+    z_stream	*strm = &z->deflater;
+
+    do
+    {
+	if (TRANS(TcpzReserve) (z, TCPZ_OUTBUF_SLACK) < 0)
+	    return -1;
+	strm->next_out = z->outbuf + z->outlen;
+	strm->avail_out = z->outsize - z->outlen;
+	if (deflate (strm, flush) == Z_STREAM_ERROR)
+	    return -1;
+	z->outlen = z->outsize - strm->avail_out;
+    } while (strm->avail_in > 0 || strm->avail_out == 0);
+
+    return 0;
+}
+
+/*
+ * Run input through deflate, starting a new frame every TCPZ_FRAME_INPUT
+ * bytes and ending each one with a sync flush.
+ */
+
+static int
+TRANS(TcpzQueueDeflate) (TcpzConn *z, struct iovec *iov, int iovcnt)
+
+{
+    z_stream	*strm = &z->deflater;
+    int		header = -1;
+    int		frame_in = 0;
+    int		i;
+
+    for (i = 0; i < iovcnt; i++)
+    {
+	const char *data = iov[i].iov_base;
+	int	len = iov[i].iov_len;
+
+	while (len > 0)
+	{
+	    int chunk = TCPZ_FRAME_INPUT - frame_in;
+
+	    if (header < 0)
+	    {
+		if (TRANS(TcpzReserve) (z, TCPZ_HEADER_SIZE) < 0)
+		    return -1;
+		header = z->outlen;
+		z->outlen += TCPZ_HEADER_SIZE;
+		frame_in = 0;
+		chunk = TCPZ_FRAME_INPUT;
+	    }
+	    if (chunk > len)
+		chunk = len;
+
+	    strm->next_in = (Bytef *) data;
+	    strm->avail_in = chunk;
+	    if (TRANS(TcpzDeflate) (z, Z_NO_FLUSH) < 0)
+		return -1;
+	    data += chunk;
+	    len -= chunk;
+	    frame_in += chunk;
+
+	    if (frame_in < TCPZ_FRAME_INPUT)
+		continue;
+
+	    if (TRANS(TcpzDeflate) (z, Z_SYNC_FLUSH) < 0)
+		return -1;
+	    TRANS(TcpzPutHeader) (z, header, TCPZ_FRAME_DEFLATE,
+				  z->outlen - header - TCPZ_HEADER_SIZE);
+	    header = -1;
+	}
+    }
+
+    if (header >= 0)
+    {
+	if (TRANS(TcpzDeflate) (z, Z_SYNC_FLUSH) < 0)
+	    return -1;
+	TRANS(TcpzPutHeader) (z, header, TCPZ_FRAME_DEFLATE,
+			      z->outlen - header - TCPZ_HEADER_SIZE);
+    }
+    return 0;
+}
+
+/*
+ * Push out as much of the send queue as the socket takes.
+ */
+
+static int
+TRANS(TcpzDrain) (XtransConnInfo ciptr)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+
+    while (z->outpos < z->outlen)
+    {
+	int n = TRANS(SocketWrite) (ciptr, (char *) z->outbuf + z->outpos,
+				    z->outlen - z->outpos);
+	if (n < 0)
+	{
+	    if (TCPZ_WOULDBLOCK (errno))
+		z->window_blocked = 1;
+	    return -1;
+	}
+	z->outpos += n;
+	z->window_sent += n;
+    }
+
+    z->outpos = z->outlen = 0;
+    if (z->outsize > 4 * TCPZ_FRAME_INPUT)
+    {
+	free (z->outbuf);
+	z->outbuf = NULL;
+	z->outsize = 0;
+    }
+    return 0;
+}
+
+/*
+ * Pick the next compression level from what the link achieved over the
+ * last interval.  When the socket never pushed back, the link is not the
+ * bottleneck and cheaper compression is enough.
+ */
+
+static void
+TRANS(TcpzAdapt) (TcpzConn *z)
+
+{
+    static const struct {
+	unsigned long	bytes_per_sec;
+	int		level;
+    } levels[] = {
+	{ 1024 * 1024, 9 },
+	{ 4 * 1024 * 1024, 6 },
+	{ 16 * 1024 * 1024, 3 },
+	{ 64 * 1024 * 1024, 1 },
+    };
+    unsigned long now = TRANS(TcpzMsec) ();
+    unsigned long elapsed = now - z->window_start;
+    int		level;
+    unsigned int i;
+
+    if (!z->adaptive || elapsed < TCPZ_ADAPT_INTERVAL)
+	return;
+
+    if (z->window_blocked)
+    {
+	unsigned long rate = z->window_sent / elapsed * 1000;
+
+	level = 0;
+	for (i = 0; i < sizeof (levels) / sizeof (levels[0]); i++)
+	    if (rate < levels[i].bytes_per_sec)
+	    {
+		level = levels[i].level;
+		break;
+	    }
+	if (level < z->level)
+	    level = z->level;
+    }
+    else if (z->window_sent >= TCPZ_ADAPT_MIN_BYTES)
+	level = z->level > 0 ? z->level - 1 : 0;
+    else
+	level = z->level;	/* too little traffic to tell */
+
+    if (level != z->level)
+    {
+	prmsg (3, "TcpzAdapt: level %d -> %d (%lu bytes in %lu ms%s)\n",
+	       z->level, level, z->window_sent, elapsed,
+	       z->window_blocked ? ", blocked" : "");
+	TRANS(TcpzSetLevel) (z, level);
+    }
+
+    z->window_start = now;
+    z->window_sent = 0;
+    z->window_blocked = 0;
+}
+
+/*
+ * Fill the receive buffer from the socket.  Returns what the socket read
+ * returned.
+ */
+
+static int
+TRANS(TcpzFill) (XtransConnInfo ciptr)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+    int		n;
+
+    if (z->inpos > 0)
+    {
+	memmove (z->inbuf, z->inbuf + z->inpos, z->inlen - z->inpos);
+	z->inlen -= z->inpos;
+	z->inpos = 0;
+    }
+
+    n = TRANS(SocketRead) (ciptr, (char *) z->inbuf + z->inlen,
+			   TCPZ_INBUF_SIZE - z->inlen);
+    if (n > 0)
+	z->inlen += n;
+    return n;
+}
+
+static void
+TRANS(TcpzMakeHello) (unsigned char *hello, int level)
+
+{
+    memset (hello, 0, TCPZ_HELLO_SIZE);
+    hello[0] = 'X';
+    hello[1] = 'Z';
+    hello[2] = TCPZ_VERSION;
+    hello[3] = level;
+}
+
+static int
+TRANS(TcpzCheckHello) (const unsigned char *hello)
+
+{
+    if (hello[0] != 'X' || hello[1] != 'Z' || hello[2] != TCPZ_VERSION)
+	return -1;
+    if (hello[3] > 9 && hello[3] != TCPZ_LEVEL_ADAPTIVE)
+	return -1;
+    return hello[3];
+}
+
+#ifdef TRANS_SERVER
+
+/*
+ * Server side of the hello exchange, done from the first reads so that a
+ * slow client does not hold up Accept.
+ */
+
+static int
+TRANS(TcpzServerHandshake) (XtransConnInfo ciptr)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+    unsigned char hello[TCPZ_HELLO_SIZE];
+    int		level;
+    int		n;
+
+    while (z->inlen - z->inpos < TCPZ_HELLO_SIZE)
+    {
+	if ((n = TRANS(TcpzFill) (ciptr)) <= 0)
+	    return n;
+    }
+
+    if ((level = TRANS(TcpzCheckHello) (z->inbuf + z->inpos)) < 0)
+    {
+	prmsg (1, "TcpzServerHandshake: bad hello from client\n");
+	errno = EPROTO;
+	return -1;
+    }
+    z->inpos += TCPZ_HELLO_SIZE;
+
+    z->adaptive = (level == TCPZ_LEVEL_ADAPTIVE);
+    if (!z->adaptive && level != z->level)
+	TRANS(TcpzSetLevel) (z, level);
+
+    TRANS(TcpzMakeHello) (hello, level);
+    if (TRANS(TcpzReserve) (z, TCPZ_HELLO_SIZE) < 0)
+	return -1;
+    memcpy (z->outbuf + z->outlen, hello, TCPZ_HELLO_SIZE);
+    z->outlen += TCPZ_HELLO_SIZE;
+    z->handshake_done = 1;
+
+    if (TRANS(TcpzDrain) (ciptr) < 0 && !TCPZ_WOULDBLOCK (errno))
+	return -1;
+
+    prmsg (2, "TcpzServerHandshake: fd %d level %d%s\n", ciptr->fd,
+	   z->level, z->adaptive ? " (adaptive)" : "");
+    return 1;
+}
+
+#endif /* TRANS_SERVER */
+
+static int
+TRANS(TcpzRead) (XtransConnInfo ciptr, char *buf, int size)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+    int		produced = 0;
+    int		filled = 0;
+
+    prmsg (2,"TcpzRead(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+#ifdef TRANS_SERVER
+    if (!z->handshake_done)
+    {
+	int ret = TRANS(TcpzServerHandshake) (ciptr);
+
+	if (ret <= 0)
+	    return ret;
+    }
+#endif
+
+    while (produced < size)
+    {
+	int avail = z->inlen - z->inpos;
+
+	if (z->frame_left == 0 && !z->inflate_full)
+	{
+	    unsigned char *hdr = z->inbuf + z->inpos;
+
+	    if (avail < TCPZ_HEADER_SIZE)
+	    {
+		int n;
+
+		/* only touch the socket while nothing can be returned yet */
+		if (produced > 0 || filled)
+		    break;
+		filled = 1;
+		if ((n = TRANS(TcpzFill) (ciptr)) <= 0)
+		    return n;
+		continue;
+	    }
+	    z->frame_type = hdr[0];
+	    z->frame_left = (hdr[1] << 16) | (hdr[2] << 8) | hdr[3];
+	    z->inpos += TCPZ_HEADER_SIZE;
+	    if (z->frame_type != TCPZ_FRAME_RAW &&
+		z->frame_type != TCPZ_FRAME_DEFLATE)
+	    {
+		prmsg (1, "TcpzRead: bad frame type %d\n", z->frame_type);
+		errno = EPROTO;
+		return -1;
+	    }
+	    continue;
+	}
+
+	if (avail == 0 && !z->inflate_full)
+	{
+	    int n;
+
+	    if (produced > 0 || filled)
+		break;
+	    filled = 1;
+	    if ((n = TRANS(TcpzFill) (ciptr)) <= 0)
+		return n;
+	    continue;
+	}
+
+	if (avail > z->frame_left)
+	    avail = z->frame_left;
+
+	if (z->frame_type == TCPZ_FRAME_RAW)
+	{
+	    int len = size - produced;
+
+	    if (len > avail)
+		len = avail;
+	    memcpy (buf + produced, z->inbuf + z->inpos, len);
+	    z->inpos += len;
+	    z->frame_left -= len;
+	    produced += len;
+	}
+	else
+	{
+	    z_stream	*strm = &z->inflater;
+	    int		ret;
+
+	    strm->next_in = z->inbuf + z->inpos;
+	    strm->avail_in = avail;
+	    strm->next_out = (Bytef *) buf + produced;
+	    strm->avail_out = size - produced;
+	    ret = inflate (strm, Z_SYNC_FLUSH);
+	    if (ret != Z_OK && ret != Z_BUF_ERROR)
+	    {
+		prmsg (1, "TcpzRead: inflate failed (%d)\n", ret);
+		errno = EPROTO;
+		return -1;
+	    }
+	    z->inpos += avail - strm->avail_in;
+	    z->frame_left -= avail - strm->avail_in;
+	    produced = size - strm->avail_out;
+	    z->inflate_full = (strm->avail_out == 0);
+	    if (ret == Z_BUF_ERROR)
+		z->inflate_full = 0;
+	}
+    }
+
+    if (produced == 0)
+    {
+	errno = EAGAIN;
+	return -1;
+    }
+    return produced;
+}
+
+static int
+TRANS(TcpzReadv) (XtransConnInfo ciptr, struct iovec *buf, int size)
+
+{
+    int		total = 0;
+    int		i;
+
+    for (i = 0; i < size; i++)
+    {
+	int n;
+
+	if (buf[i].iov_len == 0)
+	    continue;
+	n = TRANS(TcpzRead) (ciptr, buf[i].iov_base, buf[i].iov_len);
+	if (n <= 0)
+	    return total > 0 ? total : n;
+	total += n;
+	if (n < (int) buf[i].iov_len)
+	    break;
+    }
+    return total;
+}
+
+static int
+TRANS(TcpzWritev) (XtransConnInfo ciptr, struct iovec *buf, int size)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+    int		total = 0;
+    int		ret;
+    int		i;
+
+    prmsg (2,"TcpzWritev(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    /*
+     * Input that was compressed by an earlier call is only reported as
+     * written once its output is on the wire.  The caller resubmits it
+     * until then, so just finish sending it.
+     */
+    if (z->owed > 0)
+    {
+	if (TRANS(TcpzDrain) (ciptr) < 0)
+	    return -1;
+	ret = z->owed;
+	z->owed = 0;
+	return ret;
+    }
+
+    if (z->outpos < z->outlen && TRANS(TcpzDrain) (ciptr) < 0)
+	return -1;
+
+    TRANS(TcpzAdapt) (z);
+
+    for (i = 0; i < size; i++)
+	total += buf[i].iov_len;
+    if (total == 0)
+	return 0;
+
+    if (z->level == 0)
+    {
+	for (i = 0; i < size; i++)
+	    if (TRANS(TcpzQueueRaw) (z, buf[i].iov_base, buf[i].iov_len) < 0)
+		goto nomem;
+    }
+    else if (TRANS(TcpzQueueDeflate) (z, buf, size) < 0)
+	goto nomem;
+
+    z->owed = total;
+    if (TRANS(TcpzDrain) (ciptr) < 0)
+	return -1;
+    z->owed = 0;
+    return total;
+
+nomem:
+    prmsg (1, "TcpzWritev: out of memory\n");
+    errno = ENOMEM;
+    return -1;
+}
+
+static int
+TRANS(TcpzWrite) (XtransConnInfo ciptr, char *buf, int size)
+
+{
+    struct iovec iov;
+
+    iov.iov_base = buf;
+    iov.iov_len = size;
+    return TRANS(TcpzWritev) (ciptr, &iov, 1);
+}
+
+static int
+TRANS(TcpzBytesReadable) (XtransConnInfo ciptr, BytesReadable_t *pend)
+
+{
+    TcpzConn	*z = TCPZ(ciptr);
+
+    /* buffered input may decode without touching the socket */
+    if (z->handshake_done && (z->inflate_full ||
+			      (z->frame_left > 0 && z->inpos < z->inlen)))
+    {
+	*pend = 1;
+	return 0;
+    }
+    return TRANS(SocketBytesReadable) (ciptr, pend);
+}
+
+#ifdef TRANS_SERVER
+
+static int
+TRANS(TcpzCreateListener) (XtransConnInfo ciptr, const char *port,
+			   unsigned int flags)
+
+{
+    char	portbuf[PORTBUFSIZE];
+
+    if (TRANS(TcpzFixupPort) (port, portbuf, sizeof (portbuf)))
+	port = portbuf;
+    return TRANS(SocketINETCreateListener) (ciptr, port, flags);
+}
+
+static XtransConnInfo
+TRANS(TcpzAccept) (XtransConnInfo ciptr, int *status)
+
+{
+    XtransConnInfo	newciptr;
+
+    if ((newciptr = TRANS(SocketINETAccept) (ciptr, status)) == NULL)
+	return NULL;
+
+    if ((newciptr->priv = (char *) TRANS(TcpzCreate) (TCPZ_LEVEL_ADAPTIVE))
+	== NULL)
+    {
+	prmsg (1, "TcpzAccept: malloc failed\n");
+	close (newciptr->fd);
+	free (newciptr->addr);
+	free (newciptr->peeraddr);
+	free (newciptr);
+	*status = TRANS_ACCEPT_BAD_MALLOC;
+	return NULL;
+    }
+
+    return newciptr;
+}
+
+#endif /* TRANS_SERVER */
+
+#ifdef TRANS_CLIENT
+
+static int
+TRANS(TcpzConnect) (XtransConnInfo ciptr, const char *host, const char *port)
+
+{
+    char	portbuf[PORTBUFSIZE];
+    unsigned char hello[TCPZ_HELLO_SIZE];
+    const char	*env;
+    TcpzConn	*z;
+    int		level = TCPZ_LEVEL_ADAPTIVE;
+    int		got = 0;
+    int		ret;
+
+    if (TRANS(TcpzFixupPort) (port, portbuf, sizeof (portbuf)))
+	port = portbuf;
+
+    if ((ret = TRANS(SocketINETConnect) (ciptr, host, port)) < 0)
+	return ret;
+
+    if ((env = getenv ("XTRANS_TCPZ_LEVEL")) && is_numeric (env) && *env)
+    {
+	level = strtol (env, NULL, 10);
+	if (level > 9)
+	    level = 9;
+    }
+
+    if ((z = TRANS(TcpzCreate) (level)) == NULL)
+    {
+	prmsg (1, "TcpzConnect: malloc failed\n");
+	return TRANS_CONNECT_FAILED;
+    }
+    ciptr->priv = (char *) z;
+
+    /* the socket is still blocking here, as for the X connection setup */
+    TRANS(TcpzMakeHello) (hello, level);
+    if (TRANS(SocketWrite) (ciptr, (char *) hello, TCPZ_HELLO_SIZE)
+	!= TCPZ_HELLO_SIZE)
+    {
+	prmsg (1, "TcpzConnect: cannot send hello\n");
+	TRANS(TcpzDestroy) (ciptr);
+	return TRANS_CONNECT_FAILED;
+    }
+    while (got < TCPZ_HELLO_SIZE)
+    {
+	int n = TRANS(SocketRead) (ciptr, (char *) hello + got,
+				   TCPZ_HELLO_SIZE - got);
+	if (n <= 0)
+	{
+	    prmsg (1, "TcpzConnect: no hello from server\n");
+	    TRANS(TcpzDestroy) (ciptr);
+	    return TRANS_CONNECT_FAILED;
+	}
+	got += n;
+    }
+    if (TRANS(TcpzCheckHello) (hello) < 0)
+    {
+	prmsg (1, "TcpzConnect: server does not speak tcpz\n");
+	TRANS(TcpzDestroy) (ciptr);
+	return TRANS_CONNECT_FAILED;
+    }
+    z->handshake_done = 1;
+
+    return 0;
+}
+
+#endif /* TRANS_CLIENT */
+
+static int
+TRANS(TcpzClose) (XtransConnInfo ciptr)
+
+{
+    TRANS(TcpzDestroy) (ciptr);
+    return TRANS(SocketINETClose) (ciptr);
+}
+
+Xtransport	TRANS(SocketTCPZFuncs) = {
+	/* zlib compressed TCP */
+	"tcpz",
+	0,
+#ifdef TRANS_CLIENT
+	TRANS(SocketOpenCOTSClient),
+#endif /* TRANS_CLIENT */
+#ifdef TRANS_SERVER
+	NULL,
+	TRANS(SocketOpenCOTSServer),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_REOPEN
+	NULL,					/* ReopenCOTSServer */
+#endif
+	TRANS(SocketSetOption),
+#ifdef TRANS_SERVER
+	TRANS(TcpzCreateListener),
+	NULL,		       			/* ResetListener */
+	TRANS(TcpzAccept),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_CLIENT
+	TRANS(TcpzConnect),
+#endif /* TRANS_CLIENT */
+	TRANS(TcpzBytesReadable),
+	TRANS(TcpzRead),
+	TRANS(TcpzWrite),
+	TRANS(TcpzReadv),
+	TRANS(TcpzWritev),
+	TRANS(SocketSendFdInvalid),
+	TRANS(SocketRecvFdInvalid),
+	TRANS(SocketDisconnect),
+	TRANS(TcpzClose),
+	TRANS(TcpzClose),
+	};
@@ -66,6 +66,12 @@ from The Open Group.
 #if defined(TCPCONN) || defined(UNIXCONN)
 #include "Xtranssock.c"
 #endif
+#if defined(TCPCONN) && defined(TCPZCONN)
+#include "Xtranszlib.c"
+#endif
+#if defined(TCPCONN) && defined(TLSCONN)
+#include "Xtranstls.c"
+#endif
 #include "Xtrans.c"
 #include "Xtransutil.c"
 
@@ -119,6 +119,7 @@ static int do_quit ( const char *inputfilename, int lineno, int argc, const char
 static int do_source ( const char *inputfilename, int lineno, int argc, const char **argv );
 static int do_generate ( const char *inputfilename, int lineno, int argc, const char **argv );
 static int do_version ( const char *inputfilename, int lineno, int argc, const char **argv );
+static int eq_auth_dpy_and_name ( Xauth *a, Xauth *b );
 
 static CommandTable command_table[] = {	/* table of known commands */
     { "add",      2, 3, do_add,
@@ -796,6 +797,8 @@ auth_initialize(const char *authfilename)
 		 ProgramName, authfilename);
     } else {
 	xauth_existed = True;
+	/* read big blocks: the file may be on a network share */
+	(void) setvbuf (authfp, NULL, _IOFBF, 65536);
 	n = read_auth_entries (authfp, False, &head, &tail);
 	(void) fclose (authfp);
 	if (n < 0) {
@@ -822,6 +825,32 @@ auth_initialize(const char *authfilename)
     return 0;
 }
 
+/*
+ * Drop entries that can never be used because an earlier entry has the
+ * same display and protocol name: XauGetBestAuthByAddr takes the first of
+ * those.  Files shared between many hosts otherwise pile these up.
+ */
+static int
+compact_entries(void)
+{
+    AuthList *a, *b, *prev;
+    int n = 0;
+
+    for (a = xauth_head; a; a = a->next) {
+	prev = a;
+	for (b = a->next; b; b = prev->next) {
+	    if (eq_auth_dpy_and_name(a->auth, b->auth)) {
+		prev->next = b->next;
+		XauDisposeAuth(b->auth);
+		free(b);
+		n++;
+	    } else
+		prev = b;
+	}
+    }
+    return n;
+}
+
 static int
 write_auth_file(char *tmp_nam)
 {
@@ -879,6 +908,7 @@ int
 auth_finalize(void)
 {
     char temp_name[1025];	/* large filename size */
+    int n;
 
     if (xauth_modified) {
 	if (dying) {
@@ -908,6 +938,9 @@ auth_finalize(void)
 			ignore_locks ? "Ignoring locks and writing" :
 			"Writing", xauth_filename);
 	    }
+	    n = compact_entries ();
+	    if (verbose && n > 0)
+		printf ("%d unused entries dropped\n", n);
 	    temp_name[0] = '\0';
 	    if (write_auth_file (temp_name) == -1) {
 		fprintf (stderr,
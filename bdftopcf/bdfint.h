@@ -72,6 +72,8 @@ extern unsigned char * bdfGetLine ( FontFilePtr file, unsigned char *buf,
 extern Atom bdfForceMakeAtom ( const char *str, int *size );
 extern Atom bdfGetPropertyValue ( char *s );
 extern int bdfIsInteger ( char *str );
+extern int bdfGetInts ( unsigned char *line, const char *keyword,
+			int *values, int n );
 extern unsigned char bdfHexByte ( unsigned char *s );
 extern Bool bdfSpecialProperty ( FontPtr pFont, FontPropPtr prop,
 				 char isString, bdfFileState *bdfState );
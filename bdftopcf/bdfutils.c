@@ -55,6 +55,7 @@ from The Open Group.
 
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 
 #include "fntfilst.h"
@@ -219,10 +220,48 @@ bdfIsInteger(char *str)
 
 /***====================================================================***/
 
+/*
+ * return how many of the n integers following keyword in line could be
+ * read, like sscanf(line, "KEYWORD %d %d ...") but without the format
+ * parsing, which adds up over the four such lines of every glyph
+ */
+int
+bdfGetInts(unsigned char *line, const char *keyword, int *values, int n)
+{
+    char       *s, *end;
+    int         i;
+
+    if (!bdfIsPrefix(line, keyword))
+	return 0;
+    s = (char *) line + strlen(keyword);
+    for (i = 0; i < n; i++) {
+	values[i] = (int) strtol(s, &end, 10);
+	if (end == s)
+	    break;
+	s = end;
+    }
+    return i;
+}
+
+/***====================================================================***/
+
 /*
  * make a byte from the first two hex characters in glyph picture
  */
 
+#define HEX(c, v)   [c] = 0x10 | (v)
+
+static const unsigned char hexDigit[256] = {
+    HEX('0', 0), HEX('1', 1), HEX('2', 2), HEX('3', 3), HEX('4', 4),
+    HEX('5', 5), HEX('6', 6), HEX('7', 7), HEX('8', 8), HEX('9', 9),
+    HEX('A', 10), HEX('B', 11), HEX('C', 12), HEX('D', 13), HEX('E', 14),
+    HEX('F', 15),
+    HEX('a', 10), HEX('b', 11), HEX('c', 12), HEX('d', 13), HEX('e', 14),
+    HEX('f', 15)
+};
+
+#undef HEX
+
 unsigned char
 bdfHexByte(unsigned char *s)
 {
@@ -230,6 +269,10 @@ bdfHexByte(unsigned char *s)
     register char c;
     int         i;
 
+    if (hexDigit[s[0]] & hexDigit[s[1]] & 0x10)
+	return ((hexDigit[s[0]] & 0xf) << 4) | (hexDigit[s[1]] & 0xf);
+
+    /* skip bad characters, as always */
     for (i = 2; i; i--) {
 	c = *s++;
 	if ((c >= '0') && (c <= '9'))
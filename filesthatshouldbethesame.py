@@ -83,6 +83,8 @@ libxcb/src/shape.h                                include/xcb/shape.h
 libxcb/src/xcb_icccm.h                            include/xcb/xcb_icccm.h
 libxcb/src/xcb_aux.h                              include/xcb/xcb_aux.h
 libxcb/src/xcb_ewmh.h                             include/xcb/xcb_ewmh.h
+libxcb/src/imagecache.h                           include/xcb/imagecache.h
+libxcb/src/xcb_image_cache.h                      include/xcb/xcb_image_cache.h
 
 xcb-util-errors/src/xcb_errors.h                  include/xcb/xcb_errors.h
 
@@ -1,6 +1,6 @@
 #define HAVE_INTTYPES_H 1
 #define HAVE_FT_GET_NEXT_CHAR 1
-#define ENABLE_LIBXML2
+#define XML_STATIC
 #define HAVE_RAND 1
 #define HAVE_STRUCT_DIRENT_D_TYPE 1
 #undef __STDC__
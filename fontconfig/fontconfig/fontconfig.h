@@ -453,6 +453,10 @@ FcPublic FcFontSet *
 FcConfigGetFonts (FcConfig	*config,
 		  FcSetName	set);
 
+FcPublic FcFontSet *
+FcConfigGetFontsWithChar (FcConfig	*config,
+			  FcChar32	ucs4);
+
 FcPublic FcBool
 FcConfigAppFontAddFile (FcConfig    *config,
 			const FcChar8  *file);
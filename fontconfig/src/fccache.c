@@ -995,6 +995,53 @@ FcCacheOffsetsValid (FcCache *cache)
     return FcTrue;
 }
 
+#if defined(_WIN32) && !defined(HAVE_MMAP) && !defined(__CYGWIN__)
+/*
+ * Every Xft client in a session loads the same handful of caches.  Give
+ * each cache file's section a name built from the file's identity, so that
+ * a process mapping a cache another one already has open just opens that
+ * section rather than creating its own.  A rewritten cache is a new file
+ * with a new index and write time, so it can't be confused with the old
+ * one; whatever is found is validated like any other mapping.
+ */
+static void *
+FcCacheMapWin32 (int fd, size_t size)
+{
+    HANDLE			hFile = (HANDLE)(uintptr_t) _get_osfhandle (fd);
+    HANDLE			hFileMap = NULL;
+    BY_HANDLE_FILE_INFORMATION	info;
+    char			name[128];
+    void			*cache = NULL;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+	return NULL;
+    if (GetFileInformationByHandle (hFile, &info))
+    {
+	snprintf (name, sizeof (name),
+		  "Local\\fontconfig-cache-%08lx-%08lx%08lx-%08lx%08lx-%lx",
+		  (unsigned long) info.dwVolumeSerialNumber,
+		  (unsigned long) info.nFileIndexHigh,
+		  (unsigned long) info.nFileIndexLow,
+		  (unsigned long) info.ftLastWriteTime.dwHighDateTime,
+		  (unsigned long) info.ftLastWriteTime.dwLowDateTime,
+		  (unsigned long) size);
+	hFileMap = OpenFileMappingA (FILE_MAP_READ, FALSE, name);
+	if (!hFileMap)
+	    hFileMap = CreateFileMappingA (hFile, NULL, PAGE_READONLY,
+					   0, 0, name);
+    }
+    /* fall back to a private section if the name is taken or unusable */
+    if (!hFileMap)
+	hFileMap = CreateFileMapping (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hFileMap != NULL)
+    {
+	cache = MapViewOfFile (hFileMap, FILE_MAP_READ, 0, 0, size);
+	CloseHandle (hFileMap);
+    }
+    return cache;
+}
+#endif
+
 /*
  * Map a cache file into memory
  */
@@ -1030,19 +1077,7 @@ FcDirCacheMapFd (FcConfig *config, int fd, struct stat *fd_stat, struct stat *di
 	if (cache == MAP_FAILED)
 	    cache = NULL;
 #elif defined(_WIN32)
-	{
-	    HANDLE hFileMap;
-
-	    cache = NULL;
-	    hFileMap = CreateFileMapping((HANDLE)(uintptr_t) _get_osfhandle(fd), NULL,
-					 PAGE_READONLY, 0, 0, NULL);
-	    if (hFileMap != NULL)
-	    {
-		cache = MapViewOfFile (hFileMap, FILE_MAP_READ, 0, 0,
-				       fd_stat->st_size);
-		CloseHandle (hFileMap);
-	    }
-	}
+	cache = FcCacheMapWin32 (fd, fd_stat->st_size);
 #endif
     }
     if (!cache)
@@ -40,6 +40,8 @@
 
 static FcConfig    *_fcConfig; /* MT-safe */
 static FcMutex	   *_lock;
+static fc_atomic_int_t _fontsSerial;
+static FcMutex	   *_charIndexLock;
 
 static void
 lock_config (void)
@@ -83,6 +85,12 @@ free_lock (void)
 	FcMutexFinish (lock);
 	free (lock);
     }
+    lock = fc_atomic_ptr_get (&_charIndexLock);
+    if (lock && fc_atomic_ptr_cmpexch (&_charIndexLock, lock, NULL))
+    {
+	FcMutexFinish (lock);
+	free (lock);
+    }
 }
 
 static FcConfig *
@@ -187,6 +195,8 @@ FcConfigCreate (void)
     config->maxObjects = 0;
     for (set = FcSetSystem; set <= FcSetApplication; set++)
 	config->fonts[set] = 0;
+    config->charIndex = NULL;
+    FcConfigFontsChanged (config);
 
     config->rescanTime = time(0);
     config->rescanInterval = 30;
@@ -379,6 +389,7 @@ FcConfigDestroy (FcConfig *config)
 	for (set = FcSetSystem; set <= FcSetApplication; set++)
 	    if (config->fonts[set])
 		FcFontSetDestroy (config->fonts[set]);
+	free (config->charIndex);
 
 	page = config->expr_pool;
 	while (page)
@@ -463,6 +474,7 @@ FcConfigAddCache (FcConfig *config, FcCache *cache,
 		nref++;
 	}
 	FcDirCacheReference (cache, nref);
+	FcConfigFontsChanged (config);
     }
 
     /*
@@ -809,6 +821,204 @@ FcConfigSetFonts (FcConfig	*config,
     if (config->fonts[set])
 	FcFontSetDestroy (config->fonts[set]);
     config->fonts[set] = fonts;
+    FcConfigFontsChanged (config);
+}
+
+/*
+ * Give the font sets a serial number no other configuration has had,
+ * so results keyed on it (see FcFontMatch) can't be mistaken for ones
+ * computed against other fonts.
+ */
+void
+FcConfigFontsChanged (FcConfig *config)
+{
+    config->fontsSerial = fc_atomic_int_add (_fontsSerial, 1) + 1;
+}
+
+/*
+ * Picking a fallback for a character means finding the fonts that have
+ * it, which used to take a charset lookup in every font.  The index keeps,
+ * for each 256 character page, the fonts with something in that page and
+ * their leaf for it, so only those fonts have a bit tested.  It is built
+ * on first use and again after the font sets change.
+ */
+#define FC_CHAR_INDEX_PAGES	((0x10ffff >> 8) + 1)
+
+typedef struct _FcCharIndexEntry {
+    FcPattern		*font;
+    const FcCharLeaf	*leaf;
+} FcCharIndexEntry;
+
+struct _FcCharIndex {
+    int			serial;
+    int			nfont[FcSetApplication + 1];
+    int			start[FC_CHAR_INDEX_PAGES + 1];
+    FcCharIndexEntry	entries[1];
+};
+
+static void
+lock_char_index (void)
+{
+    FcMutex *lock;
+retry:
+    lock = fc_atomic_ptr_get (&_charIndexLock);
+    if (!lock)
+    {
+	lock = (FcMutex *) malloc (sizeof (FcMutex));
+	FcMutexInit (lock);
+	if (!fc_atomic_ptr_cmpexch (&_charIndexLock, NULL, lock))
+	{
+	    FcMutexFinish (lock);
+	    free (lock);
+	    goto retry;
+	}
+    }
+    FcMutexLock (lock);
+}
+
+static void
+unlock_char_index (void)
+{
+    FcMutexUnlock (fc_atomic_ptr_get (&_charIndexLock));
+}
+
+static FcBool
+FcCharIndexIsCurrent (const FcCharIndex *index, const FcConfig *config)
+{
+    FcSetName	set;
+
+    if (index->serial != config->fontsSerial)
+	return FcFalse;
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+	if (index->nfont[set] != (config->fonts[set] ? config->fonts[set]->nfont : 0))
+	    return FcFalse;
+    return FcTrue;
+}
+
+static FcCharIndex *
+FcCharIndexCreate (const FcConfig *config)
+{
+    FcCharIndex	*index;
+    FcCharSet	*cs;
+    FcSetName	set;
+    FcChar16	*numbers;
+    int		*pos;
+    int		f, i, page, n;
+
+    pos = calloc (FC_CHAR_INDEX_PAGES + 1, sizeof (int));
+    if (!pos)
+	return NULL;
+    /* count the fonts in each page */
+    n = 0;
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+    {
+	if (!config->fonts[set])
+	    continue;
+	for (f = 0; f < config->fonts[set]->nfont; f++)
+	{
+	    if (FcPatternObjectGetCharSet (config->fonts[set]->fonts[f],
+					   FC_CHARSET_OBJECT, 0, &cs) != FcResultMatch)
+		continue;
+	    numbers = FcCharSetNumbers (cs);
+	    for (i = 0; i < cs->num; i++)
+	    {
+		if (numbers[i] >= FC_CHAR_INDEX_PAGES)
+		    break;
+		pos[numbers[i]]++;
+		n++;
+	    }
+	}
+    }
+    index = malloc (sizeof (FcCharIndex) + (n ? n - 1 : 0) * sizeof (FcCharIndexEntry));
+    if (!index)
+    {
+	free (pos);
+	return NULL;
+    }
+    index->serial = config->fontsSerial;
+    n = 0;
+    for (page = 0; page < FC_CHAR_INDEX_PAGES; page++)
+    {
+	index->start[page] = n;
+	n += pos[page];
+	pos[page] = index->start[page];
+    }
+    index->start[FC_CHAR_INDEX_PAGES] = n;
+    /* fill the pages, keeping the fonts in set order */
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+    {
+	index->nfont[set] = config->fonts[set] ? config->fonts[set]->nfont : 0;
+	for (f = 0; f < index->nfont[set]; f++)
+	{
+	    FcPattern	*font = config->fonts[set]->fonts[f];
+
+	    if (FcPatternObjectGetCharSet (font, FC_CHARSET_OBJECT, 0, &cs) != FcResultMatch)
+		continue;
+	    numbers = FcCharSetNumbers (cs);
+	    for (i = 0; i < cs->num; i++)
+	    {
+		FcCharIndexEntry    *e;
+
+		if (numbers[i] >= FC_CHAR_INDEX_PAGES)
+		    break;
+		e = &index->entries[pos[numbers[i]]++];
+		e->font = font;
+		e->leaf = FcCharSetLeaf (cs, i);
+	    }
+	}
+    }
+    free (pos);
+    return index;
+}
+
+FcFontSet *
+FcConfigGetFontsWithChar (FcConfig	*config,
+			  FcChar32	ucs4)
+{
+    FcCharIndex	*index;
+    FcFontSet	*fonts;
+    int		i;
+
+    config = FcConfigReference (config);
+    if (!config)
+	return NULL;
+    fonts = FcFontSetCreate ();
+    if (!fonts || (ucs4 >> 8) >= FC_CHAR_INDEX_PAGES)
+	goto bail;
+
+    lock_char_index ();
+    index = config->charIndex;
+    if (!index || !FcCharIndexIsCurrent (index, config))
+    {
+	free (index);
+	index = config->charIndex = FcCharIndexCreate (config);
+    }
+    if (!index)
+    {
+	unlock_char_index ();
+	FcFontSetDestroy (fonts);
+	fonts = NULL;
+	goto bail;
+    }
+    for (i = index->start[ucs4 >> 8]; i < index->start[(ucs4 >> 8) + 1]; i++)
+    {
+	const FcCharIndexEntry	*e = &index->entries[i];
+
+	if (!(e->leaf->map[(ucs4 & 0xff) >> 5] & (1U << (ucs4 & 0x1f))))
+	    continue;
+	FcPatternReference (e->font);
+	if (!FcFontSetAdd (fonts, e->font))
+	{
+	    FcPatternDestroy (e->font);
+	    FcFontSetDestroy (fonts);
+	    fonts = NULL;
+	    break;
+	}
+    }
+    unlock_char_index ();
+bail:
+    FcConfigDestroy (config);
+    return fonts;
 }
 
 
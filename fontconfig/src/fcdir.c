@@ -28,6 +28,13 @@
 #include <dirent.h>
 #endif
 
+#if !defined(FC_NO_MT) && (defined(_MSC_VER) || defined(__MINGW32__))
+#define FC_SCAN_THREADS_WIN32 1
+#elif !defined(FC_NO_MT) && defined(HAVE_PTHREAD)
+#define FC_SCAN_THREADS_PTHREAD 1
+#include <pthread.h>
+#endif
+
 FcBool
 FcFileIsDir (const FcChar8 *file)
 {
@@ -62,28 +69,18 @@ FcFileIsFile (const FcChar8 *file)
     return S_ISREG (statb.st_mode);
 }
 
+/*
+ * Finish the patterns a file added to the set from old_nfont on
+ */
 static FcBool
-FcFileScanFontConfig (FcFontSet		*set,
-		      const FcChar8	*file,
+FcFileScanFontFinish (FcFontSet		*set,
+		      int		old_nfont,
 		      FcConfig		*config)
 {
     int		i;
     FcBool	ret = FcTrue;
-    int		old_nfont = set->nfont;
     const FcChar8 *sysroot = FcConfigGetSysRoot (config);
 
-    if (FcDebug () & FC_DBG_SCAN)
-    {
-	printf ("\tScanning file %s...", file);
-	fflush (stdout);
-    }
-
-    if (!FcFreeTypeQueryAll (file, -1, NULL, NULL, set))
-	return FcFalse;
-
-    if (FcDebug () & FC_DBG_SCAN)
-	printf ("done\n");
-
     for (i = old_nfont; i < set->nfont; i++)
     {
 	FcPattern *font = set->fonts[i];
@@ -127,6 +124,28 @@ FcFileScanFontConfig (FcFontSet		*set,
     return ret;
 }
 
+static FcBool
+FcFileScanFontConfig (FcFontSet		*set,
+		      const FcChar8	*file,
+		      FcConfig		*config)
+{
+    int		old_nfont = set->nfont;
+
+    if (FcDebug () & FC_DBG_SCAN)
+    {
+	printf ("\tScanning file %s...", file);
+	fflush (stdout);
+    }
+
+    if (!FcFreeTypeQueryAll (file, -1, NULL, NULL, set))
+	return FcFalse;
+
+    if (FcDebug () & FC_DBG_SCAN)
+	printf ("done\n");
+
+    return FcFileScanFontFinish (set, old_nfont, config);
+}
+
 FcBool
 FcFileScanConfig (FcFontSet	*set,
 		  FcStrSet	*dirs,
@@ -182,6 +201,158 @@ FcFileScan (FcFontSet	    *set,
     return ret;
 }
 
+#if defined(FC_SCAN_THREADS_WIN32) || defined(FC_SCAN_THREADS_PTHREAD)
+/*
+ * Opening every file with FreeType is what makes scanning a big font
+ * directory slow, and each query is independent of the others, so spread
+ * them over a few threads.  Each file gets its own font set; they are
+ * merged afterwards in the same sorted order the serial scan uses, and
+ * everything that touches the config happens then, on this thread, so
+ * the result doesn't depend on which thread finished first.
+ */
+#define FC_SCAN_MAX_THREADS	8
+#define FC_SCAN_MIN_FILES	16	/* fewer aren't worth a thread */
+
+typedef struct _FcScanJob {
+    FcChar8		**files;
+    FcFontSet		**sets;		/* NULL for directories */
+    int			nfiles;
+    fc_atomic_int_t	next;
+} FcScanJob;
+
+static void
+FcScanJobRun (FcScanJob *job)
+{
+    int	i;
+
+    while ((i = fc_atomic_int_add (job->next, 1)) < job->nfiles)
+    {
+	if (FcFileIsDir (job->files[i]))
+	    continue;
+	job->sets[i] = FcFontSetCreate ();
+	if (job->sets[i])
+	    FcFreeTypeQueryAll (job->files[i], -1, NULL, NULL, job->sets[i]);
+    }
+}
+
+#ifdef FC_SCAN_THREADS_WIN32
+static DWORD WINAPI
+FcScanThread (LPVOID arg)
+{
+    FcScanJobRun ((FcScanJob *) arg);
+    return 0;
+}
+#else
+static void *
+FcScanThread (void *arg)
+{
+    FcScanJobRun ((FcScanJob *) arg);
+    return NULL;
+}
+#endif
+
+static int
+FcScanThreadCount (int nfiles)
+{
+    int	n;
+#ifdef FC_SCAN_THREADS_WIN32
+    SYSTEM_INFO	info;
+
+    GetSystemInfo (&info);
+    n = info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+#else
+    n = 1;
+#endif
+    if (n > FC_SCAN_MAX_THREADS)
+	n = FC_SCAN_MAX_THREADS;
+    if (n > nfiles / FC_SCAN_MIN_FILES)
+	n = nfiles / FC_SCAN_MIN_FILES;
+    return n;
+}
+
+/*
+ * Query the files in parallel.  Returns FcFalse, having done nothing,
+ * when that isn't worthwhile or possible; the caller scans serially.
+ */
+static FcBool
+FcDirScanFilesParallel (FcFontSet	*set,
+			FcStrSet	*dirs,
+			FcStrSet	*files,
+			FcConfig	*config)
+{
+    FcScanJob	job;
+    int		nthreads, started, i, j;
+#ifdef FC_SCAN_THREADS_WIN32
+    HANDLE	threads[FC_SCAN_MAX_THREADS];
+#else
+    pthread_t	threads[FC_SCAN_MAX_THREADS];
+#endif
+
+    /* keep the debug output in order */
+    if (!set || (FcDebug () & FC_DBG_SCAN))
+	return FcFalse;
+    nthreads = FcScanThreadCount (files->num);
+    if (nthreads < 2)
+	return FcFalse;
+
+    job.files = files->strs;
+    job.nfiles = files->num;
+    job.next = 0;
+    job.sets = calloc (files->num, sizeof (FcFontSet *));
+    if (!job.sets)
+	return FcFalse;
+
+    /* this thread does its share too */
+    for (started = 0; started < nthreads - 1; started++)
+    {
+#ifdef FC_SCAN_THREADS_WIN32
+	threads[started] = CreateThread (NULL, 0, FcScanThread, &job, 0, NULL);
+	if (!threads[started])
+	    break;
+#else
+	if (pthread_create (&threads[started], NULL, FcScanThread, &job) != 0)
+	    break;
+#endif
+    }
+    FcScanJobRun (&job);
+    for (i = 0; i < started; i++)
+    {
+#ifdef FC_SCAN_THREADS_WIN32
+	WaitForSingleObject (threads[i], INFINITE);
+	CloseHandle (threads[i]);
+#else
+	pthread_join (threads[i], NULL);
+#endif
+    }
+
+    for (i = 0; i < files->num; i++)
+    {
+	FcFontSet   *s = job.sets[i];
+	int	    old_nfont = set->nfont;
+
+	if (!s)
+	{
+	    /* directories, or a file we ran out of memory for */
+	    FcFileScanConfig (FcFileIsDir (files->strs[i]) ? NULL : set,
+			      dirs, files->strs[i], config);
+	    continue;
+	}
+	for (j = 0; j < s->nfont; j++)
+	{
+	    if (!FcFontSetAdd (set, s->fonts[j]))
+		FcPatternDestroy (s->fonts[j]);
+	}
+	s->nfont = 0;
+	FcFontSetDestroy (s);
+	FcFileScanFontFinish (set, old_nfont, config);
+    }
+    free (job.sets);
+    return FcTrue;
+}
+#endif
+
 /*
  * Strcmp helper that takes pointers to pointers, copied from qsort(3) manpage
  */
@@ -270,6 +441,9 @@ FcDirScanConfig (FcFontSet	*set,
     /*
      * Scan file files to build font patterns
      */
+#if defined(FC_SCAN_THREADS_WIN32) || defined(FC_SCAN_THREADS_PTHREAD)
+    if (!FcDirScanFilesParallel (set, dirs, files, config))
+#endif
     for (i = 0; i < files->num; i++)
 	FcFileScanConfig (set, dirs, files->strs[i], config);
 
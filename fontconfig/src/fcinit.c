@@ -202,6 +202,7 @@ FcFini (void)
 {
     FcConfigFini ();
     FcConfigPathFini ();
+    FcMatchFini ();
     FcDefaultFini ();
     FcObjectFini ();
     FcCacheFini ();
@@ -454,6 +454,8 @@ typedef struct _FcSerializeBucket {
 
 typedef struct _FcCharSetFreezer FcCharSetFreezer;
 
+typedef struct _FcCharIndex FcCharIndex;
+
 typedef struct _FcSerialize {
     intptr_t		size;
     FcCharSetFreezer	*cs_freezer;
@@ -564,6 +566,8 @@ struct _FcConfig {
      * match preferrentially
      */
     FcFontSet	*fonts[FcSetApplication + 1];
+    int		fontsSerial;	    /* changes whenever fonts[] does */
+    FcCharIndex	*charIndex;	    /* fonts by charset page, built on demand */
     /*
      * Fontconfig can periodically rescan the system configuration
      * and font directories.  This rescanning occurs when font
@@ -655,6 +659,9 @@ FcConfigInit (void);
 FcPrivate void
 FcConfigFini (void);
 
+FcPrivate void
+FcConfigFontsChanged (FcConfig *config);
+
 FcPrivate FcChar8 *
 FcConfigXdgCacheHome (void);
 
@@ -1043,6 +1050,9 @@ FcListPatternMatchAny (const FcPattern *p,
 
 /* fcmatch.c */
 
+FcPrivate void
+FcMatchFini (void);
+
 /* fcname.c */
 
 enum {
@@ -1058,6 +1058,135 @@ FcFontSetMatch (FcConfig    *config,
     return ret;
 }
 
+/*
+ * Toolkits ask for the same few fonts over and over, and every match
+ * scores the whole font list.  Remember recent answers, keyed on the
+ * pattern and on the state of the configuration's font sets.  The
+ * answer is kept as it comes out of FcFontSetMatchInternal, since
+ * FcFontRenderPrepare is cheap and depends on the pattern anyway.
+ */
+#define FC_MATCH_CACHE_SIZE	64
+
+typedef struct _FcMatchCacheEntry {
+    FcPattern	*pattern;
+    FcPattern	*best;
+    FcChar32	hash;
+    int		serial;
+    int		nfont[FcSetApplication + 1];
+} FcMatchCacheEntry;
+
+static FcMatchCacheEntry    _matchCache[FC_MATCH_CACHE_SIZE];
+static FcMutex		    *_matchLock;
+
+static void
+lock_match_cache (void)
+{
+    FcMutex *lock;
+retry:
+    lock = fc_atomic_ptr_get (&_matchLock);
+    if (!lock)
+    {
+	lock = (FcMutex *) malloc (sizeof (FcMutex));
+	FcMutexInit (lock);
+	if (!fc_atomic_ptr_cmpexch (&_matchLock, NULL, lock))
+	{
+	    FcMutexFinish (lock);
+	    free (lock);
+	    goto retry;
+	}
+    }
+    FcMutexLock (lock);
+}
+
+static void
+unlock_match_cache (void)
+{
+    FcMutexUnlock (fc_atomic_ptr_get (&_matchLock));
+}
+
+static FcBool
+FcMatchCacheKeyEqual (const FcMatchCacheEntry *e, FcChar32 hash,
+		      const FcConfig *config, const FcPattern *p)
+{
+    int	set;
+
+    if (!e->pattern || e->hash != hash || e->serial != config->fontsSerial)
+	return FcFalse;
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+	if (e->nfont[set] != (config->fonts[set] ? config->fonts[set]->nfont : 0))
+	    return FcFalse;
+    return FcPatternEqual (e->pattern, p);
+}
+
+static FcPattern *
+FcMatchCacheLookup (const FcConfig *config, const FcPattern *p, FcChar32 hash)
+{
+    FcMatchCacheEntry	*e = &_matchCache[hash % FC_MATCH_CACHE_SIZE];
+    FcPattern		*best = NULL;
+
+    lock_match_cache ();
+    if (FcMatchCacheKeyEqual (e, hash, config, p))
+    {
+	best = e->best;
+	FcPatternReference (best);
+    }
+    unlock_match_cache ();
+    return best;
+}
+
+static void
+FcMatchCacheAdd (const FcConfig *config, const FcPattern *p, FcChar32 hash,
+		 FcPattern *best)
+{
+    FcMatchCacheEntry	*e = &_matchCache[hash % FC_MATCH_CACHE_SIZE];
+    FcPattern		*pattern, *oldPattern, *oldBest;
+    int			set;
+
+    pattern = FcPatternDuplicate (p);
+    if (!pattern)
+	return;
+    FcPatternReference (best);
+
+    lock_match_cache ();
+    oldPattern = e->pattern;
+    oldBest = e->best;
+    e->pattern = pattern;
+    e->best = best;
+    e->hash = hash;
+    e->serial = config->fontsSerial;
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+	e->nfont[set] = config->fonts[set] ? config->fonts[set]->nfont : 0;
+    unlock_match_cache ();
+
+    if (oldPattern)
+	FcPatternDestroy (oldPattern);
+    if (oldBest)
+	FcPatternDestroy (oldBest);
+}
+
+void
+FcMatchFini (void)
+{
+    FcMutex *lock;
+    int	    i;
+
+    for (i = 0; i < FC_MATCH_CACHE_SIZE; i++)
+    {
+	if (_matchCache[i].pattern)
+	    FcPatternDestroy (_matchCache[i].pattern);
+	if (_matchCache[i].best)
+	    FcPatternDestroy (_matchCache[i].best);
+	_matchCache[i].pattern = NULL;
+	_matchCache[i].best = NULL;
+    }
+    lock = fc_atomic_ptr_get (&_matchLock);
+    if (lock && fc_atomic_ptr_cmpexch (&_matchLock, lock, NULL))
+    {
+	FcMutexFinish (lock);
+	free (lock);
+    }
+}
+
 FcPattern *
 FcFontMatch (FcConfig	*config,
 	     FcPattern	*p,
@@ -1066,6 +1195,8 @@ FcFontMatch (FcConfig	*config,
     FcFontSet	*sets[2];
     int		nsets;
     FcPattern   *best, *ret = NULL;
+    FcBool	cache;
+    FcChar32	hash = 0;
 
     assert (p != NULL);
     assert (result != NULL);
@@ -1081,7 +1212,22 @@ FcFontMatch (FcConfig	*config,
     if (config->fonts[FcSetApplication])
 	sets[nsets++] = config->fonts[FcSetApplication];
 
-    best = FcFontSetMatchInternal (sets, nsets, p, result);
+    /* let the debug output show the whole match */
+    cache = !(FcDebug () & (FC_DBG_MATCH | FC_DBG_MATCHV | FC_DBG_MATCH2));
+    best = NULL;
+    if (cache)
+    {
+	hash = FcPatternHash (p);
+	best = FcMatchCacheLookup (config, p, hash);
+	if (best)
+	    *result = FcResultMatch;
+    }
+    if (!best)
+    {
+	best = FcFontSetMatchInternal (sets, nsets, p, result);
+	if (best && cache)
+	    FcMatchCacheAdd (config, p, hash, best);
+    }
     if (best)
     {
 	ret = FcFontRenderPrepare (config, p, best);
@@ -271,7 +271,7 @@
 #undef LOCALCONN
 
 /* Support MIT-SHM Extension */
-#undef MITSHM
+#define MITSHM 1
 
 /* Disable some debugging code */
 #define NDEBUG 1
@@ -327,6 +327,12 @@
 /* Support TCP socket connections */
 #define TCPCONN 1
 
+/* Support zlib compressed TCP connections (the tcpz transport) */
+#define TCPZCONN 1
+
+/* Support TLS connections over TCP (the tls transport, needs OpenSSL) */
+#define TLSCONN 1
+
 /* Support UNIX socket connections */
 #undef UNIXCONN
 
@@ -382,7 +388,7 @@
 #define XORG_DATE "7 April 2020"
 
 /* Build Xv Extension */
-#undef XvExtension
+#define XvExtension 1
 
 /* Build XvMC Extension */
 #undef XvMCExtension
@@ -394,7 +400,7 @@
 #define XTEST 1
 
 /* Support Xv extension */
-#undef XV
+#define XV 1
 
 /* Support DRI extension */
 #undef XF86DRI
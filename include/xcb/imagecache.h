@@ -0,0 +1,265 @@
+/*
+ * This file generated automatically from imagecache.xml by c_client.py.
+ * Edit at your peril.
+ */
+
+/**
+ * @defgroup XCB_ImageCache_API XCB ImageCache API
+ * @brief ImageCache XCB Protocol Implementation.
+ * @{
+ **/
+
+#ifndef __IMAGECACHE_H
+#define __IMAGECACHE_H
+
+#include "xcb.h"
+#include "xproto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XCB_IMAGECACHE_MAJOR_VERSION 1
+#define XCB_IMAGECACHE_MINOR_VERSION 0
+
+XCB_EXTERN xcb_extension_t xcb_imagecache_id;
+
+/**
+ * @brief xcb_imagecache_query_version_cookie_t
+ **/
+typedef struct xcb_imagecache_query_version_cookie_t {
+    unsigned int sequence;
+} xcb_imagecache_query_version_cookie_t;
+
+/** Opcode for xcb_imagecache_query_version. */
+#define XCB_IMAGECACHE_QUERY_VERSION 0
+
+/**
+ * @brief xcb_imagecache_query_version_request_t
+ **/
+typedef struct xcb_imagecache_query_version_request_t {
+    uint8_t  major_opcode;
+    uint8_t  minor_opcode;
+    uint16_t length;
+    uint32_t client_major_version;
+    uint32_t client_minor_version;
+} xcb_imagecache_query_version_request_t;
+
+/**
+ * @brief xcb_imagecache_query_version_reply_t
+ **/
+typedef struct xcb_imagecache_query_version_reply_t {
+    uint8_t  response_type;
+    uint8_t  pad0;
+    uint16_t sequence;
+    uint32_t length;
+    uint32_t server_major_version;
+    uint32_t server_minor_version;
+    uint32_t budget;
+    uint8_t  pad1[12];
+} xcb_imagecache_query_version_reply_t;
+
+/** Opcode for xcb_imagecache_put_image. */
+#define XCB_IMAGECACHE_PUT_IMAGE 1
+
+/**
+ * @brief xcb_imagecache_put_image_request_t
+ **/
+typedef struct xcb_imagecache_put_image_request_t {
+    uint8_t        major_opcode;
+    uint8_t        minor_opcode;
+    uint16_t       length;
+    xcb_drawable_t drawable;
+    xcb_gcontext_t gc;
+    uint16_t       width;
+    uint16_t       height;
+    int16_t        dst_x;
+    int16_t        dst_y;
+    uint8_t        format;
+    uint8_t        depth;
+    uint8_t        left_pad;
+    uint8_t        pad0;
+    uint32_t       key0;
+    uint32_t       key1;
+    uint32_t       key2;
+    uint32_t       key3;
+} xcb_imagecache_put_image_request_t;
+
+/** Opcode for xcb_imagecache_reset. */
+#define XCB_IMAGECACHE_RESET 2
+
+/**
+ * @brief xcb_imagecache_reset_request_t
+ **/
+typedef struct xcb_imagecache_reset_request_t {
+    uint8_t  major_opcode;
+    uint8_t  minor_opcode;
+    uint16_t length;
+} xcb_imagecache_reset_request_t;
+
+/** Opcode for xcb_imagecache_bad_key. */
+#define XCB_IMAGECACHE_BAD_KEY 0
+
+/**
+ * @brief xcb_imagecache_bad_key_error_t
+ **/
+typedef struct xcb_imagecache_bad_key_error_t {
+    uint8_t  response_type;
+    uint8_t  error_code;
+    uint16_t sequence;
+    uint32_t bad_value;
+    uint16_t minor_opcode;
+    uint8_t  major_opcode;
+} xcb_imagecache_bad_key_error_t;
+
+/**
+ *
+ * @param c The connection
+ * @return A cookie
+ *
+ * Delivers a request to the X server.
+ *
+ */
+xcb_imagecache_query_version_cookie_t
+xcb_imagecache_query_version (xcb_connection_t *c,
+                              uint32_t          client_major_version,
+                              uint32_t          client_minor_version);
+
+/**
+ *
+ * @param c The connection
+ * @return A cookie
+ *
+ * Delivers a request to the X server.
+ *
+ * This form can be used only if the request will cause
+ * a reply to be generated. Any returned error will be
+ * placed in the event queue.
+ */
+xcb_imagecache_query_version_cookie_t
+xcb_imagecache_query_version_unchecked (xcb_connection_t *c,
+                                        uint32_t          client_major_version,
+                                        uint32_t          client_minor_version);
+
+/**
+ * Return the reply
+ * @param c      The connection
+ * @param cookie The cookie
+ * @param e      The xcb_generic_error_t supplied
+ *
+ * Returns the reply of the request asked by
+ *
+ * The parameter @p e supplied to this function must be NULL if
+ * xcb_imagecache_query_version_unchecked(). is used.
+ * Otherwise, it stores the error if any.
+ *
+ * The returned value must be freed by the caller using free().
+ */
+xcb_imagecache_query_version_reply_t *
+xcb_imagecache_query_version_reply (xcb_connection_t                       *c,
+                                    xcb_imagecache_query_version_cookie_t   cookie  /**< */,
+                                    xcb_generic_error_t                   **e);
+
+int
+xcb_imagecache_put_image_sizeof (const void  *_buffer,
+                                 uint32_t     data_len);
+
+/**
+ *
+ * @param c The connection
+ * @return A cookie
+ *
+ * Delivers a request to the X server.
+ *
+ * This form can be used only if the request will not cause
+ * a reply to be generated. Any returned error will be
+ * saved for handling by xcb_request_check().
+ */
+xcb_void_cookie_t
+xcb_imagecache_put_image_checked (xcb_connection_t *c,
+                                  xcb_drawable_t    drawable,
+                                  xcb_gcontext_t    gc,
+                                  uint16_t          width,
+                                  uint16_t          height,
+                                  int16_t           dst_x,
+                                  int16_t           dst_y,
+                                  uint8_t           format,
+                                  uint8_t           depth,
+                                  uint8_t           left_pad,
+                                  uint32_t          key0,
+                                  uint32_t          key1,
+                                  uint32_t          key2,
+                                  uint32_t          key3,
+                                  uint32_t          data_len,
+                                  const uint8_t    *data);
+
+/**
+ *
+ * @param c The connection
+ * @return A cookie
+ *
+ * Delivers a request to the X server.
+ *
+ */
+xcb_void_cookie_t
+xcb_imagecache_put_image (xcb_connection_t *c,
+                          xcb_drawable_t    drawable,
+                          xcb_gcontext_t    gc,
+                          uint16_t          width,
+                          uint16_t          height,
+                          int16_t           dst_x,
+                          int16_t           dst_y,
+                          uint8_t           format,
+                          uint8_t           depth,
+                          uint8_t           left_pad,
+                          uint32_t          key0,
+                          uint32_t          key1,
+                          uint32_t          key2,
+                          uint32_t          key3,
+                          uint32_t          data_len,
+                          const uint8_t    *data);
+
+uint8_t *
+xcb_imagecache_put_image_data (const xcb_imagecache_put_image_request_t *R);
+
+int
+xcb_imagecache_put_image_data_length (const xcb_imagecache_put_image_request_t *R);
+
+xcb_generic_iterator_t
+xcb_imagecache_put_image_data_end (const xcb_imagecache_put_image_request_t *R);
+
+/**
+ *
+ * @param c The connection
+ * @return A cookie
+ *
+ * Delivers a request to the X server.
+ *
+ * This form can be used only if the request will not cause
+ * a reply to be generated. Any returned error will be
+ * saved for handling by xcb_request_check().
+ */
+xcb_void_cookie_t
+xcb_imagecache_reset_checked (xcb_connection_t *c);
+
+/**
+ *
+ * @param c The connection
+ * @return A cookie
+ *
+ * Delivers a request to the X server.
+ *
+ */
+xcb_void_cookie_t
+xcb_imagecache_reset (xcb_connection_t *c);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,66 @@
+#ifndef __XCB_IMAGE_CACHE_H__
+#define __XCB_IMAGE_CACHE_H__
+
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * PutImage through the server's IMAGE-CACHE extension.
+ *
+ * xcb_image_cache_put_image() takes the same arguments as xcb_put_image().
+ * It hashes the image data, and sends only the hash when the server still
+ * holds an image with that hash, following the cache rules in
+ * imagecacheproto.h.  The helper keeps no image data, only a 24 byte record
+ * per cached image.
+ *
+ * A cache must only be used from one thread at a time, and every PutImage
+ * it is to know about must go through it.  If an ImageCache BadKey error
+ * is ever received, call xcb_image_cache_reset().
+ */
+
+#include <xcb/xcb.h>
+#include <xcb/imagecache.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct xcb_image_cache_t xcb_image_cache_t;
+
+/**
+ * Set up a cache for connection c.  Waits for the server's reply; returns
+ * NULL if the server lacks IMAGE-CACHE, in which case xcb_put_image() is
+ * the only way to send images.
+ */
+xcb_image_cache_t *
+xcb_image_cache_new (xcb_connection_t *c);
+
+void
+xcb_image_cache_free (xcb_image_cache_t *cache);
+
+/**
+ * As xcb_put_image(), sending the data only if the server does not hold
+ * it already.
+ */
+xcb_void_cookie_t
+xcb_image_cache_put_image (xcb_image_cache_t *cache,
+                           uint8_t            format,
+                           xcb_drawable_t     drawable,
+                           xcb_gcontext_t     gc,
+                           uint16_t           width,
+                           uint16_t           height,
+                           int16_t            dst_x,
+                           int16_t            dst_y,
+                           uint8_t            left_pad,
+                           uint8_t            depth,
+                           uint32_t           data_len,
+                           const uint8_t     *data);
+
+/** Empty the cache here and on the server. */
+xcb_void_cookie_t
+xcb_image_cache_reset (xcb_image_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __XCB_IMAGE_CACHE_H__ */
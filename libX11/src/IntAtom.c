@@ -36,6 +36,73 @@ from The Open Group.
 #define REHASHVAL(sig) ((((sig) % (TABLESIZE-3)) + 2) | 1)
 #define REHASH(idx,rehash) ((idx + rehash) & (TABLESIZE-1))
 
+/* The atoms defined by the core protocol, in order from XA_PRIMARY */
+static const char *const predefinedAtoms[] = {
+    "PRIMARY", "SECONDARY", "ARC", "ATOM", "BITMAP", "CARDINAL", "COLORMAP",
+    "CURSOR", "CUT_BUFFER0", "CUT_BUFFER1", "CUT_BUFFER2", "CUT_BUFFER3",
+    "CUT_BUFFER4", "CUT_BUFFER5", "CUT_BUFFER6", "CUT_BUFFER7", "DRAWABLE",
+    "FONT", "INTEGER", "PIXMAP", "POINT", "RECTANGLE", "RESOURCE_MANAGER",
+    "RGB_COLOR_MAP", "RGB_BEST_MAP", "RGB_BLUE_MAP", "RGB_DEFAULT_MAP",
+    "RGB_GRAY_MAP", "RGB_GREEN_MAP", "RGB_RED_MAP", "STRING", "VISUALID",
+    "WINDOW", "WM_COMMAND", "WM_HINTS", "WM_CLIENT_MACHINE", "WM_ICON_NAME",
+    "WM_ICON_SIZE", "WM_NAME", "WM_NORMAL_HINTS", "WM_SIZE_HINTS",
+    "WM_ZOOM_HINTS", "MIN_SPACE", "NORM_SPACE", "MAX_SPACE", "END_SPACE",
+    "SUPERSCRIPT_X", "SUPERSCRIPT_Y", "SUBSCRIPT_X", "SUBSCRIPT_Y",
+    "UNDERLINE_POSITION", "UNDERLINE_THICKNESS", "STRIKEOUT_ASCENT",
+    "STRIKEOUT_DESCENT", "ITALIC_ANGLE", "X_HEIGHT", "QUAD_WIDTH", "WEIGHT",
+    "POINT_SIZE", "RESOLUTION", "COPYRIGHT", "NOTICE", "FONT_NAME",
+    "FAMILY_NAME", "FULL_NAME", "CAP_HEIGHT", "WM_CLASS", "WM_TRANSIENT_FOR"
+};
+
+/* Atoms most toolkits intern at startup, see _XPrefetchAtoms */
+static const char *const commonAtoms[] = {
+    "WM_PROTOCOLS", "WM_DELETE_WINDOW", "WM_TAKE_FOCUS", "WM_STATE",
+    "WM_CHANGE_STATE", "WM_CLIENT_LEADER", "WM_WINDOW_ROLE", "UTF8_STRING",
+    "COMPOUND_TEXT", "TEXT", "CLIPBOARD", "TARGETS", "MULTIPLE", "TIMESTAMP",
+    "INCR", "_NET_SUPPORTED", "_NET_ACTIVE_WINDOW", "_NET_WORKAREA",
+    "_NET_WM_NAME", "_NET_WM_ICON_NAME", "_NET_WM_ICON", "_NET_WM_PID",
+    "_NET_WM_PING", "_NET_WM_STATE", "_NET_WM_USER_TIME",
+    "_NET_WM_SYNC_REQUEST", "_NET_WM_WINDOW_TYPE",
+    "_NET_WM_WINDOW_TYPE_NORMAL", "_NET_WM_WINDOW_TYPE_DIALOG",
+    "_MOTIF_WM_HINTS", "XdndAware"
+};
+
+#define NUM_PREDEFINED (sizeof(predefinedAtoms) / sizeof(predefinedAtoms[0]))
+#define NUM_COMMON (sizeof(commonAtoms) / sizeof(commonAtoms[0]))
+
+/*
+ * Create the atom cache, filled in with the predefined atoms so that they
+ * never need a round trip.
+ */
+static AtomTable *
+_XNewAtomTable(Display *dpy)
+{
+    unsigned int i;
+
+    dpy->atoms = Xcalloc(1, sizeof(AtomTable));
+    if (dpy->atoms) {
+	dpy->free_funcs->atoms = _XFreeAtomTable;
+	for (i = 0; i < NUM_PREDEFINED; i++)
+	    _XUpdateAtomCache(dpy, predefinedAtoms[i], (Atom) (i + 1),
+			      0, -1, 0);
+    }
+    return dpy->atoms;
+}
+
+/*
+ * Intern the common atoms in one pipelined batch, so that a new client
+ * finds them in the cache.  Only done when XLIB_PREFETCH_ATOMS is set;
+ * atoms the server does not know yet are not created.
+ */
+void
+_XPrefetchAtoms(Display *dpy)
+{
+    Atom atoms[NUM_COMMON];
+
+    if (getenv("XLIB_PREFETCH_ATOMS"))
+	XInternAtoms(dpy, (char **) commonAtoms, NUM_COMMON, True, atoms);
+}
+
 void
 _XFreeAtomTable(Display *dpy)
 {
@@ -72,10 +139,8 @@ Atom _XInternAtom(
     xInternAtomReq *req;
 
     /* look in the cache first */
-    if (!(atoms = dpy->atoms)) {
-	dpy->atoms = atoms = Xcalloc(1, sizeof(AtomTable));
-	dpy->free_funcs->atoms = _XFreeAtomTable;
-    }
+    if (!(atoms = dpy->atoms))
+	atoms = _XNewAtomTable(dpy);
     sig = 0;
     for (s1 = (char *)name; (c = *s1++); )
 	sig += c;
@@ -127,10 +192,8 @@ _XUpdateAtomCache(
     int firstidx, rehash;
 
     if (!dpy->atoms) {
-	if (idx < 0) {
-	    dpy->atoms = Xcalloc(1, sizeof(AtomTable));
-	    dpy->free_funcs->atoms = _XFreeAtomTable;
-	}
+	if (idx < 0)
+	    _XNewAtomTable(dpy);
 	if (!dpy->atoms)
 	    return;
     }
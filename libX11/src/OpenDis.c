@@ -34,6 +34,7 @@ in this Software without prior written authorization from The Open Group.
 #include <stdio.h>
 #include <unistd.h>
 #include "Xintconn.h"
+#include "Xintatom.h"
 
 #ifdef XKB
 #include "XKBlib.h"
@@ -568,6 +569,7 @@ XOpenDisplay (
 #ifdef XKB
 	XkbUseExtension(dpy,NULL,NULL);
 #endif
+	_XPrefetchAtoms(dpy);
 /*
  * and return successfully
  */
@@ -7,7 +7,7 @@
 
 /* IntAtom.c */
 
-#define TABLESIZE 64
+#define TABLESIZE 256
 
 typedef struct _Entry {
     unsigned long sig;
@@ -27,6 +27,7 @@ _XFUNCPROTOBEGIN
 extern void _XUpdateAtomCache(Display *dpy, const char *name, Atom atom,
 				unsigned long sig, int idx, int n);
 extern void _XFreeAtomTable(Display *dpy);
+extern void _XPrefetchAtoms(Display *dpy);
 
 _XFUNCPROTOEND
 
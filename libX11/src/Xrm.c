@@ -181,10 +181,28 @@ typedef struct _LTable {
  * XrmSearchList, which is a complete crock, but we'll just leave it
  * and caste types as required.
  */
+/*
+ * XrmQGetSearchList results, remembered per database.  Xt asks for the
+ * search list of every widget it creates, and the same name/class paths
+ * come up again and again.  Each entry holds the name and class quarks of
+ * the path and the tables found for it; the whole cache is dropped when
+ * the database changes, since the tables may move.
+ */
+#define SEARCHCACHESIZE 64
+
+typedef struct _SearchCacheEntry {
+    unsigned long	hash;
+    int			nquarks;	/* names (and classes) in the path */
+    int			nlist;		/* tables in the search list */
+    XrmQuark		*quarks;	/* names then classes */
+    LTable		*list;
+} SearchCacheEntry;
+
 typedef struct _XrmHashBucketRec {
     NTable table;
     XPointer mbstate;
     XrmMethods methods;
+    SearchCacheEntry *searchCache;	/* SEARCHCACHESIZE entries, or NULL */
 #ifdef XTHREADS
     LockInfoRec linfo;
 #endif
@@ -500,6 +518,7 @@ static XrmDatabase NewDatabase(void)
 	_XCreateMutex(&db->linfo);
 	db->table = (NTable)NULL;
 	db->mbstate = (XPointer)NULL;
+	db->searchCache = NULL;
 	db->methods = _XrmInitParseInfo(&db->mbstate);
 	if (!db->methods)
 	    db->methods = &mb_methods;
@@ -507,6 +526,34 @@ static XrmDatabase NewDatabase(void)
     return db;
 }
 
+/* forget all cached search lists; the database is about to change */
+static void FlushSearchCache(
+    XrmDatabase db)
+{
+    register int i;
+
+    if (db->searchCache) {
+	for (i = 0; i < SEARCHCACHESIZE; i++)
+	    Xfree(db->searchCache[i].quarks);
+	Xfree(db->searchCache);
+	db->searchCache = NULL;
+    }
+}
+
+static unsigned long HashSearchPath(
+    XrmNameList		names,
+    XrmClassList	classes,
+    int			*nquarks)
+{
+    register unsigned long hash = 0;
+    register int i;
+
+    for (i = 0; names[i]; i++)
+	hash = (hash * 31 + names[i]) * 31 + classes[i];
+    *nquarks = i;
+    return hash;
+}
+
 /* move all values from ftable to ttable, and free ftable's buckets.
  * ttable is guaranteed empty to start with.
  */
@@ -798,6 +845,8 @@ void XrmCombineDatabase(
 		    *prev = ftable;
 	    }
 	}
+	FlushSearchCache(*into);
+	FlushSearchCache(from);
 	(from->methods->destroy)(from->mbstate);
 	_XUnlockMutex(&from->linfo);
 	_XFreeMutex(&from->linfo);
@@ -853,6 +902,7 @@ static void PutEntry(
 
     if (!db || !*quarks)
 	return;
+    FlushSearchCache(db);
     table = *(prev = &db->table);
     /* if already at leaf, bump to the leaf table */
     if (!quarks[1] && table && !table->leaf)
@@ -2252,6 +2302,62 @@ static Bool SearchNEntry(
     return False;
 }
 
+/* look for a cached search list; the caller holds the database lock */
+static Bool LookupSearchCache(
+    XrmDatabase		db,
+    XrmNameList		names,
+    XrmClassList	classes,
+    unsigned long	hash,
+    int			nquarks,
+    LTable		*list,
+    int			listLength)
+{
+    register SearchCacheEntry *entry;
+
+    if (!db->searchCache)
+	return False;
+    entry = &db->searchCache[hash % SEARCHCACHESIZE];
+    if (!entry->quarks || entry->hash != hash ||
+	entry->nquarks != nquarks || entry->nlist + 1 > listLength ||
+	memcmp(entry->quarks, names, nquarks * sizeof(XrmQuark)) ||
+	memcmp(entry->quarks + nquarks, classes, nquarks * sizeof(XrmQuark)))
+	return False;
+    memcpy(list, entry->list, entry->nlist * sizeof(LTable));
+    list[entry->nlist] = (LTable)NULL;
+    return True;
+}
+
+/* remember a complete search list; the caller holds the database lock */
+static void AddSearchCache(
+    XrmDatabase		db,
+    XrmNameList		names,
+    XrmClassList	classes,
+    unsigned long	hash,
+    int			nquarks,
+    LTable		*list,
+    int			nlist)
+{
+    register SearchCacheEntry *entry;
+    XrmQuark *quarks;
+
+    if (!db->searchCache &&
+	!(db->searchCache = Xcalloc(SEARCHCACHESIZE, sizeof(SearchCacheEntry))))
+	return;
+    quarks = Xmalloc(2 * nquarks * sizeof(XrmQuark) + nlist * sizeof(LTable));
+    if (!quarks)
+	return;
+    entry = &db->searchCache[hash % SEARCHCACHESIZE];
+    Xfree(entry->quarks);
+    entry->hash = hash;
+    entry->nquarks = nquarks;
+    entry->nlist = nlist;
+    entry->quarks = quarks;
+    entry->list = (LTable *)(quarks + 2 * nquarks);
+    memcpy(quarks, names, nquarks * sizeof(XrmQuark));
+    memcpy(quarks + nquarks, classes, nquarks * sizeof(XrmQuark));
+    memcpy(entry->list, list, nlist * sizeof(LTable));
+}
+
 Bool XrmQGetSearchList(
     XrmDatabase     db,
     XrmNameList	    names,
@@ -2261,6 +2367,8 @@ Bool XrmQGetSearchList(
 {
     register NTable	table;
     SClosureRec		closure;
+    unsigned long	hash;
+    int			nquarks;
 
     if (listLength <= 0)
 	return False;
@@ -2269,6 +2377,12 @@ Bool XrmQGetSearchList(
     closure.limit = listLength - 2;
     if (db) {
 	_XLockMutex(&db->linfo);
+	hash = HashSearchPath(names, classes, &nquarks);
+	if (LookupSearchCache(db, names, classes, hash, nquarks,
+			      closure.list, listLength)) {
+	    _XUnlockMutex(&db->linfo);
+	    return True;
+	}
 	table = db->table;
 	if (*names) {
 	    if (table && !table->leaf) {
@@ -2291,6 +2405,8 @@ Bool XrmQGetSearchList(
 		return False;
 	    }
 	}
+	AddSearchCache(db, names, classes, hash, nquarks,
+		       closure.list, closure.idx + 1);
 	_XUnlockMutex(&db->linfo);
     }
     closure.list[closure.idx + 1] = (LTable)NULL;
@@ -2658,6 +2774,7 @@ void XrmDestroyDatabase(
 	    else
 		DestroyNTable(table);
 	}
+	FlushSearchCache(db);
 	_XUnlockMutex(&db->linfo);
 	_XFreeMutex(&db->linfo);
 	(*db->methods->destroy)(db->mbstate);
@@ -26,6 +26,8 @@ typedef struct _X11XCBPrivate {
 	xcb_connection_t *connection;
 	PendingRequest *pending_requests;
 	PendingRequest *pending_requests_tail;
+	PendingRequest *free_requests;
+	int free_request_count;
 	xcb_generic_event_t *next_event;
 	void *next_response;
 	char *real_bufmax;
@@ -102,6 +102,12 @@ void _XFreeX11XCBStructure(Display *dpy)
 		dpy->xcb->pending_requests = tmp->next;
 		free(tmp);
 	}
+	while(dpy->xcb->free_requests)
+	{
+		PendingRequest *tmp = dpy->xcb->free_requests;
+		dpy->xcb->free_requests = tmp->next;
+		free(tmp);
+	}
 	if (dpy->xcb->event_notify)
 		xcondition_clear(dpy->xcb->event_notify);
 	if (dpy->xcb->reply_notify)
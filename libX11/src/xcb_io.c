@@ -146,9 +146,19 @@ static Bool check_internal_connections(Display *dpy)
 	return True;
 }
 
+/* Dequeued PendingRequests are kept for reuse, up to this many. */
+#define MAX_FREE_REQUESTS 256
+
 static PendingRequest *append_pending_request(Display *dpy, uint64_t sequence)
 {
-	PendingRequest *node = malloc(sizeof(PendingRequest));
+	PendingRequest *node = dpy->xcb->free_requests;
+	if(node)
+	{
+		dpy->xcb->free_requests = node->next;
+		--dpy->xcb->free_request_count;
+	}
+	else
+		node = malloc(sizeof(PendingRequest));
 	assert(node!=NULL);
 	node->next = NULL;
 	node->sequence = sequence;
@@ -194,7 +204,14 @@ static void dequeue_pending_request(Display *dpy, PendingRequest *req)
 		                         "dequeuing request",
 		                         xcb_xlib_threads_sequence_lost);
 
-	free(req);
+	if(dpy->xcb->free_request_count < MAX_FREE_REQUESTS)
+	{
+		req->next = dpy->xcb->free_requests;
+		dpy->xcb->free_requests = req;
+		++dpy->xcb->free_request_count;
+	}
+	else
+		free(req);
 }
 
 static int handle_error(Display *dpy, xError *err, Bool in_XReply)
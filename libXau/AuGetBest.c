@@ -29,6 +29,7 @@ in this Software without prior written authorization from The Open Group.
 #endif
 #include <X11/Xauth.h>
 #include <X11/Xos.h>
+#include "Xauint.h"
 #ifdef XTHREADS
 #include <X11/Xthreads.h>
 #endif
@@ -38,12 +39,6 @@ in this Software without prior written authorization from The Open Group.
 #include <X11/Xos_r.h>
 #endif
 
-#ifdef O_CLOEXEC
-#define FOPEN_CLOEXEC "e"
-#else
-#define FOPEN_CLOEXEC ""
-#endif
-
 #define binaryEqual(a, b, len) (memcmp(a, b, len) == 0)
 
 Xauth *
@@ -66,10 +61,12 @@ XauGetBestAuthByAddr (
     char**		types,
     _Xconst int*	type_lengths)
 {
-    FILE    *auth_file;
     char    *auth_name;
-    Xauth   *entry;
+    char    *buf;
+    size_t  len, pos, used;
+    Xauth   entry;
     Xauth   *best;
+    Xauth   best_entry;
     int	    best_type;
     int	    type;
 #ifdef hpux
@@ -80,10 +77,8 @@ XauGetBestAuthByAddr (
     auth_name = XauFileName ();
     if (!auth_name)
 	return NULL;
-    if (access (auth_name, R_OK) != 0)		/* checks REAL id */
-	return NULL;
-    auth_file = fopen (auth_name, "rb" FOPEN_CLOEXEC);
-    if (!auth_file)
+    buf = _XauReadFile (auth_name, &len);
+    if (!buf)
 	return NULL;
 
 #ifdef hpux
@@ -108,9 +103,9 @@ XauGetBestAuthByAddr (
 
     best = NULL;
     best_type = types_length;
-    for (;;) {
-	entry = XauReadAuth (auth_file);
-	if (!entry)
+    for (pos = 0; pos < len; pos += used) {
+	used = _XauParseAuth (buf + pos, len - pos, &entry);
+	if (!used)
 	    break;
 	/*
 	 * Match when:
@@ -125,45 +120,45 @@ XauGetBestAuthByAddr (
 	 *    name and entry->name are the same
 	 */
 
-	if ((family == FamilyWild || entry->family == FamilyWild ||
-	     (entry->family == family &&
-	     ((address_length == entry->address_length &&
-	      binaryEqual (entry->address, address, address_length))
+	if ((family == FamilyWild || entry.family == FamilyWild ||
+	     (entry.family == family &&
+	     ((address_length == entry.address_length &&
+	      binaryEqual (entry.address, address, address_length))
 #ifdef hpux
 	     || (family == FamilyLocal &&
-		fully_qual_address_length == entry->address_length &&
-	     	binaryEqual (entry->address, fully_qual_address,
+		fully_qual_address_length == entry.address_length &&
+	     	binaryEqual (entry.address, fully_qual_address,
 		    fully_qual_address_length))
 #endif
 	    ))) &&
-	    (number_length == 0 || entry->number_length == 0 ||
-	     (number_length == entry->number_length &&
-	      binaryEqual (entry->number, number, number_length))))
+	    (number_length == 0 || entry.number_length == 0 ||
+	     (number_length == entry.number_length &&
+	      binaryEqual (entry.number, number, number_length))))
 	{
 	    if (best_type == 0)
 	    {
-		best = entry;
+		best_entry = entry;
+		best = &best_entry;
 		break;
 	    }
 	    for (type = 0; type < best_type; type++)
-		if (type_lengths[type] == entry->name_length &&
-		    !(strncmp (types[type], entry->name, entry->name_length)))
+		if (type_lengths[type] == entry.name_length &&
+		    !(strncmp (types[type], entry.name, entry.name_length)))
 		{
 		    break;
 		}
 	    if (type < best_type)
 	    {
-		if (best)
-		    XauDisposeAuth (best);
-		best = entry;
+		best_entry = entry;
+		best = &best_entry;
 		best_type = type;
 		if (type == 0)
 		    break;
-		continue;
 	    }
 	}
-	XauDisposeAuth (entry);
     }
-    (void) fclose (auth_file);
+    if (best)
+	best = _XauCopyAuth (best);
+    _XauFreeFile (buf, len);
     return best;
 }
@@ -45,6 +45,28 @@ in this Software without prior written authorization from The Open Group.
 #define O_CLOEXEC	0
 #endif
 
+/*
+ * The lock is usually held just long enough to rewrite the file, so poll
+ * for it after a few milliseconds first, backing off to a second between
+ * attempts, instead of sleeping whole timeouts.
+ */
+#define LOCK_FIRST_PAUSE	10	/* ms */
+#define LOCK_MAX_PAUSE		1000	/* ms */
+
+static void
+lock_pause (long ms)
+{
+#ifdef WIN32
+    Sleep ((DWORD) ms);
+#else
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    (void) nanosleep (&ts, NULL);
+#endif
+}
+
 int
 XauLockAuth (
 _Xconst char *file_name,
@@ -56,6 +78,7 @@ long	dead)
     struct stat	statb;
     Time_t	now;
     int		creat_fd = -1;
+    long	pause = LOCK_FIRST_PAUSE, waited = 0;
 
     if (strlen (file_name) > 1022)
 	return LOCK_ERROR;
@@ -106,8 +129,22 @@ long	dead)
 		    return LOCK_ERROR;
 	   }
 	}
-	(void) sleep ((unsigned) timeout);
-	--retries;
+	/* a retry is used up for each timeout seconds spent waiting */
+	if (timeout <= 0) {
+	    --retries;
+	    continue;
+	}
+	if (pause > timeout * 1000L - waited)
+	    pause = timeout * 1000L - waited;
+	lock_pause (pause);
+	waited += pause;
+	if (waited >= timeout * 1000L) {
+	    waited = 0;
+	    --retries;
+	}
+	pause *= 2;
+	if (pause > LOCK_MAX_PAUSE)
+	    pause = LOCK_MAX_PAUSE;
     }
     return LOCK_TIMEOUT;
 }
@@ -28,7 +28,16 @@ in this Software without prior written authorization from The Open Group.
 #include <config.h>
 #endif
 #include <X11/Xauth.h>
+#include <X11/Xos.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include "Xauint.h"
+
+#ifdef O_CLOEXEC
+#define FOPEN_CLOEXEC "e"
+#else
+#define FOPEN_CLOEXEC ""
+#endif
 
 static int
 read_short (unsigned short *shortp, FILE *file)
@@ -114,3 +123,131 @@ XauReadAuth (FILE *auth_file)
     }
     return NULL;
 }
+
+static void
+clear_data (char *data, size_t len)
+{
+#ifdef HAVE_EXPLICIT_BZERO
+    explicit_bzero (data, len);
+#else
+    bzero (data, len);
+#endif
+}
+
+char *
+_XauReadFile (_Xconst char *file_name, size_t *length)
+{
+    FILE	*file;
+    struct stat	statb;
+    char	*buf, *bigger;
+    size_t	size, len = 0, n;
+
+    if (access (file_name, R_OK) != 0)		/* checks REAL id */
+	return NULL;
+    file = fopen (file_name, "rb" FOPEN_CLOEXEC);
+    if (!file)
+	return NULL;
+    /* the file may still grow; one more byte tells us we got all of it */
+    size = 4096;
+    if (fstat (fileno (file), &statb) == 0 && statb.st_size > 0)
+	size = (size_t) statb.st_size + 1;
+    buf = malloc (size);
+    while (buf) {
+	n = fread (buf + len, 1, size - len, file);
+	len += n;
+	if (len < size)
+	    break;
+	/* don't leave copies of the keys behind in freed memory */
+	bigger = malloc (size * 2);
+	if (bigger)
+	    memcpy (bigger, buf, len);
+	_XauFreeFile (buf, len);
+	buf = bigger;
+	size *= 2;
+    }
+    (void) fclose (file);
+    *length = len;
+    return buf;
+}
+
+void
+_XauFreeFile (char *buf, size_t length)
+{
+    if (buf) {
+	clear_data (buf, length);
+	free (buf);
+    }
+}
+
+static int
+parse_counted_string (_Xconst char **bufp, _Xconst char *end,
+		      unsigned short *countp, char **stringp)
+{
+    _Xconst unsigned char *p = (_Xconst unsigned char *) *bufp;
+    unsigned short len;
+
+    if (end - *bufp < 2)
+	return 0;
+    len = p[0] * 256 + p[1];
+    if (end - *bufp - 2 < len)
+	return 0;
+    *countp = len;
+    *stringp = len ? (char *) *bufp + 2 : NULL;
+    *bufp += 2 + len;
+    return 1;
+}
+
+size_t
+_XauParseAuth (_Xconst char *buf, size_t length, Xauth *entry)
+{
+    _Xconst char *p = buf, *end = buf + length;
+
+    if (length < 2)
+	return 0;
+    entry->family = (unsigned char) p[0] * 256 + (unsigned char) p[1];
+    p += 2;
+    if (!parse_counted_string (&p, end, &entry->address_length,
+			       &entry->address) ||
+	!parse_counted_string (&p, end, &entry->number_length,
+			       &entry->number) ||
+	!parse_counted_string (&p, end, &entry->name_length, &entry->name) ||
+	!parse_counted_string (&p, end, &entry->data_length, &entry->data))
+	return 0;
+    return p - buf;
+}
+
+static int
+copy_counted_string (unsigned short len, _Xconst char *from, char **to)
+{
+    if (len == 0) {
+	*to = NULL;
+	return 1;
+    }
+    *to = malloc (len);
+    if (!*to)
+	return 0;
+    memcpy (*to, from, len);
+    return 1;
+}
+
+Xauth *
+_XauCopyAuth (_Xconst Xauth *entry)
+{
+    Xauth *ret;
+
+    ret = calloc (1, sizeof (Xauth));
+    if (!ret)
+	return NULL;
+    *ret = *entry;
+    ret->address = ret->number = ret->name = ret->data = NULL;
+    if (!copy_counted_string (entry->address_length, entry->address,
+			      &ret->address) ||
+	!copy_counted_string (entry->number_length, entry->number,
+			      &ret->number) ||
+	!copy_counted_string (entry->name_length, entry->name, &ret->name) ||
+	!copy_counted_string (entry->data_length, entry->data, &ret->data)) {
+	XauDisposeAuth (ret);
+	return NULL;
+    }
+    return ret;
+}
@@ -0,0 +1,24 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Internal interfaces shared by the libXau sources.
+ */
+
+#ifndef _XAUINT_H_
+#define _XAUINT_H_
+
+#include <X11/Xauth.h>
+#include <stddef.h>
+
+/*
+ * The lookup functions read the whole authority file in one go and parse
+ * the entries where they lie, rather than going through stdio and four
+ * allocations per entry.  Entries filled in by _XauParseAuth point into
+ * the buffer; _XauCopyAuth makes one the caller can keep.
+ */
+char *_XauReadFile(_Xconst char *file_name, size_t *length);
+void _XauFreeFile(char *buf, size_t length);
+size_t _XauParseAuth(_Xconst char *buf, size_t length, Xauth *entry);
+Xauth *_XauCopyAuth(_Xconst Xauth *entry);
+
+#endif /* _XAUINT_H_ */
@@ -56,6 +56,7 @@ extern BufFilePtr BufFileCreate (
     int (*)(BufFilePtr, int),
     int (*)(BufFilePtr, int));
 extern BufFilePtr BufFileOpenRead ( int );
+extern BufFilePtr BufFileOpenMapped ( int );
 extern BufFilePtr BufFileOpenWrite ( int );
 extern BufFilePtr BufFilePushCompressed ( BufFilePtr );
 #ifdef X_GZIP_FONT_COMPRESSION
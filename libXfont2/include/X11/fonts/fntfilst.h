@@ -100,6 +100,7 @@ typedef struct _FontTable {
     int		    size;
     FontEntryPtr    entries;
     Bool	    sorted;
+    struct _FontTableIndex *index;	/* for wildcards, built on demand */
 } FontTableRec;
 
 typedef struct _FontDirectory {
@@ -138,6 +138,13 @@ FT_Library ftypeLibrary;
 
 static FTFacePtr faceTable[NUMFACEBUCKETS];
 
+/* Faces whose last instance went away, most recently used first.
+   Listing fonts with info opens and closes every face it looks at, and
+   clients often open the same few fonts over and over, so parsing a
+   face again each time is avoided for the last few. */
+static FTFacePtr idleFaces;
+static int numIdleFaces;
+
 static unsigned
 hash(char *string)
 {
@@ -188,6 +195,18 @@ FreeTypeOpenFace(FTFacePtr *facep, char *FTFileName, char *realFileName, int fac
     }
     if(otherFace) {
         MUMBLE("Returning cached face: %s\n", otherFace->filename);
+        if(otherFace->idle) {
+            FTFacePtr *prev;
+
+            for(prev = &idleFaces; *prev; prev = &(*prev)->idle_next)
+                if(*prev == otherFace) {
+                    *prev = otherFace->idle_next;
+                    break;
+                }
+            otherFace->idle = 0;
+            otherFace->idle_next = NULL;
+            numIdleFaces--;
+        }
         *facep = otherFace;
         return Successful;
     }
@@ -231,32 +250,53 @@ FreeTypeOpenFace(FTFacePtr *facep, char *FTFileName, char *realFileName, int fac
 }
 
 static void
-FreeTypeFreeFace(FTFacePtr face)
+FreeTypeDestroyFace(FTFacePtr face)
 {
     int bucket;
     FTFacePtr otherFace;
 
-    if(!face->instances) {
-        bucket = hash(face->filename) % NUMFACEBUCKETS;
-        if(faceTable[bucket] == face)
-            faceTable[bucket] = face->next;
-        else {
-            otherFace = faceTable[bucket];
-            while(otherFace) {
-                if(otherFace->next == face)
-                    break;
-                otherFace = otherFace->next;
-            }
-            if(otherFace && otherFace->next)
-                otherFace->next = otherFace->next->next;
-            else
-                ErrorF("FreeType: freeing unknown face\n");
+    bucket = hash(face->filename) % NUMFACEBUCKETS;
+    if(faceTable[bucket] == face)
+        faceTable[bucket] = face->next;
+    else {
+        otherFace = faceTable[bucket];
+        while(otherFace) {
+            if(otherFace->next == face)
+                break;
+            otherFace = otherFace->next;
         }
-        MUMBLE("Closing face: %s\n", face->filename);
-        FT_Done_Face(face->face);
-        free(face->filename);
-        free(face);
+        if(otherFace && otherFace->next)
+            otherFace->next = otherFace->next->next;
+        else
+            ErrorF("FreeType: freeing unknown face\n");
     }
+    MUMBLE("Closing face: %s\n", face->filename);
+    FT_Done_Face(face->face);
+    free(face->filename);
+    free(face);
+}
+
+static void
+FreeTypeFreeFace(FTFacePtr face)
+{
+    FTFacePtr *prev;
+
+    if(face->instances || face->idle)
+        return;
+
+    face->idle = 1;
+    face->idle_next = idleFaces;
+    idleFaces = face;
+    if(++numIdleFaces <= NUMIDLEFACES)
+        return;
+
+    /* Close the least recently used one */
+    for(prev = &idleFaces; (*prev)->idle_next; prev = &(*prev)->idle_next)
+        ;
+    face = *prev;
+    *prev = NULL;
+    numIdleFaces--;
+    FreeTypeDestroyFace(face);
 }
 
 static int
@@ -421,6 +461,7 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
 
     instance->refcount = 1;
     instance->face = face;
+    instance->bounds = NULL;
 
     instance->load_flags = load_flags;
     instance->spacing    = spacing;		/* Actual spacing */
@@ -571,6 +612,11 @@ FreeTypeFreeInstance(FTInstancePtr instance)
         if(instance->forceConstantMetrics) {
             free(instance->forceConstantMetrics);
         }
+        while(instance->bounds) {
+            FTBoundsPtr next = instance->bounds->next;
+            free(instance->bounds);
+            instance->bounds = next;
+        }
         if(instance->glyphs) {
             for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
                 if(instance->glyphs[i]) {
@@ -2944,10 +2990,33 @@ ft_compute_bounds(FTFontPtr font, FontInfoPtr pinfo, FontScalablePtr vals )
     int num_cols, num_chars = 0;
     int flags, skip_ok = 0;
     int force_c_outside ;
+    FTBoundsPtr bounds;
 
     instance = font->instance;
     force_c_outside = instance->ttcap.flags & TTCAP_FORCE_C_OUTSIDE;
 
+    /* Walking every glyph is what makes opening a big face slow, and the
+       answer only depends on the instance, the mapping and the range, so
+       a second open of the same face at the same size can skip it. */
+    for (bounds = instance->bounds; bounds; bounds = bounds->next) {
+        if (bounds->mapping.named == font->mapping.named &&
+            bounds->mapping.cmap == font->mapping.cmap &&
+            bounds->mapping.base == font->mapping.base &&
+            bounds->mapping.mapping == font->mapping.mapping &&
+            bounds->firstCol == pinfo->firstCol &&
+            bounds->lastCol == pinfo->lastCol &&
+            bounds->firstRow == pinfo->firstRow &&
+            bounds->lastRow == pinfo->lastRow) {
+            vals->width          = bounds->width;
+            pinfo->maxbounds     = bounds->maxbounds;
+            pinfo->minbounds     = bounds->minbounds;
+            pinfo->ink_maxbounds = bounds->maxbounds;
+            pinfo->ink_minbounds = bounds->minbounds;
+            pinfo->maxOverlap    = bounds->maxOverlap;
+            return;
+        }
+    }
+
     minchar.ascent = minchar.descent =
     minchar.leftSideBearing = minchar.rightSideBearing =
     minchar.characterWidth = minchar.attributes = 32767;
@@ -3059,6 +3128,21 @@ ft_compute_bounds(FTFontPtr font, FontInfoPtr pinfo, FontScalablePtr vals )
     pinfo->ink_maxbounds = maxchar;
     pinfo->ink_minbounds = minchar;
     pinfo->maxOverlap    = maxOverlap;
+
+    bounds = malloc(sizeof(FTBoundsRec));
+    if (bounds) {
+        bounds->mapping    = font->mapping;
+        bounds->firstCol   = pinfo->firstCol;
+        bounds->lastCol    = pinfo->lastCol;
+        bounds->firstRow   = pinfo->firstRow;
+        bounds->lastRow    = pinfo->lastRow;
+        bounds->minbounds  = minchar;
+        bounds->maxbounds  = maxchar;
+        bounds->maxOverlap = maxOverlap;
+        bounds->width      = vals->width;
+        bounds->next       = instance->bounds;
+        instance->bounds   = bounds;
+    }
 }
 
 static int
@@ -24,6 +24,9 @@ THE SOFTWARE.
 /* Number of buckets in the hashtable holding faces */
 #define NUMFACEBUCKETS 32
 
+/* Number of faces without instances kept open for reuse */
+#define NUMIDLEFACES 8
+
 /* Glyphs are held in segments of this size */
 #define FONTSEGMENTSIZE 16
 
@@ -50,6 +53,8 @@ typedef struct _FTFace {
     struct _FTInstance *instances;
     struct _FTInstance *active_instance;
     struct _FTFace *next;       /* link to next face in bucket */
+    int idle;                   /* on the idle list, no instances */
+    struct _FTFace *idle_next;
 } FTFaceRec, *FTFacePtr;
 
 /* A transformation matrix with resolution information */
@@ -116,6 +121,16 @@ struct TTCapInfo {
    matrix.  Multiple fonts may share the same instance. */
 
 /* This structure caches bitmap data */
+/* The bounds of one font on an instance, for the next font alike */
+typedef struct _FTBounds {
+    struct _FTBounds *next;
+    FTMappingRec mapping;
+    unsigned short firstCol, lastCol, firstRow, lastRow;
+    xCharInfo minbounds, maxbounds;
+    int maxOverlap;
+    int width;
+} FTBoundsRec, *FTBoundsPtr;
+
 typedef struct _FTInstance {
     FTFacePtr face;             /* the associated face */
     FT_Size size;
@@ -136,6 +151,7 @@ typedef struct _FTInstance {
     CharInfoPtr *glyphs;        /* glyphs and available are used in parallel */
     int **available;
     struct TTCapInfo ttcap;
+    FTBoundsPtr bounds;		/* what ft_compute_bounds found */
     int refcount;
     struct _FTInstance *next;   /* link to next instance */
 } FTInstanceRec, *FTInstancePtr;
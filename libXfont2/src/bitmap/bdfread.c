@@ -345,6 +345,7 @@ bdfReadCharacters(FontFilePtr file, FontPtr pFont, bdfFileState *pState,
 	int         bb;		/* bounding-box bottom */
 	int         enc,
 	            enc2;	/* encoding */
+	int         v[4];	/* values read from a line */
 	unsigned char *p;	/* temp pointer into line */
 	char        charName[100];
 	int         ignore;
@@ -357,10 +358,12 @@ bdfReadCharacters(FontFilePtr file, FontPtr pFont, bdfFileState *pState,
 	    bitmapExtra->glyphNames[ndx] = bdfForceMakeAtom(charName, NULL);
 
 	line = bdfGetLine(file, lineBuf, BDFLINELEN);
-	if (!line || (t = sscanf((char *) line, "ENCODING %d %d", &enc, &enc2)) < 1) {
+	if (!line || (t = bdfGetInts(line, "ENCODING", v, 2)) < 1) {
 	    bdfError("bad 'ENCODING' in BDF file\n");
 	    goto BAILOUT;
 	}
+	enc = v[0];
+	enc2 = (t == 2) ? v[1] : 0;
 	if (enc < -1 || (t == 2 && enc2 < -1)) {
 	    bdfError("bad ENCODING value");
 	    goto BAILOUT;
@@ -404,10 +407,12 @@ bdfReadCharacters(FontFilePtr file, FontPtr pFont, bdfFileState *pState,
 	}
 
 	line = bdfGetLine(file, lineBuf, BDFLINELEN);
-	if ((!line) || (sscanf((char *) line, "SWIDTH %d %d", &wx, &wy) != 2)) {
+	if ((!line) || (bdfGetInts(line, "SWIDTH", v, 2) != 2)) {
 	    bdfError("bad 'SWIDTH'\n");
 	    goto BAILOUT;
 	}
+	wx = v[0];
+	wy = v[1];
 	if (wy != 0) {
 	    bdfError("SWIDTH y value must be zero\n");
 	    goto BAILOUT;
@@ -419,10 +424,12 @@ bdfReadCharacters(FontFilePtr file, FontPtr pFont, bdfFileState *pState,
 /*		from all of these.					*/
 
 	line = bdfGetLine(file, lineBuf, BDFLINELEN);
-	if ((!line) || (sscanf((char *) line, "DWIDTH %d %d", &wx, &wy) != 2)) {
+	if ((!line) || (bdfGetInts(line, "DWIDTH", v, 2) != 2)) {
 	    bdfError("bad 'DWIDTH'\n");
 	    goto BAILOUT;
 	}
+	wx = v[0];
+	wy = v[1];
 	if (wy != 0) {
 	    bdfError("DWIDTH y value must be zero\n");
 	    goto BAILOUT;
@@ -434,10 +441,14 @@ bdfReadCharacters(FontFilePtr file, FontPtr pFont, bdfFileState *pState,
 	    goto BAILOUT;
 	}
 	line = bdfGetLine(file, lineBuf, BDFLINELEN);
-	if ((!line) || (sscanf((char *) line, "BBX %d %d %d %d", &bw, &bh, &bl, &bb) != 4)) {
+	if ((!line) || (bdfGetInts(line, "BBX", v, 4) != 4)) {
 	    bdfError("bad 'BBX'\n");
 	    goto BAILOUT;
 	}
+	bw = v[0];
+	bh = v[1];
+	bl = v[2];
+	bb = v[3];
 	if ((bh < 0) || (bw < 0)) {
 	    bdfError("character '%s' has a negative sized bitmap, %dx%d\n",
 		     charName, bw, bh);
@@ -88,6 +88,14 @@ in this Software without prior written authorization from The Open Group.
 #endif
 #define TimeCmp(a,c,b)	((int) ((a) - (b)) c 0)
 
+/*
+ * Toolkits tend to ask for the same few ListFonts patterns over and over
+ * as clients start up; each one is a round trip to the font server, so
+ * keep the answers for a little while.
+ */
+#define FS_LIST_CACHE_SIZE	16
+#define FS_LIST_CACHE_TIME	30000	/* ms */
+
 #define NONZEROMETRICS(pci) ((pci)->leftSideBearing || \
 			     (pci)->rightSideBearing || \
 			     (pci)->ascent || \
@@ -269,12 +277,34 @@ _fs_client_resolution(FSFpePtr conn)
  * this connection - this includes any client records.
  */
 
+static void
+_fs_free_list_cache_entry(FSListCachePtr entry)
+{
+    if (entry->names)
+	xfont2_free_font_names(entry->names);
+    free(entry);
+}
+
+static void
+_fs_flush_list_cache(FSFpePtr conn)
+{
+    FSListCachePtr  entry;
+
+    while ((entry = conn->listCache))
+    {
+	conn->listCache = entry->next;
+	_fs_free_list_cache_entry(entry);
+    }
+}
+
 static void
 fs_close_conn(FSFpePtr conn)
 {
     FSClientPtr	client, nclient;
 
     _fs_close_server (conn);
+    /* whatever answers next may have a different set of fonts */
+    _fs_flush_list_cache (conn);
 
     for (client = conn->clients; client; client = nclient)
     {
@@ -477,6 +507,12 @@ _fs_remove_block_rec(FSFpePtr conn, FSBlockDataPtr blockrec)
 	if (bglyph->num_expected_ranges)
 	    free(bglyph->expected_ranges);
     }
+    if (blockrec->type == FS_LIST_FONTS)
+    {
+	FSBlockedListPtr blist = (FSBlockedListPtr)blockrec->data;
+	if (blist->cache)
+	    _fs_free_list_cache_entry(blist->cache);
+    }
     free(blockrec);
     _fs_set_pending_reply (conn);
 }
@@ -2354,6 +2390,97 @@ fs_load_all_glyphs(FontPtr pfont)
     return err;
 }
 
+static FSListCachePtr
+_fs_new_list_cache(const char *pattern, int patlen, int maxnames)
+{
+    FSListCachePtr  entry;
+
+    entry = malloc(sizeof(FSListCacheRec) + patlen);
+    if (!entry)
+	return NULL;
+    entry->next = NULL;
+    entry->time = 0;
+    entry->maxnames = maxnames;
+    entry->patlen = patlen;
+    entry->pattern = (char *) (entry + 1);
+    memcpy(entry->pattern, pattern, patlen);
+    entry->names = NULL;
+    return entry;
+}
+
+/*
+ * Remember the names from index 'first' on; the record is shared by
+ * every element of the font path, so the ones before came from elsewhere.
+ * Takes ownership of the entry either way.
+ */
+static void
+_fs_add_list_cache(FSFpePtr conn, FSListCachePtr entry,
+		   FontNamesPtr names, int first)
+{
+    FSListCachePtr  *prev, old;
+    int		    i, n;
+
+    entry->names = xfont2_make_font_names_record(names->nnames - first);
+    if (!entry->names)
+    {
+	_fs_free_list_cache_entry(entry);
+	return;
+    }
+    for (i = first; i < names->nnames; i++)
+    {
+	if (xfont2_add_font_names_name(entry->names, names->names[i],
+				       names->length[i]) != Successful)
+	{
+	    _fs_free_list_cache_entry(entry);
+	    return;
+	}
+    }
+    entry->time = GetTimeInMillis ();
+    entry->next = conn->listCache;
+    conn->listCache = entry;
+
+    /* drop whatever falls off the end */
+    for (n = 0, prev = &conn->listCache; (old = *prev); n++)
+    {
+	if (n >= FS_LIST_CACHE_SIZE)
+	{
+	    *prev = old->next;
+	    _fs_free_list_cache_entry(old);
+	}
+	else
+	    prev = &old->next;
+    }
+}
+
+static FSListCachePtr
+_fs_find_list_cache(FSFpePtr conn, const char *pattern, int patlen,
+		    int maxnames)
+{
+    FSListCachePtr  *prev, entry;
+    CARD32	    now = GetTimeInMillis ();
+
+    for (prev = &conn->listCache; (entry = *prev); )
+    {
+	if (TimeCmp (now, >, entry->time + FS_LIST_CACHE_TIME))
+	{
+	    *prev = entry->next;
+	    _fs_free_list_cache_entry(entry);
+	    continue;
+	}
+	if (entry->maxnames == maxnames && entry->patlen == patlen &&
+	    !memcmp(entry->pattern, pattern, patlen))
+	{
+	    /* move to the front so the busy ones stay */
+	    *prev = entry->next;
+	    entry->next = conn->listCache;
+	    conn->listCache = entry;
+	    return entry;
+	}
+	prev = &entry->next;
+    }
+    return NULL;
+}
+
 static int
 fs_read_list(FontPathElementPtr fpe, FSBlockDataPtr blockrec)
 {
@@ -2363,6 +2490,7 @@ fs_read_list(FontPathElementPtr fpe, FSBlockDataPtr blockrec)
     char		*data;
     long		dataleft; /* length of reply left to use */
     int			length,
+			first,
 			i,
 			ret;
     int			err;
@@ -2382,6 +2510,7 @@ fs_read_list(FontPathElementPtr fpe, FSBlockDataPtr blockrec)
     dataleft = (rep->length << 2) - SIZEOF (fsListFontsReply);
 
     err = Successful;
+    first = blist->names->nnames;
     /* copy data into FontPathRecord */
     for (i = 0; i < rep->nFonts; i++)
     {
@@ -2405,6 +2534,8 @@ fs_read_list(FontPathElementPtr fpe, FSBlockDataPtr blockrec)
 	dataleft -= length;
     }
     _fs_done_read (conn, rep->length << 2);
+    if (err == Successful && blist->cache)
+	_fs_add_list_cache (conn, blist->cache, blist->names, first);
     return err;
 }
 
@@ -2426,6 +2557,7 @@ fs_send_list_fonts(pointer client, FontPathElementPtr fpe, const char *pattern,
 	return AllocError;
     blockedlist = (FSBlockedListPtr) blockrec->data;
     blockedlist->names = newnames;
+    blockedlist->cache = _fs_new_list_cache(pattern, patlen, maxnames);
 
     if (conn->blockState & (FS_BROKEN_CONNECTION | FS_RECONNECTING))
     {
@@ -2469,7 +2601,9 @@ fs_list_fonts(pointer client, FontPathElementPtr fpe,
 {
     FSFpePtr		conn = (FSFpePtr) fpe->private;
     FSBlockDataPtr	blockrec;
+    FSListCachePtr	cache;
     int			err;
+    int			i;
 
     /* see if the result is already there */
     for (blockrec = conn->blockedRequests; blockrec; blockrec = blockrec->next)
@@ -2484,6 +2618,20 @@ fs_list_fonts(pointer client, FontPathElementPtr fpe,
 	}
     }
 
+    /* or if someone asked the same thing a moment ago */
+    cache = _fs_find_list_cache(conn, pattern, patlen, maxnames);
+    if (cache)
+    {
+	for (i = 0; i < cache->names->nnames; i++)
+	{
+	    err = xfont2_add_font_names_name(newnames, cache->names->names[i],
+					     cache->names->length[i]);
+	    if (err != Successful)
+		return err;
+	}
+	return Successful;
+    }
+
     /* didn't find waiting record, so send a new one */
     return fs_send_list_fonts(client, fpe, pattern, patlen, maxnames, newnames);
 }
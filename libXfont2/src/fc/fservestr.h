@@ -107,9 +107,20 @@ typedef struct _fs_blocked_bitmaps {
     pointer     gdata;
 }           FSBlockedBitmapRec;
 
+/* a recent ListFonts reply, reused for the same pattern */
+typedef struct _fs_list_cache {
+    struct _fs_list_cache *next;
+    CARD32	time;		/* when the reply arrived */
+    int		maxnames;
+    int		patlen;
+    char	*pattern;
+    FontNamesPtr names;		/* just the names this server returned */
+}	    FSListCacheRec, *FSListCachePtr;
+
 /* state for blocked ListFonts */
 typedef struct _fs_blocked_list {
     FontNamesPtr names;
+    FSListCachePtr cache;	/* where to keep the reply, if anywhere */
 }           FSBlockedListRec;
 
 /* state for blocked ListFontsWithInfo */
@@ -115,6 +115,7 @@ typedef struct _fs_fpe_data {
     CARD32	brokenConnectionTime;	/* time to retry broken connection */
 
     FSBlockDataPtr  blockedRequests;
+    struct _fs_list_cache *listCache;	/* recent ListFonts replies */
 
     struct _XtransConnInfo *trans_conn; /* transport connection object */
 }           FSFpeRec;
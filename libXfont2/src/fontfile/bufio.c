@@ -39,6 +39,13 @@ from The Open Group.
 #include <X11/fonts/fontmisc.h>
 #include <X11/fonts/bufio.h>
 #include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#elif defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
 
 BufFilePtr
 BufFileCreate (char *private,
@@ -120,6 +127,114 @@ BufFileRawClose (BufFilePtr f, int doClose)
     return 1;
 }
 
+#if defined(WIN32) || defined(HAVE_MMAP)
+/*
+ * A mapped file is one big buffer: bufp walks through the mapping and
+ * there is never anything more to fill.  The pages come straight from
+ * the file cache, so every process reading the same font shares them.
+ */
+typedef struct _mapped_file {
+    int	    fd;
+    void    *addr;
+    size_t  size;
+} MappedFileRec, *MappedFilePtr;
+
+static int
+BufFileMappedFill (BufFilePtr f)
+{
+    f->left = 0;
+    return BUFFILEEOF;
+}
+
+static int
+BufFileMappedSkip (BufFilePtr f, int count)
+{
+    if (count > f->left) {
+	f->bufp += f->left;
+	f->left = 0;
+	return BUFFILEEOF;
+    }
+    f->bufp += count;
+    f->left -= count;
+    return count;
+}
+
+static int
+BufFileMappedClose (BufFilePtr f, int doClose)
+{
+    MappedFilePtr   m = (MappedFilePtr) f->private;
+
+#ifdef WIN32
+    UnmapViewOfFile (m->addr);
+#else
+    munmap (m->addr, m->size);
+#endif
+    if (doClose)
+	close (m->fd);
+    free (m);
+    return 1;
+}
+
+BufFilePtr
+BufFileOpenMapped (int fd)
+{
+    struct stat	    st;
+    MappedFilePtr   m;
+    BufFilePtr	    f = 0;
+    void	    *addr;
+#ifdef WIN32
+    HANDLE	    map;
+#endif
+
+    /* leave pipes, empty and huge files to the read path */
+    if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) ||
+	st.st_size <= 0 || st.st_size > INT_MAX)
+	return 0;
+
+#ifdef WIN32
+    map = CreateFileMapping ((HANDLE) _get_osfhandle (fd), NULL,
+			     PAGE_READONLY, 0, 0, NULL);
+    if (!map)
+	return 0;
+    addr = MapViewOfFile (map, FILE_MAP_READ, 0, 0, st.st_size);
+    /* the view keeps the mapping alive */
+    CloseHandle (map);
+    if (!addr)
+	return 0;
+#else
+    addr = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+	return 0;
+#endif
+
+    m = malloc (sizeof *m);
+    if (m)
+	f = BufFileCreate ((char *) m, BufFileMappedFill, 0,
+			   BufFileMappedSkip, BufFileMappedClose);
+    if (!m || !f) {
+#ifdef WIN32
+	UnmapViewOfFile (addr);
+#else
+	munmap (addr, st.st_size);
+#endif
+	free (m);
+	return 0;
+    }
+    m->fd = fd;
+    m->addr = addr;
+    m->size = st.st_size;
+    f->bufp = (BufChar *) addr;
+    f->left = st.st_size;
+    return f;
+}
+#else
+BufFilePtr
+BufFileOpenMapped (int fd)
+{
+    return 0;
+}
+#endif
+
 BufFilePtr
 BufFileOpenRead (int fd)
 {
@@ -173,15 +288,26 @@ BufFileOpenWrite (int fd)
 int
 BufFileRead (BufFilePtr f, char *b, int n)
 {
-    int	    c, cnt;
+    int	    c, cnt, len;
     cnt = n;
-    while (cnt--) {
+    while (cnt) {
+	/* take whatever is buffered in one go */
+	if (f->left > 0) {
+	    len = f->left < cnt ? f->left : cnt;
+	    memcpy (b, f->bufp, len);
+	    f->bufp += len;
+	    f->left -= len;
+	    b += len;
+	    cnt -= len;
+	    continue;
+	}
 	c = BufFileGet (f);
 	if (c == BUFFILEEOF)
 	    break;
 	*b++ = c;
+	cnt--;
     }
-    return n - cnt - 1;
+    return n - cnt;
 }
 
 int
@@ -54,7 +54,9 @@ FontFileOpen (const char *name)
     fd = open (name, O_BINARY|O_CLOEXEC|O_NOFOLLOW);
     if (fd < 0)
 	return 0;
-    raw = BufFileOpenRead (fd);
+    raw = BufFileOpenMapped (fd);
+    if (!raw)
+	raw = BufFileOpenRead (fd);
     if (!raw)
     {
 	close (fd);
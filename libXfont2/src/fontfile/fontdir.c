@@ -58,6 +58,7 @@ FontFileInitTable (FontTablePtr table, int size)
     table->used = 0;
     table->size = size;
     table->sorted = FALSE;
+    table->index = NULL;
     return TRUE;
 }
 
@@ -93,11 +94,14 @@ FontFileFreeEntry (FontEntryPtr entry)
     }
 }
 
+static void FontFileFreeIndex (FontTablePtr table);
+
 void
 FontFileFreeTable (FontTablePtr table)
 {
     int	i;
 
+    FontFileFreeIndex (table);
     for (i = 0; i < table->used; i++)
 	FontFileFreeEntry (&table->entries[i]);
     free (table->entries);
@@ -421,6 +425,240 @@ PatternMatch(char *pat, int patdashes, char *string, int stringdashes)
     }
 }
 
+/*
+  A sorted table only narrows a wildcard search down to the names that
+  share the pattern's literal prefix, and patterns like
+  "-*-helvetica-medium-r-normal--12-*-*-*-*-*-iso8859-1" have none, so
+  every name in the table gets a PatternMatch.  When a full XLFD pattern
+  meets a name with as many dashes, each dash in the pattern has to match
+  a dash in the name in turn, which pins every field of the pattern to the
+  same field of the name.  So any field of the pattern without wildcards
+  must equal that field of every name that matches.
+
+  The index keeps, for each XLFD field that has been asked about, the
+  table's full XLFD names sorted by that field.  A search picks the
+  literal field of the pattern that selects the fewest names and only
+  runs PatternMatch on those, along with the few names that have more
+  dashes than an XLFD, which a wildcard may still stretch across.  The
+  index is built a field at a time as patterns need it and only for
+  tables big enough to be worth it; tables are never changed once sorted.
+*/
+
+#define XLFD_NDASHES	14
+#define FONT_INDEX_MIN	256	/* smaller tables are just scanned */
+
+typedef struct _FontFieldKey {
+    const char	*field;
+    int		len;
+    int		entry;
+} FontFieldKeyRec, *FontFieldKeyPtr;
+
+typedef struct _FontTableIndex {
+    FontFieldKeyPtr fields[XLFD_NDASHES];	/* by field, 1 to 14 */
+    int		    nkeys;		/* names with exactly 14 dashes */
+    int		    *others;		/* names with more */
+    int		    nothers;
+} FontTableIndexRec, *FontTableIndexPtr;
+
+static void
+FontFileFreeIndex (FontTablePtr table)
+{
+    FontTableIndexPtr	index = table->index;
+    int			i;
+
+    if (!index)
+	return;
+    for (i = 0; i < XLFD_NDASHES; i++)
+	free (index->fields[i]);
+    free (index->others);
+    free (index);
+    table->index = NULL;
+}
+
+/* Find field n (preceded by n dashes) of a name; its length is returned */
+static int
+FontFileGetField (const char *name, int n, const char **field)
+{
+    const char	*end;
+
+    while (n > 0)
+	if (*name++ == XK_minus)
+	    n--;
+    for (end = name; *end && *end != XK_minus; end++)
+	;
+    *field = name;
+    return end - name;
+}
+
+static int
+FontFileFieldCompare (const char *a, int alen, const char *b, int blen)
+{
+    int	    res = memcmp (a, b, alen < blen ? alen : blen);
+
+    if (res)
+	return res;
+    return alen - blen;
+}
+
+static int
+FontFileKeyCompare (const void *a, const void *b)
+{
+    FontFieldKeyPtr ka = (FontFieldKeyPtr) a,
+		    kb = (FontFieldKeyPtr) b;
+
+    return FontFileFieldCompare (ka->field, ka->len, kb->field, kb->len);
+}
+
+static int
+FontFileIntCompare (const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+static FontTableIndexPtr
+FontFileGetIndex (FontTablePtr table)
+{
+    FontTableIndexPtr	index = table->index;
+    int			i;
+
+    if (index)
+	return index;
+    index = calloc (1, sizeof (FontTableIndexRec));
+    if (!index)
+	return NULL;
+    for (i = 0; i < table->used; i++) {
+	if (table->entries[i].name.ndashes == XLFD_NDASHES)
+	    index->nkeys++;
+	else if (table->entries[i].name.ndashes > XLFD_NDASHES)
+	    index->nothers++;
+    }
+    if (index->nothers) {
+	index->others = mallocarray (index->nothers, sizeof (int));
+	if (!index->others) {
+	    free (index);
+	    return NULL;
+	}
+	index->nothers = 0;
+	for (i = 0; i < table->used; i++)
+	    if (table->entries[i].name.ndashes > XLFD_NDASHES)
+		index->others[index->nothers++] = i;
+    }
+    table->index = index;
+    return index;
+}
+
+static FontFieldKeyPtr
+FontFileGetFieldKeys (FontTablePtr table, FontTableIndexPtr index, int n)
+{
+    FontFieldKeyPtr keys = index->fields[n - 1];
+    int		    i, k;
+
+    if (keys || !index->nkeys)
+	return keys;
+    keys = mallocarray (index->nkeys, sizeof (FontFieldKeyRec));
+    if (!keys)
+	return NULL;
+    for (i = 0, k = 0; i < table->used; i++) {
+	if (table->entries[i].name.ndashes != XLFD_NDASHES)
+	    continue;
+	keys[k].len = FontFileGetField (table->entries[i].name.name, n,
+					&keys[k].field);
+	keys[k].entry = i;
+	k++;
+    }
+    qsort (keys, index->nkeys, sizeof (FontFieldKeyRec), FontFileKeyCompare);
+    index->fields[n - 1] = keys;
+    return keys;
+}
+
+/* Find the run of keys whose field equals the given one */
+static void
+FontFileFindKeys (FontFieldKeyPtr keys, int nkeys, const char *field,
+		  int len, int *firstp, int *lastp)
+{
+    int	    left, right, center;
+
+    left = 0;
+    right = nkeys;
+    while (left < right) {
+	center = (left + right) / 2;
+	if (FontFileFieldCompare (keys[center].field, keys[center].len,
+				  field, len) < 0)
+	    left = center + 1;
+	else
+	    right = center;
+    }
+    *firstp = left;
+    right = nkeys;
+    while (left < right) {
+	center = (left + right) / 2;
+	if (FontFileFieldCompare (keys[center].field, keys[center].len,
+				  field, len) <= 0)
+	    left = center + 1;
+	else
+	    right = center;
+    }
+    *lastp = left;
+}
+
+/*
+  Return, in table order, the entries between start and stop that could
+  possibly match the pattern, or -1 when the index can't help and the
+  whole range has to be searched.
+*/
+static int
+FontFileIndexCandidates (FontTablePtr table, FontNamePtr pat,
+			 int start, int stop, int **candidatesp)
+{
+    FontTableIndexPtr	index;
+    FontFieldKeyPtr	keys, best = NULL;
+    const char		*field, *c;
+    int			n, len, first, last;
+    int			bestFirst = 0, bestLast = 0;
+    int			*candidates;
+    int			i, count;
+
+    if (!table->sorted || pat->ndashes != XLFD_NDASHES ||
+	stop - start < FONT_INDEX_MIN)
+	return -1;
+    if (!(index = FontFileGetIndex (table)))
+	return -1;
+
+    for (n = 1; n <= XLFD_NDASHES; n++) {
+	len = FontFileGetField (pat->name, n, &field);
+	for (c = field; c < field + len; c++)
+	    if (isWild (*c))
+		break;
+	if (c < field + len)
+	    continue;
+	if (!(keys = FontFileGetFieldKeys (table, index, n)))
+	    continue;
+	FontFileFindKeys (keys, index->nkeys, field, len, &first, &last);
+	if (!best || last - first < bestLast - bestFirst) {
+	    best = keys;
+	    bestFirst = first;
+	    bestLast = last;
+	}
+    }
+    if (!best && index->nkeys)
+	return -1;
+
+    candidates = mallocarray (bestLast - bestFirst + index->nothers + 1,
+			      sizeof (int));
+    if (!candidates)
+	return -1;
+    count = 0;
+    for (i = bestFirst; i < bestLast; i++)
+	if (best[i].entry >= start && best[i].entry < stop)
+	    candidates[count++] = best[i].entry;
+    for (i = 0; i < index->nothers; i++)
+	if (index->others[i] >= start && index->others[i] < stop)
+	    candidates[count++] = index->others[i];
+    qsort (candidates, count, sizeof (int), FontFileIntCompare);
+    *candidatesp = candidates;
+    return count;
+}
+
 int
 FontFileCountDashes (char *name, int namelen)
 {
@@ -445,17 +683,25 @@ FontFileFindNameInScalableDir(FontTablePtr table, FontNamePtr pat,
 			      FontScalablePtr vals)
 {
     int         i,
+                k,
+                n,
                 start,
                 stop,
                 res,
                 private;
+    int		*candidates = NULL;
     FontNamePtr	name;
+    FontEntryPtr found = NULL;
 
     if (!table->entries)
 	return NULL;
     if ((i = SetupWildMatch(table, pat, &start, &stop, &private)) >= 0)
 	return &table->entries[i];
-    for (i = start; i < stop; i++) {
+    n = FontFileIndexCandidates(table, pat, start, stop, &candidates);
+    if (n < 0)
+	n = stop - start;
+    for (k = 0; k < n; k++) {
+	i = candidates ? candidates[k] : start + k;
 	name = &table->entries[i].name;
 	res = PatternMatch(pat->name, private, name->name, name->ndashes);
 	if (res > 0)
@@ -479,12 +725,14 @@ FontFileFindNameInScalableDir(FontTablePtr table, FontNamePtr pat,
 		     !(cap & CAP_CHARSUBSETTING)))
 		    continue;
 	    }
-	    return &table->entries[i];
+	    found = &table->entries[i];
+	    break;
 	}
 	if (res < 0)
 	    break;
     }
-    return (FontEntryPtr)0;
+    free(candidates);
+    return found;
 }
 
 FontEntryPtr
@@ -499,10 +747,13 @@ FontFileFindNamesInScalableDir(FontTablePtr table, FontNamePtr pat, int max,
 			       int alias_behavior, int *newmax)
 {
     int		    i,
+		    k,
+		    n = -1,
 		    start,
 		    stop,
 		    res,
 		    private;
+    int		    *candidates = NULL;
     int		    ret = Successful;
     FontEntryPtr    fname;
     FontNamePtr	    name;
@@ -520,7 +771,13 @@ FontFileFindNamesInScalableDir(FontTablePtr table, FontNamePtr pat, int max,
 	start = i;
 	stop = i + 1;
     }
-    for (i = start, fname = &table->entries[start]; i < stop; i++, fname++) {
+    else
+	n = FontFileIndexCandidates(table, pat, start, stop, &candidates);
+    if (n < 0)
+	n = stop - start;
+    for (k = 0; k < n; k++) {
+	i = candidates ? candidates[k] : start + k;
+	fname = &table->entries[i];
 	res = PatternMatch(pat->name, private, fname->name.name, fname->name.ndashes);
 	if (res > 0) {
 	    if (vals)
@@ -576,6 +833,7 @@ FontFileFindNamesInScalableDir(FontTablePtr table, FontNamePtr pat, int max,
 	    break;
     }
   bail: ;
+    free(candidates);
     if (newmax) *newmax = max;
     return ret;
 }
@@ -600,6 +858,7 @@ FontFileMatchName(char *name, int length, FontNamePtr pat)
     table.used = 1;
     table.size = 1;
     table.sorted = TRUE;
+    table.index = NULL;
     table.entries = entries;
     entries[0].name.name = name;
     entries[0].name.length = length;
@@ -119,12 +119,7 @@ BufZipFileFill (BufFilePtr f)
     /* if we don't have anything to work from... */
     if (x->z.avail_in == 0) {
       /* ... fill the z buf from underlying file */
-      int i, c;
-      for (i = 0; i < sizeof(x->b_in); i++) {
-	c = BufFileGet(x->f);
-	if (c == BUFFILEEOF) break;
-	x->b_in[i] = c;
-      }
+      int i = BufFileRead(x->f, (char *) x->b_in, sizeof(x->b_in));
       x->z.avail_in += i;
       x->z.next_in = x->b_in;
     }
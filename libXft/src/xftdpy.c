@@ -168,6 +168,7 @@ _XftDisplayInfoGet (Display *dpy, FcBool createIfNecessary)
     _XftDisplayInfo = info;
 
     info->glyph_memory = 0;
+    info->use_count = 0;
     info->max_glyph_memory = (unsigned long)XftDefaultGetInteger (dpy,
 						   XFT_MAX_GLYPH_MEMORY, 0,
 						   XFT_DPY_MAX_GLYPH_MEMORY);
@@ -182,10 +183,13 @@ _XftDisplayInfoGet (Display *dpy, FcBool createIfNecessary)
     if (XftDebug() & XFT_DBG_CACHE)
 	printf ("global max unref fonts  %d\n", info->max_unref_fonts);
 
-    info->track_mem_usage = FcFalse;
+    /*
+     * Evicting the least recently used glyph needs glyphs to be freed
+     * one at a time, so it's the default wherever that's possible.
+     */
     info->track_mem_usage = XftDefaultGetBool (dpy,
 					       XFT_TRACK_MEM_USAGE, 0,
-					       FcFalse);
+					       info->use_free_glyphs);
     if (XftDebug() & XFT_DBG_CACHE)
 	printf ("global track mem usage  %s\n", BtoS(info->track_mem_usage));
 
@@ -241,22 +245,32 @@ _XftDisplayManageMemory (Display *dpy)
 		    info->glyph_memory, info->max_glyph_memory);
 	_XftDisplayValidateMemory (info);
     }
+    /*
+     * Take glyphs from the font that was drawn with longest ago, so the
+     * budget follows whichever fonts are actually in use.
+     */
     while (info->glyph_memory > info->max_glyph_memory)
     {
-	glyph_memory = (unsigned long)rand () % info->glyph_memory;
-	public = info->fonts;
-	while (public)
+	XftFont	    *oldest = NULL;
+	unsigned long	oldest_use = 0;
+
+	for (public = info->fonts; public; public = font->next)
 	{
 	    font = (XftFontInt *) public;
 
-	    if (font->glyph_memory > glyph_memory)
+	    if (font->glyph_memory &&
+		(!oldest || font->last_use < oldest_use))
 	    {
-		_XftFontUncacheGlyph (dpy, public);
-		break;
+		oldest = public;
+		oldest_use = font->last_use;
 	    }
-	    public = font->next;
-	    glyph_memory -= font->glyph_memory;
 	}
+	if (!oldest)
+	    break;
+	glyph_memory = info->glyph_memory;
+	_XftFontUncacheGlyph (dpy, oldest);
+	if (info->glyph_memory == glyph_memory)
+	    break;
     }
     if (XftDebug () & XFT_DBG_CACHE)
 	_XftDisplayValidateMemory (info);
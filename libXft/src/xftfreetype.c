@@ -1042,6 +1042,7 @@ XftFontOpenInfo (Display	*dpy,
     font->max_glyph_memory = (unsigned long)max_glyph_memory;
     font->track_mem_usage  = info->track_mem_usage;
     font->use_free_glyphs  = info->use_free_glyphs;
+    font->last_use         = 0;
     font->sizeof_glyph     = (font->track_mem_usage
     			      ? sizeof(XftGlyphUsage)
 			      : sizeof(XftGlyph));
@@ -29,6 +29,14 @@
 
 #include FT_GLYPH_H
 
+#if (defined(__SSE2__) || defined(__x86_64__) || defined(_M_AMD64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define XFT_SSE2 1
+#include <emmintrin.h>
+#else
+#define XFT_SSE2 0
+#endif
+
 typedef double m3x3[3][3];
 
 static void
@@ -443,6 +451,78 @@ _scaled_fill_xrender_bitmap( FT_Bitmap*	target,
  *
  * bgr    :: boolean, set if BGR or VBGR pixel ordering is needed
  */
+/*
+ * Expand a row of mono pixels, setting those that are on to "on";
+ * glyphs are mostly background, so empty bytes are skipped whole.
+ */
+static void
+_expand_mono_row8( unsigned char* dst, const unsigned char* src, int width )
+{
+    int x;
+
+    for ( x = 0; x < width; x += 8 )
+    {
+	unsigned char bits = src[x >> 3];
+	int	      i;
+
+	if ( !bits )
+	    continue;
+	for ( i = 0; i < 8 && x + i < width; i++ )
+	    if ( bits & (0x80 >> i) )
+		dst[x + i] = 0xff;
+    }
+}
+
+static void
+_expand_mono_row32( unsigned int* dst, const unsigned char* src, int width )
+{
+    int x;
+
+    for ( x = 0; x < width; x += 8 )
+    {
+	unsigned char bits = src[x >> 3];
+	int	      i;
+
+	if ( !bits )
+	    continue;
+	for ( i = 0; i < 8 && x + i < width; i++ )
+	    if ( bits & (0x80 >> i) )
+		dst[x + i] = 0xffffffffU;
+    }
+}
+
+/*
+ * Replicate each gray value into all four channels of an ARGB32 pixel
+ */
+static void
+_expand_gray_row32( unsigned int* dst, const unsigned char* src, int width )
+{
+    int x = 0;
+
+#if XFT_SSE2
+    for ( ; x + 16 <= width; x += 16 )
+    {
+	__m128i gray = _mm_loadu_si128( (const __m128i*) (src + x) );
+	__m128i lo = _mm_unpacklo_epi8( gray, gray );
+	__m128i hi = _mm_unpackhi_epi8( gray, gray );
+
+	_mm_storeu_si128( (__m128i*) (dst + x), _mm_unpacklo_epi16( lo, lo ) );
+	_mm_storeu_si128( (__m128i*) (dst + x + 4), _mm_unpackhi_epi16( lo, lo ) );
+	_mm_storeu_si128( (__m128i*) (dst + x + 8), _mm_unpacklo_epi16( hi, hi ) );
+	_mm_storeu_si128( (__m128i*) (dst + x + 12), _mm_unpackhi_epi16( hi, hi ) );
+    }
+#endif
+    for ( ; x < width; x++ )
+    {
+	unsigned int pix = src[x];
+
+	pix |= (pix << 8);
+	pix |= (pix << 16);
+
+	dst[x] = pix;
+    }
+}
+
 static void
 _fill_xrender_bitmap( FT_Bitmap*	target,
 		      FT_GlyphSlot	slot,
@@ -473,28 +553,12 @@ _fill_xrender_bitmap( FT_Bitmap*	target,
 	    if ( subpixel )  /* convert mono to ARGB32 values */
 	    {
 		for ( h = height; h > 0; h--, srcLine += src_pitch, dstLine += pitch )
-		{
-		    int x;
-
-		    for ( x = 0; x < width; x++ )
-		    {
-			if ( srcLine[(x >> 3)] & (0x80 >> (x & 7)) )
-			    ((unsigned int*)dstLine)[x] = 0xffffffffU;
-		    }
-		}
+		    _expand_mono_row32( (unsigned int*)dstLine, srcLine, width );
 	    }
 	    else if ( mode == FT_RENDER_MODE_NORMAL )  /* convert mono to 8-bit gray */
 	    {
 		for ( h = height; h > 0; h--, srcLine += src_pitch, dstLine += pitch )
-		{
-		    int x;
-
-		    for ( x = 0; x < width; x++ )
-		    {
-			if ( srcLine[(x >> 3)] & (0x80 >> (x & 7)) )
-			    dstLine[x] = 0xff;
-		    }
-		}
+		    _expand_mono_row8( dstLine, srcLine, width );
 	    }
 	    else  /* copy mono to mono */
 	    {
@@ -509,20 +573,7 @@ _fill_xrender_bitmap( FT_Bitmap*	target,
 	    if ( subpixel )  /* convert gray to ARGB32 values */
 	    {
 		for ( h = height; h > 0; h--, srcLine += src_pitch, dstLine += pitch )
-		{
-		    int		   x;
-		    unsigned int*  dst = (unsigned int*)dstLine;
-
-		    for ( x = 0; x < width; x++ )
-		    {
-			unsigned int pix = srcLine[x];
-
-			pix |= (pix << 8);
-			pix |= (pix << 16);
-
-			dst[x] = pix;
-		    }
-		}
+		    _expand_gray_row32( (unsigned int*)dstLine, srcLine, width );
 	    }
 	    else  /* copy gray into gray */
 	    {
@@ -631,6 +682,74 @@ _fill_xrender_bitmap( FT_Bitmap*	target,
     }
 }
 
+/*
+ * Glyphs loaded together, typically all the ones a string is missing,
+ * are sent in as few AddGlyphs requests as possible rather than one
+ * each.  Images are already padded to four bytes, as the request wants.
+ */
+#define XFT_GLYPH_BATCH		64
+#define XFT_GLYPH_BATCH_BYTES	(64 * 1024)
+
+typedef struct _XftGlyphBatch {
+    GlyphSet	    glyphset;
+    int		    nglyph;
+    Glyph	    glyphs[XFT_GLYPH_BATCH];
+    XGlyphInfo	    info[XFT_GLYPH_BATCH];
+    char	    *data;
+    int		    size;
+    int		    alloc;
+} XftGlyphBatch;
+
+static void
+_XftGlyphBatchFlush (Display *dpy, XftGlyphBatch *batch)
+{
+    if (batch->nglyph)
+	XRenderAddGlyphs (dpy, batch->glyphset, batch->glyphs, batch->info,
+			  batch->nglyph, batch->data, batch->size);
+    batch->nglyph = 0;
+    batch->size = 0;
+}
+
+static void
+_XftGlyphBatchAdd (Display	    *dpy,
+		   XftGlyphBatch    *batch,
+		   GlyphSet	    glyphset,
+		   Glyph	    glyph,
+		   _Xconst XGlyphInfo *info,
+		   _Xconst char	    *data,
+		   int		    size)
+{
+    if (batch->nglyph == XFT_GLYPH_BATCH ||
+	batch->size + size > XFT_GLYPH_BATCH_BYTES ||
+	batch->glyphset != glyphset)
+	_XftGlyphBatchFlush (dpy, batch);
+    batch->glyphset = glyphset;
+    if (batch->size + size > batch->alloc)
+    {
+	int	alloc = batch->size + size;
+	char	*data_new;
+
+	if (alloc < XFT_GLYPH_BATCH_BYTES)
+	    alloc = XFT_GLYPH_BATCH_BYTES;
+	data_new = realloc (batch->data, (size_t) alloc);
+	if (!data_new)
+	{
+	    /* send this one by itself */
+	    _XftGlyphBatchFlush (dpy, batch);
+	    XRenderAddGlyphs (dpy, glyphset, &glyph, info, 1, data, size);
+	    return;
+	}
+	batch->data = data_new;
+	batch->alloc = alloc;
+    }
+    batch->glyphs[batch->nglyph] = glyph;
+    batch->info[batch->nglyph] = *info;
+    batch->nglyph++;
+    if (size)
+	memcpy (batch->data + batch->size, data, (size_t) size);
+    batch->size += size;
+}
+
 _X_EXPORT void
 XftFontLoadGlyphs (Display	    *dpy,
 		   XftFont	    *pub,
@@ -660,6 +779,7 @@ XftFontLoadGlyphs (Display	    *dpy,
     FT_Render_Mode  mode = FT_RENDER_MODE_MONO;
     FcBool	    transform;
     FcBool	    glyph_transform;
+    XftGlyphBatch   batch;
 
     if (!info)
 	return;
@@ -689,6 +809,14 @@ XftFontLoadGlyphs (Display	    *dpy,
 
     transform = font->info.transform && mode != FT_RENDER_MODE_MONO;
 
+    FT_Library_SetLcdFilter( _XftFTlibrary, font->info.lcd_filter);
+
+    batch.glyphset = 0;
+    batch.nglyph = 0;
+    batch.data = NULL;
+    batch.size = 0;
+    batch.alloc = 0;
+
     while (nglyph--)
     {
 	glyphindex = *glyphs++;
@@ -706,8 +834,6 @@ XftFontLoadGlyphs (Display	    *dpy,
 	if (xftg->glyph_memory)
 	    continue;
 
-	FT_Library_SetLcdFilter( _XftFTlibrary, font->info.lcd_filter);
-
 	error = FT_Load_Glyph (face, glyphindex, font->info.load_flags);
 	if (error)
 	{
@@ -1042,9 +1168,8 @@ XftFontLoadGlyphs (Display	    *dpy,
 		    xftg->glyph_memory += (size_t)size * 255;
 	    }
 	    else
-		XRenderAddGlyphs (dpy, font->glyphset, &glyph,
-				  &xftg->metrics, 1,
-				  (char *) bufBitmap, size);
+		_XftGlyphBatchAdd (dpy, &batch, font->glyphset, glyph,
+				   &xftg->metrics, (char *) bufBitmap, size);
 	}
 	else
 	{
@@ -1104,6 +1229,8 @@ XftFontLoadGlyphs (Display	    *dpy,
 		_XftValidateGlyphUsage(font);
 	}
     }
+    _XftGlyphBatchFlush (dpy, &batch);
+    free (batch.data);
     if (bufBitmap != bufLocal)
 	free (bufBitmap);
     XftUnlockFace (&font->public);
@@ -1415,8 +1542,12 @@ _XftFontUncacheGlyph (Display *dpy, XftFont *pub)
 _X_HIDDEN void
 _XftFontManageMemory (Display *dpy, XftFont *pub)
 {
+    XftDisplayInfo  *info = _XftDisplayInfoGet (dpy, False);
     XftFontInt	*font = (XftFontInt *) pub;
 
+    if (info)
+	font->last_use = ++info->use_count;
+
     if (font->max_glyph_memory)
     {
 	if (XftDebug() & XFT_DBG_CACHE)
@@ -200,6 +200,7 @@ typedef struct _XftFontInt {
     FT_UInt		total_inuse;	/* total, for verifying usage */
     FcBool		track_mem_usage;   /* Use XftGlyphUsage */
     FcBool		use_free_glyphs;   /* Use XRenderFreeGlyphs */
+    unsigned long	last_use;	/* display use_count when last drawn */
 } XftFontInt;
 
 typedef enum _XftClipType {
@@ -272,6 +273,7 @@ typedef struct _XftDisplayInfo {
     FcBool		    use_free_glyphs;
     int			    num_unref_fonts;
     int			    max_unref_fonts;
+    unsigned long	    use_count;	/* bumped each time a font is used */
     XftSolidColor	    colors[XFT_NUM_SOLID_COLOR];
     XftFont		    *fontHash[XFT_NUM_FONT_HASH];
 } XftDisplayInfo;
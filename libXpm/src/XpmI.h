@@ -218,7 +218,7 @@ typedef struct {
     xpmHashAtom *atomTable;
 }      xpmHashTable;
 
-HFUNC(xpmHashTableInit, int, (xpmHashTable *table));
+HFUNC(xpmHashTableInit, int, (xpmHashTable *table, unsigned int natoms));
 HFUNC(xpmHashTableFree, void, (xpmHashTable *table));
 HFUNC(xpmHashSlot, xpmHashAtom *, (xpmHashTable *table, char *s));
 HFUNC(xpmHashIntern, int, (xpmHashTable *table, char *tag, void *data));
@@ -95,7 +95,8 @@ LFUNC(ParseAndPutPixels, int, (xpmData *data, unsigned int width,
 			       unsigned int cpp, XpmColor *colorTable,
 			       xpmHashTable *hashtable,
 			       XImage *image, Pixel *image_pixels,
-			       XImage *mask, Pixel *mask_pixels));
+			       XImage *mask, Pixel *mask_pixels,
+			       unsigned int *rowindex));
 #else  /* FOR_MSW */
 LFUNC(ParseAndPutPixels, int, (Display *dc, xpmData *data, unsigned int width,
 			       unsigned int height, unsigned int ncolors,
@@ -141,7 +142,10 @@ LFUNC(PutPixel8, int, (XImage *ximage, int x, int y, unsigned long pixel));
 LFUNC(PutPixel1MSB, int, (XImage *ximage, int x, int y, unsigned long pixel));
 LFUNC(PutPixel1LSB, int, (XImage *ximage, int x, int y, unsigned long pixel));
 
-# else /* AMIGA */
+# endif/* not AMIGA */
+LFUNC(PutImageRow, void, (XImage *image, unsigned int y, unsigned int width,
+			  unsigned int *rowindex, Pixel *pixels));
+# ifdef AMIGA
 LFUNC(APutImagePixels, void, (XImage *ximage, unsigned int width,
 			      unsigned int height, unsigned int *pixelindex,
 			      Pixel *pixels));
@@ -1996,6 +2000,97 @@ PutPixel1LSB(
 
 #endif /* not FOR_MSW && not AMIGA */
 
+#ifndef FOR_MSW
+/*
+ * Put one row of pixels, given as color indexes, in the image.  The
+ * common formats are written straight into the image data, a whole row
+ * at a time; anything else goes through XPutPixel.
+ */
+static void
+PutImageRow(
+    XImage		*image,
+    unsigned int	 y,
+    unsigned int	 width,
+    unsigned int	*rowindex,
+    Pixel		*pixels)
+{
+    unsigned int x;
+# ifndef AMIGA
+    unsigned char *addr =
+	(unsigned char *) image->data + y * image->bytes_per_line;
+    Pixel pixel;
+
+    if (image->bits_per_pixel == 32) {
+#  if !defined(WORD64) && !defined(LONG64)
+	if (*((char *) &byteorderpixel) == image->byte_order) {
+	    for (x = 0; x < width; x++, addr += 4)
+		*((unsigned long *) addr) = pixels[rowindex[x]];
+	} else
+#  endif
+	if (image->byte_order == MSBFirst) {
+	    for (x = 0; x < width; x++, addr += 4) {
+		pixel = pixels[rowindex[x]];
+		addr[0] = pixel >> 24;
+		addr[1] = pixel >> 16;
+		addr[2] = pixel >> 8;
+		addr[3] = pixel;
+	    }
+	} else {
+	    for (x = 0; x < width; x++, addr += 4) {
+		pixel = pixels[rowindex[x]];
+		addr[3] = pixel >> 24;
+		addr[2] = pixel >> 16;
+		addr[1] = pixel >> 8;
+		addr[0] = pixel;
+	    }
+	}
+	return;
+    }
+    if (image->bits_per_pixel == 16) {
+	if (image->byte_order == MSBFirst) {
+	    for (x = 0; x < width; x++, addr += 2) {
+		pixel = pixels[rowindex[x]];
+		addr[0] = pixel >> 8;
+		addr[1] = pixel;
+	    }
+	} else {
+	    for (x = 0; x < width; x++, addr += 2) {
+		pixel = pixels[rowindex[x]];
+		addr[1] = pixel >> 8;
+		addr[0] = pixel;
+	    }
+	}
+	return;
+    }
+    if (image->bits_per_pixel == 8) {
+	for (x = 0; x < width; x++)
+	    addr[x] = pixels[rowindex[x]];
+	return;
+    }
+    if ((image->bits_per_pixel | image->depth) == 1 &&
+	image->byte_order == image->bitmap_bit_order) {
+	/* eight pixels to a byte; the padding bits of the last one are 0 */
+	unsigned char byte = 0;
+
+	for (x = 0; x < width; x++) {
+	    if (pixels[rowindex[x]] & 1)
+		byte |= image->bitmap_bit_order == MSBFirst ?
+		    0x80 >> (x & 7) : 1 << (x & 7);
+	    if ((x & 7) == 7) {
+		*addr++ = byte;
+		byte = 0;
+	    }
+	}
+	if (x & 7)
+	    *addr = byte;
+	return;
+    }
+# endif /* not AMIGA */
+    for (x = 0; x < width; x++)
+	XPutPixel(image, x, y, pixels[rowindex[x]]);
+}
+#endif /* not FOR_MSW */
+
 /*
  * This function parses an Xpm file or data and directly create an XImage
  */
@@ -2026,6 +2121,9 @@ xpmParseDataAndCreate(
     Pixel *mask_pixels = NULL;
     Pixel *alloc_pixels = NULL;
     Pixel *used_pixels = NULL;
+#ifndef FOR_MSW
+    unsigned int *rowindex = NULL;
+#endif
     unsigned int nalloc_pixels = 0;
     unsigned int nused_pixels = 0;
     unsigned int width, height, ncolors, cpp;
@@ -2101,7 +2199,7 @@ xpmParseDataAndCreate(
      * init the hashtable
      */
     if (USE_HASHTABLE) {
-	ErrorStatus = xpmHashTableInit(&hashtable);
+	ErrorStatus = xpmHashTableInit(&hashtable, ncolors);
 	if (ErrorStatus != XpmSuccess)
 	    RETURN(ErrorStatus);
     }
@@ -2214,8 +2312,15 @@ xpmParseDataAndCreate(
     }
 
     /*
-     * read pixels and put them in the XImage
+     * read pixels and put them in the XImage, a row at a time
      */
+#ifndef FOR_MSW
+    if (width >= UINT_MAX / sizeof(unsigned int))
+	RETURN(XpmNoMemory);
+    rowindex = (unsigned int *) XpmMalloc(sizeof(unsigned int) * width);
+    if (!rowindex)
+	RETURN(XpmNoMemory);
+#endif
     ErrorStatus = ParseAndPutPixels(
 #ifdef FOR_MSW
 				    display,
@@ -2223,7 +2328,15 @@ xpmParseDataAndCreate(
 				    data, width, height, ncolors, cpp,
 				    colorTable, &hashtable,
 				    ximage, image_pixels,
-				    shapeimage, mask_pixels);
+				    shapeimage, mask_pixels
+#ifndef FOR_MSW
+				    , rowindex
+#endif
+				    );
+#ifndef FOR_MSW
+    XpmFree(rowindex);
+    rowindex = NULL;
+#endif
     XpmFree(image_pixels);
     image_pixels = NULL;
     XpmFree(mask_pixels);
@@ -2331,10 +2444,23 @@ error:
 	XpmFree(alloc_pixels);
     if (used_pixels)
 	XpmFree(used_pixels);
+#ifndef FOR_MSW
+    if (rowindex)
+	XpmFree(rowindex);
+#endif
 
     return (ErrorStatus);
 }
 
+#ifndef FOR_MSW
+/* put the row just parsed in the image and the mask */
+#define PUT_ROW() do { \
+    PutImageRow(image, y, width, rowindex, image_pixels); \
+    if (shapeimage) \
+	PutImageRow(shapeimage, y, width, rowindex, shape_pixels); \
+} while (0)
+#endif
+
 static int
 ParseAndPutPixels(
 #ifdef FOR_MSW
@@ -2350,7 +2476,12 @@ ParseAndPutPixels(
     XImage		*image,
     Pixel		*image_pixels,
     XImage		*shapeimage,
-    Pixel		*shape_pixels)
+    Pixel		*shape_pixels
+#ifndef FOR_MSW
+    ,
+    unsigned int	*rowindex
+#endif
+    )
 {
     unsigned int a, x, y;
 
@@ -2386,10 +2517,7 @@ ParseAndPutPixels(
 
 		    if (c > 0 && c < 256 && colidx[c] != 0) {
 #ifndef FOR_MSW
-			XPutPixel(image, x, y, image_pixels[colidx[c] - 1]);
-			if (shapeimage)
-			    XPutPixel(shapeimage, x, y,
-				      shape_pixels[colidx[c] - 1]);
+			rowindex[x] = colidx[c] - 1;
 #else
 			SetPixel(*dc, x, y, image_pixels[colidx[c] - 1]);
 			if (shapedc) {
@@ -2399,6 +2527,9 @@ ParseAndPutPixels(
 		    } else
 			return (XpmFileInvalid);
 		}
+#ifndef FOR_MSW
+		PUT_ROW();
+#endif
 	    }
 #ifdef FOR_MSW
 	    if ( shapedc ) {
@@ -2445,11 +2576,7 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
 			if (cc2 > 0 && cc2 < 256 &&
 			    cidx[cc1] && cidx[cc1][cc2] != 0) {
 #ifndef FOR_MSW
-			    XPutPixel(image, x, y,
-				      image_pixels[cidx[cc1][cc2] - 1]);
-			    if (shapeimage)
-				XPutPixel(shapeimage, x, y,
-					  shape_pixels[cidx[cc1][cc2] - 1]);
+			    rowindex[x] = cidx[cc1][cc2] - 1;
 #else
 			SelectObject(*dc, image->bitmap);
 			SetPixel(*dc, x, y, image_pixels[cidx[cc1][cc2] - 1]);
@@ -2468,6 +2595,9 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
 			return (XpmFileInvalid);
 		    }
 		}
+#ifndef FOR_MSW
+		PUT_ROW();
+#endif
 	    }
 	    FREE_CIDX;
 	}
@@ -2495,11 +2625,7 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
 			if (!*slot)	/* no color matches */
 			    return (XpmFileInvalid);
 #ifndef FOR_MSW
-			XPutPixel(image, x, y,
-				  image_pixels[HashColorIndex(slot)]);
-			if (shapeimage)
-			    XPutPixel(shapeimage, x, y,
-				      shape_pixels[HashColorIndex(slot)]);
+			rowindex[x] = HashColorIndex(slot);
 #else
 			SelectObject(*dc, image->bitmap);
 			SetPixel(*dc, x, y,
@@ -2511,6 +2637,9 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
 			}
 #endif
 		    }
+#ifndef FOR_MSW
+		    PUT_ROW();
+#endif
 		}
 	    } else {
 		for (y = 0; y < height; y++) {
@@ -2524,9 +2653,7 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
 			if (a == ncolors)	/* no color matches */
 			    return (XpmFileInvalid);
 #ifndef FOR_MSW
-			XPutPixel(image, x, y, image_pixels[a]);
-			if (shapeimage)
-			    XPutPixel(shapeimage, x, y, shape_pixels[a]);
+			rowindex[x] = a;
 #else
 			SelectObject(*dc, image->bitmap);
 			SetPixel(*dc, x, y, image_pixels[a]);
@@ -2536,6 +2663,9 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
 			}
 #endif
 		    }
+#ifndef FOR_MSW
+		    PUT_ROW();
+#endif
 		}
 	    }
 	}
@@ -2543,3 +2673,4 @@ if (cidx[f]) XpmFree(cidx[f]);} while(0)
     }
     return (XpmSuccess);
 }
+#undef PUT_ROW
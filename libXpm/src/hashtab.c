@@ -74,6 +74,7 @@ AtomMake(				/* makes an atom */
 /* #define INITIAL_HASH_SIZE 2017 */
 #define INITIAL_HASH_SIZE 256		/* should be enough for colors */
 #define HASH_TABLE_GROWS  size = size * 2;
+#define MAX_PRESIZE	  65536		/* the header may lie about ncolors */
 
 /* aho-sethi-ullman's HPJ (sizes should be primes)*/
 #ifdef notdef
@@ -195,16 +196,19 @@ xpmHashIntern(
 }
 
 /*
- *  must be called before allocating any atom
+ *  must be called before allocating any atom; the table starts large
+ *  enough for natoms, so wide palettes are not rehashed as they are read
  */
 
 int
-xpmHashTableInit(xpmHashTable *table)
+xpmHashTableInit(xpmHashTable *table, unsigned int natoms)
 {
     xpmHashAtom *p;
     xpmHashAtom *atomTable;
 
     table->size = INITIAL_HASH_SIZE;
+    while (table->size / 3 <= natoms && table->size < MAX_PRESIZE)
+	table->size *= 2;
     table->limit = table->size / 3;
     table->used = 0;
     table->atomTable = NULL;
@@ -772,7 +772,7 @@ xpmParseData(
      * init the hashtable
      */
     if (USE_HASHTABLE) {
-	ErrorStatus = xpmHashTableInit(&hashtable);
+	ErrorStatus = xpmHashTableInit(&hashtable, ncolors);
 	if (ErrorStatus != XpmSuccess)
 	    RETURN(ErrorStatus);
     }
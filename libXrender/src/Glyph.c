@@ -136,6 +136,39 @@ XRenderFreeGlyphs (Display   *dpy,
     SyncHandle();
 }
 
+/*
+ * Glyphs are sent in elements of at most 254 glyphs, as a length of 255
+ * marks a glyphset change.  The glyphs of each element are padded to a
+ * 32-bit boundary.
+ */
+#define MAX_GLYPHS	254
+
+static unsigned long
+_XRenderGlyphWords (unsigned long nchar, int size)
+{
+    unsigned long   len;
+
+    len = (nchar / MAX_GLYPHS) * ((SIZEOF (xGlyphElt) + MAX_GLYPHS * size + 3) >> 2);
+    if (nchar % MAX_GLYPHS)
+	len += (SIZEOF (xGlyphElt) + (nchar % MAX_GLYPHS) * size + 3) >> 2;
+    return len;
+}
+
+/*
+ * The number of glyphs that fit in "words" 32-bit words of elements
+ */
+static int
+_XRenderGlyphsThatFit (unsigned long words, int size)
+{
+    unsigned long   elt_words = (SIZEOF (xGlyphElt) + MAX_GLYPHS * size + 3) >> 2;
+    unsigned long   nchar = (words / elt_words) * MAX_GLYPHS;
+
+    words %= elt_words;
+    if (words > (SIZEOF (xGlyphElt) >> 2))
+	nchar += ((words << 2) - SIZEOF (xGlyphElt)) / (unsigned long) size;
+    return (int) nchar;
+}
+
 void
 XRenderCompositeString8 (Display	    *dpy,
 			 int		    op,
@@ -152,7 +185,8 @@ XRenderCompositeString8 (Display	    *dpy,
 {
     XRenderExtDisplayInfo	*info = XRenderFindDisplay (dpy);
     xRenderCompositeGlyphs8Req	*req;
-    long			len;
+    unsigned long		max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
+    unsigned long		len;
     xGlyphElt			*elt;
     int				nbytes;
 
@@ -173,38 +207,33 @@ XRenderCompositeString8 (Display	    *dpy,
     req->xSrc = (INT16) xSrc;
     req->ySrc = (INT16) ySrc;
 
-    /*
-     * xGlyphElt must be aligned on a 32-bit boundary; this is
-     * easily done by filling no more than 252 glyphs in each
-     * bucket
-     */
-
-#define MAX_8 252
-
-    len = SIZEOF(xGlyphElt) * ((nchar + MAX_8-1) / MAX_8) + nchar;
-
-    req->length = (CARD16) (req->length + ((len + 3)>>2));  /* convert to number of 32-bit words */
+    len = _XRenderGlyphWords ((unsigned long) nchar, 1);
+    if (len > (max_req - req->length)) {
+	nchar = _XRenderGlyphsThatFit (max_req - req->length, 1);
+	len = _XRenderGlyphWords ((unsigned long) nchar, 1);
+    }
+    SetReqLen (req, len, len);
 
     /*
      * If the entire request does not fit into the remaining space in the
      * buffer, flush the buffer first.
      */
 
-    if (dpy->bufptr + len > dpy->bufmax)
+    if (dpy->bufptr + (len << 2) > dpy->bufmax)
     	_XFlush (dpy);
 
-    while(nchar > MAX_8)
+    while(nchar > MAX_GLYPHS)
     {
-	nbytes = MAX_8 + SIZEOF(xGlyphElt);
+	nbytes = (MAX_GLYPHS + SIZEOF(xGlyphElt) + 3) & ~3;
 	BufAlloc (xGlyphElt *, elt, nbytes);
-	elt->len = MAX_8;
+	elt->len = MAX_GLYPHS;
 	elt->deltax = (INT16) xDst;
 	elt->deltay = (INT16) yDst;
 	xDst = 0;
 	yDst = 0;
-	memcpy ((char *) (elt + 1), string, MAX_8);
-	nchar = nchar - MAX_8;
-	string += MAX_8;
+	memcpy ((char *) (elt + 1), string, MAX_GLYPHS);
+	nchar = nchar - MAX_GLYPHS;
+	string += MAX_GLYPHS;
     }
 
     if (nchar)
@@ -216,7 +245,6 @@ XRenderCompositeString8 (Display	    *dpy,
 	elt->deltay = (INT16) yDst;
 	memcpy ((char *) (elt + 1), string, (size_t) nchar);
     }
-#undef MAX_8
 
     UnlockDisplay(dpy);
     SyncHandle();
@@ -237,7 +265,8 @@ XRenderCompositeString16 (Display	    *dpy,
 {
     XRenderExtDisplayInfo	*info = XRenderFindDisplay (dpy);
     xRenderCompositeGlyphs8Req	*req;
-    long			len;
+    unsigned long		max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
+    unsigned long		len;
     xGlyphElt			*elt;
     int				nbytes;
 
@@ -258,32 +287,33 @@ XRenderCompositeString16 (Display	    *dpy,
     req->xSrc = (INT16) xSrc;
     req->ySrc = (INT16) ySrc;
 
-#define MAX_16	254
-
-    len = SIZEOF(xGlyphElt) * ((nchar + MAX_16-1) / MAX_16) + nchar * 2;
-
-    req->length = (CARD16) (req->length + ((len + 3)>>2));  /* convert to number of 32-bit words */
+    len = _XRenderGlyphWords ((unsigned long) nchar, 2);
+    if (len > (max_req - req->length)) {
+	nchar = _XRenderGlyphsThatFit (max_req - req->length, 2);
+	len = _XRenderGlyphWords ((unsigned long) nchar, 2);
+    }
+    SetReqLen (req, len, len);
 
     /*
      * If the entire request does not fit into the remaining space in the
      * buffer, flush the buffer first.
      */
 
-    if (dpy->bufptr + len > dpy->bufmax)
+    if (dpy->bufptr + (len << 2) > dpy->bufmax)
     	_XFlush (dpy);
 
-    while(nchar > MAX_16)
+    while(nchar > MAX_GLYPHS)
     {
-	nbytes = MAX_16 * 2 + SIZEOF(xGlyphElt);
+	nbytes = MAX_GLYPHS * 2 + SIZEOF(xGlyphElt);
 	BufAlloc (xGlyphElt *, elt, nbytes);
-	elt->len = MAX_16;
+	elt->len = MAX_GLYPHS;
 	elt->deltax = (INT16) xDst;
 	elt->deltay = (INT16) yDst;
 	xDst = 0;
 	yDst = 0;
-	memcpy ((char *) (elt + 1), (_Xconst char *) string, MAX_16 * 2);
-	nchar = nchar - MAX_16;
-	string += MAX_16;
+	memcpy ((char *) (elt + 1), (_Xconst char *) string, MAX_GLYPHS * 2);
+	nchar = nchar - MAX_GLYPHS;
+	string += MAX_GLYPHS;
     }
 
     if (nchar)
@@ -295,7 +325,6 @@ XRenderCompositeString16 (Display	    *dpy,
 	elt->deltay = (INT16) yDst;
 	memcpy ((char *) (elt + 1), (_Xconst char *) string, (size_t) (nchar * 2));
     }
-#undef MAX_16
 
     UnlockDisplay(dpy);
     SyncHandle();
@@ -317,7 +346,8 @@ XRenderCompositeString32 (Display	    *dpy,
 {
     XRenderExtDisplayInfo	*info = XRenderFindDisplay (dpy);
     xRenderCompositeGlyphs8Req	*req;
-    long			len;
+    unsigned long		max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
+    unsigned long		len;
     xGlyphElt			*elt;
     int				nbytes;
 
@@ -338,32 +368,33 @@ XRenderCompositeString32 (Display	    *dpy,
     req->xSrc = (INT16) xSrc;
     req->ySrc = (INT16) ySrc;
 
-#define MAX_32	254
-
-    len = SIZEOF(xGlyphElt) * ((nchar + MAX_32-1) / MAX_32) + nchar * 4;
-
-    req->length = (CARD16) (req->length + ((len + 3)>>2));  /* convert to number of 32-bit words */
+    len = _XRenderGlyphWords ((unsigned long) nchar, 4);
+    if (len > (max_req - req->length)) {
+	nchar = _XRenderGlyphsThatFit (max_req - req->length, 4);
+	len = _XRenderGlyphWords ((unsigned long) nchar, 4);
+    }
+    SetReqLen (req, len, len);
 
     /*
      * If the entire request does not fit into the remaining space in the
      * buffer, flush the buffer first.
      */
 
-    if (dpy->bufptr + len > dpy->bufmax)
+    if (dpy->bufptr + (len << 2) > dpy->bufmax)
     	_XFlush (dpy);
 
-    while(nchar > MAX_32)
+    while(nchar > MAX_GLYPHS)
     {
-	nbytes = MAX_32 * 4 + SIZEOF(xGlyphElt);
+	nbytes = MAX_GLYPHS * 4 + SIZEOF(xGlyphElt);
 	BufAlloc (xGlyphElt *, elt, nbytes);
-	elt->len = MAX_32;
+	elt->len = MAX_GLYPHS;
 	elt->deltax = (INT16) xDst;
 	elt->deltay = (INT16) yDst;
 	xDst = 0;
 	yDst = 0;
-	memcpy ((char *) (elt + 1), (_Xconst char *) string, MAX_32 * 4);
-	nchar = nchar - MAX_32;
-	string += MAX_32;
+	memcpy ((char *) (elt + 1), (_Xconst char *) string, MAX_GLYPHS * 4);
+	nchar = nchar - MAX_GLYPHS;
+	string += MAX_GLYPHS;
     }
 
     if (nchar)
@@ -375,7 +406,6 @@ XRenderCompositeString32 (Display	    *dpy,
 	elt->deltay = (INT16) yDst;
 	memcpy ((char *) (elt + 1), (_Xconst char *) string, (size_t) (nchar * 4));
     }
-#undef MAX_32
 
     UnlockDisplay(dpy);
     SyncHandle();
@@ -396,8 +426,9 @@ XRenderCompositeText8 (Display			    *dpy,
 {
     XRenderExtDisplayInfo	*info = XRenderFindDisplay (dpy);
     xRenderCompositeGlyphs8Req	*req;
+    unsigned long		max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
     GlyphSet			glyphset;
-    long			len;
+    unsigned long		len;
     int				i;
 
     if (!nelt)
@@ -422,33 +453,30 @@ XRenderCompositeText8 (Display			    *dpy,
      */
     len = 0;
 
-#define MAX_8 252
-
     glyphset = elts[0].glyphset;
     for (i = 0; i < nelt; i++)
     {
-	long	elen;
-	int	nchars;
+	unsigned long	elen;
 
+	elen = _XRenderGlyphWords ((unsigned long) elts[i].nchars, 1);
 	/*
 	 * Check for glyphset change
 	 */
 	if (elts[i].glyphset != glyphset)
-	{
-	    glyphset = elts[i].glyphset;
-	    len += (SIZEOF (xGlyphElt) + 4) >> 2;
-	}
-	nchars = elts[i].nchars;
+	    elen += (SIZEOF (xGlyphElt) + 4) >> 2;
 	/*
-	 * xGlyphElt must be aligned on a 32-bit boundary; this is
-	 * easily done by filling no more than 252 glyphs in each
-	 * bucket
+	 * Drop the elements that do not fit in the request
 	 */
-	elen = SIZEOF(xGlyphElt) * ((nchars + MAX_8-1) / MAX_8) + nchars;
-	len += (elen + 3) >> 2;
+	if (elen > max_req - req->length - len)
+	{
+	    nelt = i;
+	    break;
+	}
+	glyphset = elts[i].glyphset;
+	len += elen;
     }
 
-    req->length = (CARD16) (req->length + len);
+    SetReqLen (req, len, len);
 
     /*
      * Send the glyphs
@@ -478,7 +506,7 @@ XRenderCompositeText8 (Display			    *dpy,
 	chars = elts[i].chars;
 	while (nchars)
 	{
-	    int this_chars = nchars > MAX_8 ? MAX_8 : nchars;
+	    int this_chars = nchars > MAX_GLYPHS ? MAX_GLYPHS : nchars;
 
 	    BufAlloc (xGlyphElt *, elt, SIZEOF(xGlyphElt))
 	    elt->len = (CARD8) this_chars;
@@ -491,7 +519,6 @@ XRenderCompositeText8 (Display			    *dpy,
 	    chars += this_chars;
 	}
     }
-#undef MAX_8
 
     UnlockDisplay(dpy);
     SyncHandle();
@@ -512,8 +539,9 @@ XRenderCompositeText16 (Display			    *dpy,
 {
     XRenderExtDisplayInfo	*info = XRenderFindDisplay (dpy);
     xRenderCompositeGlyphs16Req	*req;
+    unsigned long		max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
     GlyphSet			glyphset;
-    long			len;
+    unsigned long		len;
     int				i;
 
     if (!nelt)
@@ -538,33 +566,30 @@ XRenderCompositeText16 (Display			    *dpy,
      */
     len = 0;
 
-#define MAX_16	254
-
     glyphset = elts[0].glyphset;
     for (i = 0; i < nelt; i++)
     {
-	int	nchars;
-	long	elen;
+	unsigned long	elen;
 
+	elen = _XRenderGlyphWords ((unsigned long) elts[i].nchars, 2);
 	/*
 	 * Check for glyphset change
 	 */
 	if (elts[i].glyphset != glyphset)
-	{
-	    glyphset = elts[i].glyphset;
-	    len += (SIZEOF (xGlyphElt) + 4) >> 2;
-	}
-	nchars = elts[i].nchars;
+	    elen += (SIZEOF (xGlyphElt) + 4) >> 2;
 	/*
-	 * xGlyphElt must be aligned on a 32-bit boundary; this is
-	 * easily done by filling no more than 254 glyphs in each
-	 * bucket
+	 * Drop the elements that do not fit in the request
 	 */
-	elen = SIZEOF(xGlyphElt) * ((nchars + MAX_16-1) / MAX_16) + nchars * 2;
-	len += (elen + 3) >> 2;
+	if (elen > max_req - req->length - len)
+	{
+	    nelt = i;
+	    break;
+	}
+	glyphset = elts[i].glyphset;
+	len += elen;
     }
 
-    req->length = (CARD16) (req->length + len);
+    SetReqLen (req, len, len);
 
     glyphset = elts[0].glyphset;
     for (i = 0; i < nelt; i++)
@@ -591,7 +616,7 @@ XRenderCompositeText16 (Display			    *dpy,
 	chars = elts[i].chars;
 	while (nchars)
 	{
-	    int this_chars = nchars > MAX_16 ? MAX_16 : nchars;
+	    int this_chars = nchars > MAX_GLYPHS ? MAX_GLYPHS : nchars;
 	    int this_bytes = this_chars * 2;
 
 	    BufAlloc (xGlyphElt *, elt, SIZEOF(xGlyphElt))
@@ -605,7 +630,6 @@ XRenderCompositeText16 (Display			    *dpy,
 	    chars += this_chars;
 	}
     }
-#undef MAX_16
 
     UnlockDisplay(dpy);
     SyncHandle();
@@ -626,8 +650,9 @@ XRenderCompositeText32 (Display			    *dpy,
 {
     XRenderExtDisplayInfo	*info = XRenderFindDisplay (dpy);
     xRenderCompositeGlyphs32Req	*req;
+    unsigned long		max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
     GlyphSet			glyphset;
-    long			len;
+    unsigned long		len;
     int				i;
 
     if (!nelt)
@@ -653,28 +678,30 @@ XRenderCompositeText32 (Display			    *dpy,
      */
     len = 0;
 
-#define MAX_32	254
-
     glyphset = elts[0].glyphset;
     for (i = 0; i < nelt; i++)
     {
-	int	nchars;
-	long	elen;
+	unsigned long	elen;
 
+	elen = _XRenderGlyphWords ((unsigned long) elts[i].nchars, 4);
 	/*
 	 * Check for glyphset change
 	 */
 	if (elts[i].glyphset != glyphset)
+	    elen += (SIZEOF (xGlyphElt) + 4) >> 2;
+	/*
+	 * Drop the elements that do not fit in the request
+	 */
+	if (elen > max_req - req->length - len)
 	{
-	    glyphset = elts[i].glyphset;
-	    len += (SIZEOF (xGlyphElt) + 4) >> 2;
+	    nelt = i;
+	    break;
 	}
-	nchars = elts[i].nchars;
-	elen = SIZEOF(xGlyphElt) * ((nchars + MAX_32-1) / MAX_32) + nchars *4;
-	len += (elen + 3) >> 2;
+	glyphset = elts[i].glyphset;
+	len += elen;
     }
 
-    req->length = (CARD16) (req->length + len);
+    SetReqLen (req, len, len);
 
     glyphset = elts[0].glyphset;
     for (i = 0; i < nelt; i++)
@@ -701,7 +728,7 @@ XRenderCompositeText32 (Display			    *dpy,
 	chars = elts[i].chars;
 	while (nchars)
 	{
-	    int this_chars = nchars > MAX_32 ? MAX_32 : nchars;
+	    int this_chars = nchars > MAX_GLYPHS ? MAX_GLYPHS : nchars;
 	    int this_bytes = this_chars * 4;
 	    BufAlloc (xGlyphElt *, elt, SIZEOF(xGlyphElt))
 	    elt->len = (CARD8) this_chars;
@@ -714,7 +741,6 @@ XRenderCompositeText32 (Display			    *dpy,
 	    chars += this_chars;
 	}
     }
-#undef MAX_32
 
     UnlockDisplay(dpy);
     SyncHandle();
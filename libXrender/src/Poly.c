@@ -86,22 +86,78 @@ XRenderComputeIntersect (XLineFixed *l1, XLineFixed *l2)
     return XDoubleToFixed ((b2 - b1) / (m1 - m2));
 }
 
-static int
+/*
+ * Trapezoids are sent as they are generated, a request's worth at a time,
+ * so the buffer never holds more than one request.
+ */
+typedef struct _TrapBuffer {
+    Display			*dpy;
+    int				op;
+    Picture			src;
+    Picture			dst;
+    _Xconst XRenderPictFormat	*maskFormat;
+    int				xSrc;
+    int				ySrc;
+    XTrapezoid			*traps;
+    int				ntraps;
+    int				size;
+    int				max;
+} TrapBuffer;
+
+static void
+XRenderFlushTrapezoids (TrapBuffer *tb)
+{
+    if (tb->ntraps)
+    {
+	/* XXX adjust xSrc/xDst */
+	XRenderCompositeTrapezoids (tb->dpy, tb->op, tb->src, tb->dst,
+				    tb->maskFormat, tb->xSrc, tb->ySrc,
+				    tb->traps, tb->ntraps);
+	tb->ntraps = 0;
+    }
+}
+
+static void
+XRenderAddTrapezoid (TrapBuffer *tb, XFixed top, XFixed bottom,
+		     XLineFixed *left, XLineFixed *right)
+{
+    XTrapezoid	*trap;
+
+    if (tb->ntraps == tb->size)
+    {
+	int	size = tb->size * 2 < tb->max ? tb->size * 2 : tb->max;
+
+	trap = NULL;
+	if (size > tb->size)
+	    trap = Xrealloc (tb->traps, (size_t) size * sizeof (XTrapezoid));
+	if (trap)
+	{
+	    tb->traps = trap;
+	    tb->size = size;
+	}
+	else
+	    XRenderFlushTrapezoids (tb);
+    }
+    trap = &tb->traps[tb->ntraps++];
+    trap->top = top;
+    trap->bottom = bottom;
+    trap->left = *left;
+    trap->right = *right;
+}
+
+static void
 XRenderComputeTrapezoids (Edge		*edges,
 			  int		nedges,
 			  int		winding _X_UNUSED,
-			  XTrapezoid	*traps,
-			  int           *ntraps,
-			  int           maxtraps)
+			  TrapBuffer	*tb)
 {
-    int		ok = 1, inactive;
+    int		inactive;
     Edge	*active;
     Edge	*e, *en, *next;
     XFixed	y, next_y, intersect;
 
     qsort (edges, (size_t) nedges, sizeof (Edge), CompareEdge);
 
-    *ntraps = 0;
     y = edges[0].edge.p1.y;
     active = NULL;
     inactive = 0;
@@ -125,45 +181,43 @@ XRenderComputeTrapezoids (Edge		*edges,
 	for (e = active; e; e = e->next)
 	    e->current_x = XRenderComputeX (&e->edge, y);
 
-	/* sort active list */
-	for (e = active; e; e = next)
+	/*
+	 * sort active list.  The order changes only where edges cross,
+	 * so insertion sort does little more than walk the list
+	 */
+	for (e = active ? active->next : NULL; e; e = next)
 	{
 	    next = e->next;
+	    for (en = e->prev; en; en = en->prev)
+	    {
+		if (!(e->current_x < en->current_x ||
+		      (e->current_x == en->current_x &&
+		       e->edge.p2.x < en->edge.p2.x)))
+		    break;
+	    }
+	    if (en == e->prev)
+		continue;
+	    /*
+	     * extract e
+	     */
+	    e->prev->next = e->next;
+	    if (e->next)
+		e->next->prev = e->prev;
 	    /*
-	     * Find one later in the list that belongs before the
-	     * current one
+	     * insert e after en, or at the head of the list
 	     */
-	    for (en = next; en; en = en->next)
+	    e->prev = en;
+	    if (en)
 	    {
-		if (en->current_x < e->current_x ||
-		    (en->current_x == e->current_x &&
-		     en->edge.p2.x < e->edge.p2.x))
-		{
-		    /*
-		     * insert en before e
-		     *
-		     * extract en
-		     */
-		    en->prev->next = en->next;
-		    if (en->next)
-			en->next->prev = en->prev;
-		    /*
-		     * insert en
-		     */
-		    if (e->prev)
-			e->prev->next = en;
-		    else
-			active = en;
-		    en->prev = e->prev;
-		    e->prev = en;
-		    en->next = e;
-		    /*
-		     * start over at en
-		     */
-		    next = en;
-		    break;
-		}
+		e->next = en->next;
+		en->next = e;
+	    }
+	    else
+	    {
+		e->next = active;
+		active = e;
 	    }
+	    e->next->prev = e;
 	}
 #if 0
 	printf ("y: %6.3g:", y / 65536.0);
@@ -196,18 +250,7 @@ XRenderComputeTrapezoids (Edge		*edges,
 
 	/* walk the list generating trapezoids */
 	for (e = active; e && (en = e->next); e = en->next)
-	{
-	    traps->top = y;
-	    traps->bottom = next_y;
-	    traps->left = e->edge;
-	    traps->right = en->edge;
-	    traps++;
-	    (*ntraps)++;
-            if ( --maxtraps <= 0 ) {
-	       ok = 0;
-	       break;
-	    }
-	}
+	    XRenderAddTrapezoid (tb, y, next_y, &e->edge, &en->edge);
 
 	y = next_y;
 
@@ -226,7 +269,6 @@ XRenderComputeTrapezoids (Edge		*edges,
 	    }
 	}
     }
-    return ok;
 }
 
 void
@@ -243,17 +285,18 @@ XRenderCompositeDoublePoly (Display		    *dpy,
 			    int			    npoints,
 			    int			    winding)
 {
+    unsigned long   max_req = dpy->bigreq_size ? dpy->bigreq_size : dpy->max_request_size;
     Edge	    *edges;
-    XTrapezoid	    *traps;
-    int		    i, nedges, ntraps;
+    TrapBuffer	    tb;
+    int		    i, nedges;
     XFixed	    prevx = 0, prevy = 0, firstx = 0, firsty = 0;
     XFixed	    top = 0, bottom = 0;	/* GCCism */
 
-    edges = Xmalloc (((size_t) npoints * sizeof (Edge)) +
-                     ((size_t) (npoints * npoints) * sizeof (XTrapezoid)));
+    if (npoints <= 0)
+	return;
+    edges = Xmalloc ((size_t) npoints * sizeof (Edge));
     if (!edges)
 	return;
-    traps = (XTrapezoid *) (edges + npoints);
     nedges = 0;
     for (i = 0; i <= npoints; i++)
     {
@@ -305,9 +348,33 @@ XRenderCompositeDoublePoly (Display		    *dpy,
 	prevx = x;
 	prevy = y;
     }
-    if ( XRenderComputeTrapezoids (edges, nedges, winding, traps, &ntraps, npoints * npoints )) {
-       /* XXX adjust xSrc/xDst */
-       XRenderCompositeTrapezoids (dpy, op, src, dst, maskFormat, xSrc, ySrc, traps, ntraps);
+    if (!nedges)
+    {
+	Xfree (edges);
+	return;
+    }
+
+    tb.dpy = dpy;
+    tb.op = op;
+    tb.src = src;
+    tb.dst = dst;
+    tb.maskFormat = maskFormat;
+    tb.xSrc = xSrc;
+    tb.ySrc = ySrc;
+    tb.ntraps = 0;
+    /*
+     * Start with room for a trapezoid per edge, and grow up to what
+     * one request holds
+     */
+    tb.max = (int) ((max_req - (SIZEOF (xRenderTrapezoidsReq) >> 2)) /
+		    (SIZEOF (xTrapezoid) >> 2));
+    tb.size = nedges < tb.max ? nedges : tb.max;
+    tb.traps = Xmalloc ((size_t) tb.size * sizeof (XTrapezoid));
+    if (tb.traps)
+    {
+	XRenderComputeTrapezoids (edges, nedges, winding, &tb);
+	XRenderFlushTrapezoids (&tb);
+	Xfree (tb.traps);
     }
     Xfree (edges);
 }
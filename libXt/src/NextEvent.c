@@ -370,6 +370,39 @@ IoWait(wait_times_ptr_t wt, wait_fds_ptr_t wf)
 {
 #ifdef USE_POLL
     return poll(wf->fdlist, (nfds_t) wf->fdlistlen, wt->poll_wait);
+#elif defined(_WIN32)
+    /*
+     * Winsock's select fails at once on three empty sets, and waits in
+     * whole milliseconds, rounding a shorter wait down to none; either way
+     * a caller waiting for a timer would spin until it expired.  Sleep
+     * when there are no sockets, round the wait up, and put the Winsock
+     * error where the caller looks for it.
+     */
+    struct timeval wait_time, *wait_time_ptr = NULL;
+    DWORD ms = INFINITE;
+    int nfds;
+
+    if (wt->wait_time_ptr != NULL) {
+        ms = (DWORD) (wt->wait_time_ptr->tv_sec * 1000 +
+                      (wt->wait_time_ptr->tv_usec + 999) / 1000);
+        wait_time.tv_sec = (long) (ms / 1000);
+        wait_time.tv_usec = (long) ((ms % 1000) * 1000);
+        wait_time_ptr = &wait_time;
+    }
+    if (!XFD_ANYSET(&wf->rmask) && !XFD_ANYSET(&wf->wmask) &&
+        !XFD_ANYSET(&wf->emask)) {
+        Sleep(ms);
+        return 0;
+    }
+    nfds = Select(wf->nfds, &wf->rmask, &wf->wmask, &wf->emask,
+                  wait_time_ptr);
+    if (nfds == SOCKET_ERROR) {
+        int error = WSAGetLastError();
+
+        errno = error == WSAEINTR ? EINTR :
+            error == WSAEWOULDBLOCK ? EAGAIN : error;
+    }
+    return nfds;
 #else
     return Select (wf->nfds, &wf->rmask, &wf->wmask, &wf->emask,
                    wt->wait_time_ptr);
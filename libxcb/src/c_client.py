@@ -2172,6 +2172,21 @@ def c_union(self, name):
     _c_complex(self)
     _c_iterator(self, name)
 
+def _c_switch_max_size(self):
+    '''
+    Returns the most bytes the _serialize() function of a switch can write,
+    or None if a bitcase has variable size.  Every bitcase may add up to
+    3 bytes of padding in front of it, and the end is padded as well.
+    '''
+    if not self.is_switch:
+        return None
+    size = 3
+    for bitcase in self.bitcases:
+        if bitcase.type.size is None:
+            return None
+        size += bitcase.type.size + 3
+    return size
+
 def _c_request_helper(self, name, void, regular, aux=False, reply_fds=False):
     '''
     Declares a request function.
@@ -2363,9 +2378,15 @@ def _c_request_helper(self, name, void, regular, aux=False, reply_fds=False):
         _c('    void *xcb_aux = 0;')
 
 
-    for idx, _ in enumerate(serial_fields):
+    for idx, field in enumerate(serial_fields):
         if aux:
-            _c('    void *xcb_aux%d = 0;' % (idx))
+            # a switch of fixed size bitcases is serialized on the stack
+            max_size = _c_switch_max_size(field.type)
+            if max_size is not None:
+                _c('    char xcb_aux%d_buf[%d];' % (idx, max_size))
+                _c('    void *xcb_aux%d = xcb_aux%d_buf;' % (idx, idx))
+            else:
+                _c('    void *xcb_aux%d = 0;' % (idx))
     if list_with_var_size_elems:
         _c('    unsigned int xcb_tmp_len;')
         _c('    char *xcb_tmp;')
@@ -2468,7 +2489,8 @@ def _c_request_helper(self, name, void, regular, aux=False, reply_fds=False):
                         serialize_args = get_serialize_args(field.type, aux_var, field.c_field_name, context)
                         _c('      %s (%s);', field.type.c_serialize_name, serialize_args)
                         _c('    xcb_parts[%d].iov_base = xcb_aux%d;' % (count, idx))
-                        free_calls.append('    free(xcb_aux%d);' % idx)
+                        if _c_switch_max_size(field.type) is None:
+                            free_calls.append('    free(xcb_aux%d);' % idx)
                     else:
                         serialize_args = get_serialize_args(field.type, field.c_field_name, aux_var, context)
                         func_name = field.type.c_sizeof_name
@@ -105,6 +105,11 @@ static int is_static_error_conn(xcb_connection_t *c)
            c == (xcb_connection_t *) &xcb_con_closed_screen_er;
 }
 
+#ifdef _WIN32
+/* Buffers handed to a single WSASend call */
+#define XCB_MAX_WSABUF 64
+#endif
+
 static int set_fd_flags(const int fd)
 {
 /* Win32 doesn't have file descriptors and the fcntl function. This block sets the socket in non-blocking mode */
@@ -222,47 +227,35 @@ static int read_setup(xcb_connection_t *c)
 /* precondition: there must be something for us to write. */
 static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
 {
-#ifndef _WIN32
     int n;
-#endif
 
     assert(!c->out.queue_len);
 
 #ifdef _WIN32
-    /* Could use the WSASend win32 function for scatter/gather i/o but setting up the WSABUF struct from
-       an iovec would require more work and I'm not sure of the benefit....works for now */
-    while (*count)
     {
-        struct iovec *vec = *vector;
-        if (vec->iov_len)
+        /* Hand the iovecs to WSASend in one call instead of one send per buffer */
+        WSABUF bufs[XCB_MAX_WSABUF];
+        DWORD sent;
+        int i;
+
+        n = *count;
+        if (n > XCB_MAX_WSABUF)
+            n = XCB_MAX_WSABUF;
+        for (i = 0; i < n; i++)
         {
-            int ret = send(c->fd, vec->iov_base, vec->iov_len, 0);
-            if (ret == SOCKET_ERROR)
-            {
-                int err = WSAGetLastError();
-                if (err == WSAEWOULDBLOCK)
-                {
-                    return 1;
-                }
-            }
-            if (ret <= 0)
-            {
-                _xcb_conn_shutdown(c, XCB_CONN_ERROR);
-                return 0;
-            }
-            c->out.total_written += ret;
-            vec->iov_len -= ret;
-            vec->iov_base = (char *)vec->iov_base + ret;
+            bufs[i].buf = (*vector)[i].iov_base;
+            bufs[i].len = (*vector)[i].iov_len;
         }
-        if (vec->iov_len == 0) {
-            (*vector)++;
-            (*count)--;
+
+        if (WSASend(c->fd, bufs, n, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+        {
+            if (WSAGetLastError() == WSAEWOULDBLOCK)
+                return 1;
+            _xcb_conn_shutdown(c, XCB_CONN_ERROR);
+            return 0;
         }
+        n = sent;
     }
-
-    if (!*count)
-        *vector = 0;
-
 #else
     n = *count;
     if (n > IOV_MAX)
@@ -303,6 +296,7 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
         if(n < 0 && errno == EAGAIN)
             return 1;
     }
+#endif /* _WIN32 */
 
     if(n <= 0)
     {
@@ -328,8 +322,6 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
         *vector = 0;
     assert(n == 0);
 
-#endif /* _WIN32 */
-
     return 1;
 }
 
@@ -388,6 +380,7 @@ xcb_connection_t *xcb_connect_to_fd(int fd, xcb_auth_info_t *auth_info)
         pthread_mutex_init(&c->iolock, 0) == 0 &&
         _xcb_in_init(&c->in) &&
         _xcb_out_init(&c->out) &&
+        _xcb_trace_init(&c->trace) &&
         write_setup(c, auth_info) &&
         read_setup(c) &&
         _xcb_ext_init(c) &&
@@ -422,6 +415,7 @@ void xcb_disconnect(xcb_connection_t *c)
 
     _xcb_ext_destroy(c);
     _xcb_xid_destroy(c);
+    _xcb_trace_destroy(&c->trace);
 
     free(c);
 
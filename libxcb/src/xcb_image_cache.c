@@ -0,0 +1,281 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Client side of IMAGE-CACHE: a record of the keys the server holds for
+ * this connection, maintained by the same rules the server applies, so
+ * the data is left out exactly when the server has it.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcb/xcb.h>
+#include <xcb/imagecache.h>
+#include "xcb_image_cache.h"
+
+typedef struct xcb_image_cache_entry_t {
+    struct xcb_image_cache_entry_t *chain;      /* same hash bucket */
+    struct xcb_image_cache_entry_t *prev, *next; /* most recently used first */
+    uint32_t key[4];
+    uint32_t size;
+} xcb_image_cache_entry_t;
+
+struct xcb_image_cache_t {
+    xcb_connection_t *c;
+    uint32_t budget;
+    uint32_t used;
+    xcb_image_cache_entry_t **buckets;
+    uint32_t nbuckets;          /* a power of two */
+    uint32_t count;
+    xcb_image_cache_entry_t lru; /* list head */
+};
+
+static uint64_t
+rotl64 (uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t
+fmix64 (uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+/* MurmurHash3 x64 128; the key only has to be consistent within a process */
+static void
+image_cache_hash (const uint8_t *data, uint32_t len, uint32_t key[4])
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = 0, h2 = 0, k1, k2;
+    uint32_t i, nblocks = len / 16, rest = len & 15;
+    const uint8_t *tail = data + nblocks * 16;
+
+    for (i = 0; i < nblocks; i++) {
+        memcpy(&k1, data + i * 16, 8);
+        memcpy(&k2, data + i * 16 + 8, 8);
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    k1 = k2 = 0;
+    for (i = rest; i > 8; i--)
+        k2 ^= (uint64_t) tail[i - 1] << ((i - 9) * 8);
+    for (; i > 0; i--)
+        k1 ^= (uint64_t) tail[i - 1] << ((i - 1) * 8);
+    if (rest > 8) {
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    if (rest > 0) {
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    key[0] = (uint32_t) h1;
+    key[1] = (uint32_t) (h1 >> 32);
+    key[2] = (uint32_t) h2;
+    key[3] = (uint32_t) (h2 >> 32);
+}
+
+static xcb_image_cache_entry_t **
+image_cache_slot (xcb_image_cache_t *cache, const uint32_t key[4])
+{
+    xcb_image_cache_entry_t **slot;
+
+    slot = &cache->buckets[key[0] & (cache->nbuckets - 1)];
+    while (*slot && memcmp((*slot)->key, key, sizeof((*slot)->key)))
+        slot = &(*slot)->chain;
+    return slot;
+}
+
+static void
+image_cache_unlink (xcb_image_cache_entry_t *entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+}
+
+static void
+image_cache_link (xcb_image_cache_t *cache, xcb_image_cache_entry_t *entry)
+{
+    entry->prev = &cache->lru;
+    entry->next = cache->lru.next;
+    entry->next->prev = entry;
+    cache->lru.next = entry;
+}
+
+static void
+image_cache_remove (xcb_image_cache_t *cache, xcb_image_cache_entry_t *entry)
+{
+    xcb_image_cache_entry_t **slot = image_cache_slot(cache, entry->key);
+
+    *slot = entry->chain;
+    image_cache_unlink(entry);
+    cache->used -= entry->size;
+    cache->count--;
+    free(entry);
+}
+
+static void
+image_cache_grow (xcb_image_cache_t *cache)
+{
+    xcb_image_cache_entry_t **buckets, *entry;
+    uint32_t n = cache->nbuckets * 2;
+
+    buckets = calloc(n, sizeof(*buckets));
+    if (!buckets)
+        return;
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->nbuckets = n;
+    for (entry = cache->lru.next; entry != &cache->lru; entry = entry->next) {
+        xcb_image_cache_entry_t **slot = &buckets[entry->key[0] & (n - 1)];
+
+        entry->chain = *slot;
+        *slot = entry;
+    }
+}
+
+/* What the server does with data sent under key; see imagecacheproto.h */
+static void
+image_cache_store (xcb_image_cache_t *cache, const uint32_t key[4],
+                   uint32_t size)
+{
+    xcb_image_cache_entry_t **slot, *entry;
+
+    if ((entry = *image_cache_slot(cache, key)))
+        image_cache_remove(cache, entry);
+    if (size > cache->budget)
+        return;
+    while (cache->used + size > cache->budget)
+        image_cache_remove(cache, cache->lru.prev);
+
+    if (cache->count >= cache->nbuckets)
+        image_cache_grow(cache);
+    entry = malloc(sizeof(*entry));
+    if (!entry) {
+        /* cannot follow the server any more; start over */
+        xcb_image_cache_reset(cache);
+        return;
+    }
+    memcpy(entry->key, key, sizeof(entry->key));
+    entry->size = size;
+    slot = image_cache_slot(cache, key);
+    entry->chain = *slot;
+    *slot = entry;
+    image_cache_link(cache, entry);
+    cache->used += size;
+    cache->count++;
+}
+
+xcb_image_cache_t *
+xcb_image_cache_new (xcb_connection_t *c)
+{
+    const xcb_query_extension_reply_t *ext;
+    xcb_imagecache_query_version_reply_t *reply;
+    xcb_image_cache_t *cache;
+
+    ext = xcb_get_extension_data(c, &xcb_imagecache_id);
+    if (!ext || !ext->present)
+        return NULL;
+    reply = xcb_imagecache_query_version_reply(c,
+                xcb_imagecache_query_version(c, XCB_IMAGECACHE_MAJOR_VERSION,
+                                             XCB_IMAGECACHE_MINOR_VERSION),
+                NULL);
+    if (!reply)
+        return NULL;
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache) {
+        cache->nbuckets = 64;
+        cache->buckets = calloc(cache->nbuckets, sizeof(*cache->buckets));
+        if (!cache->buckets) {
+            free(cache);
+            cache = NULL;
+        }
+    }
+    if (cache) {
+        cache->c = c;
+        cache->budget = reply->budget;
+        cache->lru.prev = cache->lru.next = &cache->lru;
+    }
+    free(reply);
+    return cache;
+}
+
+void
+xcb_image_cache_free (xcb_image_cache_t *cache)
+{
+    if (!cache)
+        return;
+    while (cache->lru.next != &cache->lru)
+        image_cache_remove(cache, cache->lru.next);
+    free(cache->buckets);
+    free(cache);
+}
+
+xcb_void_cookie_t
+xcb_image_cache_put_image (xcb_image_cache_t *cache,
+                           uint8_t            format,
+                           xcb_drawable_t     drawable,
+                           xcb_gcontext_t     gc,
+                           uint16_t           width,
+                           uint16_t           height,
+                           int16_t            dst_x,
+                           int16_t            dst_y,
+                           uint8_t            left_pad,
+                           uint8_t            depth,
+                           uint32_t           data_len,
+                           const uint8_t     *data)
+{
+    xcb_image_cache_entry_t *entry;
+    uint32_t key[4], size = (data_len + 3) & ~3U;
+
+    /* without data the request would be a lookup */
+    if (!data_len)
+        return xcb_put_image(cache->c, format, drawable, gc, width, height,
+                             dst_x, dst_y, left_pad, depth, data_len, data);
+
+    image_cache_hash(data, data_len, key);
+    entry = *image_cache_slot(cache, key);
+    if (entry && entry->size == size) {
+        image_cache_unlink(entry);
+        image_cache_link(cache, entry);
+        return xcb_imagecache_put_image(cache->c, drawable, gc, width, height,
+                                        dst_x, dst_y, format, depth, left_pad,
+                                        key[0], key[1], key[2], key[3],
+                                        0, NULL);
+    }
+
+    image_cache_store(cache, key, size);
+    return xcb_imagecache_put_image(cache->c, drawable, gc, width, height,
+                                    dst_x, dst_y, format, depth, left_pad,
+                                    key[0], key[1], key[2], key[3],
+                                    data_len, data);
+}
+
+xcb_void_cookie_t
+xcb_image_cache_reset (xcb_image_cache_t *cache)
+{
+    while (cache->lru.next != &cache->lru)
+        image_cache_remove(cache, cache->lru.next);
+    return xcb_imagecache_reset(cache->c);
+}
@@ -97,6 +97,13 @@ typedef struct reader_list {
     struct reader_list *next;
 } reader_list;
 
+/* Condition variables are costly to create on some platforms (two
+ * semaphores each with pthreads-win32), so wait_for_reply recycles them. */
+typedef struct reader_cond {
+    pthread_cond_t cond;
+    struct reader_cond *next;
+} reader_cond;
+
 typedef struct special_list {
     xcb_special_event_t *se;
     struct special_list *next;
@@ -225,6 +232,8 @@ static int read_packet(xcb_connection_t *c)
 
     if(genrep.response_type == XCB_ERROR || genrep.response_type == XCB_REPLY)
     {
+        if(c->trace.ring)
+            _xcb_trace_replied(&c->trace, c->in.request_read);
         pend = c->in.pending_replies;
         if(pend &&
            !(XCB_SEQUENCE_COMPARE(pend->first_request, <=, c->in.request_read) &&
@@ -461,6 +470,8 @@ static int poll_for_reply(xcb_connection_t *c, uint64_t request, void **reply, x
             *reply = head->reply;
 
         free(head);
+        if(c->trace.ring)
+            _xcb_trace_woken(&c->trace, request);
     }
 
     return 1;
@@ -486,6 +497,29 @@ static void remove_reader(reader_list **prev_reader, reader_list *reader)
         }
 }
 
+static reader_cond *get_reader_cond(xcb_connection_t *c)
+{
+    reader_cond *rc = c->in.free_conds;
+    if(rc)
+    {
+        c->in.free_conds = rc->next;
+        return rc;
+    }
+    rc = malloc(sizeof(reader_cond));
+    if(rc && pthread_cond_init(&rc->cond, 0))
+    {
+        free(rc);
+        rc = 0;
+    }
+    return rc;
+}
+
+static void put_reader_cond(xcb_connection_t *c, reader_cond *rc)
+{
+    rc->next = c->in.free_conds;
+    c->in.free_conds = rc;
+}
+
 static void insert_special(special_list **prev_special, special_list *special, xcb_special_event_t *se)
 {
     special->se = se;
@@ -513,17 +547,28 @@ static void *wait_for_reply(xcb_connection_t *c, uint64_t request, xcb_generic_e
     /* If this request has not been written yet, write it. */
     if(c->out.return_socket || _xcb_out_flush_to(c, request))
     {
-        pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
         reader_list reader;
+        reader_cond *rc;
 
-        insert_reader(&c->in.readers, &reader, request, &cond);
+        /* The reply may already be here; don't bother setting up a wait. */
+        if(!poll_for_reply(c, request, &ret, e))
+        {
+            rc = get_reader_cond(c);
+            if(!rc)
+            {
+                _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
+                return 0;
+            }
+
+            insert_reader(&c->in.readers, &reader, request, &rc->cond);
 
-        while(!poll_for_reply(c, request, &ret, e))
-            if(!_xcb_conn_wait(c, &cond, 0, 0))
-                break;
+            while(!poll_for_reply(c, request, &ret, e))
+                if(!_xcb_conn_wait(c, &rc->cond, 0, 0))
+                    break;
 
-        remove_reader(&c->in.readers, &reader);
-        pthread_cond_destroy(&cond);
+            remove_reader(&c->in.readers, &reader);
+            put_reader_cond(c, rc);
+        }
     }
 
     _xcb_in_wake_up_next_reader(c);
@@ -568,6 +613,41 @@ void *xcb_wait_for_reply64(xcb_connection_t *c, uint64_t request, xcb_generic_er
     return ret;
 }
 
+int xcb_wait_for_replies(xcb_connection_t *c, int count, const unsigned int *requests, void **replies, xcb_generic_error_t **errors)
+{
+    uint64_t last = 0;
+    int i, ret = 0;
+
+    for(i = 0; i < count; ++i)
+    {
+        replies[i] = 0;
+        if(errors)
+            errors[i] = 0;
+    }
+    if(c->has_error || count <= 0)
+        return 0;
+
+    pthread_mutex_lock(&c->iolock);
+
+    /* Get every request out in one write before waiting for the first. */
+    for(i = 0; i < count; ++i)
+    {
+        uint64_t request = widen(c, requests[i]);
+        if(XCB_SEQUENCE_COMPARE(request, >, last))
+            last = request;
+    }
+    if(c->out.return_socket || _xcb_out_flush_to(c, last))
+        for(i = 0; i < count; ++i)
+        {
+            replies[i] = wait_for_reply(c, widen(c, requests[i]), errors ? &errors[i] : 0);
+            if(replies[i])
+                ++ret;
+        }
+
+    pthread_mutex_unlock(&c->iolock);
+    return ret;
+}
+
 int *xcb_get_reply_fds(xcb_connection_t *c, void *reply, size_t reply_size)
 {
     return (int *) (&((char *) reply)[reply_size]);
@@ -904,6 +984,8 @@ int _xcb_in_init(_xcb_in *in)
     if(!in->replies)
         return 0;
 
+    in->free_conds = 0;
+
     in->current_reply_tail = &in->current_reply;
     in->events_tail = &in->events;
     in->pending_replies_tail = &in->pending_replies;
@@ -914,6 +996,13 @@ int _xcb_in_init(_xcb_in *in)
 void _xcb_in_destroy(_xcb_in *in)
 {
     pthread_cond_destroy(&in->event_cond);
+    while(in->free_conds)
+    {
+        reader_cond *rc = in->free_conds;
+        in->free_conds = rc->next;
+        pthread_cond_destroy(&rc->cond);
+        free(rc);
+    }
     free_reply_list(in->current_reply);
     _xcb_map_delete(in->replies, (void (*)(void *)) free_reply_list);
     while(in->events)
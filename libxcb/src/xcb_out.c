@@ -50,6 +50,8 @@ static __inline void send_request(xcb_connection_t *c, int isvoid, enum workarou
         return;
 
     ++c->out.request;
+    if(c->trace.ring)
+        _xcb_trace_sent(&c->trace, c->out.request, count ? vector[0].iov_base : 0, count ? vector[0].iov_len : 0);
     if(!isvoid)
         c->in.request_expected = c->out.request;
     if(workaround != WORKAROUND_NONE || flags != 0)
@@ -0,0 +1,151 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Per-request latency tracing.
+ *
+ * When XCB_TRACE names a file (or is "-" for stderr), every connection
+ * keeps a ring of recent requests with the time each was sent, the time
+ * its reply or error arrived and the time a caller picked that up.  A
+ * record is written out when its slot is reused and the rest when the
+ * connection is closed, one line per request:
+ *
+ *   <sequence> <major>.<minor> <sent> <reply> <wake>
+ *
+ * with the send time in microseconds of a monotonic clock and the other
+ * two as offsets from it (-1 when it never happened).  Sequence numbers
+ * are the server's, so the trace lines up with server-side logs.  All of
+ * this runs under the connection's iolock, so the ring needs no locking of
+ * its own.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include "xcb_windefs.h"
+#endif /* _WIN32 */
+
+#include "xcb.h"
+#include "xcbext.h"
+#include "xcbint.h"
+
+#define XCB_TRACE_SIZE 4096     /* records; must be a power of two */
+
+static uint64_t trace_now(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if(!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t) (now.QuadPart / freq.QuadPart) * 1000000 +
+        (uint64_t) (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif /* _WIN32 */
+}
+
+static long long trace_offset(uint64_t t, uint64_t sent)
+{
+    return t ? (long long) (t - sent) : -1;
+}
+
+static void trace_write(_xcb_trace *trace, _xcb_trace_record *rec)
+{
+    if(!rec->request)
+        return;
+    fprintf(trace->out, "%llu %u.%u %llu %lld %lld\n",
+            (unsigned long long) rec->request, rec->major, rec->minor,
+            (unsigned long long) rec->sent,
+            trace_offset(rec->replied, rec->sent),
+            trace_offset(rec->woken, rec->sent));
+    rec->request = 0;
+}
+
+static _xcb_trace_record *trace_find(_xcb_trace *trace, uint64_t request)
+{
+    _xcb_trace_record *rec = &trace->ring[request & (XCB_TRACE_SIZE - 1)];
+    return rec->request == request ? rec : 0;
+}
+
+/* Private interface */
+
+int _xcb_trace_init(_xcb_trace *trace)
+{
+    const char *name = getenv("XCB_TRACE");
+
+    trace->ring = 0;
+    trace->out = 0;
+    if(!name || !*name)
+        return 1;
+
+    if(!strcmp(name, "-"))
+        trace->out = stderr;
+    else if(!(trace->out = fopen(name, "a")))
+        return 1; /* tracing is best effort */
+
+    trace->ring = calloc(XCB_TRACE_SIZE, sizeof(_xcb_trace_record));
+    if(!trace->ring)
+    {
+        if(trace->out != stderr)
+            fclose(trace->out);
+        trace->out = 0;
+    }
+    return 1;
+}
+
+void _xcb_trace_destroy(_xcb_trace *trace)
+{
+    int i;
+
+    if(!trace->ring)
+        return;
+    /* oldest first: the slots after the most recent request wrap around */
+    for(i = 1; i <= XCB_TRACE_SIZE; ++i)
+        trace_write(trace, &trace->ring[(trace->last + i) & (XCB_TRACE_SIZE - 1)]);
+    if(trace->out == stderr)
+        fflush(stderr);
+    else
+        fclose(trace->out);
+    free(trace->ring);
+    trace->ring = 0;
+}
+
+void _xcb_trace_sent(_xcb_trace *trace, uint64_t request, const void *header, size_t len)
+{
+    _xcb_trace_record *rec = &trace->ring[request & (XCB_TRACE_SIZE - 1)];
+
+    trace_write(trace, rec);
+    rec->request = request;
+    rec->major = len > 0 ? ((const uint8_t *) header)[0] : 0;
+    rec->minor = len > 1 ? ((const uint8_t *) header)[1] : 0;
+    rec->sent = trace_now();
+    rec->replied = 0;
+    rec->woken = 0;
+    trace->last = request;
+}
+
+void _xcb_trace_replied(_xcb_trace *trace, uint64_t request)
+{
+    _xcb_trace_record *rec = trace_find(trace, request);
+    if(rec && !rec->replied)
+        rec->replied = trace_now();
+}
+
+void _xcb_trace_woken(_xcb_trace *trace, uint64_t request)
+{
+    _xcb_trace_record *rec = trace_find(trace, request);
+    if(rec && !rec->woken)
+        rec->woken = trace_now();
+}
@@ -355,6 +355,17 @@ static int _xcb_do_connect(int fd, const struct sockaddr* addr, int addrlen) {
 
     setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
     setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+#ifdef _WIN32
+    {
+        /* Has to be set before connect(); only takes effect against a
+         * local server that enabled it on its listening socket too. */
+        int fastpath = 1;
+        DWORD bytes;
+
+        WSAIoctl(fd, SIO_LOOPBACK_FAST_PATH, &fastpath, sizeof(fastpath),
+                 NULL, 0, &bytes, NULL, NULL);
+    }
+#endif
 
     return connect(fd, addr, addrlen);
 }
@@ -45,6 +45,11 @@
 
 typedef unsigned char BYTE;
 
+/* Not declared by older SDKs, supported from Windows 8 on */
+#ifndef SIO_LOOPBACK_FAST_PATH
+#define SIO_LOOPBACK_FAST_PATH _WSAIOW(IOC_VENDOR, 16)
+#endif
+
 typedef unsigned int in_addr_t;
 
 #define HANDLE void *
@@ -263,6 +263,21 @@ void *xcb_wait_for_reply(xcb_connection_t *c, unsigned int request, xcb_generic_
  */
 void *xcb_wait_for_reply64(xcb_connection_t *c, uint64_t request, xcb_generic_error_t **e);
 
+/**
+ * @brief Wait for the replies of several requests.
+ * @param c The connection to the X server.
+ * @param count Number of requests.
+ * @param requests Sequence numbers of the requests as returned by xcb_send_request().
+ * @param replies Array of @p count locations to store the replies in, must not be NULL.
+ * @param errors Array of @p count locations to store errors in, or NULL. Ignored for unchecked requests.
+ * @return The number of replies returned.
+ *
+ * Equivalent to calling xcb_wait_for_reply() for each request in turn, but
+ * takes the connection lock and flushes the output queue only once. Each
+ * entry of @p replies is null when its request failed.
+ */
+int xcb_wait_for_replies(xcb_connection_t *c, int count, const unsigned int *requests, void **replies, xcb_generic_error_t **errors);
+
 /**
  * @brief Poll for the reply of a given request.
  * @param c The connection to the X server.
@@ -28,6 +28,8 @@
 #ifndef __XCBINT_H
 #define __XCBINT_H
 
+#include <stdio.h>
+
 #include "bigreq.h"
 
 #ifdef HAVE_CONFIG_H
@@ -155,6 +157,7 @@ typedef struct _xcb_in {
     struct event_list *events;
     struct event_list **events_tail;
     struct reader_list *readers;
+    struct reader_cond *free_conds;
     struct special_list *special_waiters;
 
     struct pending_reply *pending_replies;
@@ -203,6 +206,31 @@ int _xcb_ext_init(xcb_connection_t *c);
 void _xcb_ext_destroy(xcb_connection_t *c);
 
 
+/* xcb_trace.c */
+
+typedef struct _xcb_trace_record {
+    uint64_t request;
+    uint8_t major;
+    uint8_t minor;
+    uint64_t sent;
+    uint64_t replied;
+    uint64_t woken;
+} _xcb_trace_record;
+
+typedef struct _xcb_trace {
+    _xcb_trace_record *ring;    /* null unless XCB_TRACE is set */
+    FILE *out;
+    uint64_t last;
+} _xcb_trace;
+
+int _xcb_trace_init(_xcb_trace *trace);
+void _xcb_trace_destroy(_xcb_trace *trace);
+
+void _xcb_trace_sent(_xcb_trace *trace, uint64_t request, const void *header, size_t len);
+void _xcb_trace_replied(_xcb_trace *trace, uint64_t request);
+void _xcb_trace_woken(_xcb_trace *trace, uint64_t request);
+
+
 /* xcb_conn.c */
 
 struct xcb_connection_t {
@@ -221,6 +249,7 @@ struct xcb_connection_t {
     /* misc data */
     _xcb_ext ext;
     _xcb_xid xid;
+    _xcb_trace trace;
 };
 
 void _xcb_conn_shutdown(xcb_connection_t *c, int err);
@@ -39,6 +39,7 @@
 #include "glsl_parser.hpp"
 #include "ir_optimization.h"
 #include "builtin_functions.h"
+#include "shader_cache.h"
 
 /**
  * Format a short human-readable description of the given GLSL version.
@@ -2295,6 +2296,91 @@ can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
    return false;
 }
 
+#ifdef ENABLE_SHADER_CACHE
+/**
+ * Key for the preprocessor output of \c source: the source itself plus every
+ * piece of context state glcpp and add_builtin_defines() look at.
+ */
+static void
+compute_preprocess_key(struct gl_context *ctx, gl_shader_stage stage,
+                       const char *source, cache_key key)
+{
+   struct mesa_sha1 sha1_ctx;
+
+   _mesa_sha1_init(&sha1_ctx);
+   _mesa_sha1_update(&sha1_ctx, "glcpp", 5);
+   _mesa_sha1_update(&sha1_ctx, &stage, sizeof(stage));
+   _mesa_sha1_update(&sha1_ctx, &ctx->API, sizeof(ctx->API));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Version, sizeof(ctx->Version));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.GLSLVersion,
+                     sizeof(ctx->Const.GLSLVersion));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.ForceGLSLVersion,
+                     sizeof(ctx->Const.ForceGLSLVersion));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.DisableGLSLLineContinuations,
+                     sizeof(ctx->Const.DisableGLSLLineContinuations));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.AllowExtraPPTokens,
+                     sizeof(ctx->Const.AllowExtraPPTokens));
+   _mesa_sha1_update(&sha1_ctx, ctx->Const.dri_config_options_sha1,
+                     sizeof(ctx->Const.dri_config_options_sha1));
+   /* Only the extension flags, not the per-context extension string. */
+   _mesa_sha1_update(&sha1_ctx, &ctx->Extensions,
+                     offsetof(struct gl_extensions, String));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Extensions.Version,
+                     sizeof(ctx->Extensions.Version));
+   _mesa_sha1_update(&sha1_ctx, source, strlen(source));
+   _mesa_sha1_final(&sha1_ctx, key);
+}
+#endif
+
+/**
+ * Run glcpp on \c *source, reusing the output of an identical earlier run
+ * from any context of this process when \c cacheable is set.
+ *
+ * Only successful runs are remembered.  The stored item is the preprocessed
+ * source followed by the preprocessor info log, both NUL terminated.
+ */
+static int
+preprocess_shader(struct gl_context *ctx, struct _mesa_glsl_parse_state *state,
+                  const char **source, bool cacheable)
+{
+#ifdef ENABLE_SHADER_CACHE
+   cache_key key;
+
+   if (cacheable) {
+      size_t size;
+
+      compute_preprocess_key(ctx, state->stage, *source, key);
+      char *item = (char *) shader_cache_mem_get(key, &size);
+      if (item) {
+         *source = ralloc_strdup(state, item);
+         ralloc_strcat(&state->info_log, item + strlen(item) + 1);
+         free(item);
+         return 0;
+      }
+   }
+#endif
+
+   int error = glcpp_preprocess(state, source, &state->info_log,
+                                add_builtin_defines, state, ctx);
+
+#ifdef ENABLE_SHADER_CACHE
+   if (cacheable && !error) {
+      size_t source_len = strlen(*source) + 1;
+      size_t log_len = strlen(state->info_log) + 1;
+      char *item = (char *) malloc(source_len + log_len);
+
+      if (item) {
+         memcpy(item, *source, source_len);
+         memcpy(item + source_len, state->info_log, log_len);
+         shader_cache_mem_put(key, item, source_len + log_len);
+         free(item);
+      }
+   }
+#endif
+
+   return error;
+}
+
 void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
                           bool dump_ast, bool dump_hir, bool force_recompile)
@@ -2333,9 +2419,12 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
                               false, true);
 
+   /* Shader includes are resolved from the include tree at preprocessing
+    * time, so their output can't be shared.
+    */
    if (!source_has_shader_include || !force_recompile) {
-      state->error = glcpp_preprocess(state, &source, &state->info_log,
-                                      add_builtin_defines, state, ctx);
+      state->error = preprocess_shader(ctx, state, &source,
+                                       !source_has_shader_include);
    }
 
    /* Now that we have run the preprocessor we can check the shader cache and
@@ -42,6 +42,12 @@
  * in the hope that the final linked shader will be found in the cache.
  * If anything goes wrong (shader variant not found, backend cache item is
  * corrupt, etc) we will use a fallback path to compile and link the IR.
+ *
+ * In front of the disk cache sits a small process-wide memory store so that
+ * several contexts of the same process submitting identical shaders share
+ * the glcpp output and the serialized linked program without going through
+ * the disk cache (whose writes are asynchronous and may not have landed yet
+ * when the next context asks for the same program).
  */
 
 #include "util/os_misc.h"
@@ -59,6 +65,8 @@
 #include "serialize.h"
 #include "shader_cache.h"
 #include "util/mesa-sha1.h"
+#include "util/hash_table.h"
+#include "util/simple_mtx.h"
 #include "string_to_uint_map.h"
 #include "main/mtypes.h"
 
@@ -68,6 +76,114 @@ extern "C" {
 #include "program/program.h"
 }
 
+/* Upper bound on the bytes kept in the memory store.  Once reached new items
+ * are simply not added; the disk cache still backs everything.
+ */
+#define SHADER_MEM_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+struct mem_cache_item {
+   cache_key key;
+   size_t size;
+   void *data;
+};
+
+static simple_mtx_t mem_cache_lock = SIMPLE_MTX_INITIALIZER;
+static struct hash_table *mem_cache;
+static size_t mem_cache_size;
+
+static uint32_t
+mem_cache_key_hash(const void *key)
+{
+   /* The key is already a SHA-1, any four bytes of it hash well enough. */
+   uint32_t hash;
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+mem_cache_key_equals(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(cache_key)) == 0;
+}
+
+void
+shader_cache_mem_put(const cache_key key, const void *data, size_t size)
+{
+   simple_mtx_lock(&mem_cache_lock);
+
+   if (!mem_cache) {
+      mem_cache = _mesa_hash_table_create(NULL, mem_cache_key_hash,
+                                          mem_cache_key_equals);
+      if (!mem_cache)
+         goto out;
+   }
+
+   if (mem_cache_size + size > SHADER_MEM_CACHE_MAX_SIZE ||
+       _mesa_hash_table_search(mem_cache, key))
+      goto out;
+
+   {
+      struct mem_cache_item *item = ralloc(mem_cache, struct mem_cache_item);
+      if (!item)
+         goto out;
+
+      item->data = ralloc_size(item, size);
+      if (!item->data) {
+         ralloc_free(item);
+         goto out;
+      }
+
+      memcpy(item->key, key, sizeof(cache_key));
+      item->size = size;
+      memcpy(item->data, data, size);
+      _mesa_hash_table_insert(mem_cache, item->key, item);
+      mem_cache_size += size;
+   }
+
+out:
+   simple_mtx_unlock(&mem_cache_lock);
+}
+
+void *
+shader_cache_mem_get(const cache_key key, size_t *size)
+{
+   void *data = NULL;
+
+   simple_mtx_lock(&mem_cache_lock);
+
+   struct hash_entry *entry =
+      mem_cache ? _mesa_hash_table_search(mem_cache, key) : NULL;
+   if (entry) {
+      struct mem_cache_item *item = (struct mem_cache_item *) entry->data;
+      data = malloc(item->size);
+      if (data) {
+         memcpy(data, item->data, item->size);
+         *size = item->size;
+      }
+   }
+
+   simple_mtx_unlock(&mem_cache_lock);
+
+   return data;
+}
+
+static void
+mem_cache_remove(const cache_key key)
+{
+   simple_mtx_lock(&mem_cache_lock);
+
+   struct hash_entry *entry =
+      mem_cache ? _mesa_hash_table_search(mem_cache, key) : NULL;
+   if (entry) {
+      struct mem_cache_item *item = (struct mem_cache_item *) entry->data;
+      mem_cache_size -= item->size;
+      _mesa_hash_table_remove(mem_cache, entry);
+      ralloc_free(item);
+   }
+
+   simple_mtx_unlock(&mem_cache_lock);
+}
+
 static void
 compile_shaders(struct gl_context *ctx, struct gl_shader_program *prog) {
    for (unsigned i = 0; i < prog->NumShaders; i++) {
@@ -127,6 +243,7 @@ shader_cache_write_program_metadata(struct gl_context *ctx,
              sizeof(cache_key));
    }
 
+   shader_cache_mem_put(prog->data->sha1, metadata.data, metadata.size);
    disk_cache_put(cache, prog->data->sha1, metadata.data, metadata.size,
                   &cache_item_metadata);
 
@@ -211,8 +328,15 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
    ralloc_free(buf);
 
    size_t size;
-   uint8_t *buffer = (uint8_t *) disk_cache_get(cache, prog->data->sha1,
-                                                &size);
+   bool from_mem = true;
+   uint8_t *buffer = (uint8_t *) shader_cache_mem_get(prog->data->sha1,
+                                                      &size);
+   if (buffer == NULL) {
+      from_mem = false;
+      buffer = (uint8_t *) disk_cache_get(cache, prog->data->sha1, &size);
+      if (buffer)
+         shader_cache_mem_put(prog->data->sha1, buffer, size);
+   }
    if (buffer == NULL) {
       /* Cached program not found. We may have seen the individual shaders
        * before and skipped compiling but they may not have been used together
@@ -230,8 +354,8 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
 
    if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
       _mesa_sha1_format(sha1buf, prog->data->sha1);
-      fprintf(stderr, "loading shader program meta data from cache: %s\n",
-              sha1buf);
+      fprintf(stderr, "loading shader program meta data from %s cache: %s\n",
+              from_mem ? "memory" : "disk", sha1buf);
    }
 
    struct blob_reader metadata;
@@ -250,6 +374,7 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
                  "cache item)\n");
       }
 
+      mem_cache_remove(prog->data->sha1);
       disk_cache_remove(cache, prog->data->sha1);
       compile_shaders(ctx, prog);
       free(buffer);
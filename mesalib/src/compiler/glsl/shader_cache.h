@@ -37,4 +37,16 @@ bool
 shader_cache_read_program_metadata(struct gl_context *ctx,
                                    struct gl_shader_program *prog);
 
+/**
+ * Process-wide memory store consulted before the disk cache.
+ *
+ * Items are shared by all contexts of the process.  shader_cache_mem_get()
+ * returns a malloc'ed copy (like disk_cache_get()) or NULL on a miss.
+ */
+void
+shader_cache_mem_put(const cache_key key, const void *data, size_t size);
+
+void *
+shader_cache_mem_get(const cache_key key, size_t *size);
+
 #endif /* SHADER_CACHE_H */
@@ -99,6 +99,7 @@ struct draw_stage;
 struct draw_pt_front_end;
 struct draw_assembler;
 struct draw_llvm;
+struct draw_vs_threads;
 struct vbuf_render;
 struct tgsi_exec_machine;
 struct tgsi_sampler;
@@ -296,6 +297,10 @@ struct draw_context
          struct tgsi_sampler *sampler;
          struct tgsi_image *image;
          struct tgsi_buffer *buffer;
+
+         /** Started on first use, see draw_vs_thread.c */
+         struct draw_vs_threads *threads;
+         bool threads_checked;
       } tgsi;
 
       struct translate *fetch;
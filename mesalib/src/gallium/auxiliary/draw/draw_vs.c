@@ -41,6 +41,7 @@
 #include "draw_private.h"
 #include "draw_context.h"
 #include "draw_vs.h"
+#include "draw_vs_thread.h"
 
 #include "translate/translate.h"
 #include "translate/translate_cache.h"
@@ -190,8 +191,10 @@ draw_vs_destroy(struct draw_context *draw)
    if (draw->vs.emit_cache)
       translate_cache_destroy(draw->vs.emit_cache);
 
-   if (!draw->llvm)
+   if (!draw->llvm) {
+      draw_vs_threads_destroy(draw);
       tgsi_exec_machine_destroy(draw->vs.tgsi.machine);
+   }
 }
 
 
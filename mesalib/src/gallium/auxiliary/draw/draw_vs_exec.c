@@ -41,15 +41,21 @@
 #include "draw_private.h"
 #include "draw_context.h"
 #include "draw_vs.h"
+#include "draw_vs_thread.h"
 
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_scan.h"
 #include "tgsi/tgsi_exec.h"
 
 
+/** Smallest slice worth handing to another thread */
+#define VS_EXEC_MIN_SLICE 64
+
+
 struct exec_vertex_shader {
    struct draw_vertex_shader base;
    struct tgsi_exec_machine *machine;
+   bool uses_resources;      /**< must run on the context's thread */
 };
 
 
@@ -84,27 +90,25 @@ vs_exec_prepare(struct draw_vertex_shader *shader,
 
 
 /**
- * Simplified vertex shader interface for the pt paths.  Given the
- * complexity of code-generating all the above operations together,
- * it's time to try doing all the other stuff separately.
+ * Shade count vertices, the first of which is vertex number start of the
+ * run, on the given machine.
  */
 static void
-vs_exec_run_linear(struct draw_vertex_shader *shader,
-                   const float (*input)[4],
-                   float (*output)[4],
-                   const struct draw_buffer_info *constants,
-                   unsigned count,
-                   unsigned input_stride,
-                   unsigned output_stride,
-                   const unsigned *fetch_elts)
+vs_exec_run_range(struct draw_vertex_shader *shader,
+                  struct tgsi_exec_machine *machine,
+                  const float (*input)[4],
+                  float (*output)[4],
+                  const struct draw_buffer_info *constants,
+                  unsigned start,
+                  unsigned count,
+                  unsigned input_stride,
+                  unsigned output_stride,
+                  const unsigned *fetch_elts)
 {
-   struct exec_vertex_shader *evs = exec_vertex_shader(shader);
-   struct tgsi_exec_machine *machine = evs->machine;
    unsigned int i, j;
    unsigned slot;
    bool clamp_vertex_color = shader->draw->rasterizer->clamp_vertex_color;
 
-   assert(!shader->draw->llvm);
    tgsi_exec_set_constant_buffers(machine, PIPE_MAX_CONSTANT_BUFFERS,
                                   (const struct tgsi_exec_consts_info *)constants);
 
@@ -115,8 +119,8 @@ vs_exec_run_linear(struct draw_vertex_shader *shader,
          machine->SystemValue[i].xyzw[0].i[j] = shader->draw->instance_id;
    }
 
-   for (i = 0; i < count; i += MAX_TGSI_VERTICES) {
-      unsigned int max_vertices = MIN2(MAX_TGSI_VERTICES, count - i);
+   for (i = start; i < start + count; i += MAX_TGSI_VERTICES) {
+      unsigned int max_vertices = MIN2(MAX_TGSI_VERTICES, start + count - i);
 
       /* Swizzle inputs.
        */
@@ -206,9 +210,106 @@ vs_exec_run_linear(struct draw_vertex_shader *shader,
 }
 
 
+struct vs_exec_job {
+   struct draw_vertex_shader *shader;
+   const float (*input)[4];
+   float (*output)[4];
+   const struct draw_buffer_info *constants;
+   unsigned count;
+   unsigned slice_size;
+   unsigned input_stride;
+   unsigned output_stride;
+   const unsigned *fetch_elts;
+};
+
+
+/* Runs on the context's thread for slice 0, on a worker for the others */
+static void
+vs_exec_run_slice(struct tgsi_exec_machine *machine, unsigned slice,
+                  const void *data)
+{
+   const struct vs_exec_job *job = (const struct vs_exec_job *) data;
+   struct draw_vertex_shader *shader = job->shader;
+   unsigned start = slice * job->slice_size;
+   unsigned count = MIN2(job->slice_size, job->count - start);
+
+   /* Worker machines are bound here; slice 0 was bound by prepare */
+   if (machine->Tokens != shader->state.tokens) {
+      tgsi_exec_machine_bind_shader(machine,
+                                    shader->state.tokens,
+                                    shader->draw->vs.tgsi.sampler,
+                                    shader->draw->vs.tgsi.image,
+                                    shader->draw->vs.tgsi.buffer);
+   }
+
+   vs_exec_run_range(shader, machine,
+                     (const float (*)[4])((const char *)job->input +
+                                          start * job->input_stride),
+                     (float (*)[4])((char *)job->output +
+                                    start * job->output_stride),
+                     job->constants, start, count,
+                     job->input_stride, job->output_stride,
+                     job->fetch_elts);
+}
+
+
+/**
+ * Simplified vertex shader interface for the pt paths.  Given the
+ * complexity of code-generating all the above operations together,
+ * it's time to try doing all the other stuff separately.
+ *
+ * Big runs are split into slices shaded on the draw module's vertex
+ * shader threads.  Shaders that sample or access images or buffers stay
+ * on the context's thread, since the driver's sampler and image objects
+ * (softpipe's texture tile caches in particular) aren't thread safe.
+ */
+static void
+vs_exec_run_linear(struct draw_vertex_shader *shader,
+                   const float (*input)[4],
+                   float (*output)[4],
+                   const struct draw_buffer_info *constants,
+                   unsigned count,
+                   unsigned input_stride,
+                   unsigned output_stride,
+                   const unsigned *fetch_elts)
+{
+   struct exec_vertex_shader *evs = exec_vertex_shader(shader);
+   struct vs_exec_job job;
+   unsigned num_slices = 1;
+
+   assert(!shader->draw->llvm);
+
+   if (count >= 2 * VS_EXEC_MIN_SLICE && !evs->uses_resources) {
+      num_slices = MIN2(draw_vs_threads_max_slices(shader->draw),
+                        count / VS_EXEC_MIN_SLICE);
+   }
+
+   if (num_slices <= 1) {
+      vs_exec_run_range(shader, evs->machine, input, output, constants,
+                        0, count, input_stride, output_stride, fetch_elts);
+      return;
+   }
+
+   job.shader = shader;
+   job.input = input;
+   job.output = output;
+   job.constants = constants;
+   job.count = count;
+   job.slice_size = align(DIV_ROUND_UP(count, num_slices), MAX_TGSI_VERTICES);
+   job.input_stride = input_stride;
+   job.output_stride = output_stride;
+   job.fetch_elts = fetch_elts;
+
+   draw_vs_threads_run(shader->draw, evs->machine,
+                       DIV_ROUND_UP(count, job.slice_size),
+                       vs_exec_run_slice, &job);
+}
+
+
 static void
 vs_exec_delete(struct draw_vertex_shader *dvs)
 {
+   draw_vs_threads_release(dvs->draw, dvs->state.tokens);
    FREE((void*) dvs->state.tokens);
    FREE(dvs);
 }
@@ -240,6 +341,13 @@ draw_create_vs_exec(struct draw_context *draw,
 
    tgsi_scan_shader(vs->base.state.tokens, &vs->base.info);
 
+   vs->uses_resources = vs->base.info.file_count[TGSI_FILE_SAMPLER] ||
+                        vs->base.info.file_count[TGSI_FILE_SAMPLER_VIEW] ||
+                        vs->base.info.file_count[TGSI_FILE_IMAGE] ||
+                        vs->base.info.file_count[TGSI_FILE_BUFFER] ||
+                        vs->base.info.file_count[TGSI_FILE_HW_ATOMIC] ||
+                        vs->base.info.file_count[TGSI_FILE_MEMORY];
+
    vs->base.state.stream_output = state->stream_output;
    vs->base.draw = draw;
    vs->base.prepare = vs_exec_prepare;
@@ -0,0 +1,258 @@
+/*
+ * Copyright © 2026 Mesa contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Vertex shader thread pool.  See draw_vs_thread.h for the overall scheme.
+ *
+ * The pool is only started the first time a run is big enough to be
+ * split, so draw contexts that never see large draws (or that use llvm)
+ * never create threads.  While a job is running the context's thread
+ * shades slice 0 and then waits, so the shader, constants and vertex
+ * buffers the workers read stay put.
+ */
+
+#include <stdio.h>
+
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "util/u_thread.h"
+#include "tgsi/tgsi_exec.h"
+
+#include "draw_private.h"
+#include "draw_vs_thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+struct draw_vs_thread {
+   struct draw_vs_threads *pool;
+   unsigned index;
+
+   util_semaphore work_ready;
+   util_semaphore work_done;
+
+   struct tgsi_exec_machine *machine;
+};
+
+
+struct draw_vs_threads {
+   unsigned num_threads;
+   thrd_t threads[DRAW_VS_MAX_THREADS];
+   struct draw_vs_thread thread[DRAW_VS_MAX_THREADS];
+
+   /** The current job */
+   draw_vs_thread_func func;
+   const void *data;
+
+   bool exit_flag;
+};
+
+
+static int
+draw_vs_thread_main(void *init_data)
+{
+   struct draw_vs_thread *thread = (struct draw_vs_thread *) init_data;
+   struct draw_vs_threads *pool = thread->pool;
+   char thread_name[16];
+
+   snprintf(thread_name, sizeof thread_name, "draw-vs-%u", thread->index);
+   u_thread_setname(thread_name);
+
+   while (1) {
+      util_semaphore_wait(&thread->work_ready);
+
+      if (pool->exit_flag)
+         break;
+
+      /* worker i shades slice i + 1, slice 0 is the context's */
+      pool->func(thread->machine, thread->index + 1, pool->data);
+
+      util_semaphore_signal(&thread->work_done);
+   }
+
+#ifdef _WIN32
+   util_semaphore_signal(&thread->work_done);
+#endif
+
+   return 0;
+}
+
+
+static void
+draw_vs_threads_free(struct draw_vs_threads *pool)
+{
+   unsigned i;
+
+   /* Same shutdown as the softpipe raster threads: on Windows the threads
+    * may already be gone when this runs from process exit.
+    */
+   pool->exit_flag = true;
+   for (i = 0; i < pool->num_threads; i++)
+      util_semaphore_signal(&pool->thread[i].work_ready);
+
+   for (i = 0; i < pool->num_threads; i++) {
+#ifdef _WIN32
+      DWORD exit_code = STILL_ACTIVE;
+      if (GetExitCodeThread(pool->threads[i].handle, &exit_code) &&
+          exit_code == STILL_ACTIVE) {
+         util_semaphore_wait(&pool->thread[i].work_done);
+      }
+#else
+      thrd_join(pool->threads[i], NULL);
+#endif
+   }
+
+   for (i = 0; i < pool->num_threads; i++) {
+      util_semaphore_destroy(&pool->thread[i].work_ready);
+      util_semaphore_destroy(&pool->thread[i].work_done);
+   }
+
+   for (i = 0; i < DRAW_VS_MAX_THREADS; i++) {
+      if (pool->thread[i].machine)
+         tgsi_exec_machine_destroy(pool->thread[i].machine);
+   }
+
+   FREE(pool);
+}
+
+
+/**
+ * Start the workers.  Returns NULL (shade on the context's thread) when
+ * DRAW_NUM_THREADS or the CPU count is <= 1.
+ */
+static struct draw_vs_threads *
+draw_vs_threads_create(void)
+{
+   struct draw_vs_threads *pool;
+   unsigned num_threads, i;
+
+   num_threads = util_get_cpu_caps()->nr_cpus;
+   num_threads = debug_get_num_option("DRAW_NUM_THREADS", num_threads);
+   num_threads = MIN2(num_threads, DRAW_VS_MAX_THREADS + 1);
+   if (num_threads <= 1)
+      return NULL;
+
+   pool = CALLOC_STRUCT(draw_vs_threads);
+   if (!pool)
+      return NULL;
+
+   /* the context's thread shades too */
+   num_threads--;
+
+   for (i = 0; i < num_threads; i++) {
+      struct draw_vs_thread *thread = &pool->thread[i];
+
+      thread->pool = pool;
+      thread->index = i;
+      thread->machine = tgsi_exec_machine_create(PIPE_SHADER_VERTEX);
+      if (!thread->machine)
+         break;
+
+      util_semaphore_init(&thread->work_ready, 0);
+      util_semaphore_init(&thread->work_done, 0);
+      if (thrd_success != u_thread_create(pool->threads + i,
+                                          draw_vs_thread_main,
+                                          (void *) thread)) {
+         util_semaphore_destroy(&thread->work_ready);
+         util_semaphore_destroy(&thread->work_done);
+         break;
+      }
+      pool->num_threads++;
+   }
+
+   /* Slices are handed out per job, so fewer workers is fine */
+   if (!pool->num_threads) {
+      draw_vs_threads_free(pool);
+      return NULL;
+   }
+
+   return pool;
+}
+
+
+/**
+ * How many slices a run may be cut into, 1 if it can't be split.
+ */
+unsigned
+draw_vs_threads_max_slices(struct draw_context *draw)
+{
+   if (!draw->vs.tgsi.threads_checked) {
+      draw->vs.tgsi.threads = draw_vs_threads_create();
+      draw->vs.tgsi.threads_checked = true;
+   }
+
+   return draw->vs.tgsi.threads ? draw->vs.tgsi.threads->num_threads + 1 : 1;
+}
+
+
+/**
+ * Shade num_slices slices, at most draw_vs_threads_max_slices(), and wait
+ * for all of them.
+ */
+void
+draw_vs_threads_run(struct draw_context *draw,
+                    struct tgsi_exec_machine *machine,
+                    unsigned num_slices,
+                    draw_vs_thread_func func, const void *data)
+{
+   struct draw_vs_threads *pool = draw->vs.tgsi.threads;
+   unsigned i;
+
+   assert(num_slices >= 1);
+
+   if (!pool || num_slices == 1) {
+      for (i = 0; i < num_slices; i++)
+         func(machine, i, data);
+      return;
+   }
+
+   assert(num_slices <= pool->num_threads + 1);
+
+   pool->func = func;
+   pool->data = data;
+
+   for (i = 0; i < num_slices - 1; i++)
+      util_semaphore_signal(&pool->thread[i].work_ready);
+
+   func(machine, 0, data);
+
+   for (i = 0; i < num_slices - 1; i++)
+      util_semaphore_wait(&pool->thread[i].work_done);
+}
+
+
+/**
+ * Called when a shader is deleted, so that a new shader allocated at the
+ * same address isn't mistaken for the one still bound to a worker machine.
+ */
+void
+draw_vs_threads_release(struct draw_context *draw,
+                        const struct tgsi_token *tokens)
+{
+   struct draw_vs_threads *pool = draw->vs.tgsi.threads;
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   for (i = 0; i < pool->num_threads; i++) {
+      if (pool->thread[i].machine->Tokens == tokens)
+         pool->thread[i].machine->Tokens = NULL;
+   }
+}
+
+
+void
+draw_vs_threads_destroy(struct draw_context *draw)
+{
+   if (draw->vs.tgsi.threads)
+      draw_vs_threads_free(draw->vs.tgsi.threads);
+
+   draw->vs.tgsi.threads = NULL;
+   draw->vs.tgsi.threads_checked = false;
+}
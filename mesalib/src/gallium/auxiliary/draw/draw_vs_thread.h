@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2026 Mesa contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Vertex shader threads for the TGSI interpreter.
+ *
+ * A linear run of the vertex shader (one vsplit segment, up to 1024
+ * vertices) is cut into slices which are shaded at the same time, each on
+ * its own tgsi_exec_machine.  Every slice reads and writes a fixed range
+ * of the vertex buffers, so the results land exactly where the serial loop
+ * would have put them and clipping and primitive emission, which still run
+ * on the context's thread afterwards, see the vertices in their original
+ * order.
+ */
+
+#ifndef DRAW_VS_THREAD_H
+#define DRAW_VS_THREAD_H
+
+struct draw_context;
+struct tgsi_exec_machine;
+struct tgsi_token;
+
+
+#define DRAW_VS_MAX_THREADS 8
+
+
+/**
+ * Shade one slice.  Slice 0 runs on the context's thread with the
+ * context's machine, the others on a worker with the worker's machine.
+ */
+typedef void (*draw_vs_thread_func)(struct tgsi_exec_machine *machine,
+                                    unsigned slice, const void *data);
+
+
+unsigned
+draw_vs_threads_max_slices(struct draw_context *draw);
+
+void
+draw_vs_threads_run(struct draw_context *draw,
+                    struct tgsi_exec_machine *machine,
+                    unsigned num_slices,
+                    draw_vs_thread_func func, const void *data);
+
+void
+draw_vs_threads_release(struct draw_context *draw,
+                        const struct tgsi_token *tokens);
+
+void
+draw_vs_threads_destroy(struct draw_context *draw);
+
+
+#endif /* DRAW_VS_THREAD_H */
@@ -61,6 +61,7 @@
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/os_time.h"
 #include "util/u_sampler.h"
 #include "util/u_simple_shaders.h"
 #include "util/u_string.h"
@@ -663,6 +664,84 @@ done:
    pipe_surface_reference(&surf, NULL);
 }
 
+/**
+ * If the GALLIUM_HUD_CSV env var is set, append the values of all graphs
+ * to that file, one line whenever any of them was updated.  All contexts
+ * of a process share the file; the second column tells them apart.
+ */
+static void
+hud_csv_open(struct hud_context *hud)
+{
+   static unsigned num_csv_huds;
+   const char *path = getenv("GALLIUM_HUD_CSV");
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+   unsigned num_graphs = 0, i;
+
+   if (!path || !*path)
+      return;
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      num_graphs += pane->num_graphs;
+   }
+   if (!num_graphs)
+      return;
+
+   hud->csv_graphs = MALLOC(num_graphs * sizeof(*hud->csv_graphs));
+   if (!hud->csv_graphs)
+      return;
+
+   hud->csv = fopen(path, "a");
+   if (!hud->csv) {
+      fprintf(stderr, "gallium_hud: can't open %s for writing\n", path);
+      FREE(hud->csv_graphs);
+      hud->csv_graphs = NULL;
+      return;
+   }
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         hud->csv_graphs[hud->csv_num_graphs++] = gr;
+      }
+   }
+   hud->csv_id = p_atomic_inc_return(&num_csv_huds);
+
+   fseek(hud->csv, 0, SEEK_END);
+   if (ftell(hud->csv) == 0) {
+      fprintf(hud->csv, "time,context");
+      for (i = 0; i < hud->csv_num_graphs; i++)
+         fprintf(hud->csv, ",%s", hud->csv_graphs[i]->name);
+      fprintf(hud->csv, "\n");
+      fflush(hud->csv);
+   }
+}
+
+static void
+hud_csv_write_row(struct hud_context *hud)
+{
+   unsigned i;
+
+   fprintf(hud->csv, "%.3f,%u", os_time_get() / 1000000.0, hud->csv_id);
+   for (i = 0; i < hud->csv_num_graphs; i++)
+      fprintf(hud->csv, ",%g", hud->csv_graphs[i]->current_value);
+   fprintf(hud->csv, "\n");
+
+   /* whole lines only, other contexts may be appending too */
+   fflush(hud->csv);
+   hud->csv_new_values = false;
+}
+
+static void
+hud_csv_close(struct hud_context *hud)
+{
+   if (hud->csv)
+      fclose(hud->csv);
+   FREE(hud->csv_graphs);
+   hud->csv = NULL;
+   hud->csv_graphs = NULL;
+   hud->csv_num_graphs = 0;
+}
+
 static void
 hud_start_queries(struct hud_context *hud, struct pipe_context *pipe)
 {
@@ -748,6 +827,9 @@ hud_stop_queries(struct hud_context *hud, struct pipe_context *pipe)
          hud_pane_accumulate_vertices(hud, pane);
    }
 
+   if (hud->csv && hud->csv_new_values)
+      hud_csv_write_row(hud);
+
    /* unmap the uploader's vertex buffer before drawing */
    u_upload_unmap(pipe->stream_uploader);
 }
@@ -995,6 +1077,7 @@ void
 hud_graph_add_value(struct hud_graph *gr, double value)
 {
    gr->current_value = value;
+   gr->pane->hud->csv_new_values = true;
    value = value > gr->pane->ceiling ? gr->pane->ceiling : value;
 
    if (gr->fd) {
@@ -1555,6 +1638,8 @@ hud_parse_env_var(struct hud_context *hud, struct pipe_screen *screen,
          }
       }
    }
+
+   hud_csv_open(hud);
 }
 
 static void
@@ -1854,6 +1939,8 @@ hud_unset_record_context(struct hud_context *hud)
    if (!pipe)
       return;
 
+   hud_csv_close(hud);
+
    LIST_FOR_EACH_ENTRY_SAFE(pane, pane_tmp, &hud->pane_list, head) {
       LIST_FOR_EACH_ENTRY_SAFE(graph, graph_tmp, &pane->graph_list, head) {
          list_del(&graph->head);
@@ -101,6 +101,13 @@ struct hud_context {
    } text, bg, whitelines;
 
    bool has_srgb;
+
+   /* GALLIUM_HUD_CSV log, see hud_csv_open() */
+   FILE *csv;
+   unsigned csv_id;
+   bool csv_new_values;
+   struct hud_graph **csv_graphs;  /* columns, the panes may re-sort theirs */
+   unsigned csv_num_graphs;
 };
 
 struct hud_graph {
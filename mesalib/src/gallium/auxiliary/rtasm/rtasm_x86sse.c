@@ -1005,6 +1005,15 @@ void sse_divss( struct x86_function *p,
    emit_modrm( p, dst, src );
 }
 
+void sse_divps( struct x86_function *p,
+                struct x86_reg dst,
+                struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_2ub(p, X86_TWOB, 0x5E);
+   emit_modrm( p, dst, src );
+}
+
 void sse_minps( struct x86_function *p,
                 struct x86_reg dst,
                 struct x86_reg src )
@@ -1086,6 +1095,15 @@ void sse_rsqrtps( struct x86_function *p,
    emit_modrm( p, dst, src );
 }
 
+void sse_sqrtps( struct x86_function *p,
+                 struct x86_reg dst,
+                 struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_2ub(p, X86_TWOB, 0x51);
+   emit_modrm( p, dst, src );
+}
+
 void sse_rsqrtss( struct x86_function *p,
                   struct x86_reg dst,
                   struct x86_reg src )
@@ -1517,6 +1535,15 @@ void sse2_pcmpgtd(struct x86_function *p,
    emit_modrm(p, dst, src);
 }
 
+void sse2_psubd(struct x86_function *p,
+                struct x86_reg dst,
+                struct x86_reg src)
+{
+   DUMP_RR(dst, src);
+   emit_3ub(p, 0x66, X86_TWOB, 0xFA);
+   emit_modrm(p, dst, src);
+}
+
 /***********************************************************************
  * x87 instructions
  */
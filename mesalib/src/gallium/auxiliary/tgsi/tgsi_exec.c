@@ -58,6 +58,7 @@
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_util.h"
 #include "tgsi_exec.h"
+#include "tgsi_sse.h"
 #include "util/compiler.h"
 #include "util/half_float.h"
 #include "util/u_memory.h"
@@ -1054,6 +1055,9 @@ tgsi_exec_machine_bind_shader(
    mach->Image = image;
    mach->Buffer = buffer;
 
+   tgsi_sse_put_shader(mach->SseShader);
+   mach->SseShader = NULL;
+
    if (!tokens) {
       /* unbind and free all */
       FREE(mach->Declarations);
@@ -1214,6 +1218,9 @@ tgsi_exec_machine_bind_shader(
    FREE(mach->Instructions);
    mach->Instructions = instructions;
    mach->NumInstructions = numInstructions;
+
+   if (mach->ShaderType == PIPE_SHADER_FRAGMENT)
+      mach->SseShader = tgsi_sse_get_shader(mach);
 }
 
 
@@ -1266,6 +1273,7 @@ void
 tgsi_exec_machine_destroy(struct tgsi_exec_machine *mach)
 {
    if (mach) {
+      tgsi_sse_put_shader(mach->SseShader);
       FREE(mach->Instructions);
       FREE(mach->Declarations);
       FREE(mach->Imms);
@@ -6008,6 +6016,9 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach, int start_pc )
       for (i = 0; i < mach->NumDeclarations; i++) {
          exec_declaration( mach, mach->Declarations+i );
       }
+
+      if (mach->SseShader && tgsi_sse_run(mach->SseShader, mach))
+         return ~mach->KillMask;
    }
 
    {
@@ -412,6 +412,9 @@ tgsi_exec_machine
    struct tgsi_full_instruction *Instructions;
    unsigned NumInstructions;
 
+   /** Native code for the instructions, if they could be compiled */
+   struct tgsi_sse_shader *SseShader;
+
    struct tgsi_full_declaration *Declarations;
    unsigned NumDeclarations;
 
@@ -0,0 +1,580 @@
+/*
+ * Copyright © 2026 Mesa contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Native code for straight-line TGSI fragment shaders on x86-64.
+ *
+ * Most fragment shaders that softpipe sees are a short run of arithmetic
+ * on interpolated inputs, constants and immediates, but the interpreter
+ * pays for a function call, a swizzle lookup and a register file switch
+ * on every channel of every operand.  Shaders made only of the opcodes
+ * below are compiled once into a function that works on the whole quad
+ * with one SSE instruction per channel, and tgsi_exec_machine_run() calls
+ * that instead of the interpreter loop.  Anything else -- texturing, flow
+ * control, KILL, integer ops, indirect addressing -- is left to the
+ * interpreter.
+ *
+ * The code keeps the machine in rbx and the input, output and immediate
+ * arrays in rsi, rdi and rbp.  An instruction computes every channel it
+ * writes into xmm0-xmm3 before storing any of them, so a destination that
+ * is also a source is handled like the interpreter does it.  Only xmm0-5
+ * are used since the rest are callee-saved on Win64 and rtasm has no REX
+ * encodings for xmm8 and up.
+ *
+ * Softpipe's raster threads each bind their own machine, so compiled
+ * shaders are shared through a small cache keyed on the tokens and
+ * protected by a mutex.  Compiled shaders are refcounted; up to
+ * SSE_CACHE_IDLE of those no machine holds are kept around, along with
+ * the shaders that could not be compiled, and the least recently used are
+ * dropped first.
+ *
+ * GALLIUM_NOSSE=1 turns all of this off.
+ */
+
+#include "util/detect.h"
+
+#if DETECT_ARCH_X86_64
+
+#include <stddef.h>
+#include <string.h>
+
+#include "util/hash_table.h"
+#include "util/list.h"
+#include "util/simple_mtx.h"
+#include "util/u_debug.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "pipe/p_shader_tokens.h"
+#include "rtasm/rtasm_x86sse.h"
+#include "tgsi/tgsi_parse.h"
+#include "tgsi/tgsi_util.h"
+#include "tgsi_exec.h"
+#include "tgsi_sse.h"
+
+#define SSE_CACHE_IDLE 32
+
+DEBUG_GET_ONCE_BOOL_OPTION(tgsi_no_sse, "GALLIUM_NOSSE", false)
+
+typedef void (*tgsi_sse_func)(struct tgsi_exec_machine *mach);
+
+struct tgsi_sse_shader
+{
+   struct list_head link;     /**< in sse_cache, most recently used first */
+   uint32_t hash;
+   struct tgsi_token *tokens;
+   unsigned num_tokens;
+   unsigned refcount;
+
+   struct x86_function func;
+   tgsi_sse_func run;         /**< NULL if the shader can't be compiled */
+
+   /** Bytes of each constant buffer the code reads */
+   unsigned consts_size[PIPE_MAX_CONSTANT_BUFFERS];
+};
+
+static simple_mtx_t sse_cache_mutex = SIMPLE_MTX_INITIALIZER;
+static struct list_head sse_cache = { &sse_cache, &sse_cache };
+static unsigned sse_cache_idle;
+
+#define SSE_MACH     x86_make_reg(file_REG32, reg_BX)
+#define SSE_INPUTS   x86_make_reg(file_REG32, reg_SI)
+#define SSE_OUTPUTS  x86_make_reg(file_REG32, reg_DI)
+#define SSE_IMMS     x86_make_reg(file_REG32, reg_BP)
+#define SSE_TMP      x86_make_reg(file_REG32, reg_AX)
+
+#define SSE_SCRATCH0 4
+#define SSE_SCRATCH1 5
+
+static struct x86_reg
+sse_xmm(unsigned i)
+{
+   return x86_make_reg(file_XMM, i);
+}
+
+/** Address of one channel of a tgsi_exec_vector array */
+static struct x86_reg
+sse_channel(struct x86_reg base, unsigned offset, int index, unsigned chan)
+{
+   return x86_make_disp(base, offset +
+                        index * sizeof(struct tgsi_exec_vector) +
+                        chan * sizeof(union tgsi_exec_channel));
+}
+
+/** Broadcast a 32-bit constant into all four lanes of an xmm register */
+static void
+sse_load_imm(struct x86_function *p, struct x86_reg dst, uint32_t value)
+{
+   x86_mov_imm(p, SSE_TMP, (int) value);
+   sse2_movd(p, dst, SSE_TMP);
+   sse_shufps(p, dst, dst, SHUF(0, 0, 0, 0));
+}
+
+
+static bool
+sse_check_src(const struct tgsi_exec_machine *mach,
+              const struct tgsi_full_src_register *src)
+{
+   const struct tgsi_src_register *reg = &src->Register;
+
+   if (reg->Indirect || reg->Index < 0)
+      return false;
+   if (reg->Dimension &&
+       (reg->File != TGSI_FILE_CONSTANT || src->Dimension.Indirect))
+      return false;
+
+   switch (reg->File) {
+   case TGSI_FILE_TEMPORARY:
+      return reg->Index < TGSI_EXEC_NUM_TEMPS;
+   case TGSI_FILE_INPUT:
+      return reg->Index < PIPE_MAX_SHADER_INPUTS;
+   case TGSI_FILE_OUTPUT:
+      return reg->Index < PIPE_MAX_SHADER_OUTPUTS;
+   case TGSI_FILE_SYSTEM_VALUE:
+      return reg->Index < TGSI_MAX_MISC_INPUTS;
+   case TGSI_FILE_IMMEDIATE:
+      return (unsigned) reg->Index < mach->ImmLimit;
+   case TGSI_FILE_CONSTANT:
+      return !reg->Dimension ||
+             src->Dimension.Index < PIPE_MAX_CONSTANT_BUFFERS;
+   default:
+      return false;
+   }
+}
+
+static bool
+sse_check_inst(const struct tgsi_exec_machine *mach,
+               const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+   unsigned i;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_NOP:
+   case TGSI_OPCODE_END:
+      return true;
+   case TGSI_OPCODE_MOV:
+   case TGSI_OPCODE_ADD:
+   case TGSI_OPCODE_MUL:
+   case TGSI_OPCODE_MAD:
+   case TGSI_OPCODE_MIN:
+   case TGSI_OPCODE_MAX:
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+      break;
+   case TGSI_OPCODE_LRP:
+      /* src2 is loaded into the register abs and negate need */
+      if (inst->Src[2].Register.Absolute || inst->Src[2].Register.Negate)
+         return false;
+      break;
+   default:
+      return false;
+   }
+
+   if (inst->Instruction.NumDstRegs != 1 ||
+       dst->Register.Indirect || dst->Register.Dimension ||
+       dst->Register.Index < 0)
+      return false;
+   switch (dst->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      if (dst->Register.Index >= TGSI_EXEC_NUM_TEMPS)
+         return false;
+      break;
+   case TGSI_FILE_OUTPUT:
+      if (dst->Register.Index >= PIPE_MAX_SHADER_OUTPUTS)
+         return false;
+      break;
+   default:
+      return false;
+   }
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++)
+      if (!sse_check_src(mach, &inst->Src[i]))
+         return false;
+   return true;
+}
+
+
+/** Load one channel of a source operand, with its modifiers, into dst */
+static void
+sse_fetch(struct tgsi_sse_shader *shader, struct x86_function *p,
+          struct x86_reg dst, const struct tgsi_full_src_register *src,
+          unsigned chan)
+{
+   const struct tgsi_src_register *reg = &src->Register;
+   const unsigned swizzle = tgsi_util_get_full_src_register_swizzle(src, chan);
+   unsigned d;
+
+   switch (reg->File) {
+   case TGSI_FILE_TEMPORARY:
+      sse_movups(p, dst, sse_channel(SSE_MACH,
+                                     offsetof(struct tgsi_exec_machine, Temps),
+                                     reg->Index, swizzle));
+      break;
+   case TGSI_FILE_INPUT:
+      sse_movups(p, dst, sse_channel(SSE_INPUTS, 0, reg->Index, swizzle));
+      break;
+   case TGSI_FILE_OUTPUT:
+      sse_movups(p, dst, sse_channel(SSE_OUTPUTS, 0, reg->Index, swizzle));
+      break;
+   case TGSI_FILE_SYSTEM_VALUE:
+      sse_movups(p, dst,
+                 sse_channel(SSE_MACH,
+                             offsetof(struct tgsi_exec_machine, SystemValue),
+                             reg->Index, swizzle));
+      break;
+   case TGSI_FILE_IMMEDIATE:
+      sse_movss(p, dst, x86_make_disp(SSE_IMMS, (reg->Index * 4 + swizzle) *
+                                      sizeof(float)));
+      sse_shufps(p, dst, dst, SHUF(0, 0, 0, 0));
+      break;
+   case TGSI_FILE_CONSTANT:
+      d = reg->Dimension ? src->Dimension.Index : 0;
+      x64_mov64(p, SSE_TMP,
+                x86_make_disp(SSE_MACH,
+                              offsetof(struct tgsi_exec_machine, Consts) +
+                              d * sizeof(const void *)));
+      sse_movss(p, dst, x86_make_disp(SSE_TMP, (reg->Index * 4 + swizzle) *
+                                      sizeof(float)));
+      sse_shufps(p, dst, dst, SHUF(0, 0, 0, 0));
+      shader->consts_size[d] = MAX2(shader->consts_size[d],
+                                    (reg->Index * 4 + swizzle + 1) *
+                                    sizeof(float));
+      break;
+   default:
+      assert(0);
+   }
+
+   if (reg->Absolute) {
+      sse_load_imm(p, sse_xmm(SSE_SCRATCH1), 0x7fffffff);
+      sse_andps(p, dst, sse_xmm(SSE_SCRATCH1));
+   }
+   if (reg->Negate) {
+      sse_load_imm(p, sse_xmm(SSE_SCRATCH1), 0x80000000);
+      sse_xorps(p, dst, sse_xmm(SSE_SCRATCH1));
+   }
+}
+
+static void
+sse_store(struct x86_function *p, struct x86_reg src,
+          const struct tgsi_full_instruction *inst, unsigned chan)
+{
+   const struct tgsi_dst_register *reg = &inst->Dst[0].Register;
+
+   if (inst->Instruction.Saturate) {
+      /* maxps returns its second operand for NaN, like fmaxf(NaN, 0) */
+      sse_xorps(p, sse_xmm(SSE_SCRATCH1), sse_xmm(SSE_SCRATCH1));
+      sse_maxps(p, src, sse_xmm(SSE_SCRATCH1));
+      sse_load_imm(p, sse_xmm(SSE_SCRATCH1), fui(1.0f));
+      sse_minps(p, src, sse_xmm(SSE_SCRATCH1));
+   }
+
+   if (reg->File == TGSI_FILE_TEMPORARY)
+      sse_movups(p, sse_channel(SSE_MACH,
+                                offsetof(struct tgsi_exec_machine, Temps),
+                                reg->Index, chan), src);
+   else
+      sse_movups(p, sse_channel(SSE_OUTPUTS, 0, reg->Index, chan), src);
+}
+
+/** Per-channel ops: dst.chan = op(src0.chan, src1.chan, src2.chan) */
+static void
+sse_emit_vector(struct tgsi_sse_shader *shader, struct x86_function *p,
+                const struct tgsi_full_instruction *inst, unsigned chan)
+{
+   const struct tgsi_full_src_register *src = inst->Src;
+   struct x86_reg r = sse_xmm(chan);
+   struct x86_reg t0 = sse_xmm(SSE_SCRATCH0);
+   struct x86_reg t1 = sse_xmm(SSE_SCRATCH1);
+
+   sse_fetch(shader, p, r, &src[0], chan);
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+      break;
+   case TGSI_OPCODE_ADD:
+      sse_fetch(shader, p, t0, &src[1], chan);
+      sse_addps(p, r, t0);
+      break;
+   case TGSI_OPCODE_MUL:
+      sse_fetch(shader, p, t0, &src[1], chan);
+      sse_mulps(p, r, t0);
+      break;
+   case TGSI_OPCODE_MAD:
+      sse_fetch(shader, p, t0, &src[1], chan);
+      sse_mulps(p, r, t0);
+      sse_fetch(shader, p, t0, &src[2], chan);
+      sse_addps(p, r, t0);
+      break;
+   case TGSI_OPCODE_MIN:
+      sse_fetch(shader, p, t0, &src[1], chan);
+      sse_minps(p, r, t0);
+      break;
+   case TGSI_OPCODE_MAX:
+      sse_fetch(shader, p, t0, &src[1], chan);
+      sse_maxps(p, r, t0);
+      break;
+   case TGSI_OPCODE_LRP:
+      /* src0 * (src1 - src2) + src2, src2 without modifiers */
+      sse_fetch(shader, p, t0, &src[1], chan);
+      sse_fetch(shader, p, t1, &src[2], chan);
+      sse_subps(p, t0, t1);
+      sse_mulps(p, r, t0);
+      sse_addps(p, r, t1);
+      break;
+   default:
+      assert(0);
+   }
+}
+
+/**
+ * Compute the result of an instruction whose value is the same in every
+ * channel into xmm0.
+ */
+static void
+sse_emit_scalar(struct tgsi_sse_shader *shader, struct x86_function *p,
+                const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_src_register *src = inst->Src;
+   struct x86_reg r = sse_xmm(0);
+   struct x86_reg t0 = sse_xmm(SSE_SCRATCH0);
+   unsigned n, chan;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+      n = inst->Instruction.Opcode == TGSI_OPCODE_DP2 ? 2 :
+          inst->Instruction.Opcode == TGSI_OPCODE_DP3 ? 3 : 4;
+      sse_fetch(shader, p, r, &src[0], TGSI_CHAN_X);
+      sse_fetch(shader, p, t0, &src[1], TGSI_CHAN_X);
+      sse_mulps(p, r, t0);
+      for (chan = TGSI_CHAN_Y; chan < n; chan++) {
+         sse_fetch(shader, p, t0, &src[0], chan);
+         sse_fetch(shader, p, sse_xmm(1), &src[1], chan);
+         sse_mulps(p, t0, sse_xmm(1));
+         sse_addps(p, r, t0);
+      }
+      break;
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+      sse_fetch(shader, p, t0, &src[0], TGSI_CHAN_X);
+      if (inst->Instruction.Opcode == TGSI_OPCODE_RSQ)
+         sse_sqrtps(p, t0, t0);
+      /* divps rather than rcpps/rsqrtps, which are only good to 12 bits */
+      sse_load_imm(p, r, fui(1.0f));
+      sse_divps(p, r, t0);
+      break;
+   default:
+      assert(0);
+   }
+}
+
+static void
+sse_emit_inst(struct tgsi_sse_shader *shader, struct x86_function *p,
+              const struct tgsi_full_instruction *inst)
+{
+   const unsigned writemask = inst->Dst[0].Register.WriteMask;
+   unsigned chan;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_NOP:
+   case TGSI_OPCODE_END:
+      return;
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+      if (!writemask)
+         return;
+      sse_emit_scalar(shader, p, inst);
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+         if (writemask & (1 << chan))
+            sse_store(p, sse_xmm(0), inst, chan);
+      return;
+   default:
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+         if (writemask & (1 << chan))
+            sse_emit_vector(shader, p, inst, chan);
+      break;
+   }
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+      if (writemask & (1 << chan))
+         sse_store(p, sse_xmm(chan), inst, chan);
+}
+
+static bool
+sse_compile(struct tgsi_sse_shader *shader,
+            const struct tgsi_exec_machine *mach)
+{
+   struct x86_function *p = &shader->func;
+   unsigned i;
+
+   for (i = 0; i < mach->NumInstructions; i++)
+      if (!sse_check_inst(mach, &mach->Instructions[i]))
+         return false;
+
+   x86_init_func(p);
+
+   x86_push(p, SSE_MACH);
+   x86_push(p, SSE_IMMS);
+   x86_push(p, SSE_INPUTS);
+   x86_push(p, SSE_OUTPUTS);
+
+   x64_mov64(p, SSE_MACH, x86_fn_arg(p, 1));
+   x64_mov64(p, SSE_INPUTS,
+             x86_make_disp(SSE_MACH,
+                           offsetof(struct tgsi_exec_machine, Inputs)));
+   x64_mov64(p, SSE_OUTPUTS,
+             x86_make_disp(SSE_MACH,
+                           offsetof(struct tgsi_exec_machine, Outputs)));
+   x64_mov64(p, SSE_IMMS,
+             x86_make_disp(SSE_MACH,
+                           offsetof(struct tgsi_exec_machine, Imms)));
+
+   for (i = 0; i < mach->NumInstructions; i++)
+      sse_emit_inst(shader, p, &mach->Instructions[i]);
+
+   x86_pop(p, SSE_OUTPUTS);
+   x86_pop(p, SSE_INPUTS);
+   x86_pop(p, SSE_IMMS);
+   x86_pop(p, SSE_MACH);
+   x86_ret(p);
+
+   shader->run = (tgsi_sse_func) x86_get_func(p);
+   return shader->run != NULL;
+}
+
+
+static void
+sse_free_shader(struct tgsi_sse_shader *shader)
+{
+   list_del(&shader->link);
+   x86_release_func(&shader->func);
+   FREE(shader->tokens);
+   FREE(shader);
+}
+
+/** Drop the least recently used idle shaders.  Called with the lock held. */
+static void
+sse_cache_trim(void)
+{
+   list_for_each_entry_safe_rev(struct tgsi_sse_shader, shader,
+                                &sse_cache, link) {
+      if (sse_cache_idle <= SSE_CACHE_IDLE)
+         break;
+      if (!shader->refcount) {
+         sse_free_shader(shader);
+         sse_cache_idle--;
+      }
+   }
+}
+
+/**
+ * Return the compiled code for the machine's shader, with a reference
+ * held, or NULL if it has to be interpreted.  Call after the shader has
+ * been parsed into the machine by tgsi_exec_machine_bind_shader().
+ */
+struct tgsi_sse_shader *
+tgsi_sse_get_shader(const struct tgsi_exec_machine *mach)
+{
+   struct tgsi_sse_shader *shader;
+   unsigned num_tokens;
+   uint32_t hash;
+
+   if (debug_get_option_tgsi_no_sse() || !mach->Tokens)
+      return NULL;
+
+   num_tokens = tgsi_num_tokens(mach->Tokens);
+   hash = _mesa_hash_data(mach->Tokens, num_tokens * sizeof(struct tgsi_token));
+
+   simple_mtx_lock(&sse_cache_mutex);
+
+   LIST_FOR_EACH_ENTRY(shader, &sse_cache, link) {
+      if (shader->hash == hash && shader->num_tokens == num_tokens &&
+          !memcmp(shader->tokens, mach->Tokens,
+                  num_tokens * sizeof(struct tgsi_token)))
+         goto found;
+   }
+
+   shader = CALLOC_STRUCT(tgsi_sse_shader);
+   if (shader)
+      shader->tokens = tgsi_dup_tokens(mach->Tokens);
+   if (!shader || !shader->tokens) {
+      FREE(shader);
+      simple_mtx_unlock(&sse_cache_mutex);
+      return NULL;
+   }
+   shader->hash = hash;
+   shader->num_tokens = num_tokens;
+   if (!sse_compile(shader, mach)) {
+      x86_release_func(&shader->func);
+      shader->run = NULL;
+   }
+   list_add(&shader->link, &sse_cache);
+   sse_cache_idle++;
+
+found:
+   list_move_to(&shader->link, &sse_cache);
+   if (shader->run) {
+      if (shader->refcount++ == 0)
+         sse_cache_idle--;
+   }
+   sse_cache_trim();
+
+   simple_mtx_unlock(&sse_cache_mutex);
+   return shader->run ? shader : NULL;
+}
+
+void
+tgsi_sse_put_shader(struct tgsi_sse_shader *shader)
+{
+   if (!shader)
+      return;
+
+   simple_mtx_lock(&sse_cache_mutex);
+   assert(shader->refcount);
+   if (--shader->refcount == 0) {
+      sse_cache_idle++;
+      sse_cache_trim();
+   }
+   simple_mtx_unlock(&sse_cache_mutex);
+}
+
+/**
+ * Run the compiled shader on the machine, whose declarations have been
+ * executed.  Returns false, having done nothing, if a constant buffer the
+ * code reads is missing or too small so the interpreter has to take care
+ * of the bounds.
+ */
+bool
+tgsi_sse_run(const struct tgsi_sse_shader *shader,
+             struct tgsi_exec_machine *mach)
+{
+   unsigned d;
+
+   for (d = 0; d < PIPE_MAX_CONSTANT_BUFFERS; d++) {
+      if (shader->consts_size[d] &&
+          (!mach->Consts[d] || mach->ConstsSize[d] < shader->consts_size[d]))
+         return false;
+   }
+
+   shader->run(mach);
+   return true;
+}
+
+#else
+
+void tgsi_sse_dummy(void);
+
+void tgsi_sse_dummy(void)
+{
+}
+
+#endif /* DETECT_ARCH_X86_64 */
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2026 Mesa contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Native code for straight-line TGSI fragment shaders on x86-64.
+ */
+
+#ifndef TGSI_SSE_H
+#define TGSI_SSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "util/detect.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+struct tgsi_exec_machine;
+struct tgsi_sse_shader;
+
+#if DETECT_ARCH_X86_64
+
+struct tgsi_sse_shader *
+tgsi_sse_get_shader(const struct tgsi_exec_machine *mach);
+
+void
+tgsi_sse_put_shader(struct tgsi_sse_shader *shader);
+
+bool
+tgsi_sse_run(const struct tgsi_sse_shader *shader,
+             struct tgsi_exec_machine *mach);
+
+#else
+
+static inline struct tgsi_sse_shader *
+tgsi_sse_get_shader(const struct tgsi_exec_machine *mach)
+{
+   return NULL;
+}
+
+static inline void
+tgsi_sse_put_shader(struct tgsi_sse_shader *shader)
+{
+}
+
+static inline bool
+tgsi_sse_run(const struct tgsi_sse_shader *shader,
+             struct tgsi_exec_machine *mach)
+{
+   return false;
+}
+
+#endif
+
+#if defined __cplusplus
+}
+#endif
+
+#endif /* TGSI_SSE_H */
@@ -64,8 +64,8 @@ struct translate_buffer_variant
 
 #define ELEMENT_BUFFER_INSTANCE_ID  1001
 
-#define NUM_FLOAT_CONSTS 9
-#define NUM_UNSIGNED_CONSTS 1
+#define NUM_FLOAT_CONSTS 12
+#define NUM_UNSIGNED_CONSTS 8
 
 enum
 {
@@ -78,8 +78,18 @@ enum
    CONST_INV_4294967295,
    CONST_255,
    CONST_2147483648,
+   CONST_INV_1010102_UNORM,
+   CONST_INV_1010102_SNORM,
+   CONST_1010102_ALPHA_BIAS,
    /* float consts end */
    CONST_2147483647_INT,
+   CONST_1010102_MASK,
+   CONST_1010102_SIGN,
+   CONST_1010102_ALPHA_INT,
+   CONST_HALF_ABS_MASK,
+   CONST_HALF_MAX_INT,
+   CONST_FLOAT_EXP_MASK,
+   CONST_2_POW_112,
 };
 
 #define C(v) {(float)(v), (float)(v), (float)(v), (float)(v)}
@@ -93,14 +103,30 @@ static float consts[NUM_FLOAT_CONSTS][4] = {
    C(1.0 / 4294967295.0),
    C(255.0),
    C(2147483648.0),
+   /* 10_10_10_2 fields are converted where they lie in the dword */
+   {(float)(1.0 / 1023.0), (float)(1.0 / (1023.0 * 1024.0)),
+    (float)(1.0 / (1023.0 * 1048576.0)), (float)(1.0 / (3.0 * 1073741824.0))},
+   {(float)(1.0 / 511.0), (float)(1.0 / (511.0 * 1024.0)),
+    (float)(1.0 / (511.0 * 1048576.0)), (float)(1.0 / 1073741824.0)},
+   {0, 0, 0, 2147483648.0f},
 };
 
 #undef C
 
+#define U(v) {(v), (v), (v), (v)}
 static unsigned uconsts[NUM_UNSIGNED_CONSTS][4] = {
-   {0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff},
+   U(0x7fffffff),
+   {0x000003ff, 0x000ffc00, 0x3ff00000, 0xc0000000},
+   {0x00000200, 0x00080000, 0x20000000, 0x80000000},
+   {0, 0, 0, 0x80000000},
+   U(0x7fff0000),
+   U(0x477fe000),                /* 65504.0, the largest finite half */
+   U(0x7f800000),
+   U(0x77800000),                /* 2^112 */
 };
 
+#undef U
+
 struct translate_sse
 {
    struct translate translate;
@@ -471,6 +497,115 @@ emit_memcpy(struct translate_sse *p, struct x86_reg dst, struct x86_reg src,
    }
 }
 
+/*
+ * Whether two channels hold the same kind of value.  Unlike a memcmp this
+ * ignores the channel's shift, which differs between every channel of a
+ * format.
+ */
+static bool
+same_channel_type(const struct util_format_channel_description *a,
+                  const struct util_format_channel_description *b)
+{
+   return a->type == b->type &&
+          a->normalized == b->normalized &&
+          a->pure_integer == b->pure_integer &&
+          a->size == b->size;
+}
+
+
+/*
+ * Convert the 16-bit floats in the low words of data to 32-bit floats in
+ * its lanes, without F16C.  The half's exponent and mantissa are moved to
+ * the top of a float's and the result scaled by 2^112 to rebias the
+ * exponent, which gets denormals right too; Inf and NaN then get the
+ * float's maximum exponent.
+ */
+static void
+emit_half_to_float(struct translate_sse *p, struct x86_reg data)
+{
+   struct x86_reg tmpXMM = x86_make_reg(file_XMM, 1);
+
+   /* tmp = half << 16 */
+   sse_xorps(p->func, tmpXMM, tmpXMM);
+   sse2_punpcklwd(p->func, tmpXMM, data);
+   /* data = exponent and mantissa, tmp = sign */
+   sse_movaps(p->func, data, tmpXMM);
+   sse_andps(p->func, data, get_const(p, CONST_HALF_ABS_MASK));
+   sse_xorps(p->func, tmpXMM, data);
+   sse2_psrld_imm(p->func, data, 3);
+   sse_orps(p->func, data, tmpXMM);
+   sse_mulps(p->func, data, get_const(p, CONST_2_POW_112));
+   /* anything above the largest finite half was Inf or NaN */
+   sse_movaps(p->func, tmpXMM, data);
+   sse_andps(p->func, tmpXMM, get_const(p, CONST_2147483647_INT));
+   sse2_pcmpgtd(p->func, tmpXMM, get_const(p, CONST_HALF_MAX_INT));
+   sse_andps(p->func, tmpXMM, get_const(p, CONST_FLOAT_EXP_MASK));
+   sse_orps(p->func, data, tmpXMM);
+}
+
+
+/*
+ * Packed 10_10_10_2 normalized formats to R32G32B32A32_FLOAT.  The dword is
+ * copied to every lane and each lane keeps its own field in place, so the
+ * fields are converted without per-lane shifts and scaled by per-lane
+ * factors.
+ */
+static bool
+emit_convert_1010102(struct translate_sse *p, enum pipe_format format,
+                     struct x86_reg src, struct x86_reg dst)
+{
+   struct x86_reg dataXMM = x86_make_reg(file_XMM, 0);
+   bool snorm, bgra;
+
+   switch (format) {
+   case PIPE_FORMAT_R10G10B10A2_UNORM:
+      snorm = false;
+      bgra = false;
+      break;
+   case PIPE_FORMAT_B10G10R10A2_UNORM:
+      snorm = false;
+      bgra = true;
+      break;
+   case PIPE_FORMAT_R10G10B10A2_SNORM:
+      snorm = true;
+      bgra = false;
+      break;
+   case PIPE_FORMAT_B10G10R10A2_SNORM:
+      snorm = true;
+      bgra = true;
+      break;
+   default:
+      return false;
+   }
+
+   sse2_movd(p->func, dataXMM, src);
+   sse2_pshufd(p->func, dataXMM, dataXMM, SHUF(0, 0, 0, 0));
+   sse_andps(p->func, dataXMM, get_const(p, CONST_1010102_MASK));
+
+   if (snorm) {
+      /* sign-extend each field as (x ^ sign) - sign */
+      sse_xorps(p->func, dataXMM, get_const(p, CONST_1010102_SIGN));
+      sse2_psubd(p->func, dataXMM, get_const(p, CONST_1010102_SIGN));
+      sse2_cvtdq2ps(p->func, dataXMM, dataXMM);
+      /* not clamped to -1, like translate_generic */
+      sse_mulps(p->func, dataXMM, get_const(p, CONST_INV_1010102_SNORM));
+   }
+   else {
+      /* alpha's top bit is the sign bit; convert it biased and add back */
+      sse_xorps(p->func, dataXMM, get_const(p, CONST_1010102_ALPHA_INT));
+      sse2_cvtdq2ps(p->func, dataXMM, dataXMM);
+      sse_addps(p->func, dataXMM, get_const(p, CONST_1010102_ALPHA_BIAS));
+      sse_mulps(p->func, dataXMM, get_const(p, CONST_INV_1010102_UNORM));
+   }
+
+   if (bgra)
+      sse_shufps(p->func, dataXMM, dataXMM, SHUF(2, 1, 0, 3));
+
+   sse_movups(p->func, dst, dataXMM);
+   return true;
+}
+
+
 static bool
 translate_attr_convert(struct translate_sse *p,
                        const struct translate_element *a,
@@ -492,6 +627,11 @@ translate_attr_convert(struct translate_sse *p,
        || a->input_format == PIPE_FORMAT_NONE)
       return false;
 
+   if ((x86_target_caps(p->func) & X86_SSE2) &&
+       a->output_format == PIPE_FORMAT_R32G32B32A32_FLOAT &&
+       emit_convert_1010102(p, a->input_format, src, dst))
+      return true;
+
    if (input_desc->channel[0].size & 7)
       return false;
 
@@ -499,16 +639,14 @@ translate_attr_convert(struct translate_sse *p,
       return false;
 
    for (i = 1; i < input_desc->nr_channels; ++i) {
-      if (memcmp
-          (&input_desc->channel[i], &input_desc->channel[0],
-           sizeof(input_desc->channel[0])))
+      if (!same_channel_type(&input_desc->channel[i],
+                             &input_desc->channel[0]))
          return false;
    }
 
    for (i = 1; i < output_desc->nr_channels; ++i) {
-      if (memcmp
-          (&output_desc->channel[i], &output_desc->channel[0],
-           sizeof(output_desc->channel[0]))) {
+      if (!same_channel_type(&output_desc->channel[i],
+                             &output_desc->channel[0])) {
          return false;
       }
    }
@@ -654,6 +792,13 @@ translate_attr_convert(struct translate_sse *p,
 
             break;
          case UTIL_FORMAT_TYPE_FLOAT:
+            if (input_desc->channel[0].size == 16) {
+               if (!(x86_target_caps(p->func) & X86_SSE2))
+                  return false;
+               emit_load_sse2(p, dataXMM, src, 2 * input_desc->nr_channels);
+               emit_half_to_float(p, dataXMM);
+               break;
+            }
             if (input_desc->channel[0].size != 32
                 && input_desc->channel[0].size != 64) {
                return false;
@@ -911,8 +1056,8 @@ translate_attr_convert(struct translate_sse *p,
       }
       return true;
    }
-   else if (!memcmp(&output_desc->channel[0], &input_desc->channel[0],
-                    sizeof(output_desc->channel[0]))) {
+   else if (same_channel_type(&output_desc->channel[0],
+                              &input_desc->channel[0])) {
       struct x86_reg tmp = p->tmp_EAX;
       unsigned i;
 
@@ -35,6 +35,9 @@ void
 u_driconf_fill_st_options(struct st_config_options *options,
                           const struct driOptionCache *optionCache);
 
+bool
+u_driconf_use_glthread(const struct driOptionCache *optionCache);
+
 #ifdef __cplusplus
 }
 #endif
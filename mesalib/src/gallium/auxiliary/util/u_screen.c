@@ -548,6 +548,7 @@ u_pipe_screen_get_param_defaults(struct pipe_screen *pscreen,
    case PIPE_CAP_NULL_TEXTURES:
    case PIPE_CAP_ASTC_VOID_EXTENTS_NEED_DENORM_FLUSH:
    case PIPE_CAP_HAS_CONST_BW:
+   case PIPE_CAP_UPLOAD_BUFFER_REUSE:
       return 0;
 
    case PIPE_CAP_PERFORMANCE_MONITOR:
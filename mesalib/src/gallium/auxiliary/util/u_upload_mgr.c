@@ -38,6 +38,16 @@
 #include "u_upload_mgr.h"
 
 
+/* Number of retired upload buffers kept around for reuse. */
+#define U_UPLOAD_MAX_SPARES 4
+
+struct u_upload_spare {
+   struct pipe_resource *buffer;
+   struct pipe_transfer *transfer;
+   uint8_t *map;
+   int idle_refcount;
+};
+
 struct u_upload_mgr {
    struct pipe_context *pipe;
 
@@ -47,6 +57,7 @@ struct u_upload_mgr {
    unsigned flags;
    unsigned map_flags;     /* Bitmask of PIPE_MAP_* flags. */
    bool map_persistent; /* If persistent mappings are supported. */
+   bool reuse;          /* PIPE_CAP_UPLOAD_BUFFER_REUSE */
 
    struct pipe_resource *buffer;   /* Upload buffer. */
    struct pipe_transfer *transfer; /* Transfer object for the upload buffer. */
@@ -55,6 +66,11 @@ struct u_upload_mgr {
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
    int buffer_private_refcount;
+   int buffer_idle_refcount; /* reference.count with no outside users */
+
+   /* Retired buffers, still mapped, waiting for their last user to go. */
+   struct u_upload_spare spares[U_UPLOAD_MAX_SPARES];
+   unsigned num_spares;
 };
 
 
@@ -75,6 +91,8 @@ u_upload_create(struct pipe_context *pipe, unsigned default_size,
    upload->map_persistent =
       pipe->screen->get_param(pipe->screen,
                               PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT);
+   upload->reuse =
+      pipe->screen->get_param(pipe->screen, PIPE_CAP_UPLOAD_BUFFER_REUSE);
 
    if (upload->map_persistent) {
       upload->map_flags = PIPE_MAP_WRITE |
@@ -113,9 +131,22 @@ u_upload_clone(struct pipe_context *pipe, struct u_upload_mgr *upload)
    return result;
 }
 
+static void
+u_upload_release_spares(struct u_upload_mgr *upload)
+{
+   for (unsigned i = 0; i < upload->num_spares; i++) {
+      struct u_upload_spare *spare = &upload->spares[i];
+
+      pipe_buffer_unmap(upload->pipe, spare->transfer);
+      pipe_resource_reference(&spare->buffer, NULL);
+   }
+   upload->num_spares = 0;
+}
+
 void
 u_upload_disable_persistent(struct u_upload_mgr *upload)
 {
+   u_upload_release_spares(upload);
    upload->map_persistent = false;
    upload->map_flags &= ~(PIPE_MAP_COHERENT | PIPE_MAP_PERSISTENT);
    upload->map_flags |= PIPE_MAP_FLUSH_EXPLICIT;
@@ -170,9 +201,86 @@ void
 u_upload_destroy(struct u_upload_mgr *upload)
 {
    u_upload_release_buffer(upload);
+   u_upload_release_spares(upload);
    FREE(upload);
 }
 
+/* Give each future suballocation of the current buffer its reference in
+ * advance.  See the comment in u_upload_alloc_buffer.
+ */
+static void
+u_upload_init_private_refcount(struct u_upload_mgr *upload,
+                               unsigned size, unsigned min_size)
+{
+   u_upload_init_private_refcount(upload, size, min_size);
+}
+
+/* Move the current buffer, still mapped, to the spare list.  If the list
+ * is full, the oldest spare is released.
+ */
+static void
+u_upload_retire_buffer(struct u_upload_mgr *upload)
+{
+   if (upload->buffer_private_refcount) {
+      p_atomic_add(&upload->buffer->reference.count,
+                   -upload->buffer_private_refcount);
+      upload->buffer_private_refcount = 0;
+   }
+
+   if (upload->num_spares == U_UPLOAD_MAX_SPARES) {
+      pipe_buffer_unmap(upload->pipe, upload->spares[0].transfer);
+      pipe_resource_reference(&upload->spares[0].buffer, NULL);
+      memmove(&upload->spares[0], &upload->spares[1],
+              (U_UPLOAD_MAX_SPARES - 1) * sizeof(upload->spares[0]));
+      upload->num_spares--;
+   }
+
+   struct u_upload_spare *spare = &upload->spares[upload->num_spares++];
+   spare->buffer = upload->buffer;
+   spare->transfer = upload->transfer;
+   spare->map = upload->map;
+   spare->idle_refcount = upload->buffer_idle_refcount;
+
+   upload->buffer = NULL;
+   upload->transfer = NULL;
+   upload->map = NULL;
+   upload->buffer_size = 0;
+}
+
+/* Make an idle spare of at least min_size bytes the current buffer.
+ * Return its size or 0 if there is none.
+ */
+static unsigned
+u_upload_reuse_spare(struct u_upload_mgr *upload, unsigned min_size)
+{
+   for (unsigned i = 0; i < upload->num_spares; i++) {
+      struct u_upload_spare *spare = &upload->spares[i];
+      unsigned size = spare->buffer->width0;
+
+      /* Only our own references left: the driver is done with it. */
+      if (p_atomic_read(&spare->buffer->reference.count) !=
+          spare->idle_refcount ||
+          size < min_size)
+         continue;
+
+      upload->buffer = spare->buffer;
+      upload->transfer = spare->transfer;
+      upload->map = spare->map;
+      upload->buffer_idle_refcount = spare->idle_refcount;
+      upload->buffer_size = size;
+      upload->offset = 0;
+
+      upload->num_spares--;
+      memmove(spare, spare + 1,
+              (upload->num_spares - i) * sizeof(*spare));
+
+      u_upload_init_private_refcount(upload, size, min_size);
+      return size;
+   }
+
+   return 0;
+}
+
 /* Return the allocated buffer size or 0 if it failed. */
 static unsigned
 u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
@@ -181,9 +289,24 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
+   /* On drivers that are done with a buffer once it's unreferenced, keep
+    * the old buffer mapped and recycle one that became idle, so streaming
+    * uploads cycle through a few buffers instead of allocating new ones.
     */
-   u_upload_release_buffer(upload);
+   if (upload->reuse && upload->map_persistent) {
+      if (upload->transfer)
+         u_upload_retire_buffer(upload);
+      else
+         u_upload_release_buffer(upload);
+
+      size = u_upload_reuse_spare(upload, min_size);
+      if (size)
+         return size;
+   } else {
+      /* Release the old buffer, if present:
+       */
+      u_upload_release_buffer(upload);
+   }
 
    /* Allocate a new one:
     */
@@ -245,6 +368,13 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
       return 0;
    }
 
+   /* Nothing else can reference the new buffer yet.  This also accounts
+    * for drivers whose transfers hold a reference.
+    */
+   upload->buffer_idle_refcount =
+      p_atomic_read(&upload->buffer->reference.count) -
+      upload->buffer_private_refcount;
+
    upload->buffer_size = size;
    upload->offset = 0;
    return size;
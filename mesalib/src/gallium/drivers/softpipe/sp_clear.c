@@ -39,6 +39,7 @@
 #include "sp_context.h"
 #include "sp_screen.h"
 #include "sp_query.h"
+#include "sp_rast_thread.h"
 #include "sp_tile_cache.h"
 
 
@@ -71,7 +72,8 @@ softpipe_clear(struct pipe_context *pipe, unsigned buffers,
    if (buffers & PIPE_CLEAR_COLOR) {
       for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++) {
          if (buffers & (PIPE_CLEAR_COLOR0 << i))
-            sp_tile_cache_clear(softpipe->cbuf_cache[i], color, 0);
+            sp_rast_tile_cache_clear(softpipe, softpipe->cbuf_cache[i],
+                                     color, 0);
       }
    }
 
@@ -79,6 +81,7 @@ softpipe_clear(struct pipe_context *pipe, unsigned buffers,
        util_format_is_depth_and_stencil(zsbuf->texture->format) &&
        zs_buffers != PIPE_CLEAR_DEPTHSTENCIL) {
       /* Clearing only depth or stencil in a combined depth-stencil buffer. */
+      sp_rast_flush_tiles(softpipe);
       util_clear_depth_stencil(pipe, zsbuf, zs_buffers, depth, stencil,
                                0, 0, zsbuf->width, zsbuf->height);
    }
@@ -86,7 +89,7 @@ softpipe_clear(struct pipe_context *pipe, unsigned buffers,
       static const union pipe_color_union zero;
 
       cv = util_pack64_z_stencil(zsbuf->format, depth, stencil);
-      sp_tile_cache_clear(softpipe->zsbuf_cache, &zero, cv);
+      sp_rast_tile_cache_clear(softpipe, softpipe->zsbuf_cache, &zero, cv);
    }
 
    softpipe->dirty_render_cache = true;
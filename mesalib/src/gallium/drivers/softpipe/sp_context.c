@@ -44,6 +44,7 @@
 #include "sp_context.h"
 #include "sp_flush.h"
 #include "sp_prim_vbuf.h"
+#include "sp_rast_thread.h"
 #include "sp_state.h"
 #include "sp_surface.h"
 #include "sp_tile_cache.h"
@@ -62,6 +63,9 @@ softpipe_destroy( struct pipe_context *pipe )
    struct softpipe_context *softpipe = softpipe_context( pipe );
    uint i, sh;
 
+   /* the threads' caches point at the framebuffer surfaces */
+   sp_rast_destroy(softpipe->rast);
+
    if (softpipe->blitter) {
       util_blitter_destroy(softpipe->blitter);
    }
@@ -256,6 +260,9 @@ softpipe_create_context(struct pipe_screen *screen,
    softpipe->quad.depth_test = sp_quad_depth_test_stage(softpipe);
    softpipe->quad.blend = sp_quad_blend_stage(softpipe);
 
+   /* before the vbuf backend, which sizes its batches for the threads */
+   softpipe->rast = sp_rast_create(softpipe);
+
    softpipe->pipe.stream_uploader = u_upload_create_default(&softpipe->pipe);
    if (!softpipe->pipe.stream_uploader)
       goto fail;
@@ -50,6 +50,7 @@ struct sp_fragment_shader;
 struct sp_vertex_shader;
 struct sp_velems_state;
 struct sp_so_state;
+struct sp_rast;
 
 struct softpipe_context {
    struct pipe_context pipe;  /**< base class */
@@ -103,6 +104,10 @@ struct softpipe_context {
     * queries.
     */
    uint64_t occlusion_count;
+
+   /** Counters for the driver-specific queries */
+   uint64_t num_draw_calls;
+   uint64_t shader_compile_time;   /**< in microseconds */
    unsigned active_query_count;
 
    /** Mapped vertex buffers */
@@ -163,6 +168,8 @@ struct softpipe_context {
    struct tgsi_exec_machine *fs_machine;
    /** whether early depth testing is enabled */
    bool early_depth;
+   /** whether triangles are tested against the depth tile bounds */
+   bool hiz;
 
    /** The primitive drawing context */
    struct draw_context *draw;
@@ -178,6 +185,9 @@ struct softpipe_context {
    struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
    struct softpipe_tile_cache *zsbuf_cache;
 
+   /** Raster threads, NULL when rendering on the context's thread */
+   struct sp_rast *rast;
+
    unsigned tex_timestamp;
 
    /*
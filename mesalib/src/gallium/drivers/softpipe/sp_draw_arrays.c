@@ -81,6 +81,8 @@ softpipe_draw_vbo(struct pipe_context *pipe,
    if (!softpipe_check_render_cond(sp))
       return;
 
+   sp->num_draw_calls++;
+
    if (indirect && indirect->buffer) {
       util_draw_indirect(pipe, info, indirect);
       return;
@@ -35,6 +35,7 @@
 #include "draw/draw_context.h"
 #include "sp_flush.h"
 #include "sp_context.h"
+#include "sp_rast_thread.h"
 #include "sp_state.h"
 #include "sp_tile_cache.h"
 #include "sp_tex_tile_cache.h"
@@ -61,6 +62,7 @@ softpipe_flush( struct pipe_context *pipe,
             sp_flush_tex_tile_cache(softpipe->tex_cache[sh][i]);
          }
       }
+      sp_rast_flush_tex_caches(softpipe);
    }
 
    /* If this is a swapbuffers, just flush color buffers.
@@ -75,6 +77,8 @@ softpipe_flush( struct pipe_context *pipe,
    if (softpipe->zsbuf_cache)
       sp_flush_tile_cache(softpipe->zsbuf_cache);
 
+   sp_rast_flush_tiles(softpipe);
+
    softpipe->dirty_render_cache = false;
 
    /* Enable to dump BMPs of the color/depth buffers each frame */
@@ -179,6 +183,7 @@ void softpipe_texture_barrier(struct pipe_context *pipe, unsigned flags)
          sp_flush_tex_tile_cache(softpipe->tex_cache[sh][i]);
       }
    }
+   sp_rast_flush_tex_caches(softpipe);
 
    for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++)
       if (softpipe->cbuf_cache[i])
@@ -187,6 +192,8 @@ void softpipe_texture_barrier(struct pipe_context *pipe, unsigned flags)
    if (softpipe->zsbuf_cache)
       sp_flush_tile_cache(softpipe->zsbuf_cache);
 
+   sp_rast_flush_tiles(softpipe);
+
    softpipe->dirty_render_cache = false;
 }
 
@@ -40,6 +40,7 @@
 #include "sp_setup.h"
 #include "sp_state.h"
 #include "sp_prim_vbuf.h"
+#include "sp_rast_thread.h"
 #include "draw/draw_context.h"
 #include "draw/draw_vbuf.h"
 #include "util/u_memory.h"
@@ -49,6 +50,9 @@
 #define SP_MAX_VBUF_INDEXES 1024
 #define SP_MAX_VBUF_SIZE    4096
 
+/* Larger batches with raster threads, to amortize waking them up */
+#define SP_MAX_VBUF_SIZE_THREADED (16 * SP_MAX_VBUF_SIZE)
+
 typedef const float (*cptrf4)[4];
 
 /**
@@ -145,6 +149,21 @@ sp_vbuf_set_primitive(struct vbuf_render *vbr, enum mesa_prim prim)
 }
 
 
+/**
+ * One draw_elements/draw_arrays call, as seen by the raster threads.
+ * Everything here is read only while the batch is being rendered.
+ */
+struct sp_vbuf_batch
+{
+   enum mesa_prim prim;
+   const void *vertex_buffer;
+   unsigned stride;
+   const uint16_t *indices;  /**< NULL for draw_arrays */
+   unsigned nr;
+   bool flatshade_first;
+};
+
+
 static inline cptrf4 get_vert( const void *vertex_buffer,
                                int index,
                                int stride )
@@ -154,20 +173,21 @@ static inline cptrf4 get_vert( const void *vertex_buffer,
 
 
 /**
- * draw elements / indexed primitives
+ * Emit indexed primitives through one setup context.
+ * Called via sp_rast_run(), possibly once per raster thread.
  */
 static void
-sp_vbuf_draw_elements(struct vbuf_render *vbr, const uint16_t *indices, uint nr)
+sp_vbuf_emit_elements(struct setup_context *setup, const void *data)
 {
-   struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
-   struct softpipe_context *softpipe = cvbr->softpipe;
-   const unsigned stride = softpipe->vertex_info.size * sizeof(float);
-   const void *vertex_buffer = cvbr->vertex_buffer;
-   struct setup_context *setup = cvbr->setup;
-   const bool flatshade_first = softpipe->rasterizer->flatshade_first;
+   const struct sp_vbuf_batch *batch = data;
+   const unsigned stride = batch->stride;
+   const void *vertex_buffer = batch->vertex_buffer;
+   const uint16_t *indices = batch->indices;
+   const unsigned nr = batch->nr;
+   const bool flatshade_first = batch->flatshade_first;
    unsigned i;
 
-   switch (cvbr->prim) {
+   switch (batch->prim) {
    case MESA_PRIM_POINTS:
       for (i = 0; i < nr; i++) {
          sp_setup_point( setup,
@@ -349,22 +369,41 @@ sp_vbuf_draw_elements(struct vbuf_render *vbr, const uint16_t *indices, uint nr)
 
 
 /**
- * This function is hit when the draw module is working in pass-through mode.
- * It's up to us to convert the vertex array into point/line/tri prims.
+ * draw elements / indexed primitives
  */
 static void
-sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
+sp_vbuf_draw_elements(struct vbuf_render *vbr, const uint16_t *indices, uint nr)
 {
    struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
    struct softpipe_context *softpipe = cvbr->softpipe;
-   struct setup_context *setup = cvbr->setup;
-   const unsigned stride = softpipe->vertex_info.size * sizeof(float);
-   const void *vertex_buffer =
-      (void *) get_vert(cvbr->vertex_buffer, start, stride);
-   const bool flatshade_first = softpipe->rasterizer->flatshade_first;
+   struct sp_vbuf_batch batch;
+
+   batch.prim = cvbr->prim;
+   batch.vertex_buffer = cvbr->vertex_buffer;
+   batch.stride = softpipe->vertex_info.size * sizeof(float);
+   batch.indices = indices;
+   batch.nr = nr;
+   batch.flatshade_first = softpipe->rasterizer->flatshade_first;
+
+   sp_rast_run(softpipe, cvbr->setup, sp_vbuf_emit_elements, &batch);
+}
+
+
+/**
+ * Emit non-indexed primitives through one setup context.
+ * Called via sp_rast_run(), possibly once per raster thread.
+ */
+static void
+sp_vbuf_emit_arrays(struct setup_context *setup, const void *data)
+{
+   const struct sp_vbuf_batch *batch = data;
+   const unsigned stride = batch->stride;
+   const void *vertex_buffer = batch->vertex_buffer;
+   const unsigned nr = batch->nr;
+   const bool flatshade_first = batch->flatshade_first;
    unsigned i;
 
-   switch (cvbr->prim) {
+   switch (batch->prim) {
    case MESA_PRIM_POINTS:
       for (i = 0; i < nr; i++) {
          sp_setup_point( setup,
@@ -587,6 +626,27 @@ sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
    }
 }
 
+/**
+ * This function is hit when the draw module is working in pass-through mode.
+ * It's up to us to convert the vertex array into point/line/tri prims.
+ */
+static void
+sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
+{
+   struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
+   struct softpipe_context *softpipe = cvbr->softpipe;
+   struct sp_vbuf_batch batch;
+
+   batch.prim = cvbr->prim;
+   batch.stride = softpipe->vertex_info.size * sizeof(float);
+   batch.vertex_buffer = get_vert(cvbr->vertex_buffer, start, batch.stride);
+   batch.indices = NULL;
+   batch.nr = nr;
+   batch.flatshade_first = softpipe->rasterizer->flatshade_first;
+
+   sp_rast_run(softpipe, cvbr->setup, sp_vbuf_emit_arrays, &batch);
+}
+
 /*
  * FIXME: it is unclear if primitives_storage_needed (which is generally
  * the same as pipe query num_primitives_generated) should increase
@@ -651,7 +711,8 @@ sp_create_vbuf_backend(struct softpipe_context *sp)
    assert(sp->draw);
 
    cvbr->base.max_indices = SP_MAX_VBUF_INDEXES;
-   cvbr->base.max_vertex_buffer_bytes = SP_MAX_VBUF_SIZE;
+   cvbr->base.max_vertex_buffer_bytes =
+      sp->rast ? SP_MAX_VBUF_SIZE_THREADED : SP_MAX_VBUF_SIZE;
 
    cvbr->base.get_vertex_info = sp_vbuf_get_vertex_info;
    cvbr->base.allocate_vertices = sp_vbuf_allocate_vertices;
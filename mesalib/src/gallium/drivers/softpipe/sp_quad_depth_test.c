@@ -331,6 +331,9 @@ write_depth_stencil_values( struct depth_data *data,
    default:
       assert(0);
    }
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++)
+      sp_tile_depth_written(tile, data->bzzzz[j]);
 }
 
 
@@ -1096,3 +1099,98 @@ sp_quad_depth_test_stage(struct softpipe_context *softpipe)
 
    return stage;
 }
+
+
+/**
+ * Does every depth value in [qmin, qmax] fail the depth test against
+ * every value within the tile's bounds?
+ */
+static inline bool
+hiz_all_fail(unsigned func, const struct softpipe_cached_tile *tile,
+             unsigned qmin, unsigned qmax)
+{
+   switch (func) {
+   case PIPE_FUNC_LESS:
+      return qmin >= tile->hiz.zmax;
+   case PIPE_FUNC_LEQUAL:
+      return qmin > tile->hiz.zmax;
+   case PIPE_FUNC_GREATER:
+      return qmax <= tile->hiz.zmin;
+   case PIPE_FUNC_GEQUAL:
+      return qmax < tile->hiz.zmin;
+   default:
+      return false;
+   }
+}
+
+
+/**
+ * Hierarchical Z: can a block of fragments with depths in [zmin, zmax]
+ * be dropped before shading because they'd all fail the depth test in
+ * the tile at (x,y)?  Only valid while softpipe_context::hiz is set.
+ */
+bool
+sp_quad_depth_hiz_reject(struct softpipe_context *sp,
+                         int x, int y, unsigned layer,
+                         unsigned viewport_index,
+                         float zmin, float zmax)
+{
+   const enum pipe_format format = sp->framebuffer.zsbuf->format;
+   const unsigned func = sp->depth_stencil->depth_func;
+   struct softpipe_cached_tile *tile;
+   unsigned qmin, qmax;
+   double scale;
+   float eps;
+
+   assert(sp->hiz);
+
+   if (!sp->rasterizer->depth_clip_near) {
+      const struct pipe_viewport_state *vp = &sp->viewports[viewport_index];
+      float near_val = vp->translate[2] - vp->scale[2];
+      float far_val = near_val + (vp->scale[2] * 2.0);
+
+      zmin = CLAMP(zmin, MIN2(near_val, far_val), MAX2(near_val, far_val));
+      zmax = CLAMP(zmax, MIN2(near_val, far_val), MAX2(near_val, far_val));
+   }
+
+   /* Leave room for the rounding of the per-quad depth, which the z16
+    * paths step across a batch in fixed point.
+    */
+   eps = format == PIPE_FORMAT_Z16_UNORM ? 32.0f / 65535.0f :
+                                           1.0f / (1 << 20);
+   zmin -= eps;
+   zmax += eps;
+   if (!(zmin >= 0.0f && zmax <= 1.0f))
+      return false;
+
+   switch (format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      scale = 65535.0;
+      break;
+   case PIPE_FORMAT_Z32_UNORM:
+      scale = (double) (uint) ~0UL;
+      break;
+   default:
+      scale = (double) ((1 << 24) - 1);
+      break;
+   }
+
+   qmin = (unsigned) (zmin * scale);
+   qmax = (unsigned) (zmax * scale);
+
+   tile = sp_get_cached_tile(sp->zsbuf_cache, x, y, layer);
+   if (!tile->hiz.valid)
+      sp_tile_update_depth_bounds(sp->zsbuf_cache, tile);
+
+   if (hiz_all_fail(func, tile, qmin, qmax))
+      return true;
+
+   /* The bounds only grow as fragments are written, tighten them once
+    * enough of the tile has been rewritten.
+    */
+   if (tile->hiz.written < TILE_SIZE * TILE_SIZE / 4)
+      return false;
+
+   sp_tile_update_depth_bounds(sp->zsbuf_cache, tile);
+   return hiz_all_fail(func, tile, qmin, qmax);
+}
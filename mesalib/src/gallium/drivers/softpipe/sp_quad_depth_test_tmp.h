@@ -90,42 +90,50 @@ NAME(struct quad_stage *qs,
 #ifdef ALWAYS
       if (outmask & 1) {
          depth16[0][0] = idepth[0];
+         sp_tile_depth_written(tile, idepth[0]);
          mask |= (1 << 0);
       }
 
       if (outmask & 2) {
          depth16[0][1] = idepth[1];
+         sp_tile_depth_written(tile, idepth[1]);
          mask |= (1 << 1);
       }
 
       if (outmask & 4) {
          depth16[1][0] = idepth[2];
+         sp_tile_depth_written(tile, idepth[2]);
          mask |= (1 << 2);
       }
 
       if (outmask & 8) {
          depth16[1][1] = idepth[3];
+         sp_tile_depth_written(tile, idepth[3]);
          mask |= (1 << 3);
       }
 #else
       /* Note: OPERATOR appears here: */
       if ((outmask & 1) && (idepth[0] OPERATOR depth16[0][0])) {
          depth16[0][0] = idepth[0];
+         sp_tile_depth_written(tile, idepth[0]);
          mask |= (1 << 0);
       }
 
       if ((outmask & 2) && (idepth[1] OPERATOR depth16[0][1])) {
          depth16[0][1] = idepth[1];
+         sp_tile_depth_written(tile, idepth[1]);
          mask |= (1 << 1);
       }
 
       if ((outmask & 4) && (idepth[2] OPERATOR depth16[1][0])) {
          depth16[1][0] = idepth[2];
+         sp_tile_depth_written(tile, idepth[2]);
          mask |= (1 << 2);
       }
 
       if ((outmask & 8) && (idepth[3] OPERATOR depth16[1][1])) {
          depth16[1][1] = idepth[3];
+         sp_tile_depth_written(tile, idepth[3]);
          mask |= (1 << 3);
       }
 #endif
@@ -42,14 +42,17 @@ insert_stage_at_head(struct softpipe_context *sp, struct quad_stage *quad)
 void
 sp_build_quad_pipeline(struct softpipe_context *sp)
 {
+   const struct pipe_depth_stencil_alpha_state *dsa = sp->depth_stencil;
+   const struct tgsi_shader_info *info = &sp->fs_variant->info;
    bool early_depth_test =
-      (sp->depth_stencil->depth_enabled &&
-      sp->framebuffer.zsbuf &&
-      !sp->depth_stencil->alpha_enabled &&
-      !sp->fs_variant->info.uses_kill &&
-      !sp->fs_variant->info.writes_z &&
-       !sp->fs_variant->info.writes_stencil) ||
-      sp->fs_variant->info.properties[TGSI_PROPERTY_FS_EARLY_DEPTH_STENCIL];
+      ((dsa->depth_enabled || dsa->stencil[0].enabled) &&
+       sp->framebuffer.zsbuf &&
+       !dsa->alpha_enabled &&
+       !info->uses_kill &&
+       !info->writes_z &&
+       !info->writes_stencil &&
+       !info->writes_memory) ||
+      info->properties[TGSI_PROPERTY_FS_EARLY_DEPTH_STENCIL];
 
    sp->quad.first = sp->quad.blend;
 
@@ -62,5 +65,30 @@ sp_build_quad_pipeline(struct softpipe_context *sp)
       insert_stage_at_head( sp, sp->quad.depth_test );
       insert_stage_at_head( sp, sp->quad.shade );
    }
-}
 
+   /* Whole blocks can only be dropped when failing the depth test has no
+    * other effect.
+    */
+   sp->hiz = early_depth_test &&
+             dsa->depth_enabled &&
+             !dsa->stencil[0].enabled &&
+             (dsa->depth_func == PIPE_FUNC_LESS ||
+              dsa->depth_func == PIPE_FUNC_LEQUAL ||
+              dsa->depth_func == PIPE_FUNC_GREATER ||
+              dsa->depth_func == PIPE_FUNC_GEQUAL);
+
+   if (sp->hiz) {
+      switch (sp->framebuffer.zsbuf->format) {
+      case PIPE_FORMAT_Z16_UNORM:
+      case PIPE_FORMAT_Z32_UNORM:
+      case PIPE_FORMAT_Z24X8_UNORM:
+      case PIPE_FORMAT_Z24_UNORM_S8_UINT:
+      case PIPE_FORMAT_X8Z24_UNORM:
+      case PIPE_FORMAT_S8_UINT_Z24_UNORM:
+         break;
+      default:
+         sp->hiz = false;
+         break;
+      }
+   }
+}
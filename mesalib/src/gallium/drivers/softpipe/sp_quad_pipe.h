@@ -31,6 +31,7 @@
 #ifndef SP_QUAD_PIPE_H
 #define SP_QUAD_PIPE_H
 
+#include <stdbool.h>
 
 struct softpipe_context;
 struct quad_header;
@@ -68,4 +69,9 @@ struct quad_stage *sp_quad_output_stage( struct softpipe_context *softpipe );
 
 void sp_build_quad_pipeline(struct softpipe_context *sp);
 
+bool sp_quad_depth_hiz_reject(struct softpipe_context *sp,
+                              int x, int y, unsigned layer,
+                              unsigned viewport_index,
+                              float zmin, float zmax);
+
 #endif /* SP_QUAD_PIPE_H */
@@ -71,7 +71,9 @@ softpipe_create_query(struct pipe_context *pipe,
           type == PIPE_QUERY_PIPELINE_STATISTICS ||
           type == PIPE_QUERY_GPU_FINISHED ||
           type == PIPE_QUERY_TIMESTAMP ||
-          type == PIPE_QUERY_TIMESTAMP_DISJOINT);
+          type == PIPE_QUERY_TIMESTAMP_DISJOINT ||
+          type == SP_QUERY_DRAW_CALLS ||
+          type == SP_QUERY_SHADER_COMPILE_TIME);
    sq = CALLOC_STRUCT( softpipe_query );
    sq->type = type;
    sq->index = index;
@@ -92,6 +94,16 @@ softpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    struct softpipe_context *softpipe = softpipe_context( pipe );
    struct softpipe_query *sq = softpipe_query(q);
 
+   /* These don't affect rendering, so they aren't counted as active */
+   switch (sq->type) {
+   case SP_QUERY_DRAW_CALLS:
+      sq->start = softpipe->num_draw_calls;
+      return true;
+   case SP_QUERY_SHADER_COMPILE_TIME:
+      sq->start = softpipe->shader_compile_time;
+      return true;
+   }
+
    switch (sq->type) {
    case PIPE_QUERY_OCCLUSION_COUNTER:
    case PIPE_QUERY_OCCLUSION_PREDICATE:
@@ -151,6 +163,15 @@ softpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct softpipe_context *softpipe = softpipe_context( pipe );
    struct softpipe_query *sq = softpipe_query(q);
 
+   switch (sq->type) {
+   case SP_QUERY_DRAW_CALLS:
+      sq->end = softpipe->num_draw_calls;
+      return true;
+   case SP_QUERY_SHADER_COMPILE_TIME:
+      sq->end = softpipe->shader_compile_time;
+      return true;
+   }
+
    softpipe->active_query_count--;
    switch (sq->type) {
    case PIPE_QUERY_OCCLUSION_COUNTER:
@@ -340,6 +361,30 @@ softpipe_set_active_query_state(struct pipe_context *pipe, bool enable)
 }
 
 
+int
+softpipe_get_driver_query_info(struct pipe_screen *screen, unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"draw-calls", SP_QUERY_DRAW_CALLS, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64,
+       PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE, 0, 0},
+      {"shader-compile-time", SP_QUERY_SHADER_COMPILE_TIME, {0},
+       PIPE_DRIVER_QUERY_TYPE_MICROSECONDS,
+       PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE, 0, 0},
+   };
+
+   if (!info)
+      return ARRAY_SIZE(queries);
+
+   if (index >= ARRAY_SIZE(queries))
+      return 0;
+
+   *info = queries[index];
+   return 1;
+}
+
+
 void softpipe_init_query_funcs(struct softpipe_context *softpipe )
 {
    softpipe->pipe.create_query = softpipe_create_query;
@@ -0,0 +1,683 @@
+/*
+ * Copyright © 2026 Mesa contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Raster thread pool.  See sp_rast_thread.h for the overall scheme.
+ *
+ * Each thread renders into a private copy of the softpipe context.  The
+ * copy is refreshed from the real context at the start of every job, then
+ * pointed at the thread's own mutable state (tile caches, shader machine,
+ * texture caches, quad stages and counters).  While a job is running the
+ * context's thread only waits, so the copy's view of the state is stable.
+ *
+ * The cbuf/zsbuf tiles live either in the context's caches or in the
+ * threads' caches, never in both: whenever rendering switches between the
+ * serial and the threaded path the side that holds tiles is flushed first.
+ */
+
+#include <stdio.h>
+
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "util/u_thread.h"
+#include "tgsi/tgsi_exec.h"
+
+#include "sp_context.h"
+#include "sp_quad.h"
+#include "sp_quad_pipe.h"
+#include "sp_rast_thread.h"
+#include "sp_setup.h"
+#include "sp_state.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_texture.h"
+#include "sp_tile_cache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+enum sp_rast_job {
+   SP_RAST_JOB_DRAW,
+   SP_RAST_JOB_FLUSH,
+};
+
+/** Which caches may currently hold framebuffer tiles */
+enum sp_rast_tiles {
+   SP_RAST_TILES_NONE,
+   SP_RAST_TILES_CONTEXT,
+   SP_RAST_TILES_THREADS,
+};
+
+
+struct sp_rast_thread {
+   struct sp_rast *rast;
+   unsigned index;
+
+   util_semaphore work_ready;
+   util_semaphore work_done;
+
+   /** Private copy of the context, see sp_rast_thread_begin() */
+   struct softpipe_context *softpipe;
+   struct setup_context *setup;
+
+   struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
+   struct softpipe_tile_cache *zsbuf_cache;
+
+   struct tgsi_exec_machine *fs_machine;
+   struct sp_tgsi_sampler *sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+   struct quad_stage *shade;
+   struct quad_stage *depth_test;
+   struct quad_stage *blend;
+};
+
+
+struct sp_rast {
+   struct softpipe_context *softpipe;
+
+   unsigned num_threads;
+   thrd_t threads[SP_MAX_THREADS];
+   struct sp_rast_thread thread[SP_MAX_THREADS];
+
+   enum sp_rast_tiles tiles;
+
+   /** The current job */
+   enum sp_rast_job job;
+   sp_rast_func func;
+   const void *data;
+
+   bool exit_flag;
+};
+
+
+/**
+ * Bring the fragment sampler views of the thread's copy in line with the
+ * context, backed by the thread's own texture caches.
+ */
+static void
+sp_rast_thread_update_samplers(struct sp_rast_thread *thread)
+{
+   const struct softpipe_context *sp = thread->rast->softpipe;
+   const struct sp_tgsi_sampler *src = sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+   struct sp_tgsi_sampler *dst = thread->sampler;
+   unsigned i;
+
+   memcpy(dst->sp_sampler, src->sp_sampler, sizeof(dst->sp_sampler));
+
+   for (i = 0; i < sp->num_sampler_views[PIPE_SHADER_FRAGMENT]; i++) {
+      struct pipe_sampler_view *view =
+         sp->sampler_views[PIPE_SHADER_FRAGMENT][i];
+      struct softpipe_tex_tile_cache *tc = thread->tex_cache[i];
+
+      dst->sp_sview[i] = src->sp_sview[i];
+
+      if (!view) {
+         if (tc)
+            sp_tex_tile_cache_set_sampler_view(tc, NULL);
+         continue;
+      }
+
+      /* allocated by sp_rast_alloc_tex_caches() */
+      assert(tc);
+      sp_tex_tile_cache_set_sampler_view(tc, view);
+      if (softpipe_resource(tc->texture)->timestamp != tc->timestamp) {
+         sp_tex_tile_cache_validate_texture(tc);
+         tc->timestamp = softpipe_resource(tc->texture)->timestamp;
+      }
+      dst->sp_sview[i].cache = tc;
+   }
+}
+
+
+/**
+ * Refresh the thread's copy of the context before running a draw job.
+ */
+static void
+sp_rast_thread_begin(struct sp_rast_thread *thread)
+{
+   const struct softpipe_context *sp = thread->rast->softpipe;
+   struct softpipe_context *copy = thread->softpipe;
+   const struct sp_fragment_shader_variant *fs = sp->fs_variant;
+   unsigned i;
+
+   memcpy(copy, sp, sizeof(*copy));
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      copy->cbuf_cache[i] = thread->cbuf_cache[i];
+   copy->zsbuf_cache = thread->zsbuf_cache;
+   copy->fs_machine = thread->fs_machine;
+   copy->tgsi.sampler[PIPE_SHADER_FRAGMENT] = thread->sampler;
+   copy->quad.shade = thread->shade;
+   copy->quad.depth_test = thread->depth_test;
+   copy->quad.blend = thread->blend;
+
+   /* derived state was validated by the context before the job */
+   copy->dirty = 0;
+   copy->occlusion_count = 0;
+   memset(&copy->pipeline_statistics, 0, sizeof(copy->pipeline_statistics));
+
+   sp_build_quad_pipeline(copy);
+
+   sp_rast_thread_update_samplers(thread);
+
+   /* Binding re-parses the shader, so only do it when the shader changed.
+    * sp_rast_release_fs_variant() keeps a stale token pointer from
+    * matching a new shader allocated at the same address.
+    */
+   if (thread->fs_machine->Tokens != fs->tokens) {
+      fs->prepare(fs, thread->fs_machine,
+                  (struct tgsi_sampler *) thread->sampler,
+                  (struct tgsi_image *) sp->tgsi.image[PIPE_SHADER_FRAGMENT],
+                  (struct tgsi_buffer *) sp->tgsi.buffer[PIPE_SHADER_FRAGMENT]);
+   }
+
+   sp_setup_prepare(thread->setup);
+}
+
+
+static void
+sp_rast_thread_flush(struct sp_rast_thread *thread)
+{
+   unsigned i;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      sp_flush_tile_cache(thread->cbuf_cache[i]);
+   sp_flush_tile_cache(thread->zsbuf_cache);
+}
+
+
+static int
+sp_rast_thread_func(void *init_data)
+{
+   struct sp_rast_thread *thread = (struct sp_rast_thread *) init_data;
+   struct sp_rast *rast = thread->rast;
+   char thread_name[16];
+
+   snprintf(thread_name, sizeof thread_name, "softpipe-%u", thread->index);
+   u_thread_setname(thread_name);
+
+   while (1) {
+      util_semaphore_wait(&thread->work_ready);
+
+      if (rast->exit_flag)
+         break;
+
+      switch (rast->job) {
+      case SP_RAST_JOB_DRAW:
+         sp_rast_thread_begin(thread);
+         rast->func(thread->setup, rast->data);
+         break;
+      case SP_RAST_JOB_FLUSH:
+         sp_rast_thread_flush(thread);
+         break;
+      }
+
+      util_semaphore_signal(&thread->work_done);
+   }
+
+#ifdef _WIN32
+   util_semaphore_signal(&thread->work_done);
+#endif
+
+   return 0;
+}
+
+
+/**
+ * Run the current job on all threads and wait for them to finish.
+ */
+static void
+sp_rast_run_job(struct sp_rast *rast, enum sp_rast_job job)
+{
+   unsigned i;
+
+   rast->job = job;
+
+   for (i = 0; i < rast->num_threads; i++)
+      util_semaphore_signal(&rast->thread[i].work_ready);
+
+   for (i = 0; i < rast->num_threads; i++)
+      util_semaphore_wait(&rast->thread[i].work_done);
+}
+
+
+static void
+sp_rast_flush_context_tiles(struct softpipe_context *softpipe)
+{
+   unsigned i;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      sp_flush_tile_cache(softpipe->cbuf_cache[i]);
+   sp_flush_tile_cache(softpipe->zsbuf_cache);
+}
+
+
+/**
+ * Does the framebuffer have more than one tile to share out?
+ */
+static bool
+sp_rast_fb_is_split(const struct softpipe_context *softpipe)
+{
+   return softpipe->framebuffer.width > TILE_SIZE ||
+          softpipe->framebuffer.height > TILE_SIZE;
+}
+
+
+/**
+ * Texture caches are big (NUM_TEX_TILE_ENTRIES float tiles each) and few
+ * units are used at a time, so the threads get theirs on first use.
+ */
+static bool
+sp_rast_alloc_tex_caches(struct sp_rast *rast)
+{
+   const struct softpipe_context *softpipe = rast->softpipe;
+   unsigned i, t;
+
+   for (i = 0; i < softpipe->num_sampler_views[PIPE_SHADER_FRAGMENT]; i++) {
+      if (!softpipe->sampler_views[PIPE_SHADER_FRAGMENT][i])
+         continue;
+
+      for (t = 0; t < rast->num_threads; t++) {
+         struct sp_rast_thread *thread = &rast->thread[t];
+
+         if (!thread->tex_cache[i]) {
+            thread->tex_cache[i] =
+               sp_create_tex_tile_cache(&rast->softpipe->pipe);
+            if (!thread->tex_cache[i])
+               return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+
+/**
+ * Can the current fragment work be split over the threads?
+ */
+static bool
+sp_rast_use_threads(struct sp_rast *rast)
+{
+   const struct softpipe_context *softpipe = rast->softpipe;
+
+   /* Stores and atomics would land in an order depending on thread
+    * timing, so shaders writing memory are kept on the context's thread.
+    */
+   if (!softpipe->fs_variant || softpipe->fs_variant->info.writes_memory)
+      return false;
+
+   /* a single tile can only be rendered by a single thread anyway */
+   if (!sp_rast_fb_is_split(softpipe))
+      return false;
+
+   return sp_rast_alloc_tex_caches(rast);
+}
+
+
+/**
+ * Emit a batch of primitives, either on the raster threads or, when that
+ * isn't possible, through the context's own setup context.
+ */
+void
+sp_rast_run(struct softpipe_context *softpipe,
+            struct setup_context *setup,
+            sp_rast_func func, const void *data)
+{
+   struct sp_rast *rast = softpipe->rast;
+   unsigned i;
+
+   if (!rast || !sp_rast_use_threads(rast)) {
+      if (rast) {
+         if (rast->tiles == SP_RAST_TILES_THREADS)
+            sp_rast_flush_tiles(softpipe);
+         rast->tiles = SP_RAST_TILES_CONTEXT;
+      }
+      func(setup, data);
+      return;
+   }
+
+   if (rast->tiles == SP_RAST_TILES_CONTEXT)
+      sp_rast_flush_context_tiles(softpipe);
+   rast->tiles = SP_RAST_TILES_THREADS;
+
+   rast->func = func;
+   rast->data = data;
+   sp_rast_run_job(rast, SP_RAST_JOB_DRAW);
+
+   for (i = 0; i < rast->num_threads; i++) {
+      const struct softpipe_context *copy = rast->thread[i].softpipe;
+
+      softpipe->occlusion_count += copy->occlusion_count;
+      softpipe->pipeline_statistics.ps_invocations +=
+         copy->pipeline_statistics.ps_invocations;
+   }
+
+   /* every thread sets up every primitive, count them once */
+   softpipe->pipeline_statistics.c_primitives +=
+      rast->thread[0].softpipe->pipeline_statistics.c_primitives;
+}
+
+
+/**
+ * Write back the framebuffer tiles held by the threads and by the
+ * context, leaving all the cbuf/zsbuf caches empty.
+ */
+void
+sp_rast_flush_tiles(struct softpipe_context *softpipe)
+{
+   struct sp_rast *rast = softpipe->rast;
+
+   if (!rast)
+      return;
+
+   switch (rast->tiles) {
+   case SP_RAST_TILES_THREADS:
+      sp_rast_run_job(rast, SP_RAST_JOB_FLUSH);
+      break;
+   case SP_RAST_TILES_CONTEXT:
+      sp_rast_flush_context_tiles(softpipe);
+      break;
+   case SP_RAST_TILES_NONE:
+      break;
+   }
+
+   rast->tiles = SP_RAST_TILES_NONE;
+}
+
+
+/**
+ * Clear the surface cached by one of the context's tile caches
+ * (cbuf_cache[i] or zsbuf_cache).  Unless the context's caches already
+ * hold tiles, the clear is handed to the threads' caches so that each
+ * thread fills its own cleared tiles and nothing has to be written back
+ * for the threaded draws which follow.
+ */
+void
+sp_rast_tile_cache_clear(struct softpipe_context *softpipe,
+                         struct softpipe_tile_cache *tc,
+                         const union pipe_color_union *color,
+                         uint64_t clear_value)
+{
+   struct sp_rast *rast = softpipe->rast;
+   unsigned i, t;
+
+   if (!rast || rast->tiles == SP_RAST_TILES_CONTEXT || !tc->num_maps ||
+       !sp_rast_fb_is_split(softpipe)) {
+      sp_tile_cache_clear(tc, color, clear_value);
+      return;
+   }
+
+   for (t = 0; t < rast->num_threads; t++) {
+      struct sp_rast_thread *thread = &rast->thread[t];
+      struct softpipe_tile_cache *thread_tc = thread->zsbuf_cache;
+
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+         if (tc == softpipe->cbuf_cache[i])
+            thread_tc = thread->cbuf_cache[i];
+      }
+
+      sp_tile_cache_clear_owned(thread_tc, color, clear_value,
+                                t, rast->num_threads);
+   }
+
+   rast->tiles = SP_RAST_TILES_THREADS;
+}
+
+
+/**
+ * Drop everything the threads' texture caches hold.  Called wherever the
+ * context's texture caches are flushed.
+ */
+void
+sp_rast_flush_tex_caches(struct softpipe_context *softpipe)
+{
+   struct sp_rast *rast = softpipe->rast;
+   unsigned i, t;
+
+   if (!rast)
+      return;
+
+   for (t = 0; t < rast->num_threads; t++) {
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         if (rast->thread[t].tex_cache[i])
+            sp_tex_tile_cache_set_sampler_view(rast->thread[t].tex_cache[i],
+                                               NULL);
+      }
+   }
+}
+
+
+/**
+ * Point the threads' tile caches at the context's framebuffer surfaces.
+ * The threads' tiles must have been flushed before the surfaces changed.
+ */
+void
+sp_rast_set_framebuffer(struct softpipe_context *softpipe)
+{
+   struct sp_rast *rast = softpipe->rast;
+   unsigned i, t;
+
+   if (!rast)
+      return;
+
+   for (t = 0; t < rast->num_threads; t++) {
+      struct sp_rast_thread *thread = &rast->thread[t];
+
+      for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+         sp_tile_cache_set_surface(thread->cbuf_cache[i],
+                                   softpipe->framebuffer.cbufs[i]);
+      sp_tile_cache_set_surface(thread->zsbuf_cache,
+                                softpipe->framebuffer.zsbuf);
+   }
+}
+
+
+/**
+ * A fragment shader variant is about to be deleted: unbind it from the
+ * threads' shader machines.
+ */
+void
+sp_rast_release_fs_variant(struct softpipe_context *softpipe,
+                           const struct sp_fragment_shader_variant *var)
+{
+   struct sp_rast *rast = softpipe->rast;
+   unsigned t;
+
+   if (!rast)
+      return;
+
+   for (t = 0; t < rast->num_threads; t++) {
+      struct tgsi_exec_machine *machine = rast->thread[t].fs_machine;
+
+      if (machine->Tokens == var->tokens)
+         tgsi_exec_machine_bind_shader(machine, NULL, NULL, NULL, NULL);
+   }
+}
+
+
+static void
+sp_rast_thread_destroy(struct sp_rast_thread *thread)
+{
+   unsigned i;
+
+   if (thread->blend)
+      thread->blend->destroy(thread->blend);
+   if (thread->depth_test)
+      thread->depth_test->destroy(thread->depth_test);
+   if (thread->shade)
+      thread->shade->destroy(thread->shade);
+
+   for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+      if (thread->tex_cache[i]) {
+         sp_tex_tile_cache_set_sampler_view(thread->tex_cache[i], NULL);
+         sp_destroy_tex_tile_cache(thread->tex_cache[i]);
+      }
+   }
+   FREE(thread->sampler);
+
+   if (thread->fs_machine)
+      tgsi_exec_machine_destroy(thread->fs_machine);
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      sp_destroy_tile_cache(thread->cbuf_cache[i]);
+   sp_destroy_tile_cache(thread->zsbuf_cache);
+
+   if (thread->setup)
+      sp_setup_destroy_context(thread->setup);
+   FREE(thread->softpipe);
+}
+
+
+static bool
+sp_rast_thread_init(struct sp_rast *rast, unsigned index)
+{
+   struct softpipe_context *softpipe = rast->softpipe;
+   struct sp_rast_thread *thread = &rast->thread[index];
+   unsigned i;
+
+   thread->rast = rast;
+   thread->index = index;
+
+   thread->softpipe = CALLOC_STRUCT(softpipe_context);
+   if (!thread->softpipe)
+      return false;
+
+   thread->setup = sp_setup_create_context(thread->softpipe);
+   if (!thread->setup)
+      return false;
+   sp_setup_set_thread(thread->setup, index, rast->num_threads);
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      thread->cbuf_cache[i] = sp_create_tile_cache(&softpipe->pipe);
+      if (!thread->cbuf_cache[i])
+         return false;
+   }
+   thread->zsbuf_cache = sp_create_tile_cache(&softpipe->pipe);
+   if (!thread->zsbuf_cache)
+      return false;
+
+   thread->fs_machine = tgsi_exec_machine_create(PIPE_SHADER_FRAGMENT);
+   if (!thread->fs_machine)
+      return false;
+
+   thread->sampler = sp_create_tgsi_sampler();
+   if (!thread->sampler)
+      return false;
+
+   thread->shade = sp_quad_shade_stage(thread->softpipe);
+   thread->depth_test = sp_quad_depth_test_stage(thread->softpipe);
+   thread->blend = sp_quad_blend_stage(thread->softpipe);
+   if (!thread->shade || !thread->depth_test || !thread->blend)
+      return false;
+
+   return true;
+}
+
+
+/**
+ * Create the raster threads for a context.  Returns NULL (render on the
+ * context's thread) when SOFTPIPE_NUM_THREADS or the CPU count is <= 1.
+ */
+struct sp_rast *
+sp_rast_create(struct softpipe_context *softpipe)
+{
+   struct sp_rast *rast;
+   unsigned num_threads, i;
+
+   num_threads = util_get_cpu_caps()->nr_cpus;
+   num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", num_threads);
+   num_threads = MIN2(num_threads, SP_MAX_THREADS);
+   if (num_threads <= 1)
+      return NULL;
+
+   rast = CALLOC_STRUCT(sp_rast);
+   if (!rast)
+      return NULL;
+
+   rast->softpipe = softpipe;
+   rast->num_threads = num_threads;
+
+   for (i = 0; i < num_threads; i++) {
+      if (!sp_rast_thread_init(rast, i))
+         goto fail;
+   }
+
+   for (i = 0; i < num_threads; i++) {
+      util_semaphore_init(&rast->thread[i].work_ready, 0);
+      util_semaphore_init(&rast->thread[i].work_done, 0);
+      if (thrd_success != u_thread_create(rast->threads + i,
+                                          sp_rast_thread_func,
+                                          (void *) &rast->thread[i])) {
+         util_semaphore_destroy(&rast->thread[i].work_ready);
+         util_semaphore_destroy(&rast->thread[i].work_done);
+         break;
+      }
+   }
+
+   if (i < num_threads) {
+      /* The tile split is fixed at setup time, so rather than
+       * redistributing, stop what was started and render serially.
+       */
+      rast->num_threads = i;
+      sp_rast_destroy(rast);
+      return NULL;
+   }
+
+   return rast;
+
+fail:
+   rast->num_threads = 0;
+   for (i = 0; i < num_threads; i++)
+      sp_rast_thread_destroy(&rast->thread[i]);
+   FREE(rast);
+   return NULL;
+}
+
+
+void
+sp_rast_destroy(struct sp_rast *rast)
+{
+   unsigned i;
+
+   if (!rast)
+      return;
+
+   /* Set exit_flag and signal each thread's work_ready semaphore, as
+    * llvmpipe does.  On Windows the threads may already be gone when this
+    * runs from process exit, so don't join them there.
+    */
+   rast->exit_flag = true;
+   for (i = 0; i < rast->num_threads; i++)
+      util_semaphore_signal(&rast->thread[i].work_ready);
+
+   for (i = 0; i < rast->num_threads; i++) {
+#ifdef _WIN32
+      DWORD exit_code = STILL_ACTIVE;
+      if (GetExitCodeThread(rast->threads[i].handle, &exit_code) &&
+          exit_code == STILL_ACTIVE) {
+         util_semaphore_wait(&rast->thread[i].work_done);
+      }
+#else
+      thrd_join(rast->threads[i], NULL);
+#endif
+   }
+
+   for (i = 0; i < rast->num_threads; i++) {
+      util_semaphore_destroy(&rast->thread[i].work_ready);
+      util_semaphore_destroy(&rast->thread[i].work_done);
+   }
+
+   for (i = 0; i < SP_MAX_THREADS; i++) {
+      if (rast->thread[i].rast)
+         sp_rast_thread_destroy(&rast->thread[i]);
+   }
+
+   FREE(rast);
+}
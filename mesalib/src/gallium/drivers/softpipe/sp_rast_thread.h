@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2026 Mesa contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Raster threads for softpipe.
+ *
+ * The draw module still runs on the context's thread.  Each batch of
+ * post-transform primitives is handed to a small pool of threads which all
+ * walk the whole batch, but each one only shades and writes the quads that
+ * land in the framebuffer tiles it owns (see sp_tile_owner()).  Every
+ * thread has its own tile caches, fragment shader machine, texture caches
+ * and quad pipeline, so no locking is needed while a batch is rendered.
+ */
+
+#ifndef SP_RAST_THREAD_H
+#define SP_RAST_THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct sp_rast;
+struct softpipe_context;
+struct setup_context;
+struct sp_fragment_shader_variant;
+struct softpipe_tile_cache;
+union pipe_color_union;
+
+
+#define SP_MAX_THREADS 16
+
+
+/**
+ * Emit a batch of primitives through the given setup context.
+ * Called once per raster thread with that thread's setup context.
+ */
+typedef void (*sp_rast_func)(struct setup_context *setup, const void *data);
+
+
+struct sp_rast *
+sp_rast_create(struct softpipe_context *softpipe);
+
+void
+sp_rast_destroy(struct sp_rast *rast);
+
+void
+sp_rast_run(struct softpipe_context *softpipe,
+            struct setup_context *setup,
+            sp_rast_func func, const void *data);
+
+void
+sp_rast_flush_tiles(struct softpipe_context *softpipe);
+
+void
+sp_rast_tile_cache_clear(struct softpipe_context *softpipe,
+                         struct softpipe_tile_cache *tc,
+                         const union pipe_color_union *color,
+                         uint64_t clear_value);
+
+void
+sp_rast_flush_tex_caches(struct softpipe_context *softpipe);
+
+void
+sp_rast_set_framebuffer(struct softpipe_context *softpipe);
+
+void
+sp_rast_release_fs_variant(struct softpipe_context *softpipe,
+                           const struct sp_fragment_shader_variant *var);
+
+
+#endif /* SP_RAST_THREAD_H */
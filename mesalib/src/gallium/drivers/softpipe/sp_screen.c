@@ -27,6 +27,8 @@
 
 
 #include "compiler/nir/nir.h"
+#include "util/disk_cache.h"
+#include "util/hex.h"
 #include "util/u_helpers.h"
 #include "util/u_memory.h"
 #include "util/format/u_format.h"
@@ -47,6 +49,7 @@
 #include "sp_context.h"
 #include "sp_fence.h"
 #include "sp_public.h"
+#include "sp_query.h"
 
 static const struct debug_named_value sp_debug_options[] = {
    {"vs",        SP_DBG_VS,         "dump vertex shader assembly to stderr"},
@@ -310,6 +313,14 @@ softpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
       return 4;
    case PIPE_CAP_IMAGE_STORE_FORMATTED:
       return 1;
+   case PIPE_CAP_UPLOAD_BUFFER_REUSE:
+      /* draw_vbo() flushes the draw module before returning. */
+      return 1;
+   case PIPE_CAP_MAP_UNSYNCHRONIZED_THREAD_SAFE:
+      /* Unsynchronized buffer maps are plain pointers into the resource
+       * and don't touch the context (needed by glthread).
+       */
+      return 1;
    default:
       return u_pipe_screen_get_param_defaults(screen, param);
    }
@@ -484,6 +495,10 @@ softpipe_is_format_supported( struct pipe_screen *screen,
 static void
 softpipe_destroy_screen( struct pipe_screen *screen )
 {
+   struct softpipe_screen *sp_screen = softpipe_screen(screen);
+
+   disk_cache_destroy(sp_screen->disk_shader_cache);
+
    FREE(screen);
 }
 
@@ -572,6 +587,34 @@ softpipe_screen_get_fd(struct pipe_screen *screen)
       return -1;
 }
 
+/**
+ * Create the disk cache the state tracker keeps compiled GLSL programs in.
+ * The cache is keyed on this driver's build, so a rebuilt driver never
+ * picks up programs compiled by an older one.
+ */
+static void
+sp_disk_cache_create(struct softpipe_screen *screen)
+{
+   struct mesa_sha1 ctx;
+   unsigned char sha1[20];
+   char cache_id[20 * 2 + 1];
+   _mesa_sha1_init(&ctx);
+
+   if (!disk_cache_get_function_identifier(sp_disk_cache_create, &ctx))
+      return;
+
+   _mesa_sha1_final(&ctx, sha1);
+   mesa_bytes_to_hex(cache_id, sha1, 20);
+
+   screen->disk_shader_cache = disk_cache_create("softpipe", cache_id, 0);
+}
+
+static struct disk_cache *
+softpipe_get_disk_shader_cache(struct pipe_screen *screen)
+{
+   return softpipe_screen(screen)->disk_shader_cache;
+}
+
 /**
  * Create a new pipe_screen object
  * Note: we're not presently subclassing pipe_screen (no softpipe_screen).
@@ -597,6 +640,7 @@ softpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_param = softpipe_get_param;
    screen->base.get_shader_param = softpipe_get_shader_param;
    screen->base.get_paramf = softpipe_get_paramf;
+   screen->base.get_driver_query_info = softpipe_get_driver_query_info;
    screen->base.get_timestamp = u_default_get_timestamp;
    screen->base.query_memory_info = util_sw_query_memory_info;
    screen->base.is_format_supported = softpipe_is_format_supported;
@@ -604,8 +648,11 @@ softpipe_create_screen(struct sw_winsys *winsys)
    screen->base.flush_frontbuffer = softpipe_flush_frontbuffer;
    screen->base.get_compute_param = softpipe_get_compute_param;
    screen->base.get_compiler_options = softpipe_get_compiler_options;
+   screen->base.get_disk_shader_cache = softpipe_get_disk_shader_cache;
    screen->use_llvm = sp_debug & SP_DBG_USE_LLVM;
 
+   sp_disk_cache_create(screen);
+
    softpipe_init_screen_texture_funcs(&screen->base);
    softpipe_init_screen_fence_funcs(&screen->base);
 
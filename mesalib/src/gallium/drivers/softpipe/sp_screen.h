@@ -36,6 +36,7 @@
 
 
 struct sw_winsys;
+struct disk_cache;
 
 struct softpipe_screen {
    struct pipe_screen base;
@@ -47,6 +48,8 @@ struct softpipe_screen {
     */
    unsigned timestamp;
    bool use_llvm;
+
+   struct disk_cache *disk_shader_cache;
 };
 
 static inline struct softpipe_screen *
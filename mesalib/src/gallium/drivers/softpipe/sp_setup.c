@@ -38,6 +38,7 @@
 #include "sp_quad_pipe.h"
 #include "sp_setup.h"
 #include "sp_state.h"
+#include "sp_tile_cache.h"
 #include "draw/draw_context.h"
 #include "pipe/p_shader_tokens.h"
 #include "util/u_math.h"
@@ -114,6 +115,12 @@ struct setup_context {
 
    unsigned cull_face;		/* which faces cull */
    unsigned nr_vertex_attrs;
+
+   /* With raster threads, each setup context only emits the quads that
+    * land in the framebuffer tiles owned by its thread.
+    */
+   unsigned thread_index;
+   unsigned num_threads;
 };
 
 
@@ -154,6 +161,18 @@ quad_clip(struct setup_context *setup, struct quad_header *quad)
 }
 
 
+/**
+ * Does this setup context's thread own the framebuffer tile containing
+ * window pos (x,y)?
+ */
+static inline bool
+owns_tile(const struct setup_context *setup, int x, int y)
+{
+   return setup->num_threads <= 1 ||
+          sp_tile_owner(x, y, setup->num_threads) == setup->thread_index;
+}
+
+
 /**
  * Emit a quad (pass to next stage) with clipping.
  */
@@ -162,7 +181,8 @@ clip_emit_quad(struct setup_context *setup, struct quad_header *quad)
 {
    quad_clip(setup, quad);
 
-   if (quad->inout.mask) {
+   if (quad->inout.mask &&
+       owns_tile(setup, quad->input.x0, quad->input.y0)) {
       struct softpipe_context *sp = setup->softpipe;
 
 #if DEBUG_FRAGS
@@ -193,6 +213,29 @@ block_x(int x)
 }
 
 
+/**
+ * Are all the fragments of the chunk of quads at (x, span.y) hidden by
+ * the depth buffer?  Triangle depth is planar, so over the 16x2 pixel
+ * chunk it lies between its values at the chunk's corners.
+ */
+static inline bool
+hiz_reject(struct setup_context *setup, int x)
+{
+   const float dzdx = setup->posCoef.dadx[2];
+   const float dzdy = setup->posCoef.dady[2];
+   const float z0 = setup->posCoef.a0[2] +
+                    dzdx * (float) x + dzdy * (float) setup->span.y;
+   const float zx = dzdx * (MAX_QUADS - 1);
+   float zmin = z0 + MIN2(zx, 0.0f) + MIN2(dzdy, 0.0f);
+   float zmax = z0 + MAX2(zx, 0.0f) + MAX2(dzdy, 0.0f);
+
+   return sp_quad_depth_hiz_reject(setup->softpipe, x, setup->span.y,
+                                   setup->quad[0].input.layer,
+                                   setup->quad[0].input.viewport_index,
+                                   zmin, zmax);
+}
+
+
 /**
  * Render a horizontal span of quads
  */
@@ -230,7 +273,12 @@ flush_spans(struct setup_context *setup)
       unsigned mask0 = ~skipmask_left0 & ~skipmask_right0;
       unsigned mask1 = ~skipmask_left1 & ~skipmask_right1;
 
-      if (mask0 | mask1) {
+      /* A chunk never straddles a tile, so other threads' chunks are
+       * skipped whole and each batch keeps the same first quad as when
+       * one thread renders everything.
+       */
+      if ((mask0 | mask1) && owns_tile(setup, x, setup->span.y) &&
+          !(setup->softpipe->hiz && hiz_reject(setup, x))) {
          do {
             unsigned quadmask = (mask0 & 3) | ((mask1 & 3) << 2);
             if (quadmask) {
@@ -1442,5 +1490,20 @@ sp_setup_create_context(struct softpipe_context *softpipe)
    setup->span.left[0] = 1000000;     /* greater than right[0] */
    setup->span.left[1] = 1000000;     /* greater than right[1] */
 
+   setup->thread_index = 0;
+   setup->num_threads = 1;
+
    return setup;
 }
+
+
+/**
+ * Restrict a setup context to the tiles owned by one raster thread.
+ */
+void
+sp_setup_set_thread(struct setup_context *setup,
+                    unsigned thread_index, unsigned num_threads)
+{
+   setup->thread_index = thread_index;
+   setup->num_threads = num_threads;
+}
@@ -73,5 +73,7 @@ sp_clamp_viewport_idx(int idx)
 struct setup_context *sp_setup_create_context( struct softpipe_context *softpipe );
 void sp_setup_prepare( struct setup_context *setup );
 void sp_setup_destroy_context( struct setup_context *setup );
+void sp_setup_set_thread( struct setup_context *setup,
+                          unsigned thread_index, unsigned num_threads );
 
 #endif
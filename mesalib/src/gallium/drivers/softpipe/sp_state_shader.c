@@ -29,11 +29,13 @@
 #include "sp_screen.h"
 #include "sp_state.h"
 #include "sp_fs.h"
+#include "sp_rast_thread.h"
 #include "sp_texture.h"
 
 #include "nir.h"
 #include "nir/nir_to_tgsi.h"
 #include "pipe/p_defines.h"
+#include "util/os_time.h"
 #include "util/ralloc.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
@@ -57,6 +59,7 @@ create_fs_variant(struct softpipe_context *softpipe,
 {
    struct sp_fragment_shader_variant *var;
    struct pipe_shader_state *curfs = &fs->shader;
+   int64_t start = os_time_get();
 
    /* codegen, create variant object */
    var = softpipe_create_fs_variant_exec(softpipe);
@@ -85,6 +88,8 @@ create_fs_variant(struct softpipe_context *softpipe,
       fs->variants = var;
    }
 
+   softpipe->shader_compile_time += os_time_get() - start;
+
    return var;
 }
 
@@ -126,6 +131,9 @@ softpipe_create_shader_state(struct pipe_context *pipe,
                              const struct pipe_shader_state *templ,
                              bool debug)
 {
+   struct softpipe_context *softpipe = softpipe_context(pipe);
+   int64_t start = os_time_get();
+
    if (templ->type == PIPE_SHADER_IR_NIR) {
       if (debug)
          nir_print_shader(templ->ir.nir, stderr);
@@ -141,6 +149,8 @@ softpipe_create_shader_state(struct pipe_context *pipe,
 
    shader->stream_output = templ->stream_output;
 
+   softpipe->shader_compile_time += os_time_get() - start;
+
    if (debug)
       tgsi_dump(shader->tokens, 0);
 
@@ -218,6 +228,7 @@ softpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
       draw_delete_fragment_shader(softpipe->draw, var->draw_shader);
 #endif
 
+      sp_rast_release_fs_variant(softpipe, var);
       var->delete(var, softpipe->fs_machine);
    }
 
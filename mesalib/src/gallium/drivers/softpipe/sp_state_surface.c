@@ -29,6 +29,7 @@
  */
 
 #include "sp_context.h"
+#include "sp_rast_thread.h"
 #include "sp_state.h"
 #include "sp_tile_cache.h"
 
@@ -59,6 +60,7 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
       /* check if changing cbuf */
       if (sp->framebuffer.cbufs[i] != cb) {
          /* flush old */
+         sp_rast_flush_tiles(sp);
          sp_flush_tile_cache(sp->cbuf_cache[i]);
 
          /* assign new */
@@ -74,6 +76,7 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
    /* zbuf changing? */
    if (sp->framebuffer.zsbuf != fb->zsbuf) {
       /* flush old */
+      sp_rast_flush_tiles(sp);
       sp_flush_tile_cache(sp->zsbuf_cache);
 
       /* assign new */
@@ -97,5 +100,7 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
    sp->framebuffer.samples = fb->samples;
    sp->framebuffer.layers = fb->layers;
 
+   sp_rast_set_framebuffer(sp);
+
    sp->dirty |= SP_NEW_FRAMEBUFFER | SP_NEW_TEXTURE;
 }
@@ -1273,6 +1273,206 @@ img_filter_2d_nearest_clamp_POT(const struct sp_sampler_view *sp_sview,
 }
 
 
+/*
+ * Direct sampling of linear RGBA8 2D textures.
+ *
+ * Textured quads (image viewers, composited toolkits) mostly sample a
+ * single-level RGBA8 image with nearest or bilinear filtering and repeat
+ * or clamp-to-edge wrapping.  For those the texels are read straight out
+ * of the resource instead of going through the texture tile cache and the
+ * mip/img filter callbacks.  The coordinate math and texel conversion are
+ * the generic path's, so the results are the same.
+ */
+static inline void
+sample_direct_2d(const struct sp_sampler_view *sp_sview,
+                 const float s[TGSI_QUAD_SIZE],
+                 const float t[TGSI_QUAD_SIZE],
+                 const int8_t offset[3],
+                 float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE],
+                 bool linear, bool repeat_wrap)
+{
+   const struct softpipe_resource *spr =
+      softpipe_resource(sp_sview->base.texture);
+   const unsigned level = sp_sview->base.u.tex.first_level;
+   const unsigned width = u_minify(spr->base.width0, level);
+   const unsigned height = u_minify(spr->base.height0, level);
+   const unsigned stride = spr->stride[level];
+   const uint8_t *data = (const uint8_t *) spr->data +
+      softpipe_get_tex_image_offset(spr, level,
+                                    sp_sview->base.u.tex.first_layer);
+   const uint8_t *chan = sp_sview->direct_chan;
+   int j, c;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      if (linear) {
+         const uint8_t *tx[4];
+         int x0, y0, x1, y1;
+         float xw, yw;
+
+         if (repeat_wrap) {
+            wrap_linear_repeat(s[j], width, offset[0], &x0, &x1, &xw);
+            wrap_linear_repeat(t[j], height, offset[1], &y0, &y1, &yw);
+         } else {
+            wrap_linear_clamp_to_edge(s[j], width, offset[0], &x0, &x1, &xw);
+            wrap_linear_clamp_to_edge(t[j], height, offset[1], &y0, &y1, &yw);
+         }
+
+         tx[0] = data + y0 * stride + x0 * 4;
+         tx[1] = data + y0 * stride + x1 * 4;
+         tx[2] = data + y1 * stride + x0 * 4;
+         tx[3] = data + y1 * stride + x1 * 4;
+
+         for (c = 0; c < TGSI_NUM_CHANNELS; c++)
+            rgba[c][j] = lerp_2d(xw, yw,
+                                 ubyte_to_float(tx[0][chan[c]]),
+                                 ubyte_to_float(tx[1][chan[c]]),
+                                 ubyte_to_float(tx[2][chan[c]]),
+                                 ubyte_to_float(tx[3][chan[c]]));
+      } else {
+         const uint8_t *tx;
+         int x, y;
+
+         if (repeat_wrap) {
+            wrap_nearest_repeat(s[j], width, offset[0], &x);
+            wrap_nearest_repeat(t[j], height, offset[1], &y);
+         } else {
+            wrap_nearest_clamp_to_edge(s[j], width, offset[0], &x);
+            wrap_nearest_clamp_to_edge(t[j], height, offset[1], &y);
+         }
+
+         tx = data + y * stride + x * 4;
+         for (c = 0; c < TGSI_NUM_CHANNELS; c++)
+            rgba[c][j] = ubyte_to_float(tx[chan[c]]);
+      }
+   }
+
+   if (sp_sview->direct_opaque) {
+      for (j = 0; j < TGSI_QUAD_SIZE; j++)
+         rgba[3][j] = 1.0f;
+   }
+
+   if (DEBUG_TEX) {
+      print_sample_4(__func__, rgba);
+   }
+}
+
+
+static void
+sample_direct_2d_nearest_repeat(const struct sp_sampler_view *sp_sview,
+                                const float s[TGSI_QUAD_SIZE],
+                                const float t[TGSI_QUAD_SIZE],
+                                const int8_t offset[3],
+                                float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   sample_direct_2d(sp_sview, s, t, offset, rgba, false, true);
+}
+
+
+static void
+sample_direct_2d_nearest_clamp_to_edge(const struct sp_sampler_view *sp_sview,
+                                       const float s[TGSI_QUAD_SIZE],
+                                       const float t[TGSI_QUAD_SIZE],
+                                       const int8_t offset[3],
+                                       float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   sample_direct_2d(sp_sview, s, t, offset, rgba, false, false);
+}
+
+
+static void
+sample_direct_2d_linear_repeat(const struct sp_sampler_view *sp_sview,
+                               const float s[TGSI_QUAD_SIZE],
+                               const float t[TGSI_QUAD_SIZE],
+                               const int8_t offset[3],
+                               float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   sample_direct_2d(sp_sview, s, t, offset, rgba, true, true);
+}
+
+
+static void
+sample_direct_2d_linear_clamp_to_edge(const struct sp_sampler_view *sp_sview,
+                                      const float s[TGSI_QUAD_SIZE],
+                                      const float t[TGSI_QUAD_SIZE],
+                                      const int8_t offset[3],
+                                      float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   sample_direct_2d(sp_sview, s, t, offset, rgba, true, false);
+}
+
+
+/**
+ * Pick the direct kernel for a sampler state, or NULL when the sampler
+ * needs anything the kernels don't do: mipmapping, different min and mag
+ * filters, other wrap modes, unnormalized coords, shadow compare or
+ * anisotropy.
+ */
+static sp_direct_filter_func
+get_direct_filter(const struct pipe_sampler_state *sampler)
+{
+   if (sampler->min_mip_filter != PIPE_TEX_MIPFILTER_NONE ||
+       sampler->min_img_filter != sampler->mag_img_filter ||
+       sampler->wrap_s != sampler->wrap_t ||
+       sampler->unnormalized_coords ||
+       sampler->compare_mode != PIPE_TEX_COMPARE_NONE ||
+       sampler->max_anisotropy > 1)
+      return NULL;
+
+   switch (sampler->wrap_s) {
+   case PIPE_TEX_WRAP_REPEAT:
+      return sampler->min_img_filter == PIPE_TEX_FILTER_LINEAR ?
+         sample_direct_2d_linear_repeat : sample_direct_2d_nearest_repeat;
+   case PIPE_TEX_WRAP_CLAMP_TO_EDGE:
+      return sampler->min_img_filter == PIPE_TEX_FILTER_LINEAR ?
+         sample_direct_2d_linear_clamp_to_edge :
+         sample_direct_2d_nearest_clamp_to_edge;
+   default:
+      return NULL;
+   }
+}
+
+
+/**
+ * Can views of this texture be sampled by the direct kernels?  Sets up
+ * the byte order if so.
+ */
+static bool
+init_direct_view(struct sp_sampler_view *sview,
+                 const struct softpipe_resource *spr)
+{
+   const struct pipe_sampler_view *view = &sview->base;
+
+   if ((view->target != PIPE_TEXTURE_2D &&
+        view->target != PIPE_TEXTURE_RECT) ||
+       spr->dt || !spr->data ||
+       util_format_get_blocksize(spr->base.format) != 4)
+      return false;
+
+   switch (view->format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+   case PIPE_FORMAT_R8G8B8X8_UNORM:
+      sview->direct_chan[0] = 0;
+      sview->direct_chan[1] = 1;
+      sview->direct_chan[2] = 2;
+      sview->direct_chan[3] = 3;
+      break;
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+   case PIPE_FORMAT_B8G8R8X8_UNORM:
+      sview->direct_chan[0] = 2;
+      sview->direct_chan[1] = 1;
+      sview->direct_chan[2] = 0;
+      sview->direct_chan[3] = 3;
+      break;
+   default:
+      return false;
+   }
+
+   sview->direct_opaque = view->format == PIPE_FORMAT_R8G8B8X8_UNORM ||
+                          view->format == PIPE_FORMAT_B8G8R8X8_UNORM;
+   return true;
+}
+
+
 static void
 img_filter_1d_nearest(const struct sp_sampler_view *sp_sview,
                       const struct sp_sampler *sp_samp,
@@ -3548,6 +3748,8 @@ softpipe_create_sampler_state(struct pipe_context *pipe,
       samp->min_mag_equal = true;
    }
 
+   samp->direct_filter = get_direct_filter(sampler);
+
    return (void *)samp;
 }
 
@@ -3639,6 +3841,8 @@ softpipe_create_sampler_view(struct pipe_context *pipe,
       sview->xpot = util_logbase2( resource->width0 );
       sview->ypot = util_logbase2( resource->height0 );
 
+      sview->direct = init_direct_view(sview, spr);
+
       sview->oneval = util_format_is_pure_integer(view->format) ? uif(1) : 1.0f;
    }
 
@@ -3712,6 +3916,7 @@ sp_tgsi_get_samples(struct tgsi_sampler *tgsi_sampler,
 {
    const struct sp_tgsi_sampler *sp_tgsi_samp =
       sp_tgsi_sampler_cast_c(tgsi_sampler);
+   const struct sp_sampler_view *direct_sview;
    struct sp_sampler_view sp_sview;
    const struct sp_sampler *sp_samp;
    struct filter_args filt_args;
@@ -3723,9 +3928,22 @@ sp_tgsi_get_samples(struct tgsi_sampler *tgsi_sampler,
    assert(sampler_index < PIPE_MAX_SAMPLERS);
    assert(sp_tgsi_samp->sp_sampler[sampler_index]);
 
+   /* Fast path, needs neither the border color nor the lod */
+   direct_sview = &sp_tgsi_samp->sp_sview[sview_index];
+   sp_samp = sp_tgsi_samp->sp_sampler[sampler_index];
+   if (direct_sview->direct && sp_samp->direct_filter &&
+       control != TGSI_SAMPLER_GATHER) {
+      sp_samp->direct_filter(direct_sview, s, t, offset, rgba);
+      if (direct_sview->need_swizzle) {
+         float rgba_temp[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE];
+         memcpy(rgba_temp, rgba, sizeof(rgba_temp));
+         do_swizzling(&direct_sview->base, rgba_temp, rgba);
+      }
+      return;
+   }
+
    memcpy(&sp_sview, &sp_tgsi_samp->sp_sview[sview_index],
           sizeof(struct sp_sampler_view));
-   sp_samp = sp_tgsi_samp->sp_sampler[sampler_index];
 
    if (util_format_is_unorm(sp_sview.base.format)) {
       for (c = 0; c < TGSI_NUM_CHANNELS; c++)
@@ -104,6 +104,13 @@ typedef void (*fetch_func)(struct sp_sampler_view *sp_sview,
                            float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE]);
 
 
+typedef void (*sp_direct_filter_func)(const struct sp_sampler_view *sp_sview,
+                                      const float s[TGSI_QUAD_SIZE],
+                                      const float t[TGSI_QUAD_SIZE],
+                                      const int8_t offset[3],
+                                      float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE]);
+
+
 struct sp_sampler_view
 {
    struct pipe_sampler_view base;
@@ -117,6 +124,13 @@ struct sp_sampler_view
    bool pot2d;
    bool need_cube_convert;
 
+   /* For sampling linear RGBA8 2D textures without the tile cache,
+    * see sample_direct_2d()
+    */
+   bool direct;
+   bool direct_opaque;          /**< X8 formats, alpha reads as one */
+   uint8_t direct_chan[4];      /**< byte holding R, G, B and A */
+
    /* these are different per shader type */
    struct softpipe_tex_tile_cache *cache;
    compute_lambda_func compute_lambda;
@@ -147,6 +161,7 @@ struct sp_sampler {
    wrap_linear_func linear_texcoord_p;
 
    const struct sp_filter_funcs *filter_funcs;
+   sp_direct_filter_func direct_filter;
 };
 
 
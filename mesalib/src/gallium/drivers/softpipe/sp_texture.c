@@ -469,8 +469,10 @@ softpipe_transfer_unmap(struct pipe_context *pipe,
    }
 
    if (transfer->usage & PIPE_MAP_WRITE) {
-      /* Mark the texture as dirty to expire the tile caches. */
-      spr->timestamp++;
+      /* Mark the texture as dirty to expire the tile caches.  With glthread
+       * buffers can be unmapped from the application thread.
+       */
+      p_atomic_inc(&spr->timestamp);
    }
 
    pipe_resource_reference(&transfer->resource, NULL);
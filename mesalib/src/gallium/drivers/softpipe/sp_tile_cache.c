@@ -553,6 +553,8 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
                                tile->data.color);
          }
       }
+
+      tile->hiz.valid = false;
    }
 
    tc->last_tile = tile;
@@ -561,6 +563,70 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
 }
 
 
+/**
+ * Recompute the bounds of the depth values in a cached depth tile.
+ * Formats the depth test can't bound get the whole range, which never
+ * rejects anything.
+ */
+void
+sp_tile_update_depth_bounds(const struct softpipe_tile_cache *tc,
+                            struct softpipe_cached_tile *tile)
+{
+   uint zmin = ~0u, zmax = 0;
+   uint i, j, z;
+
+   switch (tc->surface->format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      for (i = 0; i < TILE_SIZE; i++) {
+         for (j = 0; j < TILE_SIZE; j++) {
+            z = tile->data.depth16[i][j];
+            zmin = MIN2(zmin, z);
+            zmax = MAX2(zmax, z);
+         }
+      }
+      break;
+   case PIPE_FORMAT_Z32_UNORM:
+      for (i = 0; i < TILE_SIZE; i++) {
+         for (j = 0; j < TILE_SIZE; j++) {
+            z = tile->data.depth32[i][j];
+            zmin = MIN2(zmin, z);
+            zmax = MAX2(zmax, z);
+         }
+      }
+      break;
+   case PIPE_FORMAT_Z24X8_UNORM:
+   case PIPE_FORMAT_Z24_UNORM_S8_UINT:
+      for (i = 0; i < TILE_SIZE; i++) {
+         for (j = 0; j < TILE_SIZE; j++) {
+            z = tile->data.depth32[i][j] & 0xffffff;
+            zmin = MIN2(zmin, z);
+            zmax = MAX2(zmax, z);
+         }
+      }
+      break;
+   case PIPE_FORMAT_X8Z24_UNORM:
+   case PIPE_FORMAT_S8_UINT_Z24_UNORM:
+      for (i = 0; i < TILE_SIZE; i++) {
+         for (j = 0; j < TILE_SIZE; j++) {
+            z = tile->data.depth32[i][j] >> 8;
+            zmin = MIN2(zmin, z);
+            zmax = MAX2(zmax, z);
+         }
+      }
+      break;
+   default:
+      zmin = 0;
+      zmax = ~0u;
+      break;
+   }
+
+   tile->hiz.zmin = zmin;
+   tile->hiz.zmax = zmax;
+   tile->hiz.written = 0;
+   tile->hiz.valid = true;
+}
+
+
 
 
 
@@ -588,3 +654,34 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
    }
    tc->last_tile_addr.bits.invalid = 1;
 }
+
+
+/**
+ * Like sp_tile_cache_clear(), but only flag the tiles owned by one of
+ * several raster threads.  The other tiles are left for the caches of the
+ * threads that own them.
+ */
+void
+sp_tile_cache_clear_owned(struct softpipe_tile_cache *tc,
+                          const union pipe_color_union *color,
+                          uint64_t clearValue,
+                          unsigned owner, unsigned num_owners)
+{
+   int layer;
+   uint x, y;
+
+   sp_tile_cache_clear(tc, color, clearValue);
+
+   for (layer = 0; layer < tc->num_maps; layer++) {
+      const uint w = tc->transfer[layer]->box.width;
+      const uint h = tc->transfer[layer]->box.height;
+
+      for (y = 0; y < h; y += TILE_SIZE) {
+         for (x = 0; x < w; x += TILE_SIZE) {
+            if (sp_tile_owner(x, y, num_owners) != owner)
+               clear_clear_flag(tc->clear_flags, tile_address(x, y, layer),
+                                tc->clear_flags_size);
+         }
+      }
+   }
+}
@@ -74,6 +74,17 @@ struct softpipe_cached_tile
       uint64_t depth64[TILE_SIZE][TILE_SIZE];
       uint8_t any[1];
    } data;
+
+   /**
+    * Bounds of the depth values in a depth tile, in depth buffer units.
+    * Writes only widen them, sp_tile_update_depth_bounds() makes them
+    * tight again.
+    */
+   struct {
+      uint zmin, zmax;
+      uint written;     /**< depth writes since the bounds were computed */
+      bool valid;
+   } hiz;
 };
 
 #define NUM_ENTRIES 50
@@ -123,6 +134,16 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
                     const union pipe_color_union *color,
                     uint64_t clearValue);
 
+extern void
+sp_tile_cache_clear_owned(struct softpipe_tile_cache *tc,
+                          const union pipe_color_union *color,
+                          uint64_t clearValue,
+                          unsigned owner, unsigned num_owners);
+
+extern void
+sp_tile_update_depth_bounds(const struct softpipe_tile_cache *tc,
+                            struct softpipe_cached_tile *tile);
+
 extern struct softpipe_cached_tile *
 sp_find_cached_tile(struct softpipe_tile_cache *tc, 
                     union tile_address addr );
@@ -141,6 +162,18 @@ tile_address( unsigned x,
    return addr;
 }
 
+/**
+ * Which of num_owners raster threads owns the tile containing window
+ * pos (x,y).  Tiles are dealt out diagonally so that both a row and a
+ * column of tiles are spread over all the threads.
+ */
+static inline unsigned
+sp_tile_owner(int x, int y, unsigned num_owners)
+{
+   return (unsigned) ((x >> TILE_SIZE_LOG2) + (y >> TILE_SIZE_LOG2)) %
+          num_owners;
+}
+
 /* Quickly retrieve tile if it matches last lookup.
  */
 static inline struct softpipe_cached_tile *
@@ -156,6 +189,19 @@ sp_get_cached_tile(struct softpipe_tile_cache *tc,
 }
 
 
+/**
+ * Widen a depth tile's bounds to include a depth value just written.
+ */
+static inline void
+sp_tile_depth_written(struct softpipe_cached_tile *tile, uint z)
+{
+   if (tile->hiz.valid) {
+      tile->hiz.zmin = MIN2(tile->hiz.zmin, z);
+      tile->hiz.zmax = MAX2(tile->hiz.zmax, z);
+      tile->hiz.written++;
+   }
+}
+
 
 
 #endif /* SP_TILE_CACHE_H */
@@ -35,6 +35,7 @@
 #include "util/u_memory.h"
 #include "util/u_driconf.h"
 #include "util/driconf.h"
+#include "hud/hud_context.h"
 #include "pipe/p_screen.h"
 
 #include "stw_device.h"
@@ -45,10 +46,25 @@
 #include "stw_tls.h"
 #include "stw_framebuffer.h"
 #include "stw_st.h"
+#include "stw_context.h"
 
 
 struct stw_device *stw_dev = NULL;
 
+/**
+ * Called from the glthread worker when it starts.  The worker makes the
+ * context current itself, so there is nothing to tell the loader.
+ */
+static void
+stw_set_background_context(struct st_context *st,
+                           struct util_queue_monitoring *queue_info)
+{
+   struct stw_context *ctx = (struct stw_context *)st->frontend_context;
+
+   if (ctx->hud)
+      hud_add_queue_for_monitoring(ctx->hud, queue_info);
+}
+
 static int
 stw_get_param(struct pipe_frontend_screen *fscreen,
               enum st_manager_param param)
@@ -151,6 +167,7 @@ stw_init(const struct stw_winsys *stw_winsys)
       goto error1;
 
    stw_dev->fscreen->get_param = stw_get_param;
+   stw_dev->fscreen->set_background_context = stw_set_background_context;
 
    InitializeCriticalSection(&stw_dev->screen_mutex);
    InitializeCriticalSection(&stw_dev->ctx_mutex);
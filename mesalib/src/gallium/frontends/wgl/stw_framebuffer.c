@@ -738,6 +738,11 @@ stw_framebuffer_swap_locked(HDC hdc, struct stw_framebuffer *fb)
 
    ctx = stw_current_context();
    if (ctx) {
+      /* Wait for glthread to finish because we can't use pipe_context from
+       * multiple threads.
+       */
+      _mesa_glthread_finish(ctx->st->ctx);
+
       if (ctx->hud) {
          /* Display the HUD */
          struct pipe_resource *back =
@@ -416,6 +416,11 @@ stw_st_flush(struct st_context *st,
    struct pipe_fence_handle **pfence = NULL;
    struct pipe_fence_handle *fence = NULL;
 
+   /* Wait for glthread to finish because we can't use pipe_context from
+    * multiple threads.
+    */
+   _mesa_glthread_finish(st->ctx);
+
    args.st = st;
    args.stwfb = stwfb;
    args.flags = flags;
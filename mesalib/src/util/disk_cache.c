@@ -24,19 +24,24 @@
 #ifdef ENABLE_SHADER_CACHE
 
 #include <ctype.h>
-#include <ftw.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <sys/file.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <dirent.h>
 #include <inttypes.h>
 
+#include "util/detect_os.h"
+
+#if !DETECT_OS_WINDOWS
+#include <ftw.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#endif
+
 #include "util/compress.h"
 #include "util/crc32.h"
 #include "util/u_debug.h"
@@ -80,28 +80,84 @@ disk_cache_get_function_identifier(void *ptr, struct mesa_sha1 *ctx)
 
 #ifdef ENABLE_SHADER_CACHE
 
-#if DETECT_OS_WINDOWS
-/* TODO: implement disk cache support on windows */
-
-#else
-
 #include <dirent.h>
 #include <errno.h>
-#include <pwd.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/file.h>
-#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+
+#if DETECT_OS_WINDOWS
+#include <direct.h>
+#include <io.h>
+#else
+#include <pwd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#endif
 
 #include "util/blob.h"
 #include "util/crc32.h"
 #include "util/u_debug.h"
+#include "util/u_string.h"
 #include "util/ralloc.h"
 #include "util/rand_xor.h"
 
+#if DETECT_OS_WINDOWS
+/* Cache files hold binary data, so the CRT must not translate them, and
+ * like O_CLOEXEC their handles are not inherited by child processes.
+ */
+#define O_CLOEXEC (_O_BINARY | _O_NOINHERIT)
+
+#define mkdir(path, mode) _mkdir(path)
+
+/* Ignored by stat_dir_entry() */
+#define AT_SYMLINK_NOFOLLOW 0
+#endif
+
+static inline bool
+is_path_separator(char c)
+{
+#if DETECT_OS_WINDOWS
+   return c == '/' || c == '\\';
+#else
+   return c == '/';
+#endif
+}
+
+/* Size a file takes up on disk, as accounted in the cache index. */
+static inline uint64_t
+file_disk_size(const struct stat *sb)
+{
+#if DETECT_OS_WINDOWS
+   return sb->st_size;
+#else
+   return (uint64_t)sb->st_blocks * 512;
+#endif
+}
+
+/* stat() the entry 'name' of the open directory 'dir' at 'dir_path'. */
+static int
+stat_dir_entry(DIR *dir, const char *dir_path, const char *name,
+               struct stat *sb, int flags)
+{
+#if DETECT_OS_WINDOWS
+   char *path;
+   int ret;
+
+   if (asprintf(&path, "%s/%s", dir_path, name) == -1)
+      return -1;
+
+   ret = stat(path, sb);
+   free(path);
+
+   return ret;
+#else
+   return fstatat(dirfd(dir), name, sb, flags);
+#endif
+}
+
 /* Create a directory named 'path' if it does not already exist.
  *
  * Returns: 0 if path already exists as a directory or if created.
@@ -153,12 +209,13 @@ mkdir_with_parents_if_needed(const char *path)
    p = strdup(path);
    end = p + strlen(p) + 1; /* end points to the \0 terminator */
    for (char *q = p; q != end; q++) {
-      if (*q == '/' || q == end - 1) {
+      if (is_path_separator(*q) || q == end - 1) {
          if (q == p) {
             /* Skip the first / of an absolute path. */
             continue;
          }
 
+         char sep = *q;
          *q = '\0';
 
          if (mkdir_if_needed(p) == -1) {
@@ -166,7 +223,7 @@ mkdir_with_parents_if_needed(const char *path)
             return -1;
          }
 
-         *q = '/';
+         *q = sep;
       }
    }
    free(p);
@@ -240,8 +297,6 @@ choose_lru_file_matching(const char *dir_path,
    if (dir == NULL)
       return NULL;
 
-   const int dir_fd = dirfd(dir);
-
    /* First count the number of files in the directory */
    unsigned total_file_count = 0;
    while ((dir_ent = readdir(dir)) != NULL) {
@@ -252,7 +307,8 @@ choose_lru_file_matching(const char *dir_path,
 #else
       struct stat st;
 
-      if (fstatat(dir_fd, dir_ent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+      if (stat_dir_entry(dir, dir_path, dir_ent->d_name, &st,
+                         AT_SYMLINK_NOFOLLOW) == 0) {
          if (S_ISREG(st.st_mode)) {
             total_file_count++;
          }
@@ -277,7 +333,7 @@ choose_lru_file_matching(const char *dir_path,
          break;
 
       struct stat sb;
-      if (fstatat(dir_fd, dir_ent->d_name, &sb, 0) == 0) {
+      if (stat_dir_entry(dir, dir_path, dir_ent->d_name, &sb, 0) == 0) {
          struct lru_file *entry = NULL;
          if (!list_is_empty(lru_file_list))
             entry = list_first_entry(lru_file_list, struct lru_file, node);
@@ -322,7 +378,7 @@ choose_lru_file_matching(const char *dir_path,
                entry->lru_name = tmp;
                memcpy(entry->lru_name, dir_ent->d_name, len + 1);
                entry->lru_atime = sb.st_atime;
-               entry->lru_file_size = sb.st_blocks * 512;
+               entry->lru_file_size = file_disk_size(&sb);
             }
          }
       }
@@ -538,8 +594,9 @@ disk_cache_evict_item(struct disk_cache *cache, char *filename)
    unlink(filename);
    free(filename);
 
-   if (sb.st_blocks)
-      p_atomic_add(&cache->size->value, - (uint64_t)sb.st_blocks * 512);
+   uint64_t size = file_disk_size(&sb);
+   if (size)
+      p_atomic_add(&cache->size->value, - size);
 }
 
 static void *
@@ -766,6 +823,65 @@ create_cache_item_header_and_blob(struct disk_cache_put_job *dc_job,
    return false;
 }
 
+/* Open, creating it if needed, the temporary file a cache item is written
+ * to before being renamed into place.
+ */
+static int
+open_tmp_file(const char *filename_tmp)
+{
+#if DETECT_OS_WINDOWS
+   /* The CRT opens files without FILE_SHARE_DELETE, which would make the
+    * rename into place fail while we still hold the file, (and its lock).
+    */
+   HANDLE handle = CreateFileA(filename_tmp, GENERIC_WRITE,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE |
+                               FILE_SHARE_DELETE,
+                               NULL, OPEN_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, NULL);
+   if (handle == INVALID_HANDLE_VALUE) {
+      errno = GetLastError() == ERROR_PATH_NOT_FOUND ? ENOENT : EACCES;
+      return -1;
+   }
+
+   int fd = _open_osfhandle((intptr_t)handle, _O_WRONLY | _O_BINARY);
+   if (fd == -1)
+      CloseHandle(handle);
+
+   return fd;
+#else
+   return open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+#endif
+}
+
+/* Take an exclusive lock on the temporary file without blocking.
+ *
+ * Returns: 0 if the lock was taken, -1 if another process holds it.
+ */
+static int
+lock_tmp_file(int fd)
+{
+#if DETECT_OS_WINDOWS
+   OVERLAPPED overlapped = { 0 };
+
+   if (!LockFileEx((HANDLE)_get_osfhandle(fd),
+                   LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY,
+                   0, MAXDWORD, MAXDWORD, &overlapped))
+      return -1;
+
+   return 0;
+#elif defined(HAVE_FLOCK)
+   return flock(fd, LOCK_EX | LOCK_NB);
+#else
+   struct flock lock = {
+      .l_start = 0,
+      .l_len = 0, /* entire file */
+      .l_type = F_WRLCK,
+      .l_whence = SEEK_SET
+   };
+   return fcntl(fd, F_SETLK, &lock);
+#endif
+}
+
 void
 disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
                               char *filename)
@@ -782,7 +898,7 @@ disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
    if (asprintf(&filename_tmp, "%s.tmp", filename) == -1)
       goto done;
 
-   fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+   fd = open_tmp_file(filename_tmp);
 
    /* Make the two-character subdirectory within the cache as needed. */
    if (fd == -1) {
@@ -791,7 +907,7 @@ disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
 
       make_cache_file_directory(dc_job->cache, dc_job->key);
 
-      fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+      fd = open_tmp_file(filename_tmp);
       if (fd == -1)
          goto done;
    }
@@ -801,17 +917,7 @@ disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
     * open with the flock held. So just let that file be responsible
     * for writing the file.
     */
-#ifdef HAVE_FLOCK
-   int err = flock(fd, LOCK_EX | LOCK_NB);
-#else
-   struct flock lock = {
-      .l_start = 0,
-      .l_len = 0, /* entire file */
-      .l_type = F_WRLCK,
-      .l_whence = SEEK_SET
-   };
-   int err = fcntl(fd, F_SETLK, &lock);
-#endif
+   int err = lock_tmp_file(fd);
    if (err == -1)
       goto done;
 
@@ -859,7 +965,7 @@ disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
       goto done;
    }
 
-   p_atomic_add(&dc_job->cache->size->value, sb.st_blocks * 512);
+   p_atomic_add(&dc_job->cache->size->value, file_disk_size(&sb));
 
  done:
    if (fd_final != -1)
@@ -878,6 +984,8 @@ disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
  *   $MESA_SHADER_CACHE_DIR
  *   $XDG_CACHE_HOME/mesa_shader_cache
  *   <pwd.pw_dir>/.cache/mesa_shader_cache
+ *
+ * On Windows the last one is %LOCALAPPDATA%\mesa_shader_cache instead.
  */
 char *
 disk_cache_generate_cache_dir(void *mem_ctx, const char *gpu_name,
@@ -922,6 +1030,18 @@ disk_cache_generate_cache_dir(void *mem_ctx, const char *gpu_name,
       }
    }
 
+#if DETECT_OS_WINDOWS
+   if (!path) {
+      char *local_app_data = getenv("LOCALAPPDATA");
+
+      if (!local_app_data)
+         return NULL;
+
+      path = concatenate_and_mkdir(mem_ctx, local_app_data, cache_dir_name);
+      if (!path)
+         return NULL;
+   }
+#else
    if (!path) {
       char *buf;
       size_t buf_size;
@@ -956,6 +1076,7 @@ disk_cache_generate_cache_dir(void *mem_ctx, const char *gpu_name,
       if (!path)
          return NULL;
    }
+#endif
 
    if (cache_type == DISK_CACHE_SINGLE_FILE) {
       path = concatenate_and_mkdir(mem_ctx, path, driver_id);
@@ -979,9 +1100,11 @@ disk_cache_enabled()
    if (DETECT_OS_ANDROID)
       return false;
 
+#if !DETECT_OS_WINDOWS
    /* If running as a users other than the real user disable cache */
    if (geteuid() != getuid())
       return false;
+#endif
 
    /* At user request, disable shader cache entirely. */
 #ifdef SHADER_CACHE_DISABLE_BY_DEFAULT
@@ -1065,7 +1188,10 @@ disk_cache_mmap_cache_index(void *mem_ctx, struct disk_cache *cache,
    /* Force the index file to be the expected size. */
    size_t size = sizeof(*cache->size) + CACHE_INDEX_MAX_KEYS * CACHE_KEY_SIZE;
    if (sb.st_size != size) {
-#if HAVE_POSIX_FALLOCATE
+#if DETECT_OS_WINDOWS
+      if (_chsize_s(fd, size) != 0)
+         goto path_fail;
+#elif HAVE_POSIX_FALLOCATE
       /* posix_fallocate() ensures disk space is allocated otherwise it
        * fails if there is not enough space on the disk.
        */
@@ -1096,10 +1222,23 @@ disk_cache_mmap_cache_index(void *mem_ctx, struct disk_cache *cache,
     * guarantees of the cryptographic hash, a corrupt entry is
     * unlikely to ever match a real cache key).
     */
+#if DETECT_OS_WINDOWS
+   HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(fd), NULL,
+                                       PAGE_READWRITE, 0, 0, NULL);
+   if (mapping == NULL)
+      goto path_fail;
+
+   /* The view keeps the mapping alive */
+   cache->index_mmap = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+   CloseHandle(mapping);
+   if (cache->index_mmap == NULL)
+      goto path_fail;
+#else
    cache->index_mmap = mmap(NULL, size, PROT_READ | PROT_WRITE,
                             MAP_SHARED, fd, 0);
    if (cache->index_mmap == MAP_FAILED)
       goto path_fail;
+#endif
    cache->index_mmap_size = size;
 
    cache->size = (p_atomic_uint64_t *) cache->index_mmap;
@@ -1116,7 +1255,11 @@ path_fail:
 void
 disk_cache_destroy_mmap(struct disk_cache *cache)
 {
+#if DETECT_OS_WINDOWS
+   UnmapViewOfFile(cache->index_mmap);
+#else
    munmap(cache->index_mmap, cache->index_mmap_size);
+#endif
 }
 
 void *
@@ -1158,6 +1301,5 @@ disk_cache_db_load_cache_index(void *mem_ctx, struct disk_cache *cache)
 {
    return mesa_cache_db_multipart_open(&cache->cache_db, cache->path);
 }
-#endif
 
 #endif /* ENABLE_SHADER_CACHE */
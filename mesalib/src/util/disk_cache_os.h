@@ -26,12 +26,6 @@
 
 #include "util/u_queue.h"
 
-#if DETECT_OS_WINDOWS
-
-/* TODO: implement disk cache support on windows */
-
-#else
-
 #include "util/fossilize_db.h"
 #include "util/mesa_cache_db.h"
 #include "util/mesa_cache_db_multipart.h"
@@ -182,6 +176,4 @@ disk_cache_db_load_cache_index(void *mem_ctx, struct disk_cache *cache);
 }
 #endif
 
-#endif
-
 #endif /* DISK_CACHE_OS_H */
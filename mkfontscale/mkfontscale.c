@@ -72,6 +72,10 @@
 #define QUOTE(x)	#x
 #define STRINGIFY(x)	QUOTE(x)
 
+/* Index of what was found in each file, for -c */
+#define CACHENAME ".mkfontscale-cache"
+#define CACHEVERSION "mkfontscale-cache 1"
+
 static const char *encodings_array[] = { "ascii-0",
     "iso8859-1", "iso8859-2", "iso8859-3", "iso8859-4", "iso8859-5",
     "iso8859-6", "iso8859-6.8", "iso8859-6.8x", "iso8859-6.16",
@@ -114,6 +118,8 @@ static FT_Library ft_library;
 static float bigEncodingFuzz = 0.02f;
 
 static int relative;
+static int incremental;
+static char *cacheOptions;
 static int doScalable;
 static int doBitmaps;
 static int doISO10646_1_encoding;
@@ -130,7 +136,7 @@ usage(void)
             "mkfontscale [ -b ] [ -s ] [ -o filename ] [-x suffix ]\n"
             "            [ -a encoding ] [ -f fuzz ] [ -l ]\n"
             "            [ -e directory ] [ -p prefix ] [ -n ] [ -r ] \n"
-            "            [-u] [-U] [-v] [ directory ]...\n");
+            "            [-u] [-U] [-c] [-v] [ directory ]...\n");
     exit(1);
 }
 
@@ -248,6 +254,10 @@ main(int argc, char **argv)
             relative = 1;
             argn++;
         }
+        else if (strcmp(argv[argn], "-c") == 0) {
+            incremental = 1;
+            argn++;
+        }
         else if (strcmp(argv[argn], "-l") == 0) {
             reencodeLegacy = !reencodeLegacy;
             argn++;
@@ -290,6 +300,31 @@ main(int argc, char **argv)
 
     ll = listLength(encodingsToDo);
 
+    if (incremental) {
+        ConstListPtr encoding;
+
+        /* the cache is only good for runs that would find the same names */
+        cacheOptions = dsprintf("%d %d %d %d %g", doBitmaps, doScalable,
+                                doISO10646_1_encoding, reencodeLegacy,
+                                (double) bigEncodingFuzz);
+        for (encoding = encodings; encoding && cacheOptions;
+             encoding = encoding->next) {
+            char *o = dsprintf("%s %s", cacheOptions, encoding->value);
+            free(cacheOptions);
+            cacheOptions = o;
+        }
+        for (encoding = extra_encodings; encoding && cacheOptions;
+             encoding = encoding->next) {
+            char *o = dsprintf("%s +%s", cacheOptions, encoding->value);
+            free(cacheOptions);
+            cacheOptions = o;
+        }
+        if (cacheOptions == NULL) {
+            fprintf(stderr, "Couldn't allocate cache options\n");
+            exit(1);
+        }
+    }
+
     if (argn == argc)
         doDirectory(".", ll, encodingsToDo);
     else
@@ -809,6 +844,146 @@ filePrio(char *filename)
     return 0;
 }
 
+/*
+ * With -c, what every file in a directory yielded is kept in CACHENAME
+ * next to the output, along with the file's size and modification time.
+ * Files that haven't changed since are not opened again.  The file looks
+ * like
+ *
+ *     mkfontscale-cache 1
+ *     options <the options that affect which names are found>
+ *     file <size> <mtime> <tprio> <count> <filename>
+ *     <prio> <name>        (count times)
+ *     ...
+ *
+ * and is read into a hash table from file name to
+ * "<size> <mtime> <tprio> <filename>\n<prio> <name>\n...".
+ */
+static HashTablePtr
+readCache(const char *dirname)
+{
+    char *filename;
+    FILE *in;
+    HashTablePtr cache;
+    char line[MAXFONTFILENAMELEN + MAXFONTNAMELEN + 64];
+    char file[MAXFONTFILENAMELEN + 1], font[MAXFONTNAMELEN + 1];
+    long long size, mtime;
+    int tprio, count, prio;
+
+    filename = dsprintf("%s%s", dirname, CACHENAME);
+    if (filename == NULL)
+        return NULL;
+    in = fopen(filename, "r");
+    free(filename);
+    if (in == NULL)
+        return NULL;
+
+    cache = NULL;
+    if (fgets(line, sizeof(line), in) == NULL ||
+        strcmp(line, CACHEVERSION "\n") != 0)
+        goto bail;
+    if (fgets(line, sizeof(line), in) == NULL ||
+        strncmp(line, "options ", 8) != 0 ||
+        strncmp(line + 8, cacheOptions, strlen(cacheOptions)) != 0 ||
+        strcmp(line + 8 + strlen(cacheOptions), "\n") != 0)
+        goto bail;
+
+    cache = makeHashTable();
+    if (cache == NULL)
+        goto bail;
+    while (fscanf(in, "file %lld %lld %d %d "
+                  "%" STRINGIFY(MAXFONTFILENAMELEN) "[^\n]\n",
+                  &size, &mtime, &tprio, &count, file) == 5) {
+        char *value = dsprintf("%lld %lld %d %s\n", size, mtime, tprio, file);
+
+        for (int i = 0; i < count && value; i++) {
+            char *v;
+
+            if (fscanf(in, "%d %" STRINGIFY(MAXFONTNAMELEN) "[^\n]\n",
+                       &prio, font) != 2) {
+                free(value);
+                value = NULL;
+                break;
+            }
+            v = dsprintf("%s%d %s\n", value, prio, font);
+            free(value);
+            value = v;
+        }
+        if (value == NULL)
+            break;
+        putHash(cache, file, value, 0);
+        free(value);
+    }
+
+ bail:
+    fclose(in);
+    return cache;
+}
+
+/*
+ * Return, newest first as doDirectory collects them, the names a file
+ * yielded last time if it hasn't changed since; NULL means rescan it.
+ */
+static int
+lookupCache(HashTablePtr cache, const char *file, struct stat *f_stat,
+            int tprio, ListPtr *names)
+{
+    char *value, *p, *end;
+    long long size, mtime;
+    int t, n;
+
+    if (cache == NULL || (value = getHash(cache, file)) == NULL)
+        return 0;
+    if (sscanf(value, "%lld %lld %d %n", &size, &mtime, &t, &n) != 3)
+        return 0;
+    p = value + n;
+    end = strchr(p, '\n');
+    /* the table ignores case, file names don't */
+    if (end == NULL || (size_t) (end - p) != strlen(file) ||
+        strncmp(p, file, end - p) != 0)
+        return 0;
+    if (size != (long long) f_stat->st_size ||
+        mtime != (long long) f_stat->st_mtime || t != tprio)
+        return 0;
+
+    *names = NULL;
+    for (p = end + 1; *p; p = end + 1) {
+        end = strchr(p, '\n');
+        if (end == NULL)
+            break;
+        *names = listConsF(*names, "%.*s", (int) (end - p), p);
+        if (*names == NULL) {
+            fprintf(stderr, "Couldn't allocate font entry\n");
+            exit(1);
+        }
+    }
+    return 1;
+}
+
+static void
+writeCacheEntry(FILE *out, const char *file, struct stat *f_stat,
+                int tprio, ListPtr names)
+{
+    ListPtr lp;
+
+    fprintf(out, "file %lld %lld %d %d %s\n",
+            (long long) f_stat->st_size, (long long) f_stat->st_mtime,
+            tprio, listLength(names), file);
+    for (lp = names; lp; lp = lp->next)
+        fprintf(out, "%s\n", lp->value);
+}
+
+static ListPtr
+addFileEntry(ListPtr names, int prio, const char *name)
+{
+    names = listConsF(names, "%d %s", prio, name);
+    if (names == NULL) {
+        fprintf(stderr, "Couldn't allocate font entry\n");
+        exit(1);
+    }
+    return names;
+}
+
 static int
 doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
 {
@@ -819,11 +994,13 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
     FT_Face face;
     ConstListPtr encoding;
     ListPtr xlfd, lp;
-    HashTablePtr entries;
+    HashTablePtr entries, cache = NULL;
     HashBucketPtr *array;
     int i, n, dirn, diri, found, rc;
     int isBitmap = 0;
     size_t d, xl = 0;
+    char *cache_name = NULL, *cache_new_name = NULL;
+    FILE *cache_out = NULL;
 
     if (exclusionSuffix)
         xl = strlen(exclusionSuffix);
@@ -880,12 +1057,25 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
         return 0;
     }
 
+    if (incremental) {
+        cache = readCache(dirname);
+        cache_name = dsprintf("%s%s", dirname, CACHENAME);
+        cache_new_name = dsprintf("%s%s.new", dirname, CACHENAME);
+        if (cache_name && cache_new_name)
+            cache_out = fopen(cache_new_name, "w");
+        /* not being able to write the cache just makes the next run slower */
+        if (cache_out)
+            fprintf(cache_out, "%s\noptions %s\n", CACHEVERSION, cacheOptions);
+    }
+
     for (diri = dirn - 1; diri >= 0; diri--) {
         struct dirent *entry = namelist[diri];
         int have_face = 0;
         char *xlfd_name = NULL;
         struct stat f_stat;
         int tprio = 1;
+        int have_stat = 0;
+        ListPtr names = NULL;
 
         xlfd = NULL;
 
@@ -896,6 +1086,11 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
                 continue;
         }
 
+        if (incremental &&
+            (strcmp(entry->d_name, CACHENAME) == 0 ||
+             strcmp(entry->d_name, CACHENAME ".new") == 0))
+            continue;
+
         filename = dsprintf("%s%s", dirname, entry->d_name);
 
 #define PRIO(x) ((x << 1) + tprio)
@@ -918,6 +1113,12 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
 #else
             ;
 #endif
+        if (incremental && stat(filename, &f_stat) == 0) {
+            have_stat = 1;
+            if (lookupCache(cache, entry->d_name, &f_stat, tprio, &names))
+                goto done;
+        }
+
         if (doBitmaps)
             rc = bitmapIdentify(filename, &xlfd_name);
         else
@@ -986,8 +1187,8 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
             }
             else {
                 /* Not a reencodable font -- skip all the rest of the loop body */
-                putHash(entries, xlfd_name, entry->d_name,
-                        PRIO(filePrio(entry->d_name)));
+                names = addFileEntry(names, PRIO(filePrio(entry->d_name)),
+                                     xlfd_name);
                 goto done;
             }
         }
@@ -1023,8 +1224,8 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
                     found = 1;
                     snprintf(buf, MAXFONTNAMELEN, "%s-%s",
                              lp->value, encoding->value);
-                    putHash(entries, buf, entry->d_name,
-                            PRIO(filePrio(entry->d_name)));
+                    names = addFileEntry(names, PRIO(filePrio(entry->d_name)),
+                                         buf);
                 }
             }
             for (encoding = extra_encodings; encoding;
@@ -1033,8 +1234,8 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
                     /* Do not set found! */
                     snprintf(buf, MAXFONTNAMELEN, "%s-%s",
                              lp->value, encoding->value);
-                    putHash(entries, buf, entry->d_name,
-                            PRIO(filePrio(entry->d_name)));
+                    names = addFileEntry(names, PRIO(filePrio(entry->d_name)),
+                                         buf);
                 }
             }
         }
@@ -1043,10 +1244,37 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
             FT_Done_Face(face);
         deepDestroyList(xlfd);
         xlfd = NULL;
+        /* names were collected newest first */
+        names = reverseList(names);
+        for (lp = names; lp; lp = lp->next) {
+            char *name;
+            int prio = (int) strtol(lp->value, &name, 10);
+
+            putHash(entries, name + 1, entry->d_name, prio);
+        }
+        if (cache_out && have_stat)
+            writeCacheEntry(cache_out, entry->d_name, &f_stat, tprio, names);
+        deepDestroyList(names);
         free(filename);
 #undef PRIO
     }
 
+    if (cache)
+        destroyHashTable(cache);
+    if (cache_out) {
+        if (fclose(cache_out) == 0) {
+#ifdef WIN32
+            unlink(cache_name);
+#endif
+            if (rename(cache_new_name, cache_name) != 0)
+                unlink(cache_new_name);
+        }
+        else
+            unlink(cache_new_name);
+    }
+    free(cache_name);
+    free(cache_new_name);
+
     while (dirn--)
         free(namelist[dirn]);
     free(namelist);
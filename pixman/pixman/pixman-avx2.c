@@ -0,0 +1,615 @@
+/*
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * 256-bit versions of the hottest SSE2 combiners and fast paths.  The
+ * arithmetic is the same as in pixman-sse2.c, eight pixels at a time
+ * instead of four, so results are bit for bit identical.  Everything
+ * else falls through to the SSSE3 and SSE2 implementations.
+ */
+#ifdef HAVE_CONFIG_H
+#include <pixman-config.h>
+#endif
+
+#include <string.h>
+#include <immintrin.h>
+#include "pixman-private.h"
+#include "pixman-inlines.h"
+
+/* One pixel, unpacked to 16 bits per channel in the low half of an xmm */
+
+static force_inline __m128i
+unpack_32_1x128 (uint32_t data)
+{
+    return _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (data), _mm_setzero_si128 ());
+}
+
+static force_inline uint32_t
+pack_1x128_32 (__m128i data)
+{
+    return _mm_cvtsi128_si32 (_mm_packus_epi16 (data, _mm_setzero_si128 ()));
+}
+
+static force_inline __m128i
+expand_alpha_1x128 (__m128i data)
+{
+    return _mm_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline __m128i
+expand_pixel_8_1x128 (uint8_t data)
+{
+    return _mm_shufflelo_epi16 (
+	unpack_32_1x128 ((uint32_t)data), _MM_SHUFFLE (0, 0, 0, 0));
+}
+
+static force_inline __m128i
+pix_multiply_1x128 (__m128i data, __m128i alpha)
+{
+    return _mm_mulhi_epu16 (_mm_adds_epu16 (_mm_mullo_epi16 (data, alpha),
+					    _mm_set1_epi16 (0x0080)),
+			    _mm_set1_epi16 (0x0101));
+}
+
+static force_inline __m128i
+over_1x128 (__m128i src, __m128i alpha, __m128i dst)
+{
+    __m128i neg = _mm_xor_si128 (alpha, _mm_set1_epi16 (0x00ff));
+
+    return _mm_adds_epu8 (src, pix_multiply_1x128 (dst, neg));
+}
+
+static force_inline __m128i
+in_over_1x128 (__m128i src, __m128i alpha, __m128i mask, __m128i dst)
+{
+    return over_1x128 (pix_multiply_1x128 (src, mask),
+		       pix_multiply_1x128 (alpha, mask),
+		       dst);
+}
+
+static force_inline uint32_t
+combine1 (const uint32_t *ps, const uint32_t *pm)
+{
+    uint32_t s;
+    memcpy (&s, ps, sizeof(uint32_t));
+
+    if (pm)
+    {
+	__m128i ms, mm;
+
+	mm = expand_alpha_1x128 (unpack_32_1x128 (*pm));
+	ms = pix_multiply_1x128 (unpack_32_1x128 (s), mm);
+
+	s = pack_1x128_32 (ms);
+    }
+
+    return s;
+}
+
+static force_inline uint32_t
+core_combine_over_u_pixel_avx2 (uint32_t src, uint32_t dst)
+{
+    __m128i xmms;
+
+    if ((src >> 24) == 0xff)
+	return src;
+
+    if (!src)
+	return dst;
+
+    xmms = unpack_32_1x128 (src);
+    return pack_1x128_32 (
+	over_1x128 (xmms, expand_alpha_1x128 (xmms), unpack_32_1x128 (dst)));
+}
+
+static force_inline uint32_t
+core_combine_add_u_pixel_avx2 (uint32_t src, uint32_t dst)
+{
+    return _mm_cvtsi128_si32 (
+	_mm_adds_epu8 (_mm_cvtsi32_si128 (src), _mm_cvtsi32_si128 (dst)));
+}
+
+/* Eight pixels.  Unpacking and packing both work within 128-bit lanes,
+ * so the lanes never need to be permuted.
+ */
+
+static force_inline __m256i
+load_256_unaligned (const void *src)
+{
+    return _mm256_loadu_si256 ((const __m256i *)src);
+}
+
+static force_inline __m256i
+load_256_aligned (const void *src)
+{
+    return _mm256_load_si256 ((const __m256i *)src);
+}
+
+static force_inline void
+save_256_aligned (void *dst, __m256i data)
+{
+    _mm256_store_si256 ((__m256i *)dst, data);
+}
+
+static force_inline void
+unpack_256_2x256 (__m256i data, __m256i *data_lo, __m256i *data_hi)
+{
+    *data_lo = _mm256_unpacklo_epi8 (data, _mm256_setzero_si256 ());
+    *data_hi = _mm256_unpackhi_epi8 (data, _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+pack_2x256_256 (__m256i lo, __m256i hi)
+{
+    return _mm256_packus_epi16 (lo, hi);
+}
+
+static force_inline int
+is_opaque_256 (__m256i x)
+{
+    __m256i ffs = _mm256_cmpeq_epi8 (x, x);
+
+    return ((uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, ffs)) &
+	    0x88888888) == 0x88888888;
+}
+
+static force_inline int
+is_zero_256 (__m256i x)
+{
+    return _mm256_testz_si256 (x, x);
+}
+
+static force_inline __m256i
+expand_alpha_256 (__m256i data)
+{
+    return _mm256_shufflehi_epi16 (
+	_mm256_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3)),
+	_MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline __m256i
+expand_alpha_rev_256 (__m256i data)
+{
+    return _mm256_shufflehi_epi16 (
+	_mm256_shufflelo_epi16 (data, _MM_SHUFFLE (0, 0, 0, 0)),
+	_MM_SHUFFLE (0, 0, 0, 0));
+}
+
+static force_inline __m256i
+pix_multiply_256 (__m256i data, __m256i alpha)
+{
+    return _mm256_mulhi_epu16 (
+	_mm256_adds_epu16 (_mm256_mullo_epi16 (data, alpha),
+			   _mm256_set1_epi16 (0x0080)),
+	_mm256_set1_epi16 (0x0101));
+}
+
+static force_inline __m256i
+over_256 (__m256i src, __m256i alpha, __m256i dst)
+{
+    __m256i neg = _mm256_xor_si256 (alpha, _mm256_set1_epi16 (0x00ff));
+
+    return _mm256_adds_epu8 (src, pix_multiply_256 (dst, neg));
+}
+
+static force_inline __m256i
+in_over_256 (__m256i src, __m256i alpha, __m256i mask, __m256i dst)
+{
+    return over_256 (pix_multiply_256 (src, mask),
+		     pix_multiply_256 (alpha, mask),
+		     dst);
+}
+
+/* src OVER dst for eight pixels, src already multiplied by any mask */
+static force_inline __m256i
+over_8888_256 (__m256i src, __m256i dst)
+{
+    __m256i src_lo, src_hi, dst_lo, dst_hi;
+
+    unpack_256_2x256 (src, &src_lo, &src_hi);
+    unpack_256_2x256 (dst, &dst_lo, &dst_hi);
+
+    dst_lo = over_256 (src_lo, expand_alpha_256 (src_lo), dst_lo);
+    dst_hi = over_256 (src_hi, expand_alpha_256 (src_hi), dst_hi);
+
+    return pack_2x256_256 (dst_lo, dst_hi);
+}
+
+/* src IN the alpha of mask, for eight pixels */
+static force_inline __m256i
+combine8 (const uint32_t *ps, const uint32_t *pm)
+{
+    __m256i s = load_256_unaligned (ps);
+    __m256i m, s_lo, s_hi, m_lo, m_hi;
+
+    if (!pm)
+	return s;
+
+    m = load_256_unaligned (pm);
+    unpack_256_2x256 (s, &s_lo, &s_hi);
+    unpack_256_2x256 (m, &m_lo, &m_hi);
+
+    s_lo = pix_multiply_256 (s_lo, expand_alpha_256 (m_lo));
+    s_hi = pix_multiply_256 (s_hi, expand_alpha_256 (m_hi));
+
+    return pack_2x256_256 (s_lo, s_hi);
+}
+
+static void
+avx2_combine_over_u (pixman_implementation_t *imp,
+                     pixman_op_t              op,
+                     uint32_t *               pd,
+                     const uint32_t *         ps,
+                     const uint32_t *         pm,
+                     int                      w)
+{
+    uint32_t s;
+
+    /* Align dst on a 32-byte boundary */
+    while (w && ((uintptr_t)pd & 31))
+    {
+	s = combine1 (ps, pm);
+
+	if (s)
+	    *pd = core_combine_over_u_pixel_avx2 (s, *pd);
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m256i src;
+
+	if (pm && is_zero_256 (load_256_unaligned (pm)))
+	    goto next;
+
+	src = combine8 (ps, pm);
+
+	if (is_opaque_256 (src))
+	    save_256_aligned (pd, src);
+	else if (!is_zero_256 (src))
+	    save_256_aligned (pd, over_8888_256 (src, load_256_aligned (pd)));
+
+    next:
+	ps += 8;
+	pd += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	s = combine1 (ps, pm);
+
+	if (s)
+	    *pd = core_combine_over_u_pixel_avx2 (s, *pd);
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+}
+
+static void
+avx2_combine_add_u (pixman_implementation_t *imp,
+                    pixman_op_t              op,
+                    uint32_t *               pd,
+                    const uint32_t *         ps,
+                    const uint32_t *         pm,
+                    int                      w)
+{
+    while (w && ((uintptr_t)pd & 31))
+    {
+	*pd = core_combine_add_u_pixel_avx2 (combine1 (ps, pm), *pd);
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	save_256_aligned (
+	    pd, _mm256_adds_epu8 (combine8 (ps, pm), load_256_aligned (pd)));
+
+	ps += 8;
+	pd += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	*pd = core_combine_add_u_pixel_avx2 (combine1 (ps, pm), *pd);
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+}
+
+static void
+avx2_composite_over_8888_8888 (pixman_implementation_t *imp,
+                               pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_over_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_add_8888_8888 (pixman_implementation_t *imp,
+                              pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_add_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_src_x888_8888 (pixman_implementation_t *imp,
+                              pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    int32_t w;
+    int dst_stride, src_stride;
+    __m256i alpha = _mm256_set1_epi32 ((int)0xff000000);
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w && (uintptr_t)dst & 31)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+
+	while (w >= 32)
+	{
+	    __m256i s0 = load_256_unaligned (src + 0);
+	    __m256i s1 = load_256_unaligned (src + 8);
+	    __m256i s2 = load_256_unaligned (src + 16);
+	    __m256i s3 = load_256_unaligned (src + 24);
+
+	    save_256_aligned (dst + 0, _mm256_or_si256 (s0, alpha));
+	    save_256_aligned (dst + 8, _mm256_or_si256 (s1, alpha));
+	    save_256_aligned (dst + 16, _mm256_or_si256 (s2, alpha));
+	    save_256_aligned (dst + 24, _mm256_or_si256 (s3, alpha));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	while (w >= 8)
+	{
+	    save_256_aligned (
+		dst, _mm256_or_si256 (load_256_unaligned (src), alpha));
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+
+	while (w)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+    }
+}
+
+static void
+avx2_composite_over_n_8_8888 (pixman_implementation_t *imp,
+                              pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src, srca;
+    uint32_t *dst_line, *dst;
+    uint8_t *mask_line, *mask;
+    int dst_stride, mask_stride;
+    int32_t w;
+
+    __m128i xmm_src, xmm_alpha;
+    __m256i ymm_def, ymm_src, ymm_alpha;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    srca = src >> 24;
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    xmm_src = unpack_32_1x128 (src);
+    xmm_alpha = expand_alpha_1x128 (xmm_src);
+
+    ymm_def = _mm256_set1_epi32 ((int)src);
+    ymm_src = _mm256_unpacklo_epi8 (ymm_def, _mm256_setzero_si256 ());
+    ymm_alpha = expand_alpha_256 (ymm_src);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	while (w && (uintptr_t)dst & 31)
+	{
+	    uint8_t m = *mask++;
+
+	    if (m)
+	    {
+		*dst = pack_1x128_32 (
+		    in_over_1x128 (xmm_src, xmm_alpha,
+				   expand_pixel_8_1x128 (m),
+				   unpack_32_1x128 (*dst)));
+	    }
+
+	    w--;
+	    dst++;
+	}
+
+	while (w >= 8)
+	{
+	    uint64_t m;
+	    memcpy (&m, mask, sizeof(uint64_t));
+
+	    if (srca == 0xff && m == 0xffffffffffffffffULL)
+	    {
+		save_256_aligned (dst, ymm_def);
+	    }
+	    else if (m)
+	    {
+		__m256i ymm_dst, dst_lo, dst_hi, mask_lo, mask_hi;
+		__m256i ymm_mask;
+
+		/* Spread the eight mask bytes out to one per 32-bit pixel,
+		 * in the same lane order as unpack_256_2x256 () leaves the
+		 * destination.
+		 */
+		ymm_mask = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((__m128i *)mask));
+
+		ymm_dst = load_256_aligned (dst);
+		unpack_256_2x256 (ymm_dst, &dst_lo, &dst_hi);
+		unpack_256_2x256 (ymm_mask, &mask_lo, &mask_hi);
+
+		mask_lo = expand_alpha_rev_256 (mask_lo);
+		mask_hi = expand_alpha_rev_256 (mask_hi);
+
+		dst_lo = in_over_256 (ymm_src, ymm_alpha, mask_lo, dst_lo);
+		dst_hi = in_over_256 (ymm_src, ymm_alpha, mask_hi, dst_hi);
+
+		save_256_aligned (dst, pack_2x256_256 (dst_lo, dst_hi));
+	    }
+
+	    w -= 8;
+	    dst += 8;
+	    mask += 8;
+	}
+
+	while (w)
+	{
+	    uint8_t m = *mask++;
+
+	    if (m)
+	    {
+		*dst = pack_1x128_32 (
+		    in_over_1x128 (xmm_src, xmm_alpha,
+				   expand_pixel_8_1x128 (m),
+				   unpack_32_1x128 (*dst)));
+	    }
+
+	    w--;
+	    dst++;
+	}
+    }
+}
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    /* PIXMAN_OP_OVER */
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8b8g8r8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8b8g8r8, avx2_composite_over_n_8_8888),
+
+    /* PIXMAN_OP_ADD */
+    PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, avx2_composite_add_8888_8888),
+    PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, avx2_composite_add_8888_8888),
+
+    /* PIXMAN_OP_SRC */
+    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, avx2_composite_src_x888_8888),
+    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, avx2_composite_src_x888_8888),
+
+    { PIXMAN_OP_NONE },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp =
+	_pixman_implementation_create (fallback, avx2_fast_paths);
+
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    return imp;
+}
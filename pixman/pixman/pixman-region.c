@@ -202,18 +202,75 @@ PIXREGION_SZOF (size_t n)
     return size + sizeof(region_data_type_t);
 }
 
+/* Window validation and damage produce bursts of regions of a handful
+ * of boxes, each of which used to cost a malloc and a free.  Data blocks
+ * for up to SMALL_DATA_BOXES boxes are all allocated at that size and
+ * kept on a short per-thread free list when they are released.  A block
+ * is recognised by its size field, so blocks allocated or freed by the
+ * caller with plain malloc and free mix freely with cached ones.
+ * pixman_op () sizes its result at twice the larger operand, so this
+ * covers operations on regions of up to eight boxes.
+ */
+#define SMALL_DATA_BOXES 16
+#define SMALL_DATA_CACHE 16
+
+typedef struct
+{
+    int                 n_free;
+    region_data_type_t *free[SMALL_DATA_CACHE];
+} small_data_cache_t;
+
+PIXMAN_DEFINE_THREAD_LOCAL (small_data_cache_t, small_data_cache)
+
 static region_data_type_t *
 alloc_data (size_t n)
 {
-    size_t sz = PIXREGION_SZOF (n);
+    region_data_type_t *data;
+    size_t sz;
+
+    if (n <= SMALL_DATA_BOXES)
+    {
+	small_data_cache_t *cache = PIXMAN_GET_THREAD_LOCAL (small_data_cache);
+
+	if (cache && cache->n_free)
+	    return cache->free[--cache->n_free];
+
+	n = SMALL_DATA_BOXES;
+    }
+
+    sz = PIXREGION_SZOF (n);
 
     if (!sz)
 	return NULL;
 
-    return malloc (sz);
+    data = malloc (sz);
+    if (data)
+	data->size = n;
+
+    return data;
+}
+
+static void
+free_data (region_data_type_t *data)
+{
+    if (!data || !data->size)
+	return;
+
+    if (data->size == SMALL_DATA_BOXES)
+    {
+	small_data_cache_t *cache = PIXMAN_GET_THREAD_LOCAL (small_data_cache);
+
+	if (cache && cache->n_free < SMALL_DATA_CACHE)
+	{
+	    cache->free[cache->n_free++] = data;
+	    return;
+	}
+    }
+
+    free (data);
 }
 
-#define FREE_DATA(reg) if ((reg)->data && (reg)->data->size) free ((reg)->data)
+#define FREE_DATA(reg) free_data ((reg)->data)
 
 #define RECTALLOC_BAIL(region, n, bail)					\
     do									\
@@ -497,9 +554,8 @@ pixman_rect_alloc (region_type_t * region,
 	    return pixman_break (region);
 	
 	region->data = data;
+	region->data->size = n;
     }
-    
-    region->data->size = n;
 
     return TRUE;
 }
@@ -530,8 +586,6 @@ PREFIX (_copy) (region_type_t *dst, const region_type_t *src)
 
 	if (!dst->data)
 	    return pixman_break (dst);
-
-	dst->data->size = src->data->numRects;
     }
 
     dst->data->numRects = src->data->numRects;
@@ -827,7 +881,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     {
         if (!pixman_rect_alloc (new_reg, new_size))
         {
-            free (old_data);
+            free_data (old_data);
             return FALSE;
 	}
     }
@@ -1002,7 +1056,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
         APPEND_REGIONS (new_reg, r2_band_end, r2_end);
     }
 
-    free (old_data);
+    free_data (old_data);
 
     if (!(numRects = new_reg->data->numRects))
     {
@@ -1023,7 +1077,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     return TRUE;
 
 bail:
-    free (old_data);
+    free_data (old_data);
 
     return pixman_break (new_reg);
 }
@@ -2068,32 +2122,47 @@ PREFIX (_inverse) (region_type_t *      new_reg,  /* Destination region */
 static box_type_t *
 find_box_for_y (box_type_t *begin, box_type_t *end, int y)
 {
-    box_type_t *mid;
+    while (end - begin > 1)
+    {
+	box_type_t *mid = begin + (end - begin) / 2;
+
+	/* If no box is found in [begin, mid], the answer is @mid */
+	if (mid->y2 > y)
+	    end = mid;
+	else
+	    begin = mid;
+    }
 
-    if (end == begin)
+    if (begin != end && begin->y2 <= y)
 	return end;
+    else
+	return begin;
+}
+
+/* Find the first box in [begin, end) that is either past the band that
+ * begins at @begin or reaches right of @x.  The boxes of a band are
+ * sorted by x and the bands by y, so the boxes to skip come first.
+ * Return @end if no such box exists.
+ */
+static box_type_t *
+find_box_for_x (box_type_t *begin, box_type_t *end, int x)
+{
+    int y1 = begin->y1;
 
-    if (end - begin == 1)
+    while (end - begin > 1)
     {
-	if (begin->y2 > y)
-	    return begin;
+	box_type_t *mid = begin + (end - begin) / 2;
+
+	if (mid->y1 == y1 && mid->x2 <= x)
+	    begin = mid;
 	else
-	    return end;
+	    end = mid;
     }
 
-    mid = begin + (end - begin) / 2;
-    if (mid->y2 > y)
-    {
-	/* If no box is found in [begin, mid], the function
-	 * will return @mid, which is then known to be the
-	 * correct answer.
-	 */
-	return find_box_for_y (begin, mid, y);
-    }
+    if (begin->y1 == y1 && begin->x2 <= x)
+	return end;
     else
-    {
-	return find_box_for_y (mid, end, y);
-    }
+	return begin;
 }
 
 /*
@@ -2167,7 +2236,15 @@ PREFIX (_contains_rectangle) (const region_type_t *  region,
 	}
 
         if (pbox->x2 <= x)
-	    continue;           /* not far enough over yet */
+        {
+	    /* not far enough over yet; skip to the first box that is,
+	     * stepping over one box and searching past any more
+	     */
+	    if (pbox + 1 != pbox_end && pbox[1].y1 == pbox->y1 &&
+		pbox[1].x2 <= x)
+		pbox = find_box_for_x (pbox + 1, pbox_end, x) - 1;
+	    continue;
+	}
 
         if (pbox->x1 > x)
         {
@@ -2790,7 +2867,7 @@ PREFIX (_init_from_image) (region_type_t *region,
         region->extents.y2 = PIXREGION_END(region)->y2;
         if (region->data->numRects == 1)
         {
-            free (region->data);
+            free_data (region->data);
             region->data = NULL;
         }
     }
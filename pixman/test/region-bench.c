@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+/* Times the small region operations that window validation and damage
+ * tracking do in bursts: a region of a few boxes is built, combined with
+ * another small region and thrown away again.
+ *
+ * The second table uses regions shaped like those of an X desktop
+ * session: the clip list of a window partly covered by a stack of other
+ * windows, and the damage a terminal leaves when it redraws runs of
+ * glyphs on some of its lines.  It times combining them and asking
+ * whether glyph-sized rectangles are inside the clip list, which is what
+ * the server does for every piece of drawing.
+ */
+
+#define N_REGIONS 256
+#define N_ITERATIONS 2000
+
+#define N_SESSIONS 64
+#define N_SESSION_ITERATIONS 200
+#define N_GLYPHS 256
+
+static void
+make_region (pixman_region32_t *region, int n_boxes)
+{
+    pixman_box32_t boxes[16];
+    int i;
+
+    for (i = 0; i < n_boxes; i++)
+    {
+	int x = prng_rand_n (1000);
+	int y = i * 40 + prng_rand_n (20);
+
+	boxes[i].x1 = x;
+	boxes[i].y1 = y;
+	boxes[i].x2 = x + 1 + prng_rand_n (200);
+	boxes[i].y2 = y + 1 + prng_rand_n (20);
+    }
+
+    pixman_region32_init_rects (region, boxes, n_boxes);
+}
+
+/* The part of a 1000x800 window not covered by n_windows others */
+static void
+make_clip (pixman_region32_t *region, int n_windows)
+{
+    int i;
+
+    pixman_region32_init_rect (region, 0, 0, 1000, 800);
+
+    for (i = 0; i < n_windows; i++)
+    {
+	pixman_region32_t above;
+	int x = prng_rand_n (1200) - 200;
+	int y = prng_rand_n (1000) - 200;
+
+	pixman_region32_init_rect (&above, x, y,
+				   100 + prng_rand_n (400),
+				   50 + prng_rand_n (300));
+	pixman_region32_subtract (region, region, &above);
+	pixman_region32_fini (&above);
+    }
+}
+
+/* Runs of 10x20 glyph cells redrawn on some of 40 terminal lines */
+static void
+make_damage (pixman_region32_t *region, pixman_box32_t *glyphs)
+{
+    pixman_box32_t boxes[40];
+    int i, n_boxes = 0;
+
+    for (i = 0; i < 40; i++)
+    {
+	int col, len;
+
+	if (prng_rand_n (3))
+	    continue;
+	col = prng_rand_n (100);
+	len = 1 + prng_rand_n (100 - col);
+	boxes[n_boxes].x1 = col * 10;
+	boxes[n_boxes].y1 = i * 20;
+	boxes[n_boxes].x2 = (col + len) * 10;
+	boxes[n_boxes].y2 = (i + 1) * 20;
+	n_boxes++;
+    }
+    pixman_region32_init_rects (region, boxes, n_boxes);
+
+    for (i = 0; i < N_GLYPHS; i++)
+    {
+	glyphs[i].x1 = prng_rand_n (100) * 10;
+	glyphs[i].y1 = prng_rand_n (40) * 20;
+	glyphs[i].x2 = glyphs[i].x1 + 10;
+	glyphs[i].y2 = glyphs[i].y1 + 20;
+    }
+}
+
+static void
+bench_session (void)
+{
+    static pixman_region32_t clip[N_SESSIONS], damage[N_SESSIONS];
+    static pixman_box32_t glyphs[N_SESSIONS][N_GLYPHS];
+    int n_windows;
+
+    printf ("\n# %-7s %-6s %-14s %-14s %-14s %-14s\n", "windows", "boxes",
+	    "union / ns", "intersect / ns", "subtract / ns", "contains / ns");
+
+    for (n_windows = 0; n_windows <= 32;
+	 n_windows = n_windows ? n_windows * 2 : 1)
+    {
+	double t[4];
+	int op, i, j, k, n_boxes = 0;
+
+	for (i = 0; i < N_SESSIONS; i++)
+	{
+	    make_clip (&clip[i], n_windows);
+	    make_damage (&damage[i], glyphs[i]);
+	    n_boxes += pixman_region32_n_rects (&clip[i]);
+	}
+
+	for (op = 0; op < 3; op++)
+	{
+	    double t1 = gettime ();
+
+	    for (j = 0; j < N_SESSION_ITERATIONS; j++)
+	    {
+		for (i = 0; i < N_SESSIONS; i++)
+		{
+		    pixman_region32_t r;
+
+		    pixman_region32_init (&r);
+		    if (op == 0)
+			pixman_region32_union (&r, &clip[i], &damage[i]);
+		    else if (op == 1)
+			pixman_region32_intersect (&r, &clip[i], &damage[i]);
+		    else
+			pixman_region32_subtract (&r, &clip[i], &damage[i]);
+		    pixman_region32_fini (&r);
+		}
+	    }
+
+	    t[op] = (gettime () - t1) * 1e9 /
+		(N_SESSION_ITERATIONS * N_SESSIONS);
+	}
+
+	{
+	    double t1 = gettime ();
+
+	    for (j = 0; j < N_SESSION_ITERATIONS; j++)
+	    {
+		for (i = 0; i < N_SESSIONS; i++)
+		{
+		    for (k = 0; k < N_GLYPHS; k++)
+		    {
+			pixman_region32_contains_rectangle (&clip[i],
+							    &glyphs[i][k]);
+		    }
+		}
+	    }
+
+	    t[3] = (gettime () - t1) * 1e9 /
+		((double)N_SESSION_ITERATIONS * N_SESSIONS * N_GLYPHS);
+	}
+
+	printf ("  %-7d %-6d %-14.1f %-14.1f %-14.1f %-14.1f\n",
+		n_windows, n_boxes / N_SESSIONS, t[0], t[1], t[2], t[3]);
+
+	for (i = 0; i < N_SESSIONS; i++)
+	{
+	    pixman_region32_fini (&clip[i]);
+	    pixman_region32_fini (&damage[i]);
+	}
+    }
+}
+
+int
+main ()
+{
+    static pixman_region32_t a[N_REGIONS], b[N_REGIONS];
+    int n_boxes;
+
+    prng_srand (0x2f41);
+
+    printf ("# %-6s %-14s %-14s %-14s\n",
+	    "boxes", "union / ns", "intersect / ns", "subtract / ns");
+
+    for (n_boxes = 1; n_boxes <= 8; n_boxes++)
+    {
+	double t[3];
+	int op, i, j;
+
+	for (i = 0; i < N_REGIONS; i++)
+	{
+	    make_region (&a[i], n_boxes);
+	    make_region (&b[i], n_boxes);
+	}
+
+	for (op = 0; op < 3; op++)
+	{
+	    double t1 = gettime ();
+
+	    for (j = 0; j < N_ITERATIONS; j++)
+	    {
+		for (i = 0; i < N_REGIONS; i++)
+		{
+		    pixman_region32_t r;
+
+		    pixman_region32_init (&r);
+		    if (op == 0)
+			pixman_region32_union (&r, &a[i], &b[i]);
+		    else if (op == 1)
+			pixman_region32_intersect (&r, &a[i], &b[i]);
+		    else
+			pixman_region32_subtract (&r, &a[i], &b[i]);
+		    pixman_region32_fini (&r);
+		}
+	    }
+
+	    t[op] = (gettime () - t1) * 1e9 / (N_ITERATIONS * N_REGIONS);
+	}
+
+	printf ("  %-6d %-14.1f %-14.1f %-14.1f\n",
+		n_boxes, t[0], t[1], t[2]);
+
+	for (i = 0; i < N_REGIONS; i++)
+	{
+	    pixman_region32_fini (&a[i]);
+	    pixman_region32_fini (&b[i]);
+	}
+    }
+
+    bench_session ();
+
+    return 0;
+}
@@ -37,6 +37,11 @@ struct static_extension_info_t {
 	const char *strings_xge_events;
 	const char *strings_events;
 	const char *strings_errors;
+	/* Offset of each name in the strings_* above */
+	const uint16_t *offsets_minor;
+	const uint16_t *offsets_xge_events;
+	const uint16_t *offsets_events;
+	const uint16_t *offsets_errors;
 	const char *name;
 };
 
@@ -94,10 +94,35 @@ output.write("#include \"errors.h\"\n")
 output.write("#include <string.h>\n")
 output.write("\n")
 
-def format_strings(name, table):
+def offsets_name(module, name):
+    prefix = "extension_" if module.is_ext else ""
+    return "%s%s_offsets_%s" % (prefix, module.name, name)
+
+def emit_offsets(module, name, table):
+    # The offset of each name in the string emitted by format_strings, so
+    # that a lookup does not have to walk the strings before it
+    if table is None:
+        return
+    offsets = []
+    offset = 0
+    for entry in table:
+        offsets.append(offset)
+        offset += len(entry) + 1
+    assert offset < 65536
+    output.write("static const uint16_t %s[] = {" % offsets_name(module, name))
+    for idx in range(len(offsets)):
+        if idx % 12 == 0:
+            output.write("\n\t")
+        else:
+            output.write(" ")
+        output.write("%d," % offsets[idx])
+    output.write("\n};\n\n")
+
+def format_strings(module, name, table):
     if table is None:
         output.write("\t.num_%s = 0,\n" % name)
         output.write("\t.strings_%s = NULL,\n" % name)
+        output.write("\t.offsets_%s = NULL,\n" % name)
     else:
         if len(table) == 256:
             # This must be xproto and the value isn't used, so instead use
@@ -106,6 +131,7 @@ def format_strings(name, table):
         else:
             output.write("\t.num_%s = %d,\n" % (name, len(table)))
         output.write("\t.strings_%s = \"%s\\0\",\n" % (name, "\\0".join(table)))
+        output.write("\t.offsets_%s = %s,\n" % (name, offsets_name(module, name)))
 
 def emit_module(module):
     t = ""
@@ -114,11 +140,15 @@ def emit_module(module):
         t = "static "
     else:
         prefix = ""
+    emit_offsets(module, "minor", module.requests_table)
+    emit_offsets(module, "events", module.events_table)
+    emit_offsets(module, "xge_events", module.xge_events_table)
+    emit_offsets(module, "errors", module.errors_table)
     output.write("%sconst struct static_extension_info_t %s%s_info = { // %s\n" % (t, prefix, module.name, module.xname))
-    format_strings("minor", module.requests_table)
-    format_strings("events", module.events_table)
-    format_strings("xge_events", module.xge_events_table)
-    format_strings("errors", module.errors_table)
+    format_strings(module, "minor", module.requests_table)
+    format_strings(module, "events", module.events_table)
+    format_strings(module, "xge_events", module.xge_events_table)
+    format_strings(module, "errors", module.errors_table)
     output.write("\t.name = \"%s\",\n" % module.name)
     output.write("};\n\n")
 
@@ -43,12 +43,61 @@ struct extension_info_t {
 
 struct xcb_errors_context_t {
 	struct extension_info_t *extensions;
+	/* Indexes over the list above, filled in once the extensions are
+	 * known, so that no lookup has to walk it.
+	 */
+	struct extension_info_t *by_major_opcode[256];
+	struct extension_info_t *by_event[128];
+	struct extension_info_t *by_error[256];
+	struct extension_info_t *xkb;
 };
 
-static const char *get_strings_entry(const char *strings, unsigned int index) {
-	while (index-- > 0)
-		strings += strlen(strings) + 1;
-	return strings;
+#define get_strings_entry(info, kind, index) \
+	((info)->strings_##kind + (info)->offsets_##kind[index])
+
+static void build_indexes(xcb_errors_context_t *ctx)
+{
+	struct extension_info_t *info;
+	unsigned int code;
+
+	for (info = ctx->extensions; info; info = info->next) {
+		ctx->by_major_opcode[info->major_opcode] = info;
+		if (strcmp(info->static_info->name, "xkb") == 0)
+			ctx->xkb = info;
+	}
+
+	/* For each code, the extension with the largest first_event (or
+	 * first_error) <= code.  Thanks to this we do the right thing if the
+	 * server only supports an older version of some extension which had
+	 * less events.  Codes that extension has no name for are left to
+	 * xproto.
+	 */
+	for (info = ctx->extensions; info; info = info->next) {
+		if (info->first_event != 0) {
+			for (code = info->first_event; code < 128; code++) {
+				struct extension_info_t *best = ctx->by_event[code];
+				if (best == NULL || best->first_event <= info->first_event)
+					ctx->by_event[code] = info;
+			}
+		}
+		if (info->first_error != 0) {
+			for (code = info->first_error; code < 256; code++) {
+				struct extension_info_t *best = ctx->by_error[code];
+				if (best == NULL || best->first_error <= info->first_error)
+					ctx->by_error[code] = info;
+			}
+		}
+	}
+	for (code = 0; code < 128; code++) {
+		info = ctx->by_event[code];
+		if (info && code - info->first_event >= info->static_info->num_events)
+			ctx->by_event[code] = NULL;
+	}
+	for (code = 0; code < 256; code++) {
+		info = ctx->by_error[code];
+		if (info && code - info->first_error >= info->static_info->num_errors)
+			ctx->by_error[code] = NULL;
+	}
 }
 
 int register_extension(xcb_errors_context_t *ctx, xcb_connection_t *conn,
@@ -86,7 +135,7 @@ int xcb_errors_context_new(xcb_connection_t *conn, xcb_errors_context_t **c)
 {
 	xcb_errors_context_t *ctx = NULL;
 
-	if ((*c = calloc(1, sizeof(*c))) == NULL)
+	if ((*c = calloc(1, sizeof(**c))) == NULL)
 		goto error_out;
 
 	ctx = *c;
@@ -95,6 +144,8 @@ int xcb_errors_context_new(xcb_connection_t *conn, xcb_errors_context_t **c)
 	if (register_extensions(ctx, conn) != 0)
 		goto error_out;
 
+	build_indexes(ctx);
+
 	return 0;
 
 error_out:
@@ -127,12 +178,9 @@ const char *xcb_errors_get_name_for_major_code(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	info = ctx->extensions;
-	while (info && info->major_opcode != major_code)
-		info = info->next;
-
+	info = ctx->by_major_opcode[major_code];
 	if (info == NULL)
-		return get_strings_entry(xproto_info.strings_minor, major_code);
+		return get_strings_entry(&xproto_info, minor, major_code);
 
 	return info->static_info->name;
 }
@@ -145,14 +193,11 @@ const char *xcb_errors_get_name_for_minor_code(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	info = ctx->extensions;
-	while (info && info->major_opcode != major_code)
-		info = info->next;
-
+	info = ctx->by_major_opcode[major_code];
 	if (info == NULL || minor_code >= info->static_info->num_minor)
 		return NULL;
 
-	return get_strings_entry(info->static_info->strings_minor, minor_code);
+	return get_strings_entry(info->static_info, minor, minor_code);
 }
 
 const char *xcb_errors_get_name_for_xge_event(xcb_errors_context_t *ctx,
@@ -162,21 +207,17 @@ const char *xcb_errors_get_name_for_xge_event(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	info = ctx->extensions;
-	while (info && info->major_opcode != major_code)
-		info = info->next;
-
+	info = ctx->by_major_opcode[major_code];
 	if (info == NULL || event_type >= info->static_info->num_xge_events)
 		return NULL;
 
-	return get_strings_entry(info->static_info->strings_xge_events, event_type);
+	return get_strings_entry(info->static_info, xge_events, event_type);
 }
 
 const char *xcb_errors_get_name_for_core_event(xcb_errors_context_t *ctx,
 		uint8_t event_code, const char **extension)
 {
-	struct extension_info_t *best = NULL;
-	struct extension_info_t *next;
+	struct extension_info_t *best;
 
 	event_code &= 0x7f;
 	if (extension)
@@ -184,69 +225,36 @@ const char *xcb_errors_get_name_for_core_event(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	/* Find the extension with the largest first_event <= event_code. Thanks
-	 * to this we do the right thing if the server only supports an older
-	 * version of some extension which had less events.
-	 */
-	next = ctx->extensions;
-	while (next) {
-		struct extension_info_t *current = next;
-		next = next->next;
-
-		if (current->first_event > event_code)
-			continue;
-		if (best != NULL && best->first_event > current->first_event)
-			continue;
-		best = current;
-	}
-
-	if (best == NULL || best->first_event == 0
-			|| event_code - best->first_event >= best->static_info->num_events) {
+	best = ctx->by_event[event_code];
+	if (best == NULL) {
 		/* Nothing found */
-		return get_strings_entry(xproto_info.strings_events, event_code);
+		return get_strings_entry(&xproto_info, events, event_code);
 	}
 
 	if (extension)
 		*extension = best->static_info->name;
-	return get_strings_entry(best->static_info->strings_events, event_code - best->first_event);
+	return get_strings_entry(best->static_info, events, event_code - best->first_event);
 }
 
 const char *xcb_errors_get_name_for_error(xcb_errors_context_t *ctx,
 		uint8_t error_code, const char **extension)
 {
-	struct extension_info_t *best = NULL;
-	struct extension_info_t *next;
+	struct extension_info_t *best;
 
 	if (extension)
 		*extension = NULL;
 
 	CHECK_CONTEXT(ctx);
 
-	/* Find the extension with the largest first_error <= error_code. Thanks
-	 * to this we do the right thing if the server only supports an older
-	 * version of some extension which had less events.
-	 */
-	next = ctx->extensions;
-	while (next) {
-		struct extension_info_t *current = next;
-		next = next->next;
-
-		if (current->first_error > error_code)
-			continue;
-		if (best != NULL && best->first_error > current->first_error)
-			continue;
-		best = current;
-	}
-
-	if (best == NULL || best->first_error == 0
-			|| error_code - best->first_error >= best->static_info->num_errors) {
+	best = ctx->by_error[error_code];
+	if (best == NULL) {
 		/* Nothing found */
-		return get_strings_entry(xproto_info.strings_errors, error_code);
+		return get_strings_entry(&xproto_info, errors, error_code);
 	}
 
 	if (extension)
 		*extension = best->static_info->name;
-	return get_strings_entry(best->static_info->strings_errors, error_code - best->first_error);
+	return get_strings_entry(best->static_info, errors, error_code - best->first_error);
 }
 
 const char *xcb_errors_get_name_for_xcb_event(xcb_errors_context_t *ctx,
@@ -260,10 +268,7 @@ const char *xcb_errors_get_name_for_xcb_event(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	/* Find the xkb extension, if present */
-	xkb = ctx->extensions;
-	while (xkb != NULL && strcmp(xkb->static_info->name, "xkb") != 0)
-		xkb = xkb->next;
+	xkb = ctx->xkb;
 
 	response_type = event->response_type & 0x7f;
 	if (response_type == XCB_GE_GENERIC) {
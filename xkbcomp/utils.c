@@ -283,29 +283,14 @@ uStringDup(const char *str)
 int
 uStrCaseCmp(const char *str1, const char *str2)
 {
-    char buf1[512], buf2[512];
-    char c, *s;
-    int n;
+    int c1, c2;
 
-    for (n = 0, s = buf1; (c = *str1++); n++)
+    do
     {
-        if (isupper(c))
-            c = tolower(c);
-        if (n > 510)
-            break;
-        *s++ = c;
-    }
-    *s = '\0';
-    for (n = 0, s = buf2; (c = *str2++); n++)
-    {
-        if (isupper(c))
-            c = tolower(c);
-        if (n > 510)
-            break;
-        *s++ = c;
-    }
-    *s = '\0';
-    return (strcmp(buf1, buf2));
+        c1 = tolower((unsigned char) *str1++);
+        c2 = tolower((unsigned char) *str2++);
+    } while ((c1 == c2) && (c1 != '\0'));
+    return c1 - c2;
 }
 
 int
@@ -591,9 +591,13 @@ yyGetIdent(int first)
     scanBuf[j++] = '\0';
     found = 0;
 
+    /* The keywords are all lower case; most identifiers are not keywords
+       and differ in the first character already */
+    first = tolower(first);
     for (int i = 0; (!found) && (i < numKeywords); i++)
     {
-        if (uStrCaseCmp(scanBuf, keywords[i].keyword) == 0)
+        if ((keywords[i].keyword[0] == first) &&
+            (uStrCaseCmp(scanBuf, keywords[i].keyword) == 0))
         {
             rtrn = keywords[i].token;
             found = 1;
@@ -0,0 +1,358 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * IMAGE-CACHE: PutImage by content key.
+ *
+ * Applications that redraw the same images over and over (dashboards,
+ * charts refreshed every second) send the same PutImage payloads each
+ * time.  With this extension the client sends a key for the image; the
+ * data goes over the wire only the first time, or after it has been
+ * evicted.  See <X11/extensions/imagecacheproto.h> for the rules that let
+ * the client track the cache contents without round trips.
+ *
+ * Each client has its own cache: keys are chosen by the client, so
+ * sharing entries would let one client draw, or probe for, another
+ * client's images.  Entries are kept exactly as they arrived and go
+ * through DoPutImage like any PutImage data when drawn.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#include "misc.h"
+#include "os.h"
+#include "dixstruct.h"
+#include "extnsionst.h"
+#include "privates.h"
+#include "list.h"
+#include "hashtable.h"
+#include <X11/extensions/imagecacheproto.h>
+#include "extinit.h"
+
+#define IMAGE_CACHE_BUDGET      (16 * 1024 * 1024)
+
+typedef struct _ImageCacheEntry {
+    struct xorg_list lru;       /* most recently used first */
+    CARD32 key[4];
+    long size;
+    char *data;                 /* follows the entry */
+} ImageCacheEntryRec, *ImageCacheEntryPtr;
+
+typedef struct _ImageCache {
+    HashTable entries;          /* key -> ImageCacheEntryPtr */
+    struct xorg_list lru;
+    long used;
+} ImageCacheRec, *ImageCachePtr;
+
+static DevPrivateKeyRec ImageCacheClientPrivateKeyRec;
+
+#define ImageCacheClientPrivateKey (&ImageCacheClientPrivateKeyRec)
+
+static int ImageCacheErrorBase;
+
+static ImageCachePtr
+ImageCacheGet(ClientPtr client)
+{
+    ImageCachePtr cache;
+
+    cache = dixLookupPrivate(&client->devPrivates, ImageCacheClientPrivateKey);
+    if (cache)
+        return cache;
+
+    cache = calloc(1, sizeof(ImageCacheRec));
+    if (!cache)
+        return NULL;
+    cache->entries = ht_create(4 * sizeof(CARD32),
+                               sizeof(ImageCacheEntryPtr),
+                               ht_generic_hash, ht_generic_compare, NULL);
+    if (!cache->entries) {
+        free(cache);
+        return NULL;
+    }
+    xorg_list_init(&cache->lru);
+    dixSetPrivate(&client->devPrivates, ImageCacheClientPrivateKey, cache);
+    return cache;
+}
+
+static void
+ImageCacheRemove(ImageCachePtr cache, ImageCacheEntryPtr entry)
+{
+    ht_remove(cache->entries, entry->key);
+    xorg_list_del(&entry->lru);
+    cache->used -= entry->size;
+    free(entry);
+}
+
+static void
+ImageCacheEmpty(ImageCachePtr cache)
+{
+    ImageCacheEntryPtr entry, tmp;
+
+    xorg_list_for_each_entry_safe(entry, tmp, &cache->lru, lru)
+        ImageCacheRemove(cache, entry);
+}
+
+static ImageCacheEntryPtr
+ImageCacheFind(ImageCachePtr cache, const CARD32 *key)
+{
+    ImageCacheEntryPtr *found = ht_find(cache->entries, key);
+
+    return found ? *found : NULL;
+}
+
+/*
+ * Store data under key, replacing what was there and evicting least
+ * recently used entries until it fits.  Like the client, give up on
+ * images larger than the whole budget.
+ */
+static void
+ImageCacheStore(ImageCachePtr cache, const CARD32 *key,
+                const char *data, long size)
+{
+    ImageCacheEntryPtr entry, *slot;
+
+    if ((entry = ImageCacheFind(cache, key)))
+        ImageCacheRemove(cache, entry);
+    if (size > IMAGE_CACHE_BUDGET)
+        return;
+    while (cache->used + size > IMAGE_CACHE_BUDGET) {
+        entry = xorg_list_last_entry(&cache->lru, ImageCacheEntryRec, lru);
+        ImageCacheRemove(cache, entry);
+    }
+
+    entry = malloc(sizeof(ImageCacheEntryRec) + size);
+    if (!entry)
+        return;
+    slot = ht_add(cache->entries, key);
+    if (!slot) {
+        free(entry);
+        return;
+    }
+    memcpy(entry->key, key, sizeof(entry->key));
+    entry->size = size;
+    entry->data = (char *) &entry[1];
+    memcpy(entry->data, data, size);
+    xorg_list_add(&entry->lru, &cache->lru);
+    cache->used += size;
+    *slot = entry;
+}
+
+static void
+ImageCacheFree(ClientPtr client)
+{
+    ImageCachePtr cache;
+
+    cache = dixLookupPrivate(&client->devPrivates, ImageCacheClientPrivateKey);
+    if (!cache)
+        return;
+    ImageCacheEmpty(cache);
+    ht_destroy(cache->entries);
+    free(cache);
+    dixSetPrivate(&client->devPrivates, ImageCacheClientPrivateKey, NULL);
+}
+
+static int
+ProcImageCacheQueryVersion(ClientPtr client)
+{
+    xImageCacheQueryVersionReply rep = {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = 0,
+        .majorVersion = IMAGECACHE_MAJOR,
+        .minorVersion = IMAGECACHE_MINOR,
+        .budget = IMAGE_CACHE_BUDGET
+    };
+
+    REQUEST_SIZE_MATCH(xImageCacheQueryVersionReq);
+
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.majorVersion);
+        swapl(&rep.minorVersion);
+        swapl(&rep.budget);
+    }
+    WriteToClient(client, sizeof(xImageCacheQueryVersionReply), &rep);
+    return Success;
+}
+
+static int
+ProcImageCachePutImage(ClientPtr client)
+{
+    REQUEST(xImageCachePutImageReq);
+    xPutImageReq put;
+    ImageCachePtr cache;
+    ImageCacheEntryPtr entry;
+    CARD32 key[4];
+    char *data;
+    long size;
+    int rc;
+
+    REQUEST_AT_LEAST_SIZE(xImageCachePutImageReq);
+
+    cache = ImageCacheGet(client);
+    if (!cache)
+        return BadAlloc;
+
+    put = (xPutImageReq) {
+        .reqType = X_PutImage,
+        .format = stuff->format,
+        .drawable = stuff->drawable,
+        .gc = stuff->gc,
+        .width = stuff->width,
+        .height = stuff->height,
+        .dstX = stuff->dstX,
+        .dstY = stuff->dstY,
+        .leftPad = stuff->leftPad,
+        .depth = stuff->depth
+    };
+    key[0] = stuff->key0;
+    key[1] = stuff->key1;
+    key[2] = stuff->key2;
+    key[3] = stuff->key3;
+    size = ((long) client->req_len << 2) - sizeof(xImageCachePutImageReq);
+
+    /* New data is kept even if drawing it fails, as the client expects */
+    if (size) {
+        ImageCacheStore(cache, key, (char *) &stuff[1], size);
+        return DoPutImage(client, &put, (char *) &stuff[1], size);
+    }
+
+    entry = ImageCacheFind(cache, key);
+    if (!entry) {
+        client->errorValue = key[0];
+        return ImageCacheErrorBase + ImageCacheBadKey;
+    }
+    xorg_list_del(&entry->lru);
+    xorg_list_add(&entry->lru, &cache->lru);
+
+    /* DoPutImage converts swapped clients' data in place */
+    if (!client->swapped)
+        return DoPutImage(client, &put, entry->data, entry->size);
+
+    data = malloc(entry->size);
+    if (!data)
+        return BadAlloc;
+    memcpy(data, entry->data, entry->size);
+    rc = DoPutImage(client, &put, data, entry->size);
+    free(data);
+    return rc;
+}
+
+static int
+ProcImageCacheReset(ClientPtr client)
+{
+    ImageCachePtr cache;
+
+    REQUEST_SIZE_MATCH(xImageCacheResetReq);
+
+    cache = dixLookupPrivate(&client->devPrivates, ImageCacheClientPrivateKey);
+    if (cache)
+        ImageCacheEmpty(cache);
+    return Success;
+}
+
+static int
+ProcImageCacheDispatch(ClientPtr client)
+{
+    REQUEST(xReq);
+    switch (stuff->data) {
+    case X_ImageCacheQueryVersion:
+        return ProcImageCacheQueryVersion(client);
+    case X_ImageCachePutImage:
+        return ProcImageCachePutImage(client);
+    case X_ImageCacheReset:
+        return ProcImageCacheReset(client);
+    default:
+        return BadRequest;
+    }
+}
+
+static int _X_COLD
+SProcImageCacheQueryVersion(ClientPtr client)
+{
+    REQUEST(xImageCacheQueryVersionReq);
+
+    swaps(&stuff->length);
+    REQUEST_SIZE_MATCH(xImageCacheQueryVersionReq);
+    swapl(&stuff->majorVersion);
+    swapl(&stuff->minorVersion);
+    return ProcImageCacheQueryVersion(client);
+}
+
+static int _X_COLD
+SProcImageCachePutImage(ClientPtr client)
+{
+    REQUEST(xImageCachePutImageReq);
+
+    swaps(&stuff->length);
+    REQUEST_AT_LEAST_SIZE(xImageCachePutImageReq);
+    swapl(&stuff->drawable);
+    swapl(&stuff->gc);
+    swaps(&stuff->width);
+    swaps(&stuff->height);
+    swaps(&stuff->dstX);
+    swaps(&stuff->dstY);
+    swapl(&stuff->key0);
+    swapl(&stuff->key1);
+    swapl(&stuff->key2);
+    swapl(&stuff->key3);
+    return ProcImageCachePutImage(client);
+}
+
+static int _X_COLD
+SProcImageCacheReset(ClientPtr client)
+{
+    REQUEST(xImageCacheResetReq);
+
+    swaps(&stuff->length);
+    return ProcImageCacheReset(client);
+}
+
+static int _X_COLD
+SProcImageCacheDispatch(ClientPtr client)
+{
+    REQUEST(xReq);
+    switch (stuff->data) {
+    case X_ImageCacheQueryVersion:
+        return SProcImageCacheQueryVersion(client);
+    case X_ImageCachePutImage:
+        return SProcImageCachePutImage(client);
+    case X_ImageCacheReset:
+        return SProcImageCacheReset(client);
+    default:
+        return BadRequest;
+    }
+}
+
+static void
+ImageCacheClientState(CallbackListPtr *list, void *closure, void *data)
+{
+    NewClientInfoRec *clientinfo = data;
+    ClientPtr client = clientinfo->client;
+
+    if (client->clientState == ClientStateGone ||
+        client->clientState == ClientStateRetained)
+        ImageCacheFree(client);
+}
+
+void
+ImageCacheExtensionInit(void)
+{
+    ExtensionEntry *extEntry;
+
+    if (!dixRegisterPrivateKey(ImageCacheClientPrivateKey, PRIVATE_CLIENT, 0))
+        return;
+    if (!AddCallback(&ClientStateCallback, ImageCacheClientState, NULL))
+        return;
+
+    extEntry = AddExtension(IMAGECACHE_NAME, ImageCacheNumberEvents,
+                            ImageCacheNumberErrors,
+                            ProcImageCacheDispatch, SProcImageCacheDispatch,
+                            NULL, StandardMinorOpcode);
+    if (extEntry)
+        ImageCacheErrorBase = extEntry->errorBase;
+}
@@ -689,6 +689,7 @@ PanoramiXCreateConnectionBlock(void)
     height_mult = (1.0 * root->pixHeight) / old_height;
     root->mmWidth *= width_mult;
     root->mmHeight *= height_mult;
+    InvalidateConnSetupCache();
 
     while (ConnectionCallbackList) {
         void *tmp;
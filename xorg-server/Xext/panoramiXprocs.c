@@ -50,6 +50,76 @@ Equipment Corporation.
 #define XINERAMA_IMAGE_BUFSIZE (256*1024)
 #define INPUTONLY_LEGAL_MASK (CWWinGravity | CWEventMask | \
                               CWDontPropagate | CWOverrideRedirect | CWCursor )
+#define XINERAMA_SCRATCH_SIZE (64*1024)
+
+/*
+ * Drawing requests are replayed once per screen, and requests on the root
+ * window have their coordinates rewritten for each screen in place.  The
+ * original coordinates are kept here between screens; small requests reuse
+ * one buffer instead of allocating a copy each time.
+ */
+static void *PanoramiXScratch;
+static size_t PanoramiXScratchSize;
+
+static void *
+PanoramiXSaveData(const void *data, size_t size)
+{
+    void *buf;
+
+    if (size > XINERAMA_SCRATCH_SIZE)
+        buf = malloc(size);
+    else {
+        if (size > PanoramiXScratchSize) {
+            buf = realloc(PanoramiXScratch, XINERAMA_SCRATCH_SIZE);
+            if (!buf)
+                return NULL;
+            PanoramiXScratch = buf;
+            PanoramiXScratchSize = XINERAMA_SCRATCH_SIZE;
+        }
+        buf = PanoramiXScratch;
+    }
+    if (buf)
+        memcpy(buf, data, size);
+    return buf;
+}
+
+static void
+PanoramiXFreeData(void *buf)
+{
+    if (buf != PanoramiXScratch)
+        free(buf);
+}
+
+/*
+ * A window that isn't redirected and has no backing store draws nothing on
+ * the screens where none of it is visible, so drawing requests can leave
+ * those screens out.  One screen always gets the request, so errors are
+ * still reported for a window that isn't visible anywhere.
+ */
+static void
+PanoramiXCullScreens(PanoramiXRes *draw, Bool *cull)
+{
+    WindowPtr pWin;
+    int j, drawn = 0;
+
+    FOR_NSCREENS(j) {
+        cull[j] = FALSE;
+        if (draw->type == XRT_WINDOW && !draw->u.win.root &&
+            dixLookupResourceByType((void **) &pWin, draw->info[j].id,
+                                    RT_WINDOW, serverClient,
+                                    DixReadAccess) == Success &&
+            pWin->backingStore == NotUseful &&
+#ifdef COMPOSITE
+            !pWin->redirectDraw &&
+#endif
+            !RegionNotEmpty(&pWin->borderClip))
+            cull[j] = TRUE;
+        else
+            drawn++;
+    }
+    if (!drawn)
+        cull[0] = FALSE;
+}
 
 int
 PanoramiXCreateWindow(ClientPtr client)
@@ -1374,6 +1444,7 @@ PanoramiXPolyPoint(ClientPtr client)
     int result, npoint, j;
     xPoint *origPts;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
 
     REQUEST(xPolyPointReq);
 
@@ -1395,11 +1466,18 @@ PanoramiXPolyPoint(ClientPtr client)
     isRoot = (draw->type == XRT_WINDOW) && draw->u.win.root;
     npoint = bytes_to_int32((client->req_len << 2) - sizeof(xPolyPointReq));
     if (npoint > 0) {
-        origPts = xallocarray(npoint, sizeof(xPoint));
-        memcpy((char *) origPts, (char *) &stuff[1], npoint * sizeof(xPoint));
+        origPts = NULL;
+        if (isRoot) {
+            origPts = PanoramiXSaveData(&stuff[1], npoint * sizeof(xPoint));
+            if (!origPts)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origPts)
                 memcpy(&stuff[1], origPts, npoint * sizeof(xPoint));
 
             if (isRoot) {
@@ -1425,7 +1503,7 @@ PanoramiXPolyPoint(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origPts);
+        PanoramiXFreeData(origPts);
         return result;
     }
     else
@@ -1439,6 +1517,7 @@ PanoramiXPolyLine(ClientPtr client)
     int result, npoint, j;
     xPoint *origPts;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
 
     REQUEST(xPolyLineReq);
 
@@ -1460,11 +1539,18 @@ PanoramiXPolyLine(ClientPtr client)
     isRoot = IS_ROOT_DRAWABLE(draw);
     npoint = bytes_to_int32((client->req_len << 2) - sizeof(xPolyLineReq));
     if (npoint > 0) {
-        origPts = xallocarray(npoint, sizeof(xPoint));
-        memcpy((char *) origPts, (char *) &stuff[1], npoint * sizeof(xPoint));
+        origPts = NULL;
+        if (isRoot) {
+            origPts = PanoramiXSaveData(&stuff[1], npoint * sizeof(xPoint));
+            if (!origPts)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origPts)
                 memcpy(&stuff[1], origPts, npoint * sizeof(xPoint));
 
             if (isRoot) {
@@ -1490,7 +1576,7 @@ PanoramiXPolyLine(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origPts);
+        PanoramiXFreeData(origPts);
         return result;
     }
     else
@@ -1504,6 +1590,7 @@ PanoramiXPolySegment(ClientPtr client)
     PanoramiXRes *gc, *draw;
     xSegment *origSegs;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
 
     REQUEST(xPolySegmentReq);
 
@@ -1529,11 +1616,18 @@ PanoramiXPolySegment(ClientPtr client)
         return BadLength;
     nsegs >>= 3;
     if (nsegs > 0) {
-        origSegs = xallocarray(nsegs, sizeof(xSegment));
-        memcpy((char *) origSegs, (char *) &stuff[1], nsegs * sizeof(xSegment));
+        origSegs = NULL;
+        if (isRoot) {
+            origSegs = PanoramiXSaveData(&stuff[1], nsegs * sizeof(xSegment));
+            if (!origSegs)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origSegs)
                 memcpy(&stuff[1], origSegs, nsegs * sizeof(xSegment));
 
             if (isRoot) {
@@ -1558,7 +1652,7 @@ PanoramiXPolySegment(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origSegs);
+        PanoramiXFreeData(origSegs);
         return result;
     }
     else
@@ -1571,6 +1665,7 @@ PanoramiXPolyRectangle(ClientPtr client)
     int result, nrects, i, j;
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     xRectangle *origRecs;
 
     REQUEST(xPolyRectangleReq);
@@ -1597,12 +1692,18 @@ PanoramiXPolyRectangle(ClientPtr client)
         return BadLength;
     nrects >>= 3;
     if (nrects > 0) {
-        origRecs = xallocarray(nrects, sizeof(xRectangle));
-        memcpy((char *) origRecs, (char *) &stuff[1],
-               nrects * sizeof(xRectangle));
+        origRecs = NULL;
+        if (isRoot) {
+            origRecs = PanoramiXSaveData(&stuff[1], nrects * sizeof(xRectangle));
+            if (!origRecs)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origRecs)
                 memcpy(&stuff[1], origRecs, nrects * sizeof(xRectangle));
 
             if (isRoot) {
@@ -1625,7 +1726,7 @@ PanoramiXPolyRectangle(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origRecs);
+        PanoramiXFreeData(origRecs);
         return result;
     }
     else
@@ -1638,6 +1739,7 @@ PanoramiXPolyArc(ClientPtr client)
     int result, narcs, i, j;
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     xArc *origArcs;
 
     REQUEST(xPolyArcReq);
@@ -1664,11 +1766,18 @@ PanoramiXPolyArc(ClientPtr client)
         return BadLength;
     narcs /= sizeof(xArc);
     if (narcs > 0) {
-        origArcs = xallocarray(narcs, sizeof(xArc));
-        memcpy((char *) origArcs, (char *) &stuff[1], narcs * sizeof(xArc));
+        origArcs = NULL;
+        if (isRoot) {
+            origArcs = PanoramiXSaveData(&stuff[1], narcs * sizeof(xArc));
+            if (!origArcs)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origArcs)
                 memcpy(&stuff[1], origArcs, narcs * sizeof(xArc));
 
             if (isRoot) {
@@ -1690,7 +1799,7 @@ PanoramiXPolyArc(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origArcs);
+        PanoramiXFreeData(origArcs);
         return result;
     }
     else
@@ -1703,6 +1812,7 @@ PanoramiXFillPoly(ClientPtr client)
     int result, count, j;
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     DDXPointPtr locPts;
 
     REQUEST(xFillPolyReq);
@@ -1726,12 +1836,18 @@ PanoramiXFillPoly(ClientPtr client)
 
     count = bytes_to_int32((client->req_len << 2) - sizeof(xFillPolyReq));
     if (count > 0) {
-        locPts = xallocarray(count, sizeof(DDXPointRec));
-        memcpy((char *) locPts, (char *) &stuff[1],
-               count * sizeof(DDXPointRec));
+        locPts = NULL;
+        if (isRoot) {
+            locPts = PanoramiXSaveData(&stuff[1], count * sizeof(DDXPointRec));
+            if (!locPts)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && locPts)
                 memcpy(&stuff[1], locPts, count * sizeof(DDXPointRec));
 
             if (isRoot) {
@@ -1756,7 +1872,7 @@ PanoramiXFillPoly(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(locPts);
+        PanoramiXFreeData(locPts);
         return result;
     }
     else
@@ -1769,6 +1885,7 @@ PanoramiXPolyFillRectangle(ClientPtr client)
     int result, things, i, j;
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     xRectangle *origRects;
 
     REQUEST(xPolyFillRectangleReq);
@@ -1795,12 +1912,18 @@ PanoramiXPolyFillRectangle(ClientPtr client)
         return BadLength;
     things >>= 3;
     if (things > 0) {
-        origRects = xallocarray(things, sizeof(xRectangle));
-        memcpy((char *) origRects, (char *) &stuff[1],
-               things * sizeof(xRectangle));
+        origRects = NULL;
+        if (isRoot) {
+            origRects = PanoramiXSaveData(&stuff[1], things * sizeof(xRectangle));
+            if (!origRects)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origRects)
                 memcpy(&stuff[1], origRects, things * sizeof(xRectangle));
 
             if (isRoot) {
@@ -1823,7 +1946,7 @@ PanoramiXPolyFillRectangle(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origRects);
+        PanoramiXFreeData(origRects);
         return result;
     }
     else
@@ -1835,6 +1958,7 @@ PanoramiXPolyFillArc(ClientPtr client)
 {
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     int result, narcs, i, j;
     xArc *origArcs;
 
@@ -1862,11 +1986,18 @@ PanoramiXPolyFillArc(ClientPtr client)
         return BadLength;
     narcs /= sizeof(xArc);
     if (narcs > 0) {
-        origArcs = xallocarray(narcs, sizeof(xArc));
-        memcpy((char *) origArcs, (char *) &stuff[1], narcs * sizeof(xArc));
+        origArcs = NULL;
+        if (isRoot) {
+            origArcs = PanoramiXSaveData(&stuff[1], narcs * sizeof(xArc));
+            if (!origArcs)
+                return BadAlloc;
+        }
+        PanoramiXCullScreens(draw, cull);
         FOR_NSCREENS_FORWARD(j) {
+            if (cull[j])
+                continue;
 
-            if (j)
+            if (j && origArcs)
                 memcpy(&stuff[1], origArcs, narcs * sizeof(xArc));
 
             if (isRoot) {
@@ -1889,7 +2020,7 @@ PanoramiXPolyFillArc(ClientPtr client)
             if (result != Success)
                 break;
         }
-        free(origArcs);
+        PanoramiXFreeData(origArcs);
         return result;
     }
     else
@@ -1901,6 +2032,7 @@ PanoramiXPutImage(ClientPtr client)
 {
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     int j, result, orig_x, orig_y;
 
     REQUEST(xPutImageReq);
@@ -1924,7 +2056,10 @@ PanoramiXPutImage(ClientPtr client)
 
     orig_x = stuff->dstX;
     orig_y = stuff->dstY;
+    PanoramiXCullScreens(draw, cull);
     FOR_NSCREENS_BACKWARD(j) {
+        if (cull[j])
+            continue;
         if (isRoot) {
             stuff->dstX = orig_x - screenInfo.screens[j]->x;
             stuff->dstY = orig_y - screenInfo.screens[j]->y;
@@ -2105,6 +2240,7 @@ PanoramiXPolyText8(ClientPtr client)
 {
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     int result, j;
     int orig_x, orig_y;
 
@@ -2129,7 +2265,10 @@ PanoramiXPolyText8(ClientPtr client)
 
     orig_x = stuff->x;
     orig_y = stuff->y;
+    PanoramiXCullScreens(draw, cull);
     FOR_NSCREENS_BACKWARD(j) {
+        if (cull[j])
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -2148,6 +2287,7 @@ PanoramiXPolyText16(ClientPtr client)
 {
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     int result, j;
     int orig_x, orig_y;
 
@@ -2172,7 +2312,10 @@ PanoramiXPolyText16(ClientPtr client)
 
     orig_x = stuff->x;
     orig_y = stuff->y;
+    PanoramiXCullScreens(draw, cull);
     FOR_NSCREENS_BACKWARD(j) {
+        if (cull[j])
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -2192,6 +2335,7 @@ PanoramiXImageText8(ClientPtr client)
     int result, j;
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     int orig_x, orig_y;
 
     REQUEST(xImageTextReq);
@@ -2215,7 +2359,10 @@ PanoramiXImageText8(ClientPtr client)
 
     orig_x = stuff->x;
     orig_y = stuff->y;
+    PanoramiXCullScreens(draw, cull);
     FOR_NSCREENS_BACKWARD(j) {
+        if (cull[j])
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -2235,6 +2382,7 @@ PanoramiXImageText16(ClientPtr client)
     int result, j;
     PanoramiXRes *gc, *draw;
     Bool isRoot;
+    Bool cull[MAXSCREENS];
     int orig_x, orig_y;
 
     REQUEST(xImageTextReq);
@@ -2258,7 +2406,10 @@ PanoramiXImageText16(ClientPtr client)
 
     orig_x = stuff->x;
     orig_y = stuff->y;
+    PanoramiXCullScreens(draw, cull);
     FOR_NSCREENS_BACKWARD(j) {
+        if (cull[j])
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -48,6 +48,10 @@ in this Software without prior written authorization from The Open Group.
 #include "gcstruct.h"
 #include "extinit.h"
 #include "protocol-versions.h"
+#include "damage.h"
+#ifdef MITSHM
+#include "shmint.h"
+#endif
 
 typedef RegionPtr (*CreateDftPtr) (WindowPtr    /* pWin */
     );
@@ -327,6 +331,107 @@ ProcPanoramiXShapeRectangles(ClientPtr client)
  * ProcShapeMask
  **************/
 
+/*
+ * Clients that animate a shaped window usually keep a handful of mask
+ * bitmaps and set them in turn.  Remember the regions of the last few
+ * masks converted; a damage record on each bitmap tells us whether it has
+ * been drawn to since, and its destroy callback drops the entry when the
+ * bitmap goes away.  Shared memory pixmaps change behind damage's back
+ * and are never cached.
+ */
+#define SHAPE_MASK_CACHE_SIZE 8
+
+typedef struct _ShapeMaskCache {
+    PixmapPtr pPixmap;
+    DamagePtr pDamage;
+    RegionPtr pRegion;
+    unsigned long lastUse;
+} ShapeMaskCacheRec, *ShapeMaskCachePtr;
+
+static ShapeMaskCacheRec shapeMaskCache[SHAPE_MASK_CACHE_SIZE];
+static unsigned long shapeMaskClock;
+
+static void
+ShapeMaskDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    ShapeMaskCachePtr pEntry = closure;
+
+    RegionDestroy(pEntry->pRegion);
+    pEntry->pPixmap = NULL;
+    pEntry->pDamage = NULL;
+    pEntry->pRegion = NULL;
+}
+
+static RegionPtr
+ShapeCopyRegion(RegionPtr pSrc)
+{
+    RegionPtr pDst = RegionCreate(NULL, 1);
+
+    if (pDst && !RegionCopy(pDst, pSrc)) {
+        RegionDestroy(pDst);
+        pDst = NULL;
+    }
+    return pDst;
+}
+
+static RegionPtr
+ShapeBitmapToRegion(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    ShapeMaskCachePtr pEntry = NULL, pVictim = &shapeMaskCache[0];
+    RegionPtr pRegion, pCached;
+    int i;
+
+    for (i = 0; i < SHAPE_MASK_CACHE_SIZE; i++) {
+        if (shapeMaskCache[i].pPixmap == pPixmap) {
+            pEntry = &shapeMaskCache[i];
+            break;
+        }
+        if (!shapeMaskCache[i].pPixmap)
+            pVictim = &shapeMaskCache[i];
+        else if (pVictim->pPixmap &&
+                 shapeMaskCache[i].lastUse < pVictim->lastUse)
+            pVictim = &shapeMaskCache[i];
+    }
+
+    if (pEntry) {
+        pEntry->lastUse = ++shapeMaskClock;
+        if (!RegionNotEmpty(DamageRegion(pEntry->pDamage)))
+            return ShapeCopyRegion(pEntry->pRegion);
+
+        pRegion = BitmapToRegion(pScreen, pPixmap);
+        if (pRegion && RegionCopy(pEntry->pRegion, pRegion))
+            DamageEmpty(pEntry->pDamage);
+        else
+            DamageDestroy(pEntry->pDamage);
+        return pRegion;
+    }
+
+    pRegion = BitmapToRegion(pScreen, pPixmap);
+    if (!pRegion)
+        return NULL;
+#ifdef MITSHM
+    if (ShmIsSharedPixmap(pPixmap))
+        return pRegion;
+#endif
+
+    if (pVictim->pDamage)
+        DamageDestroy(pVictim->pDamage);
+    pCached = ShapeCopyRegion(pRegion);
+    if (!pCached)
+        return pRegion;
+    pVictim->pDamage = DamageCreate(NULL, ShapeMaskDamageDestroy,
+                                    DamageReportNone, TRUE, pScreen, pVictim);
+    if (!pVictim->pDamage) {
+        RegionDestroy(pCached);
+        return pRegion;
+    }
+    pVictim->pPixmap = pPixmap;
+    pVictim->pRegion = pCached;
+    pVictim->lastUse = ++shapeMaskClock;
+    DamageRegister(&pPixmap->drawable, pVictim->pDamage);
+    return pRegion;
+}
+
 static int
 ProcShapeMask(ClientPtr client)
 {
@@ -370,7 +475,7 @@ ProcShapeMask(ClientPtr client)
         if (pPixmap->drawable.pScreen != pScreen ||
             pPixmap->drawable.depth != 1)
             return BadMatch;
-        srcRgn = BitmapToRegion(pScreen, pPixmap);
+        srcRgn = ShapeBitmapToRegion(pScreen, pPixmap);
         if (!srcRgn)
             return BadAlloc;
     }
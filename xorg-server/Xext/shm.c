@@ -59,10 +59,22 @@ in this Software without prior written authorization from The Open Group.
 #include "xace.h"
 #include <X11/extensions/shmproto.h>
 #include <X11/Xfuncproto.h>
+#if !defined(_MSC_VER)
 #include <sys/mman.h>
+#endif
 #include "protocol-versions.h"
 #include "busfault.h"
 
+#ifdef _MSC_VER
+#include <X11/Xwindows.h>
+
+/* There is no System V shared memory in native Windows builds.  Clients
+ * create a named file mapping instead and pass the number embedded in
+ * its name as the shmid.
+ */
+#define SHM_SECTION_NAME_FORMAT "Local\\XWin-MIT-SHM-%u"
+#endif
+
 /* Needed for Solaris cross-zone shared memory extension */
 #ifdef HAVE_SHMCTL64
 #include <sys/ipc_impl.h>
@@ -269,6 +281,14 @@ ShmDestroyPixmap(PixmapPtr pPixmap)
     return ret;
 }
 
+/* The client can write a shared pixmap's memory without the server knowing */
+Bool
+ShmIsSharedPixmap(PixmapPtr pPixmap)
+{
+    return dixPrivateKeyRegistered(shmPixmapPrivateKey) &&
+        dixLookupPrivate(&pPixmap->devPrivates, shmPixmapPrivateKey) != NULL;
+}
+
 void
 ShmRegisterFbFuncs(ScreenPtr pScreen)
 {
@@ -285,8 +305,13 @@ ProcShmQueryVersion(ClientPtr client)
         .length = 0,
         .majorVersion = SERVER_SHM_MAJOR_VERSION,
         .minorVersion = SERVER_SHM_MINOR_VERSION,
+#ifdef _MSC_VER
+        .uid = 0,
+        .gid = 0,
+#else
         .uid = geteuid(),
         .gid = getegid(),
+#endif
         .pixmapFormat = sharedPixmaps ? ZPixmap : 0
     };
 
@@ -304,6 +329,51 @@ ProcShmQueryVersion(ClientPtr client)
     return Success;
 }
 
+#ifdef _MSC_VER
+/*
+ * Open and map the file mapping named after shmid.  Access rights are
+ * enforced by the security descriptor of the section when it is opened.
+ */
+static Bool
+ShmMapSection(ShmDescPtr shmdesc, int shmid, Bool readonly)
+{
+    char name[64];
+    DWORD access = readonly ? FILE_MAP_READ : FILE_MAP_READ | FILE_MAP_WRITE;
+    MEMORY_BASIC_INFORMATION mbi;
+    HANDLE hMapping;
+    void *addr;
+
+    snprintf(name, sizeof(name), SHM_SECTION_NAME_FORMAT, (unsigned) shmid);
+    hMapping = OpenFileMappingA(access, FALSE, name);
+    if (!hMapping)
+        return FALSE;
+
+    addr = MapViewOfFile(hMapping, access, 0, 0, 0);
+    if (!addr) {
+        CloseHandle(hMapping);
+        return FALSE;
+    }
+
+    /* The view covers the whole section, rounded up to whole pages */
+    if (!VirtualQuery(addr, &mbi, sizeof(mbi))) {
+        UnmapViewOfFile(addr);
+        CloseHandle(hMapping);
+        return FALSE;
+    }
+
+    shmdesc->addr = addr;
+    shmdesc->size = mbi.RegionSize;
+    shmdesc->mapping = hMapping;
+    return TRUE;
+}
+
+static void
+ShmUnmapSection(ShmDescPtr shmdesc)
+{
+    UnmapViewOfFile(shmdesc->addr);
+    CloseHandle(shmdesc->mapping);
+}
+#else
 /*
  * Simulate the access() system call for a shared memory segment,
  * using the credentials from the client if available.
@@ -341,9 +411,6 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
             if (uid == 0) {
                 return 0;
             }
-            #ifdef _MSC_VER
-            __asm int 3;
-            #else
             /* Check the owner */
             if (SHMPERM_UID(perm) == uid || SHMPERM_CUID(perm) == uid) {
                 mask = S_IRUSR;
@@ -352,14 +419,10 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
                 }
                 return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
             }
-            #endif
         }
 
         if (gidset) {
             /* Check the group */
-            #ifdef _MSC_VER
-            __asm int 3;
-            #else
             if (SHMPERM_GID(perm) == gid || SHMPERM_CGID(perm) == gid) {
                 mask = S_IRGRP;
                 if (!readonly) {
@@ -367,26 +430,23 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
                 }
                 return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
             }
-            #endif
         }
     }
-            #ifdef _MSC_VER
-            __asm int 3;
-            return -1;
-            #else
     /* Otherwise, check everyone else */
     mask = S_IROTH;
     if (!readonly) {
         mask |= S_IWOTH;
     }
     return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
-    #endif
 }
+#endif
 
 static int
 ProcShmAttach(ClientPtr client)
 {
+#ifndef _MSC_VER
     SHMSTAT_TYPE buf;
+#endif
     ShmDescPtr shmdesc;
 
     REQUEST(xShmAttachReq);
@@ -413,6 +473,12 @@ ProcShmAttach(ClientPtr client)
 #ifdef SHM_FD_PASSING
         shmdesc->is_fd = FALSE;
 #endif
+#ifdef _MSC_VER
+        if (!ShmMapSection(shmdesc, stuff->shmid, stuff->readOnly)) {
+            free(shmdesc);
+            return BadAccess;
+        }
+#else
         shmdesc->addr = shmat(stuff->shmid, 0,
                               stuff->readOnly ? SHM_RDONLY : 0);
         if ((shmdesc->addr == ((char *) -1)) || SHMSTAT(stuff->shmid, &buf)) {
@@ -429,11 +495,12 @@ ProcShmAttach(ClientPtr client)
             free(shmdesc);
             return BadAccess;
         }
+        shmdesc->size = SHM_SEGSZ(buf);
+#endif
 
         shmdesc->shmid = stuff->shmid;
         shmdesc->refcnt = 1;
         shmdesc->writable = !stuff->readOnly;
-        shmdesc->size = SHM_SEGSZ(buf);
         shmdesc->next = Shmsegs;
         Shmsegs = shmdesc;
     }
@@ -451,7 +518,9 @@ ShmDetachSegment(void *value, /* must conform to DeleteType */
 
     if (--shmdesc->refcnt)
         return TRUE;
-#ifndef _MSC_VER
+#ifdef _MSC_VER
+    ShmUnmapSection(shmdesc);
+#else
 #if SHM_FD_PASSING
     if (shmdesc->is_fd) {
         if (shmdesc->busfault)
@@ -67,6 +67,9 @@ typedef struct _ShmDesc {
     char *addr;
     Bool writable;
     unsigned long size;
+#ifdef _MSC_VER
+    void *mapping;              /* HANDLE of the file mapping */
+#endif
 #ifdef SHM_FD_PASSING
     Bool is_fd;
     struct busfault *busfault;
@@ -86,6 +89,9 @@ extern _X_EXPORT void
 extern _X_EXPORT void
  ShmRegisterFbFuncs(ScreenPtr pScreen);
 
+extern _X_EXPORT Bool
+ ShmIsSharedPixmap(PixmapPtr pPixmap);
+
 extern _X_EXPORT RESTYPE ShmSegType;
 extern _X_EXPORT int ShmCompletionCode;
 extern _X_EXPORT int BadShmSegCode;
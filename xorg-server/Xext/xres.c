@@ -412,6 +412,118 @@ ProcXResQueryClientPixmapBytes(ClientPtr client)
     return Success;
 }
 
+typedef struct {
+    unsigned long count;
+    CARD64 bytes;
+} ResTypeBytes;
+
+/** @brief Adds a resource to the per-type totals of XResQueryClientStats.
+    A resource's own memory is shared evenly by its references; resources
+    that merely refer to pixmaps are charged their share of those. */
+static void
+ResFindTypeBytes(void *value, XID id, RESTYPE type, void *cdata)
+{
+    ResTypeBytes *types = cdata;
+    SizeType sizeFunc = GetResourceTypeSizeFunc(type);
+    ResourceSizeRec size = { 0, 0, 0 };
+    ResTypeBytes *entry;
+
+    if ((type & TypeMask) == RT_NONE)
+        return;
+    entry = &types[(type & TypeMask) - 1];
+
+    sizeFunc(value, id, &size);
+    entry->count++;
+    if (size.resourceSize)
+        entry->bytes += size.resourceSize / max(size.refCnt, 1);
+    else
+        entry->bytes += size.pixmapRefSize;
+}
+
+/** @brief Implements the XResQueryClientStats of XResProto v1.3 */
+static int
+ProcXResQueryClientStats(ClientPtr client)
+{
+    REQUEST(xXResQueryClientStatsReq);
+    xXResQueryClientStatsReply rep;
+    ClientPtr target;
+    ResTypeBytes *types;
+    unsigned long pending, size;
+    int i, clientID, num_types;
+
+    REQUEST_SIZE_MATCH(xXResQueryClientStatsReq);
+
+    clientID = CLIENT_ID(stuff->xid);
+
+    if ((clientID >= currentMaxClients) || !clients[clientID]) {
+        client->errorValue = stuff->xid;
+        return BadValue;
+    }
+    target = clients[clientID];
+
+    types = calloc(lastResourceType + 1, sizeof(*types));
+    if (!types)
+        return BadAlloc;
+
+    FindAllClientResources(target, ResFindTypeBytes, types);
+
+    num_types = 0;
+    for (i = 0; i < lastResourceType; i++) {
+        if (types[i].count)
+            num_types++;
+    }
+
+    ClientOutputBytes(target, &pending, &size);
+
+    rep = (xXResQueryClientStatsReply) {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = bytes_to_int32(num_types * sz_xXResTypeBytes),
+        .numTypes = num_types,
+        .requests = target->requestCount,
+        .time = target->dispatchTime,
+        .time_overflow = target->dispatchTime >> 32,
+        .outputPending = pending,
+        .outputSize = size
+    };
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swapl(&rep.numTypes);
+        swapl(&rep.requests);
+        swapl(&rep.time);
+        swapl(&rep.time_overflow);
+        swapl(&rep.outputPending);
+        swapl(&rep.outputSize);
+    }
+
+    WriteToClient(client, sizeof(xXResQueryClientStatsReply), &rep);
+
+    for (i = 0; i < lastResourceType; i++) {
+        xXResTypeBytes scratch;
+
+        if (!types[i].count)
+            continue;
+
+        scratch.resource_type = resourceTypeAtom(i + 1);
+        scratch.count = types[i].count;
+        scratch.bytes = types[i].bytes;
+        scratch.bytes_overflow = types[i].bytes >> 32;
+
+        if (client->swapped) {
+            swapl(&scratch.resource_type);
+            swapl(&scratch.count);
+            swapl(&scratch.bytes);
+            swapl(&scratch.bytes_overflow);
+        }
+        WriteToClient(client, sz_xXResTypeBytes, &scratch);
+    }
+
+    free(types);
+
+    return Success;
+}
+
 /** @brief Finds out if a client's information need to be put into the
     response; marks client having been handled, if that is the case.
 
@@ -1011,6 +1123,8 @@ ProcResDispatch(ClientPtr client)
         return ProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return ProcXResQueryResourceBytes(client);
+    case X_XResQueryClientStats:
+        return ProcXResQueryClientStats(client);
     default: break;
     }
 
@@ -1074,6 +1188,15 @@ SProcXResQueryResourceBytes (ClientPtr client)
     return ProcXResQueryResourceBytes(client);
 }
 
+static int _X_COLD
+SProcXResQueryClientStats(ClientPtr client)
+{
+    REQUEST(xXResQueryClientStatsReq);
+    REQUEST_SIZE_MATCH(xXResQueryClientStatsReq);
+    swapl(&stuff->xid);
+    return ProcXResQueryClientStats(client);
+}
+
 static int _X_COLD
 SProcResDispatch (ClientPtr client)
 {
@@ -1093,6 +1216,8 @@ SProcResDispatch (ClientPtr client)
         return SProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return SProcXResQueryResourceBytes(client);
+    case X_XResQueryClientStats:
+        return SProcXResQueryClientStats(client);
     default: break;
     }
 
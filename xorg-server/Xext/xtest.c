@@ -177,6 +177,195 @@ XTestDeviceSendEvents(DeviceIntPtr dev,
         mieqProcessDeviceEvent(dev, &xtest_evlist[i], miPointerGetScreen(inputInfo.pointer));
 }
 
+/* Make the client wait for delay milliseconds, then run the request again */
+static int
+XTestDelayRequest(ClientPtr client, xReq *req, CARD32 delay)
+{
+    TimeStamp activateTime;
+    CARD32 ms;
+
+    activateTime = currentTime;
+    ms = activateTime.milliseconds + delay;
+    if (ms < activateTime.milliseconds)
+        activateTime.months++;
+    activateTime.milliseconds = ms;
+
+    /* see mbuf.c:QueueDisplayRequest (from the deprecated Multibuffer
+     * extension) for code similar to this */
+
+    if (!ClientSleepUntil(client, &activateTime, NULL, NULL)) {
+        return BadAlloc;
+    }
+    /* swap the request back so we can simply re-execute it */
+    if (client->swapped) {
+        (void) XTestSwapFakeInput(client, req);
+        swaps(&req->length);
+    }
+    ResetCurrentRequest(client);
+    client->sequence--;
+    return Success;
+}
+
+/*
+ * A FakeInput request may carry several core events instead of one, so
+ * automation clients can inject a whole sequence in one request.  Each
+ * event's time is the delay before it, as for a single event.  The events
+ * are all checked before any is sent.  Events that have been sent are
+ * rewritten as a KeyRelease of keycode 0, which no keyboard has, so when
+ * the request sleeps for a delay and is run again it carries on from the
+ * first event that has not been sent.
+ */
+typedef struct {
+    DeviceIntPtr dev;
+    int type;
+    int detail;
+    int flags;
+    int valuators[2];
+    int numValuators;
+} XTestCoreEventRec;
+
+#define XTestEventSent(ev) \
+    (((ev)->u.u.type & 0177) == KeyRelease && !(ev)->u.u.detail)
+
+static int
+XTestCheckCoreEvent(ClientPtr client, xEvent *ev, XTestCoreEventRec *rec)
+{
+    WindowPtr root;
+    int rc;
+
+    rec->type = ev->u.u.type & 0177;
+    rec->detail = ev->u.u.detail;
+    rec->flags = 0;
+    rec->numValuators = 0;
+
+    switch (rec->type) {
+    case KeyPress:
+    case KeyRelease:
+        rec->dev = PickKeyboard(client);
+        break;
+    case ButtonPress:
+    case ButtonRelease:
+        rec->dev = PickPointer(client);
+        break;
+    case MotionNotify:
+        rec->dev = PickPointer(client);
+        rec->valuators[0] = ev->u.keyButtonPointer.rootX;
+        rec->valuators[1] = ev->u.keyButtonPointer.rootY;
+        rec->numValuators = 2;
+        if (ev->u.u.detail == xFalse)
+            rec->flags = POINTER_ABSOLUTE | POINTER_DESKTOP;
+        break;
+    default:
+        client->errorValue = ev->u.u.type;
+        return BadValue;
+    }
+
+    if (!rec->dev)
+        return BadAccess;
+    rec->dev = GetXTestDevice(rec->dev);
+
+    switch (rec->type) {
+    case KeyPress:
+    case KeyRelease:
+        if (!rec->dev->key)
+            return BadDevice;
+
+        if (rec->detail < rec->dev->key->xkbInfo->desc->min_key_code ||
+            rec->detail > rec->dev->key->xkbInfo->desc->max_key_code) {
+            client->errorValue = rec->detail;
+            return BadValue;
+        }
+        break;
+    case MotionNotify:
+        if (!rec->dev->valuator)
+            return BadDevice;
+
+        if (ev->u.keyButtonPointer.root != None) {
+            rc = dixLookupWindow(&root, ev->u.keyButtonPointer.root,
+                                 client, DixGetAttrAccess);
+            if (rc != Success)
+                return rc;
+            if (root->parent) {
+                client->errorValue = ev->u.keyButtonPointer.root;
+                return BadValue;
+            }
+
+            /* Add the root window's offset to the valuators */
+            if (rec->flags & POINTER_ABSOLUTE) {
+                rec->valuators[0] += root->drawable.pScreen->x;
+                rec->valuators[1] += root->drawable.pScreen->y;
+            }
+        }
+        if (rec->detail != xTrue && rec->detail != xFalse) {
+            client->errorValue = rec->detail;
+            return BadValue;
+        }
+        break;
+    case ButtonPress:
+    case ButtonRelease:
+        if (!rec->dev->button)
+            return BadDevice;
+
+        if (!rec->detail || rec->detail > rec->dev->button->numButtons) {
+            client->errorValue = rec->detail;
+            return BadValue;
+        }
+        break;
+    }
+    return Success;
+}
+
+static int
+XTestFakeCoreInputBatch(ClientPtr client, xReq *req, xEvent *events, int nev)
+{
+    XTestCoreEventRec rec;
+    ValuatorMask mask;
+    DeviceIntPtr moved = NULL;
+    xEvent *ev;
+    int i, rc;
+
+    for (i = 0, ev = events; i < nev; i++, ev++) {
+        if (XTestEventSent(ev))
+            continue;
+        rc = XTestCheckCoreEvent(client, ev, &rec);
+        if (rc != Success)
+            return rc;
+    }
+
+    if (screenIsSaved == SCREEN_SAVER_ON)
+        dixSaveScreens(serverClient, SCREEN_SAVER_OFF, ScreenSaverReset);
+
+    for (i = 0, ev = events; i < nev; i++, ev++) {
+        if (XTestEventSent(ev))
+            continue;
+
+        if (ev->u.keyButtonPointer.time) {
+            CARD32 delay = ev->u.keyButtonPointer.time;
+
+            ev->u.keyButtonPointer.time = 0;
+            if (moved)
+                miPointerUpdateSprite(moved);
+            return XTestDelayRequest(client, req, delay);
+        }
+
+        XTestCheckCoreEvent(client, ev, &rec);
+        valuator_mask_set_range(&mask, 0, rec.numValuators, rec.valuators);
+        if (rec.dev->sendEventsProc)
+            (*rec.dev->sendEventsProc) (rec.dev, rec.type, rec.detail,
+                                        rec.flags, &mask);
+        if (rec.type != KeyPress && rec.type != KeyRelease)
+            moved = rec.dev;
+
+        ev->u.u.type = KeyRelease;
+        ev->u.u.detail = 0;
+    }
+
+    /* The sprite only needs to catch up once, not after every event */
+    if (moved)
+        miPointerUpdateSprite(moved);
+    return Success;
+}
+
 static int
 ProcXTestFakeInput(ClientPtr client)
 {
@@ -316,7 +505,7 @@ ProcXTestFakeInput(ClientPtr client)
     }
     else {
         if (nev != 1)
-            return BadLength;
+            return XTestFakeCoreInputBatch(client, (xReq *) stuff, ev, nev);
         switch (type) {
         case KeyPress:
         case KeyRelease:
@@ -351,30 +540,10 @@ ProcXTestFakeInput(ClientPtr client)
 
     /* If the event has a time set, wait for it to pass */
     if (ev->u.keyButtonPointer.time) {
-        TimeStamp activateTime;
-        CARD32 ms;
-
-        activateTime = currentTime;
-        ms = activateTime.milliseconds + ev->u.keyButtonPointer.time;
-        if (ms < activateTime.milliseconds)
-            activateTime.months++;
-        activateTime.milliseconds = ms;
-        ev->u.keyButtonPointer.time = 0;
-
-        /* see mbuf.c:QueueDisplayRequest (from the deprecated Multibuffer
-         * extension) for code similar to this */
+        CARD32 delay = ev->u.keyButtonPointer.time;
 
-        if (!ClientSleepUntil(client, &activateTime, NULL, NULL)) {
-            return BadAlloc;
-        }
-        /* swap the request back so we can simply re-execute it */
-        if (client->swapped) {
-            (void) XTestSwapFakeInput(client, (xReq *) stuff);
-            swaps(&stuff->length);
-        }
-        ResetCurrentRequest(client);
-        client->sequence--;
-        return Success;
+        ev->u.keyButtonPointer.time = 0;
+        return XTestDelayRequest(client, (xReq *) stuff, delay);
     }
 
     switch (type) {
@@ -2780,12 +2780,6 @@ FreeInputMask(OtherInputMasks ** imask)
     *imask = NULL;
 }
 
-#define XIPropagateMask (KeyPressMask | \
-                         KeyReleaseMask | \
-                         ButtonPressMask | \
-                         ButtonReleaseMask | \
-                         PointerMotionMask)
-
 void
 RecalculateDeviceDeliverableEvents(WindowPtr pWin)
 {
@@ -2824,6 +2818,8 @@ RecalculateDeviceDeliverableEvents(WindowPtr pWin)
             break;
         pChild = pChild->nextSib;
     }
+    /* the per-window summaries are kept with the core masks */
+    RecalculateDeliverableEvents(pWin);
 }
 
 #ifdef _MSC_VER
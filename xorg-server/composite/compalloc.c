@@ -270,6 +270,7 @@ compFreeClientWindow(WindowPtr pWin, XID id)
 
     if (!cw)
         return;
+    compTopLevelFreed(pWin, id);
     for (prev = &cw->clients; (ccw = *prev); prev = &ccw->next) {
         if (ccw->id == id) {
             *prev = ccw->next;
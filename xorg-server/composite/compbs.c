@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Backing store for top-level windows within a memory budget.
+ *
+ * Without a compositing manager every uncovered part of a top-level
+ * window costs an Expose round trip to its client, which on XWin happens
+ * whenever windows are restacked.  When CompositeTopLevelBackingStore is
+ * set, mapped top-level windows are redirected automatically, so their
+ * contents live in a pixmap and uncovering them is a copy in the server.
+ *
+ * The stacking order stands in for recency of use: windows are backed
+ * from the top down as long as the budget lasts, and windows further
+ * down lose their pixmap again when the windows above them need the
+ * memory.  Windows that are already redirected by a client, or
+ * implicitly, are left alone.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include "compint.h"
+#include "compositeext.h"
+
+/* Bytes of window pixmaps to keep for top-level windows; 0 disables */
+unsigned long CompositeTopLevelBackingStore;
+
+/* The id of our redirection of a top-level window, or 0 */
+static DevPrivateKeyRec CompTopLevelPrivateKeyRec;
+
+#define GetTopLevelRedirect(w) ((XID *) \
+    dixGetPrivateAddr(&(w)->devPrivates, &CompTopLevelPrivateKeyRec))
+
+static Bool compTopLevelQueued;
+
+static unsigned long
+compTopLevelBytes(WindowPtr pWin)
+{
+    unsigned long w = pWin->drawable.width + 2 * pWin->borderWidth;
+    unsigned long h = pWin->drawable.height + 2 * pWin->borderWidth;
+
+    return w * h * (pWin->drawable.bitsPerPixel >> 3);
+}
+
+static void
+compTopLevelBalance(WindowPtr pRoot)
+{
+    CompScreenPtr cs = GetCompScreen(pRoot->drawable.pScreen);
+    unsigned long left = CompositeTopLevelBackingStore;
+    WindowPtr pWin;
+
+    for (pWin = pRoot->firstChild; pWin; pWin = pWin->nextSib) {
+        XID *id = GetTopLevelRedirect(pWin);
+        unsigned long size;
+
+        /* unmapped windows hold no pixmap whether redirected or not */
+        if (!pWin->realized || pWin->drawable.class != InputOutput ||
+            pWin == cs->pOverlayWin)
+            continue;
+
+        size = compTopLevelBytes(pWin);
+        if (size <= left) {
+            if (!*id && pWin->redirectDraw == RedirectDrawNone &&
+                compRedirectWindow(serverClient, pWin,
+                                   CompositeRedirectAutomatic) == Success)
+                *id = GetCompWindow(pWin)->clients->id;
+            if (*id)
+                left -= size;
+        }
+        else if (*id) {
+            XID old = *id;
+
+            *id = 0;
+            FreeResource(old, RT_NONE);
+        }
+    }
+}
+
+static Bool
+compTopLevelWork(ClientPtr pClient, void *closure)
+{
+    int s;
+
+    compTopLevelQueued = FALSE;
+    for (s = 0; s < screenInfo.numScreens; s++) {
+        ScreenPtr pScreen = screenInfo.screens[s];
+
+        if (GetCompScreen(pScreen) && pScreen->root)
+            compTopLevelBalance(pScreen->root);
+    }
+    return TRUE;
+}
+
+Bool
+compTopLevelInit(void)
+{
+    return dixRegisterPrivateKey(&CompTopLevelPrivateKeyRec, PRIVATE_WINDOW,
+                                 sizeof(XID));
+}
+
+/*
+ * Called when a top-level window was mapped, unmapped, restacked or
+ * resized.  Redirecting in the middle of those would re-enter window
+ * validation, so the budget is applied from a work procedure.
+ */
+void
+compTopLevelChanged(WindowPtr pWin)
+{
+    if (!CompositeTopLevelBackingStore || !pWin->parent ||
+        pWin->parent->parent || compTopLevelQueued)
+        return;
+    if (QueueWorkProc(compTopLevelWork, serverClient, NULL))
+        compTopLevelQueued = TRUE;
+}
+
+/* A redirection of pWin went away; forget it if it was ours */
+void
+compTopLevelFreed(WindowPtr pWin, XID id)
+{
+    XID *ours = GetTopLevelRedirect(pWin);
+
+    if (*ours == id)
+        *ours = 0;
+}
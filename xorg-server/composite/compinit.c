@@ -339,6 +339,8 @@ compScreenInit(ScreenPtr pScreen)
         return FALSE;
     if (!dixRegisterPrivateKey(&CompSubwindowsPrivateKeyRec, PRIVATE_WINDOW, 0))
         return FALSE;
+    if (!compTopLevelInit())
+        return FALSE;
 
     if (GetCompScreen(pScreen))
         return TRUE;
@@ -237,6 +237,19 @@ compReallocPixmap(WindowPtr pWin, int x, int y,
 
 void compMarkAncestors(WindowPtr pWin);
 
+/*
+ * compbs.c
+ */
+
+Bool
+ compTopLevelInit(void);
+
+void
+ compTopLevelChanged(WindowPtr pWin);
+
+void
+ compTopLevelFreed(WindowPtr pWin, XID id);
+
 /*
  * compinit.c
  */
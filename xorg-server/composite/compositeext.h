@@ -45,4 +45,7 @@ Bool CompositeIsImplicitRedirectException(ScreenPtr pScreen,
                                           XID parentVisual, XID winVisual);
 extern _X_EXPORT RESTYPE CompositeClientWindowType;
 
+/* Bytes of pixmap memory for backing top-level windows; 0 disables */
+extern _X_EXPORT unsigned long CompositeTopLevelBackingStore;
+
 #endif                          /* _COMPOSITEEXT_H_ */
@@ -276,6 +276,7 @@ compRealizeWindow(WindowPtr pWin)
         ret = FALSE;
     cs->RealizeWindow = pScreen->RealizeWindow;
     pScreen->RealizeWindow = compRealizeWindow;
+    compTopLevelChanged(pWin);
     compCheckTree(pWin->drawable.pScreen);
     return ret;
 }
@@ -293,6 +294,7 @@ compUnrealizeWindow(WindowPtr pWin)
         ret = FALSE;
     cs->UnrealizeWindow = pScreen->UnrealizeWindow;
     pScreen->UnrealizeWindow = compUnrealizeWindow;
+    compTopLevelChanged(pWin);
     compCheckTree(pWin->drawable.pScreen);
     return ret;
 }
@@ -678,18 +680,9 @@ compWindowUpdateAutomatic(WindowPtr pWin)
     PictFormatPtr pDstFormat = PictureWindowFormat(pWin->parent);
     int error;
     RegionPtr pRegion = DamageRegion(cw->damage);
-    PicturePtr pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable,
-                                           pSrcFormat,
-                                           0, 0,
-                                           serverClient,
-                                           &error);
+    PicturePtr pSrcPicture, pDstPicture;
     XID subwindowMode = IncludeInferiors;
-    PicturePtr pDstPicture = CreatePicture(0, &pParent->drawable,
-                                           pDstFormat,
-                                           CPSubwindowMode,
-                                           &subwindowMode,
-                                           serverClient,
-                                           &error);
+    BoxPtr pExtents;
 
     /*
      * First move the region from window to screen coordinates
@@ -701,25 +694,49 @@ compWindowUpdateAutomatic(WindowPtr pWin)
      */
     RegionIntersect(pRegion, pRegion, &cw->borderClip);
 
+    /*
+     * Damage that can't be seen in the parent (the window is obscured,
+     * or its ancestors are unmapped) needs no painting at all
+     */
+    if (!RegionNotEmpty(pRegion)) {
+        DamageEmpty(cw->damage);
+        return;
+    }
+
     /*
      * Now translate from screen to dest coordinates
      */
     RegionTranslate(pRegion, -pParent->drawable.x, -pParent->drawable.y);
 
+    pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable,
+                                pSrcFormat,
+                                0, 0,
+                                serverClient,
+                                &error);
+    pDstPicture = CreatePicture(0, &pParent->drawable,
+                                pDstFormat,
+                                CPSubwindowMode,
+                                &subwindowMode,
+                                serverClient,
+                                &error);
+
     /*
      * Clip the picture
      */
     SetPictureClipRegion(pDstPicture, 0, 0, pRegion);
 
     /*
-     * And paint
+     * And paint, only over the damaged extents rather than the whole
+     * pixmap so the backend has less to clip away
      */
+    pExtents = RegionExtents(pRegion);
     CompositePicture(PictOpSrc, pSrcPicture, 0, pDstPicture,
-                     0, 0,      /* src_x, src_y */
+                     pExtents->x1 + pParent->drawable.x - pSrcPixmap->screen_x,
+                     pExtents->y1 + pParent->drawable.y - pSrcPixmap->screen_y,
                      0, 0,      /* msk_x, msk_y */
-                     pSrcPixmap->screen_x - pParent->drawable.x,
-                     pSrcPixmap->screen_y - pParent->drawable.y,
-                     pSrcPixmap->drawable.width, pSrcPixmap->drawable.height);
+                     pExtents->x1, pExtents->y1,
+                     pExtents->x2 - pExtents->x1,
+                     pExtents->y2 - pExtents->y1);
     FreePicture(pSrcPicture, 0);
     FreePicture(pDstPicture, 0);
     /*
@@ -812,6 +829,8 @@ compConfigNotify(WindowPtr pWin, int x, int y, int w, int h,
             return ret;
     }
 
+    compTopLevelChanged(pWin);
+
     if (pWin->redirectDraw == RedirectDrawNone)
         return Success;
 
@@ -132,6 +132,64 @@ DamageExtNotify(DamageExtPtr pDamageExt, BoxPtr pBoxes, int nBoxes)
     DamageNoteCritical(pClient);
 }
 
+static void
+DamageExtFlush(DamageExtPtr pDamageExt)
+{
+    if (RegionNotEmpty(&pDamageExt->pending)) {
+        DamageExtNotify(pDamageExt, RegionRects(&pDamageExt->pending),
+                        RegionNumRects(&pDamageExt->pending));
+        RegionEmpty(&pDamageExt->pending);
+    }
+    pDamageExt->lastReport = GetTimeInMillis();
+}
+
+static CARD32
+DamageExtTimer(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    DamageExtPtr pDamageExt = arg;
+
+    /*
+     * Output is flushed before timers run, so anything still queued is
+     * output the client hasn't read; let it catch up before adding more.
+     */
+    if (!xorg_list_is_empty(&pDamageExt->pClient->output_pending))
+        return damageReportInterval;
+
+    DamageExtFlush(pDamageExt);
+    return 0;
+}
+
+/*
+ * With -damageinterval, rectangle reports go out at most once per interval,
+ * carrying the union of everything reported in between.  The first report
+ * after a quiet spell is sent at once; later ones wait for the timer, which
+ * is armed exactly when the pending region is not empty.
+ */
+static void
+DamageExtCoalesce(DamageExtPtr pDamageExt, RegionPtr pRegion)
+{
+    CARD32 since;
+
+    if (RegionNotEmpty(&pDamageExt->pending)) {
+        RegionUnion(&pDamageExt->pending, &pDamageExt->pending, pRegion);
+        return;
+    }
+
+    since = GetTimeInMillis() - pDamageExt->lastReport;
+    if (since < damageReportInterval) {
+        pDamageExt->timer = TimerSet(pDamageExt->timer, 0,
+                                     damageReportInterval - since,
+                                     DamageExtTimer, pDamageExt);
+        if (pDamageExt->timer &&
+            RegionCopy(&pDamageExt->pending, pRegion))
+            return;
+        TimerCancel(pDamageExt->timer);
+    }
+
+    DamageExtNotify(pDamageExt, RegionRects(pRegion), RegionNumRects(pRegion));
+    pDamageExt->lastReport = GetTimeInMillis();
+}
+
 static void
 DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 {
@@ -140,8 +198,11 @@ DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
     switch (pDamageExt->level) {
     case DamageReportRawRegion:
     case DamageReportDeltaRegion:
-        DamageExtNotify(pDamageExt, RegionRects(pRegion),
-                        RegionNumRects(pRegion));
+        if (damageReportInterval)
+            DamageExtCoalesce(pDamageExt, pRegion);
+        else
+            DamageExtNotify(pDamageExt, RegionRects(pRegion),
+                            RegionNumRects(pRegion));
         break;
     case DamageReportBoundingBox:
         DamageExtNotify(pDamageExt, RegionExtents(pRegion), 1);
@@ -236,6 +297,9 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
+    RegionNull(&pDamageExt->pending);
+    pDamageExt->timer = NULL;
+    pDamageExt->lastReport = 0;
     pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
                                        FALSE, pDrawable->pScreen, pDamageExt);
     if (!pDamageExt->pDamage) {
@@ -580,6 +644,8 @@ FreeDamageExt(void *value, XID did)
     if (pDamageExt->pDamage) {
         DamageDestroy(pDamageExt->pDamage);
     }
+    TimerFree(pDamageExt->timer);
+    RegionUninit(&pDamageExt->pending);
     free(pDamageExt);
     return Success;
 }
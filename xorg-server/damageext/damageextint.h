@@ -55,6 +55,9 @@ typedef struct _DamageExt {
     ClientPtr pClient;
     XID id;
     XID drawable;
+    RegionRec pending;          /* held back by -damageinterval */
+    OsTimerPtr timer;
+    CARD32 lastReport;
 } DamageExtRec, *DamageExtPtr;
 
 #define VERIFY_DAMAGEEXT(pDamageExt, rid, client, mode) { \
@@ -39,6 +39,7 @@
 #include <X11/extensions/dbeproto.h>
 #include "windowstr.h"
 #include "privates.h"
+#include "damage.h"
 
 typedef struct {
     VisualID visual;            /* one visual ID that supports double-buffering */
@@ -157,6 +158,15 @@ typedef struct _DbeWindowPrivRec {
      */
     PixmapPtr pFrontBuffer;
 
+    /* Drawing to the back buffer and to the window since the last swap,
+     * used by the MI swap to copy only what changed.  Both are NULL until
+     * the first swap, and the window damage is only trusted while the
+     * window's clip still has the serial number recorded at that swap.
+     */
+    DamagePtr pBackDamage;
+    DamagePtr pWindowDamage;
+    unsigned long windowSerial;
+
     /* Device-specific private information.
      */
     PrivateRec *devPrivates;
@@ -234,6 +234,126 @@ miDbeAliasBuffers(DbeWindowPrivPtr pDbeWindowPriv)
     }
 
 }                               /* miDbeAliasBuffers() */
+
+/******************************************************************************
+ *
+ * DBE MI Procedure: miDbeDamageDestroy, miDbeForgetDamage, miDbeTrackDamage
+ *
+ * Description:
+ *
+ *     These functions keep track of what was drawn to the back buffer and
+ *     to the window since the last swap.  Without that record the next
+ *     swap copies the whole back buffer.
+ *
+ *****************************************************************************/
+
+static void
+miDbeDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    DbeWindowPrivPtr pDbeWindowPriv = closure;
+
+    if (pDbeWindowPriv->pBackDamage == pDamage)
+        pDbeWindowPriv->pBackDamage = NULL;
+    if (pDbeWindowPriv->pWindowDamage == pDamage)
+        pDbeWindowPriv->pWindowDamage = NULL;
+}
+
+static void
+miDbeForgetDamage(DbeWindowPrivPtr pDbeWindowPriv)
+{
+    if (pDbeWindowPriv->pBackDamage)
+        DamageDestroy(pDbeWindowPriv->pBackDamage);
+    if (pDbeWindowPriv->pWindowDamage)
+        DamageDestroy(pDbeWindowPriv->pWindowDamage);
+}
+
+static void
+miDbeTrackDamage(DbeWindowPrivPtr pDbeWindowPriv)
+{
+    WindowPtr pWin = pDbeWindowPriv->pWindow;
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+
+    if (!pDbeWindowPriv->pBackDamage) {
+        pDbeWindowPriv->pBackDamage =
+            DamageCreate(NULL, miDbeDamageDestroy, DamageReportNone, TRUE,
+                         pScreen, pDbeWindowPriv);
+        if (!pDbeWindowPriv->pBackDamage)
+            return;
+        DamageRegister(&pDbeWindowPriv->pBackBuffer->drawable,
+                       pDbeWindowPriv->pBackDamage);
+    }
+    if (!pDbeWindowPriv->pWindowDamage) {
+        pDbeWindowPriv->pWindowDamage =
+            DamageCreate(NULL, miDbeDamageDestroy, DamageReportNone, TRUE,
+                         pScreen, pDbeWindowPriv);
+        if (!pDbeWindowPriv->pWindowDamage)
+            return;
+        DamageRegister(&pWin->drawable, pDbeWindowPriv->pWindowDamage);
+    }
+
+    DamageEmpty(pDbeWindowPriv->pBackDamage);
+    DamageEmpty(pDbeWindowPriv->pWindowDamage);
+    pDbeWindowPriv->windowSerial = pWin->drawable.serialNumber;
+}
+
+/******************************************************************************
+ *
+ * DBE MI Procedure: miDbeCopyBackBuffer
+ *
+ * Description:
+ *
+ *     This function copies the back buffer to the window.  If the back
+ *     buffer still holds what the last swap showed, apart from what has
+ *     been drawn to it since, and nothing else has touched the window, only
+ *     the damaged boxes are copied.
+ *
+ *****************************************************************************/
+
+#define MI_DBE_MAX_SWAP_BOXES 32
+
+static void
+miDbeCopyBackBuffer(DbeWindowPrivPtr pDbeWindowPriv, GCPtr pGC,
+                    Bool incremental)
+{
+    WindowPtr pWin = pDbeWindowPriv->pWindow;
+    DrawablePtr pBack = &pDbeWindowPriv->pBackBuffer->drawable;
+    RegionRec region, clip;
+    BoxRec box;
+    BoxPtr pBox;
+    int nBox;
+
+    if (!incremental ||
+        !pDbeWindowPriv->pBackDamage || !pDbeWindowPriv->pWindowDamage ||
+        pDbeWindowPriv->windowSerial != pWin->drawable.serialNumber) {
+        (*pGC->ops->CopyArea) (pBack, (DrawablePtr) pWin, pGC, 0, 0,
+                               pWin->drawable.width, pWin->drawable.height,
+                               0, 0);
+        return;
+    }
+
+    box.x1 = 0;
+    box.y1 = 0;
+    box.x2 = pWin->drawable.width;
+    box.y2 = pWin->drawable.height;
+    RegionInit(&clip, &box, 1);
+    RegionNull(&region);
+    RegionUnion(&region, DamageRegion(pDbeWindowPriv->pBackDamage),
+                DamageRegion(pDbeWindowPriv->pWindowDamage));
+    RegionIntersect(&region, &region, &clip);
+
+    nBox = RegionNumRects(&region);
+    pBox = RegionRects(&region);
+    if (nBox > MI_DBE_MAX_SWAP_BOXES) {
+        nBox = 1;
+        pBox = RegionExtents(&region);
+    }
+    for (; nBox--; pBox++)
+        (*pGC->ops->CopyArea) (pBack, (DrawablePtr) pWin, pGC,
+                               pBox->x1, pBox->y1,
+                               pBox->x2 - pBox->x1, pBox->y2 - pBox->y1,
+                               pBox->x1, pBox->y1);
+    RegionUninit(&region);
+}
 
 /******************************************************************************
  *
@@ -254,6 +374,7 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
     WindowPtr pWin;
     PixmapPtr pTmpBuffer;
     xRectangle clearRect;
+    Bool incremental;
 
     pWin = swapInfo[0].pWindow;
     pDbeScreenPriv = DBE_SCREEN_PRIV_FROM_WINDOW(pWin);
@@ -293,9 +414,17 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
      */
 
     ValidateGC((DrawablePtr) pWin, pGC);
-    (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
-                           (DrawablePtr) pWin, pGC, 0, 0,
-                           pWin->drawable.width, pWin->drawable.height, 0, 0);
+    incremental = (swapInfo[0].swapAction == XdbeUndefined ||
+                   swapInfo[0].swapAction == XdbeCopied);
+    miDbeCopyBackBuffer(pDbeWindowPriv, pGC, incremental);
+
+    /* XdbeBackground clears the whole back buffer and XdbeUntouched
+     * exchanges it with the front one, so their next swaps copy everything.
+     */
+    if (incremental)
+        miDbeTrackDamage(pDbeWindowPriv);
+    else
+        miDbeForgetDamage(pDbeWindowPriv);
 
     /*
      **********************************************************************
@@ -426,6 +555,8 @@ miDbeWinPrivDelete(DbeWindowPrivPtr pDbeWindowPriv, XID bufId)
      * free some stuff.
      */
 
+    miDbeForgetDamage(pDbeWindowPriv);
+
     /* Destroy the front and back pixmaps. */
     if (pDbeWindowPriv->pFrontBuffer) {
         (*pDbeWindowPriv->pWindow->drawable.pScreen->
@@ -643,6 +774,7 @@ miDbePositionWindow(WindowPtr pWin, int x, int y)
          * pixmaps.
          */
 
+        miDbeForgetDamage(pDbeWindowPriv);
         (*pScreen->DestroyPixmap) (pDbeWindowPriv->pFrontBuffer);
         (*pScreen->DestroyPixmap) (pDbeWindowPriv->pBackBuffer);
 
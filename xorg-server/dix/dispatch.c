@@ -128,6 +128,7 @@ Equipment Corporation.
 #include "xkbsrv.h"
 #include "client.h"
 #include "xfixesint.h"
+#include "wintrace.h"
 
 #ifdef XSERVER_DTRACE
 #include "registry.h"
@@ -238,6 +239,7 @@ UpdateCurrentTimeIf(void)
 /* in milliseconds */
 #define SMART_SCHEDULE_DEFAULT_INTERVAL	5
 #define SMART_SCHEDULE_MAX_SLICE	15
+#define SMART_INPUT_DEADLINE		1
 
 #ifdef HAVE_SETITIMER
 Bool SmartScheduleSignalEnable = TRUE;
@@ -248,6 +250,9 @@ long SmartScheduleInterval = SMART_SCHEDULE_DEFAULT_INTERVAL;
 long SmartScheduleMaxSlice = SMART_SCHEDULE_MAX_SLICE;
 long SmartScheduleTime;
 int SmartScheduleLatencyLimited = 0;
+Bool SmartScheduleInteractive = FALSE;
+static Bool SmartInputDeadlineSet;
+static long SmartInputDeadline;
 static ClientPtr SmartLastClient;
 static int SmartLastIndex[SMART_MAX_PRIORITY - SMART_MIN_PRIORITY + 1];
 
@@ -324,6 +329,39 @@ mark_client_ungrab(void)
     }
 }
 
+/*
+ * Interactive scheduling (-schedInteractive).  A client that is given
+ * input while another one holds the dispatch loop is owed a scheduling
+ * decision within SMART_INPUT_DEADLINE ms, so the running client's slice
+ * is cut short.  Once it is ready, it is picked ahead of clients at the
+ * same client priority that got no input.  Clients whose smart_priority
+ * is negative have been using up whole slices, so they count as bulk
+ * clients and do not get a deadline.
+ */
+void
+SmartScheduleInput(ClientPtr client)
+{
+    if (!SmartScheduleInteractive || client->smart_priority < 0 ||
+        client->smart_input_pending)
+        return;
+    client->smart_input_pending = TRUE;
+    client->smart_input_tick = SmartScheduleTime;
+    if (client != SmartLastClient && !SmartInputDeadlineSet) {
+        SmartInputDeadlineSet = TRUE;
+        SmartInputDeadline = SmartScheduleTime + SMART_INPUT_DEADLINE;
+    }
+}
+
+static Bool
+SmartInputBefore(ClientPtr a, ClientPtr b)
+{
+    if (!a->smart_input_pending)
+        return FALSE;
+    if (!b->smart_input_pending)
+        return TRUE;
+    return (a->smart_input_tick - b->smart_input_tick) < 0;
+}
+
 static ClientPtr
 SmartScheduleClient(void)
 {
@@ -355,8 +393,10 @@ SmartScheduleClient(void)
         if (!best ||
             pClient->priority > best->priority ||
             (pClient->priority == best->priority &&
-             (pClient->smart_priority > best->smart_priority ||
-              (pClient->smart_priority == best->smart_priority && robin > bestRobin))))
+             (SmartInputBefore(pClient, best) ||
+              (pClient->smart_input_pending == best->smart_input_pending &&
+               (pClient->smart_priority > best->smart_priority ||
+                (pClient->smart_priority == best->smart_priority && robin > bestRobin))))))
         {
             best = pClient;
             bestRobin = robin;
@@ -373,6 +413,12 @@ SmartScheduleClient(void)
     }
 #endif
     SmartLastIndex[best->smart_priority - SMART_MIN_PRIORITY] = best->index;
+    if (dispatchProfile)
+        DispatchProfileSchedule(best, best->smart_input_pending,
+                                best->smart_input_pending ?
+                                now - best->smart_input_tick : 0);
+    best->smart_input_pending = FALSE;
+    SmartInputDeadlineSet = FALSE;
     /*
      * Set current client pointer
      */
@@ -489,7 +535,9 @@ void DispatchQueuedEvents(Bool wait)
     {
         if (InputCheckPending())
         {
+            BeginOutputBatch();
             ProcessInputEvents();
+            EndOutputBatch();
             FlushIfCriticalOutputPending();
         }
 
@@ -528,12 +576,16 @@ void DispatchQueuedEvents(Bool wait)
             start_tick = SmartScheduleTime;
             while (!isItTimeToYield)
             {
-                int result;
+                int result, prof_bytes = 0;
+                CARD64 prof_start, prof_time;
 #ifdef XSERVER_DTRACE
                 CARD8 StartMajorOp;
 #endif
-                if (InputCheckPending())
+                if (InputCheckPending()) {
+                    BeginOutputBatch();
                     ProcessInputEvents();
+                    EndOutputBatch();
+                }
 
                 FlushIfCriticalOutputPending();
                 if ((SmartScheduleTime - start_tick) >= SmartScheduleSlice)
@@ -543,6 +595,10 @@ void DispatchQueuedEvents(Bool wait)
                         client->smart_priority--;
                     break;
                 }
+                /* Give way to a client that was just sent input */
+                if (SmartInputDeadlineSet &&
+                    (SmartScheduleTime - SmartInputDeadline) >= 0)
+                    break;
 
                 /* now, finally, deal with client requests */
                 result = ReadRequestFromClient(client);
@@ -552,6 +608,8 @@ void DispatchQueuedEvents(Bool wait)
                         CloseDownClient(client);
                     break;
                 }
+                prof_bytes = result;
+                prof_start = GetTimeInMicros();
 
                 client->sequence++;
                 client->majorOp = ((xReq *) client->requestBuffer)->reqType;
@@ -574,6 +632,11 @@ void DispatchQueuedEvents(Bool wait)
                                           client->requestBuffer);
                 }
 #endif
+                WinTraceStart("Request",
+                              TraceLoggingUInt8(client->majorOp, "Major"),
+                              TraceLoggingUInt16(client->minorOp, "Minor"),
+                              TraceLoggingInt32(client->index, "Client"),
+                              TraceLoggingInt32(prof_bytes, "Bytes"));
                 if (result > (maxBigRequestSize << 2))
                     result = BadLength;
                 else
@@ -588,6 +651,17 @@ void DispatchQueuedEvents(Bool wait)
                 }
                 if (!SmartScheduleSignalEnable)
                     SmartScheduleTime = GetTimeInMillis();
+                prof_time = GetTimeInMicros() - prof_start;
+                client->requestCount++;
+                client->dispatchTime += prof_time;
+                if (dispatchProfile)
+                    DispatchProfileRequest(client, client->majorOp,
+                                           client->minorOp, prof_bytes,
+                                           prof_time);
+                WinTraceStop("Request",
+                             TraceLoggingUInt8(client->majorOp, "Major"),
+                             TraceLoggingInt32(client->index, "Client"),
+                             TraceLoggingInt32(result, "Result"));
 
 #ifdef XSERVER_DTRACE
                 if (XSERVER_REQUEST_DONE_ENABLED())
@@ -2158,18 +2232,20 @@ ReformatImage(char *base, int nbytes, int bpp, int order)
  * Also, we need to make sure that the image is aligned on a 64-bit
  * boundary, even if the scanlines are padded to our satisfaction.
  */
+/*
+ * Draw the image at data, of size bytes (padded to a multiple of four),
+ * with the parameters of the PutImage request stuff.  The data is
+ * converted to the server's bit and byte order in place.  Also used by
+ * IMAGE-CACHE for images it holds.
+ */
 int
-ProcPutImage(ClientPtr client)
+DoPutImage(ClientPtr client, xPutImageReq *stuff, char *data, long size)
 {
     GC *pGC;
     DrawablePtr pDraw;
     long length;                /* length of scanline server padded */
     long lengthProto;           /* length of scanline protocol padded */
-    char *tmpImage;
 
-    REQUEST(xPutImageReq);
-
-    REQUEST_AT_LEAST_SIZE(xPutImageReq);
     VALIDATE_DRAWABLE_AND_GC(stuff->drawable, pDraw, DixWriteAccess);
     if (stuff->format == XYBitmap) {
         if ((stuff->depth != 1) ||
@@ -2194,27 +2270,35 @@ ProcPutImage(ClientPtr client)
         return BadValue;
     }
 
-    tmpImage = (char *) &stuff[1];
     lengthProto = length;
 
     if (stuff->height != 0 && lengthProto >= (INT32_MAX / stuff->height))
         return BadLength;
 
-    if ((bytes_to_int32(lengthProto * stuff->height) +
-         bytes_to_int32(sizeof(xPutImageReq))) != client->req_len)
+    if (pad_to_int32(lengthProto * stuff->height) != size)
         return BadLength;
 
-    ReformatImage(tmpImage, lengthProto * stuff->height,
+    ReformatImage(data, lengthProto * stuff->height,
                   stuff->format == ZPixmap ? BitsPerPixel(stuff->depth) : 1,
                   ClientOrder(client));
 
     (*pGC->ops->PutImage) (pDraw, pGC, stuff->depth, stuff->dstX, stuff->dstY,
                            stuff->width, stuff->height,
-                           stuff->leftPad, stuff->format, tmpImage);
+                           stuff->leftPad, stuff->format, data);
 
     return Success;
 }
 
+int
+ProcPutImage(ClientPtr client)
+{
+    REQUEST(xPutImageReq);
+
+    REQUEST_AT_LEAST_SIZE(xPutImageReq);
+    return DoPutImage(client, stuff, (char *) &stuff[1],
+                      ((long) client->req_len << 2) - sizeof(xPutImageReq));
+}
+
 static int
 DoGetImage(ClientPtr client, int format, Drawable drawable,
            int x, int y, int width, int height,
@@ -2228,7 +2312,9 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
     int relx, rely;
     long widthBytesLine, length;
     Mask plane = 0;
+    Mask allPlanes;
     char *pBuf;
+    Bool clearBuf;
     xGetImageReply xgi;
     RegionPtr pVisibleRegion = NULL;
 
@@ -2341,8 +2427,16 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             length += widthBytesLine;
         }
     }
-    if (!(pBuf = calloc(1, length)))
-        return BadAlloc;
+    /* Bands are generated straight into the client's output buffer, which
+     * holds stale data; clear it unless GetImage will fill every bit, i.e.
+     * scanlines are not padded and no planes are left out */
+    allPlanes = ((Mask) 1) << (pDraw->depth - 1);
+    allPlanes |= allPlanes - 1;
+    if (format == ZPixmap)
+        clearBuf = (long) width * BitsPerPixel(pDraw->depth) !=
+            widthBytesLine * 8 || (planemask & allPlanes) != allPlanes;
+    else
+        clearBuf = width != widthBytesLine * 8;
     WriteReplyToClient(client, sizeof(xGetImageReply), &xgi);
 
     if (pDraw->type == DRAWABLE_WINDOW) {
@@ -2358,6 +2452,11 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
         linesDone = 0;
         while (height - linesDone > 0) {
             nlines = min(linesPerBuf, height - linesDone);
+            if (!(pBuf = ReserveClientOutput(client,
+                                             (int) (nlines * widthBytesLine))))
+                return Success;
+            if (clearBuf)
+                memset(pBuf, 0, nlines * widthBytesLine);
             (*pDraw->pScreen->GetImage) (pDraw,
                                          x,
                                          y + linesDone,
@@ -2385,6 +2484,11 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
                 linesDone = 0;
                 while (height - linesDone > 0) {
                     nlines = min(linesPerBuf, height - linesDone);
+                    if (!(pBuf = ReserveClientOutput(client,
+                                        (int) (nlines * widthBytesLine))))
+                        return Success;
+                    if (clearBuf)
+                        memset(pBuf, 0, nlines * widthBytesLine);
                     (*pDraw->pScreen->GetImage) (pDraw,
                                                  x,
                                                  y + linesDone,
@@ -2408,7 +2512,6 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             }
         }
     }
-    free(pBuf);
     return Success;
 }
 
@@ -3619,6 +3722,8 @@ CloseDownClient(ClientPtr client)
         TouchListenerGone(client->clientAsMask);
         GestureListenerGone(client->clientAsMask);
         FreeClientResources(client);
+        if (dispatchProfile)
+            DispatchProfileClientGone(client);
         /* Disable client ID tracking. This must be done after
          * ClientStateCallback. */
         ReleaseClientIds(client);
@@ -3665,6 +3770,10 @@ InitClient(ClientPtr client, int i, void *ospriv)
     QueryMinMaxKeyCodes(&client->minKC, &client->maxKC);
     client->smart_start_tick = SmartScheduleTime;
     client->smart_stop_tick = SmartScheduleTime;
+    client->smart_input_tick = SmartScheduleTime;
+    client->smart_input_pending = FALSE;
+    client->requestCount = 0;
+    client->dispatchTime = 0;
     client->clientIds = NULL;
 }
 
@@ -3751,14 +3860,101 @@ ProcInitialConnection(ClientPtr client)
     return Success;
 }
 
+/*
+ * The successful connection setup reply, prefix and block, serialized
+ * once in each byte order, so that a new client costs one copy into its
+ * output buffer instead of a walk over every root, depth and visual (and
+ * a full byte swap for swapped clients).  Only ridBase and the roots'
+ * currentInputMask (and, with MATCH_CLIENT_ENDIAN, the image byte
+ * orders) differ between clients; they are patched in before the write.
+ * Anything that edits ConnectionInfo after it is created must call
+ * InvalidateConnSetupCache().
+ */
+static char *connSetupReply[2];         /* server order, swapped */
+static int connSetupReplyLength;
+static int connSetupNumRoots;
+static int *connSetupRootOffsets;       /* of each xWindowRoot in a reply */
+
+void
+InvalidateConnSetupCache(void)
+{
+    free(connSetupReply[0]);
+    free(connSetupReply[1]);
+    connSetupReply[0] = connSetupReply[1] = NULL;
+    free(connSetupRootOffsets);
+    connSetupRootOffsets = NULL;
+}
+
+static Bool
+BuildConnSetupReply(void)
+{
+    xConnSetup *setup;
+    xWindowRoot *root;
+    char *reply;
+    int i;
+
+    connSetupNumRoots = screenInfo.numScreens;
+#ifdef PANORAMIX
+    if (!noPanoramiXExtension)
+        connSetupNumRoots = ((xConnSetup *) ConnectionInfo)->numRoots;
+#endif
+    connSetupReplyLength = sizeof(xConnSetupPrefix) +
+        (connSetupPrefix.length << 2);
+
+    reply = malloc(connSetupReplyLength);
+    connSetupRootOffsets = xallocarray(connSetupNumRoots, sizeof(int));
+    if (!reply || !connSetupRootOffsets) {
+        free(reply);
+        InvalidateConnSetupCache();
+        return FALSE;
+    }
+
+    memcpy(reply, &connSetupPrefix, sizeof(xConnSetupPrefix));
+    memcpy(reply + sizeof(xConnSetupPrefix), ConnectionInfo,
+           connSetupPrefix.length << 2);
+    setup = (xConnSetup *) (reply + sizeof(xConnSetupPrefix));
+    setup->ridMask = RESOURCE_ID_MASK;
+
+    root = (xWindowRoot *) ((char *) setup + connBlockScreenStart);
+    for (i = 0; i < connSetupNumRoots; i++) {
+        unsigned int j;
+        xDepth *pDepth;
+
+        connSetupRootOffsets[i] = (char *) root - reply;
+        pDepth = (xDepth *) (root + 1);
+        for (j = 0; j < root->nDepths; j++) {
+            pDepth = (xDepth *) (((char *) (pDepth + 1)) +
+                                 pDepth->nVisuals * sizeof(xVisualType));
+        }
+        root = (xWindowRoot *) pDepth;
+    }
+
+    connSetupReply[0] = reply;
+    return TRUE;
+}
+
+static Bool
+BuildSwappedConnSetupReply(void)
+{
+    char *reply = malloc(connSetupReplyLength);
+
+    if (!reply)
+        return FALSE;
+
+    SwapConnSetupPrefix((xConnSetupPrefix *) connSetupReply[0],
+                        (xConnSetupPrefix *) reply);
+    SwapConnSetupInfo(connSetupReply[0] + sizeof(xConnSetupPrefix),
+                      reply + sizeof(xConnSetupPrefix));
+    connSetupReply[1] = reply;
+    return TRUE;
+}
+
 static int
 SendConnSetup(ClientPtr client, const char *reason)
 {
-    xWindowRoot *root;
+    xConnSetup *setup;
     int i;
-    int numScreens;
-    char *lConnectionInfo;
-    xConnSetupPrefix *lconnSetupPrefix;
+    char *reply;
 
     if (reason) {
         xConnSetupPrefix csp;
@@ -3776,9 +3972,11 @@ SendConnSetup(ClientPtr client, const char *reason)
         return client->noClientException = -1;
     }
 
-    numScreens = screenInfo.numScreens;
-    lConnectionInfo = ConnectionInfo;
-    lconnSetupPrefix = &connSetupPrefix;
+    if (!connSetupReply[0] && !BuildConnSetupReply())
+        return client->noClientException = -1;
+    if (client->swapped && !connSetupReply[1] &&
+        !BuildSwappedConnSetupReply())
+        return client->noClientException = -1;
 
     /* We're about to start speaking X protocol back to the client by
      * sending the connection setup info.  This means the authorization
@@ -3789,53 +3987,42 @@ SendConnSetup(ClientPtr client, const char *reason)
 
     client->requestVector = client->swapped ? SwappedProcVector : ProcVector;
     client->sequence = 0;
-    ((xConnSetup *) lConnectionInfo)->ridBase = client->clientAsMask;
-    ((xConnSetup *) lConnectionInfo)->ridMask = RESOURCE_ID_MASK;
-#ifdef MATCH_CLIENT_ENDIAN
-    ((xConnSetup *) lConnectionInfo)->imageByteOrder = ClientOrder(client);
-    ((xConnSetup *) lConnectionInfo)->bitmapBitOrder = ClientOrder(client);
-#endif
-    /* fill in the "currentInputMask" */
-    root = (xWindowRoot *) (lConnectionInfo + connBlockScreenStart);
-#ifdef PANORAMIX
-    if (noPanoramiXExtension)
-        numScreens = screenInfo.numScreens;
-    else
-        numScreens = ((xConnSetup *) ConnectionInfo)->numRoots;
-#endif
 
-    for (i = 0; i < numScreens; i++) {
-        unsigned int j;
-        xDepth *pDepth;
-        WindowPtr pRoot = screenInfo.screens[i]->root;
+    /* the server order copy is kept current for ClientStateCallback */
+    for (i = 0; i < (client->swapped ? 2 : 1); i++) {
+        int r;
 
-        root->currentInputMask = pRoot->eventMask | wOtherEventMasks(pRoot);
-        pDepth = (xDepth *) (root + 1);
-        for (j = 0; j < root->nDepths; j++) {
-            pDepth = (xDepth *) (((char *) (pDepth + 1)) +
-                                 pDepth->nVisuals * sizeof(xVisualType));
+        reply = connSetupReply[i];
+        setup = (xConnSetup *) (reply + sizeof(xConnSetupPrefix));
+        setup->ridBase = client->clientAsMask;
+#ifdef MATCH_CLIENT_ENDIAN
+        setup->imageByteOrder = ClientOrder(client);
+        setup->bitmapBitOrder = ClientOrder(client);
+#endif
+        for (r = 0; r < connSetupNumRoots; r++) {
+            xWindowRoot *root = (xWindowRoot *)
+                (reply + connSetupRootOffsets[r]);
+            WindowPtr pRoot = screenInfo.screens[r]->root;
+
+            root->currentInputMask = pRoot->eventMask |
+                wOtherEventMasks(pRoot);
+            if (i)
+                swapl(&root->currentInputMask);
         }
-        root = (xWindowRoot *) pDepth;
+        if (i)
+            swapl(&setup->ridBase);
     }
 
-    if (client->swapped) {
-        WriteSConnSetupPrefix(client, lconnSetupPrefix);
-        WriteSConnectionInfo(client,
-                             (unsigned long) (lconnSetupPrefix->length << 2),
-                             lConnectionInfo);
-    }
-    else {
-        WriteToClient(client, sizeof(xConnSetupPrefix), lconnSetupPrefix);
-        WriteToClient(client, (int) (lconnSetupPrefix->length << 2),
-		      lConnectionInfo);
-    }
+    WriteToClient(client, connSetupReplyLength, reply);
+
     client->clientState = ClientStateRunning;
     if (ClientStateCallback) {
         NewClientInfoRec clientinfo;
 
         clientinfo.client = client;
-        clientinfo.prefix = lconnSetupPrefix;
-        clientinfo.setup = (xConnSetup *) lConnectionInfo;
+        clientinfo.prefix = (xConnSetupPrefix *) connSetupReply[0];
+        clientinfo.setup = (xConnSetup *)
+            (connSetupReply[0] + sizeof(xConnSetupPrefix));
         CallCallbacks((&ClientStateCallback), (void *) &clientinfo);
     }
     CancelDispatchExceptionTimer();
@@ -3869,6 +4056,9 @@ ProcEstablishConnection(ClientPtr client)
                                   auth_proto,
                                   (unsigned short) prefix->nbytesAuthString,
                                   auth_string);
+        /* comes back through here once the host lookup is done */
+        if (reason == ClientAuthDeferred)
+            return Success;
     }
 
     return (SendConnSetup(client, reason));
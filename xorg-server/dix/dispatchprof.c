@@ -0,0 +1,223 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Request dispatch profiler.
+ *
+ * Enabled with -dispatchprofile.  Dispatch() times every request it
+ * runs and files it under its major opcode, or under major and minor
+ * opcode for extension requests.  Each entry keeps a call count, the
+ * total time and a log2 histogram of the time per call, which is enough
+ * to give a p99 within a factor of two without keeping any samples.
+ * Request and reply bytes are counted per client, as are the scheduler's
+ * decisions: how many slices a client was given, how many of those were
+ * owed to input it had been sent, and how long that input waited.
+ *
+ * DispatchProfileReport() writes the table to the log, followed by
+ * dixPrivateUsage()'s object counts and cache hit rates and the input
+ * queue's statistics; it runs at every server reset and the ddx may call
+ * it at any other time.  A client's traffic is logged when it disconnects.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#include "misc.h"
+#include "os.h"
+#include "dixstruct.h"
+#include "registry.h"
+#include "client.h"
+#include "opaque.h"
+#include "privates.h"
+#include "mi.h"
+
+#define PROF_BUCKETS 24         /* up to 2^23 us, about 8 s */
+
+typedef struct _ProfEntry {
+    unsigned long count;
+    CARD64 total;               /* microseconds */
+    CARD64 max;
+    CARD32 hist[PROF_BUCKETS];  /* hist[i]: took less than 2^i us */
+} ProfEntry;
+
+typedef struct _ProfClient {
+    unsigned long requests;
+    CARD64 bytesIn;
+    CARD64 bytesOut;
+    CARD64 time;
+    unsigned long slices;
+    unsigned long inputSlices;
+    long inputWait;             /* ms, summed over inputSlices */
+    long inputWaitMax;
+} ProfClient;
+
+static ProfEntry coreEntries[EXTENSION_BASE];
+static ProfEntry *extEntries[MAXEXTENSIONS];   /* 256 minors each */
+static ProfClient profClients[MAXCLIENTS];
+static ProfClient profSchedule;     /* scheduler totals since the last report */
+
+static int
+ProfBucket(CARD64 us)
+{
+    int i;
+
+    for (i = 0; i < PROF_BUCKETS - 1; i++)
+        if (us < ((CARD64) 1 << i))
+            break;
+    return i;
+}
+
+static ProfEntry *
+ProfLookup(int major, int minor, Bool create)
+{
+    ProfEntry **ext;
+
+    if (major < EXTENSION_BASE)
+        return &coreEntries[major];
+    if (major - EXTENSION_BASE >= MAXEXTENSIONS)
+        return NULL;
+    ext = &extEntries[major - EXTENSION_BASE];
+    if (!*ext && create)
+        *ext = calloc(256, sizeof(ProfEntry));
+    return *ext ? &(*ext)[minor & 0xff] : NULL;
+}
+
+void
+DispatchProfileRequest(ClientPtr client, int major, int minor,
+                       int bytes, CARD64 us)
+{
+    ProfEntry *entry = ProfLookup(major, minor, TRUE);
+    ProfClient *pc = &profClients[client->index];
+
+    if (entry) {
+        entry->count++;
+        entry->total += us;
+        if (us > entry->max)
+            entry->max = us;
+        entry->hist[ProfBucket(us)]++;
+    }
+    pc->requests++;
+    pc->bytesIn += bytes;
+    pc->time += us;
+}
+
+void
+DispatchProfileOutput(ClientPtr client, int bytes)
+{
+    profClients[client->index].bytesOut += bytes;
+}
+
+void
+DispatchProfileSchedule(ClientPtr client, Bool input, long wait)
+{
+    ProfClient *pcs[2] = { &profClients[client->index], &profSchedule };
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        ProfClient *pc = pcs[i];
+
+        pc->slices++;
+        if (input) {
+            pc->inputSlices++;
+            pc->inputWait += wait;
+            if (wait > pc->inputWaitMax)
+                pc->inputWaitMax = wait;
+        }
+    }
+}
+
+void
+DispatchProfileClientGone(ClientPtr client)
+{
+    ProfClient *pc = &profClients[client->index];
+    const char *name = GetClientCmdName(client);
+
+    if (pc->requests || pc->bytesOut)
+        LogMessageVerb(X_INFO, 0, "profile: client %d (%s): %lu requests, "
+                       "%llu bytes in, %llu bytes out, %llu us, "
+                       "%lu slices, %lu for input (max wait %ld ms)\n",
+                       client->index, name ? name : "unknown", pc->requests,
+                       (unsigned long long) pc->bytesIn,
+                       (unsigned long long) pc->bytesOut,
+                       (unsigned long long) pc->time,
+                       pc->slices, pc->inputSlices, pc->inputWaitMax);
+    memset(pc, 0, sizeof(*pc));
+}
+
+static CARD64
+ProfPercentile(const ProfEntry *entry, int percent)
+{
+    unsigned long want = (entry->count * percent + 99) / 100;
+    unsigned long seen = 0;
+    int i;
+
+    for (i = 0; i < PROF_BUCKETS - 1; i++) {
+        seen += entry->hist[i];
+        if (seen >= want)
+            return (CARD64) 1 << i;
+    }
+    return entry->max;
+}
+
+static void
+ProfReportEntry(int major, int minor, const ProfEntry *entry)
+{
+    const char *name = major < EXTENSION_BASE ? LookupMajorName(major)
+        : LookupRequestName(major, minor);
+
+    LogMessageVerb(X_NONE, 0, "  %3d.%-3d %-36s %10lu %12llu %8llu %8llu %8llu\n",
+                   major, minor, name, entry->count,
+                   (unsigned long long) entry->total,
+                   (unsigned long long) (entry->total / entry->count),
+                   (unsigned long long) ProfPercentile(entry, 99),
+                   (unsigned long long) entry->max);
+}
+
+void
+DispatchProfileReport(void)
+{
+    int major, minor;
+
+    if (!dispatchProfile)
+        return;
+
+    LogMessageVerb(X_INFO, 0, "profile: requests since the last report "
+                   "(times in us, p99 is an upper bound)\n");
+    LogMessageVerb(X_NONE, 0, "  %-7s %-36s %10s %12s %8s %8s %8s\n",
+                   "opcode", "request", "calls", "total", "avg", "p99",
+                   "max");
+    for (major = 0; major < EXTENSION_BASE; major++)
+        if (coreEntries[major].count)
+            ProfReportEntry(major, 0, &coreEntries[major]);
+    for (major = EXTENSION_BASE; major < EXTENSION_BASE + MAXEXTENSIONS;
+         major++) {
+        ProfEntry *ext = extEntries[major - EXTENSION_BASE];
+
+        if (!ext)
+            continue;
+        for (minor = 0; minor < 256; minor++)
+            if (ext[minor].count)
+                ProfReportEntry(major, minor, &ext[minor]);
+    }
+
+    LogMessageVerb(X_INFO, 0, "profile: scheduler: %lu slices, %lu for input, "
+                   "input waited %ld ms on average, %ld ms at most\n",
+                   profSchedule.slices, profSchedule.inputSlices,
+                   profSchedule.inputSlices ?
+                   profSchedule.inputWait / (long) profSchedule.inputSlices : 0,
+                   profSchedule.inputWaitMax);
+
+    /* Object counts, private object cache hit rates and input queue */
+    dixPrivateUsage();
+    mieqLogStats();
+
+    memset(&profSchedule, 0, sizeof(profSchedule));
+    memset(coreEntries, 0, sizeof(coreEntries));
+    for (major = 0; major < MAXEXTENSIONS; major++) {
+        free(extEntries[major]);
+        extEntries[major] = NULL;
+    }
+}
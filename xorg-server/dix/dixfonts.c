@@ -86,6 +86,104 @@ static int size_slept_fpes = 0;
 static FontPathElementPtr *slept_fpes = (FontPathElementPtr *) 0;
 static xfont2_pattern_cache_ptr patternCache;
 
+/*
+ * Replies to recent ListFonts requests.  Toolkits starting up ask for the
+ * same patterns over and over, and each one otherwise walks every element
+ * of the font path.  The replies only change when the font path does,
+ * except for font servers, so entries also go stale after a while.
+ */
+#define LIST_FONTS_CACHE_SIZE   8
+#define LIST_FONTS_CACHE_TIME   30000   /* ms */
+
+typedef struct _ListFontsCache {
+    unsigned int patlen;        /* 0 when the slot is empty */
+    unsigned int max_names;
+    char pattern[XLFDMAXFONTNAMELEN];
+    CARD16 nFonts;
+    int length;                 /* of data, unpadded */
+    char *data;
+    CARD32 time;
+} ListFontsCacheRec, *ListFontsCachePtr;
+
+static ListFontsCacheRec listFontsCache[LIST_FONTS_CACHE_SIZE];
+
+static void
+FlushListFontsCache(void)
+{
+    int i;
+
+    for (i = 0; i < LIST_FONTS_CACHE_SIZE; i++) {
+        free(listFontsCache[i].data);
+        listFontsCache[i].data = NULL;
+        listFontsCache[i].patlen = 0;
+    }
+}
+
+static unsigned long
+TrimListFontsCache(void *closure)
+{
+    unsigned long bytes = 0;
+    int i;
+
+    for (i = 0; i < LIST_FONTS_CACHE_SIZE; i++)
+        if (listFontsCache[i].data)
+            bytes += listFontsCache[i].length;
+    FlushListFontsCache();
+    return bytes;
+}
+
+static ListFontsCachePtr
+FindListFontsCache(const char *pattern, unsigned int patlen,
+                   unsigned int max_names)
+{
+    CARD32 now = GetTimeInMillis();
+    int i;
+
+    for (i = 0; i < LIST_FONTS_CACHE_SIZE; i++) {
+        ListFontsCachePtr entry = &listFontsCache[i];
+
+        if (entry->patlen == patlen && entry->max_names == max_names &&
+            memcmp(entry->pattern, pattern, patlen) == 0) {
+            if ((int) (now - entry->time) > LIST_FONTS_CACHE_TIME) {
+                free(entry->data);
+                entry->data = NULL;
+                entry->patlen = 0;
+                return NULL;
+            }
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* Keep a reply, pushing out the oldest one */
+static void
+AddListFontsCache(const char *pattern, unsigned int patlen,
+                  unsigned int max_names, CARD16 nFonts,
+                  const char *data, int length)
+{
+    ListFontsCachePtr entry = &listFontsCache[0];
+    int i;
+
+    for (i = 1; i < LIST_FONTS_CACHE_SIZE && entry->patlen; i++)
+        if (!listFontsCache[i].patlen ||
+            (int) (listFontsCache[i].time - entry->time) < 0)
+            entry = &listFontsCache[i];
+
+    free(entry->data);
+    entry->patlen = 0;
+    entry->data = malloc(length ? length : 1);
+    if (!entry->data)
+        return;
+    memcpy(entry->data, data, length);
+    memcpy(entry->pattern, pattern, patlen);
+    entry->patlen = patlen;
+    entry->max_names = max_names;
+    entry->nFonts = nFonts;
+    entry->length = length;
+    entry->time = GetTimeInMillis();
+}
+
 static int
 FontToXError(int err)
 {
@@ -787,6 +885,10 @@ doListFontsAndAliases(ClientPtr client, LFclosurePtr c)
     client->pSwapReplyFunc = ReplySwapVector[X_ListFonts];
     WriteSwappedDataToClient(client, sizeof(xListFontsReply), &reply);
     WriteToClient(client, stringLens + nnames, bufferStart);
+    if (c->current.patlen)
+        AddListFontsCache(c->current.pattern, c->current.patlen,
+                          c->current.max_names, reply.nFonts,
+                          bufferStart, stringLens + nnames);
     free(bufferStart);
 
  bail:
@@ -810,6 +912,7 @@ ListFonts(ClientPtr client, unsigned char *pattern, unsigned length,
 {
     int i;
     LFclosurePtr c;
+    ListFontsCachePtr cached;
 
     /*
      * The right error to return here would be BadName, however the
@@ -824,6 +927,22 @@ ListFonts(ClientPtr client, unsigned char *pattern, unsigned length,
     if (i != Success)
         return i;
 
+    cached = length ? FindListFontsCache((char *) pattern, length, max_names)
+                    : NULL;
+    if (cached) {
+        xListFontsReply reply = {
+            .type = X_Reply,
+            .sequenceNumber = client->sequence,
+            .length = bytes_to_int32(cached->length),
+            .nFonts = cached->nFonts
+        };
+
+        client->pSwapReplyFunc = ReplySwapVector[X_ListFonts];
+        WriteSwappedDataToClient(client, sizeof(xListFontsReply), &reply);
+        WriteToClient(client, cached->length, cached->data);
+        return Success;
+    }
+
     if (!(c = malloc(sizeof *c)))
         return BadAlloc;
     c->fpe_list = xallocarray(num_fpes, sizeof(FontPathElementPtr));
@@ -1613,6 +1732,9 @@ SetFontPathElements(int npaths, unsigned char *paths, int *bad, Bool persist)
     unsigned char *cp = paths;
     FontPathElementPtr fpe = NULL, *fplist;
 
+    /* resetting even the same elements may rescan their directories */
+    FlushListFontsCache();
+
     fplist = xallocarray(npaths, sizeof(FontPathElementPtr));
     if (!fplist) {
         *bad = 0;
@@ -1905,6 +2027,7 @@ get_client_resolutions(int *num)
 void
 FreeFonts(void)
 {
+    FlushListFontsCache();
     if (patternCache) {
         xfont2_free_font_pattern_cache(patternCache);
         patternCache = 0;
@@ -2092,4 +2215,5 @@ InitFonts(void)
 	xfont2_free_font_pattern_cache(fontPatternCache);
     fontPatternCache = xfont2_make_font_pattern_cache();
     xfont2_init(&xfont2_client_funcs);
+    RegisterCacheTrim("ListFonts replies", 20, TrimListFontsCache, NULL);
 }
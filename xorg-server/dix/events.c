@@ -2109,6 +2109,7 @@ TryClientEvents(ClientPtr client, DeviceIntPtr dev, xEvent *pEvents,
     if (BitIsOn(criticalEvents, type)) {
         if (client->smart_priority < SMART_MAX_PRIORITY)
             client->smart_priority++;
+        SmartScheduleInput(client);
         SetCriticalOutputPending();
     }
 
@@ -2862,10 +2863,27 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
     Window child = None;
     int deliveries = 0;
     int mask;
+    int xi2type, type;
+    Mask xifilter = 0, corefilter = 0;
 
     verify_internal_event(event);
 
+    /* What any window from here up could want, see
+     * RecalculateDeliverableEvents.  Once the summaries rule the event out,
+     * no ancestor will take it either. */
+    xi2type = GetXI2Type(event->any.type);
+    if ((type = GetXIType(event->any.type)) != 0)
+        xifilter = event_get_filter_from_type(dev, type);
+    if ((type = GetCoreType(event->any.type)) != 0 &&
+        IsMaster(dev) && dev->coreEvents)
+        corefilter = event_get_filter_from_type(dev, type);
+
     while (pWin) {
+        if (!(xi2type && (pWin->xi2Deliverable & ((uint64_t) 1 << xi2type))) &&
+            !(pWin->xiDeliverable & xifilter) &&
+            !(pWin->deliverableEvents & corefilter))
+            break;
+
         if ((mask = EventIsDeliverable(dev, event->any.type, pWin))) {
             /* XI2 events first */
             if (mask & EVENT_XI2_MASK) {
@@ -3244,6 +3262,7 @@ WindowsRestructured(void)
 {
     DeviceIntPtr pDev = inputInfo.devices;
 
+    WindowTreeSerial++;
     while (pDev) {
         if (IsMaster(pDev) || IsFloating(pDev))
             CheckMotion(NULL, pDev);
@@ -4504,6 +4523,10 @@ FixKeyState(DeviceEvent *event, DeviceIntPtr keybd)
 #define ManagerMask \
 	(SubstructureRedirectMask | ResizeRedirectMask)
 
+#if XI2LASTEVENT >= 64
+#error "WindowRec.xi2Deliverable cannot hold all XI2 event types"
+#endif
+
 /**
  * Recalculate which events may be deliverable for the given window.
  * Recalculated mask is used for quicker determination which events may be
@@ -4514,13 +4537,20 @@ FixKeyState(DeviceEvent *event, DeviceIntPtr keybd)
  * deliverableEventMask is the combination of the eventMask and the
  * otherEventMask plus the events that may be propagated to the parent.
  *
+ * xiDeliverable and xi2Deliverable likewise summarize the XI and XI2
+ * selections on the window and its ancestors, for all devices.  They ignore
+ * DontPropagate masks, so they may claim more than can be delivered, but
+ * never less; DeliverDeviceEvents relies on that.
+ *
  * Traverses to siblings and parents of the window.
  */
 void
 RecalculateDeliverableEvents(WindowPtr pWin)
 {
     OtherClients *others;
+    OtherInputMasks *inputMasks;
     WindowPtr pChild;
+    int i, j;
 
     pChild = pWin;
     while (1) {
@@ -4532,10 +4562,28 @@ RecalculateDeliverableEvents(WindowPtr pWin)
         }
         pChild->deliverableEvents = pChild->eventMask |
             wOtherEventMasks(pChild);
-        if (pChild->parent)
+        pChild->xiDeliverable = 0;
+        pChild->xi2Deliverable = 0;
+        if ((inputMasks = wOtherInputMasks(pChild))) {
+            const XI2Mask *xi2mask = inputMasks->xi2mask;
+
+            for (i = 0; i < EMASKSIZE; i++)
+                pChild->xiDeliverable |= inputMasks->inputEvents[i];
+            for (i = 0; i < xi2mask_num_masks(xi2mask); i++) {
+                const unsigned char *m = xi2mask_get_one_mask(xi2mask, i);
+
+                for (j = 0; j < xi2mask_mask_size(xi2mask); j++)
+                    pChild->xi2Deliverable |= (uint64_t) m[j] << (j * 8);
+            }
+        }
+        if (pChild->parent) {
             pChild->deliverableEvents |=
                 (pChild->parent->deliverableEvents &
                  ~wDontPropagateMask(pChild) & PropagateMask);
+            pChild->xiDeliverable |=
+                pChild->parent->xiDeliverable & XIPropagateMask;
+            pChild->xi2Deliverable |= pChild->parent->xi2Deliverable;
+        }
         if (pChild->firstChild) {
             pChild = pChild->firstChild;
             continue;
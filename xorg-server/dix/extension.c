@@ -68,6 +68,8 @@ int lastEvent = EXTENSION_EVENT_BASE;
 static int lastError = FirstExtensionError;
 static unsigned int NumExtensions = 0;
 
+static int FindExtension(const char *extname, int len);
+
 ExtensionEntry *
 AddExtension(const char *name, int NumEvents, int NumErrors,
              int (*MainProc) (ClientPtr c1),
@@ -80,6 +82,27 @@ AddExtension(const char *name, int NumEvents, int NumErrors,
 
     if (!MainProc || !SwappedMainProc || !MinorOpcodeProc)
         return ((ExtensionEntry *) NULL);
+
+    /* A deferred extension takes over the entry reserved for it. */
+    i = FindExtension(name, strlen(name));
+    if (i >= 0 && extensions[i]->deferredInit) {
+        ext = extensions[i];
+        if (ext->eventLast - ext->eventBase != NumEvents ||
+            ext->errorLast - ext->errorBase != NumErrors) {
+            LogMessage(X_ERROR, "Not enabling extension %s: %d events and "
+                       "%d errors were reserved for it, not %d and %d.\n",
+                       name, ext->eventLast - ext->eventBase,
+                       ext->errorLast - ext->errorBase, NumEvents, NumErrors);
+            return ((ExtensionEntry *) NULL);
+        }
+        ext->deferredInit = NULL;
+        ext->CloseDown = CloseDownProc;
+        ext->MinorOpcode = MinorOpcodeProc;
+        ProcVector[ext->base] = MainProc;
+        SwappedProcVector[ext->base] = SwappedMainProc;
+        return ext;
+    }
+
     if ((lastEvent + NumEvents > MAXEVENTS) ||
         (unsigned) (lastError + NumErrors > LAST_ERROR)) {
         LogMessage(X_ERROR, "Not enabling extension %s: maximum number of "
@@ -155,6 +178,68 @@ FindExtension(const char *extname, int len)
     return ((i == NumExtensions) ? -1 : i);
 }
 
+/*
+ * Run the init function of a deferred extension, which fills in the entry
+ * through AddExtension.  If it doesn't, the extension is withdrawn: it is
+ * no longer listed and its requests fail with BadRequest.
+ */
+static Bool
+InitDeferredExtension(ExtensionEntry *ext)
+{
+    InitExtension initFunc = ext->deferredInit;
+
+    if (!initFunc)
+        return ext->base != 0;
+
+    LogMessageVerb(X_INFO, 3, "Initializing extension %s on first use\n",
+                   ext->name);
+    (*initFunc) ();
+    if (!ext->deferredInit)
+        return TRUE;
+
+    LogMessage(X_WARNING, "Extension %s failed to initialize\n", ext->name);
+    ext->deferredInit = NULL;
+    ProcVector[ext->base] = ProcBadRequest;
+    SwappedProcVector[ext->base] = ProcBadRequest;
+    ext->base = 0;
+    return FALSE;
+}
+
+/* The request handler of a deferred extension until its first request */
+static int
+DeferredExtensionProc(ClientPtr client)
+{
+    REQUEST(xReq);
+    ExtensionEntry *ext = GetExtensionEntry(stuff->reqType);
+
+    if (!ext || !InitDeferredExtension(ext))
+        return BadRequest;
+    if (client->swapped)
+        return (*SwappedProcVector[stuff->reqType]) (client);
+    return (*ProcVector[stuff->reqType]) (client);
+}
+
+/*
+ * Reserve a major opcode, events and errors for an extension but leave
+ * initFunc, which must call AddExtension with the same name and counts,
+ * until a client queries the extension or sends it a request.  For
+ * extensions that need nothing set up before the first client connects:
+ * no window, pixmap or GC privates and no screen wrappers.
+ */
+ExtensionEntry *
+AddDeferredExtension(const char *name, int NumEvents, int NumErrors,
+                     InitExtension initFunc)
+{
+    ExtensionEntry *ext;
+
+    ext = AddExtension(name, NumEvents, NumErrors,
+                       DeferredExtensionProc, DeferredExtensionProc,
+                       NULL, StandardMinorOpcode);
+    if (ext)
+        ext->deferredInit = initFunc;
+    return ext;
+}
+
 /*
  * CheckExtension returns the extensions[] entry for the requested
  * extension name.  Maybe this could just return a Bool instead?
@@ -165,7 +250,7 @@ CheckExtension(const char *extname)
     int n;
 
     n = FindExtension(extname, strlen(extname));
-    if (n != -1)
+    if (n != -1 && InitDeferredExtension(extensions[n]))
         return extensions[n];
     else
         return NULL;
@@ -240,7 +325,8 @@ ProcQueryExtension(ClientPtr client)
         reply.present = xFalse;
     else {
         i = FindExtension((char *) &stuff[1], stuff->nbytes);
-        if (i < 0 || !ExtensionAvailable(client, extensions[i]))
+        if (i < 0 || !InitDeferredExtension(extensions[i]) ||
+            !ExtensionAvailable(client, extensions[i]))
             reply.present = xFalse;
         else {
             reply.present = xTrue;
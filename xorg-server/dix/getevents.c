@@ -372,12 +372,13 @@ updateSlaveDeviceCoords(DeviceIntPtr master, DeviceIntPtr pDev)
 /**
  * Allocate the motion history buffer.
  */
-void
-AllocateMotionHistory(DeviceIntPtr pDev)
+static void
+allocMotionBuffer(DeviceIntPtr pDev)
 {
     int size;
 
     free(pDev->valuator->motion);
+    pDev->valuator->motion = NULL;
 
     if (pDev->valuator->numMotionEvents < 1)
         return;
@@ -409,6 +410,18 @@ AllocateMotionHistory(DeviceIntPtr pDev)
                pDev->name, size * pDev->valuator->numMotionEvents);
 }
 
+/**
+ * (Re)start the motion history.  Few clients ever ask for it, so the
+ * buffer is only allocated by the first GetMotionHistory() call, and no
+ * history is kept before then.
+ */
+void
+AllocateMotionHistory(DeviceIntPtr pDev)
+{
+    if (pDev->valuator->motion)
+        allocMotionBuffer(pDev);
+}
+
 /**
  * Dump the motion history between start and stop into the supplied buffer.
  * Only records the event for a given screen in theory, but in practice, we
@@ -438,6 +451,12 @@ GetMotionHistory(DeviceIntPtr pDev, xTimecoord ** buff, unsigned long start,
     if (core && !pScreen)
         return 0;
 
+    /* Start recording; there is nothing to report yet */
+    if (!pDev->valuator->motion) {
+        allocMotionBuffer(pDev);
+        return 0;
+    }
+
     if (IsMaster(pDev))
         size = (sizeof(INT32) * 3 * MAX_VALUATORS) + sizeof(Time);
     else
@@ -558,7 +577,8 @@ updateMotionHistory(DeviceIntPtr pDev, CARD32 ms, ValuatorMask *mask,
     ValuatorClassPtr v;
     int i;
 
-    if (!pDev->valuator->numMotionEvents)
+    /* Nobody has asked for history yet */
+    if (!pDev->valuator->motion)
         return;
 
     v = pDev->valuator;
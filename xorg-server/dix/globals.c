@@ -108,6 +108,8 @@ FontPtr defaultFont;            /* not declared in dix.h to avoid including font
 CursorPtr rootCursor;
 Bool party_like_its_1989 = FALSE;
 Bool whiteRoot = FALSE;
+Bool dispatchProfile = FALSE;
+CARD32 damageReportInterval = 0;
 
 TimeStamp currentTime;
 
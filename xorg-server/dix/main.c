@@ -324,6 +324,8 @@ dix_main(int argc, char *argv[], char *envp[])
 
         Dispatch();
 
+        DispatchProfileReport();
+
         UndisplayDevices();
         DisableAllDevices();
 
@@ -404,6 +406,7 @@ dix_main(int argc, char *argv[], char *envp[])
 
         free(ConnectionInfo);
         ConnectionInfo = NULL;
+        InvalidateConnSetupCache();
     }
     return 0;
 }
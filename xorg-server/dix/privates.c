@@ -135,6 +135,106 @@ static const Bool screen_specific_private[PRIVATE_LAST] = {
     /*[PRIVATE_SYNC_FENCE] =*/ FALSE
 };
 
+/*
+ * Freed objects of the types that are created and destroyed all the time
+ * (GCs, pictures, properties, windows...) are kept on a short per-type
+ * free list and handed out again instead of going back to malloc.  The
+ * free path is not told the object's size, so a type is only cached
+ * while all of its live objects have the same size; that holds unless
+ * screens have different private sizes, and then the type just falls
+ * back to malloc and free.  Types that can be allocated before all their
+ * keys are registered (PRIVATE_CLIENT and below) are never cached, nor
+ * are glyphs, which render allocates itself with their bits attached.
+ */
+#define OBJECT_CACHE_DEPTH 64
+
+typedef struct _ObjectCache {
+    void *free;                 /* freed objects, linked through word 0 */
+    unsigned size;              /* size of every live object of the type */
+    int count;
+    Bool mixed;                 /* more than one size seen, don't cache */
+    unsigned long hits;
+    unsigned long misses;
+} ObjectCacheRec;
+
+static ObjectCacheRec object_cache[PRIVATE_LAST];
+
+static inline Bool
+dixObjectCacheable(DevPrivateType type)
+{
+    return type > PRIVATE_CLIENT && type != PRIVATE_GLYPH;
+}
+
+static unsigned long
+dixFlushObjectCache(DevPrivateType type)
+{
+    ObjectCacheRec *cache = &object_cache[type];
+    unsigned long bytes = (unsigned long) cache->count * cache->size;
+    void *object;
+
+    while ((object = cache->free)) {
+        cache->free = *(void **) object;
+        free(object);
+    }
+    cache->count = 0;
+    return bytes;
+}
+
+/* Memory is low: give every cached object back to malloc */
+static unsigned long
+dixTrimObjectCaches(void *closure)
+{
+    unsigned long bytes = 0;
+    DevPrivateType t;
+
+    for (t = PRIVATE_CLIENT + 1; t < PRIVATE_LAST; t++)
+        bytes += dixFlushObjectCache(t);
+    return bytes;
+}
+
+static void *
+dixCacheAllocObject(DevPrivateType type, unsigned size)
+{
+    ObjectCacheRec *cache = &object_cache[type];
+    void *object;
+
+    if (!dixObjectCacheable(type) || cache->mixed)
+        return malloc(size);
+
+    if (size != cache->size) {
+        dixFlushObjectCache(type);
+        if (global_keys[type].created && cache->size)
+            cache->mixed = TRUE;
+        cache->size = size;
+        cache->misses++;
+        return malloc(size);
+    }
+
+    if ((object = cache->free)) {
+        cache->free = *(void **) object;
+        cache->count--;
+        cache->hits++;
+        return object;
+    }
+    cache->misses++;
+    return malloc(size);
+}
+
+static void
+dixCacheFreeObject(DevPrivateType type, void *object)
+{
+    ObjectCacheRec *cache = &object_cache[type];
+
+    if (!dixObjectCacheable(type) || cache->mixed ||
+        cache->count >= OBJECT_CACHE_DEPTH) {
+        free(object);
+        return;
+    }
+    *(void **) object = cache->free;
+    cache->free = object;
+    cache->count++;
+}
+
 typedef Bool (*FixupFunc) (PrivatePtr *privates, int offset, unsigned bytes);
 
 typedef enum { FixupMove, FixupRealloc } FixupType;
@@ -502,7 +602,7 @@ _dixAllocateObjectWithPrivates(unsigned baseSize, unsigned clear,
     /* round up so that void * is aligned */
     baseSize = (baseSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
     totalSize = baseSize + global_keys[type].offset;
-    object = malloc(totalSize);
+    object = dixCacheAllocObject(type, totalSize);
     if (!object)
         return NULL;
 
@@ -555,7 +655,7 @@ _dixFreeObjectWithPrivates(void *object, PrivatePtr privates,
                            DevPrivateType type)
 {
     _dixFiniPrivates(privates, type);
-    free(object);
+    dixCacheFreeObject(type, object);
 }
 
 /*
@@ -730,7 +830,7 @@ _dixAllocateScreenObjectWithPrivates(ScreenPtr pScreen,
     /* round up so that pointer is aligned */
     baseSize = (baseSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
     totalSize = baseSize + privates_size;
-    object = malloc(totalSize);
+    object = dixCacheAllocObject(type, totalSize);
     if (!object)
         return NULL;
 
@@ -775,6 +875,16 @@ dixPrivateUsage(void)
         }
     }
     ErrorF("TOTAL: %d objects, %d bytes, %d allocs\n", objects, bytes, alloc);
+
+    for (t = PRIVATE_CLIENT + 1; t < PRIVATE_LAST; t++) {
+        ObjectCacheRec *cache = &object_cache[t];
+
+        if (cache->hits || cache->misses)
+            ErrorF("%s cache: %lu hits, %lu misses (%lu%%), %d cached%s\n",
+                   key_names[t], cache->hits, cache->misses,
+                   cache->hits * 100 / (cache->hits + cache->misses),
+                   cache->count, cache->mixed ? ", disabled" : "");
+    }
 }
 
 void
@@ -803,7 +913,11 @@ dixResetPrivates(void)
         global_keys[t].offset = 0;
         global_keys[t].created = 0;
         global_keys[t].allocated = 0;
+
+        dixFlushObjectCache(t);
+        memset(&object_cache[t], 0, sizeof(object_cache[t]));
     }
+    RegisterCacheTrim("object free lists", 10, dixTrimObjectCaches, NULL);
 }
 
 Bool
@@ -86,6 +86,156 @@ PrintPropertys(WindowPtr pWin)
 }
 #endif
 
+/*
+ * Windows with many properties (the root window usually has hundreds)
+ * also keep them in a hash index by name.  The list stays the master
+ * copy and keeps its order for ListProperties; each hash chain holds its
+ * properties in list order too, so the first match is the same one a
+ * list walk would find.
+ */
+
+#define PROPERTY_INDEX_THRESHOLD 32
+#define PROPERTY_INDEX_BUCKETS 64
+
+typedef struct _PropertyIndex {
+    int count;                  /* properties on the window */
+    int mask;                   /* number of buckets - 1 */
+    PropertyPtr *buckets;
+} PropertyIndexRec, *PropertyIndexPtr;
+
+static inline int
+PropertyBucket(PropertyIndexPtr pIndex, Atom name)
+{
+    return (name ^ (name >> 8)) & pIndex->mask;
+}
+
+static void
+FreePropertyIndex(WindowPtr pWin)
+{
+    PropertyIndexPtr pIndex = pWin->optional->propIndex;
+
+    if (pIndex) {
+        free(pIndex->buckets);
+        free(pIndex);
+        pWin->optional->propIndex = NULL;
+    }
+}
+
+static void
+BuildPropertyIndex(WindowPtr pWin, int count, int nbuckets)
+{
+    PropertyIndexPtr pIndex;
+    PropertyPtr pProp, **tails;
+    int i;
+
+    pIndex = malloc(sizeof(PropertyIndexRec));
+    tails = xallocarray(nbuckets, sizeof(PropertyPtr *));
+    if (pIndex)
+        pIndex->buckets = xallocarray(nbuckets, sizeof(PropertyPtr));
+    if (!pIndex || !pIndex->buckets || !tails) {
+        /* The list still works, just more slowly */
+        if (pIndex)
+            free(pIndex->buckets);
+        free(pIndex);
+        free(tails);
+        return;
+    }
+    pIndex->count = count;
+    pIndex->mask = nbuckets - 1;
+    for (i = 0; i < nbuckets; i++) {
+        pIndex->buckets[i] = NULL;
+        tails[i] = &pIndex->buckets[i];
+    }
+    for (pProp = pWin->optional->userProps; pProp; pProp = pProp->next) {
+        i = PropertyBucket(pIndex, pProp->propertyName);
+        pProp->hashNext = NULL;
+        *tails[i] = pProp;
+        tails[i] = &pProp->hashNext;
+    }
+    free(tails);
+
+    FreePropertyIndex(pWin);
+    pWin->optional->propIndex = pIndex;
+}
+
+static PropertyPtr
+FindProperty(WindowPtr pWin, Atom propertyName)
+{
+    PropertyPtr pProp;
+
+    if (pWin->optional && pWin->optional->propIndex) {
+        PropertyIndexPtr pIndex = pWin->optional->propIndex;
+
+        pProp = pIndex->buckets[PropertyBucket(pIndex, propertyName)];
+        for (; pProp; pProp = pProp->hashNext)
+            if (pProp->propertyName == propertyName)
+                break;
+        return pProp;
+    }
+
+    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
+        if (pProp->propertyName == propertyName)
+            break;
+    return pProp;
+}
+
+/* Add a new property to the head of the window's list */
+static void
+LinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr pIndex = pWin->optional->propIndex;
+    PropertyPtr *head;
+    int count;
+
+    pProp->next = pWin->optional->userProps;
+    pWin->optional->userProps = pProp;
+
+    if (pIndex) {
+        head = &pIndex->buckets[PropertyBucket(pIndex, pProp->propertyName)];
+        pProp->hashNext = *head;
+        *head = pProp;
+        if (++pIndex->count > 4 * (pIndex->mask + 1))
+            BuildPropertyIndex(pWin, pIndex->count, 2 * (pIndex->mask + 1));
+        return;
+    }
+
+    pProp->hashNext = NULL;
+    for (count = 0; pProp; pProp = pProp->next)
+        count++;
+    if (count > PROPERTY_INDEX_THRESHOLD)
+        BuildPropertyIndex(pWin, count, PROPERTY_INDEX_BUCKETS);
+}
+
+/* Take a property off the window's list; the caller frees it */
+static void
+UnlinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr pIndex = pWin->optional->propIndex;
+    PropertyPtr prevProp, *prev;
+
+    if (pIndex) {
+        prev = &pIndex->buckets[PropertyBucket(pIndex, pProp->propertyName)];
+        while (*prev != pProp)
+            prev = &(*prev)->hashNext;
+        *prev = pProp->hashNext;
+        if (--pIndex->count < PROPERTY_INDEX_THRESHOLD / 2)
+            FreePropertyIndex(pWin);
+    }
+
+    if (pWin->optional->userProps == pProp) {
+        /* Takes care of head */
+        if (!(pWin->optional->userProps = pProp->next))
+            CheckWindowOptionalNeed(pWin);
+    }
+    else {
+        /* Need to traverse to find the previous element */
+        prevProp = pWin->optional->userProps;
+        while (prevProp->next != pProp)
+            prevProp = prevProp->next;
+        prevProp->next = pProp->next;
+    }
+}
+
 int
 dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
                   ClientPtr client, Mask access_mode)
@@ -95,10 +245,7 @@ dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
 
     client->errorValue = propertyName;
 
-    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
-        if (pProp->propertyName == propertyName)
-            break;
-
+    pProp = FindProperty(pWin, propertyName);
     if (pProp)
         rc = XaceHookPropertyAccess(client, pWin, &pProp, access_mode);
     *result = pProp;
@@ -294,8 +441,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             pClient->errorValue = property;
             return rc;
         }
-        pProp->next = pWin->optional->userProps;
-        pWin->optional->userProps = pProp;
+        LinkProperty(pWin, pProp);
     }
     else if (rc == Success) {
         /* To append or prepend to a property the request format and type
@@ -369,7 +515,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
 int
 DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     int rc;
 
     rc = dixLookupProperty(&pProp, pWin, propName, client, DixDestroyAccess);
@@ -377,18 +523,7 @@ DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
         return Success;         /* Succeed if property does not exist */
 
     if (rc == Success) {
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
+        UnlinkProperty(pWin, pProp);
 
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
         free(pProp->data);
@@ -411,8 +546,10 @@ DeleteAllWindowProperties(WindowPtr pWin)
         pProp = pNextProp;
     }
 
-    if (pWin->optional)
+    if (pWin->optional) {
+        FreePropertyIndex(pWin);
         pWin->optional->userProps = NULL;
+    }
 }
 
 static int
@@ -443,7 +580,7 @@ NullPropertyReply(ClientPtr client, ATOM propertyType, int format)
 int
 ProcGetProperty(ClientPtr client)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     unsigned long n, len, ind;
     int rc;
     WindowPtr pWin;
@@ -544,18 +681,7 @@ ProcGetProperty(ClientPtr client)
 
     if (stuff->delete && (reply.bytesAfter == 0)) {
         /* Delete the Property */
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
+        UnlinkProperty(pWin, pProp);
 
         free(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
@@ -1312,22 +1312,36 @@ RegionValidate(RegionPtr badreg, Bool *pOverlap)
     return RegionBreak(badreg);
 }
 
-RegionPtr
-RegionFromRects(int nrects, xRectangle *prect, int ctype)
+/*
+ * Replace the contents of pRgn with the rectangles in prect.  The box
+ * storage the region already has is reused when it is big enough, so
+ * resetting a long-lived region from a request needs no allocation.
+ */
+Bool
+RegionSetRects(RegionPtr pRgn, int nrects, xRectangle *prect, int ctype)
 {
-
-    RegionPtr pRgn;
-    size_t rgnSize;
-    RegDataPtr pData;
+    RegDataPtr pData = NULL;
     BoxPtr pBox;
     int i;
     int x1, y1, x2, y2;
 
-    pRgn = RegionCreate(NullBox, 0);
-    if (RegionNar(pRgn))
-        return pRgn;
-    if (!nrects)
-        return pRgn;
+    if (nrects > 1 && pRgn->data && pRgn->data->size >= nrects) {
+        pData = pRgn->data;
+    }
+    else {
+        if (nrects > 1) {
+            size_t rgnSize = RegionSizeof(nrects);
+
+            pData = (rgnSize > 0) ? malloc(rgnSize) : NULL;
+            if (!pData)
+                return RegionBreak(pRgn);
+            pData->size = nrects;
+        }
+        xfreeData(pRgn);
+    }
+    pRgn->extents = RegionEmptyBox;
+    pRgn->data = &RegionEmptyData;
+
     if (nrects == 1) {
         x1 = prect->x;
         y1 = prect->y;
@@ -1342,14 +1356,11 @@ RegionFromRects(int nrects, xRectangle *prect, int ctype)
             pRgn->extents.y2 = y2;
             pRgn->data = NULL;
         }
-        return pRgn;
-    }
-    rgnSize = RegionSizeof(nrects);
-    pData = (rgnSize > 0) ? malloc(rgnSize) : NULL;
-    if (!pData) {
-        RegionBreak(pRgn);
-        return pRgn;
+        return TRUE;
     }
+    if (!pData)
+        return TRUE;
+
     pBox = (BoxPtr) (pData + 1);
     for (i = nrects; --i >= 0; prect++) {
         x1 = prect->x;
@@ -1366,22 +1377,31 @@ RegionFromRects(int nrects, xRectangle *prect, int ctype)
             pBox++;
         }
     }
-    if (pBox != (BoxPtr) (pData + 1)) {
-        pData->size = nrects;
-        pData->numRects = pBox - (BoxPtr) (pData + 1);
-        pRgn->data = pData;
-        if (ctype != CT_YXBANDED) {
-            Bool overlap;       /* result ignored */
-
-            pRgn->extents.x1 = pRgn->extents.x2 = 0;
-            RegionValidate(pRgn, &overlap);
-        }
-        else
-            RegionSetExtents(pRgn);
-        good(pRgn);
-    }
-    else {
+    if (pBox == (BoxPtr) (pData + 1)) {
         free(pData);
+        return TRUE;
     }
+    pData->numRects = pBox - (BoxPtr) (pData + 1);
+    pRgn->data = pData;
+    if (ctype != CT_YXBANDED) {
+        Bool overlap;           /* result ignored */
+
+        pRgn->extents.x1 = pRgn->extents.x2 = 0;
+        return RegionValidate(pRgn, &overlap);
+    }
+    RegionSetExtents(pRgn);
+    good(pRgn);
+    return TRUE;
+}
+
+RegionPtr
+RegionFromRects(int nrects, xRectangle *prect, int ctype)
+{
+    RegionPtr pRgn;
+
+    pRgn = RegionCreate(NullBox, 0);
+    if (RegionNar(pRgn))
+        return pRgn;
+    RegionSetRects(pRgn, nrects, prect, ctype);
     return pRgn;
 }
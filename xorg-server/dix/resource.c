@@ -149,14 +149,14 @@ Equipment Corporation.
 #define TypeNameString(t) LookupResourceName(t)
 #endif
 
-static void RebuildTable(int    /*client */
+static void SplitResourceBucket(int    /*client */
     );
 
 #define SERVER_MINID 32
 
 #define INITBUCKETS 64
 #define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+#define MAXHASHSIZE 20
 
 typedef struct _Resource {
     struct _Resource *next;
@@ -165,11 +165,18 @@ typedef struct _Resource {
     void *value;
 } ResourceRec, *ResourcePtr;
 
+/*
+ * The table grows by linear hashing: once it is full one bucket is split
+ * per AddResource, so there is never a pass over every resource.  Buckets
+ * below 'split' have already been split into their twin at
+ * split + (1 << hashsize) and are addressed with one more hash bit.
+ */
 typedef struct _ClientResource {
     ResourcePtr *resources;
     int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
+    int buckets;                /* buckets in use */
+    int hashsize;               /* log(2)(buckets) at the start of a round */
+    int split;                  /* next bucket to split */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
@@ -659,6 +666,7 @@ InitClientResources(ClientPtr client)
     clientTable[i].buckets = INITBUCKETS;
     clientTable[i].elements = 0;
     clientTable[i].hashsize = INITHASHSIZE;
+    clientTable[i].split = 0;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
@@ -686,6 +694,24 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0) << numBits);
 }
 
+static inline XID
+ResourceHashKey(XID id)
+{
+    id &= RESOURCE_ID_MASK;
+    return id ^ (id >> 10);
+}
+
+static inline int
+ResourceBucket(ClientResourceRec *rrec, XID id)
+{
+    XID key = ResourceHashKey(id);
+    int bucket = key & ((1U << rrec->hashsize) - 1);
+
+    if (bucket < rrec->split)
+        bucket = key & ((2U << rrec->hashsize) - 1);
+    return bucket;
+}
+
 static XID
 AvailableID(int client, XID id, XID maxid, XID goodid)
 {
@@ -694,7 +720,7 @@ AvailableID(int client, XID id, XID maxid, XID goodid)
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
+        res = clientTable[client].resources[ResourceBucket(&clientTable[client], id)];
         while (res && (res->id != id))
             res = res->next;
         if (!res)
@@ -819,8 +845,8 @@ AddResource(XID id, RESTYPE type, void *value)
         FatalError("client not in use\n");
     }
     if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
-        RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
+        SplitResourceBucket(client);
+    head = &rrec->resources[ResourceBucket(rrec, id)];
     res = malloc(sizeof(ResourceRec));
     if (!res) {
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
@@ -837,46 +863,46 @@ AddResource(XID id, RESTYPE type, void *value)
 }
 
 static void
-RebuildTable(int client)
+SplitResourceBucket(int client)
 {
-    int j;
-    ResourcePtr res, next;
-    ResourcePtr **tails, *resources;
-    ResourcePtr **tptr, *rptr;
+    ClientResourceRec *rrec = &clientTable[client];
+    XID bit = 1U << rrec->hashsize;
+    ResourcePtr res, next, *lo, *hi;
+
+    if (rrec->split == 0) {
+        ResourcePtr *resources;
+
+        resources = xreallocarray(rrec->resources, 2 * bit, sizeof(ResourcePtr));
+        if (!resources)
+            return;
+        rrec->resources = resources;
+    }
 
     /*
      * For now, preserve insertion order, since some ddx layers depend
      * on resources being free in the opposite order they are added.
      */
-
-    j = 2 * clientTable[client].buckets;
-    tails =  xallocarray(j, sizeof(ResourcePtr *));
-    if (!tails)
-        return;
-    resources =  xallocarray(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
-        return;
-    }
-    for (rptr = resources, tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
-    }
-    clientTable[client].hashsize++;
-    for (j = clientTable[client].buckets,
-         rptr = clientTable[client].resources; --j >= 0; rptr++) {
-        for (res = *rptr; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
+    lo = &rrec->resources[rrec->split];
+    hi = &rrec->resources[rrec->split + bit];
+    for (res = *lo; res; res = next) {
+        next = res->next;
+        if (ResourceHashKey(res->id) & bit) {
+            *hi = res;
+            hi = &res->next;
         }
+        else {
+            *lo = res;
+            lo = &res->next;
+        }
+    }
+    *lo = NULL;
+    *hi = NULL;
+
+    rrec->buckets++;
+    if (++rrec->split == bit) {
+        rrec->split = 0;
+        rrec->hashsize++;
     }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
 }
 
 static void
@@ -900,7 +926,7 @@ FreeResource(XID id, RESTYPE skipDeleteFuncType)
     int elements;
 
     if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+        head = &clientTable[cid].resources[ResourceBucket(&clientTable[cid], id)];
         eltptr = &clientTable[cid].elements;
 
         prev = head;
@@ -934,7 +960,7 @@ FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
     ResourcePtr *prev, *head;
 
     if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+        head = &clientTable[cid].resources[ResourceBucket(&clientTable[cid], id)];
 
         prev = head;
         while ((res = *prev)) {
@@ -969,7 +995,7 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
     ResourcePtr res;
 
     if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+        res = clientTable[cid].resources[ResourceBucket(&clientTable[cid], id)];
 
         for (; res; res = res->next)
             if ((res->id == id) && (res->type == rtype)) {
@@ -990,7 +1016,7 @@ void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
     ResourcePtr this, next;
     int i, elements;
     int *eltptr;
@@ -998,16 +1024,16 @@ FindClientResourcesByType(ClientPtr client,
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
+    rrec = &clientTable[client->index];
+    eltptr = &rrec->elements;
+    for (i = 0; i < rrec->buckets; i++) {
+        for (this = rrec->resources[i]; this; this = next) {
             next = this->next;
             if (!type || this->type == type) {
                 elements = *eltptr;
                 (*func) (this->value, this->id, cdata);
                 if (*eltptr != elements)
-                    next = resources[i];        /* start over */
+                    next = rrec->resources[i];   /* start over */
             }
         }
     }
@@ -1025,7 +1051,7 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
     ResourcePtr this, next;
     int i, elements;
     int *eltptr;
@@ -1033,15 +1059,15 @@ FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
+    rrec = &clientTable[client->index];
+    eltptr = &rrec->elements;
+    for (i = 0; i < rrec->buckets; i++) {
+        for (this = rrec->resources[i]; this; this = next) {
             next = this->next;
             elements = *eltptr;
             (*func) (this->value, this->id, this->type, cdata);
             if (*eltptr != elements)
-                next = resources[i];    /* start over */
+                next = rrec->resources[i];    /* start over */
         }
     }
 }
@@ -1051,7 +1077,7 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
     ResourcePtr this, next;
     void *value;
     int i;
@@ -1059,9 +1085,9 @@ LookupClientResourceComplex(ClientPtr client,
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
+    rrec = &clientTable[client->index];
+    for (i = 0; i < rrec->buckets; i++) {
+        for (this = rrec->resources[i]; this; this = next) {
             next = this->next;
             if (!type || this->type == type) {
                 /* workaround func freeing the type as DRI1 does */
@@ -1207,7 +1233,7 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
         return BadImplementation;
 
     if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+        res = clientTable[cid].resources[ResourceBucket(&clientTable[cid], id)];
 
         for (; res; res = res->next)
             if (res->id == id && res->type == rtype)
@@ -1242,7 +1268,7 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
     *result = NULL;
 
     if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+        res = clientTable[cid].resources[ResourceBucket(&clientTable[cid], id)];
 
         for (; res; res = res->next)
             if (res->id == id && (res->type & rclass))
@@ -63,6 +63,9 @@ static void SwapCharInfo(xCharInfo * pInfo);
 
 static void SwapFont(xQueryFontReply * pr, Bool hasGlyphs);
 
+/* Bytes swapped into the output buffer at a time */
+#define SWAP_WRITE_CHUNK 65536
+
 /**
  * Thanks to Jack Palevich for testing and subsequently rewriting all this
  *
@@ -71,63 +74,30 @@ static void SwapFont(xQueryFontReply * pr, Bool hasGlyphs);
 void _X_COLD
 Swap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
 {
-    int i;
-
-    size >>= 2;
-    for (i = 0; i < size; i++)
-        /* brackets are mandatory here, because "swapl" macro expands
-           to several statements */
-    {
-        swapl(&pbuf[i]);
-    }
-    WriteToClient(pClient, size << 2, pbuf);
+    SwapLongs(pbuf, size >> 2);
+    WriteToClient(pClient, size & ~3, pbuf);
 }
 
 /**
+ * Swaps straight into the client's output buffer, a chunk at a time.
  *
  * \param size size in bytes
  */
 void _X_COLD
 CopySwap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
 {
-    int bufsize = size;
-    CARD32 *pbufT;
-    CARD32 *from, *to, *fromLast, *toLast;
-    CARD32 tmpbuf[1];
-
-    /* Allocate as big a buffer as we can... */
-    while (!(pbufT = malloc(bufsize))) {
-        bufsize >>= 1;
-        if (bufsize == 4) {
-            pbufT = tmpbuf;
-            break;
-        }
-    }
-
-    /* convert lengths from # of bytes to # of longs */
-    size >>= 2;
-    bufsize >>= 2;
-
-    from = pbuf;
-    fromLast = from + size;
-    while (from < fromLast) {
-        int nbytes;
-
-        to = pbufT;
-        toLast = to + min(bufsize, fromLast - from);
-        nbytes = (toLast - to) << 2;
-        while (to < toLast) {
-            /* can't write "cpswapl(*from++, *to++)" because cpswapl is a macro
-               that evaluates its args more than once */
-            cpswapl(*from, *to);
-            from++;
-            to++;
-        }
-        WriteToClient(pClient, nbytes, pbufT);
+    size &= ~3;
+    while (size > 0) {
+        int nbytes = min(size, SWAP_WRITE_CHUNK);
+        CARD32 *to = ReserveClientOutput(pClient, nbytes);
+
+        if (!to)
+            return;
+        CopySwapLongs(pbuf, to, nbytes >> 2);
+        WriteToClient(pClient, nbytes, to);
+        pbuf += nbytes >> 2;
+        size -= nbytes;
     }
-
-    if (pbufT != tmpbuf)
-        free(pbufT);
 }
 
 /**
@@ -137,44 +107,18 @@ CopySwap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
 void _X_COLD
 CopySwap16Write(ClientPtr pClient, int size, short *pbuf)
 {
-    int bufsize = size;
-    short *pbufT;
-    short *from, *to, *fromLast, *toLast;
-    short tmpbuf[2];
-
-    /* Allocate as big a buffer as we can... */
-    while (!(pbufT = malloc(bufsize))) {
-        bufsize >>= 1;
-        if (bufsize == 4) {
-            pbufT = tmpbuf;
-            break;
-        }
-    }
-
-    /* convert lengths from # of bytes to # of shorts */
-    size >>= 1;
-    bufsize >>= 1;
-
-    from = pbuf;
-    fromLast = from + size;
-    while (from < fromLast) {
-        int nbytes;
-
-        to = pbufT;
-        toLast = to + min(bufsize, fromLast - from);
-        nbytes = (toLast - to) << 1;
-        while (to < toLast) {
-            /* can't write "cpswaps(*from++, *to++)" because cpswaps is a macro
-               that evaluates its args more than once */
-            cpswaps(*from, *to);
-            from++;
-            to++;
-        }
-        WriteToClient(pClient, nbytes, pbufT);
+    size &= ~1;
+    while (size > 0) {
+        int nbytes = min(size, SWAP_WRITE_CHUNK);
+        short *to = ReserveClientOutput(pClient, nbytes);
+
+        if (!to)
+            return;
+        CopySwapShorts(pbuf, to, nbytes >> 1);
+        WriteToClient(pClient, nbytes, to);
+        pbuf += nbytes >> 1;
+        size -= nbytes;
     }
-
-    if (pbufT != tmpbuf)
-        free(pbufT);
 }
 
 /* Extra-small reply */
@@ -58,62 +58,94 @@ SOFTWARE.
 
 /* Thanks to Jack Palevich for testing and subsequently rewriting all this */
 
-/* Byte swap a list of longs */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SWAP_SSE2
+#endif
+
+#ifdef SWAP_SSE2
+
+/* SSE2 has no byte shuffle: swap the bytes of each short with shifts,
+ * then the shorts of each long with word shuffles */
+static inline __m128i
+swap16_sse2(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i
+swap32_sse2(__m128i v)
+{
+    v = swap16_sse2(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+#endif
+
+/* Byte swap count longs from one list to another, which may be the same */
 void
-SwapLongs(CARD32 *list, unsigned long count)
+CopySwapLongs(const CARD32 *from, CARD32 *to, unsigned long count)
 {
+#ifdef SWAP_SSE2
     while (count >= 8) {
-        swapl(list + 0);
-        swapl(list + 1);
-        swapl(list + 2);
-        swapl(list + 3);
-        swapl(list + 4);
-        swapl(list + 5);
-        swapl(list + 6);
-        swapl(list + 7);
-        list += 8;
+        __m128i a = _mm_loadu_si128((const __m128i *) from);
+        __m128i b = _mm_loadu_si128((const __m128i *) (from + 4));
+
+        _mm_storeu_si128((__m128i *) to, swap32_sse2(a));
+        _mm_storeu_si128((__m128i *) (to + 4), swap32_sse2(b));
+        from += 8;
+        to += 8;
         count -= 8;
     }
-    if (count != 0) {
-        do {
-            swapl(list);
-            list++;
-        } while (--count != 0);
+#endif
+    while (count != 0) {
+        cpswapl(*from, *to);
+        from++;
+        to++;
+        count--;
     }
 }
 
-/* Byte swap a list of shorts */
+/* Byte swap count shorts from one list to another, which may be the same */
 void
-SwapShorts(short *list, unsigned long count)
+CopySwapShorts(const short *from, short *to, unsigned long count)
 {
+#ifdef SWAP_SSE2
     while (count >= 16) {
-        swaps(list + 0);
-        swaps(list + 1);
-        swaps(list + 2);
-        swaps(list + 3);
-        swaps(list + 4);
-        swaps(list + 5);
-        swaps(list + 6);
-        swaps(list + 7);
-        swaps(list + 8);
-        swaps(list + 9);
-        swaps(list + 10);
-        swaps(list + 11);
-        swaps(list + 12);
-        swaps(list + 13);
-        swaps(list + 14);
-        swaps(list + 15);
-        list += 16;
+        __m128i a = _mm_loadu_si128((const __m128i *) from);
+        __m128i b = _mm_loadu_si128((const __m128i *) (from + 8));
+
+        _mm_storeu_si128((__m128i *) to, swap16_sse2(a));
+        _mm_storeu_si128((__m128i *) (to + 8), swap16_sse2(b));
+        from += 16;
+        to += 16;
         count -= 16;
     }
-    if (count != 0) {
-        do {
-            swaps(list);
-            list++;
-        } while (--count != 0);
+#endif
+    while (count != 0) {
+        cpswaps(*from, *to);
+        from++;
+        to++;
+        count--;
     }
 }
 
+/* Byte swap a list of longs */
+void
+SwapLongs(CARD32 *list, unsigned long count)
+{
+    CopySwapLongs(list, list, count);
+}
+
+/* Byte swap a list of shorts */
+void
+SwapShorts(short *list, unsigned long count)
+{
+    CopySwapShorts(list, list, count);
+}
+
 /* The following is used for all requests that have
    no fields to be swapped (except "length") */
 int _X_COLD
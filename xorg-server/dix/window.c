@@ -160,6 +160,10 @@ WindowSeekDeviceCursor(WindowPtr pWin,
 
 int screenIsSaved = SCREEN_SAVER_OFF;
 
+/* Changes whenever viewable windows may have been moved, resized, restacked,
+ * mapped or unmapped, and whenever a window is destroyed */
+unsigned long WindowTreeSerial;
+
 static Bool TileScreenSaver(ScreenPtr pScreen, int kind);
 
 #define INPUTONLY_LEGAL_MASK (CWWinGravity | CWEventMask | \
@@ -497,6 +501,8 @@ SetWindowToDefaults(WindowPtr pWin)
 
     pWin->eventMask = 0;
     pWin->deliverableEvents = 0;
+    pWin->xiDeliverable = 0;
+    pWin->xi2Deliverable = 0;
     pWin->dontPropagate = 0;
     pWin->redirectDraw = RedirectDrawNone;
     pWin->forcedBG = FALSE;
@@ -596,6 +602,7 @@ CreateRootWindow(ScreenPtr pScreen)
     pWin->optional->otherClients = NULL;
     pWin->optional->passiveGrabs = NULL;
     pWin->optional->userProps = NULL;
+    pWin->optional->propIndex = NULL;
     pWin->optional->backingBitPlanes = ~0L;
     pWin->optional->backingPixel = 0;
     pWin->optional->boundingShape = NULL;
@@ -1100,6 +1107,7 @@ DeleteWindow(void *value, XID wid)
     }
     else
         pWin->drawable.pScreen->root = NULL;
+    WindowTreeSerial++;
     dixFreeObjectWithPrivates(pWin, PRIVATE_WINDOW);
     return Success;
 }
@@ -3406,6 +3414,7 @@ MakeWindowOptional(WindowPtr pWin)
     optional->otherClients = NULL;
     optional->passiveGrabs = NULL;
     optional->userProps = NULL;
+    optional->propIndex = NULL;
     optional->backingBitPlanes = ~0L;
     optional->backingPixel = 0;
     optional->boundingShape = NULL;
@@ -68,12 +68,17 @@ fbBlt(FbBits * srcLine,
         FbStride        dst_byte_stride = dstStride << (FB_SHIFT - 3);
         int             width_byte = (width >> 3);
 
-        /* Make sure there's no overlap; we can't use memcpy in that
-         * case as it's not well defined, so fall through to the
-         * general code
+        /* Without accessors MEMCPY_WRAPPED is memmove, which copes with
+         * a row overlapping itself (horizontal scrolls) and is the
+         * fastest copy the C library has for this CPU; rows overlapping
+         * each other are taken care of by the row order.  The wrapped
+         * byte loop only copies forwards, so make sure there's no
+         * overlap in that case and fall through to the general code.
          */
+#ifdef FB_ACCESS_WRAPPER
         if (src_byte + width_byte <= dst_byte ||
             dst_byte + width_byte <= src_byte)
+#endif
         {
             int i;
 
@@ -26,6 +26,112 @@
 
 #include "fb.h"
 
+/*
+ * First box in the band that contains y or, if none does, in the band
+ * below it.  Clip boxes are y-x banded, so their y2 never decreases.
+ */
+static BoxPtr
+fbClipBand(BoxPtr pbox, int nbox, int y)
+{
+    int lo = 0, hi = nbox;
+
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+
+        if (pbox[mid].y2 <= y)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return pbox + lo;
+}
+
+/* Below this many pixels a plain store loop beats a call into pixman */
+#define FB_SPAN_STORE_MAX   64
+
+static void
+fbSolidSpan(FbBits *dst, FbStride dstStride, int dstBpp,
+            int x, int y, int width, FbBits and, FbBits xor)
+{
+    if (dstBpp == 32 && !and && width <= FB_SPAN_STORE_MAX) {
+        FbBits *d = dst + y * dstStride + x;
+
+        while (width--)
+            WRITE(d++, xor);
+        return;
+    }
+#ifndef FB_ACCESS_WRAPPER
+    if (!and && pixman_fill((uint32_t *) dst, dstStride, dstBpp,
+                            x, y, width, 1, xor))
+        return;
+#endif
+    fbSolid(dst + y * dstStride, dstStride, x * dstBpp, dstBpp,
+            width * dstBpp, 1, and, xor);
+}
+
+/*
+ * Solid spans, the bulk of what wide lines, arcs and polygons produce:
+ * the drawable is looked up once rather than per span, only the clip
+ * boxes in the span's band are visited, and short 32bpp copies are stored
+ * directly instead of going through a fill call per span.
+ */
+static void
+fbSolidSpans(DrawablePtr pDrawable, GCPtr pGC, int n, DDXPointPtr ppt,
+             int *pwidth)
+{
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
+    RegionPtr pClip = fbGetCompositeClip(pGC);
+    BoxPtr pextent, pbox, pboxEnd;
+    FbBits *dst;
+    FbStride dstStride;
+    int dstBpp;
+    int dstXoff, dstYoff;
+    int fullX1, fullX2, fullY1;
+    int partX1, partX2;
+
+    pextent = RegionExtents(pClip);
+    pboxEnd = RegionRects(pClip) + RegionNumRects(pClip);
+    fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
+
+    while (n--) {
+        fullX1 = ppt->x;
+        fullY1 = ppt->y;
+        fullX2 = fullX1 + (int) *pwidth;
+        ppt++;
+        pwidth++;
+
+        if (fullY1 < pextent->y1 || pextent->y2 <= fullY1)
+            continue;
+        if (fullX1 < pextent->x1)
+            fullX1 = pextent->x1;
+        if (fullX2 > pextent->x2)
+            fullX2 = pextent->x2;
+        if (fullX1 >= fullX2)
+            continue;
+
+        if (RegionNumRects(pClip) == 1) {
+            fbSolidSpan(dst, dstStride, dstBpp, fullX1 + dstXoff,
+                        fullY1 + dstYoff, fullX2 - fullX1,
+                        pPriv->and, pPriv->xor);
+            continue;
+        }
+        pbox = fbClipBand(RegionRects(pClip), RegionNumRects(pClip), fullY1);
+        for (; pbox < pboxEnd && pbox->y1 <= fullY1; pbox++) {
+            if (pbox->x1 >= fullX2)
+                break;
+            partX1 = max(pbox->x1, fullX1);
+            partX2 = min(pbox->x2, fullX2);
+            if (partX2 > partX1)
+                fbSolidSpan(dst, dstStride, dstBpp, partX1 + dstXoff,
+                            fullY1 + dstYoff, partX2 - partX1,
+                            pPriv->and, pPriv->xor);
+        }
+    }
+
+    fbValidateDrawable(pDrawable);
+    fbFinishAccess(pDrawable);
+}
+
 void
 fbFillSpans(DrawablePtr pDrawable,
             GCPtr pGC, int n, DDXPointPtr ppt, int *pwidth, int fSorted)
@@ -37,6 +143,11 @@ fbFillSpans(DrawablePtr pDrawable,
     int fullX1, fullX2, fullY1;
     int partX1, partX2;
 
+    if (pGC->fillStyle == FillSolid) {
+        fbSolidSpans(pDrawable, pGC, n, ppt, pwidth);
+        return;
+    }
+
     pextent = RegionExtents(pClip);
     extentX1 = pextent->x1;
     extentY1 = pextent->y1;
@@ -53,6 +53,37 @@ fbGlyphIn(RegionPtr pRegion, int x, int y, int width, int height)
     return RegionContainsRect(pRegion, &box) == rgnIN;
 }
 
+/*
+ * Check whether every glyph of a string lies inside the clip, so that
+ * the glyphs needn't be checked one at a time.  Text is usually drawn
+ * well inside its window, into a clip of one or a few rectangles.
+ */
+static Bool
+fbGlyphRunIn(RegionPtr pRegion, int x, int y,
+             unsigned int nglyph, CharInfoPtr * ppci)
+{
+    CharInfoPtr pci;
+    int x1 = MAXINT, y1 = MAXINT, x2 = MININT, y2 = MININT;
+
+    while (nglyph--) {
+        pci = *ppci++;
+        if (GLYPHWIDTHPIXELS(pci) && GLYPHHEIGHTPIXELS(pci)) {
+            if (x1 > x + pci->metrics.leftSideBearing)
+                x1 = x + pci->metrics.leftSideBearing;
+            if (x2 < x + pci->metrics.rightSideBearing)
+                x2 = x + pci->metrics.rightSideBearing;
+            if (y1 > y - pci->metrics.ascent)
+                y1 = y - pci->metrics.ascent;
+            if (y2 < y + pci->metrics.descent)
+                y2 = y + pci->metrics.descent;
+        }
+        x += pci->metrics.characterWidth;
+    }
+    if (x1 >= x2 || y1 >= y2)
+        return TRUE;
+    return fbGlyphIn(pRegion, x1, y1, x2 - x1, y2 - y1);
+}
+
 void
 fbPolyGlyphBlt(DrawablePtr pDrawable,
                GCPtr pGC,
@@ -71,6 +102,7 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
     FbStride dstStride = 0;
     int dstBpp = 0;
     int dstXoff = 0, dstYoff = 0;
+    Bool runIn = FALSE, access = FALSE;
 
     glyph = 0;
     if (pGC->fillStyle == FillSolid && pPriv->and == 0) {
@@ -90,6 +122,9 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
     x += pDrawable->x;
     y += pDrawable->y;
 
+    if (glyph)
+        runIn = fbGlyphRunIn(fbGetCompositeClip(pGC), x, y, nglyph, ppci);
+
     while (nglyph--) {
         pci = *ppci++;
         pglyph = FONTGLYPHBITS(pglyphBase, pci);
@@ -99,14 +134,21 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
             gx = x + pci->metrics.leftSideBearing;
             gy = y - pci->metrics.ascent;
             if (glyph && gWidth <= sizeof(FbStip) * 8 &&
-                fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight)) {
-                fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff,
-                              dstYoff);
+                (runIn ||
+                 fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight))) {
+                if (!access) {
+                    fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff,
+                                  dstYoff);
+                    access = TRUE;
+                }
                 (*glyph) (dst + (gy + dstYoff) * dstStride, dstStride, dstBpp,
                           (FbStip *) pglyph, pPriv->xor, gx + dstXoff, gHeight);
-                fbFinishAccess(pDrawable);
             }
             else {
+                if (access) {
+                    fbFinishAccess(pDrawable);
+                    access = FALSE;
+                }
                 gStride = GLYPHWIDTHBYTESPADDED(pci) / sizeof(FbStip);
                 fbPushImage(pDrawable,
                             pGC,
@@ -116,6 +158,8 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
         }
         x += pci->metrics.characterWidth;
     }
+    if (access)
+        fbFinishAccess(pDrawable);
 }
 
 void
@@ -139,6 +183,7 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
     FbStride dstStride = 0;
     int dstBpp = 0;
     int dstXoff = 0, dstYoff = 0;
+    Bool runIn = FALSE, access = FALSE;
 
     glyph = 0;
     if (pPriv->and == 0) {
@@ -191,6 +236,9 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
         opaque = FALSE;
     }
 
+    if (glyph)
+        runIn = fbGlyphRunIn(fbGetCompositeClip(pGC), x, y, nglyph, ppciInit);
+
     ppci = ppciInit;
     while (nglyph--) {
         pci = *ppci++;
@@ -201,14 +249,21 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
             gx = x + pci->metrics.leftSideBearing;
             gy = y - pci->metrics.ascent;
             if (glyph && gWidth <= sizeof(FbStip) * 8 &&
-                fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight)) {
-                fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff,
-                              dstYoff);
+                (runIn ||
+                 fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight))) {
+                if (!access) {
+                    fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff,
+                                  dstYoff);
+                    access = TRUE;
+                }
                 (*glyph) (dst + (gy + dstYoff) * dstStride, dstStride, dstBpp,
                           (FbStip *) pglyph, pPriv->fg, gx + dstXoff, gHeight);
-                fbFinishAccess(pDrawable);
             }
             else {
+                if (access) {
+                    fbFinishAccess(pDrawable);
+                    access = FALSE;
+                }
                 gStride = GLYPHWIDTHBYTESPADDED(pci) / sizeof(FbStip);
                 fbPutXYImage(pDrawable,
                              fbGetCompositeClip(pGC),
@@ -224,4 +279,6 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
         }
         x += pci->metrics.characterWidth;
     }
+    if (access)
+        fbFinishAccess(pDrawable);
 }
@@ -35,6 +35,26 @@
 #include "mipict.h"
 #include "fbpict.h"
 
+typedef struct _FbCompositeBand {
+    pixman_op_t op;
+    pixman_image_t *src, *mask, *dest;
+    int src_x, src_y;
+    int msk_x, msk_y;
+    int dst_x, dst_y;
+    int width;
+} FbCompositeBand;
+
+static void
+fbCompositeBand(void *closure, int y, int height)
+{
+    FbCompositeBand *band = closure;
+
+    pixman_image_composite(band->op, band->src, band->mask, band->dest,
+                           band->src_x, band->src_y + y,
+                           band->msk_x, band->msk_y + y,
+                           band->dst_x, band->dst_y + y, band->width, height);
+}
+
 void
 fbComposite(CARD8 op,
             PicturePtr pSrc,
@@ -59,6 +79,25 @@ fbComposite(CARD8 op,
     dest = image_from_pict(pDst, TRUE, &dst_xoff, &dst_yoff);
 
     if (src && dest && !(pMask && !mask)) {
+#ifndef FB_ACCESS_WRAPPER
+        if (fbCompositeThreads > 1 &&
+            (int) width * height >= fbCompositeThreshold) {
+            FbCompositeBand band = {
+                op, src, mask, dest,
+                xSrc + src_xoff, ySrc + src_yoff,
+                xMask + msk_xoff, yMask + msk_yoff,
+                xDst + dst_xoff, yDst + dst_yoff, width
+            };
+
+            /* An empty composite validates the images, which is the only
+             * thing pixman changes in them; after that the bands only
+             * read them and write disjoint rows of the destination.
+             */
+            pixman_image_composite(op, src, mask, dest, 0, 0, 0, 0, 0, 0, 0, 0);
+            fbRunBands(height, fbCompositeBand, &band);
+        }
+        else
+#endif
         pixman_image_composite(op, src, mask, dest,
                                xSrc + src_xoff, ySrc + src_yoff,
                                xMask + msk_xoff, yMask + msk_yoff,
@@ -72,16 +111,41 @@ fbComposite(CARD8 op,
 
 static pixman_glyph_cache_t *glyphCache;
 
+/* Set once a glyph has been put in the cache, so that a later miss on it
+ * can be told apart from a first use: it means the glyph was evicted and
+ * had to be copied in again, which is the cost worth watching.
+ */
+static DevPrivateKeyRec fbGlyphPrivateKeyRec;
+
+#define fbGlyphWasCached(glyph) \
+    ((Bool *) dixGetPrivateAddr(&(glyph)->devPrivates, &fbGlyphPrivateKeyRec))
+
+static unsigned long glyphLookups, glyphMisses, glyphRecached;
+
 void
 fbDestroyGlyphCache(void)
 {
     if (glyphCache)
     {
+	if (glyphLookups)
+	    LogMessageVerb(X_INFO, 3, "fb: glyph cache: %lu lookups, "
+			   "%lu misses, %lu of them after eviction\n",
+			   glyphLookups, glyphMisses, glyphRecached);
+	glyphLookups = glyphMisses = glyphRecached = 0;
+
 	pixman_glyph_cache_destroy (glyphCache);
 	glyphCache = NULL;
     }
 }
 
+/* Memory is low; pixman can't tell how much the cache holds */
+static unsigned long
+fbTrimGlyphCache(void *closure)
+{
+    fbDestroyGlyphCache();
+    return 0;
+}
+
 static void
 fbUnrealizeGlyph(ScreenPtr pScreen,
 		 GlyphPtr pGlyph)
@@ -106,7 +170,8 @@ fbGlyphs(CARD8 op,
     pixman_glyph_t *pglyphs = stack_glyphs;
     pixman_image_t *srcImage, *dstImage;
     int srcXoff, srcYoff, dstXoff, dstYoff;
-    GlyphPtr glyph;
+    GlyphPtr glyph, lastGlyph = NULL;
+    const void *lastG = NULL;
     int n_glyphs;
     int x, y;
     int i, n;
@@ -138,8 +203,12 @@ fbGlyphs(CARD8 op,
 	    const void *g;
 
             glyph = *glyphs++;
+	    glyphLookups++;
 
-	    if (!(g = pixman_glyph_cache_lookup (glyphCache, glyph, NULL))) {
+	    /* Runs repeat glyphs a lot; nothing is evicted while frozen */
+	    if (glyph == lastGlyph)
+		g = lastG;
+	    else if (!(g = pixman_glyph_cache_lookup (glyphCache, glyph, NULL))) {
 		pixman_image_t *glyphImage;
 		PicturePtr pPicture;
 		int xoff, yoff;
@@ -162,7 +231,14 @@ fbGlyphs(CARD8 op,
 
 		if (!g)
 		    goto out;
+
+		glyphMisses++;
+		if (*fbGlyphWasCached(glyph))
+		    glyphRecached++;
+		*fbGlyphWasCached(glyph) = TRUE;
 	    }
+	    lastGlyph = glyph;
+	    lastG = g;
 
 	    pglyphs[i].x = x;
 	    pglyphs[i].y = y;
@@ -492,6 +568,9 @@ fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
 
     if (!miPictureInit(pScreen, formats, nformats))
         return FALSE;
+    if (!dixRegisterPrivateKey(&fbGlyphPrivateKeyRec, PRIVATE_GLYPH,
+                               sizeof(Bool)))
+        return FALSE;
     ps = GetPictureScreen(pScreen);
     ps->Composite = fbComposite;
     ps->Glyphs = fbGlyphs;
@@ -502,6 +581,7 @@ fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
     ps->AddTraps = fbAddTraps;
     ps->AddTriangles = fbAddTriangles;
     ps->Triangles = fbTriangles;
+    RegisterCacheTrim("fb glyphs", 40, fbTrimGlyphCache, NULL);
 
     return TRUE;
 }
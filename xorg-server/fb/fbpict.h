@@ -39,6 +39,20 @@ fbComposite(CARD8 op,
             INT16 xMask,
             INT16 yMask, INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
 
+/* fbthread.c */
+
+/* Composites of at least fbCompositeThreshold pixels are split into bands
+ * over fbCompositeThreads threads; the ddx may set both before the first
+ * composite.  One thread, the default, keeps everything serial.
+ */
+extern _X_EXPORT int fbCompositeThreads;
+extern _X_EXPORT int fbCompositeThreshold;
+
+typedef void (*FbBandProc) (void *closure, int y, int height);
+
+extern void
+fbRunBands(int height, FbBandProc proc, void *closure);
+
 /* fbtrap.c */
 
 extern _X_EXPORT void
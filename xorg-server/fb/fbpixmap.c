@@ -141,7 +141,7 @@ fbPixmapToRegion(PixmapPtr pPix)
     Bool fInBox, fSame;
     register FbBits mask0 = FB_ALLONES & ~FbScrRight(FB_ALLONES, 1);
     FbBits *pwLine;
-    int nWidth;
+    int nWidth, nWords;
 
     pReg = RegionCreate(NULL, 1);
     if (!pReg)
@@ -158,10 +158,24 @@ fbPixmapToRegion(PixmapPtr pPix)
     pReg->extents.x1 = width - 1;
     pReg->extents.x2 = 0;
     irectPrevStart = -1;
+    nWords = (width + FB_MASK) >> FB_SHIFT;
     for (h = 0; h < pPix->drawable.height; h++) {
         pw = pwLine;
         pwLine += nWidth;
         irectLineStart = rects - FirstRect;
+        /* A line the same as the one before covers the same boxes; grow
+         * them instead of scanning the bits again */
+        if (h) {
+            for (ib = 0; ib < nWords; ib++)
+                if (READ(pw + ib) != READ(pw + ib - nWidth))
+                    break;
+            if (ib == nWords) {
+                for (prectO = FirstRect + irectPrevStart; prectO < rects;
+                     prectO++)
+                    prectO->y2 += 1;
+                continue;
+            }
+        }
         /* If the Screen left most bit of the word is set, we're starting in
          * a box */
         if (READ(pw) & mask0) {
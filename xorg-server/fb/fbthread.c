@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Worker threads for large fb operations.
+ *
+ * fbRunBands() splits a job into horizontal bands and runs them on up to
+ * fbCompositeThreads threads, the calling thread included, returning once
+ * all of them are done.  The other threads come from the server's thread
+ * pool: a helper is queued on the interactive lane for each band beyond
+ * the first, and helpers take bands until none are left.  The calling
+ * thread does the same and then cancels the helpers that never started,
+ * so a busy pool only makes the job more serial.  With the default of one
+ * thread everything runs serially and the pool is never used.  The band
+ * procedure must be safe to run concurrently on disjoint bands.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <pthread.h>
+
+#include "fb.h"
+#include "picturestr.h"
+#include "fbpict.h"
+
+int fbCompositeThreads = 1;
+int fbCompositeThreshold = 256 * 256;
+
+#define FB_MAX_THREADS  16
+#define FB_MIN_BAND     32      /* rows; smaller bands are not worth a wakeup */
+
+typedef struct _FbBandJob {
+    FbBandProc proc;
+    void *closure;
+    int height;
+    int nbands;
+    int next;                   /* next band to hand out */
+    int pending;                /* bands handed out or not, still running */
+    int helpers;                /* helpers queued and not cancelled */
+} FbBandJob;
+
+static pthread_mutex_t bandMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bandDone = PTHREAD_COND_INITIALIZER;
+static FbBandJob bandJob;
+static ThreadPoolWork bandWork[FB_MAX_THREADS];
+
+/* Pre-condition: Called with bandMutex held, and a band left to take */
+static void
+fbRunNextBand(void)
+{
+    FbBandProc proc = bandJob.proc;
+    void *closure = bandJob.closure;
+    int band = bandJob.next++;
+    int y = bandJob.height * band / bandJob.nbands;
+    int h = bandJob.height * (band + 1) / bandJob.nbands - y;
+
+    pthread_mutex_unlock(&bandMutex);
+    (*proc) (closure, y, h);
+    pthread_mutex_lock(&bandMutex);
+
+    if (--bandJob.pending == 0)
+        pthread_cond_signal(&bandDone);
+}
+
+static void
+fbBandHelper(void *closure)
+{
+    pthread_mutex_lock(&bandMutex);
+    while (bandJob.next < bandJob.nbands)
+        fbRunNextBand();
+    if (--bandJob.helpers == 0)
+        pthread_cond_signal(&bandDone);
+    pthread_mutex_unlock(&bandMutex);
+}
+
+void
+fbRunBands(int height, FbBandProc proc, void *closure)
+{
+    int threads = min(fbCompositeThreads, FB_MAX_THREADS);
+    int nbands = min(threads, height / FB_MIN_BAND);
+    int i;
+
+    if (nbands > 1)
+        nbands = min(nbands, ThreadPoolThreads() + 1);
+
+    if (nbands <= 1) {
+        (*proc) (closure, 0, height);
+        return;
+    }
+
+    pthread_mutex_lock(&bandMutex);
+    bandJob.proc = proc;
+    bandJob.closure = closure;
+    bandJob.height = height;
+    bandJob.nbands = nbands;
+    bandJob.next = 0;
+    bandJob.pending = nbands;
+    bandJob.helpers = 0;
+    for (i = 0; i < nbands - 1; i++)
+        if (ThreadPoolQueue(&bandWork[i], ThreadPoolInteractive,
+                            fbBandHelper, NULL))
+            bandJob.helpers++;
+
+    while (bandJob.next < bandJob.nbands)
+        fbRunNextBand();
+    for (i = 0; i < nbands - 1; i++)
+        if (ThreadPoolCancel(&bandWork[i]))
+            bandJob.helpers--;
+    while (bandJob.pending || bandJob.helpers)
+        pthread_cond_wait(&bandDone, &bandMutex);
+    pthread_mutex_unlock(&bandMutex);
+}
@@ -98,6 +98,57 @@ fbEvenTile(FbBits * dst,
     }
 }
 
+/*
+ * Copy tile fill for whole-byte pixels.  The start of each row is copied
+ * straight from the tile row in at most two pieces, which takes care of
+ * the rotation, and the row is then doubled until it is full, so a wide
+ * fill of a small tile costs a few memcpy calls per row rather than an
+ * fbBlt per tile width.  All x values are in bits.
+ */
+static void
+fbCopyTile(FbBits * dst,
+           FbStride dstStride,
+           int dstX,
+           int width,
+           FbBits * tile,
+           FbStride tileStride,
+           int tileWidth, int tileHeight, int xRot, int yRot, int height)
+{
+    CARD8 *d, *t;
+    int tileX, tileY;
+    int n, m;
+
+    modulus(-yRot, tileHeight, tileY);
+    modulus(dstX - xRot, tileWidth, tileX);
+    tileX >>= 3;
+    tileWidth >>= 3;
+    width >>= 3;
+    dst += dstX >> FB_SHIFT;
+    dstX = (dstX & FB_MASK) >> 3;
+
+    while (height--) {
+        d = (CARD8 *) dst + dstX;
+        t = (CARD8 *) (tile + tileY * tileStride);
+
+        n = min(tileWidth - tileX, width);
+        MEMCPY_WRAPPED(d, t + tileX, n);
+        if (n < width) {
+            m = min(tileX, width - n);
+            MEMCPY_WRAPPED(d + n, t, m);
+            n += m;
+        }
+        while (n < width) {
+            m = min(n, width - n);
+            MEMCPY_WRAPPED(d + n, d, m);
+            n += m;
+        }
+
+        dst += dstStride;
+        if (++tileY == tileHeight)
+            tileY = 0;
+    }
+}
+
 void
 fbOddTile(FbBits * dst,
           FbStride dstStride,
@@ -114,6 +165,12 @@ fbOddTile(FbBits * dst,
     int h, w;
     int x, y;
 
+    if (alu == GXcopy && pm == FB_ALLONES && !(bpp & 7)) {
+        fbCopyTile(dst, dstStride, dstX, width, tile, tileStride,
+                   tileWidth, tileHeight, xRot, yRot, height);
+        return;
+    }
+
     modulus(-yRot, tileHeight, tileY);
     y = 0;
     while (height) {
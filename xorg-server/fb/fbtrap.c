@@ -154,6 +154,152 @@ fbShapes(CompositeShapesFunc composite,
     free_pixman_pict(pDst, dst);
 }
 
+#ifndef FB_ACCESS_WRAPPER
+/*
+ * Large trapezoid masks are rasterized and composited in bands on the
+ * fbRunBands() threads.  Each band gets its own mask covering its rows
+ * of the extents; pixman's edge walkers start exactly where they would
+ * have been in the full mask, so the result is the same as from
+ * pixman_composite_trapezoids(), which this follows step by step.
+ */
+
+/* Whether a zero source leaves the destination alone, as in pixman;
+ * the operators past Add all count as having an effect there too.
+ */
+static const Bool fbZeroSrcHasNoEffect[PIXMAN_OP_ADD + 1] = {
+    FALSE, FALSE, TRUE, TRUE, TRUE, FALSE, FALSE,
+    FALSE, TRUE, TRUE, FALSE, TRUE, TRUE
+};
+
+typedef struct _FbTrapBand {
+    pixman_op_t op;
+    pixman_image_t *src, *dst;
+    pixman_format_code_t mask_format;
+    int x_src, y_src;
+    int x_dst, y_dst;
+    pixman_box32_t box;
+    int n_traps;
+    const pixman_trapezoid_t *traps;
+} FbTrapBand;
+
+static void
+fbTrapezoidsBand(void *closure, int y, int height)
+{
+    FbTrapBand *band = closure;
+    int width = band->box.x2 - band->box.x1;
+    int y1 = band->box.y1 + y;
+    pixman_image_t *mask;
+    int i;
+
+    mask = pixman_image_create_bits(band->mask_format, width, height, NULL, -1);
+    if (!mask)
+        return;
+
+    for (i = 0; i < band->n_traps; i++) {
+        const pixman_trapezoid_t *trap = &band->traps[i];
+
+        if (pixman_fixed_to_int(trap->top) >= y1 + height ||
+            pixman_fixed_to_int(pixman_fixed_ceil(trap->bottom)) <= y1)
+            continue;
+
+        pixman_rasterize_trapezoid(mask, trap, -band->box.x1, -y1);
+    }
+
+    pixman_image_composite(band->op, band->src, mask, band->dst,
+                           band->x_src + band->box.x1, band->y_src + y1,
+                           0, 0,
+                           band->x_dst + band->box.x1, band->y_dst + y1,
+                           width, height);
+
+    pixman_image_unref(mask);
+}
+
+static Bool
+fbTrapezoidExtents(pixman_op_t op, pixman_image_t *dst,
+                   int n_traps, const pixman_trapezoid_t *traps,
+                   pixman_box32_t *box)
+{
+    int i;
+
+    if (op > PIXMAN_OP_ADD || !fbZeroSrcHasNoEffect[op]) {
+        box->x1 = 0;
+        box->y1 = 0;
+        box->x2 = pixman_image_get_width(dst);
+        box->y2 = pixman_image_get_height(dst);
+        return TRUE;
+    }
+
+    box->x1 = box->y1 = INT32_MAX;
+    box->x2 = box->y2 = INT32_MIN;
+
+    for (i = 0; i < n_traps; i++) {
+        const pixman_trapezoid_t *trap = &traps[i];
+
+        if (!pixman_trapezoid_valid(trap))
+            continue;
+
+        box->y1 = min(box->y1, pixman_fixed_to_int(trap->top));
+        box->y2 = max(box->y2,
+                      pixman_fixed_to_int(pixman_fixed_ceil(trap->bottom)));
+        box->x1 = min(box->x1, pixman_fixed_to_int(trap->left.p1.x));
+        box->x1 = min(box->x1, pixman_fixed_to_int(trap->left.p2.x));
+        box->x1 = min(box->x1, pixman_fixed_to_int(trap->right.p1.x));
+        box->x1 = min(box->x1, pixman_fixed_to_int(trap->right.p2.x));
+        box->x2 = max(box->x2,
+                      pixman_fixed_to_int(pixman_fixed_ceil(trap->left.p1.x)));
+        box->x2 = max(box->x2,
+                      pixman_fixed_to_int(pixman_fixed_ceil(trap->left.p2.x)));
+        box->x2 = max(box->x2,
+                      pixman_fixed_to_int(pixman_fixed_ceil(trap->right.p1.x)));
+        box->x2 = max(box->x2,
+                      pixman_fixed_to_int(pixman_fixed_ceil(trap->right.p2.x)));
+    }
+
+    return box->x1 < box->x2 && box->y1 < box->y2;
+}
+
+static void
+fbCompositeTrapezoids(pixman_op_t op,
+                      pixman_image_t *src,
+                      pixman_image_t *dst,
+                      pixman_format_code_t mask_format,
+                      int x_src, int y_src,
+                      int x_dst, int y_dst,
+                      int n_traps, const pixman_trapezoid_t *traps)
+{
+    FbTrapBand band;
+
+    /* Pixman may rasterize ADD straight into a matching destination */
+    if (fbCompositeThreads <= 1 || n_traps <= 0 ||
+        (op == PIXMAN_OP_ADD && mask_format == pixman_image_get_format(dst)) ||
+        !fbTrapezoidExtents(op, dst, n_traps, traps, &band.box) ||
+        (band.box.x2 - band.box.x1) * (band.box.y2 - band.box.y1) <
+        fbCompositeThreshold) {
+        pixman_composite_trapezoids(op, src, dst, mask_format,
+                                    x_src, y_src, x_dst, y_dst,
+                                    n_traps, traps);
+        return;
+    }
+
+    band.op = op;
+    band.src = src;
+    band.dst = dst;
+    band.mask_format = mask_format;
+    band.x_src = x_src;
+    band.y_src = y_src;
+    band.x_dst = x_dst;
+    band.y_dst = y_dst;
+    band.n_traps = n_traps;
+    band.traps = traps;
+
+    /* Validate the shared images before the bands start reading them */
+    pixman_image_composite(op, src, NULL, dst, 0, 0, 0, 0, 0, 0, 0, 0);
+    fbRunBands(band.box.y2 - band.box.y1, fbTrapezoidsBand, &band);
+}
+#else
+#define fbCompositeTrapezoids pixman_composite_trapezoids
+#endif
+
 void
 fbTrapezoids(CARD8 op,
              PicturePtr pSrc,
@@ -164,7 +310,7 @@ fbTrapezoids(CARD8 op,
     xSrc -= (traps[0].left.p1.x >> 16);
     ySrc -= (traps[0].left.p1.y >> 16);
 
-    fbShapes((CompositeShapesFunc) pixman_composite_trapezoids,
+    fbShapes((CompositeShapesFunc) fbCompositeTrapezoids,
              op, pSrc, pDst, maskFormat,
              xSrc, ySrc, ntrap, sizeof(xTrapezoid), (const uint8_t *) traps);
 }
@@ -23,6 +23,8 @@
 #define fbClearVisualTypes wfbClearVisualTypes
 #define fbCloseScreen wfbCloseScreen
 #define fbComposite wfbComposite
+#define fbCompositeThreads wfbCompositeThreads
+#define fbCompositeThreshold wfbCompositeThreshold
 #define fbCopy1toN wfbCopy1toN
 #define fbCopyArea wfbCopyArea
 #define fbCopyNto1 wfbCopyNto1
@@ -106,6 +108,7 @@
 #define fbRealizeFont wfbRealizeFont
 #define fbReplicatePixel wfbReplicatePixel
 #define fbResolveColor wfbResolveColor
+#define fbRunBands wfbRunBands
 #define fbScreenPrivateKeyRec wfbScreenPrivateKeyRec
 #define fbSegment wfbSegment
 #define fbSelectBres wfbSelectBres
@@ -2064,6 +2064,55 @@ ResetLargeCommandStatus(__GLXcontext *cx)
     cx->largeCmdRequestsTotal = 0;
 }
 
+/*
+** Render batches from immediate-mode clients are long runs of a handful
+** of opcodes (glVertex3fv, glNormal3fv, glColor4ubv...).  Remember the
+** size data and decode functions of recently seen opcodes so that each
+** command doesn't walk the dispatch tree twice.  The tables behind this
+** are constant, so the cache never needs to be invalidated.
+*/
+#define RENDER_DECODE_CACHE_SIZE 256
+
+typedef struct {
+    Bool valid;
+    CARD16 opcode;
+    __GLXrenderSizeData entry;
+    __GLXdispatchRenderProcPtr proc[2];
+} __GLXrenderDecodeCache;
+
+static __GLXrenderDecodeCache renderDecodeCache[RENDER_DECODE_CACHE_SIZE];
+
+static const __GLXrenderDecodeCache *
+LookupRenderDecode(CARD16 opcode)
+{
+    __GLXrenderDecodeCache *slot =
+        &renderDecodeCache[opcode & (RENDER_DECODE_CACHE_SIZE - 1)];
+
+    if (!slot->valid || slot->opcode != opcode) {
+        __GLXrenderSizeData entry;
+        __GLXdispatchRenderProcPtr proc[2];
+        int i;
+
+        if (__glXGetProtocolSizeData(&Render_dispatch_info, opcode,
+                                     &entry) < 0)
+            return NULL;
+
+        for (i = 0; i < 2; i++) {
+            proc[i] = (__GLXdispatchRenderProcPtr)
+                __glXGetProtocolDecodeFunction(&Render_dispatch_info,
+                                               opcode, i);
+        }
+
+        slot->valid = TRUE;
+        slot->opcode = opcode;
+        slot->entry = entry;
+        slot->proc[0] = proc[0];
+        slot->proc[1] = proc[1];
+    }
+
+    return slot;
+}
+
 /*
 ** Execute all the drawing commands in a request.
 */
@@ -2097,10 +2146,10 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
     pc += sz_xGLXRenderReq;
     left = (req->length << 2) - sz_xGLXRenderReq;
     while (left > 0) {
-        __GLXrenderSizeData entry;
+        const __GLXrenderDecodeCache *decode;
+        const __GLXrenderSizeData *entry;
         int extra = 0;
         __GLXdispatchRenderProcPtr proc;
-        int err;
 
         if (left < sizeof(__GLXrenderHeader))
             return BadLength;
@@ -2123,31 +2172,30 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
         /*
          ** Check for core opcodes and grab entry data.
          */
-        err = __glXGetProtocolSizeData(&Render_dispatch_info, opcode, &entry);
-        proc = (__GLXdispatchRenderProcPtr)
-            __glXGetProtocolDecodeFunction(&Render_dispatch_info,
-                                           opcode, client->swapped);
+        decode = LookupRenderDecode(opcode);
+        proc = decode ? decode->proc[client->swapped ? 1 : 0] : NULL;
 
-        if ((err < 0) || (proc == NULL)) {
+        if (proc == NULL) {
             client->errorValue = commandsDone;
             return __glXError(GLXBadRenderRequest);
         }
+        entry = &decode->entry;
 
-        if (cmdlen < entry.bytes) {
+        if (cmdlen < entry->bytes) {
             return BadLength;
         }
 
-        if (entry.varsize) {
+        if (entry->varsize) {
             /* variable size command */
-            extra = (*entry.varsize) (pc + __GLX_RENDER_HDR_SIZE,
-                                      client->swapped,
-                                      left - __GLX_RENDER_HDR_SIZE);
+            extra = (*entry->varsize) (pc + __GLX_RENDER_HDR_SIZE,
+                                       client->swapped,
+                                       left - __GLX_RENDER_HDR_SIZE);
             if (extra < 0) {
                 return BadLength;
             }
         }
 
-        if (cmdlen != safe_pad(safe_add(entry.bytes, extra))) {
+        if (cmdlen != safe_pad(safe_add(entry->bytes, extra))) {
             return BadLength;
         }
 
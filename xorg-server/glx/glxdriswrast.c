@@ -43,6 +43,8 @@
 #include "scrnintstr.h"
 #include "pixmapstr.h"
 #include "gcstruct.h"
+#include "windowstr.h"
+#include "damage.h"
 #include "os.h"
 
 #include "glxserver.h"
@@ -299,6 +301,94 @@ swrastGetDrawableInfo(__DRIdrawable * draw,
     *h = pDraw->height;
 }
 
+/*
+ * Present a frame by copying it straight into the drawable's backing
+ * pixmap when that is plain CPU memory (on XWin, the multiwindow DIB or
+ * the shadow framebuffer).  Only the visible boxes are written and the
+ * damage is reported directly, so the scratch GC, ValidateGC and the
+ * wrapped PutImage ops are skipped.  Returns FALSE if the generic path
+ * must be used instead.
+ */
+static Bool
+swrastPutImageDirect(DrawablePtr pDraw, int x, int y, int w, int h,
+                     char *data)
+{
+    ScreenPtr pScreen = pDraw->pScreen;
+    PixmapPtr pPix;
+    RegionRec region;
+    BoxRec box;
+    BoxPtr pbox;
+    int nbox, xoff, yoff;
+    int srcStride = PixmapBytePad(w, pDraw->depth);
+    char *dst;
+
+    if (pDraw->bitsPerPixel != 32 || w <= 0 || h <= 0)
+        return FALSE;
+
+    if (pDraw->type == DRAWABLE_WINDOW) {
+        WindowPtr pWin = (WindowPtr) pDraw;
+
+        if (!pWin->viewable)
+            return TRUE;
+        pPix = pScreen->GetWindowPixmap(pWin);
+#ifdef COMPOSITE
+        xoff = pPix->screen_x;
+        yoff = pPix->screen_y;
+#else
+        xoff = yoff = 0;
+#endif
+    }
+    else {
+        pPix = (PixmapPtr) pDraw;
+        xoff = yoff = 0;
+    }
+
+    if (!pPix || !pPix->devPrivate.ptr || pPix->devKind <= 0 ||
+        pPix->drawable.bitsPerPixel != 32)
+        return FALSE;
+
+    /* box in screen coordinates for windows, pixmap coordinates otherwise */
+    box.x1 = pDraw->x + x;
+    box.y1 = pDraw->y + y;
+    box.x2 = box.x1 + w;
+    box.y2 = box.y1 + h;
+    RegionInit(&region, &box, 1);
+
+    if (pDraw->type == DRAWABLE_WINDOW) {
+        RegionIntersect(&region, &region, &((WindowPtr) pDraw)->clipList);
+    }
+    else {
+        BoxRec bounds = { 0, 0, pPix->drawable.width, pPix->drawable.height };
+        RegionRec pixRegion;
+
+        RegionInit(&pixRegion, &bounds, 1);
+        RegionIntersect(&region, &region, &pixRegion);
+        RegionUninit(&pixRegion);
+    }
+
+    pbox = RegionRects(&region);
+    nbox = RegionNumRects(&region);
+    for (; nbox--; pbox++) {
+        const char *src = data + (pbox->y1 - box.y1) * srcStride +
+                          (pbox->x1 - box.x1) * 4;
+        const size_t len = (pbox->x2 - pbox->x1) * 4;
+        int row;
+
+        dst = (char *) pPix->devPrivate.ptr +
+              (pbox->y1 - yoff) * pPix->devKind + (pbox->x1 - xoff) * 4;
+        for (row = pbox->y1; row < pbox->y2; row++) {
+            memcpy(dst, src, len);
+            dst += pPix->devKind;
+            src += srcStride;
+        }
+    }
+
+    DamageDamageRegion(pDraw, &region);
+    RegionUninit(&region);
+
+    return TRUE;
+}
+
 static void
 swrastPutImage(__DRIdrawable * draw, int op,
                int x, int y, int w, int h, char *data, void *loaderPrivate)
@@ -327,7 +417,8 @@ swrastPutImage(__DRIdrawable * draw, int op,
   }
   else
 #endif
-    if ((gc = GetScratchGC(pDraw->depth, pDraw->pScreen))) {
+    if (!swrastPutImageDirect(pDraw, x, y, w, h, data) &&
+        (gc = GetScratchGC(pDraw->depth, pDraw->pScreen))) {
       ValidateGC(pDraw, gc);
       gc->ops->PutImage(pDraw, gc, pDraw->depth, x, y, w, h, 0, ZPixmap,
                         data);
@@ -52,6 +52,7 @@ RESTYPE idResource;
 static int
 idResourceDeleteCallback(void *value, XID id)
 {
+    GlxXIDMapChanged();
     return 0;
 }
 
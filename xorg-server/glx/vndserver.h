@@ -62,6 +62,14 @@ typedef struct GlxClientPrivRec {
      * The vendor handles for each screen.
      */
     GlxServerVendor **vendors;
+
+    /**
+     * The last XID that GlxGetXIDMap found in the XID map for this client,
+     * and its vendor. Only valid while the map's serial number matches.
+     */
+    XID lastXID;
+    GlxServerVendor *lastXIDVendor;
+    unsigned long lastXIDSerial;
 } GlxClientPriv;
 
 extern int GlxErrorBase;
@@ -95,6 +103,12 @@ Bool GlxAddXIDMap(XID id, GlxServerVendor *vendor);
 GlxServerVendor * GlxGetXIDMap(XID id);
 void GlxRemoveXIDMap(XID id);
 
+/**
+ * Called whenever an XID is removed from the XID map, to invalidate the
+ * cached lookups in each client.
+ */
+void GlxXIDMapChanged(void);
+
 /**
  * Records the client that sent the current request. This is needed in
  * GlxGetXIDMap to know which client's (screen -> vendor) mapping to use for a
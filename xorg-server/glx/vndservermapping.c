@@ -35,6 +35,10 @@
 
 static ClientPtr requestClient = NULL;
 
+// Bumped whenever an XID leaves the XID map. Zero never matches, so a
+// freshly allocated GlxClientPriv starts with an empty cache.
+static unsigned long xidMapSerial = 1;
+
 void GlxSetRequestClient(ClientPtr client)
 {
     requestClient = client;
@@ -53,11 +57,34 @@ static GlxServerVendor *LookupXIDMapResource(XID id)
     }
 }
 
+void GlxXIDMapChanged(void)
+{
+    xidMapSerial++;
+}
+
 GlxServerVendor *GlxGetXIDMap(XID id)
 {
-    GlxServerVendor *vendor = LookupXIDMapResource(id);
+    GlxClientPriv *cl = NULL;
+    GlxServerVendor *vendor;
+
+    // Most requests that need a lookup name the same context or GLX
+    // drawable as the one before, so remember the last hit per client.
+    if (requestClient != NULL) {
+        cl = GlxGetClientData(requestClient);
+        if (cl != NULL && cl->lastXID == id &&
+            cl->lastXIDSerial == xidMapSerial) {
+            return cl->lastXIDVendor;
+        }
+    }
 
-    if (vendor == NULL) {
+    vendor = LookupXIDMapResource(id);
+    if (vendor != NULL) {
+        if (cl != NULL) {
+            cl->lastXID = id;
+            cl->lastXIDVendor = vendor;
+            cl->lastXIDSerial = xidMapSerial;
+        }
+    } else {
         // If we haven't seen this XID before, then it may be a drawable that
         // wasn't created through GLX, like a regular X window or pixmap. Try
         // to look up a matching drawable to find a screen number for it.
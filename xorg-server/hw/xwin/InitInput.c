@@ -82,6 +82,9 @@ InitInput(int argc, char *argv[])
 {
   int rc;
     winDebug("InitInput\n");
+    winStartupMark("extensions, root windows and fonts");
+    winStartupWait();
+    winLatencyInit();
 
     /*
      * Wrap some functions at every generation of the server.
@@ -219,6 +219,8 @@ ddxGiveUp(enum ExitCode error)
         g_pszLogFile = LogInit(g_pszLogFile, ".old");
         g_fLogInited = TRUE;
     }
+    winWakeupLogStatistics();
+    winLatencyReport();
     LogClose(error);
 
     /*
@@ -226,6 +228,7 @@ ddxGiveUp(enum ExitCode error)
      * we are guaranteed to not need the DirectDraw functions.
      */
     winReleaseDDProcAddresses();
+    winReleaseDXGIProcAddresses();
 
     /* Free concatenated command line */
     free(g_pszCommandLine);
@@ -750,6 +753,20 @@ winUseMsg(void)
            "\tversions because they already group GDI operations together\n"
            "\tin a batch, which has a similar effect.\n");
 
+    ErrorF("-compositethreads count\n"
+           "\tSplit large RENDER composites into bands drawn by count\n"
+           "\tthreads.  Default is 1, which draws everything on the\n"
+           "\tserver thread.\n");
+
+    ErrorF("-compositethreshold pixels\n"
+           "\tOnly split composites covering at least this many pixels\n"
+           "\tacross threads.  Default is 65536.\n");
+
+    ErrorF("-threadpool count\n"
+           "\tRun background work and split composites on at most count\n"
+           "\tthreads.  Default is 0, one fewer than the CPUs the server\n"
+           "\tmay run on.\n");
+
     ErrorF("-[no]compositewm\n"
            "\tEnable [Disable] Composite extension. Default is enabled.\n"
            "\tUsed in -multiwindow mode.\n"
@@ -792,10 +809,21 @@ winUseMsg(void)
            "\tOverride the server's automatically selected engine type:\n"
            "\t\t1 - Shadow GDI\n"
            "\t\t4 - Shadow DirectDraw4 Non-Locking\n"
+           "\t\t8 - Shadow DXGI flip-model swap chain\n"
         );
 
     ErrorF("-fullscreen\n" "\tRun the server in fullscreen mode.\n");
 
+    ErrorF("-glhud graphs\n"
+           "\tShow the Gallium HUD in GLX clients rendered by the software\n"
+           "\trasterizer (-nowgl), and in Mesa clients started from the tray\n"
+           "\tmenu.  graphs is a GALLIUM_HUD specification, for example\n"
+           "\t -glhud fps,cpu;draw-calls,shader-compile-time\n");
+
+    ErrorF("-glhudlog filename\n"
+           "\tAppend the values of the -glhud graphs to <filename> as\n"
+           "\tcomma-separated lines.\n");
+
     ErrorF("-[no]hostintitle\n"
            "\tIn multiwindow mode, add remote host names to window titles.\n");
 
@@ -812,6 +840,10 @@ winUseMsg(void)
            "\tGrab special Windows keypresses like Alt-Tab or the Menu "
            "key.\n");
 
+    ErrorF("-latencyslo ms\n"
+           "\tLog a warning, naming the client, when a key or button press\n"
+           "\ttakes longer than <ms> milliseconds to show on the screen.\n");
+
     ErrorF("-lesspointer\n"
            "\tHide the windows mouse pointer when it is over any\n"
            "\t" EXECUTABLE_NAME
@@ -828,6 +860,11 @@ winUseMsg(void)
            "\t\t2 - print additional runtime information [default].\n"
            "\t\t3 - print debugging and tracing information.\n");
 
+    ErrorF("-mousehistory\n"
+           "\tAlso deliver the intermediate mouse positions Windows merged\n"
+           "\ttogether while the server was busy, for smoother strokes in\n"
+           "\tdrawing applications.\n");
+
     ErrorF("-[no]multimonitors or -[no]multiplemonitors\n"
            "\tUse the entire virtual screen if multiple\n"
            "\tmonitors are present.\n");
@@ -868,10 +905,25 @@ winUseMsg(void)
            "\t -screen 0 1024x768@3        ; 3rd monitor size 1024x768\n"
            "\t -screen 0 @1 ; on 1st monitor using its full resolution (the default)\n");
 
+    ErrorF("-shadowlog filename\n"
+           "\tAppend a line to <filename> for each shadow update: screen,\n"
+           "\tserver time in ms, boxes, pixels, microseconds since the\n"
+           "\tfirst drawing it shows, and microseconds spent updating.\n");
+
+    ErrorF("-skipunchanged\n"
+           "\tChecksum the damaged 64x64 tiles of the shadow framebuffer and\n"
+           "\tdon't blit those whose contents did not change.  Shadow GDI\n"
+           "\tengine only.\n");
+
     ErrorF("-swcursor\n"
            "\tDisable the usage of the Windows cursor and use the X11 software\n"
            "\tcursor instead.\n");
 
+    ErrorF("-toplevelbs megabytes\n"
+           "\tKeep the contents of mapped top-level windows, topmost first,\n"
+           "\tin up to this much memory, so uncovering them needs no\n"
+           "\tredraw by the client.  Default is 0, which disables it.\n");
+
     ErrorF("-[no]trayicon\n"
            "\tDo not create a notification area icon.  Default is to create\n"
            "\tone icon per screen.  You can globally disable notification area\n"
@@ -951,6 +1003,7 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
         XwinExtensionInit();
 
     winDebug("InitOutput\n");
+    winStartupMark("InitOutput");
 
     /* Validate command-line arguments */
     if (serverGeneration == 1 && !winValidateArgs()) {
@@ -964,6 +1017,9 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
                    "number :%d\n", atoi(display));
     }
 
+    /* The display is ours and listening; a launcher can start clients */
+    winStartupReady();
+
 #ifdef XWIN_XF86CONFIG
     /* Try to read the xorg.conf-style configuration file */
     if (!winReadConfigfile())
@@ -974,6 +1030,10 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
 
     /* Load preferences from XWinrc file */
     LoadPreferences();
+    winStartupMark("configuration and preferences");
+
+    /* Warm up the GL driver and the font path while the screens come up */
+    winStartupPrefetch();
 
     /* Setup global screen info parameters */
     pScreenInfo->imageByteOrder = IMAGE_BYTE_ORDER;
@@ -990,6 +1050,9 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
     /* Load pointers to DirectDraw functions */
     winGetDDProcAddresses();
 
+    /* Load pointers to Direct3D 11 and DXGI functions */
+    winGetDXGIProcAddresses();
+
     /* Detect supported engines */
     winDetectSupportedEngines();
     /* Load libraries for taskbar grouping */
@@ -1069,6 +1132,7 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
         winGenerateAuthorization();
 
 
+    winStartupMark("screens");
     winDebug("InitOutput - Returning.\n");
 }
 
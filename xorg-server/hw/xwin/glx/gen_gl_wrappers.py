@@ -58,6 +58,7 @@ used_wgl_ext_fns = {key: 1 for key in [
     "wglCreatePbufferARB",
     "wglMakeContextCurrentARB",
     "wglChoosePixelFormatARB",
+    "wglCreateContextAttribsARB",
     "wglGetPixelFormatAttribivARB",
     "wglGetPixelFormatAttribivARB"
 ]}
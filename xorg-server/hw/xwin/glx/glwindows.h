@@ -47,7 +47,21 @@ extern glxWinDebugSettingsRec glxWinDebugSettings;
 
 void glWinCallDelta(void);
 void glxWinPushNativeProvider(void);
+void glxWinWarmDriver(void);
 const GLubyte *glGetStringWrapperNonstatic(GLenum name);
+void glGetIntegervWrapperNonstatic(GLenum pname, GLint *params);
+void glGetTexLevelParameterivWrapperNonstatic(GLenum target, GLint level,
+                                              GLenum pname, GLint *params);
+void glPixelStoreiWrapperNonstatic(GLenum pname, GLint param);
+void glTexImage2DWrapperNonstatic(GLenum target, GLint level,
+                                  GLint internalformat, GLsizei width,
+                                  GLsizei height, GLint border, GLenum format,
+                                  GLenum type, const GLvoid *pixels);
+void glTexSubImage2DWrapperNonstatic(GLenum target, GLint level,
+                                     GLint xoffset, GLint yoffset,
+                                     GLsizei width, GLsizei height,
+                                     GLenum format, GLenum type,
+                                     const GLvoid *pixels);
 void glAddSwapHintRectWINWrapperNonstatic(GLint x, GLint y, GLsizei width,
                                           GLsizei height);
 void glWinSetupDispatchTable(void);
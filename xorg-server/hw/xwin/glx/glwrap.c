@@ -140,6 +140,48 @@ glGetStringWrapperNonstatic(GLenum name)
     return glGetString(name);
 }
 
+/*
+  Special non-static wrappers for uploading pixmaps for texture_from_pixmap
+*/
+
+void
+glGetIntegervWrapperNonstatic(GLenum pname, GLint *params)
+{
+    glGetIntegerv(pname, params);
+}
+
+void
+glGetTexLevelParameterivWrapperNonstatic(GLenum target, GLint level,
+                                         GLenum pname, GLint *params)
+{
+    glGetTexLevelParameteriv(target, level, pname, params);
+}
+
+void
+glPixelStoreiWrapperNonstatic(GLenum pname, GLint param)
+{
+    glPixelStorei(pname, param);
+}
+
+void
+glTexImage2DWrapperNonstatic(GLenum target, GLint level, GLint internalformat,
+                             GLsizei width, GLsizei height, GLint border,
+                             GLenum format, GLenum type, const GLvoid *pixels)
+{
+    glTexImage2D(target, level, internalformat, width, height, border, format,
+                 type, pixels);
+}
+
+void
+glTexSubImage2DWrapperNonstatic(GLenum target, GLint level, GLint xoffset,
+                                GLint yoffset, GLsizei width, GLsizei height,
+                                GLenum format, GLenum type,
+                                const GLvoid *pixels)
+{
+    glTexSubImage2D(target, level, xoffset, yoffset, width, height, format,
+                    type, pixels);
+}
+
 /*
   Special non-static wrapper for glAddSwapHintRectWIN for copySubBuffers
 */
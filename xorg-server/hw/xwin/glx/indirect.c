@@ -51,9 +51,9 @@
     before using it?
   - XGetImage() doesn't work on pixmaps; need to do more work to make the format and location
     of the native pixmap compatible
-  - implement GLX_EXT_texture_from_pixmap in terms of WGL_ARB_render_texture
-    (not quite straightforward as we will have to create a pbuffer and copy the pixmap texture
-     into it)
+  - GLX_EXT_texture_from_pixmap copies the pixmap into the texture, as only
+    the damaged parts but a copy all the same; a texture sharing the pixmap's
+    memory needs driver support (WGL_NV_DX_interop) and a D3D pixmap
 */
 
 /*
@@ -93,6 +93,7 @@
 #include <winmsg.h>
 #include <winglobals.h>
 #include <indirect.h>
+#include <wintrace.h>
 
 /* Not yet in w32api */
 #ifndef PFD_SUPPORT_DIRECTDRAW
@@ -414,6 +415,7 @@ static Bool glxWinSetPixelFormat(__GLXWinContext * gc, HDC hdc, int bppOverride,
 static HDC glxWinMakeDC(__GLXWinContext * gc, __GLXWinDrawable * draw,
                         HWND * hwnd);
 static void glxWinReleaseDC(HWND hwnd, HDC hdc, __GLXWinDrawable * draw);
+static void glxWinTexForget(__GLXWinDrawable * draw);
 
 static void glxWinCreateConfigs(HDC dc, glxWinScreen * screen);
 static void glxWinCreateConfigsExt(HDC hdc, glxWinScreen * screen,
@@ -469,13 +471,19 @@ glxWinScreenDestroy(__GLXscreen * screen)
 static int
 glxWinScreenSwapInterval(__GLXdrawable * drawable, int interval)
 {
-    BOOL ret = wglSwapIntervalEXTWrapper(interval);
+    __GLXWinDrawable *draw = (__GLXWinDrawable *) drawable;
 
-    if (!ret) {
-        ErrorF("wglSwapIntervalEXT interval %d failed:%s\n", interval,
-               glxWinErrorMessage());
-    }
-    return ret;
+    /*
+      The driver is always asked for an interval of 0 so SwapBuffers()
+      doesn't block the server waiting for vblank; the requested interval is
+      enforced by holding off the swapping client instead (see
+      glxWinDrawableSwapBuffers())
+    */
+    if (draw == NULL)
+        return FALSE;
+
+    draw->swapInterval = interval;
+    return TRUE;
 }
 
 /*
@@ -523,6 +531,202 @@ glxLogExtensions(const char *prefix, const char *extensions)
     free(str);
 }
 
+/*
+  Enumerating every pixel format takes a long time with some drivers, so the
+  resulting fbConfigs are cached in the temp directory, keyed by the renderer
+  and driver version strings, the screen depth and the WGL extensions.
+*/
+
+#define GLXWIN_CONFIG_CACHE_MAGIC	"XWin GLX fbConfig cache\n"
+#define GLXWIN_CONFIG_CACHE_VERSION	1
+
+typedef struct {
+    char magic[32];
+    int version;
+    int configSize;             /* sizeof(GLXWinConfig) of the writer */
+    char key[1024];
+    int numFBConfigs;
+    Bool has_WGL_ARB_pixel_format;
+    PixelFormatRejectStats rejects;
+} GLXWinConfigCacheHeader;
+
+static void
+glxWinConfigCachePath(ScreenPtr pScreen, char *path, size_t size)
+{
+    snprintf(path, size, "%s\\XWin.%d.glxconfigs", Win32TempDir(),
+             pScreen->myNum);
+}
+
+static void
+glxWinConfigCacheKey(HDC hdc, const char *wgl_extensions, char *key,
+                     size_t size)
+{
+    const char *vendor = (const char *) glGetStringWrapperNonstatic(GL_VENDOR);
+    const char *renderer = (const char *) glGetStringWrapperNonstatic(GL_RENDERER);
+    const char *version = (const char *) glGetStringWrapperNonstatic(GL_VERSION);
+    unsigned int hash = 2166136261u;
+    const char *p;
+
+    /* FNV-1a of the extension string, which decides the attributes queried */
+    for (p = wgl_extensions; *p; p++)
+        hash = (hash ^ (unsigned char) *p) * 16777619u;
+
+    memset(key, 0, size);
+    snprintf(key, size, "%s\n%s\n%s\n%d bpp\n%08x\n",
+             vendor ? vendor : "", renderer ? renderer : "",
+             version ? version : "", GetDeviceCaps(hdc, BITSPIXEL), hash);
+}
+
+static Bool
+glxWinLoadConfigCache(ScreenPtr pScreen, const char *key,
+                      glxWinScreen * screen, PixelFormatRejectStats * rejects)
+{
+    GLXWinConfigCacheHeader header;
+    GLXWinConfig *first = NULL, *prev = NULL;
+    char path[MAX_PATH];
+    FILE *f;
+    int i;
+
+    glxWinConfigCachePath(pScreen, path, sizeof(path));
+    f = fopen(path, "rb");
+    if (!f)
+        return FALSE;
+
+    if (fread(&header, sizeof(header), 1, f) != 1
+        || memcmp(header.magic, GLXWIN_CONFIG_CACHE_MAGIC,
+                  sizeof(GLXWIN_CONFIG_CACHE_MAGIC)) != 0
+        || header.version != GLXWIN_CONFIG_CACHE_VERSION
+        || header.configSize != sizeof(GLXWinConfig)
+        || strncmp(header.key, key, sizeof(header.key)) != 0
+        || header.numFBConfigs <= 0) {
+        fclose(f);
+        return FALSE;
+    }
+
+    for (i = 0; i < header.numFBConfigs; i++) {
+        GLXWinConfig *work = malloc(sizeof(GLXWinConfig));
+
+        if (!work || fread(work, sizeof(GLXWinConfig), 1, f) != 1) {
+            ErrorF("glxWinLoadConfigCache: %s is truncated\n", path);
+            free(work);
+            break;
+        }
+        work->base.next = NULL;
+
+        if (!first)
+            first = work;
+        if (prev)
+            prev->base.next = &(work->base);
+        prev = work;
+    }
+    fclose(f);
+
+    /* Discard partial results */
+    if (i < header.numFBConfigs) {
+        while (first) {
+            GLXWinConfig *next = (GLXWinConfig *) first->base.next;
+
+            free(first);
+            first = next;
+        }
+        return FALSE;
+    }
+
+    screen->base.numFBConfigs = header.numFBConfigs;
+    screen->base.fbconfigs = &(first->base);
+    screen->has_WGL_ARB_pixel_format = header.has_WGL_ARB_pixel_format;
+    *rejects = header.rejects;
+
+    LogMessage(X_INFO, "AIGLX: Loaded %d fbConfigs from %s\n",
+               header.numFBConfigs, path);
+    return TRUE;
+}
+
+static void
+glxWinSaveConfigCache(ScreenPtr pScreen, const char *key,
+                      glxWinScreen * screen, PixelFormatRejectStats * rejects)
+{
+    GLXWinConfigCacheHeader header;
+    __GLXconfig *c;
+    char path[MAX_PATH];
+    FILE *f;
+
+    glxWinConfigCachePath(pScreen, path, sizeof(path));
+    f = fopen(path, "wb");
+    if (!f) {
+        ErrorF("glxWinSaveConfigCache: Couldn't create %s\n", path);
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GLXWIN_CONFIG_CACHE_MAGIC,
+           sizeof(GLXWIN_CONFIG_CACHE_MAGIC));
+    header.version = GLXWIN_CONFIG_CACHE_VERSION;
+    header.configSize = sizeof(GLXWinConfig);
+    strncpy(header.key, key, sizeof(header.key) - 1);
+    header.numFBConfigs = screen->base.numFBConfigs;
+    header.has_WGL_ARB_pixel_format = screen->has_WGL_ARB_pixel_format;
+    header.rejects = *rejects;
+
+    if (fwrite(&header, sizeof(header), 1, f) != 1)
+        goto error;
+
+    for (c = screen->base.fbconfigs; c != NULL; c = c->next)
+        if (fwrite(c, sizeof(GLXWinConfig), 1, f) != 1)
+            goto error;
+
+    fclose(f);
+    return;
+
+ error:
+    ErrorF("glxWinSaveConfigCache: Couldn't write %s\n", path);
+    fclose(f);
+    remove(path);
+}
+
+/*
+ * Load and initialise the OpenGL driver on a scratch window and throw the
+ * context away again.  Run from winStartupPrefetch()'s thread, so the
+ * driver is already loaded when glxWinScreenProbe() needs it.  It uses
+ * the predefined STATIC class so it doesn't race the probe registering
+ * WIN_GL_WINDOW_CLASS.
+ */
+void
+glxWinWarmDriver(void)
+{
+    PIXELFORMATDESCRIPTOR pfd = {
+        sizeof(PIXELFORMATDESCRIPTOR), 1,
+        PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
+        PFD_TYPE_RGBA, 24,
+    };
+    HWND hwnd;
+    HDC hdc;
+    HGLRC hglrc;
+    int iPixelFormat;
+
+    hwnd = CreateWindowExA(0, "STATIC", "XWin GL Driver Prefetch Window",
+                           0, 0, 0, 0, 0, NULL, NULL, g_hInstance, NULL);
+    if (!hwnd)
+        return;
+
+    hdc = GetDC(hwnd);
+    if (hdc) {
+        iPixelFormat = ChoosePixelFormat(hdc, &pfd);
+        if (iPixelFormat && SetPixelFormat(hdc, iPixelFormat, &pfd)) {
+            hglrc = wglCreateContext(hdc);
+            if (hglrc) {
+                if (wglMakeCurrent(hdc, hglrc)) {
+                    glGetStringWrapperNonstatic(GL_RENDERER);
+                    wglMakeCurrent(NULL, NULL);
+                }
+                wglDeleteContext(hglrc);
+            }
+        }
+        ReleaseDC(hwnd, hdc);
+    }
+    DestroyWindow(hwnd);
+}
+
 /* This is called by GlxExtensionInit() asking the GLX provider if it can handle the screen... */
 static __GLXscreen *
 glxWinScreenProbe(ScreenPtr pScreen)
@@ -535,6 +739,8 @@ glxWinScreenProbe(ScreenPtr pScreen)
     HDC hdc;
     HGLRC hglrc;
     PixelFormatRejectStats rejects;
+    char cacheKey[1024];
+    Bool fCachedConfigs;
 
     GLWIN_DEBUG_MSG("glxWinScreenProbe");
 
@@ -545,6 +751,9 @@ glxWinScreenProbe(ScreenPtr pScreen)
     if (pScreen == NULL)
         return NULL;
 
+    /* the prefetch thread may still be initialising the driver */
+    winStartupWait();
+
     if (!winCheckScreenAiglxIsSupported(pScreen)) {
         LogMessage(X_ERROR,
                    "AIGLX: No native OpenGL in modes with a root window\n");
@@ -683,8 +892,6 @@ glxWinScreenProbe(ScreenPtr pScreen)
             { "WGL_ARB_make_current_read", "GLX_SGI_make_current_read", 1 },
             { "WGL_EXT_swap_control", "GLX_SGI_swap_control", 0 },
             { "WGL_EXT_swap_control", "GLX_MESA_swap_control", 0 },
-            //      { "WGL_ARB_render_texture", "GLX_EXT_texture_from_pixmap", 0 },
-            // Sufficiently different that it's not obvious if this can be done...
             { "WGL_ARB_pbuffer", "GLX_SGIX_pbuffer", 1 },
             { "WGL_ARB_multisample", "GLX_ARB_multisample", 1 },
             { "WGL_ARB_multisample", "GLX_SGIS_multisample", 0 },
@@ -694,6 +901,7 @@ glxWinScreenProbe(ScreenPtr pScreen)
             { "WGL_ARB_create_context_profile", "GLX_ARB_create_context_profile", 0 },
             { "WGL_ARB_create_context_robustness", "GLX_ARB_create_context_robustness", 0 },
             { "WGL_EXT_create_context_es2_profile", "GLX_EXT_create_context_es2_profile", 0 },
+            { "WGL_ARB_create_context_no_error", "GLX_ARB_create_context_no_error", 0 },
             { "WGL_ARB_framebuffer_sRGB", "GLX_ARB_framebuffer_sRGB", 0 },
         };
 
@@ -707,6 +915,7 @@ glxWinScreenProbe(ScreenPtr pScreen)
         __glXEnableExtension(screen->base.glx_enable_bits, "GLX_EXT_import_context");
         __glXEnableExtension(screen->base.glx_enable_bits, "GLX_OML_swap_method");
         __glXEnableExtension(screen->base.glx_enable_bits, "GLX_SGIX_fbconfig");
+        __glXEnableExtension(screen->base.glx_enable_bits, "GLX_EXT_texture_from_pixmap");
 
         for (i = 0; i < sizeof(extensionMap)/sizeof(extensionMap[0]); i++) {
             if (strstr(wgl_extensions, extensionMap[i].wglext)) {
@@ -735,10 +944,30 @@ glxWinScreenProbe(ScreenPtr pScreen)
         if (strstr(wgl_extensions, "WGL_ARB_multisample"))
             screen->has_WGL_ARB_multisample = TRUE;
 
+        if (strstr(wgl_extensions, "WGL_ARB_create_context_no_error"))
+            screen->has_WGL_ARB_create_context_no_error = TRUE;
+
         if (strstr(wgl_extensions, "WGL_ARB_framebuffer_sRGB")) {
             screen->has_WGL_ARB_framebuffer_sRGB = TRUE;
         }
 
+        if (strstr(wgl_extensions, "WGL_EXT_swap_control")) {
+            screen->has_WGL_EXT_swap_control = TRUE;
+
+            /* Swap completion is known to the server once it paces swaps */
+            __glXEnableExtension(screen->base.glx_enable_bits,
+                                 "GLX_INTEL_swap_event");
+        }
+
+        {
+            int refresh = GetDeviceCaps(hdc, VREFRESH);
+
+            /* 0 and 1 mean the hardware default refresh rate */
+            if (refresh <= 1)
+                refresh = 60;
+            screen->refreshPeriod = 1000000 / refresh;
+        }
+
         screen->base.destroy = glxWinScreenDestroy;
         screen->base.createContext = glxWinCreateContext;
         screen->base.createDrawable = glxWinCreateDrawable;
@@ -747,7 +976,13 @@ glxWinScreenProbe(ScreenPtr pScreen)
 
         // Creating the fbConfigs initializes screen->base.fbconfigs and screen->base.numFBConfigs
         memset(&rejects, 0, sizeof(rejects));
-        if (strstr(wgl_extensions, "WGL_ARB_pixel_format")) {
+        glxWinConfigCacheKey(hdc, wgl_extensions, cacheKey, sizeof(cacheKey));
+        fCachedConfigs = glxWinLoadConfigCache(pScreen, cacheKey, screen,
+                                               &rejects);
+        if (fCachedConfigs) {
+            /* Nothing left to enumerate */
+        }
+        else if (strstr(wgl_extensions, "WGL_ARB_pixel_format")) {
             glxWinCreateConfigsExt(hdc, screen, &rejects);
 
             /*
@@ -766,6 +1001,9 @@ glxWinScreenProbe(ScreenPtr pScreen)
             screen->has_WGL_ARB_pixel_format = FALSE;
         }
 
+        if (!fCachedConfigs && screen->base.numFBConfigs > 0)
+            glxWinSaveConfigCache(pScreen, cacheKey, screen, &rejects);
+
         /*
            If we still didn't get any fbConfigs, we can't provide GLX for this screen
          */
@@ -807,6 +1045,7 @@ glxWinScreenProbe(ScreenPtr pScreen)
     // Note that WGL is active on this screen
     winSetScreenAiglxIsActive(pScreen);
 
+    winStartupMark("GLX probe");
     return &screen->base;
 
  error:
@@ -940,15 +1179,22 @@ glxWinDestroyWindow(WindowPtr pWin)
     {
       if (pGlxDraw->drawContext->hwnd!=pWinPriv->hWnd)
         ErrorF("Wrong assumption\n");
+      /* The context may still be bound to the DC we are about to release */
+      if (wglGetCurrentDC() == pGlxDraw->drawContext->hDC)
+        wglMakeCurrent(NULL, NULL);
       glxWinReleaseDC(pGlxDraw->drawContext->hwnd, pGlxDraw->drawContext->hDC, pGlxDraw);
       pGlxDraw->drawContext->hDC=NULL;
       pGlxDraw->drawContext->hwnd=NULL;
     }
     if (pWinPriv->fWglUsed && pWinPriv->hWnd)
     {
+      /* Don't leave a context bound to the DC of a destroyed window */
+      if (WindowFromDC(wglGetCurrentDC()) == pWinPriv->hWnd)
+        wglMakeCurrent(NULL, NULL);
       DestroyWindow(pWinPriv->hWnd);
       pWinPriv->hWnd=NULL;
       pWinPriv->fWglUsed=0;
+      pWinPriv->OpenGlWindow=FALSE;
     }
 
     pScreen->DestroyWindow = screenPriv->DestroyWindow;
@@ -963,11 +1209,61 @@ glxWinDestroyWindow(WindowPtr pWin)
  * Drawable functions
  */
 
+static void
+glxWinReleaseSwapClient(__GLXWinDrawable *draw)
+{
+    /* The client may have gone away while it was held off */
+    if (draw->swapClient
+        && clients[draw->swapClientIndex] == draw->swapClient)
+        AttendClient(draw->swapClient);
+    draw->swapClient = NULL;
+}
+
+static CARD32
+glxWinSwapTimerCallback(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    __GLXWinDrawable *draw = arg;
+
+    glxWinReleaseSwapClient(draw);
+    return 0;
+}
+
+/*
+  Hold off the client until the next swap is due according to the swap
+  interval, so it is throttled the way a vsync'ed SwapBuffers() would but
+  without stalling every other client in the meantime
+*/
+static void
+glxWinThrottleSwap(ClientPtr client, __GLXWinDrawable *draw)
+{
+    glxWinScreen *screen = (glxWinScreen *) draw->base.pGlxScreen;
+    CARD64 now = GetTimeInMicros();
+    CARD64 period = screen->refreshPeriod * draw->swapInterval;
+
+    /* Start over if the client fell behind by more than a frame */
+    if (draw->nextSwap + period < now)
+        draw->nextSwap = now;
+    draw->nextSwap += period;
+
+    if (draw->nextSwap <= now || client == NULL || draw->swapClient)
+        return;
+
+    draw->swapTimer = TimerSet(draw->swapTimer, 0,
+                               (CARD32) ((draw->nextSwap - now + 999) / 1000),
+                               glxWinSwapTimerCallback, draw);
+    if (draw->swapTimer) {
+        IgnoreClient(client);
+        draw->swapClient = client;
+        draw->swapClientIndex = client->index;
+    }
+}
+
 static GLboolean
 glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
 {
     BOOL ret;
     __GLXWinDrawable *draw = (__GLXWinDrawable *) base;
+    glxWinScreen *screen = (glxWinScreen *) base->pGlxScreen;
 
     /* Swap buffers on the last active context for drawing on the drawable */
     if (draw->drawContext == NULL) {
@@ -979,13 +1275,23 @@ glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
         ("glxWinSwapBuffers on drawable %p, last context %p (native ctx %p)",
          base, draw->drawContext, draw->drawContext->ctx);
 
+    WinTraceStart("GLXSwap", TraceLoggingPointer(base, "Drawable"));
     ret = SwapBuffers(draw->drawContext->hDC);
+    WinTraceStop("GLXSwap", TraceLoggingPointer(base, "Drawable"),
+                 TraceLoggingBoolean(ret, "Success"));
 
     if (!ret) {
         ErrorF("SwapBuffers failed: %s\n", glxWinErrorMessage());
         return GL_FALSE;
     }
 
+    draw->swapCount++;
+    __glXsendSwapEvent(base, GLX_BLIT_COMPLETE_INTEL, GetTimeInMicros(),
+                       draw->swapCount, draw->swapCount);
+
+    if (screen->has_WGL_EXT_swap_control && draw->swapInterval > 0)
+        glxWinThrottleSwap(client, draw);
+
     return GL_TRUE;
 }
 
@@ -1002,6 +1308,12 @@ glxWinDrawableDestroy(__GLXdrawable * base)
 {
     __GLXWinDrawable *glxPriv = (__GLXWinDrawable *) base;
 
+    /* Let a client held off by swap pacing go */
+    TimerFree(glxPriv->swapTimer);
+    glxWinReleaseSwapClient(glxPriv);
+
+    glxWinTexForget(glxPriv);
+
     if (glxPriv->hPbuffer)
         if (!wglDestroyPbufferARBWrapper(glxPriv->hPbuffer)) {
             ErrorF("wglDestroyPbufferARB failed: %s\n", glxWinErrorMessage());
@@ -1052,6 +1364,9 @@ glxWinCreateDrawable(ClientPtr client,
         return NULL;
     }
 
+    /* GLX_EXT_swap_control default */
+    glxPriv->swapInterval = 1;
+
     glxPriv->base.destroy = glxWinDrawableDestroy;
     glxPriv->base.swapBuffers = glxWinDrawableSwapBuffers;
     glxPriv->base.copySubBuffer = glxWinDrawableCopySubBuffer;
@@ -1244,13 +1559,203 @@ glxWinDeferredCreateDrawable(__GLXWinDrawable *draw, __GLXWinContext * gc)
  * Texture functions
  */
 
+/*
+ * Binding a pixmap copies it into the texture bound to the context, since
+ * WGL has no way to texture from memory GDI or fb draws into.  Damage on
+ * the pixmap tracks what changed after the copy, so binding the pixmap to
+ * the same texture again only copies that.
+ *
+ * Another pixmap copied into the same texture makes the next bind of this
+ * one copy everything again; so does a texture that has no image, which is
+ * what a texture deleted and created afresh under the same name looks
+ * like.  Anything else done to the texture between binds is undefined by
+ * the extension.
+ *
+ * GL drawing into a pixmap's DIB, by the server or by a direct rendering
+ * client sharing the section through WindowsDRI, makes no damage, so such
+ * pixmaps are copied whole every time.
+ */
+
+static __GLXWinDrawable *glxWinTexDrawables;
+
+static void
+glxWinTexDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    __GLXWinDrawable *draw = closure;
+
+    /* The pixmap is gone, and its damage with it */
+    draw->texDamage = NULL;
+}
+
+static void
+glxWinTexUnlink(__GLXWinDrawable * draw)
+{
+    __GLXWinDrawable **prev;
+
+    for (prev = &glxWinTexDrawables; *prev; prev = &(*prev)->texNext) {
+        if (*prev == draw) {
+            *prev = draw->texNext;
+            break;
+        }
+    }
+    draw->texNext = NULL;
+}
+
+static void
+glxWinTexForget(__GLXWinDrawable * draw)
+{
+    glxWinTexUnlink(draw);
+    draw->texContext = NULL;
+
+    if (draw->texDamage) {
+        DamagePtr pDamage = draw->texDamage;
+
+        draw->texDamage = NULL;
+        DamageDestroy(pDamage);
+    }
+}
+
+/* What's in the texture now is draw's pixmap, and nothing else's */
+static void
+glxWinTexLoaded(__GLXWinDrawable * draw, HGLRC ctx, GLuint name,
+                GLenum target)
+{
+    __GLXWinDrawable *other;
+
+    for (other = glxWinTexDrawables; other; other = other->texNext) {
+        if (other != draw && other->texContext == ctx &&
+            other->texName == name && other->texTarget == target)
+            other->texContext = NULL;
+    }
+
+    draw->texContext = ctx;
+    draw->texName = name;
+    draw->texTarget = target;
+}
+
 static
     int
 glxWinBindTexImage(__GLXcontext * baseContext,
                    int buffer, __GLXdrawable * pixmap)
 {
-    ErrorF("glxWinBindTexImage: not implemented\n");
-    return FALSE;
+    __GLXWinContext *gc = (__GLXWinContext *) baseContext;
+    __GLXWinDrawable *draw = (__GLXWinDrawable *) pixmap;
+    PixmapPtr pPixmap = (PixmapPtr) pixmap->pDraw;
+    GLint texName, texWidth;
+    GLint rowLength, skipPixels, skipRows, alignment;
+    GLenum format, type, internalFormat;
+    RegionPtr pRegion = NULL;
+    int bpp;
+
+    if (pixmap->target != GL_TEXTURE_2D &&
+        pixmap->target != GL_TEXTURE_RECTANGLE_ARB)
+        return BadMatch;
+
+    switch (pPixmap->drawable.depth) {
+    case 24:
+    case 32:
+        bpp = 4;
+        format = GL_BGRA;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    case 16:
+        bpp = 2;
+        format = GL_RGB;
+        type = GL_UNSIGNED_SHORT_5_6_5;
+        break;
+    case 15:
+        bpp = 2;
+        format = GL_BGRA;
+        type = GL_UNSIGNED_SHORT_1_5_5_5_REV;
+        break;
+    default:
+        return BadMatch;
+    }
+
+    /* Only a depth 32 pixmap has an alpha channel to give */
+    if (pixmap->format == GLX_TEXTURE_FORMAT_RGBA_EXT &&
+        pPixmap->drawable.depth == 32)
+        internalFormat = GL_RGBA;
+    else
+        internalFormat = GL_RGB;
+
+    glGetIntegervWrapperNonstatic(pixmap->target == GL_TEXTURE_2D ?
+                                  GL_TEXTURE_BINDING_2D :
+                                  GL_TEXTURE_BINDING_RECTANGLE_ARB, &texName);
+    if (!texName)
+        return __glXError(GLXBadContextState);
+
+    if (!draw->texDamage) {
+        draw->texDamage = DamageCreate(NULL, glxWinTexDamageDestroy,
+                                       DamageReportNone, TRUE,
+                                       pPixmap->drawable.pScreen, draw);
+        if (!draw->texDamage)
+            return BadAlloc;
+        DamageRegister(&pPixmap->drawable, draw->texDamage);
+        draw->texContext = NULL;
+
+        glxWinTexUnlink(draw);
+        draw->texNext = glxWinTexDrawables;
+        glxWinTexDrawables = draw;
+    }
+    else if (!draw->dibDC && draw->texContext == gc->ctx &&
+             draw->texName == (GLuint) texName &&
+             draw->texTarget == pixmap->target) {
+        glGetTexLevelParameterivWrapperNonstatic(pixmap->target, 0,
+                                                 GL_TEXTURE_WIDTH, &texWidth);
+        if (texWidth == pPixmap->drawable.width) {
+            pRegion = DamageRegion(draw->texDamage);
+            if (!RegionNotEmpty(pRegion))
+                return Success;
+        }
+    }
+
+    /* GL may have drawn into the pixmap through its DIB */
+    if (draw->dibDC)
+        GdiFlush();
+
+    /* The unpack state belongs to the client's rendering, keep it */
+    glGetIntegervWrapperNonstatic(GL_UNPACK_ROW_LENGTH, &rowLength);
+    glGetIntegervWrapperNonstatic(GL_UNPACK_SKIP_PIXELS, &skipPixels);
+    glGetIntegervWrapperNonstatic(GL_UNPACK_SKIP_ROWS, &skipRows);
+    glGetIntegervWrapperNonstatic(GL_UNPACK_ALIGNMENT, &alignment);
+
+    glPixelStoreiWrapperNonstatic(GL_UNPACK_ROW_LENGTH,
+                                  pPixmap->devKind / bpp);
+    glPixelStoreiWrapperNonstatic(GL_UNPACK_ALIGNMENT, 4);
+
+    if (!pRegion) {
+        glPixelStoreiWrapperNonstatic(GL_UNPACK_SKIP_PIXELS, 0);
+        glPixelStoreiWrapperNonstatic(GL_UNPACK_SKIP_ROWS, 0);
+        glTexImage2DWrapperNonstatic(pixmap->target, 0, internalFormat,
+                                     pPixmap->drawable.width,
+                                     pPixmap->drawable.height, 0,
+                                     format, type, pPixmap->devPrivate.ptr);
+        glxWinTexLoaded(draw, gc->ctx, texName, pixmap->target);
+    }
+    else {
+        BoxPtr pBox = RegionRects(pRegion);
+        int i;
+
+        for (i = 0; i < RegionNumRects(pRegion); i++, pBox++) {
+            glPixelStoreiWrapperNonstatic(GL_UNPACK_SKIP_PIXELS, pBox->x1);
+            glPixelStoreiWrapperNonstatic(GL_UNPACK_SKIP_ROWS, pBox->y1);
+            glTexSubImage2DWrapperNonstatic(pixmap->target, 0,
+                                            pBox->x1, pBox->y1,
+                                            pBox->x2 - pBox->x1,
+                                            pBox->y2 - pBox->y1,
+                                            format, type,
+                                            pPixmap->devPrivate.ptr);
+        }
+    }
+    DamageEmpty(draw->texDamage);
+
+    glPixelStoreiWrapperNonstatic(GL_UNPACK_ROW_LENGTH, rowLength);
+    glPixelStoreiWrapperNonstatic(GL_UNPACK_SKIP_PIXELS, skipPixels);
+    glPixelStoreiWrapperNonstatic(GL_UNPACK_SKIP_ROWS, skipRows);
+    glPixelStoreiWrapperNonstatic(GL_UNPACK_ALIGNMENT, alignment);
+
+    return Success;
 }
 
 static
@@ -1258,8 +1763,8 @@ static
 glxWinReleaseTexImage(__GLXcontext * baseContext,
                       int buffer, __GLXdrawable * pixmap)
 {
-    ErrorF(" glxWinReleaseTexImage: not implemented\n");
-    return FALSE;
+    /* The texture holds a copy, there is nothing to give back */
+    return Success;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -1396,6 +1901,31 @@ glxWinSetPixelFormat(__GLXWinContext * gc, HDC hdc, int bppOverride,
     return TRUE;
 }
 
+/*
+ * Create the native context for gc on hdc.  A context which asked for
+ * GLX_CONTEXT_OPENGL_NO_ERROR_ARB gets a no-error WGL context, so the
+ * driver can skip its per-call error checking.
+ */
+static HGLRC
+glxWinCreateNativeContext(__GLXWinContext *gc, HDC hdc)
+{
+    if (gc->noError) {
+        static const int attribs[] = {
+            WGL_CONTEXT_OPENGL_NO_ERROR_ARB, GL_TRUE,
+            0
+        };
+        HGLRC ctx = wglCreateContextAttribsARBWrapper(hdc, NULL, attribs);
+
+        if (ctx != NULL)
+            return ctx;
+
+        ErrorF("wglCreateContextAttribsARB error: %s, retrying without no-error\n",
+               glxWinErrorMessage());
+    }
+
+    return wglCreateContext(hdc);
+}
+
 static HDC
 glxWinMakeDC(__GLXWinContext *gc, __GLXWinDrawable *draw, HWND *hwnd)
 {
@@ -1436,7 +1966,9 @@ glxWinMakeDC(__GLXWinContext *gc, __GLXWinDrawable *draw, HWND *hwnd)
 
             glxWinSetPixelFormat(gc, hdc, 0, GLX_WINDOW_BIT);
             pWinPriv->OpenGlWindow=TRUE; /* Identify it as an opengl window, also used to check if the pixel format is already set */
-            gc->ctx = wglCreateContext(hdc);
+            /* A DC obtained again for a recreated HWND keeps the existing native context */
+            if (gc->ctx == NULL)
+                gc->ctx = glxWinCreateNativeContext(gc, hdc);
         }
 
 #ifdef _DEBUG
@@ -1461,7 +1993,7 @@ glxWinMakeDC(__GLXWinContext *gc, __GLXWinDrawable *draw, HWND *hwnd)
         if (hdc == NULL)
             ErrorF("GetDC (pbuffer) error: %s\n", glxWinErrorMessage());
 
-        gc->ctx = wglCreateContext(hdc);
+        gc->ctx = glxWinCreateNativeContext(gc, hdc);
     }
         break;
 
@@ -1564,6 +2096,49 @@ glxWinDeferredCreateContext(__GLXWinContext * gc, __GLXWinDrawable * draw)
     }
 }
 
+/*
+ * Check that the HWND the context's DC was obtained from is still the one
+ * backing the window drawable.  Reparenting a top-level window or unmapping
+ * it destroys its HWND, and with it the DC we are holding.
+ */
+static Bool
+glxWinContextHWNDValid(__GLXWinContext * gc, __GLXWinDrawable * draw)
+{
+    WindowPtr pWin = (WindowPtr) draw->base.pDraw;
+    HWND hwnd;
+
+    if (pWin == NULL)
+        return FALSE;
+
+    {
+        winWindowPriv(pWin);
+        hwnd = pWinPriv->hWnd;
+    }
+    if (hwnd == NULL)
+        hwnd = winGetScreenPriv(pWin->drawable.pScreen)->hwndScreen;
+
+    return gc->hwnd == hwnd;
+}
+
+/*
+ * Toolkits re-issue MakeCurrent for the same context and drawable all the
+ * time, and the GLX core loses the context before every bind.  Since we
+ * keep the native context bound across loseCurrent, we can skip the WGL
+ * calls entirely when it is still bound to our cached DC.
+ */
+static Bool
+glxWinContextIsBound(__GLXWinContext * gc, __GLXWinDrawable * draw)
+{
+    if (gc->hDC == NULL)
+        return FALSE;
+
+    if (draw->base.type == GLX_DRAWABLE_WINDOW &&
+        !glxWinContextHWNDValid(gc, draw))
+        return FALSE;
+
+    return wglGetCurrentContext() == gc->ctx && wglGetCurrentDC() == gc->hDC;
+}
+
 /* ---------------------------------------------------------------------- */
 /*
  * Context functions
@@ -1625,8 +2200,19 @@ glxWinContextMakeCurrent(__GLXcontext * base)
                    glxWinErrorMessage());
         }
     }
+    else if (glxWinContextIsBound(gc, drawPriv)) {
+        /* Still bound from the last time, nothing to do */
+        ret = TRUE;
+    }
     else {
         /* Otherwise, just use wglMakeCurrent */
+        if (gc->hDC && gc->hwnd && drawPriv->base.type == GLX_DRAWABLE_WINDOW &&
+            !glxWinContextHWNDValid(gc, drawPriv)) {
+            /* The HWND has been recreated, so the DC we hold is stale */
+            GLWIN_DEBUG_MSG("glxWinContextMakeCurrent: dropping stale DC %p for hwnd %p", gc->hDC, gc->hwnd);
+            ReleaseDC(gc->hwnd, gc->hDC);
+            gc->hDC = NULL;
+        }
         if (!gc->hDC) {
             /* It probably has been release by loseCurrent, so create it again */
             gc->hDC = glxWinMakeDC(gc, drawPriv, &gc->hwnd);
@@ -1647,6 +2233,14 @@ glxWinContextMakeCurrent(__GLXcontext * base)
     if (!ret)
       drawPriv->drawContext = NULL; /* clear last active context because we return error */
 
+    /* Make sure the driver doesn't wait for vblank in SwapBuffers() */
+    if (ret && scr->has_WGL_EXT_swap_control && !drawPriv->swapIntervalSet) {
+        if (!wglSwapIntervalEXTWrapper(0))
+            ErrorF("wglSwapIntervalEXT interval 0 failed:%s\n",
+                   glxWinErrorMessage());
+        drawPriv->swapIntervalSet = TRUE;
+    }
+
     return ret;
 }
 
@@ -1665,17 +2259,16 @@ glxWinContextLoseCurrent(__GLXcontext * base)
      /* Clear the last active context in the drawable */
     if (drawPriv) drawPriv->drawContext = NULL;
 
-    if (wglGetCurrentContext()==gc->ctx)
-    {
-      /* Only do this when we are sure we are currently the active, otherwise we are deactivating the wrong one (this is happening!!!) */
-      ret = wglMakeCurrent(NULL, NULL);
-      if (!ret)
-        ErrorF("glxWinContextLoseCurrent error: %s\n", glxWinErrorMessage());
-    }
-    else
-    {
+    /*
+     * Only report success when we are sure we are currently the active one,
+     * otherwise we are deactivating the wrong one (this is happening!!!).
+     * The native context is left bound: nothing can reach it with the
+     * dispatch table cleared, and the next makeCurrent of this context,
+     * usually immediate, then needs no WGL call.  Binding another context
+     * unbinds it implicitly.
+     */
+    if (wglGetCurrentContext()!=gc->ctx)
       return FALSE;
-    }
 
     base->currentClient=NULL;  /* It looks like glx is not doing this */
     _glapi_set_dispatch(NULL);
@@ -1746,6 +2339,8 @@ glxWinCreateContext(__GLXscreen * screen,
 {
     __GLXWinContext *context;
     __GLXWinContext *shareContext = (__GLXWinContext *) baseShareContext;
+    glxWinScreen *winScreen = (glxWinScreen *) screen;
+    unsigned i;
 
     context = calloc(1, sizeof(*context));
 
@@ -1765,6 +2360,18 @@ glxWinCreateContext(__GLXscreen * screen,
     //context->ctx = NULL; already done by calloc
     context->shareContext = shareContext;
 
+    /*
+     * Honour GLX_CONTEXT_OPENGL_NO_ERROR_ARB, unless debug or trace output
+     * has been asked for, in which case GL errors are still wanted
+     */
+    for (i = 0; i < num_attribs; i++) {
+        if (attribs[2 * i] == GLX_CONTEXT_OPENGL_NO_ERROR_ARB)
+            context->noError = attribs[2 * i + 1] != 0;
+    }
+    if (!winScreen->has_WGL_ARB_create_context_no_error ||
+        glxWinDebugSettings.enableDebug || glxWinDebugSettings.enableTrace)
+        context->noError = FALSE;
+
     context->Dispatch=calloc(sizeof(void*), (sizeof(struct _glapi_table) / sizeof(void *) + MAX_EXTENSION_FUNCS));
     _glapi_set_dispatch(context->Dispatch);
 
@@ -2186,12 +2793,21 @@ glxWinCreateConfigs(HDC hdc, glxWinScreen * screen)
         else
             c->base.swapMethod = GLX_SWAP_UNDEFINED_OML;
 
-        /* EXT_texture_from_pixmap */
-        c->base.bindToTextureRgb = -1;
-        c->base.bindToTextureRgba = -1;
+        /* EXT_texture_from_pixmap, see glxWinBindTexImage() */
+        if (c->base.drawableType & GLX_PIXMAP_BIT) {
+            c->base.bindToTextureRgb = TRUE;
+            c->base.bindToTextureRgba = TRUE;
+            c->base.bindToTextureTargets =
+                GLX_TEXTURE_2D_BIT_EXT | GLX_TEXTURE_RECTANGLE_BIT_EXT;
+            c->base.yInverted = TRUE;
+        }
+        else {
+            c->base.bindToTextureRgb = -1;
+            c->base.bindToTextureRgba = -1;
+            c->base.bindToTextureTargets = -1;
+            c->base.yInverted = -1;
+        }
         c->base.bindToMipmapTexture = -1;
-        c->base.bindToTextureTargets = -1;
-        c->base.yInverted = -1;
         c->base.sRGBCapable = 0;
 
         n++;
@@ -2589,7 +3205,12 @@ glxWinCreateConfigsExt(HDC hdc, glxWinScreen * screen, PixelFormatRejectStats *
            bindToTextureRgb/bindToTextureRgba to FALSE means that swrast can't find any fbConfigs to use,
            so setting these to 0, even if we know bindToTexture isn't available, isn't a good idea...
          */
-        if (screen->has_WGL_ARB_render_texture) {
+        if (c->base.drawableType & GLX_PIXMAP_BIT) {
+            /* glxWinBindTexImage() copies pixmaps of any format */
+            c->base.bindToTextureRgb = TRUE;
+            c->base.bindToTextureRgba = TRUE;
+        }
+        else if (screen->has_WGL_ARB_render_texture) {
             c->base.bindToTextureRgb =
                 ATTR_VALUE(WGL_BIND_TO_TEXTURE_RGB_ARB, -1);
             c->base.bindToTextureRgba =
@@ -2603,7 +3224,8 @@ glxWinCreateConfigsExt(HDC hdc, glxWinScreen * screen, PixelFormatRejectStats *
         c->base.bindToTextureTargets =
             GLX_TEXTURE_1D_BIT_EXT | GLX_TEXTURE_2D_BIT_EXT |
             GLX_TEXTURE_RECTANGLE_BIT_EXT;
-        c->base.yInverted = -1;
+        /* pixmaps are copied top row first */
+        c->base.yInverted = (c->base.drawableType & GLX_PIXMAP_BIT) ? TRUE : -1;
 
         /* WGL_ARB_framebuffer_sRGB */
         if (screen->has_WGL_ARB_framebuffer_sRGB)
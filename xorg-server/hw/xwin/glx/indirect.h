@@ -27,6 +27,7 @@
 #include <X11/Xwindows.h>
 #include <wglext.h>
 #include <glx/extension_string.h>
+#include "damage.h"
 
 /* ---------------------------------------------------------------------- */
 /*
@@ -49,6 +50,7 @@ struct __GLXWinContext {
     HWND hreadwnd;
     struct _glapi_table *Dispatch;
 
+    Bool noError;               /* Create the native context with WGL_CONTEXT_OPENGL_NO_ERROR_ARB */
 };
 
 struct __GLXWinDrawable {
@@ -65,6 +67,22 @@ struct __GLXWinDrawable {
     HBITMAP hDIB;
     HBITMAP hOldDIB;            /* original DIB for DC */
     void *pOldBits;             /* original pBits for this drawable's pixmap */
+
+    /* If this pixmap has been bound with glXBindTexImageEXT */
+    DamagePtr texDamage;        /* changes since the texture was loaded */
+    HGLRC texContext;           /* the texture last loaded... */
+    GLuint texName;
+    GLenum texTarget;
+    __GLXWinDrawable *texNext;  /* list of bound pixmaps */
+
+    /* Swap interval pacing, done by the server rather than the driver */
+    int swapInterval;           /* requested GLX swap interval */
+    Bool swapIntervalSet;       /* driver swap interval set to 0 */
+    CARD64 nextSwap;            /* earliest next swap, in microseconds */
+    CARD32 swapCount;
+    OsTimerPtr swapTimer;
+    ClientPtr swapClient;       /* client ignored until the timer fires */
+    int swapClientIndex;
 };
 
 struct __GLXWinScreen {
@@ -76,6 +94,10 @@ struct __GLXWinScreen {
     Bool has_WGL_ARB_render_texture;
     Bool has_WGL_ARB_make_current_read;
     Bool has_WGL_ARB_framebuffer_sRGB;
+    Bool has_WGL_EXT_swap_control;
+    Bool has_WGL_ARB_create_context_no_error;
+
+    CARD64 refreshPeriod;       /* in microseconds */
 
     /* wrapped screen functions */
     RealizeWindowProcPtr RealizeWindow;
@@ -80,4 +80,7 @@ BOOL __stdcall wglSwapIntervalEXTWrapper(int interval);
 
 int __stdcall wglGetSwapIntervalEXTWrapper(void);
 
+HGLRC __stdcall wglCreateContextAttribsARBWrapper(HDC hDC, HGLRC hShareContext,
+                                                  const int *attribList);
+
 #endif                          /* wgl_ext_api_h */
@@ -57,6 +57,11 @@
 #define WIN_DEFAULT_WIN_KILL			TRUE
 #define WIN_DEFAULT_UNIX_KILL			FALSE
 #define WIN_DEFAULT_CLIP_UPDATES_NBOXES		0
+
+/*
+ * Fixed cost of a blit call, in pixels copied, used when merging damage
+ */
+#define WIN_BLT_BOX_COST			4096
 #ifdef XWIN_EMULATEPSEUDO
 #define WIN_DEFAULT_EMULATE_PSEUDO		FALSE
 #endif
@@ -97,6 +102,7 @@
 #define WIN_SERVER_NONE		0x0L    /* 0 */
 #define WIN_SERVER_SHADOW_GDI	0x1L    /* 1 */
 #define WIN_SERVER_SHADOW_DDNL	0x4L    /* 4 */
+#define WIN_SERVER_SHADOW_DXGI	0x8L    /* 8 */
 
 #define AltMapIndex		Mod1MapIndex
 #define NumLockMapIndex		Mod2MapIndex
@@ -267,6 +273,23 @@ typedef struct {
     BOOL owned;
 } winPrivPixmapRec, *winPrivPixmapPtr;
 
+/*
+ * Released pixmap DIBs kept for reuse in multiwindow composite mode
+ */
+
+#define WIN_DIB_CACHE_SIZE		16
+#define WIN_DIB_CACHE_MAX_BYTES		(16 * 1024 * 1024)
+
+typedef struct {
+    HBITMAP hBitmap;
+    void *pbBits;
+    BITMAPINFOHEADER *pbmih;
+    int iWidth;
+    int iHeight;
+    int iBpp;
+    DWORD dwSize;
+} winCachedDIBRec;
+
 /*
  * Colormap privates
  */
@@ -291,7 +314,6 @@ typedef struct {
     BOOL visible;
     HCURSOR handle;
     QueryBestSizeProcPtr QueryBestSize;
-    miPointerSpriteFuncPtr spriteFuncs;
 } winCursorRec;
 
 /*
@@ -348,6 +370,7 @@ typedef struct {
     DWORD dwEngine;
     DWORD dwEnginePreferred;
     DWORD dwClipUpdatesNBoxes;
+    Bool fSkipUnchanged;
 #ifdef XWIN_EMULATEPSEUDO
     Bool fEmulatePseudo;
 #endif
@@ -375,6 +398,22 @@ typedef struct {
     HICON hIconSm;
 } winScreenInfo, *winScreenInfoPtr;
 
+/*
+ * Shadow update statistics since the last winEngineStatsReport()
+ */
+
+#define WIN_UPDATE_BUCKETS 24   /* up to 2^23 us, about 8 s */
+
+typedef struct {
+    unsigned long updates;
+    unsigned long multiBoxUpdates;
+    unsigned long long boxes;
+    unsigned long long pixels;
+    unsigned long long time;    /* microseconds */
+    unsigned long long max;
+    CARD32 hist[WIN_UPDATE_BUCKETS];    /* hist[i]: took less than 2^i us */
+} winUpdateStatsRec;
+
 /*
  * Screen privates
  */
@@ -421,6 +460,22 @@ typedef struct _winPrivScreenRec {
     HWND hwndScreen;
     BITMAPINFOHEADER *pbmih;
 
+    /* Multiwindow paint scheduling used by shadow fb GDI engine */
+    Bool fPaintPending;
+    DWORD dwPaintInterval;
+    DWORD dwLastPaintFlush;
+
+    /* Shadow fb tile checksums used by -skipunchanged */
+    CARD64 *pTileSums;
+    int iTileCols;
+    int iTileRows;
+    char *pTileSumsFB;
+
+    /* Pixmap DIB cache used by multiwindow composite mode */
+    winCachedDIBRec aDIBCache[WIN_DIB_CACHE_SIZE];
+    int iDIBCacheCount;
+    DWORD dwDIBCacheBytes;
+
     /* Privates used by shadow fb DirectDraw Nonlocking engine */
     LPDIRECTDRAW pdd;
     LPDIRECTDRAW4 pdd4;
@@ -429,6 +484,15 @@ typedef struct _winPrivScreenRec {
     LPDIRECTDRAWCLIPPER pddcPrimary;
     BOOL fRetryCreateSurface;
 
+    /* Privates used by shadow fb DXGI flip-model engine */
+    struct ID3D11Device *pd3dDevice;
+    struct ID3D11DeviceContext *pd3dContext;
+    struct IDXGISwapChain1 *pdxgiSwapChain;
+    struct ID3D11Texture2D *pd3dBackBuffer;
+    RegionRec rgnDXGIStale;
+    RECT *prcDXGIDirty;
+    DWORD dwDXGIDirtyMax;
+
     /* Privates used by multi-window */
     pthread_t ptWMProc;
     pthread_t ptXMsgProc;
@@ -462,6 +526,11 @@ typedef struct _winPrivScreenRec {
     winReleasePrimarySurfaceProcPtr pwinReleasePrimarySurface;
     winCreateScreenResourcesProc pwinCreateScreenResources;
 
+    /* Shadow update statistics, and frame timing for -shadowlog */
+    winUpdateStatsRec updateStats;
+    DamagePtr pShadowLogDamage;
+    LARGE_INTEGER liShadowLogDamaged;
+
     /* Window Procedures for Rootless mode */
     CreateWindowProcPtr CreateWindow;
     DestroyWindowProcPtr DestroyWindow;
@@ -486,11 +555,6 @@ typedef struct _winPrivScreenRec {
     Bool fNativeGlActive;
 } winPrivScreenRec;
 
-typedef struct {
-    void *value;
-    XID id;
-} WindowIDPairRec, *WindowIDPairPtr;
-
 /*
  * Extern declares for general global variables
  */
@@ -535,6 +599,7 @@ extern DeviceIntPtr g_pwinKeyboard;
 
 extern FARPROC g_fpDirectDrawCreate;
 extern FARPROC g_fpDirectDrawCreateClipper;
+extern FARPROC g_fpD3D11CreateDevice;
 
 /*
  * Screen privates macros
@@ -662,6 +727,9 @@ void
 Bool
  winCreateDefColormap(ScreenPtr pScreen);
 
+void
+ winColormapRange(int ndef, xColorItem * pdefs, int *piFirst, int *piCount);
+
 /*
  * wincreatewnd.c
  */
@@ -704,6 +772,12 @@ Bool
 void
  winReleaseDDProcAddresses(void);
 
+Bool
+ winGetDXGIProcAddresses(void);
+
+void
+ winReleaseDXGIProcAddresses(void);
+
 /*
  * winerror.c
  */
@@ -765,6 +839,22 @@ Bool
 void
  winRemoveKeyboardHookLL(void);
 
+/*
+ * winlatency.c
+ */
+
+void
+ winLatencyInit(void);
+
+void
+ winLatencyInput(void);
+
+void
+ winLatencyPresent(ScreenPtr pScreen);
+
+void
+ winLatencyReport(void);
+
 /*
  * winmisc.c
  */
@@ -775,6 +865,12 @@ CARD8
 Bool
  winUpdateFBPointer(ScreenPtr pScreen, void *pbits);
 
+DWORD
+ winCoalesceDamageBoxes(RegionPtr pRegion, BoxPtr *ppBox);
+
+void
+ winSkipUnchangedTiles(ScreenPtr pScreen, RegionPtr pRegion);
+
 /*
  * winmouse.c
  */
@@ -796,6 +892,21 @@ winMouseButtonsHandle(ScreenPtr pScreen,
 void
  winEnqueueMotion(int x, int y);
 
+void
+ winEnqueueMotionHistory(int x, int y, int dx, int dy);
+
+void
+ winMouseStartRelative(HWND hwnd, int x, int y);
+
+void
+ winMouseStopRelative(void);
+
+Bool
+ winMouseRelative(void);
+
+void
+ winMouseRawInput(HRAWINPUT hRawInput);
+
 /*
  * winscrinit.c
  */
@@ -806,6 +917,9 @@ Bool
 Bool
  winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv);
 
+void
+ winEngineStatsReport(void);
+
 /*
  * winshadddnl.c
  */
@@ -813,6 +927,13 @@ Bool
 Bool
  winSetEngineFunctionsShadowDDNL(ScreenPtr pScreen);
 
+/*
+ * winshaddxgi.c
+ */
+
+Bool
+ winSetEngineFunctionsShadowDXGI(ScreenPtr pScreen);
+
 /*
  * winshadgdi.c
  */
@@ -820,6 +941,9 @@ Bool
 Bool
  winSetEngineFunctionsShadowGDI(ScreenPtr pScreen);
 
+void
+ winFlushPendingPaintsShadowGDI(ScreenPtr pScreen, int *piTimeout);
+
 /*
  * winwakeup.c
  */
@@ -827,6 +951,9 @@ Bool
 void
 winWakeupHandler(ScreenPtr pScreen, int iResult);
 
+void
+ winWakeupLogStatistics(void);
+
 /*
  * winwindow.c
  */
@@ -918,6 +1045,18 @@ winCreatePixmapMultiwindow(ScreenPtr pScreen, int width, int height, int depth,
 Bool
 winDestroyPixmapMultiwindow(PixmapPtr pPixmap);
 
+Bool
+ winPixmapEnsureDIBMultiwindow(PixmapPtr pPixmap);
+
+void
+ winInitPixmapBytesMultiwindow(void);
+
+void
+ winFlushDIBCacheMultiwindow(ScreenPtr pScreen);
+
+unsigned long
+ winTrimDIBCacheMultiwindow(void *closure);
+
 Bool
 winModifyPixmapHeaderMultiwindow(PixmapPtr pPixmap,
                                  int width,
@@ -938,6 +1077,25 @@ int
 LRESULT CALLBACK
 winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
+/*
+ * winstartup.c
+ */
+
+void
+ winStartupMark(const char *pszStep);
+
+void
+ winStartupReady(void);
+
+void
+ winStartupDone(void);
+
+void
+ winStartupPrefetch(void);
+
+void
+ winStartupWait(void);
+
 /*
  * wintrayicon.c
  */
@@ -1003,6 +1161,26 @@ winDoRandRScreenSetSize(ScreenPtr pScreen,
                         CARD16 width,
                         CARD16 height, CARD32 mmWidth, CARD32 mmHeight);
 
+/*
+ * winpresent.c
+ */
+Bool
+winPresentScreenInit(ScreenPtr pScreen);
+
+/*
+ * winsync.c
+ */
+Bool
+winSyncScreenInit(ScreenPtr pScreen);
+
+#ifdef XWIN_XV
+/*
+ * winvideo.c
+ */
+Bool
+winInitVideo(ScreenPtr pScreen);
+#endif
+
 /*
  * winmsgwindow.c
  */
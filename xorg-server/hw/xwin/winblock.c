@@ -40,26 +40,37 @@ winBlockHandler(ScreenPtr pScreen, void *pTimeout)
 {
     winScreenPriv(pScreen);
 
+    winStartupDone();
+
 #ifndef HAS_DEVWINDOWS
-    struct timeval **tvp = pTimeout;
+    int *piTimeout = pTimeout;
 
-    if (*tvp != NULL) {
+    if (*piTimeout != 0) {
       if (GetQueueStatus(QS_ALLINPUT | QS_ALLPOSTMESSAGE) != 0) {
         /* If there are still messages to process on the Windows message
            queue, make sure select() just polls rather than blocking.
         */
-        *(int*)pTimeout = 0;
+        *piTimeout = 0;
       }
+#ifdef __CYGWIN__
       else {
         /* Otherwise, lacking /dev/windows, we must wake up again in
            a reasonable time to check the Windows message queue. without
            noticeable delay.
          */
-        *(int*)pTimeout = 1;
+        *piTimeout = 1;
       }
+#endif
+      /* Native builds wait in MsgWaitForMultipleObjectsEx, which returns
+         as soon as a message arrives, so the timeout can stand as is */
     }
 #endif
 
+    /* Paint the multiwindow windows invalidated by shadow updates */
+    if (pScreenPriv != NULL && pScreenPriv->pScreenInfo->fMultiWindow
+        && pScreenPriv->pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI)
+        winFlushPendingPaintsShadowGDI(pScreen, pTimeout);
+
     /* Signal threaded modules to begin */
     if (pScreenPriv != NULL && !pScreenPriv->fServerStarted) {
         int iReturn;
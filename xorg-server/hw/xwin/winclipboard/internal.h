@@ -87,9 +87,15 @@ Bool
 void
  winClipboardDOStoUNIX(char *pszData, int iLength);
 
+int
+ winClipboardCountNakedNewlines(const char *pszSrc, int iLength);
+
 void
  winClipboardUNIXtoDOS(char **ppszData, int iLength);
 
+int
+ winClipboardUNIXtoDOSW(wchar_t *pwszData, int iNewlineCount, int iLength);
+
 /*
  * winclipboardthread.c
  */
@@ -129,6 +135,8 @@ typedef struct
   xcb_atom_t *targetList;
   unsigned char *incr;
   unsigned long int incrsize;
+  unsigned long int incrcap;
+  unsigned int serial;
 } ClipboardConversionData;
 
 int
@@ -139,6 +147,9 @@ winClipboardFlushXEvents(HWND hwnd,
 xcb_atom_t
 winClipboardGetLastOwnedSelectionAtom(ClipboardAtoms *atoms);
 
+BOOL
+winClipboardRenderCached(ClipboardConversionData *data);
+
 void
 winClipboardInitMonitoredSelections(void);
 
@@ -33,6 +33,7 @@
 #endif
 
 #include <stdlib.h>
+#include <wchar.h>
 #include "internal.h"
 
 /*
@@ -66,20 +67,15 @@ winClipboardDOStoUNIX(char *pszSrc, int iLength)
 }
 
 /*
- * Convert \n to \r\n
+ * Count \n characters without leading \r
  */
 
-void
-winClipboardUNIXtoDOS(char **ppszData, int iLength)
+int
+winClipboardCountNakedNewlines(const char *pszSrc, int iLength)
 {
     int iNewlineCount = 0;
-    char *pszSrc = *ppszData;
-    char *pszEnd = pszSrc + iLength;
-    char *pszDest = NULL, *pszDestBegin = NULL;
+    const char *pszEnd = pszSrc + iLength;
 
-    winDebug("UNIXtoDOS () - Original data:'%s'\n", *ppszData);
-
-    /* Count \n characters without leading \r */
     while (pszSrc < pszEnd) {
         /* Skip ahead two character if found set of \r\n */
         if (*pszSrc == '\r' && pszSrc + 1 < pszEnd && *(pszSrc + 1) == '\n') {
@@ -95,6 +91,25 @@ winClipboardUNIXtoDOS(char **ppszData, int iLength)
         pszSrc++;
     }
 
+    return iNewlineCount;
+}
+
+/*
+ * Convert \n to \r\n
+ */
+
+void
+winClipboardUNIXtoDOS(char **ppszData, int iLength)
+{
+    int iNewlineCount;
+    char *pszSrc = *ppszData;
+    char *pszEnd = pszSrc + iLength;
+    char *pszDest = NULL, *pszDestBegin = NULL;
+
+    winDebug("UNIXtoDOS () - Original data:'%s'\n", *ppszData);
+
+    iNewlineCount = winClipboardCountNakedNewlines(pszSrc, iLength);
+
     /* Return if no naked \n's */
     if (iNewlineCount == 0)
         return;
@@ -140,3 +155,42 @@ winClipboardUNIXtoDOS(char **ppszData, int iLength)
 
     winDebug("UNIXtoDOS () - Final string:'%s'\n", pszDestBegin);
 }
+
+/*
+ * Convert \n to \r\n in place in a UTF-16 string
+ *
+ * The iLength characters to convert start iNewlineCount characters into
+ * pwszData, leaving room for the \r's to be inserted as the string is
+ * moved down to the start of the buffer.  No more than iNewlineCount
+ * \r's are inserted, and the result is null terminated.  Returns the
+ * length of the result, not counting the null.
+ */
+
+int
+winClipboardUNIXtoDOSW(wchar_t *pwszData, int iNewlineCount, int iLength)
+{
+    wchar_t *pwszDest = pwszData;
+    wchar_t *pwszSrc = pwszData + iNewlineCount;
+    wchar_t *pwszEnd = pwszSrc + iLength;
+
+    while (pwszSrc < pwszEnd) {
+        /* Copy line endings that are already valid */
+        if (*pwszSrc == L'\r' && pwszSrc + 1 < pwszEnd
+            && *(pwszSrc + 1) == L'\n') {
+            *pwszDest++ = *pwszSrc++;
+            *pwszDest++ = *pwszSrc++;
+            continue;
+        }
+
+        /* Add \r to naked \n's, as long as there is room left */
+        if (*pwszSrc == L'\n' && pwszDest < pwszSrc)
+            *pwszDest++ = L'\r';
+
+        *pwszDest++ = *pwszSrc++;
+    }
+
+    /* Put terminating null at end of new string */
+    *pwszDest = L'\0';
+
+    return pwszDest - pwszData;
+}
@@ -111,6 +111,39 @@ intern_atom(xcb_connection_t *conn, const char *atomName)
   return atom;
 }
 
+typedef struct {
+  const char *name;
+  xcb_atom_t *atom;
+} AtomRequest;
+
+/* Intern several atoms with a single round trip */
+static void
+intern_atoms(xcb_connection_t *conn, const AtomRequest *req, int count)
+{
+  xcb_intern_atom_cookie_t *cookies;
+  xcb_intern_atom_reply_t *atom_reply;
+  int i;
+
+  cookies = calloc(count, sizeof(xcb_intern_atom_cookie_t));
+  if (!cookies) {
+    for (i = 0; i < count; i++)
+      *req[i].atom = intern_atom(conn, req[i].name);
+    return;
+  }
+
+  for (i = 0; i < count; i++)
+    cookies[i] = xcb_intern_atom(conn, 0, strlen(req[i].name), req[i].name);
+  for (i = 0; i < count; i++) {
+    *req[i].atom = XCB_ATOM_NONE;
+    atom_reply = xcb_intern_atom_reply(conn, cookies[i], NULL);
+    if (atom_reply) {
+      *req[i].atom = atom_reply->atom;
+      free(atom_reply);
+    }
+  }
+  free(cookies);
+}
+
 static void
 winClipboardThreadExit(void *arg);
 
@@ -185,12 +218,18 @@ winClipboardProc(char *szDisplay, xcb_auth_info_t *auth_info)
     xcb_xfixes_query_version_unchecked(conn, 1, 0);
 
     /* Create atoms */
-    atoms.atomClipboard = intern_atom(conn, "CLIPBOARD");
-    atoms.atomLocalProperty = intern_atom(conn, "CYGX_CUT_BUFFER");
-    atoms.atomUTF8String = intern_atom(conn, "UTF8_STRING");
-    atoms.atomCompoundText = intern_atom(conn, "COMPOUND_TEXT");
-    atoms.atomTargets = intern_atom(conn, "TARGETS");
-    atoms.atomIncr = intern_atom(conn, "INCR");
+    {
+        const AtomRequest req[] = {
+            { "CLIPBOARD", &atoms.atomClipboard },
+            { "CYGX_CUT_BUFFER", &atoms.atomLocalProperty },
+            { "UTF8_STRING", &atoms.atomUTF8String },
+            { "COMPOUND_TEXT", &atoms.atomCompoundText },
+            { "TARGETS", &atoms.atomTargets },
+            { "INCR", &atoms.atomIncr },
+        };
+
+        intern_atoms(conn, req, ARRAY_SIZE(req));
+    }
 
     xcb_screen_t *root_screen = xcb_aux_get_screen(conn, screen);
     xcb_window_t root_window_id = root_screen->root;
@@ -271,6 +310,8 @@ winClipboardProc(char *szDisplay, xcb_auth_info_t *auth_info)
 
     data.incr = NULL;
     data.incrsize = 0;
+    data.incrcap = 0;
+    data.serial = 0;
     winDebug ("winClipboardProc - Started\n");
     /* Signal that the clipboard client has started */
     g_fClipboardStarted = TRUE;
@@ -56,6 +56,7 @@
  */
 
 #define WIN_POLL_TIMEOUT	1
+#define WIN_CONVERSION_MAX_TIMEOUT	30
 
 /*
  * References to external symbols
@@ -67,7 +68,12 @@ extern Atom g_atomLastOwnedSelection;
 extern Bool g_fClipboardStarted;
 extern HWND g_hwndClipboard;
 /*
- * Process X events up to specified timeout
+ * Process X events until the conversion completes or stalls.
+ *
+ * iTimeoutSec is how long the owner may go without sending anything.
+ * Each chunk of an INCR transfer restarts that wait, so a large selection
+ * from a slow client that keeps making progress is not cut off, while
+ * the whole conversion is still abandoned after WIN_CONVERSION_MAX_TIMEOUT.
  */
 
 static int
@@ -77,7 +83,9 @@ winProcessXEventsTimeout(HWND hwnd, xcb_window_t iWindow, xcb_connection_t *conn
     int iConnNumber;
     struct timeval tv;
     int iReturn;
-    long endTime;
+    long endTime, maxTime;
+    unsigned long lastIncrSize = data->incrsize;
+    Bool fIncr = data->incr != NULL;
 
     winDebug("winProcessXEventsTimeout () - pumping X events, timeout %d seconds\n",
              iTimeoutSec);
@@ -86,6 +94,7 @@ winProcessXEventsTimeout(HWND hwnd, xcb_window_t iWindow, xcb_connection_t *conn
     iConnNumber = xcb_get_file_descriptor(conn);
 
     endTime = GetTimeInMillis() + iTimeoutSec * 1000;
+    maxTime = GetTimeInMillis() + WIN_CONVERSION_MAX_TIMEOUT * 1000;
     /* Loop for X events */
     while (1) {
         long remainingTime;
@@ -101,6 +110,14 @@ winProcessXEventsTimeout(HWND hwnd, xcb_window_t iWindow, xcb_connection_t *conn
           return iReturn;
         }
 
+        /* An INCR transfer started or sent another chunk; give the owner
+         * time for the next one */
+        if (data->incr && (!fIncr || data->incrsize != lastIncrSize)) {
+            fIncr = TRUE;
+            lastIncrSize = data->incrsize;
+            endTime = min(GetTimeInMillis() + iTimeoutSec * 1000, maxTime);
+        }
+
         /* We need to ensure that all pending requests are sent */
         xcb_flush(conn);
 
@@ -340,6 +357,12 @@ winClipboardWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             goto fake_paste;
         }
 
+        /* The owner hasn't changed since the last paste, reuse it */
+        if (winClipboardRenderCached(&data)) {
+            winDebug("winClipboardWindowProc - WM_RENDERFORMAT - Cached.\n");
+            return 0;
+        }
+
         winDebug("winClipboardWindowProc - requesting targets for selection from owner\n");
 
         /* Request the selection's supported conversion targets */
@@ -349,6 +372,7 @@ winClipboardWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         /* Process X events */
         data.incr = NULL;
         data.incrsize = 0;
+        data.incrcap = 0;
 
         iReturn = winProcessXEventsTimeout(hwnd,
                                            iWindow,
@@ -425,6 +449,11 @@ winClipboardWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         if (WIN_XEVENTS_NOTIFY_DATA != iReturn) {
             ErrorF
                 ("winClipboardWindowProc - timed out waiting for WIN_XEVENTS_NOTIFY_DATA\n");
+
+            /* Drop whatever part of an INCR transfer was received */
+            free(data.incr);
+            data.incr = NULL;
+            data.incrsize = data.incrcap = 0;
         }
         else {
             pasted = TRUE;
@@ -58,6 +58,9 @@
 
 #define CP_ISO_8559_1 28591
 
+/* Longest conversion kept for repeated pastes, in UTF-16 characters */
+#define CLIP_MAX_CACHED_TEXT		(8 * 1024 * 1024)
+
 /*
  * Global variables
  */
@@ -75,9 +78,89 @@ static const char *szSelectionNames[CLIP_NUM_SELECTIONS] =
 
 static unsigned int lastOwnedSelectionIndex = CLIP_OWN_NONE;
 
+/*
+ * The last text converted from X, kept so that pasting it again does not
+ * repeat the conversion.  Every XFixes SetSelectionOwner notify, whether
+ * for a new owner or a new timestamp from the same one, bumps
+ * s_iSelectionSerial and drops the cache, so a cached conversion is
+ * valid exactly while s_iCachedSerial is current.
+ */
+static unsigned int s_iSelectionSerial;
+static unsigned int s_iCachedSerial;
+static wchar_t *s_pwszCachedText;
+static int s_iCachedLen;
+
+static void
+winClipboardDropCache(void)
+{
+    free(s_pwszCachedText);
+    s_pwszCachedText = NULL;
+    s_iCachedLen = 0;
+}
+
+static void
+winClipboardCacheText(const ClipboardConversionData *data,
+                      const wchar_t *pwszText, int iLen)
+{
+    /* Don't cache a conversion that raced with an ownership change */
+    if (data->serial != s_iSelectionSerial || iLen > CLIP_MAX_CACHED_TEXT)
+        return;
+
+    winClipboardDropCache();
+    s_pwszCachedText = malloc(sizeof(wchar_t) * (iLen + 1));
+    if (!s_pwszCachedText)
+        return;
+    memcpy(s_pwszCachedText, pwszText, sizeof(wchar_t) * (iLen + 1));
+    s_iCachedLen = iLen;
+    s_iCachedSerial = s_iSelectionSerial;
+}
+
+/*
+ * Answer WM_RENDERFORMAT from the cache if the selection has not changed
+ * since it was last converted; otherwise note the current selection in
+ * data, so the conversion about to be made can be cached.
+ */
+
+BOOL
+winClipboardRenderCached(ClipboardConversionData *data)
+{
+    HGLOBAL hGlobal;
+    wchar_t *pwszGlobalData;
+
+    data->serial = s_iSelectionSerial;
+
+    if (!s_pwszCachedText || s_iCachedSerial != s_iSelectionSerial)
+        return FALSE;
+
+    hGlobal = GlobalAlloc(GMEM_MOVEABLE,
+                          sizeof(wchar_t) * (s_iCachedLen + 1));
+    if (!hGlobal)
+        return FALSE;
+
+    pwszGlobalData = GlobalLock(hGlobal);
+    if (!pwszGlobalData) {
+        GlobalFree(hGlobal);
+        return FALSE;
+    }
+    memcpy(pwszGlobalData, s_pwszCachedText,
+           sizeof(wchar_t) * (s_iCachedLen + 1));
+    GlobalUnlock(hGlobal);
+
+    winDebug("winClipboardRenderCached - reusing %d characters\n",
+             s_iCachedLen);
+
+    /* Windows owns hGlobal after this */
+    SetClipboardData(CF_UNICODETEXT, hGlobal);
+    return TRUE;
+}
+
 static void
 MonitorSelection(xcb_xfixes_selection_notify_event_t * e, unsigned int i)
 {
+    /* Whatever changed, the cached conversion is stale */
+    s_iSelectionSerial++;
+    winClipboardDropCache();
+
     /* Look for owned -> not owned transition */
     if ((XCB_NONE == e->owner) && (XCB_NONE != s_iOwners[i])) {
         unsigned int other_index;
@@ -133,6 +216,9 @@ winClipboardInitMonitoredSelections(void)
       s_iOwners[i] = XCB_NONE;
 
     lastOwnedSelectionIndex = CLIP_OWN_NONE;
+
+    s_iSelectionSerial++;
+    winClipboardDropCache();
 }
 
 static char *get_atom_name(xcb_connection_t *conn, xcb_atom_t atom)
@@ -212,11 +298,13 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
     int xtpText_nitems;
 
     BOOL fSetClipboardData = TRUE;
-    char *pszReturnData = NULL;
-    UINT codepage;
-    wchar_t *pwszUnicodeStr = NULL;
+    UINT codepage = CP_UTF8;
+    int iTextLen;
+    int iNewlineCount;
+    int iUnicodeLen = 0;
+    int iDOSLen;
     HGLOBAL hGlobal = NULL;
-    char *pszGlobalData = NULL;
+    wchar_t *pwszGlobalData = NULL;
 
     /* Retrieve the selection data and delete the property */
     xcb_get_property_cookie_t cookie = xcb_get_property(conn,
@@ -253,10 +341,22 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
 
     /* INCR reply indicates the start of a incremental transfer */
     if (encoding == atoms->atomIncr) {
-        winDebug("winClipboardSelectionNotifyData: starting INCR, anticipated size %d\n", *(int *)value);
+        int iAnticipated = nitems >= sizeof(int) ? *(int *)value : 0;
+
+        winDebug("winClipboardSelectionNotifyData: starting INCR, anticipated size %d\n", iAnticipated);
+        free(reply);
+
+        /* The size is only a lower bound, but usually exact */
+        free(data->incr);
         data->incrsize = 0;
-        data->incr = malloc(*(int *)value);
-        // XXX: if malloc failed, we have an error
+        data->incrcap = iAnticipated > 0 ? iAnticipated : 4096;
+        data->incr = malloc(data->incrcap);
+        if (!data->incr) {
+            ErrorF("winClipboardSelectionNotifyData - malloc of %lu bytes "
+                   "for INCR transfer failed\n", data->incrcap);
+            data->incrcap = 0;
+            return WIN_XEVENTS_FAILED;
+        }
         return WIN_XEVENTS_SUCCESS;
     }
     else if (data->incr) {
@@ -274,9 +374,30 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
         else {
             /* Otherwise, continue appending the INCR data */
             winDebug("winClipboardSelectionNotifyData: INCR, %ld bytes\n", nitems);
-            data->incr = realloc(data->incr, data->incrsize + nitems);
+
+            /* Grow geometrically, so a transfer longer than announced
+             * costs a logarithmic number of copies rather than one a chunk */
+            if (data->incrsize + nitems > data->incrcap) {
+                unsigned long cap = max(data->incrcap * 2,
+                                        data->incrsize + nitems);
+                unsigned char *incr = realloc(data->incr, cap);
+
+                if (!incr) {
+                    ErrorF("winClipboardSelectionNotifyData - realloc of %lu "
+                           "bytes for INCR transfer failed\n", cap);
+                    free(reply);
+                    free(data->incr);
+                    data->incr = NULL;
+                    data->incrsize = data->incrcap = 0;
+                    goto winClipboardFlushXEvents_SelectionNotify_Done;
+                }
+                data->incr = incr;
+                data->incrcap = cap;
+            }
+
             memcpy(data->incr + data->incrsize, value, nitems);
             data->incrsize = data->incrsize + nitems;
+            free(reply);
             return WIN_XEVENTS_SUCCESS;
         }
     }
@@ -289,61 +410,46 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
     }
 
     if (xtpText_encoding == atoms->atomUTF8String) {
-        pszReturnData = malloc(xtpText_nitems + 1);
-        memcpy(pszReturnData, xtpText_value, xtpText_nitems);
-        pszReturnData[xtpText_nitems] = 0;
         codepage = CP_UTF8; // code page identifier for utf8
     } else if (xtpText_encoding == XCB_ATOM_STRING) {
         // STRING encoding is Latin1 (ISO8859-1) plus tab and newline
-        pszReturnData = malloc(xtpText_nitems + 1);
-        memcpy(pszReturnData, xtpText_value, xtpText_nitems);
-        pszReturnData[xtpText_nitems] = 0;
         codepage = CP_ISO_8559_1; // code page identifier for iso-8559-1
     } else if (xtpText_encoding == atoms->atomCompoundText) {
         // COMPOUND_TEXT is complex, based on ISO 2022
         ErrorF("SelectionNotify: data in COMPOUND_TEXT encoding which is not implemented, discarding\n");
-        pszReturnData = malloc(1);
-        pszReturnData[0] = '\0';
+        xtpText_nitems = 0;
     } else { // shouldn't happen as we accept no other encodings
-        pszReturnData = malloc(1);
-        pszReturnData[0] = '\0';
-    }
-
-    /* Free the data returned from xcb_get_property */
-    free(reply);
-
-    /* Free any INCR data */
-    if (data->incr) {
-        free(data->incr);
-        data->incr = NULL;
-        data->incrsize = 0;
+        xtpText_nitems = 0;
     }
 
-    /* Convert the X clipboard string to DOS format */
-    winClipboardUNIXtoDOS(&pszReturnData, strlen(pszReturnData));
-
-    /* Find out how much space needed when converted to UTF-16 */
-    int iUnicodeLen = MultiByteToWideChar(codepage, 0,
-                                          pszReturnData, -1, NULL, 0);
+    /*
+     * Convert straight from the received data into the clipboard block:
+     * the \r's needed for DOS line endings are counted up front, the text
+     * is converted to UTF-16 at an offset that leaves room for them, and
+     * then moved down in place, inserting them.
+     */
 
-    /* NOTE: iUnicodeLen includes space for null terminator */
-    pwszUnicodeStr = malloc(sizeof(wchar_t) * iUnicodeLen);
-    if (!pwszUnicodeStr) {
-        ErrorF("winClipboardFlushXEvents - SelectionNotify "
-               "malloc failed for pwszUnicodeStr, aborting.\n");
+    /* Like a C string, the text ends at the first null */
+    iTextLen = xtpText_nitems;
+    {
+        unsigned char *pNull = memchr(xtpText_value, 0, iTextLen);
 
-        /* Abort */
-        goto winClipboardFlushXEvents_SelectionNotify_Done;
+        if (pNull)
+            iTextLen = pNull - xtpText_value;
     }
 
-    /* Do the actual conversion */
-    MultiByteToWideChar(codepage, 0,
-                        pszReturnData, -1, pwszUnicodeStr, iUnicodeLen);
+    iNewlineCount = winClipboardCountNakedNewlines((char *) xtpText_value,
+                                                   iTextLen);
 
-    /* Allocate global memory for the X clipboard data */
-    hGlobal = GlobalAlloc(GMEM_MOVEABLE, sizeof(wchar_t) * iUnicodeLen);
+    /* Find out how much space needed when converted to UTF-16 */
+    if (iTextLen > 0)
+        iUnicodeLen = MultiByteToWideChar(codepage, 0,
+                                          (char *) xtpText_value, iTextLen,
+                                          NULL, 0);
 
-    free(pszReturnData);
+    /* Allocate global memory for the X clipboard data, with a null */
+    hGlobal = GlobalAlloc(GMEM_MOVEABLE,
+                          sizeof(wchar_t) * (iUnicodeLen + iNewlineCount + 1));
 
     /* Check that global memory was allocated */
     if (!hGlobal) {
@@ -351,27 +457,33 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
                "GlobalAlloc failed, aborting: %08x\n", (unsigned int)GetLastError());
 
         /* Abort */
-        goto winClipboardFlushXEvents_SelectionNotify_Done;
+        goto winClipboardFlushXEvents_SelectionNotify_Free;
     }
 
     /* Obtain a pointer to the global memory */
-    pszGlobalData = GlobalLock(hGlobal);
-    if (pszGlobalData == NULL) {
+    pwszGlobalData = GlobalLock(hGlobal);
+    if (pwszGlobalData == NULL) {
         ErrorF("winClipboardFlushXEvents - Could not lock global "
                "memory for clipboard transfer\n");
 
         /* Abort */
-        goto winClipboardFlushXEvents_SelectionNotify_Done;
+        goto winClipboardFlushXEvents_SelectionNotify_Free;
     }
 
-    /* Copy the returned string into the global memory */
-    wcscpy((wchar_t *)pszGlobalData, pwszUnicodeStr);
-    free(pwszUnicodeStr);
-    pwszUnicodeStr = NULL;
+    /* Do the actual conversion, then add the \r's */
+    if (iUnicodeLen > 0)
+        MultiByteToWideChar(codepage, 0,
+                            (char *) xtpText_value, iTextLen,
+                            pwszGlobalData + iNewlineCount, iUnicodeLen);
+    iDOSLen = winClipboardUNIXtoDOSW(pwszGlobalData, iNewlineCount,
+                                     iUnicodeLen);
+
+    /* Keep it for the next paste of the same selection */
+    winClipboardCacheText(data, pwszGlobalData, iDOSLen);
 
     /* Release the pointer to the global memory */
     GlobalUnlock(hGlobal);
-    pszGlobalData = NULL;
+    pwszGlobalData = NULL;
 
     /* Push the selection data to the Windows clipboard */
     SetClipboardData(CF_UNICODETEXT, hGlobal);
@@ -380,15 +492,29 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
     fSetClipboardData = FALSE;
 
     /*
-     * NOTE: Do not try to free pszGlobalData, it is owned by
+     * NOTE: Do not try to free hGlobal, it is owned by
      * Windows after the call to SetClipboardData ().
      */
+    hGlobal = NULL;
+
+ winClipboardFlushXEvents_SelectionNotify_Free:
+    /* Free the data returned from xcb_get_property */
+    free(reply);
+
+    /* Free any INCR data */
+    if (data->incr) {
+        free(data->incr);
+        data->incr = NULL;
+        data->incrsize = data->incrcap = 0;
+    }
 
  winClipboardFlushXEvents_SelectionNotify_Done:
     /* Free allocated resources */
-    free(pwszUnicodeStr);
-    if (hGlobal && pszGlobalData)
-        GlobalUnlock(hGlobal);
+    if (hGlobal) {
+        if (pwszGlobalData)
+            GlobalUnlock(hGlobal);
+        GlobalFree(hGlobal);
+    }
     if (fSetClipboardData) {
         SetClipboardData(CF_UNICODETEXT, NULL);
         SetClipboardData(CF_TEXT, NULL);
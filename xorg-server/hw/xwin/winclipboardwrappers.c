@@ -158,6 +158,7 @@ winProcEstablishConnection(ClientPtr client)
         }
 
         winDebug ("winProcEstablishConnection - winInitClipboard returned.\n");
+        winStartupMark("clipboard thread");
     }
 
     /* Flag that clipboard client has been launched */
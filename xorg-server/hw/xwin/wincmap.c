@@ -200,14 +200,14 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
         nBlue = pdefs[i].blue >> 8;
 
         /* Copy the colors to a palette entry table */
-        pCmapPriv->peColors[pdefs[0].pixel + i].peRed = nRed;
-        pCmapPriv->peColors[pdefs[0].pixel + i].peGreen = nGreen;
-        pCmapPriv->peColors[pdefs[0].pixel + i].peBlue = nBlue;
+        pCmapPriv->peColors[pdefs[i].pixel].peRed = nRed;
+        pCmapPriv->peColors[pdefs[i].pixel].peGreen = nGreen;
+        pCmapPriv->peColors[pdefs[i].pixel].peBlue = nBlue;
 
         /* Copy the colors to a RGBQUAD table */
-        pCmapPriv->rgbColors[pdefs[0].pixel + i].rgbRed = nRed;
-        pCmapPriv->rgbColors[pdefs[0].pixel + i].rgbGreen = nGreen;
-        pCmapPriv->rgbColors[pdefs[0].pixel + i].rgbBlue = nBlue;
+        pCmapPriv->rgbColors[pdefs[i].pixel].rgbRed = nRed;
+        pCmapPriv->rgbColors[pdefs[i].pixel].rgbGreen = nGreen;
+        pCmapPriv->rgbColors[pdefs[i].pixel].rgbBlue = nBlue;
 
         winDebug("winStoreColors - nRed %d nGreen %d nBlue %d\n",
                  nRed, nGreen, nBlue);
@@ -221,6 +221,26 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
     }
 }
 
+/*
+ * The smallest run of colormap entries that holds every pixel in pdefs.
+ * The engines pass the run to Windows, which takes contiguous entries only.
+ */
+void
+winColormapRange(int ndef, xColorItem * pdefs, int *piFirst, int *piCount)
+{
+    int i, iFirst, iLast;
+
+    iFirst = iLast = ndef ? (int) pdefs[0].pixel : 0;
+    for (i = 1; i < ndef; ++i) {
+        if ((int) pdefs[i].pixel < iFirst)
+            iFirst = pdefs[i].pixel;
+        if ((int) pdefs[i].pixel > iLast)
+            iLast = pdefs[i].pixel;
+    }
+    *piFirst = iFirst;
+    *piCount = ndef ? iLast - iFirst + 1 : 0;
+}
+
 /* See Porting Layer Definition - p. 30 */
 static void
 winResolveColor(unsigned short *pred,
@@ -46,6 +46,9 @@
 #ifdef _MSC_VER
 #define min(a,b) (((a) < (b)) ? (a) : (b))
 #define max(a,b) (((a) > (b)) ? (a) : (b))
+
+/* Largest cursor Windows will show */
+#define WIN_CURSOR_MAX_SIZE 256
 #endif
 
 /*
@@ -108,6 +111,19 @@ winPointerWarpCursor(DeviceIntPtr pDev, ScreenPtr pScreen, int x, int y)
          * immediately warp back to the current position.
          */
         SetCursorPos(rcClient.left + x, rcClient.top + y);
+
+        /*
+         * A grabbing client warping the pointer wants mouse motion as
+         * deltas; take those from raw input from now on.
+         */
+        if (!winMouseRelative()) {
+            HWND hwnd = GetForegroundWindow();
+            DWORD dwProcessId = 0;
+
+            GetWindowThreadProcessId(hwnd, &dwProcessId);
+            if (dwProcessId == GetCurrentProcessId())
+                winMouseStartRelative(hwnd, rcClient.left, rcClient.top);
+        }
     }
 
     /* Call the mi warp procedure to do the actual warping in X. */
@@ -125,16 +141,32 @@ winCrossScreen(ScreenPtr pScreen, Bool fEntering)
 {
 }
 
+/*
+ * Converted cursors, shared by all screens.  An entry holds one reference
+ * per cursor realized with it and stays cached after that until its slot
+ * is needed.  When every slot is referenced, cursors get a handle of their
+ * own.
+ */
+#define WIN_CURSOR_CACHE_SIZE 64
+
+typedef struct {
+    uint64_t hash;
+    unsigned short width, height, xhot, yhot;
+    int sm_cx, sm_cy;
+    HCURSOR hCursor;
+    int iRefs;
+    unsigned long ulLastUse;
+} winCursorCacheRec;
+
+static winCursorCacheRec s_cursorCache[WIN_CURSOR_CACHE_SIZE];
+static unsigned long s_ulCursorCacheClock;
+
 static unsigned char
 reverse(unsigned char c)
 {
-    int i;
-    unsigned char ret = 0;
-
-    for (i = 0; i < 8; ++i) {
-        ret |= ((c >> i) & 1) << (7 - i);
-    }
-    return ret;
+    c = (c & 0xF0) >> 4 | (c & 0x0F) << 4;
+    c = (c & 0xCC) >> 2 | (c & 0x33) << 2;
+    return (c & 0xAA) >> 1 | (c & 0x55) << 1;
 }
 
 /*
@@ -149,6 +181,7 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
     unsigned char *pAnd;
     unsigned char *pXor;
     int nCX, nCY;
+    int nWinCX, nWinCY;
     int nBytes;
     double dForeY, dBackY;
     BOOL fReverse;
@@ -161,35 +194,38 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
     BITMAPINFO *pbmi;
     uint32_t *lpBits;
 
-    winDebug("winLoadCursor: Win32: %dx%d X11: %dx%d hotspot: %d,%d\n", 
-                  pScreenPriv->cursor.sm_cx, pScreenPriv->cursor.sm_cy,
-                  pCursor->bits->width, pCursor->bits->height,
-                  pCursor->bits->xhot, pCursor->bits->yhot);
-
     /* We can use only White and Black, so calc brightness of color
      * Also check if the cursor is inverted */
     dForeY = BRIGHTNESS(pCursor->fore);
     dBackY = BRIGHTNESS(pCursor->back);
     fReverse = dForeY < dBackY;
 
-    /* Check whether the X11 cursor is bigger than the win32 cursor */
-    if (pScreenPriv->cursor.sm_cx < pCursor->bits->width ||
-        pScreenPriv->cursor.sm_cy < pCursor->bits->height) {
-        ErrorF (
-                      "winLoadCursor - Windows requires %dx%d cursor but X requires %dx%d\n",
-                      pScreenPriv->cursor.sm_cx, pScreenPriv->cursor.sm_cy,
-                      pCursor->bits->width, pCursor->bits->height);
+    /* Windows shows cursors at the size of their bitmaps, so grow the
+     * bitmaps past the system size for big X cursors rather than crop them.
+     * Mask rows have to be a multiple of 16 bits. */
+    nWinCX = min(max(pScreenPriv->cursor.sm_cx, pCursor->bits->width),
+                 WIN_CURSOR_MAX_SIZE);
+    nWinCX = (nWinCX + 15) & ~15;
+    nWinCY = min(max(pScreenPriv->cursor.sm_cy, pCursor->bits->height),
+                 WIN_CURSOR_MAX_SIZE);
+    if (nWinCX < pCursor->bits->width || nWinCY < pCursor->bits->height) {
+        ErrorF("winLoadCursor - cropping %dx%d cursor to %dx%d\n",
+               pCursor->bits->width, pCursor->bits->height, nWinCX, nWinCY);
     }
 
+    winDebug("winLoadCursor: Win32: %dx%d X11: %dx%d hotspot: %d,%d\n",
+             nWinCX, nWinCY, pCursor->bits->width, pCursor->bits->height,
+             pCursor->bits->xhot, pCursor->bits->yhot);
+
     /* Get the number of bytes required to store the whole cursor image
      * This is roughly (sm_cx * sm_cy) / 8
      * round up to 8 pixel boundary so we can convert whole bytes */
     nBytes =
-        bits_to_bytes(pScreenPriv->cursor.sm_cx) * pScreenPriv->cursor.sm_cy;
+        bits_to_bytes(nWinCX) * nWinCY;
 
     /* Get the effective width and height */
-    nCX = min(pScreenPriv->cursor.sm_cx, pCursor->bits->width);
-    nCY = min(pScreenPriv->cursor.sm_cy, pCursor->bits->height);
+    nCX = min(nWinCX, pCursor->bits->width);
+    nCY = min(nWinCY, pCursor->bits->height);
 
     /* Allocate memory for the bitmaps */
     pAnd = malloc(nBytes);
@@ -203,7 +239,7 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
 
         for (y = 0; y < nCY; ++y)
             for (x = 0; x < xmax; ++x) {
-                int nWinPix = bits_to_bytes(pScreenPriv->cursor.sm_cx) * y + x;
+                int nWinPix = bits_to_bytes(nWinCX) * y + x;
                 int nXPix = BitmapBytePad(pCursor->bits->width) * y + x;
 
                 pAnd[nWinPix] = 0;
@@ -218,7 +254,7 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
 
         for (y = 0; y < nCY; ++y)
             for (x = 0; x < xmax; ++x) {
-                int nWinPix = bits_to_bytes(pScreenPriv->cursor.sm_cx) * y + x;
+                int nWinPix = bits_to_bytes(nWinCX) * y + x;
                 int nXPix = BitmapBytePad(pCursor->bits->width) * y + x;
 
                 unsigned char mask = pCursor->bits->mask[nXPix];
@@ -242,8 +278,8 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
         winDebug("winLoadCursor: Trying truecolor alphablended cursor\n"); 
         memset(&bi, 0, sizeof(BITMAPV4HEADER));
         bi.bV4Size = sizeof(BITMAPV4HEADER);
-        bi.bV4Width = pScreenPriv->cursor.sm_cx;
-        bi.bV4Height = -(pScreenPriv->cursor.sm_cy);    /* right-side up */
+        bi.bV4Width = nWinCX;
+        bi.bV4Height = -(nWinCY);    /* right-side up */
         bi.bV4Planes = 1;
         bi.bV4BitCount = 32;
         bi.bV4V4Compression = BI_BITFIELDS;
@@ -252,7 +288,7 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
         bi.bV4BlueMask = 0x000000FF;
         bi.bV4AlphaMask = 0xFF000000;
 
-        lpBits = calloc(pScreenPriv->cursor.sm_cx * pScreenPriv->cursor.sm_cy,
+        lpBits = calloc(nWinCX * nWinCY,
                         sizeof(uint32_t));
 
         if (lpBits) {
@@ -260,7 +296,7 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
             for (y = 0; y < nCY; y++) {
                 void *src, *dst;
                 src = &(pCursor->bits->argb[y * pCursor->bits->width]);
-                dst = &(lpBits[y * pScreenPriv->cursor.sm_cx]);
+                dst = &(lpBits[y * nWinCX]);
                 memcpy(dst, src, 4 * nCX);
             }
         }
@@ -275,8 +311,8 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
 
         memset(pbmi, 0, sizeof(BITMAPINFOHEADER));
         pbmi->bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        pbmi->bmiHeader.biWidth = pScreenPriv->cursor.sm_cx;
-        pbmi->bmiHeader.biHeight = -abs(pScreenPriv->cursor.sm_cy);     /* right-side up */
+        pbmi->bmiHeader.biWidth = nWinCX;
+        pbmi->bmiHeader.biHeight = -abs(nWinCY);     /* right-side up */
         pbmi->bmiHeader.biPlanes = 1;
         pbmi->bmiHeader.biBitCount = 8;
         pbmi->bmiHeader.biCompression = BI_RGB;
@@ -297,19 +333,19 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
         pbmiColors[2].rgbBlue = pCursor->foreBlue >> 8;
         pbmiColors[2].rgbReserved = 0;
 
-        lpBits = calloc(pScreenPriv->cursor.sm_cx * pScreenPriv->cursor.sm_cy, 1);
+        lpBits = calloc(nWinCX * nWinCY, 1);
 
         pCur = (unsigned char *) lpBits;
         if (lpBits) {
 	    int x, y;
-            for (y = 0; y < pScreenPriv->cursor.sm_cy; y++) {
-                for (x = 0; x < pScreenPriv->cursor.sm_cx; x++) {
+            for (y = 0; y < nWinCY; y++) {
+                for (x = 0; x < nWinCX; x++) {
                     if (x >= nCX || y >= nCY)   /* Outside of X11 icon bounds */
                         (*pCur++) = 0;
                     else {      /* Within X11 icon bounds */
 
                         int nWinPix =
-                            bits_to_bytes(pScreenPriv->cursor.sm_cx) * y +
+                            bits_to_bytes(nWinCX) * y +
                             (x / 8);
 
                         bit = pAnd[nWinPix];
@@ -345,15 +381,15 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
         hXor = NULL;
 
         hAnd =
-            CreateBitmap(pScreenPriv->cursor.sm_cx, pScreenPriv->cursor.sm_cy,
+            CreateBitmap(nWinCX, nWinCY,
                          1, 1, pAnd);
 
         hDC = GetDC(NULL);
         if (hDC) {
             hXor =
-                CreateCompatibleBitmap(hDC, pScreenPriv->cursor.sm_cx,
-                                       pScreenPriv->cursor.sm_cy);
-            SetDIBits(hDC, hXor, 0, pScreenPriv->cursor.sm_cy, lpBits,
+                CreateCompatibleBitmap(hDC, nWinCX,
+                                       nWinCY);
+            SetDIBits(hDC, hXor, 0, nWinCY, lpBits,
                       (BITMAPINFO *) &bi, DIB_RGB_COLORS);
             ReleaseDC(NULL, hDC);
         }
@@ -405,8 +441,8 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
            black and white instead */
         hCursor = CreateCursor(g_hInstance,
                                pCursor->bits->xhot, pCursor->bits->yhot,
-                               pScreenPriv->cursor.sm_cx,
-                               pScreenPriv->cursor.sm_cy, pAnd, pXor);
+                               nWinCX,
+                               nWinCY, pAnd, pXor);
         if (hCursor == NULL)
             winW32Error("winLoadCursor - CreateCursor failed:");
     }
@@ -416,6 +452,139 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
     return hCursor;
 }
 
+/*
+ * Hash what winLoadCursor looks at: the image and, for two colour
+ * cursors, the colours
+ */
+static uint64_t
+winCursorHash(CursorPtr pCursor)
+{
+    CursorBitsPtr bits = pCursor->bits;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i, n;
+
+    if (bits->argb) {
+        n = (size_t) bits->width * bits->height;
+        for (i = 0; i < n; i++)
+            hash = (hash ^ bits->argb[i]) * 0x100000001b3ULL;
+    }
+    else {
+        const unsigned short colors[6] = {
+            pCursor->foreRed, pCursor->foreGreen, pCursor->foreBlue,
+            pCursor->backRed, pCursor->backGreen, pCursor->backBlue
+        };
+
+        n = (size_t) BitmapBytePad(bits->width) * bits->height;
+        for (i = 0; i < n; i++)
+            hash = (hash ^ bits->source[i]) * 0x100000001b3ULL;
+        if (!bits->emptyMask)
+            for (i = 0; i < n; i++)
+                hash = (hash ^ bits->mask[i]) * 0x100000001b3ULL;
+        for (i = 0; i < ARRAY_SIZE(colors); i++)
+            hash = (hash ^ colors[i]) * 0x100000001b3ULL;
+        hash = (hash ^ bits->emptyMask) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * Get a Windows cursor for pCursor, converting it only if no cursor with
+ * the same image has been realized before.  Drop it with winReleaseCursor.
+ */
+static HCURSOR
+winAcquireCursor(ScreenPtr pScreen, CursorPtr pCursor)
+{
+    winScreenPriv(pScreen);
+    CursorBitsPtr bits = pCursor->bits;
+    uint64_t hash = winCursorHash(pCursor);
+    winCursorCacheRec *pEntry, *pVictim = NULL;
+    HCURSOR hCursor;
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; i++) {
+        pEntry = &s_cursorCache[i];
+
+        if (pEntry->hCursor && pEntry->hash == hash
+            && pEntry->width == bits->width && pEntry->height == bits->height
+            && pEntry->xhot == bits->xhot && pEntry->yhot == bits->yhot
+            && pEntry->sm_cx == pScreenPriv->cursor.sm_cx
+            && pEntry->sm_cy == pScreenPriv->cursor.sm_cy) {
+            pEntry->iRefs++;
+            pEntry->ulLastUse = ++s_ulCursorCacheClock;
+            return pEntry->hCursor;
+        }
+
+        /* Reuse an empty slot, or else the least recently used free one */
+        if (pEntry->iRefs == 0
+            && (!pVictim || (pVictim->hCursor
+                             && (!pEntry->hCursor
+                                 || pEntry->ulLastUse <
+                                 pVictim->ulLastUse))))
+            pVictim = pEntry;
+    }
+
+    hCursor = winLoadCursor(pScreen, pCursor, pScreen->myNum);
+    if (!hCursor || !pVictim)
+        return hCursor;
+
+    if (pVictim->hCursor)
+        DestroyCursor(pVictim->hCursor);
+    pVictim->hash = hash;
+    pVictim->width = bits->width;
+    pVictim->height = bits->height;
+    pVictim->xhot = bits->xhot;
+    pVictim->yhot = bits->yhot;
+    pVictim->sm_cx = pScreenPriv->cursor.sm_cx;
+    pVictim->sm_cy = pScreenPriv->cursor.sm_cy;
+    pVictim->hCursor = hCursor;
+    pVictim->iRefs = 1;
+    pVictim->ulLastUse = ++s_ulCursorCacheClock;
+
+    return hCursor;
+}
+
+static void
+winReleaseCursor(HCURSOR hCursor)
+{
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; i++)
+        if (s_cursorCache[i].hCursor == hCursor) {
+            if (s_cursorCache[i].iRefs > 0)
+                s_cursorCache[i].iRefs--;
+            return;
+        }
+
+    /* Not ours to keep */
+    DestroyCursor(hCursor);
+}
+
+/*
+ * Memory is low: destroy the cached cursors no cursor uses any more.  The
+ * size is what their colour and mask bitmaps take.
+ */
+static unsigned long
+winTrimCursorCache(void *closure)
+{
+    unsigned long ulBytes = 0;
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; i++) {
+        winCursorCacheRec *pEntry = &s_cursorCache[i];
+
+        if (pEntry->hCursor && pEntry->iRefs == 0) {
+            unsigned long ulCX = max(pEntry->sm_cx, pEntry->width);
+            unsigned long ulCY = max(pEntry->sm_cy, pEntry->height);
+
+            DestroyCursor(pEntry->hCursor);
+            pEntry->hCursor = NULL;
+            ulBytes += ulCX * ulCY * 4 + bits_to_bytes(ulCX) * ulCY;
+        }
+    }
+    return ulBytes;
+}
+
 /*
 ===========================================================================
 
@@ -424,9 +593,15 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
 ===========================================================================
 */
 
+#define winGetCursorHandle(pCursor, pScreen) ((HCURSOR) \
+    dixLookupScreenPrivate(&(pCursor)->devPrivates, CursorScreenKey, pScreen))
+
 /*
  * winRealizeCursor
  *  Convert the X cursor representation to native format if possible.
+ *  The handle is kept with the cursor, so setting it later is only a
+ *  SetCursor.  This is called once per pointer device; the first call
+ *  converts.
  */
 static Bool
 winRealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
@@ -434,7 +609,16 @@ winRealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
     if (pCursor == NULL || pCursor->bits == NULL)
         return FALSE;
 
-    /* FIXME: cache ARGB8888 representation? */
+    if (!winGetCursorHandle(pCursor, pScreen)) {
+        HCURSOR hCursor = winAcquireCursor(pScreen, pCursor);
+
+        if (!hCursor)
+            ErrorF("winRealizeCursor - no Windows cursor for a %dx%d "
+                   "cursor, the pointer is hidden while it is set\n",
+                   pCursor->bits->width, pCursor->bits->height);
+        dixSetScreenPrivate(&pCursor->devPrivates, CursorScreenKey, pScreen,
+                            hCursor);
+    }
 
     return TRUE;
 }
@@ -446,6 +630,18 @@ winRealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
 static Bool
 winUnrealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
 {
+    winScreenPriv(pScreen);
+    HCURSOR hCursor = winGetCursorHandle(pCursor, pScreen);
+
+    if (hCursor) {
+        /* Don't leave the screen pointing at a handle that may be gone */
+        if (pScreenPriv->cursor.handle == hCursor)
+            pScreenPriv->cursor.handle = NULL;
+        winReleaseCursor(hCursor);
+        dixSetScreenPrivate(&pCursor->devPrivates, CursorScreenKey, pScreen,
+                            NULL);
+    }
+
     return TRUE;
 }
 
@@ -497,14 +693,8 @@ winSetCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor, int x,
         }
     }
     else {
-        if (pScreenPriv->cursor.handle) {
-            if (!bInhibit)
-                SetCursor(NULL);
-            DestroyCursor(pScreenPriv->cursor.handle);
-            pScreenPriv->cursor.handle = NULL;
-        }
-        pScreenPriv->cursor.handle =
-            winLoadCursor(pScreen, pCursor, pScreen->myNum);
+        /* The realized cursor owns the handle */
+        pScreenPriv->cursor.handle = winGetCursorHandle(pCursor, pScreen);
         winDebug("winSetCursor: handle=%p\n", pScreenPriv->cursor.handle); 
 
         if (!bInhibit)
@@ -527,18 +717,19 @@ winMoveCursor(DeviceIntPtr pDev, ScreenPtr pScreen, int x, int y)
 {
 }
 
+/*
+ * winDeviceCursorInitialize, winDeviceCursorCleanup
+ *  Windows draws the cursor, so there is no per-device sprite state.
+ */
 static Bool
 winDeviceCursorInitialize(DeviceIntPtr pDev, ScreenPtr pScr)
 {
-    winScreenPriv(pScr);
-    return pScreenPriv->cursor.spriteFuncs->DeviceCursorInitialize(pDev, pScr);
+    return TRUE;
 }
 
 static void
 winDeviceCursorCleanup(DeviceIntPtr pDev, ScreenPtr pScr)
 {
-    winScreenPriv(pScr);
-    pScreenPriv->cursor.spriteFuncs->DeviceCursorCleanup(pDev, pScr);
 }
 
 static miPointerSpriteFuncRec winSpriteFuncsRec = {
@@ -581,31 +772,30 @@ winCursorQueryBestSize(int class, unsigned short *width,
 
 /*
  * winInitCursor
- *  Initialize cursor support
+ *  Initialize cursor support.  The pointer sprite is the Windows cursor,
+ *  so the mi software sprite, which saves and restores the screen under
+ *  the cursor on every move, is not installed at all.
  */
 Bool
 winInitCursor(ScreenPtr pScreen)
 {
     winScreenPriv(pScreen);
-    miPointerScreenPtr pPointPriv;
+
+    if (!miPointerInitialize(pScreen, &winSpriteFuncsRec,
+                             &g_winPointerCursorFuncs, TRUE))
+        return FALSE;
 
     /* override some screen procedures */
     pScreenPriv->cursor.QueryBestSize = pScreen->QueryBestSize;
     pScreen->QueryBestSize = winCursorQueryBestSize;
 
-    pPointPriv = (miPointerScreenPtr)
-        dixLookupPrivate(&pScreen->devPrivates, miPointerScreenKey);
-
-    if (pPointPriv)
-    {
-        pScreenPriv->cursor.spriteFuncs = pPointPriv->spriteFuncs;
-        pPointPriv->spriteFuncs = &winSpriteFuncsRec;
-    }
     pScreenPriv->cursor.handle = NULL;
     pScreenPriv->cursor.visible = FALSE;
 
     pScreenPriv->cursor.sm_cx = GetSystemMetrics(SM_CXCURSOR);
     pScreenPriv->cursor.sm_cy = GetSystemMetrics(SM_CYCURSOR);
 
+    RegisterCacheTrim("XWin cursors", 30, winTrimCursorCache, NULL);
+
     return TRUE;
 }
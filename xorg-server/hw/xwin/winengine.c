@@ -40,12 +40,24 @@
  */
 FARPROC g_fpDirectDrawCreate = NULL;
 FARPROC g_fpDirectDrawCreateClipper = NULL;
+FARPROC g_fpD3D11CreateDevice = NULL;
+static FARPROC g_fpCreateDXGIFactory1 = NULL;
 
 /*
   module handle for dynamically loaded directdraw library
 */
 static HMODULE g_hmodDirectDraw = NULL;
 
+/*
+  module handles for dynamically loaded direct3d 11 and dxgi libraries
+*/
+static HMODULE g_hmodD3D11 = NULL;
+static HMODULE g_hmodDXGI = NULL;
+
+/* IID_IDXGIFactory2, so that we do not need dxgi1_2.h here */
+static const GUID g_iidIDXGIFactory2 =
+    { 0x50c83a1c, 0xe072, 0x4c48, {0x87, 0xb0, 0x36, 0x30, 0xfa, 0x36, 0xa6, 0xd0} };
+
 /*
  * Detect engines supported by current Windows version
  * DirectDraw version and hardware
@@ -57,6 +69,24 @@ winDetectSupportedEngines(void)
     /* Initialize the engine support flags */
     g_dwEnginesSupported = WIN_SERVER_SHADOW_GDI;
 
+    /*
+     * Do we have DXGI 1.2?  Flip-model swap chains need an IDXGIFactory2,
+     * which is only available from Windows 8 on.
+     */
+    if (g_fpD3D11CreateDevice != NULL && g_fpCreateDXGIFactory1 != NULL) {
+        IUnknown *pFactory = NULL;
+        HRESULT hr;
+
+        hr = (*g_fpCreateDXGIFactory1) (&g_iidIDXGIFactory2,
+                                        (void **) &pFactory);
+        if (SUCCEEDED(hr)) {
+            winDebug (
+                      "winDetectSupportedEngines - DXGI 1.2 installed, allowing ShadowDXGI\n");
+            g_dwEnginesSupported |= WIN_SERVER_SHADOW_DXGI;
+            pFactory->lpVtbl->Release(pFactory);
+        }
+    }
+
     /* Do we have DirectDraw? */
     if (g_hmodDirectDraw != NULL) {
         LPDIRECTDRAW lpdd = NULL;
@@ -172,6 +202,21 @@ winSetEngine(ScreenPtr pScreen)
         case WIN_SERVER_SHADOW_DDNL:
             winSetEngineFunctionsShadowDDNL(pScreen);
             break;
+        case WIN_SERVER_SHADOW_DXGI:
+            /*
+             * The swap chain is anchored at the top-left of the client
+             * area, so it cannot follow the scrollbars.
+             */
+            if (!(g_dwEnginesSupported & WIN_SERVER_SHADOW_DXGI)
+                || pScreenInfo->iResizeMode == resizeWithScrollbars) {
+                ErrorF ("winSetEngine - ShadowDXGI is not available with "
+                        "this configuration, using Shadow GDI DIB\n");
+                pScreenInfo->dwEngine = WIN_SERVER_SHADOW_GDI;
+                winSetEngineFunctionsShadowGDI(pScreen);
+                break;
+            }
+            winSetEngineFunctionsShadowDXGI(pScreen);
+            break;
         default:
             FatalError ("winSetEngine - Invalid engine type %d\n",pScreenInfo->dwEngine);
         }
@@ -261,3 +306,53 @@ winReleaseDDProcAddresses(void)
         g_fpDirectDrawCreateClipper = NULL;
     }
 }
+
+/*
+ * Get procedure addresses for D3D11CreateDevice and CreateDXGIFactory1
+ */
+
+Bool
+winGetDXGIProcAddresses(void)
+{
+    /* Load the Direct3D 11 and DXGI libraries */
+    g_hmodD3D11 = LoadLibraryEx("d3d11.dll", NULL, 0);
+    g_hmodDXGI = LoadLibraryEx("dxgi.dll", NULL, 0);
+    if (g_hmodD3D11 == NULL || g_hmodDXGI == NULL) {
+        winDebug("winGetDXGIProcAddresses - Could not load d3d11.dll or "
+                 "dxgi.dll\n");
+        winReleaseDXGIProcAddresses();
+        return FALSE;
+    }
+
+    g_fpD3D11CreateDevice = GetProcAddress(g_hmodD3D11, "D3D11CreateDevice");
+    g_fpCreateDXGIFactory1 = GetProcAddress(g_hmodDXGI, "CreateDXGIFactory1");
+    if (g_fpD3D11CreateDevice == NULL || g_fpCreateDXGIFactory1 == NULL) {
+        ErrorF("winGetDXGIProcAddresses - Could not get D3D11CreateDevice "
+               "or CreateDXGIFactory1 address\n");
+        winReleaseDXGIProcAddresses();
+        return FALSE;
+    }
+
+    /*
+     * Note: Do not unload the libraries here.  Do it in GiveUp
+     */
+
+    return TRUE;
+}
+
+void
+winReleaseDXGIProcAddresses(void)
+{
+    g_fpD3D11CreateDevice = NULL;
+    g_fpCreateDXGIFactory1 = NULL;
+
+    if (g_hmodD3D11 != NULL) {
+        FreeLibrary(g_hmodD3D11);
+        g_hmodD3D11 = NULL;
+    }
+
+    if (g_hmodDXGI != NULL) {
+        FreeLibrary(g_hmodDXGI);
+        g_hmodDXGI = NULL;
+    }
+}
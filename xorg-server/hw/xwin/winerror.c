@@ -34,6 +34,7 @@
 
 #include <../xfree86/common/xorgVersion.h>
 #include "win.h"
+#include "winlock.h"
 
 #ifdef DDXOSVERRORF
 void
@@ -41,16 +42,16 @@ OsVendorVErrorF(const char *pszFormat, va_list va_args)
 {
     /* make sure the clipboard and multiwindow threads do not interfere the
      * main thread */
-    static pthread_mutex_t s_pmPrinting = PTHREAD_MUTEX_INITIALIZER;
+    static winMtx s_pmPrinting = WIN_MTX_INITIALIZER("log");
 
     /* Lock the printing mutex */
-    pthread_mutex_lock(&s_pmPrinting);
+    winMtxLock(&s_pmPrinting);
 
     /* Print the error message to a log file, could be stderr */
     LogVWrite(0, pszFormat, va_args);
 
     /* Unlock the printing mutex */
-    pthread_mutex_unlock(&s_pmPrinting);
+    winMtxUnlock(&s_pmPrinting);
 }
 #endif
 
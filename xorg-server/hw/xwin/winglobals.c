@@ -77,8 +77,14 @@ DWORD g_dwCurrentThreadID = 0;
 Bool g_fKeyboardHookLL = FALSE;
 Bool g_fNoHelpMessageBox = FALSE;
 Bool g_fSoftwareCursor = FALSE;
+Bool g_fMouseHistory = FALSE;
 Bool g_fNativeGl = TRUE;
 Bool g_fswrastwgl = FALSE;
+const char *g_pszGLHud = NULL;
+const char *g_pszGLHudLog = NULL;
+const char *g_pszShadowLog = NULL;
+int g_iLatencySLO = 0;
+HANDLE g_hReadyEvent = NULL;
 Bool g_fHostInTitle = TRUE;
 pthread_mutex_t g_pmTerminating = PTHREAD_MUTEX_INITIALIZER;
 
@@ -58,6 +58,11 @@ extern Bool g_fCompositeAlpha;
 extern Bool g_fNoHelpMessageBox;
 extern Bool g_fNativeGl;
 extern Bool g_fswrastwgl;
+extern const char *g_pszGLHud;
+extern const char *g_pszGLHudLog;
+extern const char *g_pszShadowLog;
+extern int g_iLatencySLO;
+extern HANDLE g_hReadyEvent;
 extern Bool g_fHostInTitle;
 
 extern HWND g_hDlgDepthChange;
@@ -65,6 +70,7 @@ extern HWND g_hDlgExit;
 extern HWND g_hDlgAbout;
 
 extern Bool g_fSoftwareCursor;
+extern Bool g_fMouseHistory;
 extern Bool g_fCursor;
 
 /* Typedef for DIX wrapper functions */
@@ -176,6 +176,7 @@ winKeybdProc(DeviceIntPtr pDeviceInt, int iState)
         else {
             winDebug ("winKeybdProc - Error initializing keyboard AutoRepeat\n");
         }
+        winStartupMark("keymap");
 
         break;
 
@@ -515,6 +516,8 @@ winSendKeyEvent(DWORD dwKey, Bool fDown)
     /* Update the keyState map */
     g_winKeyState[dwKey] = fDown;
 
+    if (fDown)
+        winLatencyInput();
     QueueKeyboardEvents(g_pwinKeyboard, fDown ? KeyPress : KeyRelease,
                         dwKey + MIN_KEYCODE);
 
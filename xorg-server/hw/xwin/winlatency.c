@@ -0,0 +1,338 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Input-to-screen latency.
+ *
+ * A sample follows one key or button press through the server: it starts
+ * when Windows queued the message, which is earlier than the wndproc sees
+ * it by however long the message waited; the event reaches the first
+ * client it is delivered to; that client then draws on the screen pixmap;
+ * and the sample ends with the next shadow update of that screen, which
+ * is when the drawing goes to Windows.  Each finished sample goes into a
+ * histogram, reported from the tray menu with the engine statistics and
+ * at exit, and into an ETW event.  With -latencyslo, samples slower than
+ * the threshold are also logged as warnings naming the client.
+ *
+ * There is one sample at a time, so presses that come while a sample is
+ * in flight are not measured separately; the earliest unanswered press is
+ * the one the user is waiting on.  A press that no drawing answers within
+ * WIN_LATENCY_ABANDON_MS is given up and counted as unanswered.  Drawing
+ * that goes around the screen pixmap (direct GL, -compositewm top-level
+ * pixmaps) is not seen, and neither is drawing a client does for a
+ * reason other than the press, so the numbers are an approximation.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#include "win.h"
+#include "winmsg.h"
+#include "wintrace.h"
+#include "damage.h"
+#include <X11/extensions/XI2.h>
+#include <X11/extensions/XIproto.h>
+
+#define WIN_LATENCY_BUCKETS     14      /* up to 2^13 ms, about 8 s */
+#define WIN_LATENCY_ABANDON_MS  2000
+#define WIN_LATENCY_WARN_MS     1000    /* at most one warning this often */
+
+typedef enum {
+    WIN_LATENCY_IDLE,
+    WIN_LATENCY_INPUT,          /* queued, not delivered yet */
+    WIN_LATENCY_DELIVERED,      /* waiting for the client to draw */
+    WIN_LATENCY_DRAWN           /* waiting for the screen update */
+} winLatencyState;
+
+static struct {
+    winLatencyState state;
+    LARGE_INTEGER liInput, liDelivered, liDrawn;
+    ClientPtr pClient;
+    ScreenPtr pScreen;          /* the screen drawn on */
+    DamagePtr apDamage[MAXSCREENS];
+} s_sample;
+
+static struct {
+    unsigned long samples;
+    unsigned long unanswered;
+    unsigned long long delivery, response, present;    /* ms */
+    unsigned long max;
+    CARD32 hist[WIN_LATENCY_BUCKETS];   /* hist[i]: under 2^i ms */
+} s_stats;
+
+static LARGE_INTEGER s_liFrequency;
+static int s_iXIReqCode;
+static DWORD s_dwLastWarning;
+static unsigned long s_ulWarningsSuppressed;
+
+static unsigned long
+winLatencyMillis(LARGE_INTEGER liFrom, LARGE_INTEGER liTo)
+{
+    return (unsigned long) ((liTo.QuadPart - liFrom.QuadPart) * 1000 /
+                            s_liFrequency.QuadPart);
+}
+
+static void
+winLatencyDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    ScreenPtr pScreen = closure;
+
+    /* The screen pixmap went away with the damage still on it */
+    s_sample.apDamage[pScreen->myNum] = NULL;
+}
+
+/* End the sample and stop watching the screens */
+static void
+winLatencyReset(void)
+{
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        DamagePtr pDamage = s_sample.apDamage[i];
+
+        if (pDamage) {
+            s_sample.apDamage[i] = NULL;
+            DamageDestroy(pDamage);
+        }
+    }
+    s_sample.state = WIN_LATENCY_IDLE;
+    s_sample.pClient = NULL;
+    s_sample.pScreen = NULL;
+}
+
+/*
+ * Something was drawn on a screen that was clean.  If the client drew
+ * it, that's the answer; otherwise empty the damage so the next drawing
+ * is reported too.
+ */
+static void
+winLatencyDamage(DamagePtr pDamage, RegionPtr pRegion, void *closure)
+{
+    if (s_sample.state == WIN_LATENCY_DELIVERED &&
+        GetCurrentClient() == s_sample.pClient) {
+        QueryPerformanceCounter(&s_sample.liDrawn);
+        s_sample.pScreen = closure;
+        s_sample.state = WIN_LATENCY_DRAWN;
+        return;
+    }
+    DamageEmpty(pDamage);
+}
+
+static void
+winLatencyWatchScreens(void)
+{
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        ScreenPtr pScreen = screenInfo.screens[i];
+        PixmapPtr pPixmap = pScreen->devPrivate;
+        DamagePtr pDamage;
+
+        if (!pPixmap)
+            continue;
+        pDamage = DamageCreate(winLatencyDamage, winLatencyDamageDestroy,
+                               DamageReportNonEmpty, TRUE, pScreen, pScreen);
+        if (!pDamage)
+            continue;
+        DamageRegister(&pPixmap->drawable, pDamage);
+        s_sample.apDamage[i] = pDamage;
+    }
+}
+
+static Bool
+winLatencyIsPress(xEvent *pEvent)
+{
+    if (pEvent->u.u.type == KeyPress || pEvent->u.u.type == ButtonPress)
+        return TRUE;
+    if (pEvent->u.u.type == GenericEvent && s_iXIReqCode) {
+        xGenericEvent *pGeneric = (xGenericEvent *) pEvent;
+
+        return pGeneric->extension == s_iXIReqCode &&
+            (pGeneric->evtype == XI_KeyPress ||
+             pGeneric->evtype == XI_ButtonPress);
+    }
+    return FALSE;
+}
+
+/* The press went out to its first client */
+static void
+winLatencyEventCallback(CallbackListPtr *pcbl, void *pData, void *pArgs)
+{
+    EventInfoRec *pInfo = pArgs;
+
+    if (s_sample.state != WIN_LATENCY_INPUT || pInfo->count < 1 ||
+        pInfo->client == serverClient || !winLatencyIsPress(pInfo->events))
+        return;
+
+    QueryPerformanceCounter(&s_sample.liDelivered);
+    s_sample.pClient = pInfo->client;
+    s_sample.state = WIN_LATENCY_DELIVERED;
+    winLatencyWatchScreens();
+}
+
+/*
+ * Called at every server generation, since the callback lists are freed
+ * at reset
+ */
+void
+winLatencyInit(void)
+{
+    ExtensionEntry *pExtension;
+
+    if (!s_liFrequency.QuadPart)
+        QueryPerformanceFrequency(&s_liFrequency);
+    s_sample.state = WIN_LATENCY_IDLE;
+    s_sample.pClient = NULL;
+    memset(s_sample.apDamage, 0, sizeof(s_sample.apDamage));
+
+    pExtension = CheckExtension(INAME);
+    s_iXIReqCode = pExtension ? pExtension->base : 0;
+
+    AddCallback(&EventCallback, winLatencyEventCallback, NULL);
+}
+
+/*
+ * A key or button press is being queued, from a wndproc.  Start a sample
+ * unless one is in flight.
+ */
+void
+winLatencyInput(void)
+{
+    LARGE_INTEGER liNow;
+    DWORD dwQueued;
+
+    if (!s_liFrequency.QuadPart)
+        return;
+
+    QueryPerformanceCounter(&liNow);
+    if (s_sample.state != WIN_LATENCY_IDLE) {
+        if (winLatencyMillis(s_sample.liInput, liNow) < WIN_LATENCY_ABANDON_MS)
+            return;
+        s_stats.unanswered++;
+        winLatencyReset();
+    }
+
+    /* Count the time the message spent in the queue, if it makes sense */
+    dwQueued = GetTickCount() - (DWORD) GetMessageTime();
+    if (dwQueued >= WIN_LATENCY_ABANDON_MS)
+        dwQueued = 0;
+    s_sample.liInput.QuadPart =
+        liNow.QuadPart - dwQueued * s_liFrequency.QuadPart / 1000;
+    s_sample.state = WIN_LATENCY_INPUT;
+}
+
+static void
+winLatencyWarn(unsigned long ulTotal, unsigned long ulDelivery,
+               unsigned long ulResponse, unsigned long ulPresent)
+{
+    ClientPtr pClient = s_sample.pClient;
+    const char *pszName = GetClientCmdName(pClient);
+    DWORD dwNow = GetTickCount();
+
+    if (s_dwLastWarning && dwNow - s_dwLastWarning < WIN_LATENCY_WARN_MS) {
+        s_ulWarningsSuppressed++;
+        return;
+    }
+    s_dwLastWarning = dwNow;
+
+    LogMessageVerb(X_WARNING, 0, "latency: %lu ms from input to screen "
+                   "for client %d (%s): %lu ms to deliver, %lu ms to draw, "
+                   "%lu ms to update the screen; %lu slow samples not "
+                   "logged since the last one\n",
+                   ulTotal, pClient->index, pszName ? pszName : "unknown",
+                   ulDelivery, ulResponse, ulPresent, s_ulWarningsSuppressed);
+    s_ulWarningsSuppressed = 0;
+}
+
+/*
+ * A shadow update of pScreen has just finished.  If it shows the drawing
+ * the sample waits for, the sample is complete.
+ */
+void
+winLatencyPresent(ScreenPtr pScreen)
+{
+    LARGE_INTEGER liNow;
+    unsigned long ulDelivery, ulResponse, ulPresent, ulTotal;
+    const char *pszName;
+    int i;
+
+    if (s_sample.state != WIN_LATENCY_DRAWN || s_sample.pScreen != pScreen)
+        return;
+
+    QueryPerformanceCounter(&liNow);
+    ulDelivery = winLatencyMillis(s_sample.liInput, s_sample.liDelivered);
+    ulResponse = winLatencyMillis(s_sample.liDelivered, s_sample.liDrawn);
+    ulPresent = winLatencyMillis(s_sample.liDrawn, liNow);
+    ulTotal = winLatencyMillis(s_sample.liInput, liNow);
+
+    for (i = 0; i < WIN_LATENCY_BUCKETS - 1; i++)
+        if (ulTotal < (1UL << i))
+            break;
+    s_stats.hist[i]++;
+    s_stats.samples++;
+    s_stats.delivery += ulDelivery;
+    s_stats.response += ulResponse;
+    s_stats.present += ulPresent;
+    if (ulTotal > s_stats.max)
+        s_stats.max = ulTotal;
+
+    pszName = GetClientCmdName(s_sample.pClient);
+    WinTrace("InputLatency",
+             TraceLoggingUInt32(ulTotal, "TotalMs"),
+             TraceLoggingUInt32(ulDelivery, "DeliveryMs"),
+             TraceLoggingUInt32(ulResponse, "ClientMs"),
+             TraceLoggingUInt32(ulPresent, "PresentMs"),
+             TraceLoggingInt32(s_sample.pClient->index, "Client"),
+             TraceLoggingString(pszName ? pszName : "", "ClientName"));
+
+    if (g_iLatencySLO > 0 && ulTotal > (unsigned long) g_iLatencySLO)
+        winLatencyWarn(ulTotal, ulDelivery, ulResponse, ulPresent);
+
+    winLatencyReset();
+}
+
+/* Upper bound of the bucket holding the sample at rank want */
+static unsigned long
+winLatencyPercentile(unsigned long want)
+{
+    unsigned long seen = 0;
+    int i;
+
+    for (i = 0; i < WIN_LATENCY_BUCKETS - 1; i++) {
+        seen += s_stats.hist[i];
+        if (seen >= want)
+            return (1UL << i) < s_stats.max ? (1UL << i) : s_stats.max;
+    }
+    return s_stats.max;
+}
+
+/*
+ * Log the latency histogram and start counting afresh
+ */
+void
+winLatencyReport(void)
+{
+    unsigned long n = s_stats.samples;
+    int i;
+
+    if (!n && !s_stats.unanswered)
+        return;
+
+    LogMessageVerb(X_INFO, 0, "latency: %lu presses answered, %lu not; "
+                   "input to screen p50 %lu ms, p99 %lu ms, max %lu ms\n",
+                   n, s_stats.unanswered,
+                   n ? winLatencyPercentile((n + 1) / 2) : 0,
+                   n ? winLatencyPercentile((n * 99 + 99) / 100) : 0,
+                   s_stats.max);
+    if (n) {
+        LogMessageVerb(X_INFO, 0, "latency: average %llu ms to deliver, "
+                       "%llu ms for the client to draw, %llu ms to update "
+                       "the screen\n", s_stats.delivery / n,
+                       s_stats.response / n, s_stats.present / n);
+        for (i = 0; i < WIN_LATENCY_BUCKETS; i++)
+            if (s_stats.hist[i])
+                LogMessageVerb(X_INFO, 0, "latency:   under %5lu ms: %u\n",
+                               1UL << i, (unsigned) s_stats.hist[i]);
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+}
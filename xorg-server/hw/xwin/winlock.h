@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Native locks for the XWin threads.
+ *
+ * The main thread, the WM threads and the clipboard thread share a few
+ * small structures (the WM message queue, the icon cache, the log).
+ * pthread mutexes and condition variables from the bundled emulation
+ * library cost a kernel object and several interlocked operations each;
+ * an SRWLOCK and a CONDITION_VARIABLE are one pointer, need no setup or
+ * teardown, and stay in user mode when uncontended.
+ *
+ * The calls follow C11 threads.h: winMtxLock/winMtxUnlock, winCndWait/
+ * winCndSignal.  While an ETW session records the VcXsrv.XServer
+ * provider, every unlock reports how long the lock was held, and every
+ * contended lock how long it waited, as "LockHeld" and "LockWait".
+ *
+ * These locks are not owned by a thread: don't use them where a lock is
+ * released by another thread than the one that took it, as with
+ * pmServerStarted, and don't take one recursively.
+ */
+
+#ifndef WINLOCK_H
+#define WINLOCK_H
+
+#include <X11/Xwindows.h>
+#include "wintrace.h"
+
+typedef struct {
+    SRWLOCK lock;
+    const char *pszName;
+    LONGLONG llAcquired;        /* performance counter, 0 if not tracing */
+} winMtx;
+
+typedef CONDITION_VARIABLE winCnd;
+
+#define WIN_MTX_INITIALIZER(name) { SRWLOCK_INIT, name, 0 }
+
+static inline void
+winMtxInit(winMtx * pm, const char *pszName)
+{
+    InitializeSRWLock(&pm->lock);
+    pm->pszName = pszName;
+    pm->llAcquired = 0;
+}
+
+static inline LONGLONG
+winMtxMicros(LONGLONG llTicks)
+{
+    LARGE_INTEGER liFreq;
+
+    QueryPerformanceFrequency(&liFreq);
+    return llTicks * 1000000 / liFreq.QuadPart;
+}
+
+static inline void
+winMtxLock(winMtx * pm)
+{
+    LARGE_INTEGER liStart, liNow;
+
+    if (!WinTraceEnabled()) {
+        AcquireSRWLockExclusive(&pm->lock);
+        pm->llAcquired = 0;
+        return;
+    }
+
+    if (!TryAcquireSRWLockExclusive(&pm->lock)) {
+        QueryPerformanceCounter(&liStart);
+        AcquireSRWLockExclusive(&pm->lock);
+        QueryPerformanceCounter(&liNow);
+        WinTrace("LockWait", TraceLoggingString(pm->pszName, "Lock"),
+                 TraceLoggingInt64(winMtxMicros(liNow.QuadPart -
+                                                liStart.QuadPart),
+                                   "Microseconds"));
+    }
+    else
+        QueryPerformanceCounter(&liNow);
+    pm->llAcquired = liNow.QuadPart;
+}
+
+static inline void
+winMtxUnlock(winMtx * pm)
+{
+    LONGLONG llAcquired = pm->llAcquired;
+
+    pm->llAcquired = 0;
+    ReleaseSRWLockExclusive(&pm->lock);
+
+    if (llAcquired) {
+        LARGE_INTEGER liNow;
+
+        QueryPerformanceCounter(&liNow);
+        WinTrace("LockHeld", TraceLoggingString(pm->pszName, "Lock"),
+                 TraceLoggingInt64(winMtxMicros(liNow.QuadPart - llAcquired),
+                                   "Microseconds"));
+    }
+}
+
+static inline void
+winCndInit(winCnd * pc)
+{
+    InitializeConditionVariable(pc);
+}
+
+/* Waiting doesn't count as holding the lock */
+static inline void
+winCndWait(winCnd * pc, winMtx * pm)
+{
+    LARGE_INTEGER liNow;
+
+    pm->llAcquired = 0;
+    SleepConditionVariableSRW(pc, &pm->lock, INFINITE, 0);
+    if (WinTraceEnabled()) {
+        QueryPerformanceCounter(&liNow);
+        pm->llAcquired = liNow.QuadPart;
+    }
+}
+
+static inline void
+winCndSignal(winCnd * pc)
+{
+    WakeConditionVariable(pc);
+}
+
+#endif                          /* WINLOCK_H */
@@ -78,3 +78,222 @@ winUpdateFBPointer(ScreenPtr pScreen, void *pbits)
 
     return TRUE;
 }
+
+/*
+ * Reduce a damage region to a box list that is cheap to blit.
+ *
+ * Each blit has a fixed setup cost, which we express as a number of
+ * pixels.  Boxes are merged into their bounding box whenever the extra
+ * pixels copied cost less than the call that is saved.  Only the last
+ * few output boxes are considered as merge candidates, which catches the
+ * neighbours in the same and previous band of the region.
+ *
+ * Returns the number of boxes in *ppBox.  The storage is owned by this
+ * function and is only valid until the next call.
+ */
+
+#define WIN_COALESCE_WINDOW	8
+
+#define WIN_BOX_AREA(x1, y1, x2, y2) \
+    ((unsigned long) ((x2) - (x1)) * (unsigned long) ((y2) - (y1)))
+
+DWORD
+winCoalesceDamageBoxes(RegionPtr pRegion, BoxPtr *ppBox)
+{
+    static BoxPtr s_pBox = NULL;
+    static DWORD s_dwBoxMax = 0;
+    DWORD dwBoxIn = RegionNumRects(pRegion);
+    BoxPtr pBoxIn = RegionRects(pRegion);
+    DWORD dwBoxOut = 0;
+    DWORD i;
+
+    if (dwBoxIn > s_dwBoxMax) {
+        BoxPtr pBoxNew = realloc(s_pBox, dwBoxIn * sizeof(BoxRec));
+
+        if (pBoxNew) {
+            s_pBox = pBoxNew;
+            s_dwBoxMax = dwBoxIn;
+        }
+    }
+    /* Nothing to gain from one box, or when we can't get storage */
+    if (dwBoxIn <= 1 || dwBoxIn > s_dwBoxMax) {
+        *ppBox = pBoxIn;
+        return dwBoxIn;
+    }
+
+    for (i = 0; i < dwBoxIn; ++i) {
+        BoxPtr pBox = &pBoxIn[i];
+        unsigned long ulArea = WIN_BOX_AREA(pBox->x1, pBox->y1,
+                                            pBox->x2, pBox->y2);
+        unsigned long ulBestWaste = WIN_BLT_BOX_COST;
+        DWORD dwBest = dwBoxOut;
+        DWORD j = dwBoxOut > WIN_COALESCE_WINDOW
+            ? dwBoxOut - WIN_COALESCE_WINDOW : 0;
+
+        for (; j < dwBoxOut; ++j) {
+            BoxPtr pOut = &s_pBox[j];
+            short x1 = min(pOut->x1, pBox->x1);
+            short y1 = min(pOut->y1, pBox->y1);
+            short x2 = max(pOut->x2, pBox->x2);
+            short y2 = max(pOut->y2, pBox->y2);
+            unsigned long ulUnion = WIN_BOX_AREA(x1, y1, x2, y2);
+            unsigned long ulOut = WIN_BOX_AREA(pOut->x1, pOut->y1,
+                                               pOut->x2, pOut->y2);
+            unsigned long ulWaste;
+
+            /* Overlapping boxes make the waste estimate go negative */
+            if (ulUnion <= ulOut + ulArea)
+                ulWaste = 0;
+            else
+                ulWaste = ulUnion - ulOut - ulArea;
+
+            if (ulWaste < ulBestWaste) {
+                ulBestWaste = ulWaste;
+                dwBest = j;
+            }
+        }
+
+        if (dwBest < dwBoxOut) {
+            BoxPtr pOut = &s_pBox[dwBest];
+
+            pOut->x1 = min(pOut->x1, pBox->x1);
+            pOut->y1 = min(pOut->y1, pBox->y1);
+            pOut->x2 = max(pOut->x2, pBox->x2);
+            pOut->y2 = max(pOut->y2, pBox->y2);
+        }
+        else
+            s_pBox[dwBoxOut++] = *pBox;
+    }
+
+    *ppBox = s_pBox;
+    return dwBoxOut;
+}
+
+/*
+ * Remove from a shadow update region the tiles whose contents are the
+ * same as when they were last updated.
+ *
+ * The shadow fb is split into WIN_TILE_SIZE square tiles and a checksum
+ * of each damaged tile is compared against the one taken the last time
+ * it was damaged.  Clients that repaint identical content every frame
+ * then cost a read of the shadow fb instead of a blit each.
+ */
+
+#define WIN_TILE_SIZE		64
+
+static CARD64
+winTileChecksum(const char *pb, DWORD dwPitch, int iBytes, int iRows)
+{
+    CARD64 ullSum = 0xcbf29ce484222325ULL;
+
+    while (iRows--) {
+        const char *pbRow = pb;
+        int i;
+
+        for (i = 0; i + 8 <= iBytes; i += 8) {
+            CARD64 ullWord;
+
+            memcpy(&ullWord, pbRow + i, 8);
+            ullSum = (ullSum ^ ullWord) * 0x100000001b3ULL;
+        }
+        for (; i < iBytes; ++i)
+            ullSum = (ullSum ^ (CARD8) pbRow[i]) * 0x100000001b3ULL;
+
+        pb += dwPitch;
+    }
+
+    /* Zero marks a tile that has never been summed */
+    return ullSum | 1;
+}
+
+void
+winSkipUnchangedTiles(ScreenPtr pScreen, RegionPtr pRegion)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    static BoxPtr s_pBox = NULL;
+    static int s_iBoxMax = 0;
+    int iBytesPP = pScreenInfo->dwBPP / 8;
+    DWORD dwPitch = pScreenInfo->dwStride * iBytesPP;
+    int iCols = (pScreen->width + WIN_TILE_SIZE - 1) / WIN_TILE_SIZE;
+    int iRows = (pScreen->height + WIN_TILE_SIZE - 1) / WIN_TILE_SIZE;
+    int nBox = RegionNumRects(pRegion);
+    BoxPtr pBox = RegionRects(pRegion);
+    int nSame = 0;
+    int iTile;
+    RegionRec rgnSame;
+
+    if (!pScreenInfo->pfb || iBytesPP == 0)
+        return;
+
+    /* Start over when the shadow fb is reallocated or resized */
+    if (!pScreenPriv->pTileSums
+        || pScreenPriv->pTileSumsFB != pScreenInfo->pfb
+        || pScreenPriv->iTileCols != iCols || pScreenPriv->iTileRows != iRows) {
+        free(pScreenPriv->pTileSums);
+        pScreenPriv->pTileSums = calloc(iCols * iRows, sizeof(CARD64));
+        if (!pScreenPriv->pTileSums)
+            return;
+        pScreenPriv->pTileSumsFB = pScreenInfo->pfb;
+        pScreenPriv->iTileCols = iCols;
+        pScreenPriv->iTileRows = iRows;
+    }
+
+    if (iCols * iRows > s_iBoxMax) {
+        BoxPtr pBoxNew = realloc(s_pBox, iCols * iRows * sizeof(BoxRec));
+
+        if (!pBoxNew)
+            return;
+        s_pBox = pBoxNew;
+        s_iBoxMax = iCols * iRows;
+    }
+
+    /* Mark the damaged tiles; x1 of the box list doubles as the flag */
+    for (iTile = 0; iTile < iCols * iRows; ++iTile)
+        s_pBox[iTile].x1 = 0;
+    while (nBox--) {
+        int iX1 = max(pBox->x1, 0) / WIN_TILE_SIZE;
+        int iY1 = max(pBox->y1, 0) / WIN_TILE_SIZE;
+        int iX2 = min((pBox->x2 - 1) / WIN_TILE_SIZE, iCols - 1);
+        int iY2 = min((pBox->y2 - 1) / WIN_TILE_SIZE, iRows - 1);
+        int iX, iY;
+
+        for (iY = iY1; iY <= iY2; ++iY)
+            for (iX = iX1; iX <= iX2; ++iX)
+                s_pBox[iY * iCols + iX].x1 = 1;
+        ++pBox;
+    }
+
+    /* Sum the damaged tiles and collect the unchanged ones in place */
+    for (iTile = 0; iTile < iCols * iRows; ++iTile) {
+        int iX = (iTile % iCols) * WIN_TILE_SIZE;
+        int iY = (iTile / iCols) * WIN_TILE_SIZE;
+        int iW = min(WIN_TILE_SIZE, pScreen->width - iX);
+        int iH = min(WIN_TILE_SIZE, pScreen->height - iY);
+        CARD64 ullSum;
+
+        if (!s_pBox[iTile].x1)
+            continue;
+
+        ullSum = winTileChecksum(pScreenInfo->pfb + iY * dwPitch
+                                 + iX * iBytesPP, dwPitch,
+                                 iW * iBytesPP, iH);
+        if (ullSum != pScreenPriv->pTileSums[iTile]) {
+            pScreenPriv->pTileSums[iTile] = ullSum;
+            continue;
+        }
+
+        s_pBox[nSame].x1 = iX;
+        s_pBox[nSame].y1 = iY;
+        s_pBox[nSame].x2 = iX + iW;
+        s_pBox[nSame].y2 = iY + iH;
+        ++nSame;
+    }
+
+    if (!nSame)
+        return;
+
+    if (RegionInitBoxes(&rgnSame, s_pBox, nSame))
+        RegionSubtract(pRegion, pRegion, &rgnSame);
+    RegionUninit(&rgnSame);
+}
@@ -222,6 +222,9 @@ winMouseButtonsSendEvent(int iEventType, int iButton)
     if (g_winMouseButtonMap)
         iButton = g_winMouseButtonMap[iButton];
 
+    if (iEventType == ButtonPress)
+        winLatencyInput();
+
     valuator_mask_zero(&mask);
     QueuePointerEvents(g_pwinPointer, iEventType, iButton,
                        POINTER_RELATIVE, &mask);
@@ -341,3 +344,191 @@ winEnqueueMotion(int x, int y)
                        POINTER_ABSOLUTE | POINTER_SCREEN, &mask);
 
 }
+
+/* How far back, in milliseconds, recovered mouse points may go */
+#define WIN_MOUSE_HISTORY_SPAN 100
+
+/**
+ * Enqueue the positions the pointer went through on its way to (x, y).
+ *
+ * Windows only keeps the latest WM_MOUSEMOVE while its queue is busy;
+ * GetMouseMovePointsEx() returns the points it dropped, newest first.
+ * Those newer than the last position we delivered are replayed oldest
+ * first, then (x, y).  dx and dy map X screen coordinates to Windows
+ * screen coordinates.  Bursts of them that the server has no time for are
+ * coalesced again by mieq.
+ */
+void
+winEnqueueMotionHistory(int x, int y, int dx, int dy)
+{
+    static DWORD dwLastTime;
+    static int iLastX, iLastY;
+    static Bool fLastValid = FALSE;
+    MOUSEMOVEPOINT mmpIn, mmpHistory[64];
+    DWORD dwTime = GetMessageTime();
+    int i, n = 0;
+
+    if (fLastValid) {
+        ZeroMemory(&mmpIn, sizeof(mmpIn));
+        mmpIn.x = (x + dx) & 0xFFFF;
+        mmpIn.y = (y + dy) & 0xFFFF;
+        mmpIn.time = dwTime;
+
+        n = GetMouseMovePointsEx(sizeof(mmpIn), &mmpIn, mmpHistory,
+                                 ARRAY_SIZE(mmpHistory),
+                                 GMMP_USE_DISPLAY_POINTS);
+    }
+
+    /* Entry 0 is (x, y) itself; find the oldest one not yet delivered */
+    for (i = 1; i < n; i++) {
+        int px = mmpHistory[i].x > 32767 ? mmpHistory[i].x - 65536
+            : mmpHistory[i].x;
+        int py = mmpHistory[i].y > 32767 ? mmpHistory[i].y - 65536
+            : mmpHistory[i].y;
+
+        if ((LONG) (mmpHistory[i].time - dwLastTime) < 0
+            || dwTime - mmpHistory[i].time > WIN_MOUSE_HISTORY_SPAN
+            || (px - dx == iLastX && py - dy == iLastY))
+            break;
+    }
+
+    while (--i > 0) {
+        int px = mmpHistory[i].x > 32767 ? mmpHistory[i].x - 65536
+            : mmpHistory[i].x;
+        int py = mmpHistory[i].y > 32767 ? mmpHistory[i].y - 65536
+            : mmpHistory[i].y;
+
+        winEnqueueMotion(px - dx, py - dy);
+    }
+
+    winEnqueueMotion(x, y);
+
+    dwLastTime = dwTime;
+    iLastX = x;
+    iLastY = y;
+    fLastValid = TRUE;
+}
+
+/*
+ * Relative pointer mode.
+ *
+ * Games and CAD programs grab the pointer and warp it back every frame to
+ * measure how far the mouse moved.  Each warp moves the Windows cursor,
+ * whose WM_MOUSEMOVE comes back as one more absolute motion, and the
+ * cursor stops at the edge of the desktop.  While a grabbing client warps,
+ * the mouse is read as deltas from raw input instead, the Windows cursor is
+ * confined to the window with ClipCursor(), and WM_MOUSEMOVE is ignored.
+ * The deltas still go through GetPointerEvents(), so pointer barriers and
+ * confine-to windows apply as before.
+ */
+
+static Bool s_fRelative = FALSE;
+static POINT s_ptRelativeOrigin;
+
+static Bool
+winMouseGrabbed(void)
+{
+    DeviceIntPtr pMaster;
+
+    if (g_pwinPointer == NULL)
+        return FALSE;
+    pMaster = GetMaster(g_pwinPointer, MASTER_POINTER);
+    return pMaster && pMaster->deviceGrab.grab;
+}
+
+/**
+ * Switch to relative mode for the grab a client is warping in.
+ * hwnd is the window with the pointer, (x, y) the Windows screen position
+ * of X screen coordinate (0, 0).
+ */
+void
+winMouseStartRelative(HWND hwnd, int x, int y)
+{
+    RAWINPUTDEVICE rid;
+    RECT rcClient;
+
+    if (s_fRelative || !winMouseGrabbed())
+        return;
+
+    rid.usUsagePage = 0x01;     /* generic desktop */
+    rid.usUsage = 0x02;         /* mouse */
+    rid.dwFlags = 0;
+    rid.hwndTarget = NULL;
+    if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
+        ErrorF("winMouseStartRelative - RegisterRawInputDevices failed\n");
+        return;
+    }
+
+    GetClientRect(hwnd, &rcClient);
+    MapWindowPoints(hwnd, HWND_DESKTOP, (LPPOINT) &rcClient, 2);
+    ClipCursor(&rcClient);
+
+    s_ptRelativeOrigin.x = x;
+    s_ptRelativeOrigin.y = y;
+    s_fRelative = TRUE;
+}
+
+/**
+ * Leave relative mode, putting the Windows cursor where the X pointer is.
+ */
+void
+winMouseStopRelative(void)
+{
+    RAWINPUTDEVICE rid;
+    int x, y;
+
+    if (!s_fRelative)
+        return;
+    s_fRelative = FALSE;
+
+    rid.usUsagePage = 0x01;
+    rid.usUsage = 0x02;
+    rid.dwFlags = RIDEV_REMOVE;
+    rid.hwndTarget = NULL;
+    RegisterRawInputDevices(&rid, 1, sizeof(rid));
+    ClipCursor(NULL);
+
+    miPointerGetPosition(g_pwinPointer, &x, &y);
+    SetCursorPos(s_ptRelativeOrigin.x + x, s_ptRelativeOrigin.y + y);
+}
+
+/**
+ * Whether absolute mouse positions are to be ignored.  Relative mode
+ * ends with the grab that started it.
+ */
+Bool
+winMouseRelative(void)
+{
+    if (s_fRelative && !winMouseGrabbed())
+        winMouseStopRelative();
+    return s_fRelative;
+}
+
+/**
+ * Deliver the motion in a WM_INPUT message.
+ */
+void
+winMouseRawInput(HRAWINPUT hRawInput)
+{
+    RAWINPUT ri;
+    UINT uiSize = sizeof(ri);
+    int valuators[2];
+    ValuatorMask mask;
+
+    if (!winMouseRelative())
+        return;
+
+    if (GetRawInputData(hRawInput, RID_INPUT, &ri, &uiSize,
+                        sizeof(RAWINPUTHEADER)) == (UINT) -1
+        || ri.header.dwType != RIM_TYPEMOUSE
+        || (ri.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+        || (!ri.data.mouse.lLastX && !ri.data.mouse.lLastY))
+        return;
+
+    valuators[0] = ri.data.mouse.lLastX;
+    valuators[1] = ri.data.mouse.lLastY;
+
+    valuator_mask_set_range(&mask, 0, 2, valuators);
+    QueuePointerEvents(g_pwinPointer, MotionNotify, 0, POINTER_RELATIVE,
+                       &mask);
+}
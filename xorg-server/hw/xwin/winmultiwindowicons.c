@@ -49,12 +49,34 @@
 #include "winmsg.h"
 #include "winmultiwindowicons.h"
 #include "winglobals.h"
+#include "winlock.h"
 
 /*
  * global variables
  */
 extern HINSTANCE g_hInstance;
 
+/*
+ * Icons converted from _NET_WM_ICON, shared by every window showing the
+ * same image: an application that keeps resetting its icon property, or
+ * opens many windows with the same icon, converts it only once.  Entries
+ * live while some window uses the icon; winDestroyIcon() drops them.
+ */
+
+#define WIN_ICON_CACHE_SIZE	128
+
+typedef struct {
+    uint64_t hash;
+    uint32_t width, height;
+    Bool fAlpha;
+    HICON hIcon;
+    int iRefs;
+} winIconCacheRec;
+
+static winIconCacheRec s_iconCache[WIN_ICON_CACHE_SIZE];
+static int s_iIconCacheUsed;
+static winMtx s_pmIconCache = WIN_MTX_INITIALIZER("icon cache");
+
 /*
  * Scale an X icon ZPixmap into a Windoze icon bitmap
  */
@@ -334,13 +356,104 @@ NetWMToWinIconThreshold(uint32_t * icon)
     return result;
 }
 
+static uint64_t
+NetWMIconHash(uint32_t * icon)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i, n = (size_t) icon[0] * icon[1] + 2;
+
+    for (i = 0; i < n; i++)
+        hash = (hash ^ icon[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+/*
+ * Convert a _NET_WM_ICON image, reusing the icon already made from the
+ * same pixels if there is one
+ */
+
+static HICON
+NetWMToWinIcon(uint32_t * icon, Bool fAlpha)
+{
+    uint64_t hash = NetWMIconHash(icon);
+    HICON hIcon;
+    int i;
+
+    winMtxLock(&s_pmIconCache);
+    for (i = 0; i < s_iIconCacheUsed; i++) {
+        winIconCacheRec *pEntry = &s_iconCache[i];
+
+        if (pEntry->hash == hash && pEntry->width == icon[0]
+            && pEntry->height == icon[1] && pEntry->fAlpha == fAlpha) {
+            pEntry->iRefs++;
+            winMtxUnlock(&s_pmIconCache);
+            winDebug("NetWMToWinIcon - %u x %u reused %p\n", icon[0], icon[1],
+                     pEntry->hIcon);
+            return pEntry->hIcon;
+        }
+    }
+    winMtxUnlock(&s_pmIconCache);
+
+    hIcon = fAlpha ? NetWMToWinIconAlpha(icon) : NetWMToWinIconThreshold(icon);
+    if (!hIcon)
+        return NULL;
+
+    /* A full cache just means this icon is not shared */
+    winMtxLock(&s_pmIconCache);
+    if (s_iIconCacheUsed < WIN_ICON_CACHE_SIZE) {
+        winIconCacheRec *pEntry = &s_iconCache[s_iIconCacheUsed++];
+
+        pEntry->hash = hash;
+        pEntry->width = icon[0];
+        pEntry->height = icon[1];
+        pEntry->fAlpha = fAlpha;
+        pEntry->hIcon = hIcon;
+        pEntry->iRefs = 1;
+    }
+    winMtxUnlock(&s_pmIconCache);
+
+    return hIcon;
+}
+
+/*
+ * _NET_WM_ICON atom, interned once per server generation
+ */
+
+static xcb_atom_t
+NetWMIconAtom(xcb_connection_t *conn)
+{
+    static xcb_atom_t _XA_NET_WM_ICON;
+    static int generation;
+
+    if (generation != serverGeneration) {
+        xcb_intern_atom_reply_t *atom_reply;
+        xcb_intern_atom_cookie_t atom_cookie;
+        const char *atomName = "_NET_WM_ICON";
+
+        generation = serverGeneration;
+
+        _XA_NET_WM_ICON = XCB_NONE;
+
+        atom_cookie = xcb_intern_atom(conn, 0, strlen(atomName), atomName);
+        atom_reply = xcb_intern_atom_reply(conn, atom_cookie, NULL);
+        if (atom_reply) {
+          _XA_NET_WM_ICON = atom_reply->atom;
+          free(atom_reply);
+        }
+    }
+
+    return _XA_NET_WM_ICON;
+}
+
 /*
  * Attempt to create a custom icon from the WM_HINTS bitmaps
  */
 
 static
 HICON
-winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
+winXIconToHICON(xcb_connection_t *conn, xcb_window_t id,
+                xcb_get_property_reply_t *reply, int iconSize)
 {
     unsigned char *mask, *image = NULL, *imageMask;
     unsigned char *dst, *src;
@@ -351,8 +464,6 @@ winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
     xcb_icccm_wm_hints_t hints;
     HICON hIcon = NULL;
     uint32_t *biggest_icon = NULL;
-    static xcb_atom_t _XA_NET_WM_ICON;
-    static int generation;
     uint32_t *icon, *icon_data = NULL;
     unsigned long int size;
 
@@ -362,27 +473,7 @@ winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
     ReleaseDC(GetDesktopWindow(), hDC);
 
     /* Always prefer _NET_WM_ICON icons */
-    if (generation != serverGeneration) {
-        xcb_intern_atom_reply_t *atom_reply;
-        xcb_intern_atom_cookie_t atom_cookie;
-        const char *atomName = "_NET_WM_ICON";
-
-        generation = serverGeneration;
-
-        _XA_NET_WM_ICON = XCB_NONE;
-
-        atom_cookie = xcb_intern_atom(conn, 0, strlen(atomName), atomName);
-        atom_reply = xcb_intern_atom_reply(conn, atom_cookie, NULL);
-        if (atom_reply) {
-          _XA_NET_WM_ICON = atom_reply->atom;
-          free(atom_reply);
-        }
-    }
-
     {
-        xcb_get_property_cookie_t cookie = xcb_get_property(conn, FALSE, id, _XA_NET_WM_ICON, XCB_ATOM_CARDINAL, 0L, INT_MAX);
-        xcb_get_property_reply_t *reply =  xcb_get_property_reply(conn, cookie, NULL);
-
         if (reply &&
             ((icon_data = xcb_get_property_value(reply)) != NULL)) {
           size = xcb_get_property_value_length(reply)/sizeof(uint32_t);
@@ -407,7 +498,7 @@ winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
             if (icon[0] == iconSize && icon[1] == iconSize) {
                 winDebug("winXIconToHICON: selected %d x %d NetIcon\n",
                          iconSize, iconSize);
-                hIcon = (bpp == 32) ? NetWMToWinIconAlpha(icon) : NetWMToWinIconThreshold(icon);
+                hIcon = NetWMToWinIcon(icon, bpp == 32);
                 break;
             }
             /* Otherwise, find the biggest icon and let Windows scale the size */
@@ -422,10 +513,8 @@ winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
                 ("winXIconToHICON: selected %u x %u NetIcon for scaling to %d x %d\n",
                  biggest_icon[0], biggest_icon[1], iconSize, iconSize);
 
-            hIcon = (bpp == 32) ? NetWMToWinIconAlpha(biggest_icon) : NetWMToWinIconThreshold(biggest_icon);
+            hIcon = NetWMToWinIcon(biggest_icon, bpp == 32);
         }
-
-        free(reply);
       }
     }
 
@@ -558,9 +647,17 @@ winUpdateIcon(HWND hWnd, xcb_connection_t *conn, xcb_window_t id, HICON hIconNew
         hIcon = hIconNew;
         hIconSmall = hIconNew;
     } else {
+        /* Fetch _NET_WM_ICON once for both sizes, it can be large */
+        xcb_get_property_cookie_t cookie =
+            xcb_get_property(conn, FALSE, id, NetWMIconAtom(conn),
+                             XCB_ATOM_CARDINAL, 0L, INT_MAX);
+        xcb_get_property_reply_t *reply =
+            xcb_get_property_reply(conn, cookie, NULL);
+
         /* If we still need an icon, try and get the icon from WM_HINTS */
-        hIcon = winXIconToHICON(conn, id, GetSystemMetrics(SM_CXICON));
-        hIconSmall = winXIconToHICON(conn, id, GetSystemMetrics(SM_CXSMICON));
+        hIcon = winXIconToHICON(conn, id, reply, GetSystemMetrics(SM_CXICON));
+        hIconSmall = winXIconToHICON(conn, id, reply, GetSystemMetrics(SM_CXSMICON));
+        free(reply);
         /* If we got the small, but not the large one swap them */
         if (!hIcon && hIconSmall) {
             hIcon = hIconSmall;
@@ -637,9 +734,27 @@ winSelectIcons(HICON * pIcon, HICON * pSmallIcon)
 void
 winDestroyIcon(HICON hIcon)
 {
+    int i;
+
     /* Delete the icon if its not one of the application defaults or an override */
-    if (hIcon &&
-        hIcon != g_hIconX &&
-        hIcon != g_hSmallIconX && !winIconIsOverride(hIcon))
-        DestroyIcon(hIcon);
+    if (!hIcon ||
+        hIcon == g_hIconX ||
+        hIcon == g_hSmallIconX || winIconIsOverride(hIcon))
+        return;
+
+    /* ... or still used by another window */
+    winMtxLock(&s_pmIconCache);
+    for (i = 0; i < s_iIconCacheUsed; i++) {
+        if (s_iconCache[i].hIcon == hIcon) {
+            if (--s_iconCache[i].iRefs > 0) {
+                winMtxUnlock(&s_pmIconCache);
+                return;
+            }
+            s_iconCache[i] = s_iconCache[--s_iIconCacheUsed];
+            break;
+        }
+    }
+    winMtxUnlock(&s_pmIconCache);
+
+    DestroyIcon(hIcon);
 }
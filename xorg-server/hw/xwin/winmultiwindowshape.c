@@ -66,11 +66,41 @@ winSetShapeMultiWindow(WindowPtr pWin, int kind)
 void
 winUpdateRgnMultiWindow(WindowPtr pWin)
 {
-    SetWindowRgn(winGetWindowPriv(pWin)->hWnd,
-                 winGetWindowPriv(pWin)->hRgn, TRUE);
+    winWindowPriv(pWin);
+
+    if (pWinPriv->hWnd == NULL)
+        return;
+
+    /* Leave the window alone if its shape did not change */
+    if (pWinPriv->hRgn == NULL ? pWinPriv->hRgnShown == NULL
+        : pWinPriv->hRgnShown && EqualRgn(pWinPriv->hRgn,
+                                          pWinPriv->hRgnShown)) {
+        if (pWinPriv->hRgn) {
+            DeleteObject(pWinPriv->hRgn);
+            pWinPriv->hRgn = NULL;
+        }
+        return;
+    }
+
+    /* Keep a copy to compare the next shape against */
+    if (pWinPriv->hRgnShown) {
+        DeleteObject(pWinPriv->hRgnShown);
+        pWinPriv->hRgnShown = NULL;
+    }
+    if (pWinPriv->hRgn) {
+        pWinPriv->hRgnShown = CreateRectRgn(0, 0, 0, 0);
+        if (pWinPriv->hRgnShown
+            && CombineRgn(pWinPriv->hRgnShown, pWinPriv->hRgn, NULL,
+                          RGN_COPY) == ERROR) {
+            DeleteObject(pWinPriv->hRgnShown);
+            pWinPriv->hRgnShown = NULL;
+        }
+    }
+
+    SetWindowRgn(pWinPriv->hWnd, pWinPriv->hRgn, TRUE);
 
     /* The system now owns the region specified by the region handle and will delete it when it is no longer needed. */
-    winGetWindowPriv(pWin)->hRgn = NULL;
+    pWinPriv->hRgn = NULL;
 }
 
 /*
@@ -83,7 +113,9 @@ winReshapeMultiWindow(WindowPtr pWin)
     int nRects;
     RegionRec rrNewShape;
     BoxPtr pShape, pRects, pEnd;
-    HRGN hRgn, hRgnRect;
+    HRGN hRgn;
+    RGNDATA *pData;
+    RECT *prc;
 
     winWindowPriv(pWin);
 
@@ -146,44 +178,38 @@ winReshapeMultiWindow(WindowPtr pWin)
         iOffsetX = rcClient.left - rcWindow.left;
         iOffsetY = rcClient.top - rcWindow.top;
 
-        /* Create initial Windows region for title bar */
-        /* FIXME: Mean, nasty, ugly hack!!! */
-        hRgn = CreateRectRgn(0, 0, rcWindow.right, iOffsetY);
-        if (hRgn == NULL) {
-            ErrorF("winReshape - Initial CreateRectRgn (%d, %d, %d, %d) "
-                   "failed: %d\n",
-                   0, 0, (int) rcWindow.right, iOffsetY, (int) GetLastError());
+        /* Build the region in one go: the title bar plus the X rectangles */
+        pData = malloc(sizeof(RGNDATAHEADER) + (nRects + 1) * sizeof(RECT));
+        if (pData == NULL) {
+            ErrorF("winReshape - malloc of %d rectangles failed\n", nRects + 1);
+            RegionUninit(&rrNewShape);
+            return;
         }
+        prc = (RECT *) pData->Buffer;
+
+        /* FIXME: Mean, nasty, ugly hack!!! */
+        SetRect(&pData->rdh.rcBound, 0, 0, rcWindow.right, iOffsetY);
+        SetRect(prc++, 0, 0, rcWindow.right, iOffsetY);
 
-        /* Loop through all rectangles in the X region */
         for (pRects = pShape, pEnd = pShape + nRects; pRects < pEnd; pRects++) {
-            /* Create a Windows region for the X rectangle */
-            hRgnRect = CreateRectRgn(pRects->x1 + iOffsetX,
-                                     pRects->y1 + iOffsetY,
-                                     pRects->x2 + iOffsetX,
-                                     pRects->y2 + iOffsetY);
-            if (hRgnRect == NULL) {
-                ErrorF("winReshape - Loop CreateRectRgn (%d, %d, %d, %d) "
-                       "failed: %d\n"
-                       "\tx1: %d x2: %d xOff: %d y1: %d y2: %d yOff: %d\n",
-                       pRects->x1 + iOffsetX,
-                       pRects->y1 + iOffsetY,
-                       pRects->x2 + iOffsetX,
-                       pRects->y2 + iOffsetY,
-                       (int) GetLastError(),
-                       pRects->x1, pRects->x2, iOffsetX,
-                       pRects->y1, pRects->y2, iOffsetY);
-            }
-
-            /* Merge the Windows region with the accumulated region */
-            if (CombineRgn(hRgn, hRgn, hRgnRect, RGN_OR) == ERROR) {
-                ErrorF("winReshape - CombineRgn () failed: %d\n",
-                       (int) GetLastError());
-            }
-
-            /* Delete the temporary Windows region */
-            DeleteObject(hRgnRect);
+            SetRect(prc, pRects->x1 + iOffsetX, pRects->y1 + iOffsetY,
+                    pRects->x2 + iOffsetX, pRects->y2 + iOffsetY);
+            UnionRect(&pData->rdh.rcBound, &pData->rdh.rcBound, prc++);
+        }
+
+        pData->rdh.dwSize = sizeof(RGNDATAHEADER);
+        pData->rdh.iType = RDH_RECTANGLES;
+        pData->rdh.nCount = nRects + 1;
+        pData->rdh.nRgnSize = (nRects + 1) * sizeof(RECT);
+
+        hRgn = ExtCreateRegion(NULL,
+                               sizeof(RGNDATAHEADER) + pData->rdh.nRgnSize,
+                               pData);
+        if (hRgn == NULL) {
+            ErrorF("winReshape - ExtCreateRegion of %d rectangles failed: "
+                   "%d\n", nRects + 1, (int) GetLastError());
         }
+        free(pData);
 
         /* Save a handle to the composite region in the window privates */
         pWinPriv->hRgn = hRgn;
@@ -54,9 +54,6 @@ static void
 static void
  winUpdateWindowsWindow(WindowPtr pWin);
 
-static void
- winFindWindow(void *value, XID id, void *cdata);
-
 static
     void
 winInitMultiWindowClass(void)
@@ -115,9 +112,12 @@ winCreateWindowMultiWindow(WindowPtr pWin)
 
     /* Initialize some privates values */
     pWinPriv->hRgn = NULL;
+    pWinPriv->hRgnShown = NULL;
     pWinPriv->hWnd = NULL;
     pWinPriv->pScreenPriv = winGetScreenPriv(pWin->drawable.pScreen);
     pWinPriv->fXKilled = FALSE;
+    pWinPriv->fPaintPending = FALSE;
+    pWinPriv->pDamage = NULL;
 #ifdef XWIN_GLX_WINDOWS
     pWinPriv->fWglUsed = FALSE;
 #endif
@@ -439,6 +439,57 @@ winRestackWindowMultiWindow(WindowPtr pWin, WindowPtr pOldNextSib)
         winReorderWindowsMultiWindow();
 }
 
+/*
+ * With -compositewm a top-level window draws into its own pixmap, and its
+ * HWND paints from that pixmap's DIB.  Drawing on the window is tracked
+ * here rather than through the screen pixmap, so the window manager can
+ * redirect manually and nothing is copied to the root window.  The damage
+ * is turned into invalidated areas of the HWND by
+ * winFlushPendingPaintsShadowGDI, once per frame.
+ */
+
+static void
+winWindowDamageReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
+{
+    WindowPtr pWin = closure;
+
+    winWindowPriv(pWin);
+    winScreenPriv(pWin->drawable.pScreen);
+
+    pWinPriv->fPaintPending = TRUE;
+    pScreenPriv->fPaintPending = TRUE;
+}
+
+static void
+winWindowDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    WindowPtr pWin = closure;
+
+    winWindowPriv(pWin);
+
+    pWinPriv->pDamage = NULL;
+}
+
+static void
+winWatchWindowDamage(WindowPtr pWin)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+
+    winWindowPriv(pWin);
+    winScreenPriv(pScreen);
+
+    if (!pScreenPriv->pScreenInfo->fCompositeWM || pWinPriv->pDamage
+        || pWin->drawable.class == InputOnly)
+        return;
+
+    pWinPriv->pDamage = DamageCreate(winWindowDamageReport,
+                                     winWindowDamageDestroy,
+                                     DamageReportNonEmpty, TRUE, pScreen,
+                                     pWin);
+    if (pWinPriv->pDamage)
+        DamageRegister(&pWin->drawable, pWinPriv->pDamage);
+}
+
 /*
  * winCreateWindowsWindow - Create a Windows window associated with an X window
  */
@@ -607,6 +658,8 @@ winCreateWindowsWindow(WindowPtr pWin)
 
     /* Flag that this Windows window handles its own activation */
     SetProp(hWnd, WIN_NEEDMANAGE_PROP, (HANDLE) 0);
+
+    winWatchWindowDamage(pWin);
 }
 
 Bool winInDestroyWindowsWindow = FALSE;
@@ -632,18 +685,38 @@ winDestroyWindowsWindow(WindowPtr pWin)
     if (pWinPriv->hWnd == NULL)
         return;
 
+    /* Nothing to paint any more */
+    if (pWinPriv->pDamage)
+        DamageDestroy(pWinPriv->pDamage);
+
     winInDestroyWindowsWindow = TRUE;
 
     /* Store the info we need to destroy after this window is gone */
     hIcon = (HICON) SendMessage(pWinPriv->hWnd, WM_GETICON, ICON_BIG, 0);
     hIconSm = (HICON) SendMessage(pWinPriv->hWnd, WM_GETICON, ICON_SMALL, 0);
 
+#ifdef XWIN_GLX_WINDOWS
+    /* Unbind a GL context left bound to this window or one of its children */
+    {
+        HWND hwndGL = WindowFromDC(wglGetCurrentDC());
+
+        if (hwndGL && (hwndGL == pWinPriv->hWnd || IsChild(pWinPriv->hWnd, hwndGL)))
+            wglMakeCurrent(NULL, NULL);
+    }
+#endif
+
     /* Destroy the Windows window */
     DestroyWindow(pWinPriv->hWnd);
 
     /* Null our handle to the Window so referencing it will cause an error */
     pWinPriv->hWnd = NULL;
 
+    /* A new Windows window starts out unshaped */
+    if (pWinPriv->hRgnShown) {
+        DeleteObject(pWinPriv->hRgnShown);
+        pWinPriv->hRgnShown = NULL;
+    }
+
     /* Destroy any icons we created for this window */
     winDestroyIcon(hIcon);
     winDestroyIcon(hIconSm);
@@ -651,6 +724,8 @@ winDestroyWindowsWindow(WindowPtr pWin)
 #ifdef XWIN_GLX_WINDOWS
     /* No longer note WGL used on this window */
     pWinPriv->fWglUsed = FALSE;
+    /* A recreated HWND needs its pixel format set again */
+    pWinPriv->OpenGlWindow = FALSE;
 #endif
 
     /* Process all messages on our queue 
@@ -748,35 +823,19 @@ winUpdateWindowsWindow(WindowPtr pWin)
 XID
 winGetWindowID(WindowPtr pWin)
 {
-    WindowIDPairRec wi = { pWin, 0 };
-    ClientPtr c = wClient(pWin);
-
-    /* */
-    FindClientResourcesByType(c, RT_WINDOW, winFindWindow, &wi);
-
+    /* A window's drawable id is its resource id */
 #if CYGMULTIWINDOW_DEBUG
-    winDebug("winGetWindowID - Window ID: %u\n", (unsigned int)wi.id);
+    winDebug("winGetWindowID - Window ID: %u\n",
+             (unsigned int) pWin->drawable.id);
 #endif
 
-    return wi.id;
-}
-
-/*
- * winFindWindow -
- */
-
-static void
-winFindWindow(void *value, XID id, void *cdata)
-{
-    WindowIDPairPtr wi = (WindowIDPairPtr) cdata;
-
-    if (value == wi->value) {
-        wi->id = id;
-    }
+    return pWin->drawable.id;
 }
 
 /*
- * winReorderWindowsMultiWindow -
+ * winReorderWindowsMultiWindow - Restack the X windows to match the Windows
+ * z-order.  Windows already just below their predecessor are left alone, so
+ * an activation only touches the windows that actually moved.
  */
 
 void
@@ -816,13 +875,17 @@ winReorderWindowsMultiWindow(void)
             pWinSib = pWin;
             pWin = GetProp(hwnd, WIN_WINDOW_PROP);
 
+            /* Already in place? */
+            if (pWin->prevSib == pWinSib)
+                continue;
+
             if (!pWinSib) {     /* 1st window - raise to the top */
                 vlist[0] = Above;
 
                 winConfigureWindow(pWin, CWStackMode, vlist, wClient(pWin));
             }
             else {              /* 2nd or deeper windows - just below the previous one */
-                vlist[0] = winGetWindowID(pWinSib);
+                vlist[0] = pWinSib->drawable.id;
                 vlist[1] = Below;
 
                 winConfigureWindow(pWin, CWSibling | CWStackMode,
@@ -1037,6 +1100,7 @@ static HBITMAP winCreateDIB(ScreenPtr pScreen, int width, int height, int bpp, v
                                DIB_RGB_COLORS, ppvBits, NULL, 0);
     if (hBitmap == NULL) {
         ErrorF("winCreateDIB: CreateDIBSection() failed\n");
+        free(pbmih);
         return NULL;
     }
 
@@ -1049,8 +1113,213 @@ static HBITMAP winCreateDIB(ScreenPtr pScreen, int width, int height, int bpp, v
 }
 
 
+/*
+  DIBs are cached and reused in size classes, rounded up to this many pixels
+ */
+#define WIN_DIB_SIZE_CLASS(x) (((x) + 31) & ~31)
+
+/* Row stride of a DIB, which has 4-byte aligned rows */
+#define WIN_DIB_STRIDE(width, bpp) (((((bpp) * (width)) + 31) & ~31) / 8)
+
+static void
+winEvictCachedDIB(winPrivScreenPtr pScreenPriv)
+{
+    winCachedDIBRec *pDIB = &pScreenPriv->aDIBCache[0];
+
+    DeleteObject(pDIB->hBitmap);
+    free(pDIB->pbmih);
+    pScreenPriv->dwDIBCacheBytes -= pDIB->dwSize;
+    pScreenPriv->iDIBCacheCount--;
+    memmove(pDIB, pDIB + 1, pScreenPriv->iDIBCacheCount * sizeof(*pDIB));
+}
+
+/*
+  Get a DIB of the size class of width x height, from the cache if possible
+ */
+static HBITMAP
+winAcquireDIB(ScreenPtr pScreen, int width, int height, int bpp,
+              void **ppvBits, BITMAPINFOHEADER **ppbmih, int *piStride)
+{
+    winScreenPriv(pScreen);
+    int iWidth = WIN_DIB_SIZE_CLASS(width);
+    int iHeight = WIN_DIB_SIZE_CLASS(height);
+    int i;
+
+    *piStride = WIN_DIB_STRIDE(iWidth, bpp);
+
+    /* Most recently released entries are at the end */
+    for (i = pScreenPriv->iDIBCacheCount - 1; i >= 0; --i) {
+        winCachedDIBRec *pDIB = &pScreenPriv->aDIBCache[i];
+        HBITMAP hBitmap = pDIB->hBitmap;
+
+        if (pDIB->iWidth != iWidth || pDIB->iHeight != iHeight
+            || pDIB->iBpp != bpp)
+            continue;
+
+        *ppvBits = pDIB->pbBits;
+        *ppbmih = pDIB->pbmih;
+        pScreenPriv->dwDIBCacheBytes -= pDIB->dwSize;
+        pScreenPriv->iDIBCacheCount--;
+        memmove(pDIB, pDIB + 1,
+                (pScreenPriv->iDIBCacheCount - i) * sizeof(*pDIB));
+        return hBitmap;
+    }
+
+    return winCreateDIB(pScreen, iWidth, iHeight, bpp, ppvBits, ppbmih);
+}
+
+/*
+  Return a pixmap's DIB to the cache, or free it if it is too large
+ */
+static void
+winReleaseDIB(ScreenPtr pScreen, HBITMAP hBitmap, void *pvBits,
+              BITMAPINFOHEADER *pbmih)
+{
+    winScreenPriv(pScreen);
+    winCachedDIBRec *pDIB;
+    int iWidth = pbmih->biWidth;
+    int iHeight = -pbmih->biHeight;
+    int iBpp = pbmih->biBitCount;
+    DWORD dwSize = WIN_DIB_STRIDE(iWidth, iBpp) * iHeight;
+
+    if (pScreenPriv->fClosed || dwSize > WIN_DIB_CACHE_MAX_BYTES) {
+        DeleteObject(hBitmap);
+        free(pbmih);
+        return;
+    }
+
+    /* Make room by dropping the least recently released entries */
+    while (pScreenPriv->iDIBCacheCount == WIN_DIB_CACHE_SIZE
+           || pScreenPriv->dwDIBCacheBytes + dwSize > WIN_DIB_CACHE_MAX_BYTES)
+        winEvictCachedDIB(pScreenPriv);
+
+    pDIB = &pScreenPriv->aDIBCache[pScreenPriv->iDIBCacheCount++];
+    pDIB->hBitmap = hBitmap;
+    pDIB->pbBits = pvBits;
+    pDIB->pbmih = pbmih;
+    pDIB->iWidth = iWidth;
+    pDIB->iHeight = iHeight;
+    pDIB->iBpp = iBpp;
+    pDIB->dwSize = dwSize;
+    pScreenPriv->dwDIBCacheBytes += dwSize;
+}
+
+/*
+ * Free all cached DIBs, called when the screen is closed
+ */
+void
+winFlushDIBCacheMultiwindow(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    while (pScreenPriv->iDIBCacheCount > 0)
+        winEvictCachedDIB(pScreenPriv);
+}
+
+/*
+ * Free the cached DIBs of the screen in closure when memory is low
+ */
+unsigned long
+winTrimDIBCacheMultiwindow(void *closure)
+{
+    ScreenPtr pScreen = closure;
+    winScreenPriv(pScreen);
+    unsigned long ulBytes = pScreenPriv->dwDIBCacheBytes;
+
+    winFlushDIBCacheMultiwindow(pScreen);
+    return ulBytes;
+}
+
+/*
+ * Make sure a pixmap is backed by a DIB, so it can be selected into a DC.
+ * Pixmaps start out in plain memory unless they back a window; move the
+ * bits into a DIB the first time GDI needs them.
+ */
+Bool
+winPixmapEnsureDIBMultiwindow(PixmapPtr pPixmap)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+    winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+    int bpp = pPixmap->drawable.bitsPerPixel;
+    CARD8 *pbSrc = pPixmap->devPrivate.ptr;
+    CARD8 *pbDst;
+    int iStride, i;
+
+    if (pPixmapPriv->hBitmap)
+        return TRUE;
+
+    if (!pPixmapPriv->owned || pbSrc == NULL)
+        return FALSE;
+
+    pPixmapPriv->hBitmap = winAcquireDIB(pScreen,
+                                         pPixmap->drawable.width,
+                                         pPixmap->drawable.height, bpp,
+                                         &pPixmapPriv->pbBits,
+                                         &pPixmapPriv->pbmih, &iStride);
+    if (!pPixmapPriv->hBitmap)
+        return FALSE;
+
+    /* Copy the bits over, the old storage goes away with the pixmap */
+    pbDst = pPixmapPriv->pbBits;
+    for (i = 0; i < pPixmap->drawable.height; ++i)
+        memcpy(pbDst + i * iStride, pbSrc + i * pPixmap->devKind,
+               pPixmap->devKind);
+
+    pPixmap->devKind = iStride;
+    pPixmap->devPrivate.ptr = pPixmapPriv->pbBits;
+
+    winDebug("winPixmapEnsureDIBMultiwindow: pPixmap %p HBITMAP %p\n",
+             pPixmap, pPixmapPriv->hBitmap);
+
+    return TRUE;
+}
+
+static SizeType winGetPixmapBytesWrapped;
+
+/*
+ * X-Resource's estimate of a pixmap's memory.  DIB rows are padded, and a
+ * pixmap that winPixmapEnsureDIBMultiwindow moved into a DIB still holds
+ * the storage it was created with, so both are counted.
+ */
+static void
+winGetPixmapBytesMultiwindow(void *value, XID id, ResourceSizePtr size)
+{
+    PixmapPtr pPixmap = value;
+    winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+
+    winGetPixmapBytesWrapped(value, id, size);
+    if (!pPixmap->refcnt || !pPixmapPriv->hBitmap || !pPixmapPriv->owned)
+        return;
+
+    size->resourceSize = (unsigned long) pPixmap->devKind *
+        pPixmap->drawable.height;
+    if (pPixmap->usage_hint != CREATE_PIXMAP_USAGE_BACKING_PIXMAP)
+        size->resourceSize *= 2;
+    size->pixmapRefSize = size->resourceSize / pPixmap->refcnt;
+}
+
+/*
+ * Resource types are reset every server generation, so this is called
+ * from each screen's initialisation and wraps only once.
+ */
+void
+winInitPixmapBytesMultiwindow(void)
+{
+    SizeType sizeFunc = GetResourceTypeSizeFunc(RT_PIXMAP);
+
+    if (sizeFunc == winGetPixmapBytesMultiwindow)
+        return;
+    winGetPixmapBytesWrapped = sizeFunc;
+    SetResourceTypeSizeFunc(RT_PIXMAP, winGetPixmapBytesMultiwindow);
+}
+
 /*
  * CreatePixmap - See Porting Layer Definition
+ *
+ * Drawing into these pixmaps is left to fb even when they are DIBs: a DIB
+ * section is system memory, so GDI would rasterize into it in software as
+ * well, and pixman's SIMD fill and blit routines beat GDI's and don't
+ * need a GdiFlush before fb may touch the bits again.
  */
 PixmapPtr
 winCreatePixmapMultiwindow(ScreenPtr pScreen, int width, int height, int depth,
@@ -1059,11 +1328,8 @@ winCreatePixmapMultiwindow(ScreenPtr pScreen, int width, int height, int depth,
     winPrivPixmapPtr pPixmapPriv = NULL;
     PixmapPtr pPixmap = NULL;
     int bpp, paddedwidth;
-
-    /* allocate Pixmap header and privates */
-    pPixmap = AllocatePixmap(pScreen, 0);
-    if (!pPixmap)
-        return NullPixmap;
+    size_t datasize = 0;
+    Bool fDIB;
 
     bpp = BitsPerPixel(depth);
     /*
@@ -1074,7 +1340,23 @@ winCreatePixmapMultiwindow(ScreenPtr pScreen, int width, int height, int depth,
       i.e. round up the number of bits used by a row so it is a multiple of 32,
       then convert to bytes
     */
-    paddedwidth = (((bpp * width) + 31) & ~31)/8;
+    paddedwidth = WIN_DIB_STRIDE(width, bpp);
+    if (paddedwidth / 4 > 32767 || height > 32767)
+        return NullPixmap;
+
+    /*
+      Only window pixmaps are ever selected into a DC, so only those get a
+      DIB up front.  Everything else lives in memory allocated with the
+      pixmap header, and is moved to a DIB should GDI ever need it.
+    */
+    fDIB = (usage_hint == CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    if (!fDIB)
+        datasize = (size_t) height * paddedwidth;
+
+    /* allocate Pixmap header and privates */
+    pPixmap = AllocatePixmap(pScreen, datasize);
+    if (!pPixmap)
+        return NullPixmap;
 
     /* setup Pixmap header */
     pPixmap->drawable.type = DRAWABLE_PIXMAP;
@@ -1110,11 +1392,23 @@ winCreatePixmapMultiwindow(ScreenPtr pScreen, int width, int height, int depth,
     pPixmapPriv->hBitmap = NULL;
     pPixmapPriv->pbBits = NULL;
     pPixmapPriv->pbmih = NULL;
-
-    /* Create a DIB for the pixmap */
-    pPixmapPriv->hBitmap = winCreateDIB(pScreen, width, height, bpp, &pPixmapPriv->pbBits, &pPixmapPriv->pbmih);
     pPixmapPriv->owned = TRUE;
 
+    if (!fDIB) {
+        pPixmap->devPrivate.ptr = (char *) pPixmap + pScreen->totalPixmapSize;
+        return pPixmap;
+    }
+
+    /* Get a DIB for the pixmap */
+    pPixmapPriv->hBitmap = winAcquireDIB(pScreen, width, height, bpp,
+                                         &pPixmapPriv->pbBits,
+                                         &pPixmapPriv->pbmih,
+                                         &pPixmap->devKind);
+    if (!pPixmapPriv->hBitmap) {
+        free(pPixmap);
+        return NullPixmap;
+    }
+
     winDebug("winCreatePixmap: pPixmap %p HBITMAP %p pBMIH %p pBits %p\n", pPixmap, pPixmapPriv->hBitmap, pPixmapPriv->pbmih, pPixmapPriv->pbBits);
     /* XXX: so why do we need this in privates ??? */
     pPixmap->devPrivate.ptr = pPixmapPriv->pbBits;
@@ -1149,12 +1443,11 @@ winDestroyPixmapMultiwindow(PixmapPtr pPixmap)
     if (!pPixmapPriv->owned)
         return TRUE;
 
-    /* Free GDI bitmap */
+    /* Hand the GDI bitmap and its info header back for reuse */
     if (pPixmapPriv->hBitmap)
-        DeleteObject(pPixmapPriv->hBitmap);
-
-    /* Free the bitmap info header memory */
-    free(pPixmapPriv->pbmih);
+        winReleaseDIB(pPixmap->drawable.pScreen, pPixmapPriv->hBitmap,
+                      pPixmapPriv->pbBits, pPixmapPriv->pbmih);
+    pPixmapPriv->hBitmap = NULL;
     pPixmapPriv->pbmih = NULL;
 
     /* Free the pixmap memory */
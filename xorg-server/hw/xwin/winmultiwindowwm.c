@@ -69,6 +69,8 @@ typedef int pid_t;
 #include "windisplay.h"
 #include "winmultiwindowicons.h"
 #include "winauth.h"
+#include "wintrace.h"
+#include "winlock.h"
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_icccm.h>
@@ -104,20 +106,20 @@ extern void winSetAuthorization(void);
 #define HINT_MAX	(1L<<0)
 #define HINT_MIN	(1L<<1)
 
+#define WM_MSG_QUEUE_SIZE	256     /* initial ring size, a power of two */
+#define WM_MSG_COALESCE_DEPTH	32      /* queued messages searched for a duplicate */
+
 /*
  * Local structures
  */
 
-typedef struct _WMMsgNodeRec {
-    winWMMessageRec msg;
-    struct _WMMsgNodeRec *pNext;
-} WMMsgNodeRec, *WMMsgNodePtr;
-
 typedef struct _WMMsgQueueRec {
-    struct _WMMsgNodeRec *pHead;
-    struct _WMMsgNodeRec *pTail;
-    pthread_mutex_t pmMutex;
-    pthread_cond_t pcNotEmpty;
+    winWMMessagePtr pRing;      /* iSize entries, iCount queued from iHead */
+    int iSize;
+    int iHead;
+    int iCount;
+    winMtx pmMutex;
+    winCnd pcNotEmpty;
 } WMMsgQueueRec, *WMMsgQueuePtr;
 
 typedef struct _WMInfo {
@@ -158,9 +160,10 @@ typedef struct _XMsgProcArgRec {
  */
 
 static void
- PushMessage(WMMsgQueuePtr pQueue, WMMsgNodePtr pNode);
+ PushMessage(WMMsgQueuePtr pQueue, winWMMessagePtr pMsg);
 
-static WMMsgNodePtr PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo);
+static Bool
+ PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo, winWMMessagePtr pMsg);
 
 static Bool
  InitQueue(WMMsgQueuePtr pQueue);
@@ -255,84 +258,125 @@ MessageName(winWMMessagePtr msg)
 }
 
 /*
- * PushMessage - Push a message onto the queue
+ * IsDuplicateMessage - Is an identical update for the window already queued?
+ *
+ * Name, icon and hints messages just make the WM re-read the window's
+ * properties, so a second one queued behind the first adds nothing.  The
+ * search stops at any other message for the same window, so coalescing
+ * never reorders a window's messages.
  */
 
-static void
-PushMessage(WMMsgQueuePtr pQueue, WMMsgNodePtr pNode)
+static Bool
+IsDuplicateMessage(WMMsgQueuePtr pQueue, winWMMessagePtr pMsg)
 {
+    int i, n;
 
-    /* Lock the queue mutex */
-    pthread_mutex_lock(&pQueue->pmMutex);
+    if (pMsg->msg != WM_WM_NAME_EVENT && pMsg->msg != WM_WM_ICON_EVENT
+        && pMsg->msg != WM_WM_HINTS_EVENT)
+        return FALSE;
 
-    pNode->pNext = NULL;
+    n = min(pQueue->iCount, WM_MSG_COALESCE_DEPTH);
+    for (i = 1; i <= n; i++) {
+        winWMMessagePtr pQueued =
+            &pQueue->pRing[(pQueue->iHead + pQueue->iCount - i) & (pQueue->iSize - 1)];
 
-    if (pQueue->pTail != NULL) {
-        pQueue->pTail->pNext = pNode;
+        if (pQueued->iWindow != pMsg->iWindow)
+            continue;
+        return pQueued->msg == pMsg->msg;
     }
-    pQueue->pTail = pNode;
 
-    if (pQueue->pHead == NULL) {
-        pQueue->pHead = pNode;
-    }
+    return FALSE;
+}
 
-    /* Release the queue mutex */
-    pthread_mutex_unlock(&pQueue->pmMutex);
+/*
+ * GrowQueue - Double the ring, keeping the queued messages in order
+ */
 
-    /* Signal that the queue is not empty */
-    pthread_cond_signal(&pQueue->pcNotEmpty);
+static Bool
+GrowQueue(WMMsgQueuePtr pQueue)
+{
+    winWMMessagePtr pRing;
+    int i;
+
+    pRing = malloc(2 * pQueue->iSize * sizeof(winWMMessageRec));
+    if (!pRing)
+        return FALSE;
+
+    for (i = 0; i < pQueue->iCount; i++)
+        pRing[i] = pQueue->pRing[(pQueue->iHead + i) & (pQueue->iSize - 1)];
+
+    free(pQueue->pRing);
+    pQueue->pRing = pRing;
+    pQueue->iSize *= 2;
+    pQueue->iHead = 0;
+
+    return TRUE;
 }
 
 /*
- * PopMessage - Pop a message from the queue
+ * PushMessage - Push a message onto the queue
  */
 
-static WMMsgNodePtr
-PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo)
+static void
+PushMessage(WMMsgQueuePtr pQueue, winWMMessagePtr pMsg)
 {
-    WMMsgNodePtr pNode;
 
     /* Lock the queue mutex */
-    pthread_mutex_lock(&pQueue->pmMutex);
+    winMtxLock(&pQueue->pmMutex);
 
-    /* Wait for --- */
-    while (pQueue->pHead == NULL) {
-        pthread_cond_wait(&pQueue->pcNotEmpty, &pQueue->pmMutex);
+    if (IsDuplicateMessage(pQueue, pMsg)) {
+        winDebug("PushMessage - coalesced %s for 0x%08x\n",
+                 MessageName(pMsg), pMsg->iWindow);
+        winMtxUnlock(&pQueue->pmMutex);
+        return;
     }
 
-    pNode = pQueue->pHead;
-    if (pQueue->pHead != NULL) {
-        pQueue->pHead = pQueue->pHead->pNext;
+    /*
+       The senders must never block waiting for the WM thread, which may
+       itself be waiting on them in SendMessage(), so grow rather than wait
+       when the ring is full.
+     */
+    if (pQueue->iCount == pQueue->iSize && !GrowQueue(pQueue)) {
+        ErrorF("PushMessage - queue full, dropping %s\n", MessageName(pMsg));
+        winMtxUnlock(&pQueue->pmMutex);
+        return;
     }
 
-    if (pQueue->pTail == pNode) {
-        pQueue->pTail = NULL;
-    }
+    pQueue->pRing[(pQueue->iHead + pQueue->iCount) & (pQueue->iSize - 1)] =
+        *pMsg;
+    pQueue->iCount++;
 
     /* Release the queue mutex */
-    pthread_mutex_unlock(&pQueue->pmMutex);
+    winMtxUnlock(&pQueue->pmMutex);
 
-    return pNode;
+    /* Signal that the queue is not empty */
+    winCndSignal(&pQueue->pcNotEmpty);
 }
 
-#if 0
 /*
- * HaveMessage -
+ * PopMessage - Pop a message from the queue
  */
 
 static Bool
-HaveMessage(WMMsgQueuePtr pQueue, UINT msg, xcb_window_t iWindow)
+PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo, winWMMessagePtr pMsg)
 {
-    WMMsgNodePtr pNode;
+    /* Lock the queue mutex */
+    winMtxLock(&pQueue->pmMutex);
 
-    for (pNode = pQueue->pHead; pNode != NULL; pNode = pNode->pNext) {
-        if (pNode->msg.msg == msg && pNode->msg.iWindow == iWindow)
-            return True;
+    /* Wait for --- */
+    while (pQueue->iCount == 0) {
+        winCndWait(&pQueue->pcNotEmpty, &pQueue->pmMutex);
     }
 
-    return False;
+    *pMsg = pQueue->pRing[pQueue->iHead];
+    pQueue->iHead = (pQueue->iHead + 1) & (pQueue->iSize - 1);
+    pQueue->iCount--;
+
+    /* Release the queue mutex */
+    winMtxUnlock(&pQueue->pmMutex);
+
+    return TRUE;
 }
-#endif
 
 /*
  * InitQueue - Initialize the Window Manager message queue
@@ -348,21 +392,19 @@ InitQueue(WMMsgQueuePtr pQueue)
         return FALSE;
     }
 
-    /* Set the head and tail to NULL */
-    pQueue->pHead = NULL;
-    pQueue->pTail = NULL;
-
-    winDebug("InitQueue - Calling pthread_mutex_init\n");
+    /* Preallocate the ring */
+    pQueue->pRing = malloc(WM_MSG_QUEUE_SIZE * sizeof(winWMMessageRec));
+    if (pQueue->pRing == NULL) {
+        ErrorF("InitQueue - malloc failed.  Exiting.\n");
+        return FALSE;
+    }
+    pQueue->iSize = WM_MSG_QUEUE_SIZE;
+    pQueue->iHead = 0;
+    pQueue->iCount = 0;
 
     /* Create synchronization objects */
-    pthread_mutex_init(&pQueue->pmMutex, NULL);
-
-    winDebug("InitQueue - pthread_mutex_init returned\n");
-    winDebug("InitQueue - Calling pthread_cond_init\n");
-
-    pthread_cond_init(&pQueue->pcNotEmpty, NULL);
-
-    winDebug("InitQueue - pthread_cond_init returned\n");
+    winMtxInit(&pQueue->pmMutex, "WM queue");
+    winCndInit(&pQueue->pcNotEmpty);
 
     return TRUE;
 }
@@ -398,33 +440,44 @@ GetWindowName(WMInfoPtr pWMInfo, xcb_window_t iWin, char **ppWindowName)
     xcb_connection_t *conn = pWMInfo->conn;
     char *pszWindowName = NULL;
 
+    xcb_get_property_cookie_t cookie_net_wm_name;
+    xcb_get_property_cookie_t cookie_wm_name;
+    xcb_get_property_cookie_t cookie_client_machine;
+
     winDebug ("GetWindowName\n");
 
+    /* Ask for everything we might need at once, rather than one round trip
+       at a time; unwanted replies are discarded */
+    cookie_net_wm_name = xcb_get_property(conn, FALSE, iWin,
+                                          pWMInfo->atmNetWmName,
+                                          XCB_GET_PROPERTY_TYPE_ANY, 0, INT_MAX);
+    cookie_wm_name = xcb_icccm_get_wm_name(conn, iWin);
+    if (g_fHostInTitle)
+        cookie_client_machine = xcb_icccm_get_wm_client_machine(conn, iWin);
+
     /* Try to get window name from _NET_WM_NAME */
     {
-        xcb_get_property_cookie_t cookie;
         xcb_get_property_reply_t *reply;
 
-        cookie = xcb_get_property(pWMInfo->conn, FALSE, iWin,
-                                  pWMInfo->atmNetWmName,
-                                  XCB_GET_PROPERTY_TYPE_ANY, 0, INT_MAX);
-        reply = xcb_get_property_reply(pWMInfo->conn, cookie, NULL);
+        reply = xcb_get_property_reply(conn, cookie_net_wm_name, NULL);
         if (reply && (reply->type != XCB_NONE)) {
             pszWindowName = strndup(xcb_get_property_value(reply),
                                     xcb_get_property_value_length(reply));
-            free(reply);
         }
+        free(reply);
     }
 
     /* Otherwise, try to get window name from WM_NAME */
-    if (!pszWindowName)
+    if (pszWindowName)
+        xcb_discard_reply(conn, cookie_wm_name.sequence);
+    else
         {
-            xcb_get_property_cookie_t cookie;
             xcb_icccm_get_text_property_reply_t reply;
 
-            cookie = xcb_icccm_get_wm_name(conn, iWin);
-            if (!xcb_icccm_get_wm_name_reply(conn, cookie, &reply, NULL)) {
+            if (!xcb_icccm_get_wm_name_reply(conn, cookie_wm_name, &reply, NULL)) {
                 ErrorF("GetWindowName - xcb_icccm_get_wm_name_reply failed.  No name.\n");
+                if (g_fHostInTitle)
+                    xcb_discard_reply(conn, cookie_client_machine.sequence);
                 *ppWindowName = NULL;
                 return;
             }
@@ -437,12 +490,10 @@ GetWindowName(WMInfoPtr pWMInfo, xcb_window_t iWin, char **ppWindowName)
     *ppWindowName = pszWindowName;
 
     if (g_fHostInTitle) {
-        xcb_get_property_cookie_t cookie;
         xcb_icccm_get_text_property_reply_t reply;
 
         /* Try to get client machine name */
-        cookie = xcb_icccm_get_wm_client_machine(conn, iWin);
-        if (xcb_icccm_get_wm_client_machine_reply(conn, cookie, &reply, NULL)) {
+        if (xcb_icccm_get_wm_client_machine_reply(conn, cookie_client_machine, &reply, NULL)) {
             char *pszClientMachine;
             char *pszClientHostname;
             char *dot;
@@ -587,19 +638,78 @@ IsOverrideRedirect(xcb_connection_t *conn, xcb_window_t iWin)
 }
 
 /*
- * Helper function to get class and window names
+ * The stored HWND for a window the WM manages, or NULL if there is none or
+ * the window is override-redirect.  Same as getHwnd() and
+ * IsOverrideRedirect() together, but in a single round trip.
+ */
+static HWND
+GetManagedHwnd(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    HWND hWnd = NULL;
+    Bool fOverrideRedirect = FALSE;
+    xcb_get_property_cookie_t cookie;
+    xcb_get_property_reply_t *reply;
+    xcb_get_window_attributes_cookie_t cookie_attr;
+    xcb_get_window_attributes_reply_t *reply_attr;
+
+    cookie = xcb_get_property(pWMInfo->conn, FALSE, iWindow, pWMInfo->atmPrivMap,
+                              XCB_ATOM_INTEGER, 0L, sizeof(HWND)/4L);
+    cookie_attr = xcb_get_window_attributes(pWMInfo->conn, iWindow);
+
+    reply = xcb_get_property_reply(pWMInfo->conn, cookie, NULL);
+    if (reply) {
+        int length = xcb_get_property_value_length(reply);
+        HWND *value = xcb_get_property_value(reply);
+
+        if (value && (length == sizeof(HWND))) {
+            hWnd = *value;
+        }
+        free(reply);
+    }
+
+    reply_attr = xcb_get_window_attributes_reply(pWMInfo->conn, cookie_attr, NULL);
+    if (reply_attr) {
+        fOverrideRedirect = (reply_attr->override_redirect != 0);
+        free(reply_attr);
+    }
+    else {
+        ErrorF("GetManagedHwnd: Failed to get window attributes\n");
+    }
+
+    /* Some sanity checks */
+    if (!hWnd || fOverrideRedirect)
+        return NULL;
+    if (!IsWindow(hWnd))
+        return NULL;
+
+    return hWnd;
+}
+
+/*
+ * Helper functions to get class and window names, split so the requests
+ * can be sent along with others
 */
+typedef struct {
+    xcb_get_property_cookie_t wm_class;
+    xcb_get_property_cookie_t wm_name;
+} ClassNamesCookies;
+
 static void
-GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
-              char **res_class, char **window_name)
+RequestClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow,
+                  ClassNamesCookies *cookies)
+{
+    cookies->wm_class = xcb_icccm_get_wm_class(pWMInfo->conn, iWindow);
+    cookies->wm_name = xcb_icccm_get_wm_name(pWMInfo->conn, iWindow);
+}
+
+static void
+GetClassNamesReply(WMInfoPtr pWMInfo, ClassNamesCookies *cookies,
+                   char **res_name, char **res_class, char **window_name)
 {
-    xcb_get_property_cookie_t cookie1;
     xcb_icccm_get_wm_class_reply_t reply1;
-    xcb_get_property_cookie_t cookie2;
     xcb_icccm_get_text_property_reply_t reply2;
 
-    cookie1 = xcb_icccm_get_wm_class(pWMInfo->conn, iWindow);
-    if (xcb_icccm_get_wm_class_reply(pWMInfo->conn, cookie1, &reply1,
+    if (xcb_icccm_get_wm_class_reply(pWMInfo->conn, cookies->wm_class, &reply1,
                                      NULL)) {
         *res_name = strdup(reply1.instance_name);
         *res_class = strdup(reply1.class_name);
@@ -610,8 +720,8 @@ GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
         *res_class = strdup("");
     }
 
-    cookie2 = xcb_icccm_get_wm_name(pWMInfo->conn, iWindow);
-    if (xcb_icccm_get_wm_name_reply(pWMInfo->conn, cookie2, &reply2, NULL)) {
+    if (xcb_icccm_get_wm_name_reply(pWMInfo->conn, cookies->wm_name, &reply2,
+                                    NULL)) {
         *window_name = strndup(reply2.name, reply2.name_len);
         xcb_icccm_get_text_property_reply_wipe(&reply2);
     }
@@ -620,42 +730,56 @@ GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
     }
 }
 
+static void
+GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
+              char **res_class, char **window_name)
+{
+    ClassNamesCookies cookies;
+
+    RequestClassNames(pWMInfo, iWindow, &cookies);
+    GetClassNamesReply(pWMInfo, &cookies, res_name, res_class, window_name);
+}
+
 /*
  * Updates the name of a HWND according to its X WM_NAME property
  */
 
+static void
+ApplyName(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd)
+{
+    char *pszWindowName;
+
+    /* Get the X windows window name */
+    GetWindowName(pWMInfo, iWindow, &pszWindowName);
+
+    if (pszWindowName) {
+        /* Convert from UTF-8 to wide char */
+        int iLen =
+            MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1, NULL, 0);
+        wchar_t *pwszWideWindowName =
+            malloc(sizeof(wchar_t)*(iLen + 1));
+        MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1,
+                            pwszWideWindowName, iLen);
+
+        /* Set the Windows window name */
+        SetWindowTextW(hWnd, pwszWideWindowName);
+
+        free(pwszWideWindowName);
+        free(pszWindowName);
+    }
+}
+
 static void
 UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow)
 {
     HWND hWnd;
 
-    hWnd = getHwnd(pWMInfo, iWindow);
+    /* If window isn't override-redirect */
+    hWnd = GetManagedHwnd(pWMInfo, iWindow);
     if (!hWnd)
         return;
 
-    /* If window isn't override-redirect */
-    if (!IsOverrideRedirect(pWMInfo->conn, iWindow)) {
-        char *pszWindowName;
-
-        /* Get the X windows window name */
-        GetWindowName(pWMInfo, iWindow, &pszWindowName);
-
-        if (pszWindowName) {
-            /* Convert from UTF-8 to wide char */
-            int iLen =
-                MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1, NULL, 0);
-            wchar_t *pwszWideWindowName =
-                malloc(sizeof(wchar_t)*(iLen + 1));
-            MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1,
-                                pwszWideWindowName, iLen);
-
-            /* Set the Windows window name */
-            SetWindowTextW(hWnd, pwszWideWindowName);
-
-            free(pwszWideWindowName);
-            free(pszWindowName);
-        }
-    }
+    ApplyName(pWMInfo, iWindow, hWnd);
 }
 
 /*
@@ -663,30 +787,34 @@ UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow)
  */
 
 static void
-UpdateIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+ApplyIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd)
 {
-    HWND hWnd;
     HICON hIconNew = NULL;
+    char *window_name = 0;
+    char *res_name = 0;
+    char *res_class = 0;
 
-    hWnd = getHwnd(pWMInfo, iWindow);
-    if (!hWnd)
-        return;
+    GetClassNames(pWMInfo, iWindow, &res_name, &res_class, &window_name);
 
-    /* If window isn't override-redirect */
-    if (!IsOverrideRedirect(pWMInfo->conn, iWindow)) {
-        char *window_name = 0;
-        char *res_name = 0;
-        char *res_class = 0;
+    hIconNew = winOverrideIcon(res_name, res_class, window_name);
 
-        GetClassNames(pWMInfo, iWindow, &res_name, &res_class, &window_name);
+    free(res_name);
+    free(res_class);
+    free(window_name);
+    winUpdateIcon(hWnd, pWMInfo->conn, iWindow, hIconNew);
+}
+
+static void
+UpdateIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    HWND hWnd;
 
-        hIconNew = winOverrideIcon(res_name, res_class, window_name);
+    /* If window isn't override-redirect */
+    hWnd = GetManagedHwnd(pWMInfo, iWindow);
+    if (!hWnd)
+        return;
 
-        free(res_name);
-        free(res_class);
-        free(window_name);
-        winUpdateIcon(hWnd, pWMInfo->conn, iWindow, hIconNew);
-    }
+    ApplyIcon(pWMInfo, iWindow, hWnd);
 }
 
 /*
@@ -694,20 +822,11 @@ UpdateIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow)
  */
 
 static void
-UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int extra)
+ApplyStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, unsigned long *maxmin, int extra)
 {
-    HWND hWnd;
     HWND zstyle = HWND_NOTOPMOST;
     UINT flags;
 
-    /* If window isn't override-redirect */
-    if (IsOverrideRedirect(pWMInfo->conn, iWindow))
-        return;
-
-    hWnd = getHwnd(pWMInfo, iWindow);
-    if (!hWnd)
-        return;
-
     /* Determine the Window style, which determines borders and clipping region... */
     winApplyHints(pWMInfo, iWindow, hWnd, &zstyle, maxmin);
     if (extra)
@@ -735,6 +854,19 @@ UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int
                             GetWindowLongPtr(hWnd, GWLP_HWNDPARENT)==0 ? TRUE : FALSE);
 }
 
+static void
+UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int extra)
+{
+    HWND hWnd;
+
+    /* If window isn't override-redirect */
+    hWnd = GetManagedHwnd(pWMInfo, iWindow);
+    if (!hWnd)
+        return;
+
+    ApplyStyle(pWMInfo, iWindow, hWnd, maxmin, extra);
+}
+
 /*
  * Updates the state of a HWND
  */
@@ -941,11 +1073,10 @@ winMultiWindowWMProc(void *pArg)
 
     /* Loop until we explicitly break out */
     for (;;) {
-        WMMsgNodePtr pNode;
+        winWMMessageRec msg;
 
         /* Pop a message off of our queue */
-        pNode = PopMessage(&pWMInfo->wmMsgQueue, pWMInfo);
-        if (pNode == NULL) {
+        if (!PopMessage(&pWMInfo->wmMsgQueue, pWMInfo, &msg)) {
             /* Bail if PopMessage returns without a message */
             /* NOTE: Remember that PopMessage is a blocking function. */
             ErrorF("winMultiWindowWMProc - Queue is Empty?  Exiting.\n");
@@ -953,15 +1084,17 @@ winMultiWindowWMProc(void *pArg)
         }
 
         winDebug("winMultiWindowWMProc - MSG: %s (%d) ID: %d\n",
-               MessageName(&(pNode->msg)), (int)pNode->msg.msg, (int)pNode->msg.dwID);
+               MessageName(&msg), (int)msg.msg, (int)msg.dwID);
+        WinTraceStart("WMMessage", TraceLoggingUInt32(msg.msg, "Message"),
+                      TraceLoggingHexUInt32(msg.iWindow, "Window"));
 
         /* Branch on the message type */
-        switch (pNode->msg.msg) {
+        switch (msg.msg) {
         case WM_WM_RAISE:
             /* Raise the window */
             {
                 const static uint32_t values[] = { XCB_STACK_MODE_ABOVE };
-                xcb_configure_window(pWMInfo->conn, pNode->msg.iWindow,
+                xcb_configure_window(pWMInfo->conn, msg.iWindow,
                                      XCB_CONFIG_WINDOW_STACK_MODE, values);
             }
 
@@ -971,7 +1104,7 @@ winMultiWindowWMProc(void *pArg)
             /* Lower the window */
             {
                 const static uint32_t values[] = { XCB_STACK_MODE_BELOW };
-                xcb_configure_window(pWMInfo->conn, pNode->msg.iWindow,
+                xcb_configure_window(pWMInfo->conn, msg.iWindow,
                                      XCB_CONFIG_WINDOW_STACK_MODE, values);
             }
             break;
@@ -979,47 +1112,53 @@ winMultiWindowWMProc(void *pArg)
         case WM_WM_MAP_UNMANAGED:
             /* Put a note as to the HWND associated with this Window */
             xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
-                                pNode->msg.iWindow, pWMInfo->atmPrivMap,
+                                msg.iWindow, pWMInfo->atmPrivMap,
                                 XCB_ATOM_INTEGER, 32,
-                                sizeof(HWND)/4, &(pNode->msg.hwndWindow));
+                                sizeof(HWND)/4, &(msg.hwndWindow));
 
             break;
 
         case WM_WM_MAP_MANAGED:
           {
             unsigned long maxmin = 0;
+            HWND hWnd;
 
             /* Put a note as to the HWND associated with this Window */
             xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
-                                pNode->msg.iWindow, pWMInfo->atmPrivMap,
+                                msg.iWindow, pWMInfo->atmPrivMap,
                                 XCB_ATOM_INTEGER, 32,
-                                sizeof(HWND)/4, &(pNode->msg.hwndWindow));
+                                sizeof(HWND)/4, &(msg.hwndWindow));
 
-            UpdateName(pWMInfo, pNode->msg.iWindow);
-            UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 1);
+            /* Look the window up once for name, style and icon */
+            hWnd = GetManagedHwnd(pWMInfo, msg.iWindow);
+            if (hWnd) {
+                ApplyName(pWMInfo, msg.iWindow, hWnd);
+                ApplyStyle(pWMInfo, msg.iWindow, hWnd, &maxmin, 1);
+            }
 
             /* Reshape */
             {
                 WindowPtr pWin =
-                    GetProp(pNode->msg.hwndWindow, WIN_WINDOW_PROP);
+                    GetProp(msg.hwndWindow, WIN_WINDOW_PROP);
                 if (pWin) {
                     winReshapeMultiWindow(pWin);
                     winUpdateRgnMultiWindow(pWin);
                 }
             }
 
-            UpdateIcon(pWMInfo, pNode->msg.iWindow);
+            if (hWnd)
+                ApplyIcon(pWMInfo, msg.iWindow, hWnd);
             /* Establish initial state */
-            UpdateState(pWMInfo, pNode->msg.iWindow, XCB_ICCCM_WM_STATE_NORMAL);
+            UpdateState(pWMInfo, msg.iWindow, XCB_ICCCM_WM_STATE_NORMAL);
 
             /*
               It only makes sense to apply minimize/maximize override as the
               initial state, otherwise that state can't be changed.
             */
             if (maxmin & HINT_MAX)
-                SendMessage(pNode->msg.hwndWindow, WM_SYSCOMMAND, SC_MAXIMIZE, 0);
+                SendMessage(msg.hwndWindow, WM_SYSCOMMAND, SC_MAXIMIZE, 0);
             else if (maxmin & HINT_MIN)
-                SendMessage(pNode->msg.hwndWindow, WM_SYSCOMMAND, SC_MINIMIZE, 0);
+                SendMessage(msg.hwndWindow, WM_SYSCOMMAND, SC_MINIMIZE, 0);
           }
 
             break;
@@ -1027,20 +1166,20 @@ winMultiWindowWMProc(void *pArg)
         case WM_WM_UNMAP:
 
             /* Unmap the window */
-            xcb_unmap_window(pWMInfo->conn, pNode->msg.iWindow);
+            xcb_unmap_window(pWMInfo->conn, msg.iWindow);
             break;
 
         case WM_WM_KILL:
             {
                 /* --- */
                 if (IsWmProtocolAvailable(pWMInfo,
-                                          pNode->msg.iWindow,
+                                          msg.iWindow,
                                           pWMInfo->atmWmDelete))
                     SendXMessage(pWMInfo->conn,
-                                 pNode->msg.iWindow,
+                                 msg.iWindow,
                                  pWMInfo->atmWmProtos, pWMInfo->atmWmDelete);
                 else
-                    xcb_kill_client(pWMInfo->conn, pNode->msg.iWindow);
+                    xcb_kill_client(pWMInfo->conn, msg.iWindow);
             }
             break;
 
@@ -1055,13 +1194,13 @@ winMultiWindowWMProc(void *pArg)
                -- independently, the WM_TAKE_FOCUS protocol determines whether
                the WM should send a WM_TAKE_FOCUS ClientMessage.
             */
-            if (pNode->msg.iWindow)
+            if (msg.iWindow)
             {
               Bool neverFocus = FALSE;
               xcb_get_property_cookie_t cookie;
               xcb_icccm_wm_hints_t hints;
 
-              cookie = xcb_icccm_get_wm_hints(pWMInfo->conn, pNode->msg.iWindow);
+              cookie = xcb_icccm_get_wm_hints(pWMInfo->conn, msg.iWindow);
               if (xcb_icccm_get_wm_hints_reply(pWMInfo->conn, cookie, &hints,
                                                NULL)) {
                 if (hints.flags & XCB_ICCCM_WM_HINT_INPUT)
@@ -1070,13 +1209,13 @@ winMultiWindowWMProc(void *pArg)
 
               if (!neverFocus)
                 xcb_set_input_focus(pWMInfo->conn, XCB_INPUT_FOCUS_PARENT,
-                                    pNode->msg.iWindow, XCB_CURRENT_TIME);
+                                    msg.iWindow, XCB_CURRENT_TIME);
 
               if (IsWmProtocolAvailable(pWMInfo,
-                                        pNode->msg.iWindow,
+                                        msg.iWindow,
                                         pWMInfo->atmWmTakeFocus))
                 SendXMessage(pWMInfo->conn,
-                             pNode->msg.iWindow,
+                             msg.iWindow,
                              pWMInfo->atmWmProtos, pWMInfo->atmWmTakeFocus);
 
             }
@@ -1090,23 +1229,23 @@ winMultiWindowWMProc(void *pArg)
             break;
 
         case WM_WM_NAME_EVENT:
-            UpdateName(pWMInfo, pNode->msg.iWindow);
+            UpdateName(pWMInfo, msg.iWindow);
             break;
 
         case WM_WM_ICON_EVENT:
-            UpdateIcon(pWMInfo, pNode->msg.iWindow);
+            UpdateIcon(pWMInfo, msg.iWindow);
             break;
 
         case WM_WM_HINTS_EVENT:
             {
             unsigned long maxmin = 0;
 
-            UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 0);
+            UpdateStyle(pWMInfo, msg.iWindow, &maxmin, 0);
             }
             break;
 
         case WM_WM_CHANGE_STATE:
-            UpdateState(pWMInfo, pNode->msg.iWindow, pNode->msg.dwID);
+            UpdateState(pWMInfo, msg.iWindow, msg.dwID);
             break;
 
         default:
@@ -1117,6 +1256,7 @@ winMultiWindowWMProc(void *pArg)
 
         /* Flush any pending events on our display */
         xcb_flush(pWMInfo->conn);
+        WinTraceStop("WMMessage", TraceLoggingUInt32(msg.msg, "Message"));
 
         /* This is just laziness rather than making sure we used _checked everywhere */
         {
@@ -1138,9 +1278,6 @@ winMultiWindowWMProc(void *pArg)
             }
         }
 
-        /* Free the retrieved message */
-        free(pNode);
-
         /* I/O errors etc. */
         {
             int e = xcb_connection_has_error(pWMInfo->conn);
@@ -1151,11 +1288,8 @@ winMultiWindowWMProc(void *pArg)
         }
     }
 
-    /* Free the condition variable */
-    pthread_cond_destroy(&pWMInfo->wmMsgQueue.pcNotEmpty);
-
-    /* Free the mutex variable */
-    pthread_mutex_destroy(&pWMInfo->wmMsgQueue.pmMutex);
+    free(pWMInfo->wmMsgQueue.pRing);
+    pWMInfo->wmMsgQueue.pRing = NULL;
 
     xcb_disconnect(pWMInfo->conn);
     xcb_errors_context_free(pWMInfo->err_ctx);
@@ -1189,6 +1323,39 @@ intern_atom(xcb_connection_t *conn, const char *atomName)
   return atom;
 }
 
+typedef struct {
+  const char *name;
+  xcb_atom_t *atom;
+} AtomRequest;
+
+/* Intern several atoms with a single round trip */
+static void
+intern_atoms(xcb_connection_t *conn, const AtomRequest *req, int count)
+{
+  xcb_intern_atom_cookie_t *cookies;
+  xcb_intern_atom_reply_t *atom_reply;
+  int i;
+
+  cookies = calloc(count, sizeof(xcb_intern_atom_cookie_t));
+  if (!cookies) {
+    for (i = 0; i < count; i++)
+      *req[i].atom = intern_atom(conn, req[i].name);
+    return;
+  }
+
+  for (i = 0; i < count; i++)
+    cookies[i] = xcb_intern_atom(conn, 0, strlen(req[i].name), req[i].name);
+  for (i = 0; i < count; i++) {
+    *req[i].atom = XCB_ATOM_NONE;
+    atom_reply = xcb_intern_atom_reply(conn, cookies[i], NULL);
+    if (atom_reply) {
+      *req[i].atom = atom_reply->atom;
+      free(atom_reply);
+    }
+  }
+  free(cookies);
+}
+
 /*
  * X message procedure
  */
@@ -1308,15 +1475,21 @@ winMultiWindowXMsgProc(void *pArg)
                             sizeof(xis)/4, &xis);
     }
 
-    atmWmName = intern_atom(pProcArg->conn, "WM_NAME");
-    atmNetWmName = intern_atom(pProcArg->conn, "_NET_WM_NAME");
-    atmWmHints = intern_atom(pProcArg->conn, "WM_HINTS");
-    atmWmChange = intern_atom(pProcArg->conn, "WM_CHANGE_STATE");
-    atmNetWmIcon = intern_atom(pProcArg->conn, "_NET_WM_ICON");
-    atmWindowState = intern_atom(pProcArg->conn, "_NET_WM_STATE");
-    atmMotifWmHints = intern_atom(pProcArg->conn, "_MOTIF_WM_HINTS");
-    atmWindowType = intern_atom(pProcArg->conn, "_NET_WM_WINDOW_TYPE");
-    atmNormalHints = intern_atom(pProcArg->conn, "WM_NORMAL_HINTS");
+    {
+        const AtomRequest req[] = {
+            { "WM_NAME", &atmWmName },
+            { "_NET_WM_NAME", &atmNetWmName },
+            { "WM_HINTS", &atmWmHints },
+            { "WM_CHANGE_STATE", &atmWmChange },
+            { "_NET_WM_ICON", &atmNetWmIcon },
+            { "_NET_WM_STATE", &atmWindowState },
+            { "_MOTIF_WM_HINTS", &atmMotifWmHints },
+            { "_NET_WM_WINDOW_TYPE", &atmWindowType },
+            { "WM_NORMAL_HINTS", &atmNormalHints },
+        };
+
+        intern_atoms(pProcArg->conn, req, ARRAY_SIZE(req));
+    }
 
     /*
       Enable Composite extension and redirect subwindows of the root window
@@ -1330,24 +1503,34 @@ winMultiWindowXMsgProc(void *pArg)
         reply = xcb_query_extension_reply(pProcArg->conn, cookie, NULL);
 
         if (reply && (reply->present)) {
-            xcb_composite_redirect_subwindows(pProcArg->conn,
-                                              root_window_id,
-                                              XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+            xcb_void_cookie_t redirect;
+            xcb_generic_error_t *error;
 
             /*
-              We use automatic updating of the root window for two
-              reasons:
-
-              1) redirected window contents are mirrored to the root
-              window so that the root window draws correctly when shown.
-
-              2) updating the root window causes damage against the
-              shadow framebuffer, which ultimately causes WM_PAINT to be
-              sent to the affected window(s) to cause the damage regions
-              to be redrawn.
+              Redirect manually: the root window is never shown, and the
+              server paints each Windows window from its X window's
+              pixmap, tracking the damage to it directly, so there is no
+              need to copy every window's contents to the root window too.
+
+              Only one client may redirect manually.  If another already
+              does, fall back to automatic updating of the root window,
+              which mirrors the window contents there at the cost of that
+              copy.
             */
-
-            ErrorF("Using Composite redirection\n");
+            redirect =
+                xcb_composite_redirect_subwindows_checked(pProcArg->conn,
+                                                          root_window_id,
+                                                          XCB_COMPOSITE_REDIRECT_MANUAL);
+            error = xcb_request_check(pProcArg->conn, redirect);
+            if (error) {
+                free(error);
+                xcb_composite_redirect_subwindows(pProcArg->conn,
+                                                  root_window_id,
+                                                  XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+                ErrorF("Using automatic Composite redirection\n");
+            }
+            else
+                ErrorF("Using Composite redirection\n");
 
             free(reply);
         }
@@ -1758,16 +1941,22 @@ winInitMultiWindowWM(WMInfoPtr pWMInfo, WMProcArgPtr pProcArg)
     xcb_errors_context_new(pWMInfo->conn, &pWMInfo->err_ctx);
 
     /* Create some atoms */
-    pWMInfo->atmWmProtos = intern_atom(pWMInfo->conn, "WM_PROTOCOLS");
-    pWMInfo->atmWmDelete = intern_atom(pWMInfo->conn, "WM_DELETE_WINDOW");
-    pWMInfo->atmWmTakeFocus = intern_atom(pWMInfo->conn, "WM_TAKE_FOCUS");
-    pWMInfo->atmPrivMap = intern_atom(pWMInfo->conn, WINDOWSWM_NATIVE_HWND);
-    pWMInfo->atmUtf8String = intern_atom(pWMInfo->conn, "UTF8_STRING");
-    pWMInfo->atmNetWmName = intern_atom(pWMInfo->conn, "_NET_WM_NAME");
-    pWMInfo->atmCurrentDesktop = intern_atom(pWMInfo->conn, "_NET_CURRENT_DESKTOP");
-    pWMInfo->atmNumberDesktops = intern_atom(pWMInfo->conn, "_NET_NUMBER_OF_DESKTOPS");
-    pWMInfo->atmDesktopNames = intern_atom(pWMInfo->conn, "__NET_DESKTOP_NAMES");
-    pWMInfo->atmWmState = intern_atom(pWMInfo->conn, "WM_STATE");
+    {
+        const AtomRequest req[] = {
+            { "WM_PROTOCOLS", &pWMInfo->atmWmProtos },
+            { "WM_DELETE_WINDOW", &pWMInfo->atmWmDelete },
+            { "WM_TAKE_FOCUS", &pWMInfo->atmWmTakeFocus },
+            { WINDOWSWM_NATIVE_HWND, &pWMInfo->atmPrivMap },
+            { "UTF8_STRING", &pWMInfo->atmUtf8String },
+            { "_NET_WM_NAME", &pWMInfo->atmNetWmName },
+            { "_NET_CURRENT_DESKTOP", &pWMInfo->atmCurrentDesktop },
+            { "_NET_NUMBER_OF_DESKTOPS", &pWMInfo->atmNumberDesktops },
+            { "__NET_DESKTOP_NAMES", &pWMInfo->atmDesktopNames },
+            { "WM_STATE", &pWMInfo->atmWmState },
+        };
+
+        intern_atoms(pWMInfo->conn, req, ARRAY_SIZE(req));
+    }
 
     /* Initialization for the xcb_ewmh and EWMH atoms */
     {
@@ -1879,15 +2068,9 @@ winMultiWindowThreadExit(void *arg)
 void
 winSendMessageToWM(void *pWMInfo, winWMMessagePtr pMsg)
 {
-    WMMsgNodePtr pNode;
-
     winDebug("winSendMessageToWM %s\n", MessageName(pMsg));
 
-    pNode = malloc(sizeof(WMMsgNodeRec));
-    if (pNode != NULL) {
-        memcpy(&pNode->msg, pMsg, sizeof(winWMMessageRec));
-        PushMessage(&((WMInfoPtr) pWMInfo)->wmMsgQueue, pNode);
-    }
+    PushMessage(&((WMInfoPtr) pWMInfo)->wmMsgQueue, pMsg);
 }
 
 /*
@@ -1975,6 +2158,9 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     unsigned long style, exStyle;
     unsigned long oristyle, oriexStyle;
     Bool nodecoration = FALSE;
+    xcb_get_property_cookie_t cookie_wm_state, cookie_mwm_hint;
+    xcb_get_property_cookie_t cookie_wm_window_type, cookie_normal_hints;
+    ClassNamesCookies cookies_class_names;
 
     *maxmin = 0;
 
@@ -1985,18 +2171,30 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
 
     if (generation != serverGeneration) {
         generation = serverGeneration;
-        windowState = intern_atom(conn, "_NET_WM_STATE");
-        motif_wm_hints = intern_atom(conn, "_MOTIF_WM_HINTS");
-        hiddenState = intern_atom(conn, "_NET_WM_STATE_HIDDEN");
-        fullscreenState = intern_atom(conn, "_NET_WM_STATE_FULLSCREEN");
-        belowState = intern_atom(conn, "_NET_WM_STATE_BELOW");
-        aboveState = intern_atom(conn, "_NET_WM_STATE_ABOVE");
-        skiptaskbarState = intern_atom(conn, "_NET_WM_STATE_SKIP_TASKBAR");
-        splashType = intern_atom(conn, "_NET_WM_WINDOW_TYPE_SPLASHSCREEN");
+        {
+            const AtomRequest req[] = {
+                { "_NET_WM_STATE", &windowState },
+                { "_MOTIF_WM_HINTS", &motif_wm_hints },
+                { "_NET_WM_STATE_HIDDEN", &hiddenState },
+                { "_NET_WM_STATE_FULLSCREEN", &fullscreenState },
+                { "_NET_WM_STATE_BELOW", &belowState },
+                { "_NET_WM_STATE_ABOVE", &aboveState },
+                { "_NET_WM_STATE_SKIP_TASKBAR", &skiptaskbarState },
+                { "_NET_WM_WINDOW_TYPE_SPLASHSCREEN", &splashType },
+            };
+
+            intern_atoms(conn, req, ARRAY_SIZE(req));
+        }
     }
 
+    /* Send all the requests before waiting for the first reply */
+    cookie_wm_state = xcb_get_property(conn, FALSE, iWindow, windowState, XCB_ATOM_ATOM, 0L, INT_MAX);
+    cookie_mwm_hint = xcb_get_property(conn, FALSE, iWindow, motif_wm_hints, motif_wm_hints, 0L, sizeof(MwmHints));
+    cookie_wm_window_type = xcb_ewmh_get_wm_window_type(&pWMInfo->ewmh, iWindow);
+    cookie_normal_hints = xcb_icccm_get_wm_normal_hints(conn, iWindow);
+    RequestClassNames(pWMInfo, iWindow, &cookies_class_names);
+
     {
-      xcb_get_property_cookie_t cookie_wm_state = xcb_get_property(conn, FALSE, iWindow, windowState, XCB_ATOM_ATOM, 0L, INT_MAX);
       xcb_get_property_reply_t *reply = xcb_get_property_reply(conn, cookie_wm_state, NULL);
       if (reply) {
         int i;
@@ -2030,7 +2228,6 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     }
 
     {
-      xcb_get_property_cookie_t cookie_mwm_hint = xcb_get_property(conn, FALSE, iWindow, motif_wm_hints, motif_wm_hints, 0L, sizeof(MwmHints));
       xcb_get_property_reply_t *reply =  xcb_get_property_reply(conn, cookie_mwm_hint, NULL);
       if (reply) {
         int nitems = xcb_get_property_value_length(reply)/4;
@@ -2100,8 +2297,7 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     {
       int i;
       xcb_ewmh_get_atoms_reply_t type;
-      xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_window_type(&pWMInfo->ewmh, iWindow);
-      if (xcb_ewmh_get_wm_window_type_reply(&pWMInfo->ewmh, cookie, &type, NULL)) {
+      if (xcb_ewmh_get_wm_window_type_reply(&pWMInfo->ewmh, cookie_wm_window_type, &type, NULL)) {
         for (i = 0; i < type.atoms_len; i++) {
             if (type.atoms[i] ==  pWMInfo->ewmh._NET_WM_WINDOW_TYPE_DOCK) {
                 hint &= ~(HINT_BORDER | HINT_SIZEBOX | HINT_CAPTION | HINT_NOFRAME);
@@ -2120,10 +2316,8 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
 
     {
         xcb_size_hints_t size_hints;
-        xcb_get_property_cookie_t cookie;
 
-        cookie = xcb_icccm_get_wm_normal_hints(conn, iWindow);
-        if (xcb_icccm_get_wm_normal_hints_reply(conn, cookie, &size_hints, NULL)) {
+        if (xcb_icccm_get_wm_normal_hints_reply(conn, cookie_normal_hints, &size_hints, NULL)) {
             /* Notwithstanding MwmDecorHandle, if we have a border, and
                WM_NORMAL_HINTS indicates the window should be resizeable, let
                the window have a resizing border.  This is necessary for windows
@@ -2164,7 +2358,8 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
         char *res_class = 0;
         char *rand_id = 0;
 
-        GetClassNames(pWMInfo, iWindow, &res_name, &res_class, &window_name);
+        GetClassNamesReply(pWMInfo, &cookies_class_names,
+                           &res_name, &res_class, &window_name);
 
         style = STYLE_NONE;
         style = winOverrideStyle(res_name, res_class, window_name);
@@ -372,7 +372,8 @@ CheckForAlpha(HWND hWnd, WindowPtr pWin, winScreenInfo *pScreenInfo)
     /* Check (once) which API we should use */
     static Bool doOnce = TRUE;
     static PFNSETWINDOWCOMPOSITIONATTRIBUTE pSetWindowCompositionAttribute = NULL;
-    static Bool useDwmEnableBlurBehindWindow = FALSE;
+    HRESULT hr;
+    WINBOOL enabled;
 
     if (doOnce)
         {
@@ -392,13 +393,6 @@ CheckForAlpha(HWND hWnd, WindowPtr pWin, winScreenInfo *pScreenInfo)
                         pSetWindowCompositionAttribute = (PFNSETWINDOWCOMPOSITIONATTRIBUTE) GetProcAddress(hUser32, "SetWindowCompositionAttribute");
                     winDebug("SetWindowCompositionAttribute %s\n", pSetWindowCompositionAttribute ? "found" : "not found");
                 }
-            /* On Windows 7 and Windows Vista, use DwmEnableBlurBehindWindow() */
-            else if ((osvi.dwMajorVersion == 6) && (osvi.dwMinorVersion <= 1))
-                {
-                    useDwmEnableBlurBehindWindow = TRUE;
-                }
-            /* On Windows 8 and Windows 8.1, using the alpha channel on those
-               seems near impossible, so we don't do anything. */
 
             doOnce = FALSE;
         }
@@ -412,44 +406,45 @@ CheckForAlpha(HWND hWnd, WindowPtr pWin, winScreenInfo *pScreenInfo)
         return;
 
     /* ... and we can do something useful with it? */
+    hr = DwmIsCompositionEnabled(&enabled);
+    if ((hr == S_OK) && enabled)
+        {
+            /* This terribly-named function actually controls if DWM
+               looks at the alpha channel of this window.  With an empty
+               blur region nothing is blurred: DWM just blends the window
+               on the GPU, from the areas the WM_PAINTs have copied in.
+               This works on every version with DWM, Windows 8 and 8.1
+               included. */
+            DWM_BLURBEHIND bbh;
+            HRGN hRgnEmpty = CreateRectRgn(0, 0, -1, -1);
+
+            bbh.dwFlags = DWM_BB_ENABLE | DWM_BB_BLURREGION;
+            bbh.fEnable = TRUE;
+            bbh.hRgnBlur = hRgnEmpty;
+            bbh.fTransitionOnMaximized = FALSE;
+
+            winDebug("enabling alpha for XID %08x hWnd %p, using DwmEnableBlurBehindWindow()\n", (unsigned int)pWin->drawable.id, hWnd);
+            hr = DwmEnableBlurBehindWindow(hWnd, &bbh);
+            DeleteObject(hRgnEmpty);
+            if (hr == S_OK)
+                return;
+            ErrorF("DwmEnableBlurBehindWindow failed: %x, %d\n", (int)hr, (int)GetLastError());
+        }
+
     if (pSetWindowCompositionAttribute)
         {
             WINBOOL rc;
-            /* Use the (undocumented) SetWindowCompositionAttribute, if
-               available, to turn on alpha channel use on Windows 10. */
+            /* Fall back to the (undocumented) SetWindowCompositionAttribute,
+               which also turns on alpha channel use on Windows 10, but
+               blurs what is behind the window. */
             ACCENTPOLICY policy = { ACCENT_ENABLE_BLURBEHIND, 0, 0, 0 } ;
             WINCOMPATTR data = { WCA_ACCENT_POLICY,  &policy, sizeof(ACCENTPOLICY) };
 
-            /* This turns on DWM looking at the alpha-channel of this window */
             winDebug("enabling alpha for XID %08x hWnd %p, using SetWindowCompositionAttribute()\n", (unsigned int)pWin->drawable.id, hWnd);
             rc = pSetWindowCompositionAttribute(hWnd, &data);
             if (!rc)
                 ErrorF("SetWindowCompositionAttribute failed: %d\n", (int)GetLastError());
         }
-    else if (useDwmEnableBlurBehindWindow)
-        {
-            HRESULT rc;
-            WINBOOL enabled;
-
-            rc = DwmIsCompositionEnabled(&enabled);
-            if ((rc == S_OK) && enabled)
-                {
-                    /* Use DwmEnableBlurBehindWindow, to turn on alpha channel
-                       use on Windows Vista and Windows 7 */
-                    DWM_BLURBEHIND bbh;
-                    bbh.dwFlags = DWM_BB_ENABLE | DWM_BB_BLURREGION | DWM_BB_TRANSITIONONMAXIMIZED;
-                    bbh.fEnable = TRUE;
-                    bbh.hRgnBlur = NULL;
-                    bbh.fTransitionOnMaximized = TRUE; /* What does this do ??? */
-
-                    /* This terribly-named function actually controls if DWM
-                       looks at the alpha channel of this window */
-                    winDebug("enabling alpha for XID %08x hWnd %p, using DwmEnableBlurBehindWindow()\n", (unsigned int)pWin->drawable.id, hWnd);
-                    rc = DwmEnableBlurBehindWindow(hWnd, &bbh);
-                    if (rc != S_OK)
-                        ErrorF("DwmEnableBlurBehindWindow failed: %x, %d\n", (int)rc, (int)GetLastError());
-                }
-        }
 }
 
 void DispatchQueuedEvents(Bool);
@@ -706,12 +701,34 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             g_uipMousePollingTimerID = 0;
         }
 
+        /* In relative mode motion comes from WM_INPUT */
+        if (winMouseRelative())
+            return 0;
+
         /* Deliver absolute cursor position to X Server */
-        winEnqueueMotion(ptMouse.x - s_pScreenInfo->dwXOffset,
-                         ptMouse.y - s_pScreenInfo->dwYOffset);
+        if (g_fMouseHistory)
+            winEnqueueMotionHistory(ptMouse.x - s_pScreenInfo->dwXOffset,
+                                    ptMouse.y - s_pScreenInfo->dwYOffset,
+                                    GetSystemMetrics(SM_XVIRTUALSCREEN) +
+                                    s_pScreenInfo->dwXOffset,
+                                    GetSystemMetrics(SM_YVIRTUALSCREEN) +
+                                    s_pScreenInfo->dwYOffset);
+        else
+            winEnqueueMotion(ptMouse.x - s_pScreenInfo->dwXOffset,
+                             ptMouse.y - s_pScreenInfo->dwYOffset);
 
         return 0;
 
+    case WM_INPUT:
+        /* We can't do anything without privates */
+        if (s_pScreenPriv == NULL || s_pScreenInfo->fIgnoreInput)
+            break;
+
+        winMouseRawInput((HRAWINPUT) lParam);
+
+        /* DefWindowProc frees the raw input buffer */
+        break;
+
     case WM_NCMOUSEMOVE:
         /*
          * We break instead of returning 0 since we need to call
@@ -883,6 +900,9 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         /* Remove our keyboard hook if it is installed */
         winRemoveKeyboardHookLL();
 
+        /* Hand the cursor back along with the focus */
+        winMouseStopRelative();
+
         /* Revert the X focus as well */
         if (pWin)
             {
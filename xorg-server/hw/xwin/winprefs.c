@@ -35,6 +35,7 @@
 #endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #ifdef __CYGWIN__
 #include <sys/resource.h>
 #include <sys/cygwin.h>
@@ -63,6 +64,165 @@ extern int parse_file(FILE * fp);
 /* Currently in use command ID, incremented each new menu item created */
 static int g_cmdid = STARTMENUID;
 
+/*
+ * Index over the match strings of an ICONS{}, STYLES{} or TASKBAR{}
+ * section, so a window is matched without a strcmp and strstr per rule.
+ * The first rule in file order still wins.
+ */
+typedef struct {
+    const char *items;          /* The section's array; match comes first */
+    size_t stride;              /* sizeof one item */
+    int *exact;                 /* Hash of match -> first rule, -1 if free */
+    unsigned int exactMask;
+    int *substr;                /* Rules in order, grouped by first byte */
+    int substrStart[257];
+    int anyRule;                /* First rule with an empty match, or -1 */
+} winPrefMatcher;
+
+#define PREF_MATCH(m, i) ((m)->items + (size_t) (i) * (m)->stride)
+
+static winPrefMatcher g_iconMatcher, g_styleMatcher, g_taskbarMatcher;
+
+static unsigned int
+winPrefHash(const char *s)
+{
+    unsigned int h = 2166136261u;
+
+    while (*s)
+        h = (h ^ (unsigned char) *s++) * 16777619u;
+    return h;
+}
+
+/*
+ * Build the index for @count items of @stride bytes at @items.  Rules for
+ * which @used returns FALSE are left out, as if they weren't there.
+ */
+static void
+winPrefMatcherBuild(winPrefMatcher *m, const void *items, size_t stride,
+                    int count, Bool (*used) (int))
+{
+    unsigned int size, h;
+    int i, c;
+
+    free(m->exact);
+    free(m->substr);
+    memset(m, 0, sizeof(*m));
+    m->items = items;
+    m->stride = stride;
+    m->anyRule = -1;
+    if (count <= 0)
+        return;
+
+    for (size = 16; size < 2 * (unsigned int) count; size <<= 1)
+        ;
+    m->exact = malloc(size * sizeof(int));
+    m->substr = malloc(count * sizeof(int));
+    if (!m->exact || !m->substr) {
+        free(m->exact);
+        free(m->substr);
+        m->exact = m->substr = NULL;
+        return;
+    }
+    m->exactMask = size - 1;
+    memset(m->exact, 0xff, size * sizeof(int));
+
+    for (i = 0; i < count; i++) {
+        const char *match = PREF_MATCH(m, i);
+
+        if (used && !used(i))
+            continue;
+
+        /* Probe until the same string or a free slot; keep the first rule */
+        for (h = winPrefHash(match) & m->exactMask;
+             m->exact[h] >= 0 && strcmp(PREF_MATCH(m, m->exact[h]), match);
+             h = (h + 1) & m->exactMask)
+            ;
+        if (m->exact[h] < 0)
+            m->exact[h] = i;
+
+        if (!*match) {
+            if (m->anyRule < 0)
+                m->anyRule = i;
+        }
+        else
+            m->substrStart[(unsigned char) *match + 1]++;
+    }
+
+    for (c = 0; c < 256; c++)
+        m->substrStart[c + 1] += m->substrStart[c];
+    {
+        int fill[256];
+
+        memcpy(fill, m->substrStart, sizeof(fill));
+        for (i = 0; i < count; i++) {
+            const char *match = PREF_MATCH(m, i);
+
+            if ((!used || used(i)) && *match)
+                m->substr[fill[(unsigned char) *match]++] = i;
+        }
+    }
+}
+
+static int
+winPrefMatcherExact(const winPrefMatcher *m, const char *s)
+{
+    unsigned int h;
+
+    for (h = winPrefHash(s) & m->exactMask; m->exact[h] >= 0;
+         h = (h + 1) & m->exactMask)
+        if (!strcmp(PREF_MATCH(m, m->exact[h]), s))
+            return m->exact[h];
+    return -1;
+}
+
+/*
+ * Return the first rule whose match equals @res_name or @res_class, or
+ * occurs in @wmName, or -1 if none does.
+ */
+static int
+winPrefMatcherFind(const winPrefMatcher *m, const char *res_name,
+                   const char *res_class, const char *wmName)
+{
+    int best = INT_MAX;
+    int i, k;
+    const char *p;
+
+    if (!m->exact)
+        return -1;
+
+    if (res_name && (i = winPrefMatcherExact(m, res_name)) >= 0)
+        best = i;
+    if (res_class && (i = winPrefMatcherExact(m, res_class)) >= 0 && i < best)
+        best = i;
+
+    if (wmName) {
+        if (m->anyRule >= 0 && m->anyRule < best)
+            best = m->anyRule;
+
+        for (p = wmName; *p; p++) {
+            int c = (unsigned char) *p;
+
+            /* Rules are in order, so stop at the first that can't win */
+            for (k = m->substrStart[c];
+                 k < m->substrStart[c + 1] && m->substr[k] < best; k++) {
+                const char *match = PREF_MATCH(m, m->substr[k]);
+                const char *q = p;
+
+                while (*match && *match == *q) {
+                    match++;
+                    q++;
+                }
+                if (!*match) {
+                    best = m->substr[k];
+                    break;
+                }
+            }
+        }
+    }
+
+    return best == INT_MAX ? -1 : best;
+}
+
 /*
  * Creates or appends a menu from a MENUPARSED structure
  */
@@ -619,21 +779,18 @@ winOverrideIcon(char *res_name, char *res_class, char *wmName)
     int i;
     HICON hicon;
 
-    for (i = 0; i < pref.iconItems; i++) {
-        if ((res_name && !strcmp(pref.icon[i].match, res_name)) ||
-            (res_class && !strcmp(pref.icon[i].match, res_class)) ||
-            (wmName && strstr(wmName, pref.icon[i].match))) {
-            if (pref.icon[i].hicon)
-                return pref.icon[i].hicon;
+    i = winPrefMatcherFind(&g_iconMatcher, res_name, res_class, wmName);
+    if (i >= 0) {
+        if (pref.icon[i].hicon)
+            return pref.icon[i].hicon;
 
-            hicon = LoadImageComma(pref.icon[i].iconFile, pref.iconDirectory, 0, 0, LR_DEFAULTSIZE);
-            if (hicon == NULL)
-                ErrorF("winOverrideIcon: LoadImageComma(%s) failed\n",
-                       pref.icon[i].iconFile);
+        hicon = LoadImageComma(pref.icon[i].iconFile, pref.iconDirectory, 0, 0, LR_DEFAULTSIZE);
+        if (hicon == NULL)
+            ErrorF("winOverrideIcon: LoadImageComma(%s) failed\n",
+                   pref.icon[i].iconFile);
 
-            pref.icon[i].hicon = hicon;
-            return hicon;
-        }
+        pref.icon[i].hicon = hicon;
+        return hicon;
     }
 
     /* Didn't find the icon, fail gracefully */
@@ -701,6 +858,38 @@ winPrefsLoadPreferences(const char *path)
     return TRUE;
 }
 
+/*
+ * Export a Gallium HUD setting to the GL driver, and to the clients
+ * started from the menus.
+ */
+static void
+winSetGLHudEnv(const char *name, const char *value)
+{
+    char *env;
+
+    if (!value || !*value)
+        return;
+
+    /* putenv doesn't copy the argument */
+    env = malloc(strlen(name) + strlen(value) + 2);
+    if (!env)
+        return;
+    sprintf(env, "%s=%s", name, value);
+    putenv(env);
+}
+
+static Bool
+winStyleRuleUsed(int i)
+{
+    return pref.style[i].type != 0;
+}
+
+static Bool
+winTaskbarRuleUsed(int i)
+{
+    return pref.taskbar[i].type != 0;
+}
+
 /*
  * Try and open ~/.XWinrc and system.XWinrc
  * Load it into prefs structure for use by other functions
@@ -757,6 +946,11 @@ LoadPreferences(void)
     snprintf(szEnvDisplay, 512, "DISPLAY=%s", szDisplay);
     putenv (szEnvDisplay);
 
+    /* -glhud and -glhudlog override the preferences file */
+    winSetGLHudEnv("GALLIUM_HUD", g_pszGLHud ? g_pszGLHud : pref.glHud);
+    winSetGLHudEnv("GALLIUM_HUD_CSV",
+                   g_pszGLHudLog ? g_pszGLHudLog : pref.glHudLog);
+
     /* Replace any "%display%" in menu commands with display string */
     for (i = 0; i < pref.menuItems; i++) {
         for (j = 0; j < pref.menu[i].menuItems; j++) {
@@ -786,6 +980,13 @@ LoadPreferences(void)
         }                       /* for all menuitems */
     }                           /* for all menus */
 
+    /* Index the window matching sections */
+    winPrefMatcherBuild(&g_iconMatcher, pref.icon, sizeof(ICONITEM),
+                        pref.iconItems, NULL);
+    winPrefMatcherBuild(&g_styleMatcher, pref.style, sizeof(STYLEITEM),
+                        pref.styleItems, winStyleRuleUsed);
+    winPrefMatcherBuild(&g_taskbarMatcher, pref.taskbar, sizeof(TASKBARITEM),
+                        pref.taskbarItems, winTaskbarRuleUsed);
 }
 
 /*
@@ -797,14 +998,10 @@ winOverrideStyle(char *res_name, char *res_class, char *wmName)
 {
     int i;
 
-    for (i = 0; i < pref.styleItems; i++) {
-        if ((res_name && !strcmp(pref.style[i].match, res_name)) ||
-            (res_class && !strcmp(pref.style[i].match, res_class)) ||
-            (wmName && strstr(wmName, pref.style[i].match))) {
-            if (pref.style[i].type)
-                return pref.style[i].type;
-        }
-    }
+    /* Rules without a type aren't in the index */
+    i = winPrefMatcherFind(&g_styleMatcher, res_name, res_class, wmName);
+    if (i >= 0)
+        return pref.style[i].type;
 
     /* Didn't find the style, fail gracefully */
     return STYLE_NONE;
@@ -819,13 +1016,9 @@ winOverrideTaskbar(char *res_name, char *res_class, char *wmName)
 {
     int i;
 
-    for (i=0; i<pref.taskbarItems; i++) {
-        if ((res_name && !strcmp(pref.taskbar[i].match, res_name)) ||
-            (res_class && !strcmp(pref.taskbar[i].match, res_class)) ||
-            (wmName && strstr(wmName, pref.taskbar[i].match))) {
-            if (pref.taskbar[i].type) return pref.taskbar[i].type;
-        }
-    }
+    i = winPrefMatcherFind(&g_taskbarMatcher, res_name, res_class, wmName);
+    if (i >= 0)
+        return pref.taskbar[i].type;
 
     /* Didn't find a taskbar type */
     return TASKBAR_NONE;
@@ -159,6 +159,10 @@ typedef struct WINPREFS {
     /* No tray icon flag */
     Bool fNoTrayIcon;
 
+    /* Gallium HUD graphs and CSV log for the GL driver */
+    char glHud[PARAM_MAX + 1];
+    char glHudLog[PATH_MAX + 1];
+
 } WINPREFS;
 
 /* The global pref settings structure loaded by the winprefyacc.y parser */
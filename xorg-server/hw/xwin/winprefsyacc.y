@@ -63,6 +63,8 @@ static void SetDefaultIcon (char *fname);
 static void SetRootMenu (char *menu);
 static void SetDefaultSysMenu (char *menu, int pos);
 static void SetTrayIcon (char *fname);
+static void SetGLHud (char *graphs);
+static void SetGLHudLog (char *fname);
 
 static void OpenMenu(char *menuname);
 static void AddMenuLine(const char *name, MENUCOMMANDTYPE cmd, const char *param);
@@ -134,6 +136,8 @@ extern int yylex(void);
 %token TRAYICON
 %token FORCEEXIT
 %token SILENTEXIT
+%token GLHUD
+%token GLHUDLOG
 
 %token <sVal> STRING
 %type <uVal>  group1
@@ -170,6 +174,8 @@ command:	defaulticon
 	| trayicon
 	| forceexit
 	| silentexit
+	| glhud
+	| glhudlog
 	;
 
 trayicon:	TRAYICON STRING NEWLINE { SetTrayIcon($2); free($2); }
@@ -273,6 +279,12 @@ forceexit:	FORCEEXIT NEWLINE { pref.fForceExit = TRUE; }
 silentexit:	SILENTEXIT NEWLINE { pref.fSilentExit = TRUE; }
 	;
 
+glhud:	GLHUD STRING NEWLINE { SetGLHud($2); free($2); }
+	;
+
+glhudlog:	GLHUDLOG STRING NEWLINE { SetGLHudLog($2); free($2); }
+	;
+
 debug: 	DEBUGOUTPUT STRING NEWLINE { winDebug("LoadPreferences: %s\n", $2); free($2); }
 	;
 
@@ -310,6 +322,20 @@ SetTrayIcon (char *fname)
   pref.trayIconName[NAME_MAX] = 0;
 }
 
+static void
+SetGLHud (char *graphs)
+{
+  strncpy (pref.glHud, graphs, PARAM_MAX);
+  pref.glHud[PARAM_MAX] = 0;
+}
+
+static void
+SetGLHudLog (char *fname)
+{
+  strncpy (pref.glHudLog, fname, PATH_MAX);
+  pref.glHudLog[PATH_MAX] = 0;
+}
+
 static void
 SetRootMenu (char *menuname)
 {
@@ -0,0 +1,243 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+/*
+ * Present timing for XWin taken from the desktop compositor.
+ *
+ * Without a driver, Present falls back to a timer at a guessed 60Hz that
+ * has nothing to do with the monitor, so frames land at arbitrary points
+ * of the real refresh.  DWM knows when the last vblank happened, how many
+ * there have been and how far apart they are, so UST/MSC are reported from
+ * that and vblank events are scheduled for the predicted time of the
+ * target refresh.  If DWM has no timing to give at startup, the screen is
+ * left to Present's own fake vblanks as before.
+ *
+ * Everything here runs on the server thread; the timers only fire from
+ * the main loop.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "randrstr.h"
+#include "present.h"
+#include "list.h"
+#include <dwmapi.h>
+
+#ifdef PRESENT
+
+typedef struct _winPresentVblank {
+    struct xorg_list list;
+    uint64_t event_id;
+    uint64_t target_msc;
+    OsTimerPtr timer;
+} winPresentVblankRec, *winPresentVblankPtr;
+
+static struct xorg_list winPresentVblankQueue = {
+    &winPresentVblankQueue, &winPresentVblankQueue
+};
+
+/* The last timing DWM gave us, to extrapolate from if it stops */
+static uint64_t winPresentLastUst, winPresentLastMsc;
+static uint64_t winPresentInterval = 1000000 / 60;
+
+/*
+ * Read the time of the last vblank, its number and the refresh interval,
+ * with the time converted from the performance counter to the server's
+ * microsecond clock.
+ */
+static Bool
+winPresentGetTiming(uint64_t *ust, uint64_t *msc, uint64_t *interval)
+{
+    DWM_TIMING_INFO info;
+    LARGE_INTEGER freq, now;
+    int64_t since;
+
+    memset(&info, 0, sizeof(info));
+    info.cbSize = sizeof(info);
+    if (FAILED(DwmGetCompositionTimingInfo(NULL, &info)) ||
+        !info.qpcRefreshPeriod ||
+        !QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&now))
+        return FALSE;
+
+    since = (int64_t) (now.QuadPart - info.qpcVBlank) * 1000000 / freq.QuadPart;
+    *ust = GetTimeInMicros() - since;
+    *msc = info.cRefresh;
+    *interval = info.qpcRefreshPeriod * 1000000 / freq.QuadPart;
+    if (!*interval)
+        return FALSE;
+    return TRUE;
+}
+
+static void
+winPresentCurrent(uint64_t *ust, uint64_t *msc)
+{
+    uint64_t interval;
+
+    if (winPresentGetTiming(ust, msc, &interval)) {
+        winPresentLastUst = *ust;
+        winPresentLastMsc = *msc;
+        winPresentInterval = interval;
+        return;
+    }
+
+    /* Keep counting at the last known rate */
+    *msc = winPresentLastMsc +
+        (GetTimeInMicros() - winPresentLastUst) / winPresentInterval;
+    *ust = winPresentLastUst +
+        (*msc - winPresentLastMsc) * winPresentInterval;
+}
+
+static RRCrtcPtr
+winPresentGetCrtc(WindowPtr window)
+{
+    rrScrPrivPtr pScrPriv = rrGetScrPriv(window->drawable.pScreen);
+
+    if (!pScrPriv || !pScrPriv->numCrtcs)
+        return NULL;
+    return pScrPriv->crtcs[0];
+}
+
+static int
+winPresentGetUstMsc(RRCrtcPtr crtc, uint64_t *ust, uint64_t *msc)
+{
+    winPresentCurrent(ust, msc);
+    return Success;
+}
+
+/*
+ * Milliseconds until the given refresh, rounded up so the timer doesn't
+ * fire just before it.
+ */
+static CARD32
+winPresentDelay(uint64_t ust, uint64_t msc, uint64_t target_msc)
+{
+    uint64_t when = ust + (target_msc - msc) * winPresentInterval;
+    uint64_t now = GetTimeInMicros();
+
+    if (when <= now)
+        return 1;
+    return (CARD32) ((when - now + 999) / 1000);
+}
+
+static CARD32
+winPresentTimer(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    winPresentVblankPtr vblank = arg;
+    uint64_t ust, msc;
+
+    winPresentCurrent(&ust, &msc);
+    if (msc < vblank->target_msc)
+        return winPresentDelay(ust, msc, vblank->target_msc);
+
+    xorg_list_del(&vblank->list);
+    present_event_notify(vblank->event_id, ust, msc);
+    TimerFree(vblank->timer);
+    free(vblank);
+    return 0;
+}
+
+static Bool
+winPresentQueueVblank(RRCrtcPtr crtc, uint64_t event_id, uint64_t msc)
+{
+    winPresentVblankPtr vblank;
+    uint64_t cur_ust, cur_msc;
+
+    winPresentCurrent(&cur_ust, &cur_msc);
+    if (msc <= cur_msc) {
+        present_event_notify(event_id, cur_ust, cur_msc);
+        return TRUE;
+    }
+
+    vblank = calloc(1, sizeof(winPresentVblankRec));
+    if (!vblank)
+        return FALSE;
+
+    vblank->event_id = event_id;
+    vblank->target_msc = msc;
+    vblank->timer = TimerSet(NULL, 0, winPresentDelay(cur_ust, cur_msc, msc),
+                             winPresentTimer, vblank);
+    if (!vblank->timer) {
+        free(vblank);
+        return FALSE;
+    }
+    xorg_list_add(&vblank->list, &winPresentVblankQueue);
+    return TRUE;
+}
+
+static void
+winPresentAbortVblank(RRCrtcPtr crtc, uint64_t event_id, uint64_t msc)
+{
+    winPresentVblankPtr vblank, tmp;
+
+    xorg_list_for_each_entry_safe(vblank, tmp, &winPresentVblankQueue, list) {
+        if (vblank->event_id == event_id) {
+            TimerFree(vblank->timer);
+            xorg_list_del(&vblank->list);
+            free(vblank);
+            break;
+        }
+    }
+}
+
+static present_screen_info_rec winPresentScreenInfo = {
+    .version = PRESENT_SCREEN_INFO_VERSION,
+
+    .get_crtc = winPresentGetCrtc,
+    .get_ust_msc = winPresentGetUstMsc,
+    .queue_vblank = winPresentQueueVblank,
+    .abort_vblank = winPresentAbortVblank,
+    .flush = NULL,
+
+    .capabilities = PresentCapabilityNone,
+    .check_flip = NULL,
+    .flip = NULL,
+    .unflip = NULL,
+};
+
+Bool
+winPresentScreenInit(ScreenPtr pScreen)
+{
+    uint64_t ust, msc, interval;
+
+    /* Without composition timing, leave Present to its fake vblanks */
+    if (!winPresentGetTiming(&ust, &msc, &interval)) {
+        winDebug("winPresentScreenInit - no DWM timing, using fake vblanks\n");
+        return TRUE;
+    }
+    winPresentLastUst = ust;
+    winPresentLastMsc = msc;
+    winPresentInterval = interval;
+
+    winDebug("winPresentScreenInit - refresh interval %llu us\n",
+             (unsigned long long) interval);
+    return present_screen_init(pScreen, &winPresentScreenInfo);
+}
+
+#endif /* PRESENT */
@@ -41,6 +41,8 @@ from The Open Group.
 #include "winmsg.h"
 #include "winmonitors.h"
 #include "winprefs.h"
+#include "fbpict.h"
+#include "compositeext.h"
 
 #include "winclipboard/winclipboard.h"
 extern Bool g_fClipboardPrimary;
@@ -121,6 +123,7 @@ winInitializeScreenDefaults(void)
     defaultScreenInfo.fUserGavePosition = FALSE;
     defaultScreenInfo.dwBPP = WIN_DEFAULT_BPP;
     defaultScreenInfo.dwClipUpdatesNBoxes = WIN_DEFAULT_CLIP_UPDATES_NBOXES;
+    defaultScreenInfo.fSkipUnchanged = FALSE;
 #ifdef XWIN_EMULATEPSEUDO
     defaultScreenInfo.fEmulatePseudo = WIN_DEFAULT_EMULATE_PSEUDO;
 #endif
@@ -853,6 +856,81 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 2;
     }
 
+    /*
+     * Look for the '-skipunchanged' argument
+     */
+    if (IS_OPTION("-skipunchanged")) {
+        screenInfoPtr->fSkipUnchanged = TRUE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
+
+    /*
+     * Look for the '-compositethreads count' argument
+     */
+    if (IS_OPTION("-compositethreads")) {
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc || atoi(argv[i]) < 1) {
+            UseMsg();
+            return 0;
+        }
+
+        fbCompositeThreads = atoi(argv[i]);
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
+    /*
+     * Look for the '-compositethreshold pixels' argument
+     */
+    if (IS_OPTION("-compositethreshold")) {
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc || atoi(argv[i]) < 0) {
+            UseMsg();
+            return 0;
+        }
+
+        fbCompositeThreshold = atoi(argv[i]);
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
+    /*
+     * Look for the '-threadpool count' argument
+     */
+    if (IS_OPTION("-threadpool")) {
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc || atoi(argv[i]) < 0) {
+            UseMsg();
+            return 0;
+        }
+
+        threadPoolSize = atoi(argv[i]);
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
+    /*
+     * Look for the '-toplevelbs megabytes' argument
+     */
+    if (IS_OPTION("-toplevelbs")) {
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc || atoi(argv[i]) < 0 ||
+            (unsigned long) atoi(argv[i]) > ULONG_MAX >> 20) {
+            UseMsg();
+            return 0;
+        }
+
+        CompositeTopLevelBackingStore = (unsigned long) atoi(argv[i]) << 20;
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
 #ifdef XWIN_EMULATEPSEUDO
     /*
      * Look for the '-emulatepseudo' argument
@@ -1087,6 +1165,11 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 1;
     }
 
+    if (IS_OPTION("-mousehistory")) {
+        g_fMouseHistory = TRUE;
+        return 1;
+    }
+
     if (IS_OPTION("-wgl")) {
         g_fNativeGl = TRUE;
         return 1;
@@ -1101,6 +1184,30 @@ ddxProcessArgument(int argc, char *argv[], int i)
         g_fswrastwgl = TRUE;
         return 1;
     }
+
+    if (IS_OPTION("-glhud")) {
+        CHECK_ARGS(1);
+        g_pszGLHud = argv[++i];
+        return 2;
+    }
+
+    if (IS_OPTION("-glhudlog")) {
+        CHECK_ARGS(1);
+        g_pszGLHudLog = argv[++i];
+        return 2;
+    }
+
+    if (IS_OPTION("-shadowlog")) {
+        CHECK_ARGS(1);
+        g_pszShadowLog = argv[++i];
+        return 2;
+    }
+
+    if (IS_OPTION("-latencyslo")) {
+        CHECK_ARGS(1);
+        g_iLatencySLO = atoi(argv[++i]);
+        return 2;
+    }
     else if (IS_OPTION("-parentprocessid"))
     {
         DWORD dwProcessId;
@@ -1114,6 +1221,12 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 2;
     }
 
+    if (IS_OPTION("-readyevent")) {
+        CHECK_ARGS(1);
+        g_hReadyEvent = (HANDLE) (uintptr_t) strtoul(argv[++i], NULL, 0);
+        return 2;
+    }
+
     if (IS_OPTION("-hostintitle")) {
         g_fHostInTitle = TRUE;
         return 1;
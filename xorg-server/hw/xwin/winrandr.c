@@ -97,14 +97,37 @@ winDoRandRScreenSetSize(ScreenPtr pScreen,
     winScreenPriv(pScreen);
     winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
     WindowPtr pRoot = pScreen->root;
+    int iBytesPP = BitsPerPixel(pScreen->rootDepth) / 8;
+    int iKeepWidth = min(pScreen->width, width);
+    int iKeepHeight = min(pScreen->height, height);
+    int iKeepPitch = iKeepWidth * iBytesPP;
+    char *pKeep = NULL;
+    int y;
 
     /* Ignore changes which do nothing */
     if ((pScreen->width == width) && (pScreen->height == height) &&
         (pScreen->mmWidth == mmWidth) && (pScreen->mmHeight == mmHeight))
         return;
 
-    // Prevent screen updates while we change things around
-    SetRootClip(pScreen, ROOT_CLIP_NONE);
+    /*
+     * Save the part of the framebuffer that is still on screen after the
+     * change, so it can be put back into the new one instead of repainting
+     * everything.  If that isn't possible, fall back to a full repaint.
+     */
+    if (pScreenInfo->pfb && iKeepWidth > 0 && iKeepHeight > 0)
+        pKeep = malloc(iKeepPitch * iKeepHeight);
+    if (pKeep) {
+        int iOldPitch = PixmapBytePad(pScreenInfo->dwStride,
+                                      pScreenInfo->dwBPP);
+
+        for (y = 0; y < iKeepHeight; y++)
+            memcpy(pKeep + y * iKeepPitch,
+                   pScreenInfo->pfb + y * iOldPitch, iKeepPitch);
+    }
+    else {
+        // Prevent screen updates while we change things around
+        SetRootClip(pScreen, ROOT_CLIP_NONE);
+    }
 
     /* Update the screen size as requested */
     pScreenInfo->dwWidth = width;
@@ -129,11 +152,31 @@ winDoRandRScreenSetSize(ScreenPtr pScreen,
     //pScreen->ResizeWindow(pRoot, 0, 0, width, height, NULL);
     // does this emit a ConfigureNotify??
 
-    // Restore the ability to update screen, now with new dimensions
-    SetRootClip(pScreen, ROOT_CLIP_FULL);
+    if (pKeep) {
+        int iNewPitch = PixmapBytePad(pScreenInfo->dwStride,
+                                      pScreenInfo->dwBPP);
+
+        if (pScreenInfo->pfb) {
+            for (y = 0; y < iKeepHeight; y++)
+                memcpy(pScreenInfo->pfb + y * iNewPitch,
+                       pKeep + y * iKeepPitch, iKeepPitch);
+        }
+        free(pKeep);
 
-    // and arrange for it to be repainted
-    pScreen->PaintWindow(pRoot, &pRoot->borderClip, PW_BACKGROUND);
+        /*
+         * The root clip is still the old screen, so validating it against
+         * the new size only exposes (and paints the background of) what
+         * has just come into view.
+         */
+        SetRootClip(pScreen, ROOT_CLIP_FULL);
+    }
+    else {
+        // Restore the ability to update screen, now with new dimensions
+        SetRootClip(pScreen, ROOT_CLIP_FULL);
+
+        // and arrange for it to be repainted
+        pScreen->PaintWindow(pRoot, &pRoot->borderClip, PW_BACKGROUND);
+    }
 
     // Set mode to current display size
     pRRScrPriv = rrGetScrPriv(pScreen);
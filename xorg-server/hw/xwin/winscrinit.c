@@ -37,6 +37,8 @@
 #endif
 #include "win.h"
 #include "winmsg.h"
+#include "wintrace.h"
+#include "opaque.h"
 
 /*
  * Determine what type of screen we are initializing
@@ -173,13 +175,6 @@ winScreenInit(ScreenPtr pScreen, int argc, char **argv)
         return FALSE;
     }
 
-    if (!g_fSoftwareCursor)
-        winInitCursor(pScreen);
-#ifdef WINDBG
-    else
-        winDebug("winScreenInit - Using software cursor\n");  
-#endif
-
     if (!noPanoramiXExtension) {
         /*
            Note the screen origin in a normalized coordinate space where (0,0) is at the top left
@@ -198,6 +193,159 @@ winScreenInit(ScreenPtr pScreen, int argc, char **argv)
     return TRUE;
 }
 
+static FILE *s_pShadowLog;
+static LARGE_INTEGER s_liPerformanceFrequency;
+
+static void
+winShadowLogDamage(DamagePtr pDamage, RegionPtr pRegion, void *closure)
+{
+    ScreenPtr pScreen = closure;
+    winScreenPriv(pScreen);
+
+    /* Only called when the screen goes from clean to damaged */
+    QueryPerformanceCounter(&pScreenPriv->liShadowLogDamaged);
+}
+
+static unsigned long long
+winMicroseconds(LARGE_INTEGER liFrom, LARGE_INTEGER liTo)
+{
+    return (liTo.QuadPart - liFrom.QuadPart) * 1000000 /
+        s_liPerformanceFrequency.QuadPart;
+}
+
+static void
+winUpdateStatsAdd(winUpdateStatsRec *pStats, int nBoxes,
+                  unsigned long long ullPixels, unsigned long long us)
+{
+    int i;
+
+    for (i = 0; i < WIN_UPDATE_BUCKETS - 1; i++)
+        if (us < (1ULL << i))
+            break;
+
+    pStats->updates++;
+    if (nBoxes > 1)
+        pStats->multiBoxUpdates++;
+    pStats->boxes += nBoxes;
+    pStats->pixels += ullPixels;
+    pStats->time += us;
+    if (us > pStats->max)
+        pStats->max = us;
+    pStats->hist[i]++;
+}
+
+/*
+ * Every shadow update goes through here, to be counted in the screen's
+ * statistics and, with -shadowlog, logged along with how long the oldest
+ * drawing it shows has waited for it.  Everything happens on the server
+ * thread, so plain counters will do.  The boxes and pixels counted are
+ * what the engine left in the damage, so tiles that GDI found unchanged
+ * are not counted.
+ */
+static void
+winShadowUpdate(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    RegionPtr pRegion = DamageRegion(pBuf->pDamage);
+    BoxPtr pBox;
+    int i, nBoxes;
+    unsigned long long ullPixels = 0, us;
+    LARGE_INTEGER liStart, liEnd;
+
+    WinTraceStart("ShadowUpdate", TraceLoggingInt32(pScreen->myNum, "Screen"));
+    QueryPerformanceCounter(&liStart);
+    pScreenPriv->pwinShadowUpdate(pScreen, pBuf);
+    QueryPerformanceCounter(&liEnd);
+
+    pBox = RegionRects(pRegion);
+    nBoxes = RegionNumRects(pRegion);
+    for (i = 0; i < nBoxes; i++)
+        ullPixels += (unsigned long long) (pBox[i].x2 - pBox[i].x1) *
+            (pBox[i].y2 - pBox[i].y1);
+
+    WinTraceStop("ShadowUpdate", TraceLoggingInt32(pScreen->myNum, "Screen"),
+                 TraceLoggingInt32(nBoxes, "Boxes"),
+                 TraceLoggingUInt64(ullPixels, "Pixels"));
+
+    us = winMicroseconds(liStart, liEnd);
+    winUpdateStatsAdd(&pScreenPriv->updateStats, nBoxes, ullPixels, us);
+    winLatencyPresent(pScreen);
+
+    if (!pScreenPriv->pShadowLogDamage)
+        return;
+
+    if (!pScreenPriv->liShadowLogDamaged.QuadPart)
+        pScreenPriv->liShadowLogDamaged = liStart;
+    fprintf(s_pShadowLog, "%d %u %d %llu %llu %llu\n",
+            pScreen->myNum, (unsigned) GetTimeInMillis(), nBoxes, ullPixels,
+            winMicroseconds(pScreenPriv->liShadowLogDamaged, liEnd), us);
+    fflush(s_pShadowLog);
+
+    pScreenPriv->liShadowLogDamaged.QuadPart = 0;
+    DamageEmpty(pScreenPriv->pShadowLogDamage);
+}
+
+/*
+ * Log each screen's shadow update statistics and start counting afresh.
+ */
+void
+winEngineStatsReport(void)
+{
+    int i, j;
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        ScreenPtr pScreen = screenInfo.screens[i];
+        winScreenPriv(pScreen);
+        winUpdateStatsRec *pStats = &pScreenPriv->updateStats;
+        unsigned long long want = (pStats->updates * 99ULL + 99) / 100;
+        unsigned long long seen = 0;
+        unsigned long long p99 = pStats->max;
+
+        if (!pStats->updates)
+            continue;
+
+        for (j = 0; j < WIN_UPDATE_BUCKETS - 1; j++) {
+            seen += pStats->hist[j];
+            if (seen >= want) {
+                p99 = min(1ULL << j, pStats->max);
+                break;
+            }
+        }
+
+        LogMessageVerb(X_INFO, 0, "engine: screen %d: %lu updates "
+                       "(%lu with more than one box), %llu boxes, "
+                       "%llu pixels, %llu us (avg %llu, p99 %llu, max %llu)\n",
+                       i, pStats->updates, pStats->multiBoxUpdates,
+                       pStats->boxes, pStats->pixels, pStats->time,
+                       pStats->time / pStats->updates, p99, pStats->max);
+        memset(pStats, 0, sizeof(*pStats));
+    }
+}
+
+static void
+winShadowLogStart(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    PixmapPtr pPixmap = pScreen->devPrivate;
+
+    if (!s_pShadowLog) {
+        s_pShadowLog = fopen(g_pszShadowLog, "a");
+        if (!s_pShadowLog) {
+            ErrorF("winShadowLogStart - cannot open %s\n", g_pszShadowLog);
+            return;
+        }
+    }
+
+    /* Destroyed along with the screen pixmap */
+    pScreenPriv->pShadowLogDamage =
+        DamageCreate(winShadowLogDamage, NULL, DamageReportNonEmpty, TRUE,
+                     pScreen, pScreen);
+    if (!pScreenPriv->pShadowLogDamage)
+        return;
+    DamageRegister(&pPixmap->drawable, pScreenPriv->pShadowLogDamage);
+    pScreenPriv->liShadowLogDamaged.QuadPart = 0;
+}
+
 static Bool
 winCreateScreenResources(ScreenPtr pScreen)
 {
@@ -206,10 +354,17 @@ winCreateScreenResources(ScreenPtr pScreen)
 
     result = pScreenPriv->pwinCreateScreenResources(pScreen);
 
+    if (!s_liPerformanceFrequency.QuadPart)
+        QueryPerformanceFrequency(&s_liPerformanceFrequency);
+    memset(&pScreenPriv->updateStats, 0, sizeof(pScreenPriv->updateStats));
+    pScreenPriv->pShadowLogDamage = NULL;
+    if (g_pszShadowLog)
+        winShadowLogStart(pScreen);
+
     /* Now the screen bitmap has been wrapped in a pixmap,
        add that to the Shadow framebuffer */
-    if (!shadowAdd(pScreen, pScreen->devPrivate,
-                   pScreenPriv->pwinShadowUpdate, NULL, 0, 0)) {
+    if (!shadowAdd(pScreen, pScreen->devPrivate, winShadowUpdate,
+                   NULL, 0, 0)) {
         ErrorF("winCreateScreenResources - shadowAdd () failed\n");
         return FALSE;
     }
@@ -327,11 +482,43 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
         ErrorF("winFinishScreenInitFB - winRandRInit () failed\n");
         return FALSE;
     }
+
+#ifdef PRESENT
+    /* Present timing from DWM, using the RandR CRTC */
+    if (!winPresentScreenInit(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winPresentScreenInit () failed\n");
+        return FALSE;
+    }
+#endif
+#endif
+
+#ifdef XSYNC
+    /* SYNC fences with Win32 events for local clients */
+    if (!winSyncScreenInit(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winSyncScreenInit () failed\n");
+        return FALSE;
+    }
+#endif
+
+#ifdef XWIN_XV
+    /* XVideo image adaptor */
+    if (!winInitVideo(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winInitVideo () failed\n");
+        return FALSE;
+    }
 #endif
 
     /* Setup the cursor routines */
-    winDebug("winFinishScreenInitFB - Calling miDCInitialize ()\n");
-    miDCInitialize(pScreen, &g_winPointerCursorFuncs);
+    if (g_fSoftwareCursor) {
+        LogMessage(X_CONFIG, "winFinishScreenInitFB - -swcursor: screen %d "
+                   "draws the cursor itself instead of using the Windows "
+                   "cursor\n", pScreen->myNum);
+        miDCInitialize(pScreen, &g_winPointerCursorFuncs);
+    }
+    else if (!winInitCursor(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winInitCursor () failed\n");
+        return FALSE;
+    }
 
     /* KDrive does winCreateDefColormap right after miDCInitialize */
     /* Create a default colormap */
@@ -343,7 +530,8 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
 
     /* Initialize the shadow framebuffer layer */
     if ((pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI
-         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL)) {
+         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL
+         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DXGI)) {
         winDebug("winFinishScreenInitFB - Calling shadowSetup ()\n");
         if (!shadowSetup(pScreen)) {
             ErrorF("winFinishScreenInitFB - shadowSetup () failed\n");
@@ -415,6 +603,16 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
         WRAP(SetShape);
         WRAP(ModifyPixmapHeader);
 
+        /*
+         * The root window is never shown, so unless a root background was
+         * asked for, leave it unpainted.  The parts of the shadow
+         * framebuffer no window covers, such as the gaps between monitors
+         * of different sizes, are then never touched and take no memory.
+         */
+        pScreen->canDoBGNoneRoot = TRUE;
+        if (!party_like_its_1989 && !whiteRoot)
+            bgNoneRoot = TRUE;
+
         /* Assign multi-window window procedures to be top level procedures */
         pScreen->CreateWindow = winCreateWindowMultiWindow;
         pScreen->DestroyWindow = winDestroyWindowMultiWindow;
@@ -433,6 +631,9 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
             pScreen->CreatePixmap = winCreatePixmapMultiwindow;
             pScreen->DestroyPixmap = winDestroyPixmapMultiwindow;
             pScreen->ModifyPixmapHeader = winModifyPixmapHeaderMultiwindow;
+            winInitPixmapBytesMultiwindow();
+            RegisterCacheTrim("XWin pixmap DIBs", 30,
+                              winTrimDIBCacheMultiwindow, pScreen);
         }
 
         /* Undefine the WRAP macro, as it is not needed elsewhere */
@@ -482,6 +683,7 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
             ErrorF("winFinishScreenInitFB - winInitWM () failed.\n");
             return FALSE;
         }
+        winStartupMark("window manager thread");
     }
 
     /* Tell the server that we are enabled */
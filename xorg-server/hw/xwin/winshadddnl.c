@@ -621,6 +621,9 @@ winShadowUpdateDDNL(ScreenPtr pScreen, shadowBufPtr pBuf)
      */
     if (pScreenInfo->dwClipUpdatesNBoxes == 0
         || dwBox < pScreenInfo->dwClipUpdatesNBoxes) {
+        /* Merge small boxes to cut down the number of blits */
+        dwBox = winCoalesceDamageBoxes(damage, &pBox);
+
         /* Loop through all boxes in the damaged region */
         while (dwBox--) {
             /* Assign damage box to source rectangle */
@@ -1060,14 +1063,15 @@ winStoreColorsShadowDDNL(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
     winCmapPriv(pColormap);
     ColormapPtr curpmap = pScreenPriv->pcmapInstalled;
     HRESULT ddrval = DD_OK;
+    int iFirst, iCount;
 
     /* Put the X colormap entries into the Windows logical palette */
+    winColormapRange(ndef, pdefs, &iFirst, &iCount);
     ddrval = IDirectDrawPalette_SetEntries(pCmapPriv->lpDDPalette,
                                            0,
-                                           pdefs[0].pixel,
-                                           ndef,
-                                           pCmapPriv->peColors
-                                           + pdefs[0].pixel);
+                                           iFirst,
+                                           iCount,
+                                           pCmapPriv->peColors + iFirst);
     if (FAILED(ddrval)) {
         ErrorF("winStoreColorsShadowDDNL - SetEntries () failed: %08x\n",
                (unsigned int) ddrval);
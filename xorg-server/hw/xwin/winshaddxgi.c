@@ -0,0 +1,750 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "winprefs.h"
+
+#ifndef COBJMACROS
+#define COBJMACROS
+#endif
+/* X11/Xmd.h defines BOOL as a CARD8, the DXGI structures need the Win32 one */
+#pragma push_macro("BOOL")
+#undef BOOL
+#define BOOL WINBOOL
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#pragma pop_macro("BOOL")
+
+/*
+ * The shadow surface is always 32 bpp BGRX, which is the only format
+ * a flip-model swap chain accepts for a GDI-less window.  DXGI converts
+ * to the display format while composing, so the Windows depth does not
+ * matter to us.
+ */
+#define WIN_DXGI_BPP		32
+#define WIN_DXGI_DEPTH		24
+#define WIN_DXGI_BUFFER_COUNT	2
+
+/*
+ * Local prototypes
+ */
+
+static Bool
+ winAllocateFBShadowDXGI(ScreenPtr pScreen);
+
+static void
+ winFreeFBShadowDXGI(ScreenPtr pScreen);
+
+static void
+ winShadowUpdateDXGI(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+static Bool
+ winCloseScreenShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winInitVisualsShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winAdjustVideoModeShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winBltExposedRegionsShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winActivateAppShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winRedrawScreenShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winRealizeInstalledPaletteShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winInstallColormapShadowDXGI(ColormapPtr pColormap);
+
+static Bool
+ winStoreColorsShadowDXGI(ColormapPtr pmap, int ndef, xColorItem * pdefs);
+
+static Bool
+ winCreateColormapShadowDXGI(ColormapPtr pColormap);
+
+static Bool
+ winDestroyColormapShadowDXGI(ColormapPtr pColormap);
+
+/*
+ * Release the swap chain and the D3D11 device, leaving the shadow
+ * framebuffer memory alone.
+ */
+
+static void
+winReleaseSwapChainShadowDXGI(winPrivScreenPtr pScreenPriv)
+{
+    if (pScreenPriv->pd3dBackBuffer) {
+        ID3D11Texture2D_Release(pScreenPriv->pd3dBackBuffer);
+        pScreenPriv->pd3dBackBuffer = NULL;
+    }
+
+    /*
+     * A flip-model swap chain keeps a reference on the HWND until all
+     * of its presents are retired; flush so that a new swap chain can
+     * be created on the same window right away (RandR resize).
+     */
+    if (pScreenPriv->pd3dContext) {
+        ID3D11DeviceContext_ClearState(pScreenPriv->pd3dContext);
+        ID3D11DeviceContext_Flush(pScreenPriv->pd3dContext);
+    }
+
+    if (pScreenPriv->pdxgiSwapChain) {
+        IDXGISwapChain1_Release(pScreenPriv->pdxgiSwapChain);
+        pScreenPriv->pdxgiSwapChain = NULL;
+    }
+
+    if (pScreenPriv->pd3dContext) {
+        ID3D11DeviceContext_Release(pScreenPriv->pd3dContext);
+        pScreenPriv->pd3dContext = NULL;
+    }
+
+    if (pScreenPriv->pd3dDevice) {
+        ID3D11Device_Release(pScreenPriv->pd3dDevice);
+        pScreenPriv->pd3dDevice = NULL;
+    }
+}
+
+/*
+ * Copy the given boxes of the shadow framebuffer into the current
+ * back buffer of the swap chain.
+ */
+
+static void
+winUploadBoxesShadowDXGI(ScreenPtr pScreen, BoxPtr pBox, int nBox)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    ID3D11Resource *pResource = (ID3D11Resource *) pScreenPriv->pd3dBackBuffer;
+    D3D11_BOX box;
+
+    box.front = 0;
+    box.back = 1;
+
+    while (nBox--) {
+        box.left = pBox->x1;
+        box.top = pBox->y1;
+        box.right = pBox->x2;
+        box.bottom = pBox->y2;
+
+        ID3D11DeviceContext_UpdateSubresource(pScreenPriv->pd3dContext,
+                                              pResource, 0, &box,
+                                              pScreenInfo->pfb
+                                              + pBox->y1 * pScreenInfo->dwPaddedWidth
+                                              + pBox->x1 * (WIN_DXGI_BPP / 8),
+                                              pScreenInfo->dwPaddedWidth, 0);
+        ++pBox;
+    }
+}
+
+/*
+ * Make the back buffer match the shadow framebuffer and present it.
+ *
+ * With WIN_DXGI_BUFFER_COUNT back buffers in a FLIP_SEQUENTIAL chain the
+ * buffer we are about to draw into last saw the shadow framebuffer one
+ * present ago, so it is missing both the new damage and whatever we
+ * uploaded into the other buffer for the previous present.  We upload
+ * the union of the two, but only report the new damage as dirty to DWM:
+ * the rest of the buffer is identical to what is already on screen.
+ *
+ * If pDamage is NULL the whole buffer is uploaded and presented.
+ */
+
+static void
+winPresentShadowDXGI(ScreenPtr pScreen, RegionPtr pDamage)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    DXGI_PRESENT_PARAMETERS params;
+    RegionRec rgnUpload;
+    BoxRec boxScreen;
+    HRESULT hr;
+
+    boxScreen.x1 = 0;
+    boxScreen.y1 = 0;
+    boxScreen.x2 = pScreenInfo->dwWidth;
+    boxScreen.y2 = pScreenInfo->dwHeight;
+
+    ZeroMemory(&params, sizeof(params));
+
+    if (pDamage == NULL) {
+        winUploadBoxesShadowDXGI(pScreen, &boxScreen, 1);
+
+        /* The other buffer has to catch up with everything as well */
+        RegionReset(&pScreenPriv->rgnDXGIStale, &boxScreen);
+    }
+    else {
+        DWORD dwBox = RegionNumRects(pDamage);
+        BoxPtr pBox = RegionRects(pDamage);
+        DWORD i;
+
+        RegionNull(&rgnUpload);
+        RegionUnion(&rgnUpload, pDamage, &pScreenPriv->rgnDXGIStale);
+        winUploadBoxesShadowDXGI(pScreen,
+                                 RegionRects(&rgnUpload),
+                                 RegionNumRects(&rgnUpload));
+        RegionUninit(&rgnUpload);
+
+        /* Remember what the other buffer is missing now */
+        RegionCopy(&pScreenPriv->rgnDXGIStale, pDamage);
+
+        /* Grow the dirty rectangle array, if needed */
+        if (dwBox > pScreenPriv->dwDXGIDirtyMax) {
+            RECT *prc = realloc(pScreenPriv->prcDXGIDirty,
+                                dwBox * sizeof(RECT));
+
+            if (prc != NULL) {
+                pScreenPriv->prcDXGIDirty = prc;
+                pScreenPriv->dwDXGIDirtyMax = dwBox;
+            }
+        }
+
+        /* Fall back to presenting everything if we are out of memory */
+        if (dwBox <= pScreenPriv->dwDXGIDirtyMax) {
+            for (i = 0; i < dwBox; ++i, ++pBox) {
+                SetRect(&pScreenPriv->prcDXGIDirty[i],
+                        pBox->x1, pBox->y1, pBox->x2, pBox->y2);
+            }
+
+            params.DirtyRectsCount = dwBox;
+            params.pDirtyRects = pScreenPriv->prcDXGIDirty;
+        }
+    }
+
+    hr = IDXGISwapChain1_Present1(pScreenPriv->pdxgiSwapChain, 0, 0, &params);
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
+        ErrorF("winPresentShadowDXGI - Device lost: %08x, recreating "
+               "swap chain\n", (unsigned int) hr);
+
+        /* Keep the framebuffer, only the presentation objects are gone */
+        winReleaseSwapChainShadowDXGI(pScreenPriv);
+        winAllocateFBShadowDXGI(pScreen);
+    }
+    else if (FAILED(hr)) {
+        ErrorF("winPresentShadowDXGI - Present1 failed: %08x\n",
+               (unsigned int) hr);
+    }
+}
+
+/*
+ * Create the D3D11 device and a flip-model swap chain for our display
+ * window, and allocate the shadow framebuffer if we do not have one yet.
+ */
+
+static Bool
+winAllocateFBShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    PFN_D3D11_CREATE_DEVICE pfnD3D11CreateDevice
+        = (PFN_D3D11_CREATE_DEVICE) g_fpD3D11CreateDevice;
+    DXGI_SWAP_CHAIN_DESC1 scd;
+    IDXGIDevice *pdxgiDevice = NULL;
+    IDXGIAdapter *pdxgiAdapter = NULL;
+    IDXGIFactory2 *pdxgiFactory = NULL;
+    HRESULT hr;
+    Bool fReturn = FALSE;
+
+    winDebug("winAllocateFBShadowDXGI - w %u h %u\n",
+             (unsigned int)pScreenInfo->dwWidth,
+             (unsigned int)pScreenInfo->dwHeight);
+
+    if (pfnD3D11CreateDevice == NULL) {
+        ErrorF("winAllocateFBShadowDXGI - D3D11CreateDevice not available\n");
+        return FALSE;
+    }
+
+    /* Set the padded screen width */
+    pScreenInfo->dwPaddedWidth = PixmapBytePad(pScreenInfo->dwWidth,
+                                               pScreenInfo->dwBPP);
+
+    /* Allocate the shadow framebuffer, unless we are only recreating the
+       presentation objects */
+    if (pScreenInfo->pfb == NULL) {
+        pScreenInfo->pfb = calloc(pScreenInfo->dwHeight,
+                                  pScreenInfo->dwPaddedWidth);
+        if (pScreenInfo->pfb == NULL) {
+            ErrorF("winAllocateFBShadowDXGI - Could not allocate bits\n");
+            return FALSE;
+        }
+    }
+
+    /* Set screeninfo stride */
+    pScreenInfo->dwStride = (pScreenInfo->dwPaddedWidth * 8)
+        / pScreenInfo->dwBPP;
+
+    /* Create a hardware device, BGRA support is needed for the back buffer */
+    hr = pfnD3D11CreateDevice(NULL,
+                              D3D_DRIVER_TYPE_HARDWARE,
+                              NULL,
+                              D3D11_CREATE_DEVICE_BGRA_SUPPORT
+                              | D3D11_CREATE_DEVICE_SINGLETHREADED,
+                              NULL, 0,
+                              D3D11_SDK_VERSION,
+                              &pScreenPriv->pd3dDevice,
+                              NULL, &pScreenPriv->pd3dContext);
+    if (FAILED(hr)) {
+        ErrorF("winAllocateFBShadowDXGI - D3D11CreateDevice failed: %08x\n",
+               (unsigned int) hr);
+        goto winAllocateFBShadowDXGI_Exit;
+    }
+
+    /* Walk up to the factory that created our adapter */
+    hr = ID3D11Device_QueryInterface(pScreenPriv->pd3dDevice,
+                                     &IID_IDXGIDevice,
+                                     (void **) &pdxgiDevice);
+    if (SUCCEEDED(hr))
+        hr = IDXGIDevice_GetAdapter(pdxgiDevice, &pdxgiAdapter);
+    if (SUCCEEDED(hr))
+        hr = IDXGIAdapter_GetParent(pdxgiAdapter,
+                                    &IID_IDXGIFactory2,
+                                    (void **) &pdxgiFactory);
+    if (FAILED(hr)) {
+        ErrorF("winAllocateFBShadowDXGI - Could not get IDXGIFactory2: "
+               "%08x\n", (unsigned int) hr);
+        goto winAllocateFBShadowDXGI_Exit;
+    }
+
+    /* Describe the swap chain */
+    ZeroMemory(&scd, sizeof(scd));
+    scd.Width = pScreenInfo->dwWidth;
+    scd.Height = pScreenInfo->dwHeight;
+    scd.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    scd.SampleDesc.Count = 1;
+    scd.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    scd.BufferCount = WIN_DXGI_BUFFER_COUNT;
+    scd.Scaling = DXGI_SCALING_NONE;
+    scd.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    scd.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+
+    hr = IDXGIFactory2_CreateSwapChainForHwnd(pdxgiFactory,
+                                              (IUnknown *) pScreenPriv->pd3dDevice,
+                                              pScreenPriv->hwndScreen,
+                                              &scd, NULL, NULL,
+                                              &pScreenPriv->pdxgiSwapChain);
+    if (FAILED(hr)) {
+        ErrorF("winAllocateFBShadowDXGI - CreateSwapChainForHwnd failed: "
+               "%08x\n", (unsigned int) hr);
+        goto winAllocateFBShadowDXGI_Exit;
+    }
+
+    /* We handle Alt+Enter and friends ourselves */
+    IDXGIFactory2_MakeWindowAssociation(pdxgiFactory,
+                                        pScreenPriv->hwndScreen,
+                                        DXGI_MWA_NO_WINDOW_CHANGES
+                                        | DXGI_MWA_NO_ALT_ENTER);
+
+    /*
+     * Buffer 0 always refers to the current back buffer of a flip-model
+     * swap chain in D3D11, so it can be kept for the life of the chain.
+     */
+    hr = IDXGISwapChain1_GetBuffer(pScreenPriv->pdxgiSwapChain, 0,
+                                   &IID_ID3D11Texture2D,
+                                   (void **) &pScreenPriv->pd3dBackBuffer);
+    if (FAILED(hr)) {
+        ErrorF("winAllocateFBShadowDXGI - GetBuffer failed: %08x\n",
+               (unsigned int) hr);
+        goto winAllocateFBShadowDXGI_Exit;
+    }
+
+    /* Neither back buffer has seen the shadow framebuffer yet */
+    RegionUninit(&pScreenPriv->rgnDXGIStale);
+    RegionNull(&pScreenPriv->rgnDXGIStale);
+    winPresentShadowDXGI(pScreen, NULL);
+
+    /* The swap chain format fixes our masks */
+    pScreenPriv->dwRedMask = WIN_24BPP_MASK_RED;
+    pScreenPriv->dwGreenMask = WIN_24BPP_MASK_GREEN;
+    pScreenPriv->dwBlueMask = WIN_24BPP_MASK_BLUE;
+
+    winDebug("winAllocateFBShadowDXGI - Created swap chain, stride: %d\n",
+             (int) pScreenInfo->dwStride);
+
+    fReturn = TRUE;
+
+ winAllocateFBShadowDXGI_Exit:
+    if (pdxgiFactory)
+        IDXGIFactory2_Release(pdxgiFactory);
+    if (pdxgiAdapter)
+        IDXGIAdapter_Release(pdxgiAdapter);
+    if (pdxgiDevice)
+        IDXGIDevice_Release(pdxgiDevice);
+
+    if (!fReturn)
+        winReleaseSwapChainShadowDXGI(pScreenPriv);
+
+    return fReturn;
+}
+
+static void
+winFreeFBShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    winReleaseSwapChainShadowDXGI(pScreenPriv);
+
+    RegionUninit(&pScreenPriv->rgnDXGIStale);
+    RegionNull(&pScreenPriv->rgnDXGIStale);
+
+    free(pScreenPriv->prcDXGIDirty);
+    pScreenPriv->prcDXGIDirty = NULL;
+    pScreenPriv->dwDXGIDirtyMax = 0;
+
+    /* Free the shadow framebuffer and invalidate the ScreenInfo's pointer */
+    free(pScreenInfo->pfb);
+    pScreenInfo->pfb = NULL;
+}
+
+/*
+ * Present the damaged regions of the shadow framebuffer.
+ */
+
+static void
+winShadowUpdateDXGI(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    RegionPtr damage = DamageRegion(pBuf->pDamage);
+
+    /*
+     * Return immediately if the app is not active
+     * and we are fullscreen, or if we have a bad display depth
+     */
+    if ((!pScreenPriv->fActive && pScreenInfo->fFullScreen)
+        || pScreenPriv->fBadDepth)
+        return;
+
+    /* Return immediately if we didn't get a swap chain */
+    if (!pScreenPriv->pdxgiSwapChain)
+        return;
+
+    winPresentShadowDXGI(pScreen, damage);
+}
+
+static Bool
+winInitScreenShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    /* Get a device context for the screen, only used for queries */
+    pScreenPriv->hdcScreen = GetDC(pScreenPriv->hwndScreen);
+
+    return winAllocateFBShadowDXGI(pScreen);
+}
+
+/*
+ * Call the wrapped CloseScreen function.
+ *
+ * Free our resources and private structures.
+ */
+
+static Bool
+winCloseScreenShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    Bool fReturn = TRUE;
+
+    winDebug("winCloseScreenShadowDXGI - Freeing screen resources\n");
+
+    /* Flag that the screen is closed */
+    pScreenPriv->fClosed = TRUE;
+    pScreenPriv->fActive = FALSE;
+
+    /* Call the wrapped CloseScreen procedure */
+    WIN_UNWRAP(CloseScreen);
+    if (pScreen->CloseScreen)
+        fReturn = (*pScreen->CloseScreen) (pScreen);
+
+    winFreeFBShadowDXGI(pScreen);
+
+    /* Free the screen DC */
+    ReleaseDC(pScreenPriv->hwndScreen, pScreenPriv->hdcScreen);
+
+    /* Delete the window property */
+    RemoveProp(pScreenPriv->hwndScreen, WIN_SCR_PROP);
+
+    /* Delete tray icon, if we have one */
+    if (!pScreenInfo->fNoTrayIcon && !pref.fNoTrayIcon)
+        winDeleteNotifyIcon(pScreenPriv);
+
+    /* Free the exit confirmation dialog box, if it exists */
+    if (g_hDlgExit != NULL) {
+        DestroyWindow(g_hDlgExit);
+        g_hDlgExit = NULL;
+    }
+
+    /* Kill our window */
+    if (pScreenPriv->hwndScreen) {
+        DestroyWindow(pScreenPriv->hwndScreen);
+        pScreenPriv->hwndScreen = NULL;
+    }
+
+    /* Destroy the thread startup mutex */
+    if (pScreenPriv->pmServerStarted) pthread_mutex_destroy (&pScreenPriv->pmServerStarted);
+
+    /* Kill our screeninfo's pointer to the screen */
+    pScreenInfo->pScreen = NULL;
+
+    /* Free the screen privates for this screen */
+    free((void *) pScreenPriv);
+
+    return fReturn;
+}
+
+/*
+ * Tell mi what sort of visuals we need.
+ *
+ * The swap chain is always BGRX, so we only ever have a TrueColor visual.
+ */
+
+static Bool
+winInitVisualsShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    pScreenPriv->dwBitsPerRGB = 8;
+
+    winDebug("winInitVisualsShadowDXGI - Masks %08x %08x %08x BPRGB %d d %d "
+             "bpp %d\n",
+             (unsigned int) pScreenPriv->dwRedMask,
+             (unsigned int) pScreenPriv->dwGreenMask,
+             (unsigned int) pScreenPriv->dwBlueMask,
+             (int) pScreenPriv->dwBitsPerRGB,
+             (int) pScreenInfo->dwDepth, (int) pScreenInfo->dwBPP);
+
+    if (pScreenInfo->dwDepth != WIN_DXGI_DEPTH) {
+        ErrorF("winInitVisualsShadowDXGI - Unsupported screen depth %d\n",
+               (int) pScreenInfo->dwDepth);
+        return FALSE;
+    }
+
+    if (!miSetVisualTypesAndMasks(pScreenInfo->dwDepth,
+                                  TrueColorMask,
+                                  pScreenPriv->dwBitsPerRGB,
+                                  -1,
+                                  pScreenPriv->dwRedMask,
+                                  pScreenPriv->dwGreenMask,
+                                  pScreenPriv->dwBlueMask)) {
+        ErrorF("winInitVisualsShadowDXGI - miSetVisualTypesAndMasks "
+               "failed for TrueColor\n");
+        return FALSE;
+    }
+
+#ifdef XWIN_EMULATEPSEUDO
+    if (pScreenInfo->fEmulatePseudo) {
+        /* Setup a pseudocolor visual */
+        if (!miSetVisualTypesAndMasks(8, PseudoColorMask, 8, -1, 0, 0, 0)) {
+            ErrorF("winInitVisualsShadowDXGI - miSetVisualTypesAndMasks "
+                   "failed for PseudoColor\n");
+            return FALSE;
+        }
+    }
+#endif
+
+    winDebug("winInitVisualsShadowDXGI - Returning\n");
+
+    return TRUE;
+}
+
+/*
+ * Adjust the user proposed video mode
+ */
+
+static Bool
+winAdjustVideoModeShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /* DXGI converts from our swap chain format, whatever the display uses */
+    pScreenInfo->dwBPP = WIN_DXGI_BPP;
+
+    return TRUE;
+}
+
+/*
+ * Present the whole shadow framebuffer when the window is exposed.
+ *
+ * We must not draw with GDI on a window that has a flip-model swap
+ * chain, so we only validate the update region and present again.
+ */
+
+static Bool
+winBltExposedRegionsShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    PAINTSTRUCT ps;
+
+    BeginPaint(pScreenPriv->hwndScreen, &ps);
+    EndPaint(pScreenPriv->hwndScreen, &ps);
+
+    if (!pScreenPriv->pdxgiSwapChain)
+        return FALSE;
+
+    winPresentShadowDXGI(pScreen, NULL);
+
+    return TRUE;
+}
+
+/*
+ * Do any engine-specific application-activation processing
+ */
+
+static Bool
+winActivateAppShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /*
+     * Our fullscreen window is an ordinary borderless window, so keep
+     * it out of the z-order while deactivated, like ShadowGDI does.
+     */
+    if (pScreenPriv->fActive && pScreenInfo->fFullScreen) {
+        ShowWindow(pScreenPriv->hwndScreen, SW_RESTORE);
+    }
+    else if (!pScreenPriv->fActive && pScreenInfo->fFullScreen) {
+        ShowWindow(pScreenPriv->hwndScreen, SW_MINIMIZE);
+    }
+
+    return TRUE;
+}
+
+/*
+ * Present the whole shadow framebuffer again.
+ */
+
+static Bool
+winRedrawScreenShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    /* Return immediately if we didn't get a swap chain */
+    if (!pScreenPriv->pdxgiSwapChain)
+        return FALSE;
+
+    winPresentShadowDXGI(pScreen, NULL);
+
+    return TRUE;
+}
+
+/*
+ * Colormap handling; we only have TrueColor visuals so there is
+ * nothing to install.
+ */
+
+static Bool
+winRealizeInstalledPaletteShadowDXGI(ScreenPtr pScreen)
+{
+    return TRUE;
+}
+
+static Bool
+winInstallColormapShadowDXGI(ColormapPtr pColormap)
+{
+    winScreenPriv(pColormap->pScreen);
+
+    /* Save a pointer to the newly installed colormap */
+    pScreenPriv->pcmapInstalled = pColormap;
+
+    return TRUE;
+}
+
+static Bool
+winStoreColorsShadowDXGI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
+{
+    return TRUE;
+}
+
+static Bool
+winCreateColormapShadowDXGI(ColormapPtr pColormap)
+{
+    return TRUE;
+}
+
+static Bool
+winDestroyColormapShadowDXGI(ColormapPtr pColormap)
+{
+    winScreenPriv(pColormap->pScreen);
+
+    if (pColormap->flags & IsDefault)
+        pScreenPriv->pcmapInstalled = NULL;
+
+    return TRUE;
+}
+
+/*
+ * Set pointers to our engine specific functions
+ */
+
+Bool
+winSetEngineFunctionsShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /* Set our pointers */
+    pScreenPriv->pwinAllocateFB = winAllocateFBShadowDXGI;
+    pScreenPriv->pwinFreeFB = winFreeFBShadowDXGI;
+    pScreenPriv->pwinShadowUpdate = winShadowUpdateDXGI;
+    pScreenPriv->pwinInitScreen = winInitScreenShadowDXGI;
+    pScreenPriv->pwinCloseScreen = winCloseScreenShadowDXGI;
+    pScreenPriv->pwinInitVisuals = winInitVisualsShadowDXGI;
+    pScreenPriv->pwinAdjustVideoMode = winAdjustVideoModeShadowDXGI;
+    if (pScreenInfo->fFullScreen)
+        pScreenPriv->pwinCreateBoundingWindow =
+            winCreateBoundingWindowFullScreen;
+    else
+        pScreenPriv->pwinCreateBoundingWindow = winCreateBoundingWindowWindowed;
+    pScreenPriv->pwinFinishScreenInit = winFinishScreenInitFB;
+    pScreenPriv->pwinBltExposedRegions = winBltExposedRegionsShadowDXGI;
+    pScreenPriv->pwinBltExposedWindowRegion = NULL;
+    pScreenPriv->pwinActivateApp = winActivateAppShadowDXGI;
+    pScreenPriv->pwinRedrawScreen = winRedrawScreenShadowDXGI;
+    pScreenPriv->pwinRealizeInstalledPalette
+        = winRealizeInstalledPaletteShadowDXGI;
+    pScreenPriv->pwinInstallColormap = winInstallColormapShadowDXGI;
+    pScreenPriv->pwinStoreColors = winStoreColorsShadowDXGI;
+    pScreenPriv->pwinCreateColormap = winCreateColormapShadowDXGI;
+    pScreenPriv->pwinDestroyColormap = winDestroyColormapShadowDXGI;
+    pScreenPriv->pwinCreatePrimarySurface = NULL;
+    pScreenPriv->pwinReleasePrimarySurface = NULL;
+
+    return TRUE;
+}
@@ -40,7 +40,8 @@
 
 static wBOOL CALLBACK winRedrawAllProcShadowGDI(HWND hwnd, LPARAM lParam);
 
-static wBOOL CALLBACK winRedrawDamagedWindowShadowGDI(HWND hwnd, LPARAM lParam);
+static void
+ winRedrawDamagedWindowsShadowGDI(ScreenPtr pScreen, RegionPtr pDamage);
 
 static Bool
  winAllocateFBShadowGDI(ScreenPtr pScreen);
@@ -278,36 +279,145 @@ winRedrawAllProcShadowGDI(HWND hwnd, LPARAM lParam)
     return TRUE;
 }
 
-static wBOOL CALLBACK
-winRedrawDamagedWindowShadowGDI(HWND hwnd, LPARAM lParam)
+/*
+ * Invalidate the parts of the multiwindow mode HWNDs covered by the
+ * damaged region.
+ *
+ * We walk the X top-level windows, which track exactly the area each
+ * HWND displays, instead of asking Windows about every top-level window
+ * in the thread.  Windows whose extents miss the damage are rejected
+ * without any region arithmetic, and only the damage boxes that fall
+ * inside a window are invalidated.
+ */
+
+static void
+winRedrawDamagedWindowsShadowGDI(ScreenPtr pScreen, RegionPtr pDamage)
 {
-    BoxPtr pDamage = (BoxPtr) lParam;
-    RECT rcClient, rcDamage, rcRedraw;
-    POINT topLeft, bottomRight;
-
-    if (IsIconic(hwnd))
-        return TRUE;            /* Don't care minimized windows */
-
-    /* Convert the damaged area from Screen coords to Client coords */
-    topLeft.x = pDamage->x1;
-    topLeft.y = pDamage->y1;
-    bottomRight.x = pDamage->x2;
-    bottomRight.y = pDamage->y2;
-    topLeft.x += GetSystemMetrics(SM_XVIRTUALSCREEN);
-    bottomRight.x += GetSystemMetrics(SM_XVIRTUALSCREEN);
-    topLeft.y += GetSystemMetrics(SM_YVIRTUALSCREEN);
-    bottomRight.y += GetSystemMetrics(SM_YVIRTUALSCREEN);
-    ScreenToClient(hwnd, &topLeft);
-    ScreenToClient(hwnd, &bottomRight);
-    SetRect(&rcDamage, topLeft.x, topLeft.y, bottomRight.x, bottomRight.y);
-
-    GetClientRect(hwnd, &rcClient);
-
-    if (IntersectRect(&rcRedraw, &rcClient, &rcDamage)) {
-        InvalidateRect(hwnd, &rcRedraw, FALSE);
-        UpdateWindow(hwnd);
+    winScreenPriv(pScreen);
+    BoxPtr pDamageExtents = RegionExtents(pDamage);
+    RegionRec rgnRedraw;
+    WindowPtr pWin;
+
+    if (pScreen->root == NULL)
+        return;
+
+    RegionNull(&rgnRedraw);
+
+    for (pWin = pScreen->root->firstChild; pWin; pWin = pWin->nextSib) {
+        winWindowPriv(pWin);
+        BoxPtr pWinExtents = RegionExtents(&pWin->winSize);
+        BoxPtr pBox;
+        int nBox;
+
+        if (!pWin->realized || pWinPriv->hWnd == NULL)
+            continue;
+
+        /* Quick reject on the extents */
+        if (pWinExtents->x1 >= pDamageExtents->x2
+            || pWinExtents->x2 <= pDamageExtents->x1
+            || pWinExtents->y1 >= pDamageExtents->y2
+            || pWinExtents->y2 <= pDamageExtents->y1)
+            continue;
+
+        RegionIntersect(&rgnRedraw, pDamage, &pWin->winSize);
+        if (!RegionNotEmpty(&rgnRedraw))
+            continue;
+
+        if (IsIconic(pWinPriv->hWnd))
+            continue;           /* Don't care minimized windows */
+
+        /* The client area origin of the HWND is the X window origin */
+        nBox = RegionNumRects(&rgnRedraw);
+        pBox = RegionRects(&rgnRedraw);
+        while (nBox--) {
+            RECT rcRedraw;
+
+            SetRect(&rcRedraw,
+                    pBox->x1 - pWin->drawable.x,
+                    pBox->y1 - pWin->drawable.y,
+                    pBox->x2 - pWin->drawable.x,
+                    pBox->y2 - pWin->drawable.y);
+            InvalidateRect(pWinPriv->hWnd, &rcRedraw, FALSE);
+            ++pBox;
+        }
+
+        /*
+         * Windows accumulates the update region for us; the WM_PAINT is
+         * either picked up by our message pump or forced out by
+         * winFlushPendingPaintsShadowGDI at the next frame boundary.
+         */
+        pWinPriv->fPaintPending = TRUE;
+        pScreenPriv->fPaintPending = TRUE;
+    }
+
+    RegionUninit(&rgnRedraw);
+}
+
+/*
+ * Paint the multiwindow windows that still have invalidated areas.
+ *
+ * Called from the block handler, so the BitBlts happen after the
+ * dispatch loop has run out of requests, and at most once per monitor
+ * refresh.  If the next frame is not due yet, shorten the wait so that
+ * we come back in time for it.
+ */
+
+void
+winFlushPendingPaintsShadowGDI(ScreenPtr pScreen, int *piTimeout)
+{
+    winScreenPriv(pScreen);
+    DWORD dwElapsed = GetTickCount() - pScreenPriv->dwLastPaintFlush;
+    WindowPtr pWin;
+
+    if (!pScreenPriv->fPaintPending || pScreen->root == NULL)
+        return;
+
+    if (dwElapsed < pScreenPriv->dwPaintInterval) {
+        int iRemaining = pScreenPriv->dwPaintInterval - dwElapsed;
+
+        if (*piTimeout < 0 || *piTimeout > iRemaining)
+            *piTimeout = iRemaining;
+        return;
+    }
+
+    pScreenPriv->fPaintPending = FALSE;
+    pScreenPriv->dwLastPaintFlush = GetTickCount();
+
+    for (pWin = pScreen->root->firstChild; pWin; pWin = pWin->nextSib) {
+        winWindowPriv(pWin);
+        RegionPtr pRegion = NULL;
+
+        /*
+         * A WM_PAINT handled meanwhile clears fPaintPending, but not the
+         * damage of a -compositewm window, which was not invalidated yet
+         */
+        if (pWinPriv->pDamage &&
+            RegionNotEmpty(DamageRegion(pWinPriv->pDamage)))
+            pRegion = DamageRegion(pWinPriv->pDamage);
+
+        if (!pWinPriv->fPaintPending && !pRegion)
+            continue;
+
+        pWinPriv->fPaintPending = FALSE;
+        if (pWinPriv->hWnd == NULL)
+            continue;
+
+        if (pRegion) {
+            BoxPtr pBox = RegionRects(pRegion);
+            int nBox = RegionNumRects(pRegion);
+
+            while (nBox--) {
+                RECT rcRedraw;
+
+                SetRect(&rcRedraw, pBox->x1, pBox->y1, pBox->x2, pBox->y2);
+                InvalidateRect(pWinPriv->hWnd, &rcRedraw, FALSE);
+                ++pBox;
+            }
+            DamageEmpty(pWinPriv->pDamage);
+        }
+
+        UpdateWindow(pWinPriv->hWnd);
     }
-    return TRUE;
 }
 
 /*
@@ -357,22 +467,28 @@ winAllocateFBShadowGDI(ScreenPtr pScreen)
     /* Select the shadow bitmap into the shadow DC */
     SelectObject(pScreenPriv->hdcShadow, pScreenPriv->hbmpShadow);
 
-    winDebug("winAllocateFBShadowGDI - Attempting a shadow blit\n");
-
-    /* Do a test blit from the shadow to the screen, I think */
-    fReturn = BitBlt(pScreenPriv->hdcScreen,
-                     0, 0,
-                     pScreenInfo->dwWidth, pScreenInfo->dwHeight,
-                     pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
-    if (fReturn) {
-        winDebug("winAllocateFBShadowGDI - Shadow blit success\n");
-    }
-    else {
-        winW32Error ("winAllocateFBShadowGDI - Shadow blit failure\n");
-        /* ago: ignore this error. The blit fails with wine, but does not
-         * cause any problems later. */
+    /*
+     * Do a test blit from the shadow to the screen, I think.  Not in
+     * multiwindow mode, where the screen window is hidden and reading all
+     * of the shadow would bring in the pages no window ever covers.
+     */
+    if (!pScreenInfo->fMultiWindow) {
+        winDebug("winAllocateFBShadowGDI - Attempting a shadow blit\n");
+
+        fReturn = BitBlt(pScreenPriv->hdcScreen,
+                         0, 0,
+                         pScreenInfo->dwWidth, pScreenInfo->dwHeight,
+                         pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
+        if (fReturn) {
+            winDebug("winAllocateFBShadowGDI - Shadow blit success\n");
+        }
+        else {
+            winW32Error ("winAllocateFBShadowGDI - Shadow blit failure\n");
+            /* ago: ignore this error. The blit fails with wine, but does not
+             * cause any problems later. */
 
-        fReturn = TRUE;
+            fReturn = TRUE;
+        }
     }
 
     /* Look for height weirdness */
@@ -406,6 +522,10 @@ winFreeFBShadowGDI(ScreenPtr pScreen)
 
     /* Invalidate the ScreenInfo's fb pointer */
     pScreenInfo->pfb = NULL;
+
+    /* The tile checksums described the old bitmap */
+    free(pScreenPriv->pTileSums);
+    pScreenPriv->pTileSums = NULL;
 }
 
 /*
@@ -422,12 +542,6 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
     BoxPtr pBox = RegionRects(damage);
     int x, y, w, h;
     HRGN hrgnCombined = NULL;
-
-#ifdef XWIN_UPDATESTATS
-    static DWORD s_dwNonUnitRegions = 0;
-    static DWORD s_dwTotalUpdates = 0;
-    static DWORD s_dwTotalBoxes = 0;
-#endif
     BoxPtr pBoxExtents = RegionExtents(damage);
 
     /*
@@ -438,23 +552,15 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
         || pScreenPriv->fBadDepth)
         return;
 
-#ifdef XWIN_UPDATESTATS
-    ++s_dwTotalUpdates;
-    s_dwTotalBoxes += dwBox;
-
-    if (dwBox != 1) {
-        ++s_dwNonUnitRegions;
-        winDebug ("winShadowUpdatGDI - dwBox: %d\n", dwBox);
+    /* Don't blit tiles that were redrawn with the same contents */
+    if (pScreenInfo->fSkipUnchanged) {
+        winSkipUnchangedTiles(pScreen, damage);
+        if (!RegionNotEmpty(damage))
+            return;
+        dwBox = RegionNumRects(damage);
+        pBox = RegionRects(damage);
     }
 
-    if ((s_dwTotalUpdates % 100) == 0)
-        winDebug ("winShadowUpdateGDI - %d%% non-unity regions, avg boxes: %d "
-                  "nu: %d tu: %d\n",
-                  (s_dwNonUnitRegions * 100) / s_dwTotalUpdates,
-                  s_dwTotalBoxes / s_dwTotalUpdates,
-                  s_dwNonUnitRegions, s_dwTotalUpdates);
-#endif                          /* XWIN_UPDATESTATS */
-
     /*
      * Handle small regions with multiple blits,
      * handle large regions by creating a clipping region and
@@ -463,6 +569,9 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
     if (!pScreenInfo->fMultiWindow &&
         (pScreenInfo->dwClipUpdatesNBoxes == 0 ||
          dwBox < pScreenInfo->dwClipUpdatesNBoxes)) {
+        /* Merge small boxes to cut down the number of blits */
+        dwBox = winCoalesceDamageBoxes(damage, &pBox);
+
         /* Loop through all boxes in the damaged region */
         while (dwBox--) {
             /*
@@ -508,11 +617,9 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
         SelectClipRgn(pScreenPriv->hdcScreen, NULL);
     }
 
-    /* Redraw all multiwindow windows */
+    /* Redraw the damaged parts of the multiwindow windows */
     if (pScreenInfo->fMultiWindow)
-        EnumThreadWindows(g_dwCurrentThreadID,
-                          winRedrawDamagedWindowShadowGDI,
-                          (LPARAM) pBoxExtents);
+        winRedrawDamagedWindowsShadowGDI(pScreen, damage);
 }
 
 static Bool
@@ -531,6 +638,16 @@ winInitScreenShadowGDI(ScreenPtr pScreen)
         return FALSE;
     }
 
+    /* Pace multiwindow repaints to the refresh rate of the display */
+    {
+        int iRefresh = GetDeviceCaps(pScreenPriv->hdcScreen, VREFRESH);
+
+        /* 0 and 1 mean the hardware default refresh rate */
+        if (iRefresh <= 1)
+            iRefresh = 60;
+        pScreenPriv->dwPaintInterval = 1000 / iRefresh;
+    }
+
     /* Query the screen format */
     if (!winQueryScreenDIBFormat(pScreen, pScreenPriv->pbmih)) {
         ErrorF("winInitScreenShadowGDI - winQueryScreenDIBFormat failed\n");
@@ -578,6 +695,10 @@ winCloseScreenShadowGDI(ScreenPtr pScreen)
 
     winFreeFBShadowGDI(pScreen);
 
+    /* Free any pixmap DIBs kept for reuse */
+    UnregisterCacheTrim(winTrimDIBCacheMultiwindow, pScreen);
+    winFlushDIBCacheMultiwindow(pScreen);
+
     /* Free the screen DC */
     ReleaseDC(pScreenPriv->hwndScreen, pScreenPriv->hdcScreen);
 
@@ -800,6 +921,9 @@ winBltExposedWindowRegionShadowGDI(ScreenPtr pScreen, WindowPtr pWin)
     HDC hdcUpdate;
     PAINTSTRUCT ps;
 
+    /* BeginPaint validates the whole update region, nothing is left over */
+    pWinPriv->fPaintPending = FALSE;
+
     hdcUpdate = BeginPaint(hWnd, &ps);
     /* Avoid the BitBlt if the PAINTSTRUCT region is bogus */
     if (ps.rcPaint.right == 0 && ps.rcPaint.bottom == 0 &&
@@ -818,17 +942,12 @@ winBltExposedWindowRegionShadowGDI(ScreenPtr pScreen, WindowPtr pWin)
         /* window pixmap format is the same as the screen pixmap */
         assert(pPixmap->drawable.bitsPerPixel > 8);
 
-        /* Get the window bitmap from the pixmap */
-        hBitmap = pPixmapPriv->hBitmap;
-
-        /* XXX: There may be a need for a slow-path here: If hBitmap is NULL
-           (because we couldn't back the pixmap with a Windows DIB), we should
-           fall-back to creating a Windows DIB from the pixmap, then deleting it
-           after the BitBlt (as this this code did before the fast-path was
-           added). */
-        if (!hBitmap) {
+        /* Get the window bitmap from the pixmap, moving a pixmap that
+           still lives in plain memory into a DIB first */
+        if (!winPixmapEnsureDIBMultiwindow(pPixmap)) {
             ErrorF("winBltExposedWindowRegionShadowGDI - slow path unimplemented\n");
         }
+        hBitmap = pPixmapPriv->hBitmap;
 
         /* Select the window bitmap into a screen-compatible DC */
         hdcPixmap = CreateCompatibleDC(pScreenPriv->hdcScreen);
@@ -1014,6 +1133,66 @@ winRealizeInstalledPaletteShadowGDI(ScreenPtr pScreen)
     return TRUE;
 }
 
+/*
+ * Load entries of the shadow DIB color table, telling whether any of them
+ * changed.  Colormaps that only differ in pixels nobody stored to, or a
+ * client storing the colors it already has, then cost no redraw.
+ */
+
+static Bool
+winSetColorTableShadowGDI(ScreenPtr pScreen, int iFirst, int iCount,
+                          RGBQUAD *prgbColors, Bool *pfChanged)
+{
+    winScreenPriv(pScreen);
+    RGBQUAD rgbCurrent[WIN_NUM_PALETTE_ENTRIES];
+
+    *pfChanged = TRUE;
+    if (iCount <= 0)
+        return TRUE;
+
+    if (GetDIBColorTable(pScreenPriv->hdcShadow, iFirst, iCount,
+                         rgbCurrent) == (UINT) iCount
+        && memcmp(rgbCurrent, prgbColors + iFirst,
+                  iCount * sizeof(RGBQUAD)) == 0) {
+        *pfChanged = FALSE;
+        return TRUE;
+    }
+
+    if (SetDIBColorTable(pScreenPriv->hdcShadow,
+                         iFirst, iCount, prgbColors + iFirst) == 0)
+        return FALSE;
+
+    return TRUE;
+}
+
+/*
+ * Every pixel on the screen may have changed color.  Invalidate instead of
+ * blitting now, so that several colormap changes in one dispatch cycle
+ * cost a single redraw; multiwindow mode paints from the block handler.
+ */
+
+static void
+winRedrawPaletteShadowGDI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    if (pScreenInfo->fMultiWindow) {
+        RegionRec rgnScreen;
+        BoxRec box;
+
+        box.x1 = 0;
+        box.y1 = 0;
+        box.x2 = pScreen->width;
+        box.y2 = pScreen->height;
+        RegionInit(&rgnScreen, &box, 1);
+        winRedrawDamagedWindowsShadowGDI(pScreen, &rgnScreen);
+        RegionUninit(&rgnScreen);
+    }
+    else
+        InvalidateRect(pScreenPriv->hwndScreen, NULL, FALSE);
+}
+
 /*
  * Install the specified colormap
  */
@@ -1024,7 +1203,7 @@ winInstallColormapShadowGDI(ColormapPtr pColormap)
     ScreenPtr pScreen = pColormap->pScreen;
 
     winScreenPriv(pScreen);
-    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    Bool fChanged;
 
     winCmapPriv(pColormap);
 
@@ -1044,25 +1223,18 @@ winInstallColormapShadowGDI(ColormapPtr pColormap)
     }
 
     /* Set the DIB color table */
-    if (SetDIBColorTable(pScreenPriv->hdcShadow,
-                         0,
-                         WIN_NUM_PALETTE_ENTRIES, pCmapPriv->rgbColors) == 0) {
+    if (!winSetColorTableShadowGDI(pScreen, 0, WIN_NUM_PALETTE_ENTRIES,
+                                   pCmapPriv->rgbColors, &fChanged)) {
         ErrorF("winInstallColormapShadowGDI - SetDIBColorTable () failed\n");
         return FALSE;
     }
 
-    /* Redraw the whole window, to take account for the new colors */
-    BitBlt(pScreenPriv->hdcScreen,
-           0, 0,
-           pScreenInfo->dwWidth, pScreenInfo->dwHeight,
-           pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
-
     /* Save a pointer to the newly installed colormap */
     pScreenPriv->pcmapInstalled = pColormap;
 
-    /* Redraw all windows */
-    if (pScreenInfo->fMultiWindow)
-        EnumThreadWindows(g_dwCurrentThreadID, winRedrawAllProcShadowGDI, 0);
+    /* Redraw everything, to take account for the new colors */
+    if (fChanged)
+        winRedrawPaletteShadowGDI(pScreen);
 
     return TRUE;
 }
@@ -1079,11 +1251,15 @@ winStoreColorsShadowGDI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
     winScreenPriv(pScreen);
     winCmapPriv(pColormap);
     ColormapPtr curpmap = pScreenPriv->pcmapInstalled;
+    int iFirst, iCount;
+    Bool fChanged;
 
     /* Put the X colormap entries into the Windows logical palette */
-    if (SetPaletteEntries(pCmapPriv->hPalette,
-                          pdefs[0].pixel,
-                          ndef, pCmapPriv->peColors + pdefs[0].pixel) == 0) {
+    winColormapRange(ndef, pdefs, &iFirst, &iCount);
+    if (iCount == 0)
+        return TRUE;
+    if (SetPaletteEntries(pCmapPriv->hPalette, iFirst, iCount,
+                          pCmapPriv->peColors + iFirst) == 0) {
         ErrorF("winStoreColorsShadowGDI - SetPaletteEntries () failed\n");
         return FALSE;
     }
@@ -1093,28 +1269,21 @@ winStoreColorsShadowGDI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
         return TRUE;
     }
 
-    /* Try to install the newly modified colormap */
-    if (!winInstallColormapShadowGDI(pColormap)) {
-        ErrorF("winInstallColormapShadowGDI - winInstallColormapShadowGDI "
-               "failed\n");
+    /* Tell Windows that the palette has changed */
+    if (GDI_ERROR == RealizePalette(pScreenPriv->hdcScreen)) {
+        ErrorF("winStoreColorsShadowGDI - RealizePalette () failed\n");
         return FALSE;
     }
 
-#if 0
-    /* Tell Windows that the palette has changed */
-    RealizePalette(pScreenPriv->hdcScreen);
-
-    /* Set the DIB color table */
-    if (SetDIBColorTable(pScreenPriv->hdcShadow,
-                         pdefs[0].pixel,
-                         ndef, pCmapPriv->rgbColors + pdefs[0].pixel) == 0) {
-        ErrorF("winInstallColormapShadowGDI - SetDIBColorTable () failed\n");
+    /* Only the stored entries of the DIB color table need loading */
+    if (!winSetColorTableShadowGDI(pScreen, iFirst, iCount,
+                                   pCmapPriv->rgbColors, &fChanged)) {
+        ErrorF("winStoreColorsShadowGDI - SetDIBColorTable () failed\n");
         return FALSE;
     }
 
-    /* Save a pointer to the newly installed colormap */
-    pScreenPriv->pcmapInstalled = pColormap;
-#endif
+    if (fChanged)
+        winRedrawPaletteShadowGDI(pScreen);
 
     return TRUE;
 }
@@ -0,0 +1,228 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Startup timeline and background prefetch.
+ *
+ * winStartupMark() logs how long after process creation each step of the
+ * first server generation finished, so a slow start can be pinned on the
+ * screen engine, GLX, the font path, the keymap or the window manager.
+ * "ready for clients" is logged when the server first waits for clients;
+ * the clipboard thread, started by the first client, comes after it.
+ *
+ * winStartupReady() signals the event a launcher passed with -readyevent
+ * as soon as the display is listening, which is early in InitOutput.
+ * Clients that connect from then on wait in the listen backlog until the
+ * server dispatches, so the launcher can start them while the screens
+ * are still coming up, instead of polling for the display.
+ *
+ * winStartupPrefetch() starts a thread, while InitOutput is still setting
+ * up the screens, that does work whose only lasting effect is a warm
+ * cache: it loads and initialises the OpenGL driver, which is most of
+ * what the GLX probe waits for, and reads the font path's fonts.dir and
+ * fonts.alias files.  The probe and InitInput join the thread with
+ * winStartupWait(), so nothing runs concurrently with them.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#include <pthread.h>
+
+#include "win.h"
+#include "winmsg.h"
+#include "opaque.h"
+#ifdef XWIN_GLX_WINDOWS
+#include "glx/glwindows.h"
+#endif
+
+static LARGE_INTEGER s_liStartupFrequency;
+static LARGE_INTEGER s_liStartupFirst;
+static unsigned long s_ulStartupOffset;   /* ms from creation to first mark */
+static unsigned long s_ulStartupLast;
+static Bool s_fStartupDone;
+
+static pthread_t s_ptPrefetch;
+static Bool s_fPrefetchRunning;
+static unsigned long s_ulPrefetchGl, s_ulPrefetchFonts;   /* ms */
+
+static unsigned long
+winStartupMillis(LARGE_INTEGER liFrom, LARGE_INTEGER liTo)
+{
+    return (unsigned long) ((liTo.QuadPart - liFrom.QuadPart) * 1000 /
+                            s_liStartupFrequency.QuadPart);
+}
+
+/*
+ * Log that a startup step has finished.  The first mark anchors the
+ * performance counter to the process creation time; later marks are
+ * timed with the counter alone.
+ */
+void
+winStartupMark(const char *pszStep)
+{
+    LARGE_INTEGER liNow;
+    unsigned long ulNow;
+
+    if (serverGeneration != 1)
+        return;
+
+    QueryPerformanceCounter(&liNow);
+    if (!s_liStartupFirst.QuadPart) {
+        FILETIME ftCreation, ftExit, ftKernel, ftUser, ftNow;
+        ULARGE_INTEGER uliCreation, uliNow;
+
+        QueryPerformanceFrequency(&s_liStartupFrequency);
+        s_liStartupFirst = liNow;
+        GetSystemTimeAsFileTime(&ftNow);
+        if (GetProcessTimes(GetCurrentProcess(), &ftCreation, &ftExit,
+                            &ftKernel, &ftUser)) {
+            uliCreation.LowPart = ftCreation.dwLowDateTime;
+            uliCreation.HighPart = ftCreation.dwHighDateTime;
+            uliNow.LowPart = ftNow.dwLowDateTime;
+            uliNow.HighPart = ftNow.dwHighDateTime;
+            if (uliNow.QuadPart > uliCreation.QuadPart)
+                s_ulStartupOffset = (unsigned long)
+                    ((uliNow.QuadPart - uliCreation.QuadPart) / 10000);
+        }
+    }
+
+    ulNow = s_ulStartupOffset + winStartupMillis(s_liStartupFirst, liNow);
+    LogMessageVerb(X_INFO, 1, "startup: %-32s %6lu ms (+%lu)\n", pszStep,
+                   ulNow, ulNow - s_ulStartupLast);
+    s_ulStartupLast = ulNow;
+}
+
+/*
+ * The display's sockets are listening and no other server holds the
+ * display number.  With -displayfd, the launcher learns the number here
+ * too, rather than after InitInput.
+ */
+void
+winStartupReady(void)
+{
+    if (serverGeneration != 1 || !g_hReadyEvent)
+        return;
+
+    if (displayfd != -1)
+        NotifyParentProcess();
+    if (!SetEvent(g_hReadyEvent))
+        ErrorF("winStartupReady - SetEvent failed (%lu)\n",
+               (unsigned long) GetLastError());
+    CloseHandle(g_hReadyEvent);
+    g_hReadyEvent = NULL;
+    winStartupMark("listening");
+}
+
+/* The server is about to wait for its first client */
+void
+winStartupDone(void)
+{
+    if (serverGeneration != 1 || s_fStartupDone)
+        return;
+    winStartupMark("ready for clients");
+    s_fStartupDone = TRUE;
+}
+
+/* Read a file and throw the data away, so the real reader finds it cached */
+static void
+winStartupReadFile(const char *pszDir, const char *pszFile)
+{
+    char szPath[MAX_PATH];
+    char achBuffer[16384];
+    FILE *pFile;
+
+    if (snprintf(szPath, sizeof(szPath), "%s/%s", pszDir, pszFile)
+        >= sizeof(szPath))
+        return;
+    pFile = fopen(szPath, "rb");
+    if (!pFile)
+        return;
+    while (fread(achBuffer, 1, sizeof(achBuffer), pFile) == sizeof(achBuffer))
+        ;
+    fclose(pFile);
+}
+
+/*
+ * Font path elements are directories, optionally followed by
+ * ":attributes" after the last slash; anything else (font servers,
+ * built-ins) has no fonts.dir and simply isn't found.
+ */
+static void
+winStartupReadFontPath(char *pszFontPath)
+{
+    char *pszElement, *pszNext;
+
+    for (pszElement = pszFontPath; pszElement; pszElement = pszNext) {
+        char *pszSlash, *pszColon;
+
+        pszNext = strchr(pszElement, ',');
+        if (pszNext)
+            *pszNext++ = '\0';
+
+        pszSlash = strrchr(pszElement, '/');
+        pszColon = strchr(pszSlash ? pszSlash : pszElement, ':');
+        if (pszColon && pszSlash)
+            *pszColon = '\0';
+
+        winStartupReadFile(pszElement, "fonts.dir");
+        winStartupReadFile(pszElement, "fonts.alias");
+    }
+}
+
+static void *
+winStartupPrefetchProc(void *pArg)
+{
+    char *pszFontPath = pArg;
+    LARGE_INTEGER liStart, liGl, liFonts;
+
+    QueryPerformanceCounter(&liStart);
+#ifdef XWIN_GLX_WINDOWS
+    if (g_fNativeGl)
+        glxWinWarmDriver();
+#endif
+    QueryPerformanceCounter(&liGl);
+
+    if (pszFontPath) {
+        winStartupReadFontPath(pszFontPath);
+        free(pszFontPath);
+    }
+    QueryPerformanceCounter(&liFonts);
+
+    s_ulPrefetchGl = winStartupMillis(liStart, liGl);
+    s_ulPrefetchFonts = winStartupMillis(liGl, liFonts);
+    return NULL;
+}
+
+void
+winStartupPrefetch(void)
+{
+    char *pszFontPath;
+
+    if (serverGeneration != 1 || s_fPrefetchRunning)
+        return;
+
+    /* InitOutput's first winStartupMark has set the counter frequency */
+    pszFontPath = defaultFontPath ? strdup(defaultFontPath) : NULL;
+    if (pthread_create(&s_ptPrefetch, NULL, winStartupPrefetchProc,
+                       pszFontPath)) {
+        ErrorF("winStartupPrefetch - pthread_create failed\n");
+        free(pszFontPath);
+        return;
+    }
+    s_fPrefetchRunning = TRUE;
+}
+
+void
+winStartupWait(void)
+{
+    if (!s_fPrefetchRunning)
+        return;
+
+    pthread_join(s_ptPrefetch, NULL);
+    s_fPrefetchRunning = FALSE;
+    LogMessageVerb(X_INFO, 1, "startup: prefetch took %lu ms for the GL "
+                   "driver, %lu ms for the font path\n",
+                   s_ulPrefetchGl, s_ulPrefetchFonts);
+    winStartupMark("prefetch joined");
+}
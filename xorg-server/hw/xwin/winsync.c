@@ -0,0 +1,260 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+/*
+ * SYNC fences backed by Win32 events.
+ *
+ * Every fence gets a manual-reset event named
+ *
+ *   Local\VcXsrv-fence-<display>-<fence XID>
+ *
+ * that is set whenever the fence is triggered and reset with it, so a
+ * local GL or D3D client can wait for the server with WaitForSingleObject
+ * instead of a round trip, and can trigger the fence itself with SetEvent
+ * once its own rendering is done.  An untriggered fence is watched from
+ * the thread pool; when its event is set from outside, the pool thread
+ * only flags the fence and wakes the server thread, and the fence is
+ * triggered, with everything waiting on it, from the wakeup handler.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "opaque.h"
+#include "list.h"
+#include "misync.h"
+#include "misyncstr.h"
+
+#ifdef XSYNC
+
+typedef struct {
+    SyncScreenCreateFenceFunc CreateFence;
+    SyncScreenDestroyFenceFunc DestroyFence;
+} winSyncScreenRec, *winSyncScreenPtr;
+
+typedef struct {
+    struct xorg_list link;
+    SyncFence *pFence;
+    HANDLE hEvent;
+    HANDLE hWait;               /* thread pool wait while untriggered */
+    volatile LONG lSignalled;   /* event set from outside, not handled yet */
+    SyncFenceSetTriggeredFunc SetTriggered;
+    SyncFenceResetFunc Reset;
+} winSyncFenceRec, *winSyncFencePtr;
+
+static DevPrivateKeyRec winSyncScreenKeyRec;
+static DevPrivateKeyRec winSyncFenceKeyRec;
+
+#define winSyncGetScreen(pScreen) ((winSyncScreenPtr) \
+    dixLookupPrivate(&(pScreen)->devPrivates, &winSyncScreenKeyRec))
+#define winSyncGetFence(pFence) ((winSyncFencePtr) \
+    dixLookupPrivate(&(pFence)->devPrivates, &winSyncFenceKeyRec))
+
+static struct xorg_list winSyncFences;
+static volatile LONG winSyncPending;
+static unsigned long winSyncGeneration;
+
+/* Runs on a thread pool thread */
+static VOID CALLBACK
+winSyncFenceSignalled(PVOID pvFence, BOOLEAN fTimedOut)
+{
+    winSyncFencePtr pWinFence = pvFence;
+
+    InterlockedExchange(&pWinFence->lSignalled, 1);
+    InterlockedExchange(&winSyncPending, 1);
+    PostThreadMessage(g_dwCurrentThreadID, WM_NULL, 0, 0);
+}
+
+static void
+winSyncFenceWatch(winSyncFencePtr pWinFence)
+{
+    if (pWinFence->hWait)
+        return;
+    if (!RegisterWaitForSingleObject(&pWinFence->hWait, pWinFence->hEvent,
+                                     winSyncFenceSignalled, pWinFence,
+                                     INFINITE, WT_EXECUTEONLYONCE))
+        pWinFence->hWait = NULL;
+}
+
+static void
+winSyncFenceUnwatch(winSyncFencePtr pWinFence)
+{
+    if (pWinFence->hWait) {
+        /* Also waits for a callback that is already running */
+        UnregisterWaitEx(pWinFence->hWait, INVALID_HANDLE_VALUE);
+        pWinFence->hWait = NULL;
+    }
+    InterlockedExchange(&pWinFence->lSignalled, 0);
+}
+
+static void
+winSyncWakeupHandler(void *data, int result)
+{
+    winSyncFencePtr pWinFence, pNext;
+
+    if (!InterlockedExchange(&winSyncPending, 0))
+        return;
+
+    xorg_list_for_each_entry_safe(pWinFence, pNext, &winSyncFences, link) {
+        SyncFence *pFence = pWinFence->pFence;
+
+        if (!InterlockedExchange(&pWinFence->lSignalled, 0))
+            continue;
+        winSyncFenceUnwatch(pWinFence);
+        if (!pFence->funcs.CheckTriggered(pFence))
+            miSyncTriggerFence(pFence);
+    }
+}
+
+static void
+winSyncFenceSetTriggered(SyncFence *pFence)
+{
+    winSyncFencePtr pWinFence = winSyncGetFence(pFence);
+
+    winSyncFenceUnwatch(pWinFence);
+    pWinFence->SetTriggered(pFence);
+    SetEvent(pWinFence->hEvent);
+}
+
+static void
+winSyncFenceReset(SyncFence *pFence)
+{
+    winSyncFencePtr pWinFence = winSyncGetFence(pFence);
+
+    pWinFence->Reset(pFence);
+    ResetEvent(pWinFence->hEvent);
+    winSyncFenceWatch(pWinFence);
+}
+
+static void
+winSyncCreateFence(ScreenPtr pScreen, SyncFence *pFence,
+                   Bool initially_triggered)
+{
+    winSyncScreenPtr pWinSync = winSyncGetScreen(pScreen);
+    SyncScreenFuncsPtr pScreenFuncs = miSyncGetScreenFuncs(pScreen);
+    winSyncFencePtr pWinFence = winSyncGetFence(pFence);
+    char szName[64];
+
+    pScreenFuncs->CreateFence = pWinSync->CreateFence;
+    pScreenFuncs->CreateFence(pScreen, pFence, initially_triggered);
+    pWinSync->CreateFence = pScreenFuncs->CreateFence;
+    pScreenFuncs->CreateFence = winSyncCreateFence;
+
+    /* Fences the server makes for itself have no XID and no name */
+    if (pFence->sync.id) {
+        snprintf(szName, sizeof(szName), "Local\\VcXsrv-fence-%s-%lx",
+                 display, (unsigned long) pFence->sync.id);
+        pWinFence->hEvent = CreateEventA(NULL, TRUE, initially_triggered,
+                                         szName);
+    }
+    else
+        pWinFence->hEvent = CreateEventA(NULL, TRUE, initially_triggered,
+                                         NULL);
+    if (!pWinFence->hEvent) {
+        winDebug("winSyncCreateFence - CreateEvent failed: %lu\n",
+                 GetLastError());
+        return;
+    }
+
+    /* A client may have opened the name first; the fence decides */
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        if (initially_triggered)
+            SetEvent(pWinFence->hEvent);
+        else
+            ResetEvent(pWinFence->hEvent);
+    }
+
+    pWinFence->pFence = pFence;
+    pWinFence->SetTriggered = pFence->funcs.SetTriggered;
+    pFence->funcs.SetTriggered = winSyncFenceSetTriggered;
+    pWinFence->Reset = pFence->funcs.Reset;
+    pFence->funcs.Reset = winSyncFenceReset;
+    xorg_list_add(&pWinFence->link, &winSyncFences);
+
+    if (!initially_triggered)
+        winSyncFenceWatch(pWinFence);
+}
+
+static void
+winSyncDestroyFence(ScreenPtr pScreen, SyncFence *pFence)
+{
+    winSyncScreenPtr pWinSync = winSyncGetScreen(pScreen);
+    SyncScreenFuncsPtr pScreenFuncs = miSyncGetScreenFuncs(pScreen);
+    winSyncFencePtr pWinFence = winSyncGetFence(pFence);
+
+    if (pWinFence->hEvent) {
+        winSyncFenceUnwatch(pWinFence);
+        xorg_list_del(&pWinFence->link);
+        CloseHandle(pWinFence->hEvent);
+        pWinFence->hEvent = NULL;
+    }
+
+    pScreenFuncs->DestroyFence = pWinSync->DestroyFence;
+    pScreenFuncs->DestroyFence(pScreen, pFence);
+    pWinSync->DestroyFence = pScreenFuncs->DestroyFence;
+    pScreenFuncs->DestroyFence = winSyncDestroyFence;
+}
+
+Bool
+winSyncScreenInit(ScreenPtr pScreen)
+{
+    winSyncScreenPtr pWinSync;
+    SyncScreenFuncsPtr pScreenFuncs;
+
+    if (!dixRegisterPrivateKey(&winSyncScreenKeyRec, PRIVATE_SCREEN,
+                               sizeof(winSyncScreenRec)))
+        return FALSE;
+    if (!dixRegisterPrivateKey(&winSyncFenceKeyRec, PRIVATE_SYNC_FENCE,
+                               sizeof(winSyncFenceRec)))
+        return FALSE;
+
+    if (!miSyncSetup(pScreen))
+        return FALSE;
+
+    if (winSyncGeneration != serverGeneration) {
+        xorg_list_init(&winSyncFences);
+        winSyncPending = 0;
+        if (!RegisterBlockAndWakeupHandlers((ServerBlockHandlerProcPtr)
+                                            NoopDDA, winSyncWakeupHandler,
+                                            NULL))
+            return FALSE;
+        winSyncGeneration = serverGeneration;
+    }
+
+    pWinSync = winSyncGetScreen(pScreen);
+    pScreenFuncs = miSyncGetScreenFuncs(pScreen);
+    pWinSync->CreateFence = pScreenFuncs->CreateFence;
+    pScreenFuncs->CreateFence = winSyncCreateFence;
+    pWinSync->DestroyFence = pScreenFuncs->DestroyFence;
+    pScreenFuncs->DestroyFence = winSyncDestroyFence;
+
+    return TRUE;
+}
+
+#endif /* XSYNC */
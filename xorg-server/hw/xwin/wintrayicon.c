@@ -37,6 +37,7 @@
 #include <shellapi.h>
 #include "winprefs.h"
 #include "winclipboard/winclipboard.h"
+#include "opaque.h"
 
 static NOTIFYICONDATA nid;
 /*
@@ -199,6 +200,10 @@ winHandleIconMessage(HWND hwnd, UINT message,
             RemoveMenu(hmenuTray, ID_APP_MONITOR_PRIMARY, MF_BYCOMMAND);
         }
 
+        /* Only offer the profile dump when -dispatchprofile is on */
+        if (!dispatchProfile)
+            RemoveMenu(hmenuTray, ID_APP_DISPATCH_PROFILE, MF_BYCOMMAND);
+
         SetupRootMenu(hmenuTray);
 
         /*
@@ -0,0 +1,517 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+/*
+ * XVideo image adaptor for XWin.
+ *
+ * Video players hand us YUV frames with XvPutImage or XvShmPutImage and
+ * we convert and scale them into the drawable ourselves, so the frame
+ * crosses the wire once at its native size instead of as client-side
+ * converted and scaled RGB.  Only the part of the destination that the
+ * GC's composite clip leaves visible is converted, and the result goes
+ * through the GC's PutImage, so damage and the shadow update see it like
+ * any other drawing.
+ *
+ * Scaling is nearest neighbour and colour conversion is BT.601 from
+ * tables; only 32 bit x8r8g8b8 screens get an adaptor.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "extinit.h"
+#include <X11/extensions/Xv.h>
+#include "xvdix.h"
+#include "fourcc.h"
+
+#ifdef XWIN_XV
+
+#define WIN_VIDEO_NUM_PORTS	16
+#define WIN_VIDEO_MAX_WIDTH	4096
+#define WIN_VIDEO_MAX_HEIGHT	4096
+
+typedef struct {
+    CloseScreenProcPtr CloseScreen;
+    CARD32 *pBuf;               /* converted pixels for one PutImage */
+    size_t nBufSize;
+    int *pXTable;               /* source column of each output pixel */
+    int nXTableSize;
+} winVideoScreenRec, *winVideoScreenPtr;
+
+static DevPrivateKeyRec winVideoScreenKeyRec;
+
+#define winVideoGetScreen(pScreen) ((winVideoScreenPtr) \
+    dixLookupPrivate(&(pScreen)->devPrivates, &winVideoScreenKeyRec))
+
+static XvImageRec winVideoImages[] = {
+    XVIMAGE_YV12,
+    XVIMAGE_I420,
+    XVIMAGE_NV12,
+    XVIMAGE_YUY2,
+    XVIMAGE_UYVY
+};
+
+#define WIN_VIDEO_NUM_IMAGES (sizeof(winVideoImages) / sizeof(winVideoImages[0]))
+
+/* BT.601 studio range, in 8.8 fixed point with the rounding folded in */
+static int winVideoYTable[256];
+static int winVideoRVTable[256];
+static int winVideoGUTable[256];
+static int winVideoGVTable[256];
+static int winVideoBUTable[256];
+
+static void
+winVideoInitTables(void)
+{
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        winVideoYTable[i] = 298 * (i - 16) + 128;
+        winVideoRVTable[i] = 409 * (i - 128);
+        winVideoGUTable[i] = -100 * (i - 128);
+        winVideoGVTable[i] = -208 * (i - 128);
+        winVideoBUTable[i] = 516 * (i - 128);
+    }
+}
+
+static inline CARD32
+winVideoClamp(int c)
+{
+    c >>= 8;
+    if (c < 0)
+        return 0;
+    if (c > 255)
+        return 255;
+    return c;
+}
+
+static inline CARD32
+winVideoPixel(int y, int u, int v)
+{
+    int l = winVideoYTable[y];
+
+    return 0xff000000 |
+        (winVideoClamp(l + winVideoRVTable[v]) << 16) |
+        (winVideoClamp(l + winVideoGUTable[u] + winVideoGVTable[v]) << 8) |
+        winVideoClamp(l + winVideoBUTable[u]);
+}
+
+/* One output row from planar Y with subsampled chroma, U and V uvStep apart */
+static void
+winVideoRowPlanar(CARD32 *pDst, int n, const int *pXTable,
+                  const CARD8 *pY, const CARD8 *pU, const CARD8 *pV,
+                  int uvStep)
+{
+    int i, x;
+
+    for (i = 0; i < n; i++) {
+        x = pXTable[i];
+        pDst[i] = winVideoPixel(pY[x], pU[(x >> 1) * uvStep],
+                                pV[(x >> 1) * uvStep]);
+    }
+}
+
+/* One output row from packed 4:2:2, two pixels in each four bytes */
+static void
+winVideoRowPacked(CARD32 *pDst, int n, const int *pXTable,
+                  const CARD8 *pRow, int yOff, int uOff, int vOff)
+{
+    int i, x;
+    const CARD8 *pPair;
+
+    for (i = 0; i < n; i++) {
+        x = pXTable[i];
+        pPair = pRow + (x & ~1) * 2;
+        pDst[i] = winVideoPixel(pRow[x * 2 + yOff], pPair[uOff], pPair[vOff]);
+    }
+}
+
+static int
+winVideoQueryImageAttributes(XvPortPtr pPort, XvImagePtr pImage,
+                             CARD16 *width, CARD16 *height,
+                             int *pitches, int *offsets)
+{
+    int size, tmp;
+
+    if (*width > WIN_VIDEO_MAX_WIDTH)
+        *width = WIN_VIDEO_MAX_WIDTH;
+    if (*height > WIN_VIDEO_MAX_HEIGHT)
+        *height = WIN_VIDEO_MAX_HEIGHT;
+
+    *width = (*width + 1) & ~1;
+    if (offsets)
+        offsets[0] = 0;
+
+    switch (pImage->id) {
+    case FOURCC_YV12:
+    case FOURCC_I420:
+        *height = (*height + 1) & ~1;
+        size = (*width + 3) & ~3;
+        if (pitches)
+            pitches[0] = size;
+        size *= *height;
+        if (offsets)
+            offsets[1] = size;
+        tmp = ((*width >> 1) + 3) & ~3;
+        if (pitches)
+            pitches[1] = pitches[2] = tmp;
+        tmp *= (*height >> 1);
+        size += tmp;
+        if (offsets)
+            offsets[2] = size;
+        size += tmp;
+        break;
+    case FOURCC_NV12:
+        *height = (*height + 1) & ~1;
+        tmp = (*width + 3) & ~3;
+        if (pitches)
+            pitches[0] = pitches[1] = tmp;
+        size = tmp * *height;
+        if (offsets)
+            offsets[1] = size;
+        size += tmp * (*height >> 1);
+        break;
+    default:                   /* YUY2, UYVY */
+        size = *width * 2;
+        if (pitches)
+            pitches[0] = size;
+        size *= *height;
+        break;
+    }
+
+    return size;
+}
+
+static int
+winVideoPutImage(DrawablePtr pDraw, XvPortPtr pPort, GCPtr pGC,
+                 INT16 src_x, INT16 src_y, CARD16 src_w, CARD16 src_h,
+                 INT16 drw_x, INT16 drw_y, CARD16 drw_w, CARD16 drw_h,
+                 XvImagePtr pImage, unsigned char *data, Bool sync,
+                 CARD16 width, CARD16 height)
+{
+    winVideoScreenPtr pVideo = winVideoGetScreen(pDraw->pScreen);
+    BoxPtr pClip;
+    int x1, y1, x2, y2;
+    CARD16 padWidth = width, padHeight = height;
+    int pitches[3], offsets[3];
+    int xStep, yStep;
+    int w, h, i, x, y, row;
+    const CARD8 *pY, *pU, *pV;
+
+    if (!width || !height)
+        return Success;
+
+    /* Only convert what the clip leaves visible, in screen coordinates */
+    x1 = pDraw->x + drw_x;
+    y1 = pDraw->y + drw_y;
+    x2 = x1 + drw_w;
+    y2 = y1 + drw_h;
+    pClip = RegionExtents(pGC->pCompositeClip);
+    if (x1 < pClip->x1)
+        x1 = pClip->x1;
+    if (y1 < pClip->y1)
+        y1 = pClip->y1;
+    if (x2 > pClip->x2)
+        x2 = pClip->x2;
+    if (y2 > pClip->y2)
+        y2 = pClip->y2;
+    if (x1 >= x2 || y1 >= y2)
+        return Success;
+
+    w = x2 - x1;
+    h = y2 - y1;
+
+    if ((size_t) w * h * sizeof(CARD32) > pVideo->nBufSize) {
+        CARD32 *pBuf = malloc((size_t) w * h * sizeof(CARD32));
+
+        if (!pBuf)
+            return BadAlloc;
+        free(pVideo->pBuf);
+        pVideo->pBuf = pBuf;
+        pVideo->nBufSize = (size_t) w * h * sizeof(CARD32);
+    }
+    if (w > pVideo->nXTableSize) {
+        int *pXTable = reallocarray(pVideo->pXTable, w, sizeof(int));
+
+        if (!pXTable)
+            return BadAlloc;
+        pVideo->pXTable = pXTable;
+        pVideo->nXTableSize = w;
+    }
+
+    winVideoQueryImageAttributes(pPort, pImage, &padWidth, &padHeight,
+                                 pitches, offsets);
+
+    /* 16.16 steps through the source; clients may ask for more than the
+     * image holds, so source positions are clamped to it */
+    xStep = ((int) src_w << 16) / drw_w;
+    yStep = ((int) src_h << 16) / drw_h;
+
+    for (i = 0; i < w; i++) {
+        x = src_x + (int) (((INT64) (x1 - pDraw->x - drw_x + i) *
+                            xStep) >> 16);
+        pVideo->pXTable[i] = x < 0 ? 0 : x >= width ? width - 1 : x;
+    }
+
+    for (row = 0; row < h; row++) {
+        CARD32 *pDst = pVideo->pBuf + row * w;
+
+        y = src_y + (int) (((INT64) (y1 - pDraw->y - drw_y + row) *
+                            yStep) >> 16);
+        y = y < 0 ? 0 : y >= height ? height - 1 : y;
+
+        switch (pImage->id) {
+        case FOURCC_YV12:
+        case FOURCC_I420:
+            pY = data + offsets[0] + y * pitches[0];
+            pU = data + offsets[1] + (y >> 1) * pitches[1];
+            pV = data + offsets[2] + (y >> 1) * pitches[2];
+            if (pImage->id == FOURCC_YV12) {
+                const CARD8 *pTmp = pU;
+
+                pU = pV;
+                pV = pTmp;
+            }
+            winVideoRowPlanar(pDst, w, pVideo->pXTable, pY, pU, pV, 1);
+            break;
+        case FOURCC_NV12:
+            pY = data + offsets[0] + y * pitches[0];
+            pU = data + offsets[1] + (y >> 1) * pitches[1];
+            winVideoRowPlanar(pDst, w, pVideo->pXTable, pY, pU, pU + 1, 2);
+            break;
+        case FOURCC_YUY2:
+            winVideoRowPacked(pDst, w, pVideo->pXTable,
+                              data + y * pitches[0], 0, 1, 3);
+            break;
+        case FOURCC_UYVY:
+            winVideoRowPacked(pDst, w, pVideo->pXTable,
+                              data + y * pitches[0], 1, 0, 2);
+            break;
+        default:
+            return BadMatch;
+        }
+    }
+
+    (*pGC->ops->PutImage) (pDraw, pGC, pDraw->depth,
+                           x1 - pDraw->x, y1 - pDraw->y, w, h,
+                           0, ZPixmap, (char *) pVideo->pBuf);
+
+    return Success;
+}
+
+static int
+winVideoStopVideo(XvPortPtr pPort, DrawablePtr pDraw)
+{
+    /* Nothing is left running between images */
+    return Success;
+}
+
+static int
+winVideoSetPortAttribute(XvPortPtr pPort, Atom attribute, INT32 value)
+{
+    return BadMatch;
+}
+
+static int
+winVideoGetPortAttribute(XvPortPtr pPort, Atom attribute, INT32 *value)
+{
+    return BadMatch;
+}
+
+static int
+winVideoQueryBestSize(XvPortPtr pPort, CARD8 motion,
+                      CARD16 vid_w, CARD16 vid_h,
+                      CARD16 drw_w, CARD16 drw_h,
+                      unsigned int *p_w, unsigned int *p_h)
+{
+    /* Any scale is as cheap as any other */
+    *p_w = drw_w;
+    *p_h = drw_h;
+    return Success;
+}
+
+static Bool
+winVideoCloseScreen(ScreenPtr pScreen)
+{
+    winVideoScreenPtr pVideo = winVideoGetScreen(pScreen);
+    XvScreenPtr pxvs = dixLookupPrivate(&pScreen->devPrivates,
+                                        XvGetScreenKey());
+    int i;
+
+    pScreen->CloseScreen = pVideo->CloseScreen;
+
+    if (pxvs) {
+        for (i = 0; i < pxvs->nAdaptors; i++)
+            XvFreeAdaptor(&pxvs->pAdaptors[i]);
+        free(pxvs->pAdaptors);
+        pxvs->pAdaptors = NULL;
+        pxvs->nAdaptors = 0;
+    }
+
+    free(pVideo->pBuf);
+    free(pVideo->pXTable);
+    free(pVideo);
+    dixSetPrivate(&pScreen->devPrivates, &winVideoScreenKeyRec, NULL);
+
+    return (*pScreen->CloseScreen) (pScreen);
+}
+
+static Bool
+winVideoInitAdaptor(ScreenPtr pScreen, XvAdaptorPtr pa)
+{
+    winScreenPriv(pScreen);
+    XvPortPtr pp;
+    int i;
+
+    pa->type = XvInputMask | XvImageMask;
+    pa->pScreen = pScreen;
+    pa->name = strdup("XWin Video");
+
+    pa->nEncodings = 1;
+    pa->pEncodings = calloc(1, sizeof(XvEncodingRec));
+    if (pa->pEncodings) {
+        pa->pEncodings->id = 0;
+        pa->pEncodings->pScreen = pScreen;
+        pa->pEncodings->name = strdup("XV_IMAGE");
+        pa->pEncodings->width = WIN_VIDEO_MAX_WIDTH;
+        pa->pEncodings->height = WIN_VIDEO_MAX_HEIGHT;
+        pa->pEncodings->rate.numerator = 1;
+        pa->pEncodings->rate.denominator = 1;
+    }
+
+    pa->nFormats = 1;
+    pa->pFormats = calloc(1, sizeof(XvFormatRec));
+    if (pa->pFormats) {
+        pa->pFormats->depth = pScreen->rootDepth;
+        pa->pFormats->visual = pScreenPriv->pRootVisual->vid;
+    }
+
+    pa->nImages = WIN_VIDEO_NUM_IMAGES;
+    pa->pImages = malloc(sizeof(winVideoImages));
+    if (pa->pImages)
+        memcpy(pa->pImages, winVideoImages, sizeof(winVideoImages));
+
+    pa->pPorts = calloc(WIN_VIDEO_NUM_PORTS, sizeof(XvPortRec));
+
+    if (!pa->name || !pa->pEncodings || !pa->pEncodings->name ||
+        !pa->pFormats || !pa->pImages || !pa->pPorts)
+        return FALSE;
+
+    for (i = 0, pp = pa->pPorts; i < WIN_VIDEO_NUM_PORTS; i++) {
+        if (!(pp->id = FakeClientID(0)))
+            continue;
+        if (!AddResource(pp->id, XvGetRTPort(), pp))
+            continue;
+
+        pp->pAdaptor = pa;
+        pp->pNotify = NULL;
+        pp->pDraw = NULL;
+        pp->client = NULL;
+        pp->grab.client = NULL;
+        pp->time = currentTime;
+        pp->devPriv.ptr = NULL;
+
+        pp++;
+        pa->nPorts++;
+    }
+    if (!pa->nPorts)
+        return FALSE;
+    pa->base_id = pa->pPorts->id;
+
+    pa->ddPutVideo = NULL;
+    pa->ddPutStill = NULL;
+    pa->ddGetVideo = NULL;
+    pa->ddGetStill = NULL;
+    pa->ddStopVideo = winVideoStopVideo;
+    pa->ddSetPortAttribute = winVideoSetPortAttribute;
+    pa->ddGetPortAttribute = winVideoGetPortAttribute;
+    pa->ddQueryBestSize = winVideoQueryBestSize;
+    pa->ddPutImage = winVideoPutImage;
+    pa->ddQueryImageAttributes = winVideoQueryImageAttributes;
+
+    return TRUE;
+}
+
+Bool
+winInitVideo(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    VisualPtr pVisual = pScreenPriv->pRootVisual;
+    winVideoScreenPtr pVideo;
+    XvScreenPtr pxvs;
+    XvAdaptorPtr pa;
+
+    if (noXvExtension)
+        return TRUE;
+
+    /* The converters write x8r8g8b8 only */
+    if (pScreenInfo->dwBPP != 32 || pVisual->class != TrueColor ||
+        pVisual->redMask != 0xff0000 || pVisual->greenMask != 0xff00 ||
+        pVisual->blueMask != 0xff) {
+        winDebug("winInitVideo - no Xv adaptor for this screen format\n");
+        return TRUE;
+    }
+
+    if (!dixRegisterPrivateKey(&winVideoScreenKeyRec, PRIVATE_SCREEN, 0))
+        return FALSE;
+
+    if (XvScreenInit(pScreen) != Success)
+        return FALSE;
+    pxvs = dixLookupPrivate(&pScreen->devPrivates, XvGetScreenKey());
+
+    pVideo = calloc(1, sizeof(winVideoScreenRec));
+    pa = calloc(1, sizeof(XvAdaptorRec));
+    if (!pVideo || !pa) {
+        free(pVideo);
+        free(pa);
+        return FALSE;
+    }
+
+    if (!winVideoInitAdaptor(pScreen, pa)) {
+        ErrorF("winInitVideo - Could not set up the Xv adaptor\n");
+        XvFreeAdaptor(pa);
+        free(pa);
+        free(pVideo);
+        return TRUE;
+    }
+
+    winVideoInitTables();
+
+    pxvs->nAdaptors = 1;
+    pxvs->pAdaptors = pa;
+
+    dixSetPrivate(&pScreen->devPrivates, &winVideoScreenKeyRec, pVideo);
+    pVideo->CloseScreen = pScreen->CloseScreen;
+    pScreen->CloseScreen = winVideoCloseScreen;
+
+    return TRUE;
+}
+
+#endif /* XWIN_XV */
@@ -36,19 +36,89 @@
 #endif
 #include "win.h"
 
+/*
+ * Upper bounds on the work done draining the Windows message queue on a
+ * single wakeup, so that a flood of Windows messages (mouse drags, bursts
+ * of WM_PAINT) is handled promptly without starving X clients.
+ */
+#define WIN_WAKEUP_MAX_MESSAGES		64
+#define WIN_WAKEUP_TIME_SLICE_MS	8
+
+/*
+ * Message pump statistics, reported at verbosity 3 when the server exits
+ */
+static struct {
+    unsigned long ulWakeups;
+    unsigned long ulMessages;
+    unsigned long ulBatchesTruncated;
+    DWORD dwMaxBatch;
+    DWORD dwMaxLatency;
+    unsigned long long ullTotalLatency;
+} s_wakeupStats;
+
+static Bool
+winWakeupIsDialogMessage(MSG *pmsg)
+{
+    return (g_hDlgDepthChange != 0
+            && IsDialogMessage(g_hDlgDepthChange, pmsg))
+        || (g_hDlgExit != 0 && IsDialogMessage(g_hDlgExit, pmsg))
+        || (g_hDlgAbout != 0 && IsDialogMessage(g_hDlgAbout, pmsg));
+}
+
 /* See Porting Layer Definition - p. 7 */
 void
 winWakeupHandler(ScreenPtr pScreen, int iResult)
 {
     MSG msg;
+    DWORD dwStart = GetTickCount();
+    DWORD dwCount = 0;
+
+    /*
+     * Process a batch of messages from our queue, bounded both by count
+     * and by time so X client requests still get serviced under load
+     */
+    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+        DWORD dwLatency = GetTickCount() - (DWORD) msg.time;
 
-    /* Process one message from our queue */
-    if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-        if ((g_hDlgDepthChange == 0
-             || !IsDialogMessage(g_hDlgDepthChange, &msg))
-            && (g_hDlgExit == 0 || !IsDialogMessage(g_hDlgExit, &msg))
-            && (g_hDlgAbout == 0 || !IsDialogMessage(g_hDlgAbout, &msg))) {
+        /* msg.time is zero for some internally generated messages */
+        if (msg.time != 0 && dwLatency < 0x80000000) {
+            s_wakeupStats.ullTotalLatency += dwLatency;
+            if (dwLatency > s_wakeupStats.dwMaxLatency)
+                s_wakeupStats.dwMaxLatency = dwLatency;
+        }
+
+        if (!winWakeupIsDialogMessage(&msg))
             DispatchMessage(&msg);
+
+        if (++dwCount >= WIN_WAKEUP_MAX_MESSAGES
+            || GetTickCount() - dwStart >= WIN_WAKEUP_TIME_SLICE_MS) {
+            /* Anything left over is picked up on the next wakeup, since
+               winBlockHandler polls while the queue is non-empty */
+            s_wakeupStats.ulBatchesTruncated++;
+            break;
         }
     }
+
+    s_wakeupStats.ulWakeups++;
+    s_wakeupStats.ulMessages += dwCount;
+    if (dwCount > s_wakeupStats.dwMaxBatch)
+        s_wakeupStats.dwMaxBatch = dwCount;
+}
+
+void
+winWakeupLogStatistics(void)
+{
+    if (g_iLogVerbose < 3 || s_wakeupStats.ulWakeups == 0)
+        return;
+
+    ErrorF("winWakeupHandler - %lu wakeups, %lu messages, "
+           "max batch %lu, %lu batches truncated\n",
+           s_wakeupStats.ulWakeups, s_wakeupStats.ulMessages,
+           (unsigned long) s_wakeupStats.dwMaxBatch,
+           s_wakeupStats.ulBatchesTruncated);
+    if (s_wakeupStats.ulMessages != 0)
+        ErrorF("winWakeupHandler - message latency avg %lu ms, max %lu ms\n",
+               (unsigned long) (s_wakeupStats.ullTotalLatency /
+                                s_wakeupStats.ulMessages),
+               (unsigned long) s_wakeupStats.dwMaxLatency);
 }
@@ -72,11 +72,14 @@ typedef struct _winPrivScreenRec *winPrivScreenPtr;
 typedef struct {
     DWORD dwDummy;
     HRGN hRgn;
+    HRGN hRgnShown;             /* copy of the region last set on hWnd */
     HWND hWnd;
     BOOL OpenGlWindow;
     winPrivScreenPtr pScreenPriv;
     Bool fXKilled;
     HDWP hDwp;
+    Bool fPaintPending;
+    struct _damage *pDamage;    /* drawing on a -compositewm top-level */
 #ifdef XWIN_GLX_WINDOWS
     Bool fWglUsed;
 #endif
@@ -824,11 +824,37 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             ShowCursor(TRUE);
         }
 
+        /* In relative mode motion comes from WM_INPUT */
+        if (winMouseRelative())
+            return 0;
+
         /* Deliver absolute cursor position to X Server */
-        winEnqueueMotion(GET_X_LPARAM(lParam) - s_pScreenInfo->dwXOffset,
-                         GET_Y_LPARAM(lParam) - s_pScreenInfo->dwYOffset);
+        if (g_fMouseHistory) {
+            POINT ptOrigin = { 0, 0 };
+
+            ClientToScreen(hwnd, &ptOrigin);
+            winEnqueueMotionHistory(GET_X_LPARAM(lParam) -
+                                    s_pScreenInfo->dwXOffset,
+                                    GET_Y_LPARAM(lParam) -
+                                    s_pScreenInfo->dwYOffset,
+                                    ptOrigin.x + s_pScreenInfo->dwXOffset,
+                                    ptOrigin.y + s_pScreenInfo->dwYOffset);
+        }
+        else
+            winEnqueueMotion(GET_X_LPARAM(lParam) - s_pScreenInfo->dwXOffset,
+                             GET_Y_LPARAM(lParam) - s_pScreenInfo->dwYOffset);
         return 0;
 
+    case WM_INPUT:
+        /* We can't do anything without privates */
+        if (s_pScreenPriv == NULL || s_pScreenInfo->fIgnoreInput)
+            break;
+
+        winMouseRawInput((HRAWINPUT) lParam);
+
+        /* DefWindowProc frees the raw input buffer */
+        break;
+
     case WM_NCMOUSEMOVE:
         /*
          * We break instead of returning 0 since we need to call
@@ -961,7 +987,8 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             point.y -= GetSystemMetrics(SM_YVIRTUALSCREEN);
 
             /* If the mouse pointer has moved, deliver absolute cursor position to X Server */
-            if (last_point.x != point.x || last_point.y != point.y) {
+            if ((last_point.x != point.x || last_point.y != point.y)
+                && !winMouseRelative()) {
                 winEnqueueMotion(point.x, point.y);
                 last_point.x = point.x;
                 last_point.y = point.y;
@@ -1029,6 +1056,9 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 
         /* Remove our keyboard hook if it is installed */
         winRemoveKeyboardHookLL();
+
+        /* Hand the cursor back along with the focus */
+        winMouseStopRelative();
         return 0;
 
     case WM_SYSKEYDOWN:
@@ -1204,6 +1234,15 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             gatherWindows();
             return 0;
 
+        case ID_APP_DISPATCH_PROFILE:
+            DispatchProfileReport();
+            return 0;
+
+        case ID_APP_ENGINE_STATS:
+            winEngineStatsReport();
+            winLatencyReport();
+            return 0;
+
         case ID_APP_ABOUT:
             /* Display the About box */
             winDisplayAboutDialog(s_pScreenPriv);
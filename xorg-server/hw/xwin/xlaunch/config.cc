@@ -23,133 +23,215 @@
  * holders shall not be used in advertising or otherwise to promote the sale,
  * use or other dealings in this Software without prior written authorization.
  */
-#include <libxml/parser.h>
-#include <libxml/tree.h>
+#include <expat.h>
+#include <stdio.h>
+#include <map>
 #include "config.h"
 #include "window/util.h"
 #include <stdexcept>
 
-xmlDocPtr CreateDocument()
+typedef std::map<std::string, std::string> Attributes;
+
+/* Config files are UTF-8; the strings in CConfig are in the ANSI code page */
+static std::string convert(const std::string &str, UINT from, UINT to)
 {
-  xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
-  xmlNodePtr root_node = xmlNewNode(NULL, BAD_CAST "XLaunch");
-  xmlDocSetRootElement(doc, root_node);
-  
-  return doc;
-    
+  if (str.empty())
+    return str;
+
+  int wlen = MultiByteToWideChar(from, 0, str.c_str(), -1, NULL, 0);
+  if (wlen <= 0)
+    return str;
+  std::vector<wchar_t> wide(wlen);
+  MultiByteToWideChar(from, 0, str.c_str(), -1, &wide[0], wlen);
+
+  int len = WideCharToMultiByte(to, 0, &wide[0], -1, NULL, 0, NULL, NULL);
+  if (len <= 0)
+    return str;
+  std::vector<char> ret(len);
+  WideCharToMultiByte(to, 0, &wide[0], -1, &ret[0], len, NULL, NULL);
+  return std::string(&ret[0]);
 }
 
-void setAttribute(xmlNodePtr elem, const char *name, const char *value)
+void setAttribute(std::string &xml, const char *name, const char *value)
 {
-  xmlNewProp(elem, BAD_CAST name, BAD_CAST value);
+  std::string str = convert(value, CP_ACP, CP_UTF8);
+
+  xml += ' ';
+  xml += name;
+  xml += "=\"";
+  for (size_t i = 0; i < str.size(); i++)
+  {
+    switch (str[i])
+    {
+	case '<': xml += "&lt;"; break;
+	case '>': xml += "&gt;"; break;
+	case '&': xml += "&amp;"; break;
+	case '"': xml += "&quot;"; break;
+	case '\n': xml += "&#10;"; break;
+	case '\r': xml += "&#13;"; break;
+	case '\t': xml += "&#9;"; break;
+	default: xml += str[i]; break;
+    }
+  }
+  xml += '"';
 }
 
 void CConfig::Save(const char *filename)
 {
-    xmlDocPtr doc = CreateDocument();
-    xmlNodePtr root = xmlDocGetRootElement(doc);
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<XLaunch";
 
     switch (window)
     {
 	case MultiWindow:
-	    setAttribute(root, "WindowMode", "MultiWindow");
+	    setAttribute(xml, "WindowMode", "MultiWindow");
 	    break;
 	case Fullscreen:
-	    setAttribute(root, "WindowMode", "Fullscreen");
+	    setAttribute(xml, "WindowMode", "Fullscreen");
 	    break;
 	default:
 	case Windowed:
-	    setAttribute(root, "WindowMode", "Windowed");
+	    setAttribute(xml, "WindowMode", "Windowed");
 	    break;
 	case Nodecoration:
-	    setAttribute(root, "WindowMode", "Nodecoration");
+	    setAttribute(xml, "WindowMode", "Nodecoration");
 	    break;
     }
     switch (client)
     {
 	default:
 	case NoClient:
-	    setAttribute(root, "ClientMode", "NoClient");
+	    setAttribute(xml, "ClientMode", "NoClient");
 	    break;
 	case StartProgram:
-	    setAttribute(root, "ClientMode", "StartProgram");
+	    setAttribute(xml, "ClientMode", "StartProgram");
 	    break;
 	case XDMCP:
-	    setAttribute(root, "ClientMode", "XDMCP");
+	    setAttribute(xml, "ClientMode", "XDMCP");
 	    break;
     }
-    setAttribute(root, "LocalClient", local?"True":"False");
-    setAttribute(root, "Display", display.c_str());
-    setAttribute(root, "LocalProgram", localprogram.c_str());
-    setAttribute(root, "RemoteProgram", remoteprogram.c_str());
-    setAttribute(root, "RemotePassword", remotepassword.c_str());
-    setAttribute(root, "PrivateKey", privatekey.c_str());
-    setAttribute(root, "RemoteHost", host.c_str());
-    setAttribute(root, "RemoteUser", user.c_str());
-    setAttribute(root, "XDMCPHost", xdmcp_host.c_str());
-    setAttribute(root, "XDMCPBroadcast", broadcast?"True":"False");
-    setAttribute(root, "XDMCPIndirect", indirect?"True":"False");
-    setAttribute(root, "Clipboard", clipboard?"True":"False");
-    setAttribute(root, "ClipboardPrimary", clipboardprimary?"True":"False");
-    setAttribute(root, "ExtraParams", extra_params.c_str());
-    setAttribute(root, "Wgl", wgl?"True":"False");
-    setAttribute(root, "DisableAC", disableac?"True":"False");
-    setAttribute(root, "XDMCPTerminate", xdmcpterminate?"True":"False");
-
-    xmlSaveFormatFileEnc(filename, doc, "UTF-8", 1);
-
-    /*free the document */
-    xmlFreeDoc(doc);
-
-    /*
-     *Free the global variables that may
-     *have been allocated by the parser.
-     */
-    xmlCleanupParser();
+    setAttribute(xml, "LocalClient", local?"True":"False");
+    setAttribute(xml, "Display", display.c_str());
+    setAttribute(xml, "LocalProgram", localprogram.c_str());
+    setAttribute(xml, "RemoteProgram", remoteprogram.c_str());
+    setAttribute(xml, "RemotePassword", remotepassword.c_str());
+    setAttribute(xml, "PrivateKey", privatekey.c_str());
+    setAttribute(xml, "RemoteHost", host.c_str());
+    setAttribute(xml, "RemoteUser", user.c_str());
+    setAttribute(xml, "XDMCPHost", xdmcp_host.c_str());
+    setAttribute(xml, "XDMCPBroadcast", broadcast?"True":"False");
+    setAttribute(xml, "XDMCPIndirect", indirect?"True":"False");
+    setAttribute(xml, "Clipboard", clipboard?"True":"False");
+    setAttribute(xml, "ClipboardPrimary", clipboardprimary?"True":"False");
+    setAttribute(xml, "ExtraParams", extra_params.c_str());
+    setAttribute(xml, "Wgl", wgl?"True":"False");
+    setAttribute(xml, "DisableAC", disableac?"True":"False");
+    setAttribute(xml, "XDMCPTerminate", xdmcpterminate?"True":"False");
+    xml += "/>\n";
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+	return;
+    fwrite(xml.data(), 1, xml.size(), file);
+    fclose(file);
 }
 
-BOOL getAttribute(xmlNodePtr elem, const char *name, std::string &ret)
+BOOL getAttribute(const Attributes &attrs, const char *name, std::string &ret)
 {
-  char *pVal=(char*)xmlGetProp(elem,BAD_CAST name);
-  if (!pVal)
+  Attributes::const_iterator it = attrs.find(name);
+  if (it == attrs.end())
     return false;
-  ret=pVal;
+  ret = convert(it->second, CP_UTF8, CP_ACP);
   return true;
 }
 
-BOOL getAttributeBool(xmlNodePtr elem, const char *name, bool &ret)
+BOOL getAttributeBool(const Attributes &attrs, const char *name, bool &ret)
 {
-  const char *pVal=(char*)xmlGetProp(elem, BAD_CAST name);
-  if (!pVal)
+  Attributes::const_iterator it = attrs.find(name);
+  if (it == attrs.end())
     return false;
 
-  std::string str(pVal);
-
-  if (str == "True")
+  if (it->second == "True")
     ret = true;
   else
     ret = false;
   return true;
 }
 
+struct LoadState
+{
+  bool root;
+  Attributes attrs;
+};
 
-void CConfig::Load(const char *filename)
+/* Everything is kept on the root element; keep its attributes */
+static void XMLCALL startElement(void *userData, const XML_Char *name, const XML_Char **atts)
 {
-  xmlDocPtr doc = xmlReadFile(filename, NULL, 0);
+  LoadState *state = (LoadState *)userData;
 
-  xmlNodePtr root;
+  if (state->root)
+    return;
+  state->root = true;
+  for (; atts[0]; atts += 2)
+    state->attrs[atts[0]] = atts[1];
+}
+
+void CConfig::Load(const char *filename)
+{
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL)
+  {
+    return;
+  }
 
-  if (doc == NULL)
+  XML_Parser parser = XML_ParserCreate(NULL);
+  if (parser == NULL)
   {
+    fclose(file);
     return;
   }
 
-  root = xmlDocGetRootElement(doc);
+  LoadState state;
+  state.root = false;
+  XML_SetUserData(parser, &state);
+  XML_SetStartElementHandler(parser, startElement);
+
+  /* Stream the file through the parser; a malformed file changes nothing */
+  bool ok;
+  for (;;)
+  {
+    void *buf = XML_GetBuffer(parser, BUFSIZ);
+    if (!buf)
+    {
+      ok = false;
+      break;
+    }
+    size_t len = fread(buf, 1, BUFSIZ, file);
+    bool done = len < BUFSIZ;
+    if (ferror(file) ||
+        XML_ParseBuffer(parser, (int)len, done) == XML_STATUS_ERROR)
+    {
+      ok = false;
+      break;
+    }
+    if (done)
+    {
+      ok = true;
+      break;
+    }
+  }
+
+  XML_ParserFree(parser);
+  fclose(file);
+
+  if (!ok)
+    return;
+
+  const Attributes &attrs = state.attrs;
 
   std::string windowMode;
   std::string clientMode;
 
-    if (getAttribute(root, "WindowMode", windowMode))
+    if (getAttribute(attrs, "WindowMode", windowMode))
     {
 	if (windowMode == "MultiWindow")
 	    window = MultiWindow;
@@ -160,7 +242,7 @@ void CConfig::Load(const char *filename)
 	else if (windowMode == "Nodecoration")
 	    window = Nodecoration;
     }
-    if (getAttribute(root, "ClientMode", clientMode))
+    if (getAttribute(attrs, "ClientMode", clientMode))
     {
 	if (clientMode == "NoClient")
 	    client = NoClient;
@@ -170,31 +252,22 @@ void CConfig::Load(const char *filename)
 	    client = XDMCP;
     }
     
-    getAttributeBool(root, "LocalClient", local);
-    getAttribute(root, "Display", display);
-    getAttribute(root, "LocalProgram", localprogram);
-    getAttribute(root, "RemoteProgram", remoteprogram);
-    getAttribute(root, "RemotePassword", remotepassword);
-    getAttribute(root, "PrivateKey", privatekey);
-    getAttribute(root, "RemoteHost", host);
-    getAttribute(root, "RemoteUser", user);
-    getAttribute(root, "XDMCPHost", xdmcp_host);
-    getAttributeBool(root, "XDMCPBroadcast", broadcast);
-    getAttributeBool(root, "XDMCPIndirect", indirect);
-    getAttributeBool(root, "Clipboard", clipboard);
-    getAttributeBool(root, "ClipboardPrimary", clipboardprimary);
-    getAttribute(root, "ExtraParams", extra_params);
-    getAttributeBool(root, "Wgl", wgl);
-    getAttributeBool(root, "DisableAC", disableac);
-    getAttributeBool(root, "XDMCPTerminate", xdmcpterminate);
-
-    /*free the document */
-    xmlFreeDoc(doc);
-
-    /*
-     *Free the global variables that may
-     *have been allocated by the parser.
-     */
-    xmlCleanupParser();
+    getAttributeBool(attrs, "LocalClient", local);
+    getAttribute(attrs, "Display", display);
+    getAttribute(attrs, "LocalProgram", localprogram);
+    getAttribute(attrs, "RemoteProgram", remoteprogram);
+    getAttribute(attrs, "RemotePassword", remotepassword);
+    getAttribute(attrs, "PrivateKey", privatekey);
+    getAttribute(attrs, "RemoteHost", host);
+    getAttribute(attrs, "RemoteUser", user);
+    getAttribute(attrs, "XDMCPHost", xdmcp_host);
+    getAttributeBool(attrs, "XDMCPBroadcast", broadcast);
+    getAttributeBool(attrs, "XDMCPIndirect", indirect);
+    getAttributeBool(attrs, "Clipboard", clipboard);
+    getAttributeBool(attrs, "ClipboardPrimary", clipboardprimary);
+    getAttribute(attrs, "ExtraParams", extra_params);
+    getAttributeBool(attrs, "Wgl", wgl);
+    getAttributeBool(attrs, "DisableAC", disableac);
+    getAttributeBool(attrs, "XDMCPTerminate", xdmcpterminate);
 }
 
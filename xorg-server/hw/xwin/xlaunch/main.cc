@@ -786,6 +786,23 @@ class CMyWizard : public CWizard
                 }
             }
 
+            // Have VCXsrv tell us when the display is listening, so the client
+            // can start while the server is still initialising
+            HANDLE hReadyEvent = NULL;
+            if (!client.empty())
+            {
+              SECURITY_ATTRIBUTES sa;
+              sa.nLength=sizeof(sa);
+              sa.lpSecurityDescriptor=NULL;
+              sa.bInheritHandle=TRUE;
+              hReadyEvent=CreateEvent(&sa, TRUE, FALSE, NULL);
+              if (!hReadyEvent)
+                throw win32_error("CreateEvent failed");
+              std::stringstream ss;
+              ss<<" -readyevent "<<(uintptr_t)hReadyEvent;
+              buffer+=ss.str();
+            }
+
             // Prepare program startup
             STARTUPINFO si, sic;
             PROCESS_INFORMATION pi, pic;
@@ -813,16 +830,20 @@ class CMyWizard : public CWizard
 
             if (!client.empty())
             {
+                // Wait for the display to listen.  A client connecting from
+                // then on is answered as soon as the server is up.
+                HANDLE hWait[2] = { hReadyEvent, pi.hProcess };
+                DWORD wait = WaitForMultipleObjects(2, hWait, FALSE, 120000);
+                CloseHandle(hReadyEvent);
+                if (wait != WAIT_OBJECT_0)
+                {
+                    TerminateProcess(pi.hProcess, (DWORD)-1);
+                    throw std::runtime_error("Connection to server failed");
+                }
+
                 if (DisplayNbr==-1)
                 {
-                  // Wait maximum 10 seconds
-                  int Count=1000;
-                  while (-1==*pDisplayfd)
-                  {
-                    if (Count-- < 0)
-                      throw std::runtime_error("Connection to server failed");
-                    Sleep(10);
-                  }
+                  // VCXsrv stored the display number before signalling
                   std::stringstream ss;
                   ss<<*pDisplayfd;
                   display_id = ":" + ss.str();
@@ -831,14 +852,6 @@ class CMyWizard : public CWizard
                 // Set DISPLAY variable
                 _putenv(display.c_str());
 
-                // Wait for server to startup
-                dpy = WaitForServer(pi.hProcess);
-                if (dpy == NULL)
-                {
-                    TerminateProcess(pi.hProcess, (DWORD)-1);
-                    throw std::runtime_error("Connection to server failed");
-                }
-
 #ifdef _DEBUG
                 printf("%s\n", client.c_str());
 #endif
@@ -871,15 +884,15 @@ class CMyWizard : public CWizard
                 if (!CreatePipe(&hChildStdinRd, &hChildStdinWr, &saAttr, 0))
                   throw win32_error("CreatePipe failed", GetLastError());
 
-                // Ensure the write handle to the pipe for STDIN is not inherited. 
-                if ( ! SetHandleInformation(hChildStdinWr, HANDLE_FLAG_INHERIT, 0) )
+                // Ensure the write handle to the pipe for STDIN is not inherited. 
+                if ( ! SetHandleInformation(hChildStdinWr, HANDLE_FLAG_INHERIT, 0) )
                   throw win32_error("SetHandleInformation failed", GetLastError());
 
                 if (!CreatePipe(&hChildStdoutRd, &hChildStdoutWr, &saAttr, 0))
                   throw win32_error("CreatePipe failed", GetLastError());
 
-                // Ensure the read handle to the pipe for STDOUT is not inherited. 
-                if ( ! SetHandleInformation(hChildStdoutRd, HANDLE_FLAG_INHERIT, 0) )
+                // Ensure the read handle to the pipe for STDOUT is not inherited. 
+                if ( ! SetHandleInformation(hChildStdoutRd, HANDLE_FLAG_INHERIT, 0) )
                   throw win32_error("SetHandleInformation failed", GetLastError());
 
                 sic.dwFlags = STARTF_USESTDHANDLES;
@@ -897,6 +910,16 @@ class CMyWizard : public CWizard
                 CloseHandle(hChildStdoutWr);
                 CloseHandle(pic.hThread);
 
+                // Hold a connection while the server finishes starting up,
+                // so it does not reset between clients
+                dpy = WaitForServer(pi.hProcess);
+                if (dpy == NULL)
+                {
+                    TerminateProcess(pic.hProcess, (DWORD)-1);
+                    TerminateProcess(pi.hProcess, (DWORD)-1);
+                    throw std::runtime_error("Connection to server failed");
+                }
+
                 int hStdIn = _open_osfhandle((intptr_t)hChildStdinWr, _O_WRONLY|_O_BINARY);
                 int hStdOut = _open_osfhandle((intptr_t)hChildStdoutRd, _O_RDONLY|_O_BINARY);
                 HANDLE hConsoleInput=GetStdHandle(STD_INPUT_HANDLE);
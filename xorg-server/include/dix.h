@@ -173,6 +173,23 @@ extern _X_EXPORT void SetInputCheck(HWEventQueuePtr /*c0 */ ,
 
 extern _X_EXPORT void CloseDownClient(ClientPtr /*client */ );
 
+extern _X_EXPORT void DispatchProfileRequest(ClientPtr /*client */ ,
+                                             int /*major */ ,
+                                             int /*minor */ ,
+                                             int /*bytes */ ,
+                                             CARD64 /*us */ );
+
+extern _X_EXPORT void DispatchProfileOutput(ClientPtr /*client */ ,
+                                            int /*bytes */ );
+
+extern _X_EXPORT void DispatchProfileSchedule(ClientPtr /*client */ ,
+                                              Bool /*input */ ,
+                                              long /*wait */ );
+
+extern _X_EXPORT void DispatchProfileClientGone(ClientPtr /*client */ );
+
+extern _X_EXPORT void DispatchProfileReport(void);
+
 extern _X_EXPORT void UpdateCurrentTime(void);
 
 extern _X_EXPORT void UpdateCurrentTimeIf(void);
@@ -196,6 +213,13 @@ extern _X_EXPORT void MarkClientException(ClientPtr /*client */ );
 
 extern _X_HIDDEN Bool CreateConnectionBlock(void);
 
+extern _X_EXPORT void InvalidateConnSetupCache(void);
+
+extern _X_EXPORT int DoPutImage(ClientPtr /*client */ ,
+                                struct _PutImageReq * /*stuff */ ,
+                                char * /*data */ ,
+                                long /*size */ );
+
 /* dixutils.c */
 
 extern _X_EXPORT int CompareISOLatin1Lowered(const unsigned char * /*a */ ,
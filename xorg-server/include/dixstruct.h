@@ -107,6 +107,12 @@ typedef struct _Client {
 
     int smart_start_tick;
     int smart_stop_tick;
+    int smart_input_tick;       /* input delivered, not yet scheduled */
+    Bool smart_input_pending;
+
+    /* reported through X-Resource */
+    CARD32 requestCount;        /* requests dispatched */
+    CARD64 dispatchTime;        /* microseconds spent running them */
 
     DeviceIntPtr clientPtr;
     ClientIdPtr clientIds;
@@ -127,6 +133,7 @@ extern long SmartScheduleTime;
 extern long SmartScheduleInterval;
 extern long SmartScheduleSlice;
 extern long SmartScheduleMaxSlice;
+extern Bool SmartScheduleInteractive;
 #ifdef HAVE_SETITIMER
 extern Bool SmartScheduleSignalEnable;
 #else
@@ -179,6 +186,8 @@ static inline Bool any_output_pending(void) {
 
 extern void SmartScheduleInit(void);
 
+extern void SmartScheduleInput(ClientPtr /* client */);
+
 /* This prototype is used pervasively in Xext, dix */
 #define DISPATCH_PROC(func) int func(ClientPtr /* client */)
 
@@ -212,6 +212,12 @@ extern int
                     Mask /* mask */ ,
                     int /* mskidx */ );
 
+#define XIPropagateMask (KeyPressMask | \
+                         KeyReleaseMask | \
+                         ButtonPressMask | \
+                         ButtonReleaseMask | \
+                         PointerMotionMask)
+
 extern void
  RecalculateDeviceDeliverableEvents(WindowPtr /* pWin */ );
 
@@ -84,6 +84,10 @@ typedef struct {
     InitExtension initFunc;
     const char *name;
     Bool *disablePtr;
+    /* register at startup, initialise on first use (AddDeferredExtension) */
+    Bool deferred;
+    int numEvents;
+    int numErrors;
 } ExtensionModule;
 
 extern _X_EXPORT unsigned short StandardMinorOpcode(ClientPtr /*client */ );
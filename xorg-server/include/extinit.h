@@ -120,6 +120,9 @@ extern void SyncExtensionInit(void);
 
 extern void XCMiscExtensionInit(void);
 
+extern _X_EXPORT Bool noImageCacheExtension;
+extern void ImageCacheExtensionInit(void);
+
 #ifdef XCSECURITY
 extern _X_EXPORT Bool noSecurityExtension;
 extern void SecurityExtensionInit(void);
@@ -68,6 +68,7 @@ typedef struct _ExtensionEntry {
     unsigned short (*MinorOpcode) (     /* called for errors */
                                       ClientPtr /* client */ );
     PrivateRec *devPrivates;
+    InitExtension deferredInit; /* set until a deferred extension is used */
 } ExtensionEntry;
 
 /*
@@ -93,6 +94,12 @@ AddExtension(const char * /*name */ ,
              unsigned short (* /*MinorOpcodeProc */ )(ClientPtr /*client */ )
     );
 
+extern _X_EXPORT ExtensionEntry *
+AddDeferredExtension(const char * /*name */ ,
+                     int /*NumEvents */ ,
+                     int /*NumErrors */ ,
+                     InitExtension /*initFunc */ );
+
 extern _X_EXPORT ExtensionEntry *
 CheckExtension(const char *extname);
 extern _X_EXPORT ExtensionEntry *
@@ -402,6 +402,12 @@ extern _X_EXPORT void SwapLongs(CARD32 *list, unsigned long count);
 
 extern _X_EXPORT void SwapShorts(short *list, unsigned long count);
 
+extern _X_EXPORT void CopySwapLongs(const CARD32 *from, CARD32 *to,
+                                    unsigned long count);
+
+extern _X_EXPORT void CopySwapShorts(const short *from, short *to,
+                                     unsigned long count);
+
 extern _X_EXPORT void MakePredeclaredAtoms(void);
 
 extern _X_EXPORT int Ones(unsigned long /*mask */ );
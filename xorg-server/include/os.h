@@ -119,9 +119,20 @@ extern _X_EXPORT void FlushIfCriticalOutputPending(void);
 
 extern _X_EXPORT void SetCriticalOutputPending(void);
 
+extern _X_EXPORT void BeginOutputBatch(void);
+
+extern _X_EXPORT void EndOutputBatch(void);
+
+extern _X_EXPORT void *ReserveClientOutput(ClientPtr /*who */ ,
+                                          int /*count */ );
+
 extern _X_EXPORT int WriteToClient(ClientPtr /*who */ , int /*count */ ,
                                    const void * /*buf */ );
 
+extern _X_EXPORT void ClientOutputBytes(ClientPtr /*who */ ,
+                                        unsigned long * /*pending */ ,
+                                        unsigned long * /*size */ );
+
 extern _X_EXPORT void ResetOsBuffers(void);
 
 extern _X_EXPORT int TransIsListening(char *protocol);
@@ -136,6 +147,8 @@ extern _X_EXPORT void CloseWellKnownConnections(void);
 
 extern _X_EXPORT XID AuthorizationIDOfClient(ClientPtr /*client */ );
 
+extern _X_EXPORT const char ClientAuthDeferred[];
+
 extern _X_EXPORT const char *ClientAuthorized(ClientPtr /*client */ ,
                                               unsigned int /*proto_n */ ,
                                               char * /*auth_proto */ ,
@@ -209,6 +222,60 @@ extern _X_EXPORT void TimerCheck(void);
 extern _X_EXPORT void TimerCancel(OsTimerPtr /* pTimer */ );
 extern _X_EXPORT void TimerFree(OsTimerPtr /* pTimer */ );
 
+/*
+ * Caches that can be refilled on demand; lower priorities are trimmed
+ * first when memory is low.  The proc returns the number of bytes it
+ * freed, or 0 if the cache can't tell.
+ */
+typedef unsigned long (*CacheTrimProcPtr) (void *closure);
+
+extern _X_EXPORT void RegisterCacheTrim(const char *name, int priority,
+                                        CacheTrimProcPtr proc, void *closure);
+extern _X_EXPORT void UnregisterCacheTrim(CacheTrimProcPtr proc,
+                                          void *closure);
+extern _X_EXPORT void TrimCaches(Bool untilRelieved);
+
+/*
+ * The server's worker threads.  Interactive work is taken before any
+ * background work, and background work never occupies every worker.
+ * Work items are owned by the caller and must start out zeroed.
+ */
+typedef enum {
+    ThreadPoolInteractive,
+    ThreadPoolBackground,
+    ThreadPoolNumLanes
+} ThreadPoolLane;
+
+typedef void (*ThreadPoolProcPtr) (void *closure);
+
+typedef struct _ThreadPoolWork {
+    struct _ThreadPoolWork *next;
+    ThreadPoolProcPtr proc;
+    void *closure;
+    CARD32 queued;              /* time it was queued */
+    ThreadPoolLane lane;
+    Bool pending;               /* queued and not yet picked up */
+} ThreadPoolWork;
+
+typedef struct _ThreadPoolStats {
+    int queued;                 /* waiting for a worker */
+    int running;
+    int maxQueued;
+    unsigned long done;
+    unsigned long waitMs;       /* total time spent queued by done work */
+    unsigned long maxWaitMs;
+} ThreadPoolStats;
+
+extern _X_EXPORT int threadPoolSize;
+
+extern _X_EXPORT int ThreadPoolThreads(void);
+extern _X_EXPORT Bool ThreadPoolQueue(ThreadPoolWork *work,
+                                      ThreadPoolLane lane,
+                                      ThreadPoolProcPtr proc, void *closure);
+extern _X_EXPORT Bool ThreadPoolCancel(ThreadPoolWork *work);
+extern _X_EXPORT void ThreadPoolGetStats(ThreadPoolLane lane,
+                                         ThreadPoolStats *stats);
+
 extern _X_EXPORT void SetScreenSaverTimer(void);
 extern _X_EXPORT void FreeScreenSaverTimer(void);
 
@@ -251,6 +251,11 @@ extern _X_EXPORT RegionPtr RegionFromRects(int /*nrects */ ,
                                            xRectanglePtr /*prect */ ,
                                            int /*ctype */ );
 
+extern _X_EXPORT Bool RegionSetRects(RegionPtr /*pRgn */ ,
+                                     int /*nrects */ ,
+                                     xRectanglePtr /*prect */ ,
+                                     int /*ctype */ );
+
 /*-
  *-----------------------------------------------------------------------
  * Subtract --
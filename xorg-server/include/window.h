@@ -81,6 +81,8 @@ enum RootClipMode {
 typedef int (*VisitWindowProcPtr) (WindowPtr pWin,
                                    void *data);
 
+extern _X_EXPORT unsigned long WindowTreeSerial;
+
 extern _X_EXPORT int TraverseTree(WindowPtr pWin,
                                   VisitWindowProcPtr func,
                                   void *data);
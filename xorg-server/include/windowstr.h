@@ -86,6 +86,7 @@ typedef struct _WindowOpt {
     struct _OtherClients *otherClients; /* default: NULL */
     struct _GrabRec *passiveGrabs;      /* default: NULL */
     PropertyPtr userProps;      /* default: NULL */
+    struct _PropertyIndex *propIndex;   /* default: NULL */
     CARD32 backingBitPlanes;    /* default: ~0L */
     CARD32 backingPixel;        /* default: 0 */
     RegionPtr boundingShape;    /* default: NULL */
@@ -142,6 +143,8 @@ typedef struct _Window {
     unsigned short borderWidth;
     unsigned long deliverableEvents;   /* all masks from all clients */
     Mask eventMask;             /* mask from the creating client */
+    Mask xiDeliverable;         /* XI masks selected here or above, any device */
+    uint64_t xi2Deliverable;    /* XI2 types selected here or above */
     PixUnion background;
     PixUnion border;
     WindowOptPtr optional;
@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * ETW events from the server, through a TraceLogging provider.
+ *
+ * TraceLogging events describe themselves, so no manifest has to be
+ * registered: any ETW consumer (WPR, PerfView, xperf) can record the
+ * provider by its name, "VcXsrv.XServer", and WPA shows the events next
+ * to DWM and GPU activity.  While no session listens, WinTraceEnabled()
+ * is a single load, so the call sites stay in release builds.
+ *
+ * Where TraceLogging is not available the macros expand to nothing and
+ * their arguments are not evaluated.
+ */
+
+#ifndef WINTRACE_H
+#define WINTRACE_H
+
+#ifdef _MSC_VER
+
+#include <X11/Xwindows.h>
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(WinTraceProvider);
+
+#define WinTraceEnabled() TraceLoggingProviderEnabled(WinTraceProvider, 0, 0)
+
+/* name must be a string literal; the rest are TraceLogging field macros */
+#define WinTrace(name, ...) \
+    TraceLoggingWrite(WinTraceProvider, name, __VA_ARGS__)
+
+/* a pair of these becomes a region in WPA */
+#define WinTraceStart(name, ...) \
+    WinTrace(name, TraceLoggingOpcode(WINEVENT_OPCODE_START), __VA_ARGS__)
+#define WinTraceStop(name, ...) \
+    WinTrace(name, TraceLoggingOpcode(WINEVENT_OPCODE_STOP), __VA_ARGS__)
+
+extern void WinTraceInit(void);
+extern void WinTraceFini(void);
+
+#else
+
+#define WinTraceEnabled() 0
+#define WinTrace(name, ...) do { } while (0)
+#define WinTraceStart(name, ...) do { } while (0)
+#define WinTraceStop(name, ...) do { } while (0)
+#define WinTraceInit() do { } while (0)
+#define WinTraceFini() do { } while (0)
+
+#endif
+
+#endif /* WINTRACE_H */
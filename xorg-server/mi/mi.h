@@ -209,6 +209,8 @@ extern _X_EXPORT void mieqProcessDeviceEvent(DeviceIntPtr /* dev */ ,
 extern _X_EXPORT void mieqProcessInputEvents(void
     );
 
+extern _X_EXPORT void mieqLogStats(void);
+
 extern _X_EXPORT void mieqAddCallbackOnDrained(CallbackProcPtr callback,
                                                void *param);
 
@@ -53,6 +53,7 @@ in this Software without prior written authorization from The Open Group.
 #include   "extinit.h"
 #include   "exglobals.h"
 #include   "eventstr.h"
+#include   "wintrace.h"
 
 #ifdef DPMSExtension
 #include "dpmsproc.h"
@@ -65,6 +66,7 @@ in this Software without prior written authorization from The Open Group.
 #define QUEUE_MAXIMUM_SIZE                4096
 #define QUEUE_DROP_BACKTRACE_FREQUENCY     100
 #define QUEUE_DROP_BACKTRACE_MAX            10
+#define QUEUE_COALESCE_LOOKAHEAD             8
 
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
@@ -83,6 +85,11 @@ typedef struct _EventQueue {
     size_t nevents;             /* the number of buckets in our queue */
     size_t dropped;             /* counter for number of consecutive dropped events */
     mieqHandler handlers[128];  /* custom event handler */
+    /* statistics since the last mieqLogStats() */
+    unsigned long enqueued;
+    unsigned long coalesced;    /* motion events merged or skipped */
+    unsigned long dropped_total;
+    size_t max_depth;
 } EventQueueRec, *EventQueuePtr;
 
 static EventQueueRec miEventQueue;
@@ -216,6 +223,7 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
     if (isMotion && isMotion == miEventQueue.lastMotion &&
         oldtail != miEventQueue.head) {
         oldtail = (oldtail - 1) % miEventQueue.nevents;
+        miEventQueue.coalesced++;
     }
     else if (n_enqueued + 1 == miEventQueue.nevents) {
         if (!mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1)) {
@@ -223,6 +231,7 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
              * stuck in an infinite loop in the main thread.
              */
             miEventQueue.dropped++;
+            miEventQueue.dropped_total++;
             if (miEventQueue.dropped == 1) {
                 ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
                               "discarded until existing events are processed.\n");
@@ -263,8 +272,38 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
     miEventQueue.events[oldtail].pScreen = pDev ? EnqueueScreen(pDev) : NULL;
     miEventQueue.events[oldtail].pDev = pDev;
 
+    WinTrace("InputEnqueue", TraceLoggingInt32(pDev ? pDev->id : -1, "Device"),
+             TraceLoggingUInt8(e->any.type, "Type"),
+             TraceLoggingBoolean(oldtail != miEventQueue.tail, "Coalesced"),
+             TraceLoggingUInt32(e->any.time, "Time"));
+
     miEventQueue.lastMotion = isMotion;
     miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+
+    miEventQueue.enqueued++;
+    n_enqueued = mieqNumEnqueued(&miEventQueue);
+    if (n_enqueued > miEventQueue.max_depth)
+        miEventQueue.max_depth = n_enqueued;
+}
+
+/**
+ * Log the queue statistics gathered since the last call and reset them.
+ */
+void
+mieqLogStats(void)
+{
+    input_lock();
+    LogMessageVerb(X_INFO, 0, "[mi] EQ: %lu events queued, %lu motion events "
+                   "coalesced, %lu dropped, peak depth %lu of %lu\n",
+                   miEventQueue.enqueued, miEventQueue.coalesced,
+                   miEventQueue.dropped_total,
+                   (unsigned long) miEventQueue.max_depth,
+                   (unsigned long) miEventQueue.nevents);
+    miEventQueue.enqueued = 0;
+    miEventQueue.coalesced = 0;
+    miEventQueue.dropped_total = 0;
+    miEventQueue.max_depth = mieqNumEnqueued(&miEventQueue);
+    input_unlock();
 }
 
 /**
@@ -509,6 +548,50 @@ mieqProcessDeviceEvent(DeviceIntPtr dev, InternalEvent *event, ScreenPtr screen)
     }
 }
 
+/**
+ * A motion event that is followed in the queue by another motion event
+ * from the same device, with nothing in between but that device's raw
+ * events, need not be processed: the later one moves the sprite to where
+ * it ends up anyway.  mieqEnqueue() only merges a motion event into the
+ * one directly before it, which never happens for devices that post raw
+ * events, since GetPointerEvents() queues the raw event first.
+ *
+ * The later event must carry every valuator the earlier one does, so that
+ * no axis is left with a stale value.  Pre-condition: Called with
+ * input_lock held, with the event already removed from the queue.
+ */
+static Bool
+mieqMotionSuperseded(const EventRec *e, const InternalEvent *event)
+{
+    const DeviceEvent *ev = &event->device_event;
+    HWEventQueueType i = miEventQueue.head;
+    int n;
+    size_t j;
+
+    if (ev->type != ET_Motion || ev->flags)
+        return FALSE;
+
+    for (n = 0; n < QUEUE_COALESCE_LOOKAHEAD && i != miEventQueue.tail; n++) {
+        const EventRec *next = &miEventQueue.events[i];
+        const DeviceEvent *nev = &next->events->device_event;
+
+        if (next->pDev != e->pDev)
+            return FALSE;
+        if (nev->type == ET_Motion) {
+            if (next->pScreen != e->pScreen || nev->flags)
+                return FALSE;
+            for (j = 0; j < sizeof(ev->valuators.mask); j++)
+                if (ev->valuators.mask[j] & ~nev->valuators.mask[j])
+                    return FALSE;
+            return TRUE;
+        }
+        if (nev->type != ET_RawMotion)
+            return FALSE;
+        i = (i + 1) % miEventQueue.nevents;
+    }
+    return FALSE;
+}
+
 /* Call this from ProcessInputEvents(). */
 void
 mieqProcessInputEvents(void)
@@ -546,6 +629,11 @@ mieqProcessInputEvents(void)
 
         miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
 
+        if (mieqMotionSuperseded(e, &event)) {
+            miEventQueue.coalesced++;
+            continue;
+        }
+
         input_unlock();
 
         master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
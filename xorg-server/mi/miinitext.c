@@ -106,6 +106,13 @@ SOFTWARE.
 
 #include "miinitext.h"
 
+#ifdef XRECORD
+#include <X11/extensions/recordconst.h>
+#endif
+#ifdef XV
+#include <X11/extensions/Xv.h>
+#endif
+
 /* List of built-in (statically linked) extensions */
 static const ExtensionModule staticExtensions[] = {
     {GEExtensionInit, "Generic Event Extension", &noGEExtension},
@@ -133,6 +140,7 @@ static const ExtensionModule staticExtensions[] = {
     {XFree86BigfontExtensionInit, "XFree86-Bigfont", &noXFree86BigfontExtension},
 #endif
     {RenderExtensionInit, "RENDER", &noRenderExtension},
+    {ImageCacheExtensionInit, "IMAGE-CACHE", &noImageCacheExtension},
 #ifdef RANDR
     {RRExtensionInit, "RANDR", &noRRExtension},
 #endif
@@ -149,7 +157,8 @@ static const ExtensionModule staticExtensions[] = {
     {DbeExtensionInit, "DOUBLE-BUFFER", &noDbeExtension},
 #endif
 #ifdef XRECORD
-    {RecordExtensionInit, "RECORD", &noTestExtensions},
+    {RecordExtensionInit, "RECORD", &noTestExtensions,
+     TRUE, RecordNumEvents, RecordNumErrors},
 #endif
 #ifdef DPMSExtension
     {DPMSExtensionInit, "DPMS", &noDPMSExtension},
@@ -164,7 +173,8 @@ static const ExtensionModule staticExtensions[] = {
     {ResExtensionInit, "X-Resource", &noResExtension},
 #endif
 #ifdef XV
-    {XvExtensionInit, "XVideo", &noXvExtension},
+    {XvExtensionInit, "XVideo", &noXvExtension,
+     TRUE, XvNumEvents, XvNumErrors},
     {XvMCExtensionInit, "XVideo-MotionCompensation", &noXvExtension},
 #endif
 #ifdef XSELINUX
@@ -266,6 +276,13 @@ InitExtensions(int argc, char *argv[])
         ext = &ExtensionModuleList[i];
         if (ext->initFunc != NULL &&
             (ext->disablePtr == NULL || !*ext->disablePtr)) {
+            if (ext->deferred) {
+                LogMessageVerb(X_INFO, 3, "Deferring extension %s\n",
+                               ext->name);
+                AddDeferredExtension(ext->name, ext->numEvents,
+                                     ext->numErrors, ext->initFunc);
+                continue;
+            }
             LogMessageVerb(X_INFO, 3, "Initializing extension %s\n",
                            ext->name);
 
@@ -314,5 +331,8 @@ LoadExtensionList(const ExtensionModule ext[], int size, Bool builtin)
         newext->name = ext[i].name;
         newext->initFunc = ext[i].initFunc;
         newext->disablePtr = ext[i].disablePtr;
+        newext->deferred = ext[i].deferred;
+        newext->numEvents = ext[i].numEvents;
+        newext->numErrors = ext[i].numErrors;
     }
 }
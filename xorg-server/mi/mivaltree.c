@@ -177,6 +177,93 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
 				    HasBorder(w) && \
 				    (w)->backgroundState == ParentRelative)
 
+static void miComputeClips(WindowPtr pParent, ScreenPtr pScreen,
+                           RegionPtr universe, VTKind kind, RegionPtr exposed);
+
+/*
+ * Find the box around the parts of a window's borderClip that change from
+ * before to after.  Returns FALSE if the change covers no area.
+ */
+static Bool
+miClipChangeBox(RegionPtr before, RegionPtr after, BoxPtr changed)
+{
+    RegionRec gained, lost;
+    Bool any;
+
+    RegionNull(&gained);
+    RegionNull(&lost);
+    RegionSubtract(&gained, after, before);
+    RegionSubtract(&lost, before, after);
+    any = RegionNotEmpty(&gained) || RegionNotEmpty(&lost);
+    if (!RegionNotEmpty(&gained))
+        *changed = *RegionExtents(&lost);
+    else if (!RegionNotEmpty(&lost))
+        *changed = *RegionExtents(&gained);
+    else {
+        BoxPtr g = RegionExtents(&gained), l = RegionExtents(&lost);
+
+        changed->x1 = min(g->x1, l->x1);
+        changed->y1 = min(g->y1, l->y1);
+        changed->x2 = max(g->x2, l->x2);
+        changed->y2 = max(g->y2, l->y2);
+    }
+    RegionUninit(&gained);
+    RegionUninit(&lost);
+    return any;
+}
+
+/*
+ * The children part of miComputeClips for a window whose own geometry and
+ * that of its inferiors did not change, and whose borderClip changed only
+ * inside the changed box.  Outside that box the old clipList and the old
+ * borderClips of the children are still right, so only the children that
+ * reach into the box are looked at, and only the box is recomputed.
+ *
+ * On entry universe is the window's new clip before children are removed;
+ * on return it is the new clipList.
+ */
+static void
+miComputeChildClipsInBox(WindowPtr pParent, ScreenPtr pScreen,
+                         RegionPtr universe, BoxPtr changed, VTKind kind,
+                         RegionPtr exposed)
+{
+    RegionRec box, childUniverse, inside;
+    WindowPtr pChild;
+
+    if (changed->x1 < changed->x2 && changed->y1 < changed->y2)
+        RegionInit(&box, changed, 1);
+    else
+        RegionNull(&box);
+    RegionNull(&childUniverse);
+    RegionNull(&inside);
+    RegionIntersect(universe, universe, &box);
+
+    for (pChild = pParent->firstChild; pChild; pChild = pChild->nextSib) {
+        Bool reaches;
+
+        if (!pChild->viewable)
+            continue;
+        reaches = RegionContainsRect(&pChild->borderSize, changed) != rgnOUT;
+        if (pChild->valdata) {
+            RegionSubtract(&childUniverse, &pChild->borderClip, &box);
+            if (reaches) {
+                RegionIntersect(&inside, universe, &pChild->borderSize);
+                RegionUnion(&childUniverse, &childUniverse, &inside);
+            }
+            miComputeClips(pChild, pScreen, &childUniverse, kind, exposed);
+        }
+        if (reaches && !TreatAsTransparent(pChild))
+            RegionSubtract(universe, universe, &pChild->borderSize);
+    }
+
+    RegionSubtract(&inside, &pParent->clipList, &box);
+    RegionUnion(universe, universe, &inside);
+
+    RegionUninit(&inside);
+    RegionUninit(&childUniverse);
+    RegionUninit(&box);
+}
+
 /*
  *-----------------------------------------------------------------------
  * miComputeClips --
@@ -206,6 +293,8 @@ miComputeClips(WindowPtr pParent,
     RegionRec childUnion;
     Bool overlap;
     RegionPtr borderVisible;
+    BoxRec changed;
+    Bool inBox = FALSE;
 
     /*
      * Figure out the new visibility of this window.
@@ -350,6 +439,23 @@ miComputeClips(WindowPtr pParent,
     }
 
     borderVisible = pParent->valdata->before.borderVisible;
+
+    /*
+     * A window that stayed put while a sibling or a sibling's ancestor
+     * moved only needs its clips redone where its borderClip changes.
+     */
+    if (kind == VTMove && !dx && !dy && !borderVisible &&
+        pParent->firstChild && pParent->mapped &&
+#ifdef COMPOSITE
+        pParent->redirectDraw == RedirectDrawNone &&
+#endif
+        !RegionBroken(&pParent->borderClip) &&
+        !RegionBroken(&pParent->clipList)) {
+        inBox = TRUE;
+        if (!miClipChangeBox(&pParent->borderClip, universe, &changed))
+            changed.x1 = changed.y1 = changed.x2 = changed.y2 = 0;
+    }
+
     RegionNull(&pParent->valdata->after.borderExposed);
     RegionNull(&pParent->valdata->after.exposed);
 
@@ -395,7 +501,11 @@ miComputeClips(WindowPtr pParent,
     else
         RegionCopy(&pParent->borderClip, universe);
 
-    if ((pChild = pParent->firstChild) && pParent->mapped) {
+    if (inBox) {
+        miComputeChildClipsInBox(pParent, pScreen, universe, &changed, kind,
+                                 exposed);
+    }
+    else if ((pChild = pParent->firstChild) && pParent->mapped) {
         RegionNull(&childUniverse);
         RegionNull(&childUnion);
         if ((pChild->drawable.y < pParent->lastChild->drawable.y) ||
@@ -746,15 +746,12 @@ miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure)
     }
 }
 
-WindowPtr
-miSpriteTrace(SpritePtr pSprite, int x, int y)
+static Bool
+miSpriteHit(WindowPtr pWin, int x, int y)
 {
-    WindowPtr pWin;
     BoxRec box;
 
-    pWin = DeepestSpriteWin(pSprite)->firstChild;
-    while (pWin) {
-        if ((pWin->mapped) &&
+    return ((pWin->mapped) &&
             (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
             (x < pWin->drawable.x + (int) pWin->drawable.width +
              wBorderWidth(pWin)) &&
@@ -774,18 +771,203 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
              * they're in X's stack. (E.g. if the native window system
              * implements some form of virtual desktop system).
              */
-            && !pWin->unhittable) {
-            if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
-                pSprite->spriteTraceSize += 10;
-                pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
-                                                    pSprite->spriteTraceSize,
-                                                    sizeof(WindowPtr));
-            }
-            pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
-            pWin = pWin->firstChild;
+            && !pWin->unhittable);
+}
+
+/*
+ * Windows with many children get a grid over their mapped children's
+ * border boxes, so finding the child under the pointer only tests the
+ * children overlapping one cell, still in stacking order.  Indexes are
+ * built for the few parents most recently found to have long child lists,
+ * and are good until WindowTreeSerial changes.
+ */
+#define PICK_MIN_CHILDREN       32      /* walks shorter than this are cheap */
+#define PICK_GRID               16      /* cells along each side */
+#define PICK_MAX_ENTRIES        8       /* cells per child, on average */
+#define PICK_CACHE_SIZE         4
+
+typedef struct {
+    WindowPtr parent;
+    unsigned long serial;
+    unsigned long lastUsed;
+    Bool useful;                /* FALSE if children overlap too much */
+    struct {
+        int x1, y1, x2, y2;
+    } bounds;                   /* of all the children */
+    int cellWidth, cellHeight;
+    int start[PICK_GRID * PICK_GRID + 1];   /* cell -> first candidate */
+    WindowPtr *candidates;
+    int candidatesSize;
+} miPickIndexRec, *miPickIndexPtr;
+
+static miPickIndexRec miPickCache[PICK_CACHE_SIZE];
+static unsigned long miPickClock;
+
+static miPickIndexPtr
+miPickIndexFind(WindowPtr pParent)
+{
+    int i;
+
+    for (i = 0; i < PICK_CACHE_SIZE; i++) {
+        miPickIndexPtr index = &miPickCache[i];
+
+        if (index->parent == pParent && index->serial == WindowTreeSerial) {
+            index->lastUsed = ++miPickClock;
+            return index;
         }
-        else
-            pWin = pWin->nextSib;
+    }
+    return NULL;
+}
+
+static void
+miPickCells(miPickIndexPtr index, WindowPtr pWin, int *cx1, int *cy1,
+            int *cx2, int *cy2)
+{
+    int bw = wBorderWidth(pWin);
+
+    *cx1 = (pWin->drawable.x - bw - index->bounds.x1) / index->cellWidth;
+    *cy1 = (pWin->drawable.y - bw - index->bounds.y1) / index->cellHeight;
+    *cx2 = (pWin->drawable.x + (int) pWin->drawable.width + bw - 1 -
+            index->bounds.x1) / index->cellWidth;
+    *cy2 = (pWin->drawable.y + (int) pWin->drawable.height + bw - 1 -
+            index->bounds.y1) / index->cellHeight;
+}
+
+static void
+miPickIndexBuild(WindowPtr pParent)
+{
+    miPickIndexPtr index = &miPickCache[0];
+    WindowPtr pWin;
+    int i, cx, cy, cx1, cy1, cx2, cy2, nchildren = 0, total;
+
+    for (i = 1; i < PICK_CACHE_SIZE; i++)
+        if (miPickCache[i].lastUsed < index->lastUsed)
+            index = &miPickCache[i];
+    index->parent = pParent;
+    index->serial = WindowTreeSerial;
+    index->lastUsed = ++miPickClock;
+    index->useful = FALSE;
+
+    for (pWin = pParent->firstChild; pWin; pWin = pWin->nextSib) {
+        int bw = wBorderWidth(pWin);
+        int x1 = pWin->drawable.x - bw, y1 = pWin->drawable.y - bw;
+        int x2 = pWin->drawable.x + (int) pWin->drawable.width + bw;
+        int y2 = pWin->drawable.y + (int) pWin->drawable.height + bw;
+
+        if (!pWin->mapped)
+            continue;
+        if (!nchildren++) {
+            index->bounds.x1 = x1;
+            index->bounds.y1 = y1;
+            index->bounds.x2 = x2;
+            index->bounds.y2 = y2;
+            continue;
+        }
+        index->bounds.x1 = min(index->bounds.x1, x1);
+        index->bounds.y1 = min(index->bounds.y1, y1);
+        index->bounds.x2 = max(index->bounds.x2, x2);
+        index->bounds.y2 = max(index->bounds.y2, y2);
+    }
+    if (!nchildren) {
+        index->bounds.x1 = index->bounds.x2 = 0;
+        index->bounds.y1 = index->bounds.y2 = 0;
+        index->cellWidth = index->cellHeight = 1;
+        index->useful = TRUE;
+        return;
+    }
+    index->cellWidth = (index->bounds.x2 - index->bounds.x1 + PICK_GRID - 1) /
+        PICK_GRID;
+    index->cellHeight = (index->bounds.y2 - index->bounds.y1 + PICK_GRID - 1) /
+        PICK_GRID;
+
+    /* count the candidates of each cell, then lay the cells out */
+    memset(index->start, 0, sizeof(index->start));
+    total = 0;
+    for (pWin = pParent->firstChild; pWin; pWin = pWin->nextSib) {
+        if (!pWin->mapped)
+            continue;
+        miPickCells(index, pWin, &cx1, &cy1, &cx2, &cy2);
+        for (cy = cy1; cy <= cy2; cy++)
+            for (cx = cx1; cx <= cx2; cx++)
+                index->start[cy * PICK_GRID + cx + 1]++;
+        total += (cx2 - cx1 + 1) * (cy2 - cy1 + 1);
+    }
+    if (total > PICK_MAX_ENTRIES * nchildren)
+        return;
+    if (total > index->candidatesSize) {
+        WindowPtr *candidates = reallocarray(index->candidates, total,
+                                             sizeof(WindowPtr));
+
+        if (!candidates)
+            return;
+        index->candidates = candidates;
+        index->candidatesSize = total;
+    }
+    for (i = 0; i < PICK_GRID * PICK_GRID; i++)
+        index->start[i + 1] += index->start[i];
+
+    /* fill each cell top to bottom, using start[cell] as the cursor; the
+     * cursors end up where the next cells begin, so shift them back */
+    for (pWin = pParent->firstChild; pWin; pWin = pWin->nextSib) {
+        if (!pWin->mapped)
+            continue;
+        miPickCells(index, pWin, &cx1, &cy1, &cx2, &cy2);
+        for (cy = cy1; cy <= cy2; cy++)
+            for (cx = cx1; cx <= cx2; cx++)
+                index->candidates[index->start[cy * PICK_GRID + cx]++] = pWin;
+    }
+    for (i = PICK_GRID * PICK_GRID; i > 0; i--)
+        index->start[i] = index->start[i - 1];
+    index->start[0] = 0;
+    index->useful = TRUE;
+}
+
+static WindowPtr
+miPickIndexHit(miPickIndexPtr index, int x, int y)
+{
+    int cell, i;
+
+    if (x < index->bounds.x1 || x >= index->bounds.x2 ||
+        y < index->bounds.y1 || y >= index->bounds.y2)
+        return NULL;
+    cell = ((y - index->bounds.y1) / index->cellHeight) * PICK_GRID +
+        (x - index->bounds.x1) / index->cellWidth;
+    for (i = index->start[cell]; i < index->start[cell + 1]; i++)
+        if (miSpriteHit(index->candidates[i], x, y))
+            return index->candidates[i];
+    return NULL;
+}
+
+WindowPtr
+miSpriteTrace(SpritePtr pSprite, int x, int y)
+{
+    WindowPtr pParent, pWin;
+    miPickIndexPtr index;
+    int n;
+
+    for (;;) {
+        pParent = DeepestSpriteWin(pSprite);
+        index = miPickIndexFind(pParent);
+        if (index && index->useful)
+            pWin = miPickIndexHit(index, x, y);
+        else {
+            n = 0;
+            for (pWin = pParent->firstChild; pWin; pWin = pWin->nextSib, n++)
+                if (miSpriteHit(pWin, x, y))
+                    break;
+            if (!index && n >= PICK_MIN_CHILDREN)
+                miPickIndexBuild(pParent);
+        }
+        if (!pWin)
+            break;
+
+        if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
+            pSprite->spriteTraceSize += 10;
+            pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
+                                                pSprite->spriteTraceSize,
+                                                sizeof(WindowPtr));
+        }
+        pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
     }
     return DeepestSpriteWin(pSprite);
 }
@@ -121,6 +121,83 @@ getDrawableDamageRef(DrawablePtr pDrawable)
     DamagePtr	*pPrev = (DamagePtr *) \
 	dixLookupPrivateAddr(&(pWindow)->devPrivates, damageWinPrivateKey)
 
+/*
+ * Damage without a report function is only looked at when somebody asks
+ * for DamageRegion, typically once per frame by shadow.  Clients doing
+ * lots of tiny operations would make every one of them pay for a union
+ * into a region of thousands of rectangles, so their boxes are collected
+ * raw and merged in one go when the region is needed or the buffer fills.
+ */
+#define DAMAGE_RAW_BOXES    256
+
+static void
+damageCapRects(DamagePtr pDamage)
+{
+    if (pDamage->maxRects &&
+        RegionNumRects(&pDamage->damage) > pDamage->maxRects) {
+        BoxRec extents = *RegionExtents(&pDamage->damage);
+
+        RegionReset(&pDamage->damage, &extents);
+    }
+}
+
+static void
+damageFlushRawBoxes(DamagePtr pDamage)
+{
+    RegionRec raw;
+
+    if (!pDamage->nRawBoxes)
+        return;
+
+    if (!RegionInitBoxes(&raw, pDamage->rawBoxes, pDamage->nRawBoxes)) {
+        /* Out of memory sorting them out; their extents will do */
+        BoxRec extents = pDamage->rawBoxes[0];
+        int i;
+
+        for (i = 1; i < pDamage->nRawBoxes; i++) {
+            BoxPtr pBox = &pDamage->rawBoxes[i];
+
+            extents.x1 = min(extents.x1, pBox->x1);
+            extents.y1 = min(extents.y1, pBox->y1);
+            extents.x2 = max(extents.x2, pBox->x2);
+            extents.y2 = max(extents.y2, pBox->y2);
+        }
+        RegionInit(&raw, &extents, 1);
+    }
+    RegionUnion(&pDamage->damage, &pDamage->damage, &raw);
+    RegionUninit(&raw);
+    pDamage->nRawBoxes = 0;
+    damageCapRects(pDamage);
+}
+
+static void
+damageAccumulate(DamagePtr pDamage, RegionPtr pRegion)
+{
+    int n = RegionNumRects(pRegion);
+
+    if (!pDamage->rawBoxes) {
+        pDamage->rawBoxes = xallocarray(DAMAGE_RAW_BOXES, sizeof(BoxRec));
+        if (!pDamage->rawBoxes) {
+            RegionUnion(&pDamage->damage, &pDamage->damage, pRegion);
+            damageCapRects(pDamage);
+            return;
+        }
+    }
+
+    if (pDamage->nRawBoxes + n > DAMAGE_RAW_BOXES) {
+        damageFlushRawBoxes(pDamage);
+        if (n > DAMAGE_RAW_BOXES) {
+            RegionUnion(&pDamage->damage, &pDamage->damage, pRegion);
+            damageCapRects(pDamage);
+            return;
+        }
+    }
+
+    memcpy(pDamage->rawBoxes + pDamage->nRawBoxes, RegionRects(pRegion),
+           n * sizeof(BoxRec));
+    pDamage->nRawBoxes += n;
+}
+
 #if DAMAGE_DEBUG_ENABLE
 static void
 _damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
@@ -265,7 +342,7 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, pDamageRegion);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+                damageAccumulate(pDamage, pDamageRegion);
         }
 
         /*
@@ -293,8 +370,7 @@ damageRegionProcessPending(DrawablePtr pDrawable)
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, &pDamage->pendingDamage);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage,
-                            &pDamage->pendingDamage);
+                damageAccumulate(pDamage, &pDamage->pendingDamage);
         }
 
         if (pDamage->reportAfter)
@@ -1889,6 +1965,7 @@ DamageDestroy(DamagePtr pDamage)
     (*pScrPriv->funcs.Destroy) (pDamage);
     RegionUninit(&pDamage->damage);
     RegionUninit(&pDamage->pendingDamage);
+    free(pDamage->rawBoxes);
     free(pDamage);
 }
 
@@ -1899,6 +1976,7 @@ DamageSubtract(DamagePtr pDamage, const RegionPtr pRegion)
     RegionRec pixmapClip;
     DrawablePtr pDrawable = pDamage->pDrawable;
 
+    damageFlushRawBoxes(pDamage);
     RegionSubtract(&pDamage->damage, &pDamage->damage, pRegion);
     if (pDrawable) {
         if (pDrawable->type == DRAWABLE_WINDOW)
@@ -1926,11 +2004,13 @@ void
 DamageEmpty(DamagePtr pDamage)
 {
     RegionEmpty(&pDamage->damage);
+    pDamage->nRawBoxes = 0;
 }
 
 RegionPtr
 DamageRegion(DamagePtr pDamage)
 {
+    damageFlushRawBoxes(pDamage);
     return &pDamage->damage;
 }
 
@@ -1971,6 +2051,18 @@ DamageSetReportAfterOp(DamagePtr pDamage, Bool reportAfter)
     pDamage->reportAfter = reportAfter;
 }
 
+/*
+ * Once the accumulated damage has more than maxRects rectangles it is
+ * replaced by its extents; 0, the default, never collapses it.  Useful
+ * for consumers that pay per rectangle more than per pixel.
+ */
+void
+DamageSetMaxRects(DamagePtr pDamage, int maxRects)
+{
+    pDamage->maxRects = maxRects;
+    damageCapRects(pDamage);
+}
+
 DamageScreenFuncsPtr
 DamageGetScreenFuncs(ScreenPtr pScreen)
 {
@@ -49,6 +49,11 @@ typedef struct _damage {
     Bool reportAfter;
     RegionRec pendingDamage;    /* will be flushed post submission at the latest */
     ScreenPtr pScreen;
+
+    /* Boxes not yet merged into damage; only used without damageReport */
+    BoxPtr rawBoxes;
+    int nRawBoxes;
+    int maxRects;               /* collapse damage to its extents beyond this */
 } DamageRec;
 
 typedef struct _damageScrPriv {
@@ -52,6 +52,9 @@ static DevPrivateKeyRec shadowScrPrivateKeyRec;
     real->mem = priv->mem; \
 }
 
+/* Updates cost per rectangle; past this many, copy the bounding box */
+#define SHADOW_MAX_DAMAGE_RECTS 256
+
 static void
 shadowRedisplay(ScreenPtr pScreen)
 {
@@ -132,6 +135,7 @@ shadowSetup(ScreenPtr pScreen)
         free(pBuf);
         return FALSE;
     }
+    DamageSetMaxRects(pBuf->pDamage, SHADOW_MAX_DAMAGE_RECTS);
 
     wrap(pBuf, pScreen, CloseScreen);
     wrap(pBuf, pScreen, GetImage);
@@ -31,6 +31,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #include    <X11/X.h>
 #include    "scrnintstr.h"
@@ -176,6 +177,22 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
                     ("   |   |   |-> Writing Line - Metrics: win=%x, sha=%x\n",
                      win, sha);
 #endif
+#if !defined(ROTATE) || ROTATE == 0
+                /* Unrotated rows are contiguous on both sides */
+                memcpy(win, sha, i * sizeof(Data));
+                win += i;
+                sha += i;
+#else
+                /* Four independent loads per step keep the strided
+                 * reads of a 90/270 rotation in flight together */
+                for (; i >= 4; i -= 4) {
+                    win[0] = sha[0];
+                    win[1] = sha[SHASTEPX(shaStride)];
+                    win[2] = sha[2 * SHASTEPX(shaStride)];
+                    win[3] = sha[3 * SHASTEPX(shaStride)];
+                    win += 4;
+                    sha += 4 * SHASTEPX(shaStride);
+                }
                 while (i--) {
 #if(DANDEBUG > 6)
                     ErrorF
@@ -185,6 +202,7 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
                     *win++ = *sha;
                     sha += SHASTEPX(shaStride);
                 }               /*  i */
+#endif
             }                   /*  width */
             shaLine += SHASTEPY(shaStride);
             NEXTY(x, y, w, h);
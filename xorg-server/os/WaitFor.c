@@ -72,6 +72,7 @@ SOFTWARE.
 #include "dpmsproc.h"
 #endif
 #include "busfault.h"
+#include "wintrace.h"
 
 #ifdef WIN32
 /* Error codes from windows sockets differ from fileio error codes  */
@@ -95,7 +96,8 @@ SOFTWARE.
 #endif
 
 struct _OsTimerRec {
-    struct xorg_list list;
+    int index;                  /* position in timer_heap, 0 if not pending */
+    CARD32 seq;                 /* orders timers with equal expiry */
     CARD32 expires;
     CARD32 delta;
     OsTimerCallback callback;
@@ -105,15 +107,107 @@ struct _OsTimerRec {
 static void DoTimer(OsTimerPtr timer, CARD32 now);
 static void DoTimers(CARD32 now);
 static void CheckAllTimers(void);
-static volatile struct xorg_list timers;
+
+/*
+ * Pending timers live in a binary min-heap ordered by expiry, so setting
+ * and cancelling a timer is O(log n) however many are active.  The heap
+ * is 1-based: timer_heap[1] expires first and index 0 means not pending.
+ */
+static OsTimerPtr *timer_heap;
+static int timer_count, timer_size;
+static CARD32 timer_seq;
+
+/*
+ * Relative timers may fire up to 1/64 of their delay late, at most 64ms,
+ * rounded to a power of two grid; timers landing on the same grid point
+ * wake the server once.  Short timers, such as fake vblank, are exact.
+ */
+#define TIMER_SLACK_SHIFT 6
+#define TIMER_SLACK_MAX 64
+
+static inline Bool
+timer_before(OsTimerPtr a, OsTimerPtr b)
+{
+    int diff = (int) (a->expires - b->expires);
+
+    if (diff)
+        return diff < 0;
+    return (int) (a->seq - b->seq) < 0;
+}
+
+static inline void
+timer_heap_place(OsTimerPtr timer, int i)
+{
+    timer_heap[i] = timer;
+    timer->index = i;
+}
+
+static void
+timer_heap_up(OsTimerPtr timer, int i)
+{
+    while (i > 1 && timer_before(timer, timer_heap[i >> 1])) {
+        timer_heap_place(timer_heap[i >> 1], i);
+        i >>= 1;
+    }
+    timer_heap_place(timer, i);
+}
+
+static void
+timer_heap_down(OsTimerPtr timer, int i)
+{
+    int child;
+
+    while ((child = i << 1) <= timer_count) {
+        if (child < timer_count &&
+            timer_before(timer_heap[child + 1], timer_heap[child]))
+            child++;
+        if (!timer_before(timer_heap[child], timer))
+            break;
+        timer_heap_place(timer_heap[child], i);
+        i = child;
+    }
+    timer_heap_place(timer, i);
+}
+
+static Bool
+timer_heap_insert(OsTimerPtr timer)
+{
+    if (timer_count + 1 >= timer_size) {
+        int size = timer_size ? timer_size * 2 : 32;
+        OsTimerPtr *heap = reallocarray(timer_heap, size, sizeof(OsTimerPtr));
+
+        if (!heap)
+            return FALSE;
+        timer_heap = heap;
+        timer_size = size;
+    }
+    timer->seq = timer_seq++;
+    timer_heap_up(timer, ++timer_count);
+    return TRUE;
+}
+
+static void
+timer_heap_remove(OsTimerPtr timer)
+{
+    int i = timer->index;
+    OsTimerPtr last;
+
+    if (!i)
+        return;
+    timer->index = 0;
+    last = timer_heap[timer_count--];
+    if (last == timer)
+        return;
+    if (i > 1 && timer_before(last, timer_heap[i >> 1]))
+        timer_heap_up(last, i);
+    else
+        timer_heap_down(last, i);
+}
 
 static inline OsTimerPtr
 first_timer(void)
 {
-    /* inline xorg_list_is_empty which can't handle volatile */
-    if (timers.next == &timers)
-        return NULL;
-    return xorg_list_first_entry(&timers, struct _OsTimerRec, list);
+    return timer_count ? timer_heap[1] : NULL;
 }
 
 /*
@@ -201,10 +295,10 @@ WaitForSomething(Bool are_ready)
         /* keep this check close to select() call to minimize race */
         if (dispatchException)
             i = -1;
-        else
-        {
-            if (!timeout) timeout=10; /* Avoid a 100 % usage loop, timeout is in milliseconds */
+        else {
+            WinTraceStart("Wait", TraceLoggingInt32(timeout, "Timeout"));
             i = ospoll_wait(server_poll, timeout);
+            WinTraceStop("Wait", TraceLoggingInt32(i, "Ready"));
         }
         pollerr = GetErrno();
         if (i <= 0) {           /* An error or timeout occurred */
@@ -328,22 +422,24 @@ AdjustWaitForDelay(void *waitTime, int newdelay)
 }
 
 static inline Bool timer_pending(OsTimerPtr timer) {
-    return !xorg_list_is_empty(&timer->list);
+    return timer->index != 0;
 }
 
 /* If time has rewound, re-run every affected timer.
- * Timers might drop out of the list, so we have to restart every time. */
+ * Timers might move in the heap, so we have to restart every time. */
 static void
 CheckAllTimers(void)
 {
     OsTimerPtr timer;
     CARD32 now;
+    int i;
 
     input_lock();
  start:
     now = GetTimeInMillis();
 
-    xorg_list_for_each_entry(timer, &timers, list) {
+    for (i = 1; i <= timer_count; i++) {
+        timer = timer_heap[i];
         if (timer->expires - now > timer->delta + 250) {
             DoTimer(timer, now);
             goto start;
@@ -357,7 +453,7 @@ DoTimer(OsTimerPtr timer, CARD32 now)
 {
     CARD32 newTime;
 
-    xorg_list_del(&timer->list);
+    timer_heap_remove(timer);
     newTime = (*timer->callback) (timer, now, timer->arg);
     if (newTime)
         TimerSet(timer, 0, newTime, timer->callback, timer->arg);
@@ -381,19 +477,19 @@ OsTimerPtr
 TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
          OsTimerCallback func, void *arg)
 {
-    OsTimerPtr existing;
     CARD32 now = GetTimeInMillis();
+    Bool allocated = FALSE;
 
     if (!timer) {
         timer = calloc(1, sizeof(struct _OsTimerRec));
         if (!timer)
             return NULL;
-        xorg_list_init(&timer->list);
+        allocated = TRUE;
     }
     else {
         input_lock();
         if (timer_pending(timer)) {
-            xorg_list_del(&timer->list);
+            timer_heap_remove(timer);
             if (flags & TimerForceOld)
                 (void) (*timer->callback) (timer, now, timer->arg);
         }
@@ -405,20 +501,32 @@ TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
         timer->delta = millis - now;
     }
     else {
+        CARD32 slack = millis >> TIMER_SLACK_SHIFT;
+
         timer->delta = millis;
         millis += now;
+        if (slack) {
+            CARD32 grid = 1;
+
+            while (grid << 1 <= slack && grid < TIMER_SLACK_MAX)
+                grid <<= 1;
+            millis = (millis + grid - 1) & ~(grid - 1);
+        }
     }
     timer->expires = millis;
     timer->callback = func;
     timer->arg = arg;
     input_lock();
 
-    /* Sort into list */
-    xorg_list_for_each_entry(existing, &timers, list)
-        if ((int) (existing->expires - millis) > 0)
-            break;
-    /* This even works at the end of the list -- existing->list will be timers */
-    xorg_list_append(&timer->list, &existing->list);
+    if (!timer_heap_insert(timer)) {
+        input_unlock();
+        ErrorF("TimerSet: cannot grow the timer queue\n");
+        if (allocated) {
+            free(timer);
+            return NULL;
+        }
+        return timer;
+    }
 
     /* Check to see if the timer is ready to run now */
     if ((int) (millis - now) <= 0)
@@ -447,7 +555,7 @@ TimerCancel(OsTimerPtr timer)
     if (!timer)
         return;
     input_lock();
-    xorg_list_del(&timer->list);
+    timer_heap_remove(timer);
     input_unlock();
 }
 
@@ -469,16 +577,10 @@ TimerCheck(void)
 void
 TimerInit(void)
 {
-    static Bool been_here;
-    OsTimerPtr timer, tmp;
-
-    if (!been_here) {
-        been_here = TRUE;
-        xorg_list_init((struct xorg_list*) &timers);
-    }
+    while (timer_count) {
+        OsTimerPtr timer = timer_heap[timer_count--];
 
-    xorg_list_for_each_entry_safe(timer, tmp, &timers, list) {
-        xorg_list_del(&timer->list);
+        timer->index = 0;
         free(timer);
     }
 }
@@ -574,6 +676,13 @@ FreeScreenSaverTimer(void)
     }
 }
 
+/*
+ * Arm the timer for the earliest screen saver or DPMS timeout.  Input
+ * events only record their time in lastDeviceEventTime; the timer
+ * measures the idle time itself when it fires and re-arms for whatever
+ * is left, so this only needs calling when the timeouts change or the
+ * screen wakes up, never per event.
+ */
 void
 SetScreenSaverTimer(void)
 {
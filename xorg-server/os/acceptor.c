@@ -0,0 +1,350 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Connection setup reads off the dispatch thread.
+ *
+ * A new connection used to become a client as soon as it was accepted, and
+ * the dispatch loop then read the connection prefix and authorization data
+ * like any other request.  A peer sending its prefix a few bytes at a time,
+ * a TLS handshake or a slow link all cost dispatch wakeups (and, for TLS,
+ * the handshake's public key operations) before the client could even be
+ * authorized.  AcceptorQueue() instead hands the accepted connection to a
+ * worker thread, which drives the transport handshake and reads the
+ * xConnClientPrefix with the padded authorization name and data.  Once all
+ * of it is in, the connection is queued back to the dispatch thread, whose
+ * wakeup handler creates the client with those bytes already buffered, so
+ * InitialConnection and EstablishConnection run without waiting again.
+ *
+ * Authorization itself stays on the dispatch thread: the authorization and
+ * host tables belong to it, and checking a cookie costs microseconds once
+ * the data is in.
+ *
+ * Connections that do not complete their setup within ACCEPT_TIMEOUT are
+ * dropped here, as EstablishNewConnections does for clients.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef WIN32
+#include <X11/Xwinsock.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#define XSERV_t
+#define TRANS_SERVER
+#include <X11/Xtrans/Xtrans.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "misc.h"
+#include "osdep.h"
+#include "xserver_poll.h"
+
+#ifdef WIN32
+#define close closesocket
+#endif
+
+#define ACCEPT_TIMEOUT          (60 * 1000)
+#define ACCEPT_MAX_PENDING      60      /* stay within the Winsock FD_SETSIZE */
+#define ACCEPT_MAX_SETUP        1024    /* longer setup data is left to dispatch */
+
+typedef struct _AcceptConn {
+    struct _AcceptConn *next;
+    XtransConnInfo trans_conn;
+    int fd;
+    CARD32 conn_time;
+    int want;                   /* bytes of setup data expected */
+    int have;
+    char data[ACCEPT_MAX_SETUP];
+} AcceptConn;
+
+static pthread_mutex_t acceptMutex = PTHREAD_MUTEX_INITIALIZER;
+static AcceptConn *acceptTodo;          /* handed over, not yet polled */
+static AcceptConn *acceptDone;          /* setup complete, for dispatch */
+static int acceptCount;                 /* connections held by the worker */
+static Bool acceptThreadRunning;
+static int acceptWakeFd = -1;           /* loopback datagram socket */
+
+/*
+ * A UDP socket connected to itself: the dispatch thread sends a byte to
+ * interrupt the worker's poll.  Winsock cannot poll pipes.
+ */
+static int
+AcceptWakeSocket(void)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+        getsockname(fd, (struct sockaddr *) &addr, &len) < 0 ||
+        connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Length of the setup data, once the fixed part of the prefix is in */
+static int
+AcceptSetupLength(const char *data)
+{
+    xConnClientPrefix prefix;
+    int whichbyte = 1;
+
+    memcpy(&prefix, data, sz_xConnClientPrefix);
+    switch (prefix.byteOrder) {
+    case 'l':
+    case 'r':
+        if (!*(char *) &whichbyte) {
+            swaps(&prefix.nbytesAuthProto);
+            swaps(&prefix.nbytesAuthString);
+        }
+        break;
+    case 'B':
+    case 'R':
+        if (*(char *) &whichbyte) {
+            swaps(&prefix.nbytesAuthProto);
+            swaps(&prefix.nbytesAuthString);
+        }
+        break;
+    default:
+        /* let ProcInitialConnection reject it */
+        return sz_xConnClientPrefix;
+    }
+    return sz_xConnClientPrefix + pad_to_int32(prefix.nbytesAuthProto) +
+        pad_to_int32(prefix.nbytesAuthString);
+}
+
+static void
+AcceptDrop(AcceptConn *conn)
+{
+    _XSERVTransDisconnect(conn->trans_conn);
+    _XSERVTransClose(conn->trans_conn);
+    free(conn);
+}
+
+/*
+ * Read what the connection has for us.  Returns -1 when it has gone, 1
+ * when the setup data is complete (or too long to hold), 0 otherwise.
+ */
+static int
+AcceptRead(AcceptConn *conn)
+{
+    int result;
+
+    for (;;) {
+        result = _XSERVTransRead(conn->trans_conn, conn->data + conn->have,
+                                 conn->want - conn->have);
+        if (result <= 0)
+            return (result < 0 && ETEST(errno)) ? 0 : -1;
+        conn->have += result;
+        if (conn->have < conn->want)
+            continue;
+        if (conn->want == sz_xConnClientPrefix) {
+            conn->want = AcceptSetupLength(conn->data);
+            if (conn->want > ACCEPT_MAX_SETUP)
+                return 1;
+            if (conn->want > conn->have)
+                continue;
+        }
+        return 1;
+    }
+}
+
+static void *
+AcceptThread(void *arg)
+{
+    struct pollfd fds[ACCEPT_MAX_PENDING + 1];
+    AcceptConn *pending = NULL, **prev, *conn;
+    int count, timeout, n;
+    CARD32 now;
+    char byte;
+
+    for (;;) {
+        pthread_mutex_lock(&acceptMutex);
+        while ((conn = acceptTodo)) {
+            acceptTodo = conn->next;
+            conn->next = pending;
+            pending = conn;
+        }
+        pthread_mutex_unlock(&acceptMutex);
+
+        fds[0].fd = acceptWakeFd;
+        fds[0].events = POLLIN;
+        count = 1;
+        timeout = -1;
+        now = GetTimeInMillis();
+        for (conn = pending; conn; conn = conn->next) {
+            INT32 left = ACCEPT_TIMEOUT - (INT32) (now - conn->conn_time);
+
+            fds[count].fd = conn->fd;
+            fds[count].events = POLLIN;
+            count++;
+            if (left < 0)
+                left = 0;
+            if (timeout < 0 || left < timeout)
+                timeout = left;
+        }
+
+        /* on errors only the timeouts are checked */
+        n = xserver_poll(fds, count, timeout);
+        if (n > 0 && (fds[0].revents & POLLIN))
+            (void) recv(acceptWakeFd, &byte, 1, 0);
+
+        now = GetTimeInMillis();
+        prev = &pending;
+        count = 1;
+        while ((conn = *prev)) {
+            int status = 0;
+
+            if (n > 0 && fds[count].revents)
+                status = AcceptRead(conn);
+            else if ((INT32) (now - conn->conn_time) >= ACCEPT_TIMEOUT)
+                status = -1;
+            count++;
+
+            if (status == 0) {
+                prev = &conn->next;
+                continue;
+            }
+            *prev = conn->next;
+            pthread_mutex_lock(&acceptMutex);
+            acceptCount--;
+            if (status < 0) {
+                pthread_mutex_unlock(&acceptMutex);
+                AcceptDrop(conn);
+            }
+            else {
+                conn->next = acceptDone;
+                acceptDone = conn;
+                ospoll_wakeup(server_poll);
+                pthread_mutex_unlock(&acceptMutex);
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Called with acceptMutex held */
+static Bool
+AcceptStartThread(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    acceptWakeFd = AcceptWakeSocket();
+    if (acceptWakeFd < 0)
+        return FALSE;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    acceptThreadRunning =
+        pthread_create(&thread, &attr, AcceptThread, NULL) == 0;
+    pthread_attr_destroy(&attr);
+    if (!acceptThreadRunning) {
+        close(acceptWakeFd);
+        acceptWakeFd = -1;
+    }
+    return acceptThreadRunning;
+}
+
+/*
+ * Hand a newly accepted, non-blocking connection to the worker.  Returns
+ * FALSE if the worker cannot take it; the caller then sets the client up
+ * directly.
+ */
+Bool
+AcceptorQueue(XtransConnInfo trans_conn, int fd, CARD32 conn_time)
+{
+    AcceptConn *conn;
+    char byte = 0;
+
+    conn = malloc(sizeof(AcceptConn));
+    if (!conn)
+        return FALSE;
+    conn->trans_conn = trans_conn;
+    conn->fd = fd;
+    conn->conn_time = conn_time;
+    conn->want = sz_xConnClientPrefix;
+    conn->have = 0;
+
+    pthread_mutex_lock(&acceptMutex);
+    if (acceptCount >= ACCEPT_MAX_PENDING ||
+        (!acceptThreadRunning && !AcceptStartThread())) {
+        pthread_mutex_unlock(&acceptMutex);
+        free(conn);
+        return FALSE;
+    }
+    conn->next = acceptTodo;
+    acceptTodo = conn;
+    acceptCount++;
+    pthread_mutex_unlock(&acceptMutex);
+
+    (void) send(acceptWakeFd, &byte, 1, 0);
+    return TRUE;
+}
+
+static void
+AcceptWakeupHandler(void *data, int result)
+{
+    AcceptConn *conns, *conn, *next;
+
+    pthread_mutex_lock(&acceptMutex);
+    conns = acceptDone;
+    acceptDone = NULL;
+    pthread_mutex_unlock(&acceptMutex);
+
+    /* oldest first */
+    for (conn = NULL; conns; conns = next) {
+        next = conns->next;
+        conns->next = conn;
+        conn = conns;
+    }
+    for (; conn; conn = next) {
+        next = conn->next;
+        EstablishAcceptedConnection(conn->trans_conn, conn->fd,
+                                    conn->conn_time, conn->data, conn->have);
+        free(conn);
+    }
+}
+
+static void
+AcceptBlockHandler(void *data, void *timeout)
+{
+    pthread_mutex_lock(&acceptMutex);
+    if (acceptDone)
+        AdjustWaitForDelay(timeout, 0);
+#ifndef WIN32
+    /* ospoll_wakeup() only interrupts the wait on Windows */
+    else if (acceptCount)
+        AdjustWaitForDelay(timeout, 10);
+#endif
+    pthread_mutex_unlock(&acceptMutex);
+}
+
+/*
+ * Called from OsInit for every server generation.  Connections still with
+ * the worker are delivered to the new generation.
+ */
+void
+AcceptorInit(void)
+{
+    RegisterBlockAndWakeupHandlers(AcceptBlockHandler,
+                                   AcceptWakeupHandler, NULL);
+}
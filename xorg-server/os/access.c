@@ -1014,6 +1014,29 @@ AddLocalHosts(void)
         (void) NewHost(self->family, self->addr, self->len, TRUE);
 }
 
+#if defined(TCPCONN) && defined(IPv6) && defined(AF_INET6)
+/* Adds the addresses of a name from the hosts file, once it is resolved */
+static void
+ResetHostsResolved(const char *hostname, struct addrinfo *addresses,
+                   void *closure)
+{
+    int family = (int) (intptr_t) closure;
+    struct addrinfo *a;
+    void *addr;
+    int len, f;
+
+    for (a = addresses; a != NULL; a = a->ai_next) {
+        addr = NULL;
+        len = a->ai_addrlen;
+        f = ConvertAddr(a->ai_addr, &len, &addr);
+        if (addr && ((family == f) ||
+                     ((family == FamilyWild) && (f != -1)))) {
+            NewHost(f, addr, len, FALSE);
+        }
+    }
+}
+#endif
+
 /* Reset access control list to initial hosts */
 void
 ResetHosts(const char *display)
@@ -1128,27 +1151,18 @@ ResetHosts(const char *display)
                 if ((family == FamilyInternet) || (family == FamilyInternet6) ||
                     (family == FamilyWild)) {
                     struct addrinfo *addresses;
-                    struct addrinfo *a;
                     struct addrinfo hints;
-                    int f;
 
                     ZeroMemory(&hints, sizeof(hints));
                     if (family == FamilyInternet)
                         hints.ai_family = AF_INET;
                     else if (family == FamilyInternet6)
                         hints.ai_family = AF_INET6;
-                    if (getaddrinfo(hostname, NULL, &hints, &addresses) == 0) {
-                        for (a = addresses; a != NULL; a = a->ai_next) {
-                            len = a->ai_addrlen;
-                            f = ConvertAddr(a->ai_addr, &len,
-                                            (void **) &addr);
-                            if (addr && ((family == f) ||
-                                         ((family == FamilyWild) && (f != -1)))) {
-                                NewHost(f, addr, len, FALSE);
-                            }
-                        }
-                        freeaddrinfo(addresses);
-                    }
+                    if (ResolveHost(hostname, hints.ai_family, &addresses,
+                                    ResetHostsResolved,
+                                    (void *) (intptr_t) family))
+                        ResetHostsResolved(hostname, addresses,
+                                           (void *) (intptr_t) family);
                 }
 #else
 #ifdef XTHREADS_NEEDS_BYNAMEPARAMS
@@ -1963,7 +1977,9 @@ siHostnameAddrMatch(int family, void *addr, int len,
             hints.ai_family = AF_INET;
         else if (family == FamilyInternet6)
             hints.ai_family = AF_INET6;
-        if (getaddrinfo(hostname, NULL, &hints, &addresses) == 0) {
+        /* if the name is not cached yet, ClientAuthorized holds the
+         * connection until it is */
+        if (ResolveHost(hostname, hints.ai_family, &addresses, NULL, NULL)) {
             for (a = addresses; a != NULL; a = a->ai_next) {
                 hostaddrlen = a->ai_addrlen;
                 f = ConvertAddr(a->ai_addr, &hostaddrlen, &hostaddr);
@@ -1973,7 +1989,6 @@ siHostnameAddrMatch(int family, void *addr, int len,
                     break;
                 }
             }
-            freeaddrinfo(addresses);
         }
     }
 #else                           /* IPv6 not supported, use gethostbyname instead for IPv4 */
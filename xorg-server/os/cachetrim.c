@@ -0,0 +1,164 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Trimming server caches under memory pressure.
+ *
+ * Caches that can be rebuilt on demand register a trim function with
+ * RegisterCacheTrim.  When Windows signals that physical memory is low,
+ * TrimCaches calls them from the main loop in order of priority, lowest
+ * first, and stops as soon as the signal clears; so the caches that are
+ * cheapest to refill go first.  Each trim is logged with what it freed.
+ *
+ * The low memory notification is polled from a timer rather than waited
+ * on, since the caches belong to the main thread; after trimming, the
+ * next trim waits a while, so a system that stays short of memory does
+ * not have its caches emptied again every poll.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#endif
+
+#include <string.h>
+
+#include "misc.h"
+#include "os.h"
+#include "osdep.h"
+
+#define CACHE_TRIM_MAX          16
+#define CACHE_TRIM_POLL         5000    /* ms */
+#define CACHE_TRIM_HOLDOFF      60000   /* ms */
+
+typedef struct _CacheTrim {
+    const char *name;
+    int priority;
+    CacheTrimProcPtr proc;
+    void *closure;
+} CacheTrimRec;
+
+static CacheTrimRec cacheTrims[CACHE_TRIM_MAX];
+static int numCacheTrims;
+
+#ifdef WIN32
+static HANDLE lowMemoryNotification;
+static CARD32 lastCacheTrim;
+static Bool cacheTrimmed;
+#endif
+
+/*
+ * Caches register at every server generation; registering the same proc
+ * and closure again just updates the entry.
+ */
+void
+RegisterCacheTrim(const char *name, int priority,
+                  CacheTrimProcPtr proc, void *closure)
+{
+    int i;
+
+    UnregisterCacheTrim(proc, closure);
+    if (numCacheTrims == CACHE_TRIM_MAX) {
+        LogMessage(X_WARNING, "Too many caches to trim, not adding %s\n",
+                   name);
+        return;
+    }
+    for (i = numCacheTrims; i > 0 && cacheTrims[i - 1].priority > priority;
+         i--)
+        cacheTrims[i] = cacheTrims[i - 1];
+    cacheTrims[i].name = name;
+    cacheTrims[i].priority = priority;
+    cacheTrims[i].proc = proc;
+    cacheTrims[i].closure = closure;
+    numCacheTrims++;
+}
+
+void
+UnregisterCacheTrim(CacheTrimProcPtr proc, void *closure)
+{
+    int i;
+
+    for (i = 0; i < numCacheTrims; i++) {
+        if (cacheTrims[i].proc == proc && cacheTrims[i].closure == closure) {
+            memmove(&cacheTrims[i], &cacheTrims[i + 1],
+                    (numCacheTrims - i - 1) * sizeof(CacheTrimRec));
+            numCacheTrims--;
+            return;
+        }
+    }
+}
+
+static Bool
+MemoryIsLow(void)
+{
+#ifdef WIN32
+    BOOL low;
+
+    if (lowMemoryNotification &&
+        QueryMemoryResourceNotification(lowMemoryNotification, &low))
+        return low;
+#endif
+    return FALSE;
+}
+
+/*
+ * Trim the registered caches in order.  With untilRelieved, stop once
+ * memory is no longer low; otherwise trim them all.
+ */
+void
+TrimCaches(Bool untilRelieved)
+{
+    unsigned long total = 0;
+    int i;
+
+    for (i = 0; i < numCacheTrims; i++) {
+        unsigned long freed;
+
+        if (untilRelieved && !MemoryIsLow())
+            break;
+        freed = (*cacheTrims[i].proc) (cacheTrims[i].closure);
+        LogMessageVerb(X_INFO, 1, "Trimmed cache %s: %lu bytes\n",
+                       cacheTrims[i].name, freed);
+        total += freed;
+    }
+    LogMessageVerb(X_INFO, 1, "Trimmed %d of %d caches, %lu bytes\n",
+                   i, numCacheTrims, total);
+}
+
+#ifdef WIN32
+static CARD32
+CacheTrimTimer(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    if (cacheTrimmed && (INT32) (now - lastCacheTrim) < CACHE_TRIM_HOLDOFF)
+        return CACHE_TRIM_POLL;
+    if (!numCacheTrims || !MemoryIsLow())
+        return CACHE_TRIM_POLL;
+
+    LogMessageVerb(X_WARNING, 1, "Physical memory is low, trimming caches\n");
+    TrimCaches(TRUE);
+    lastCacheTrim = now;
+    cacheTrimmed = TRUE;
+    return CACHE_TRIM_POLL;
+}
+#endif
+
+/* Called from OsInit, after TimerInit has freed last generation's timer */
+void
+CacheTrimInit(void)
+{
+#ifdef WIN32
+    if (!lowMemoryNotification) {
+        lowMemoryNotification =
+            CreateMemoryResourceNotification(LowMemoryResourceNotification);
+        if (!lowMemoryNotification) {
+            LogMessage(X_WARNING, "CreateMemoryResourceNotification failed "
+                       "(%lu), caches are not trimmed\n",
+                       (unsigned long) GetLastError());
+            return;
+        }
+    }
+    TimerSet(NULL, 0, CACHE_TRIM_POLL, CacheTrimTimer, NULL);
+#endif
+}
@@ -136,6 +136,10 @@ struct ospoll   *server_poll;
 
 Bool NewOutputPending;          /* not yet attempted to write some new output */
 Bool NoListenAll;               /* Don't establish any listening sockets */
+#ifdef TLSCONN
+const char *TLSCertFile;        /* PEM certificate chain for "tls" */
+const char *TLSKeyFile;         /* PEM key, defaults to TLSCertFile */
+#endif
 
 #if !defined(_MSC_VER)
 static Bool RunFromSmartParent; /* send SIGUSR1 to parent process */
@@ -163,6 +167,7 @@ static int *ListenTransFds = NULL;
 static int ListenTransCount;
 
 static void ErrorConnMax(XtransConnInfo /* trans_conn */ );
+static void ConnMaxReply(XtransConnInfo /* trans_conn */ , char /* order */ );
 
 static XtransConnInfo
 lookup_trans_conn(int fd)
@@ -280,6 +285,16 @@ CreateWellKnownSockets(void)
     /* display is initialized to "0" by main(). It is then set to the display
      * number if specified on the command line. */
 
+#ifdef TLSCONN
+    if (_XSERVTransIsListening("tls") &&
+        (!TLSCertFile ||
+         _XSERVTransSetTLSCertificate(TLSCertFile, TLSKeyFile ?
+                                      TLSKeyFile : TLSCertFile) < 0)) {
+        ErrorF("No usable -tlscert, not listening on tls\n");
+        _XSERVTransNoListen("tls");
+    }
+#endif
+
     if (NoListenAll) {
         ListenTransCount = 0;
     }
@@ -521,6 +536,8 @@ AuthorizationIDOfClient(ClientPtr client)
         return None;
 }
 
+const char ClientAuthDeferred[] = "Waiting for a host name lookup";
+
 /*****************************************************************
  * ClientAuthorized
  *
@@ -538,6 +555,9 @@ AuthorizationIDOfClient(ClientPtr client)
  *        client expects, or a server that only implements the host-based
  *        mechanism, will simply ignore this information.
  *
+ *      Returns ClientAuthDeferred, with the client ignored, if the answer
+ *      depends on a host name that is still being looked up.
+ *
  *****************************************************************/
 
 const char *
@@ -569,9 +589,21 @@ ClientAuthorized(ClientPtr client,
 
     if (auth_id == (XID) ~0L) {
         if (_XSERVTransGetPeerAddr(trans_conn, &family, &fromlen, &from) != -1) {
-            if (InvalidHost((struct sockaddr *) from, fromlen, client))
+            if (InvalidHost((struct sockaddr *) from, fromlen, client)) {
+                if (ResolvePending()) {
+                    /* The host may be allowed by a name that is still being
+                     * looked up: park the setup request until the answer is
+                     * in, AttendResolvingClients() then runs it again.
+                     */
+                    free(from);
+                    ResetCurrentRequest(client);
+                    IgnoreClient(client);
+                    priv->flags |= OS_COMM_RESOLVING;
+                    return ClientAuthDeferred;
+                }
                 AuthAudit(client, FALSE, (struct sockaddr *) from,
                           fromlen, proto_n, auth_proto, auth_id);
+            }
             else {
                 auth_id = (XID) 0;
 #ifdef XSERVER_DTRACE
@@ -659,6 +691,9 @@ AllocNewConnection(XtransConnInfo trans_conn, int fd, CARD32 conn_time)
     oc->auth_id = None;
     oc->conn_time = conn_time;
     oc->flags = 0;
+    oc->bytesBuffered = 0;
+    oc->flushCount = 0;
+    oc->reallocCount = 0;
     if (!(client = NextAvailableClient((void *) oc))) {
         free(oc);
         return NullClient;
@@ -723,12 +758,36 @@ EstablishNewConnections_local(int curconn, int ready, void *data)
     if (trans_conn->flags & TRANS_NOXAUTH)
         new_trans_conn->flags = new_trans_conn->flags | TRANS_NOXAUTH;
 
+    /* the acceptor thread reads the setup data */
+    if (AcceptorQueue(new_trans_conn, newconn, connect_time))
+        return;
+
     if (!AllocNewConnection(new_trans_conn, newconn, connect_time)) {
         ErrorConnMax(new_trans_conn);
     }
     return;
 }
 
+/*****************
+ * EstablishAcceptedConnection
+ *    Set up the client for a connection the acceptor thread has read
+ *    the connection prefix and authorization data from.
+ *****************/
+void
+EstablishAcceptedConnection(XtransConnInfo trans_conn, int fd,
+                            CARD32 conn_time, const char *data, int count)
+{
+    ClientPtr client;
+
+    if (!(client = AllocNewConnection(trans_conn, fd, conn_time))) {
+        ConnMaxReply(trans_conn, data[0]);
+        _XSERVTransClose(trans_conn);
+        return;
+    }
+    if (!AppendClientInput(client, data, count))
+        CloseDownClient(client);
+}
+
 #define NOROOM "Maximum number of clients reached"
 
 /************
@@ -737,13 +796,8 @@ EstablishNewConnections_local(int curconn, int ready, void *data)
  ************/
 
 static void
-ConnMaxNotify(int fd, int events, void *data)
+ConnMaxReply(XtransConnInfo trans_conn, char order)
 {
-    XtransConnInfo trans_conn = data;
-    char order = 0;
-
-    /* try to read the byte-order of the connection */
-    (void) _XSERVTransRead(trans_conn, &order, 1);
     if (order == 'l' || order == 'B' || order == 'r' || order == 'R') {
         xConnSetupPrefix csp;
         char pad[3] = { 0, 0, 0 };
@@ -769,6 +823,17 @@ ConnMaxNotify(int fd, int events, void *data)
         iov[2].iov_base = pad;
         (void) _XSERVTransWritev(trans_conn, iov, 3);
     }
+}
+
+static void
+ConnMaxNotify(int fd, int events, void *data)
+{
+    XtransConnInfo trans_conn = data;
+    char order = 0;
+
+    /* try to read the byte-order of the connection */
+    (void) _XSERVTransRead(trans_conn, &order, 1);
+    ConnMaxReply(trans_conn, order);
     RemoveNotifyFd(trans_conn->fd);
     _XSERVTransClose(trans_conn);
 }
@@ -870,6 +935,8 @@ CloseDownConnection(ClientPtr client)
 #endif
     if (oc->output)
         FlushClient(client, oc, (char *) NULL, 0);
+    DebugF("client %d I/O: %lu bytes buffered, %lu flushes, %lu reallocs\n",
+           client->index, oc->bytesBuffered, oc->flushCount, oc->reallocCount);
     CloseDownFileDescriptor(oc);
     FreeOsBuffers(oc);
     free(client->osPrivate);
@@ -1036,6 +1103,29 @@ AttendClient(ClientPtr client)
     }
 }
 
+/****************
+ * AttendResolvingClients
+ *    Called when host name lookups complete; re-runs the connection setup
+ *    of clients ClientAuthorized deferred.
+ ****************/
+
+void
+AttendResolvingClients(void)
+{
+    int i;
+
+    for (i = 1; i < currentMaxClients; i++) {
+        ClientPtr client = clients[i];
+        OsCommPtr oc;
+
+        if (!client || !(oc = (OsCommPtr) client->osPrivate) ||
+            !(oc->flags & OS_COMM_RESOLVING))
+            continue;
+        oc->flags &= ~OS_COMM_RESOLVING;
+        AttendClient(client);
+    }
+}
+
 /* make client impervious to grabs; assume only executing client calls this */
 
 void
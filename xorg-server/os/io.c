@@ -89,19 +89,24 @@ typedef struct _connectionInput {
     int lenLastReq;
     int size;
     unsigned int ignoreBytes;   /* bytes to ignore before the next request */
+    int smallReads;             /* reads since the buffer was last needed at its size */
 } ConnectionInput;
 
 typedef struct _connectionOutput {
     struct _connectionOutput *next;
     unsigned char *buf;
     int size;
-    int count;
+    int start;                  /* first byte not yet written to the client */
+    int count;                  /* end of the buffered data */
 } ConnectionOutput;
 
 static ConnectionInputPtr AllocateInputBuffer(void);
 static ConnectionOutputPtr AllocateOutputBuffer(void);
+static ConnectionOutputPtr GetOutputBuffer(ClientPtr who, OsCommPtr oc);
 
 static Bool CriticalOutputPending;
+static int OutputBatchDepth = 0;
+static Bool OutputBatched = FALSE;
 static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
 static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
@@ -118,6 +123,7 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 
 #define BUFSIZE 16384
 #define BUFWATERMARK 32768
+#define BUFSHRINKREADS 8        /* small reads before a big input buffer shrinks */
 
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
@@ -333,6 +339,7 @@ ReadRequestFromClient(ClientPtr client)
                 }
                 oci->size = needed;
                 oci->buffer = ibuf;
+                oc->reallocCount++;
             }
             oci->bufptr = oci->buffer;
             oci->bufcnt = gotnow;
@@ -367,9 +374,13 @@ ReadRequestFromClient(ClientPtr client)
         }
         oci->bufcnt += result;
         gotnow += result;
-        /* free up some space after huge requests */
-        if ((oci->size > BUFWATERMARK) &&
-            (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE)) {
+        /* free up some space after huge requests, but only once the
+         * client has stopped sending them for a while, rather than
+         * reallocating back and forth for every large PutImage */
+        if (needed >= BUFSIZE)
+            oci->smallReads = 0;
+        else if ((oci->size > BUFWATERMARK) && (oci->bufcnt < BUFSIZE) &&
+                 (++oci->smallReads >= BUFSHRINKREADS)) {
             char *ibuf;
 
             ibuf = (char *) realloc(oci->buffer, BUFSIZE);
@@ -377,6 +388,8 @@ ReadRequestFromClient(ClientPtr client)
                 oci->size = BUFSIZE;
                 oci->buffer = ibuf;
                 oci->bufptr = ibuf + oci->bufcnt - gotnow;
+                oci->smallReads = 0;
+                oc->reallocCount++;
             }
         }
         if (need_header && gotnow >= needed) {
@@ -528,6 +541,7 @@ InsertFakeRequest(ClientPtr client, char *data, int count)
         oci->size = gotnow + count;
         oci->buffer = ibuf;
         oci->bufptr = ibuf + oci->bufcnt - gotnow;
+        oc->reallocCount++;
     }
     moveup = count - (oci->bufptr - oci->buffer);
     if (moveup > 0) {
@@ -547,6 +561,47 @@ InsertFakeRequest(ClientPtr client, char *data, int count)
     return TRUE;
 }
 
+/*****************************************************************
+ * AppendClientInput
+ *    Add bytes read before the client existed behind the fake
+ *    InitialConnection request NextAvailableClient queued.
+ *
+ **********************/
+
+Bool
+AppendClientInput(ClientPtr client, const char *data, int count)
+{
+    OsCommPtr oc = (OsCommPtr) client->osPrivate;
+    ConnectionInputPtr oci = oc->input;
+    int gotnow;
+
+    if (!oci)
+        return FALSE;
+    gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
+    if (oci->bufptr != oci->buffer) {
+        memmove(oci->buffer, oci->bufptr, gotnow);
+        oci->bufptr = oci->buffer;
+        oci->bufcnt = gotnow;
+    }
+    if (gotnow + count > oci->size) {
+        char *ibuf;
+
+        ibuf = (char *) realloc(oci->buffer, gotnow + count);
+        if (!ibuf)
+            return FALSE;
+        oci->size = gotnow + count;
+        oci->buffer = oci->bufptr = ibuf;
+        oc->reallocCount++;
+    }
+    memcpy(oci->buffer + oci->bufcnt, data, count);
+    oci->bufcnt += count;
+    gotnow += count;
+    if ((gotnow >= sizeof(xReq)) &&
+        (gotnow >= (int) (get_req_len((xReq *) oci->bufptr, client) << 2)))
+        mark_client_ready(client);
+    return TRUE;
+}
+
 /*****************************************************************
  * ResetRequestFromClient
  *    Reset to reexecute the current request, and yield.
@@ -646,6 +701,43 @@ SetCriticalOutputPending(void)
     CriticalOutputPending = TRUE;
 }
 
+ /********************
+ * BeginOutputBatch(), EndOutputBatch()
+ *    Local clients normally get their output written straight away when
+ *    nothing is buffered for them, which costs one write per event when
+ *    a burst of input is delivered.  Between these calls that output is
+ *    buffered instead and each local client is written once at the end.
+ *    Data for a client is still written in the order it was queued.
+ *
+ **********************/
+
+void
+BeginOutputBatch(void)
+{
+    OutputBatchDepth++;
+}
+
+void
+EndOutputBatch(void)
+{
+    ClientPtr client, tmp;
+
+    if (--OutputBatchDepth > 0 || !OutputBatched)
+        return;
+    OutputBatched = FALSE;
+
+    xorg_list_for_each_entry_safe(client, tmp, &output_pending_clients, output_pending) {
+        if (client->clientGone || !client->local)
+            continue;
+        output_pending_clear(client);
+        (void) FlushClient(client, (OsCommPtr) client->osPrivate, NULL, 0);
+    }
+    if (!any_output_pending()) {
+        CriticalOutputPending = FALSE;
+        NewOutputPending = FALSE;
+    }
+}
+
 /*****************
  * AbortClient:
  *    When a write error occurs to a client, close
@@ -666,6 +758,83 @@ AbortClient(ClientPtr client)
     }
 }
 
+static ConnectionOutputPtr
+GetOutputBuffer(ClientPtr who, OsCommPtr oc)
+{
+    ConnectionOutputPtr oco;
+
+    if ((oco = FreeOutputs)) {
+        FreeOutputs = oco->next;
+    }
+    else if (!(oco = AllocateOutputBuffer())) {
+        AbortClient(who);
+        MarkClientException(who);
+        return NULL;
+    }
+    oc->output = oco;
+    return oco;
+}
+
+/*****************
+ * ReserveClientOutput
+ *    Returns room for count bytes (plus padding) at the end of who's
+ *    output buffer, so that a reply can be generated in place instead of
+ *    in a scratch buffer that WriteToClient then copies.  The caller
+ *    fills it and passes the same pointer and count to WriteToClient,
+ *    which finds the data already where it belongs.  Nothing else may be
+ *    written to the client in between.  Returns NULL if the client is
+ *    gone or the space cannot be had; the client is aborted in the latter
+ *    case, as WriteToClient would.
+ *****************/
+
+void *
+ReserveClientOutput(ClientPtr who, int count)
+{
+    OsCommPtr oc;
+    ConnectionOutputPtr oco;
+    long needed = count + padding_for_int32(count);
+
+    if (count <= 0 || !who || who == serverClient || who->clientGone)
+        return NULL;
+    oc = who->osPrivate;
+    oco = oc->output;
+
+    /* Try writing out what is queued before making the buffer bigger */
+    if (oco && oco->count + needed > oco->size) {
+        if (FlushClient(who, oc, NULL, 0) < 0)
+            return NULL;
+        oco = oc->output;
+    }
+    if (!oco && !(oco = GetOutputBuffer(who, oc)))
+        return NULL;
+
+    if (oco->count + needed > oco->size) {
+        if (oco->start > 0) {
+            oco->count -= oco->start;
+            memmove((char *) oco->buf,
+                    (char *) oco->buf + oco->start, oco->count);
+            oco->start = 0;
+        }
+        if (oco->count + needed > oco->size) {
+            unsigned char *obuf = NULL;
+            long newsize = oco->count + needed;
+
+            if (newsize <= INT_MAX)
+                obuf = realloc(oco->buf, newsize);
+            if (!obuf) {
+                AbortClient(who);
+                MarkClientException(who);
+                oco->start = oco->count = 0;
+                return NULL;
+            }
+            oco->size = newsize;
+            oco->buf = obuf;
+            oc->reallocCount++;
+        }
+    }
+    return (char *) oco->buf + oco->count;
+}
+
 /*****************
  * WriteToClient
  *    Copies buf into ClientPtr.buf if it fits (with padding), else
@@ -693,6 +862,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 #endif
     if (!count || !who || who == serverClient || who->clientGone)
         return 0;
+    if (dispatchProfile)
+        DispatchProfileOutput(who, count);
     oc = who->osPrivate;
     oco = oc->output;
 #ifdef DEBUG_COMMUNICATION
@@ -736,17 +907,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
     }
 #endif
 
-    if (!oco) {
-        if ((oco = FreeOutputs)) {
-            FreeOutputs = oco->next;
-        }
-        else if (!(oco = AllocateOutputBuffer())) {
-            AbortClient(who);
-            MarkClientException(who);
-            return -1;
-        }
-        oc->output = oco;
-    }
+    if (!oco && !(oco = GetOutputBuffer(who, oc)))
+        return -1;
 
     padBytes = padding_for_int32(count);
 
@@ -790,7 +952,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
     }
 #endif
-    if ((oco->count == 0 && who->local) || oco->count + count + padBytes > oco->size) {
+    if ((oco->count == 0 && who->local && !OutputBatchDepth) ||
+        oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
             CriticalOutputPending = FALSE;
@@ -800,6 +963,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         return FlushClient(who, oc, buf, count);
     }
 
+    if (who->local && OutputBatchDepth)
+        OutputBatched = TRUE;
     NewOutputPending = TRUE;
     output_pending_mark(who);
     memmove((char *) oco->buf + oco->count, buf, count);
@@ -808,6 +973,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         memset(oco->buf + oco->count, '\0', padBytes);
         oco->count += padBytes;
     }
+    oc->bytesBuffered += count + padBytes;
     return count;
 }
 
@@ -838,13 +1004,15 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
 	return 0;
     written = 0;
     padsize = padding_for_int32(extraCount);
-    notWritten = oco->count + extraCount + padsize;
+    notWritten = oco->count - oco->start + extraCount + padsize;
     if (!notWritten)
         return 0;
 
     if (FlushCallback)
         CallCallbacks(&FlushCallback, who);
 
+    oc->flushCount++;
+
     todo = notWritten;
     while (notWritten) {
         long before = written;  /* amount of whole thing written */
@@ -879,7 +1047,7 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
 	    before = 0; \
 	}
 
-        InsertIOV((char *) oco->buf, oco->count)
+        InsertIOV((char *) oco->buf + oco->start, oco->count - oco->start)
             InsertIOV((char *) extraBuf, extraCount)
             InsertIOV(padBuffer, padsize)
 
@@ -902,42 +1070,59 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
                the rest. */
             output_pending_mark(who);
 
-            if (written < oco->count) {
-                if (written > 0) {
-                    oco->count -= written;
-                    memmove((char *) oco->buf,
-                            (char *) oco->buf + written, oco->count);
-                    written = 0;
-                }
+            /* Leave what is left of the buffered data where it is; moving
+               it to the front on every partial write makes draining a big
+               reply quadratic. */
+            if (written < oco->count - oco->start) {
+                oco->start += written;
+                written = 0;
             }
             else {
-                written -= oco->count;
-                oco->count = 0;
+                written -= oco->count - oco->start;
+                oco->start = oco->count = 0;
             }
 
-            if (notWritten > oco->size) {
-                unsigned char *obuf = NULL;
-
-                if (notWritten + BUFSIZE <= INT_MAX) {
-                    obuf = realloc(oco->buf, notWritten + BUFSIZE);
+            if (oco->start + notWritten > oco->size) {
+                /* Out of room at the end: reclaim the space already
+                   written out before resorting to a bigger buffer */
+                if (oco->start > 0) {
+                    oco->count -= oco->start;
+                    memmove((char *) oco->buf,
+                            (char *) oco->buf + oco->start, oco->count);
+                    oco->start = 0;
                 }
-                if (!obuf) {
-                    AbortClient(who);
-                    MarkClientException(who);
-                    oco->count = 0;
-                    return -1;
+                if (notWritten > oco->size) {
+                    unsigned char *obuf = NULL;
+                    long newsize = notWritten + BUFSIZE;
+
+                    /* Grow geometrically, so a client that keeps falling
+                       behind costs a logarithmic number of reallocs */
+                    if (oco->size <= INT_MAX / 2 && newsize < oco->size * 2)
+                        newsize = oco->size * 2;
+                    if (newsize <= INT_MAX) {
+                        obuf = realloc(oco->buf, newsize);
+                    }
+                    if (!obuf) {
+                        AbortClient(who);
+                        MarkClientException(who);
+                        oco->start = oco->count = 0;
+                        return -1;
+                    }
+                    oco->size = newsize;
+                    oco->buf = obuf;
+                    oc->reallocCount++;
                 }
-                oco->size = notWritten + BUFSIZE;
-                oco->buf = obuf;
             }
 
             /* If the amount written extended into the padBuffer, then the
                difference "extraCount - written" may be less than 0 */
-            if ((len = extraCount - written) > 0)
+            if ((len = extraCount - written) > 0) {
                 memmove((char *) oco->buf + oco->count,
                         extraBuf + written, len);
+                oc->bytesBuffered += len;
+            }
 
-            oco->count = notWritten;    /* this will include the pad */
+            oco->count = oco->start + notWritten;    /* this will include the pad */
             ospoll_listen(server_poll, oc->fd, X_NOTIFY_WRITE);
 
             /* return only the amount explicitly requested */
@@ -951,13 +1136,13 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
         else {
             AbortClient(who);
             MarkClientException(who);
-            oco->count = 0;
+            oco->start = oco->count = 0;
             return -1;
         }
     }
 
     /* everything was flushed out */
-    oco->count = 0;
+    oco->start = oco->count = 0;
     output_pending_clear(who);
 
     if (oco->size > BUFWATERMARK) {
@@ -990,6 +1175,7 @@ AllocateInputBuffer(void)
     oci->bufcnt = 0;
     oci->lenLastReq = 0;
     oci->ignoreBytes = 0;
+    oci->smallReads = 0;
     return oci;
 }
 
@@ -1007,6 +1193,7 @@ AllocateOutputBuffer(void)
         return NULL;
     }
     oco->size = BUFSIZE;
+    oco->start = 0;
     oco->count = 0;
     return oco;
 }
@@ -1031,6 +1218,7 @@ FreeOsBuffers(OsCommPtr oc)
             oci->bufcnt = 0;
             oci->lenLastReq = 0;
             oci->ignoreBytes = 0;
+            oci->smallReads = 0;
         }
     }
     if ((oco = oc->output)) {
@@ -1041,11 +1229,28 @@ FreeOsBuffers(OsCommPtr oc)
         else {
             FreeOutputs = oco;
             oco->next = (ConnectionOutputPtr) NULL;
+            oco->start = 0;
             oco->count = 0;
         }
     }
 }
 
+/*****************
+ * ClientOutputBytes
+ *    How many bytes of output are queued for a client and how large its
+ *    output buffer has grown; a client that stops reading shows up here.
+ *****************/
+
+void
+ClientOutputBytes(ClientPtr who, unsigned long *pending, unsigned long *size)
+{
+    OsCommPtr oc = who->osPrivate;
+    ConnectionOutputPtr oco = oc ? oc->output : NULL;
+
+    *pending = oco ? oco->count - oco->start : 0;
+    *size = oco ? oco->size : 0;
+}
+
 void
 ResetOsBuffers(void)
 {
@@ -119,10 +119,14 @@ typedef struct _osComm {
     CARD32 conn_time;           /* timestamp if not established, else 0  */
     struct _XtransConnInfo *trans_conn; /* transport connection object */
     int flags;
+    unsigned long bytesBuffered;        /* output bytes that had to be buffered */
+    unsigned long flushCount;           /* FlushClient calls with data to write */
+    unsigned long reallocCount;         /* input and output buffer reallocations */
 } OsCommRec, *OsCommPtr;
 
 #define OS_COMM_GRAB_IMPERVIOUS 1
 #define OS_COMM_IGNORED         2
+#define OS_COMM_RESOLVING       4       /* setup waits for a host lookup */
 
 extern int FlushClient(ClientPtr /*who */ ,
                        OsCommPtr /*oc */ ,
@@ -146,11 +150,49 @@ listen_to_client(ClientPtr client);
 
 extern Bool NewOutputPending;
 
+#ifdef TLSCONN
+extern const char *TLSCertFile;
+extern const char *TLSKeyFile;
+#endif
+
 extern WorkQueuePtr workQueue;
 
 /* in access.c */
 extern Bool ComputeLocalClient(ClientPtr client);
 
+/* in connection.c */
+extern void AttendResolvingClients(void);
+extern void EstablishAcceptedConnection(struct _XtransConnInfo *trans_conn,
+                                        int fd, CARD32 conn_time,
+                                        const char *data, int count);
+
+/* in io.c */
+extern Bool AppendClientInput(ClientPtr client, const char *data, int count);
+
+/* in acceptor.c */
+extern Bool AcceptorQueue(struct _XtransConnInfo *trans_conn, int fd,
+                          CARD32 conn_time);
+extern void AcceptorInit(void);
+
+/* in resolve.c */
+struct addrinfo;
+
+typedef void (*HostResolvedProcPtr) (const char *name,
+                                     struct addrinfo *addrs,
+                                     void *closure);
+
+extern Bool ResolveHost(const char *name, int family,
+                        struct addrinfo **addrs,
+                        HostResolvedProcPtr proc, void *closure);
+extern Bool ResolvePending(void);
+extern void ResolverInit(void);
+
+/* in cachetrim.c */
+extern void CacheTrimInit(void);
+
+/* in threadpool.c */
+extern void ThreadPoolLogStats(void);
+
 /* in auth.c */
 extern void GenerateRandomData(int len, char *buf);
 
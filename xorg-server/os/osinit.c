@@ -159,6 +159,7 @@ OsSigHandler(int signo)
 #endif /* !WIN32 || __CYGWIN__ */
 
 #include "busfault.h"
+#include "wintrace.h"
 
 void
 OsInit(void)
@@ -311,9 +312,12 @@ OsInit(void)
         }
 #endif
         LockServer();
+        WinTraceInit();
         been_here = TRUE;
     }
     TimerInit();
+    ResolverInit();
+    AcceptorInit();
     OsVendorInit();
     OsResetSignals();
     /*
@@ -322,12 +326,15 @@ OsInit(void)
      */
     LogInit(NULL, NULL);
     SmartScheduleInit();
+    CacheTrimInit();
 }
 
 void
 OsCleanup(Bool terminating)
 {
+    ThreadPoolLogStats();
     if (terminating) {
+        WinTraceFini();
         UnlockServer();
     }
 }
@@ -24,6 +24,9 @@
 #include <dix-config.h>
 #endif
 
+#if defined(WIN32) && !defined(__CYGWIN__)
+#include <X11/Xwinsock.h>
+#endif
 #include <X11/X.h>
 #include <X11/Xproto.h>
 #include <stdlib.h>
@@ -55,6 +58,12 @@
 #include "xserver_poll.h"
 #define POLL            1
 #define HAVE_OSPOLL     1
+#if defined(WIN32) && !defined(__CYGWIN__)
+/* Block in MsgWaitForMultipleObjectsEx so that both socket activity
+ * and the Windows message queue of the server thread wake us up
+ */
+#define POLL_WSAEVENT   1
+#endif
 #endif
 
 #if POLLSET
@@ -116,8 +125,88 @@ struct ospoll {
     int                 num;
     int                 size;
     Bool                changed;
+#if POLL_WSAEVENT
+    HANDLE              wake_event;
+    struct wsapollfd    *wsafds;
+#endif
 };
 
+#if POLL_WSAEVENT
+
+/* WSAPoll is only declared for Vista and later targets, so carry our
+ * own copy of WSAPOLLFD and its flags and look the function up at
+ * runtime.  Unlike select() it takes the registered array as is, so
+ * nothing is rebuilt per call and FD_SETSIZE does not apply.
+ */
+struct wsapollfd {
+    SOCKET              fd;
+    SHORT               events;
+    SHORT               revents;
+};
+
+#define WSAPOLL_ERR     0x0001
+#define WSAPOLL_HUP     0x0002
+#define WSAPOLL_NVAL    0x0004
+#define WSAPOLL_WRNORM  0x0010
+#define WSAPOLL_RDNORM  0x0100
+#define WSAPOLL_RDBAND  0x0200
+
+typedef int (WSAAPI *wsapoll_proc)(struct wsapollfd *fds, ULONG nfds,
+                                   INT timeout);
+
+static wsapoll_proc wsapoll;
+
+static SHORT
+wsapoll_events(short events)
+{
+    SHORT wsaevents = 0;
+
+    /* POLLPRI is rejected by WSAPoll, out of band data is not used */
+    if (events & POLLIN)
+        wsaevents |= WSAPOLL_RDNORM | WSAPOLL_RDBAND;
+    if (events & POLLOUT)
+        wsaevents |= WSAPOLL_WRNORM;
+    return wsaevents;
+}
+
+static int
+ospoll_poll(struct ospoll *ospoll, int timeout)
+{
+    int nready;
+    int f;
+
+    if (!wsapoll)
+        return xserver_poll(ospoll->fds, ospoll->num, timeout);
+
+    nready = wsapoll(ospoll->wsafds, ospoll->num, timeout);
+    for (f = 0; f < ospoll->num; f++) {
+        SHORT wsarevents = ospoll->wsafds[f].revents;
+        short revents = 0;
+
+        if (nready > 0 && wsarevents) {
+            if (wsarevents & (WSAPOLL_RDNORM | WSAPOLL_RDBAND))
+                revents |= POLLIN;
+            if (wsarevents & WSAPOLL_WRNORM)
+                revents |= POLLOUT;
+            if (wsarevents & WSAPOLL_ERR)
+                revents |= POLLERR;
+            if (wsarevents & WSAPOLL_HUP)
+                revents |= POLLHUP;
+            if (wsarevents & WSAPOLL_NVAL)
+                revents |= POLLNVAL;
+        }
+        ospoll->fds[f].revents = revents;
+    }
+    return nready;
+}
+
+#else
+
+#define ospoll_poll(ospoll, timeout) \
+    xserver_poll((ospoll)->fds, (ospoll)->num, timeout)
+
+#endif
+
 #endif
 
 /* Binary search for the specified file descriptor
@@ -234,8 +323,24 @@ ospoll_create(void)
     return ospoll;
 #endif
 #if POLL
+#if POLL_WSAEVENT
+    struct ospoll       *ospoll = calloc(1, sizeof (struct ospoll));
+
+    if (!ospoll)
+        return NULL;
+    ospoll->wake_event = WSACreateEvent();
+    if (ospoll->wake_event == WSA_INVALID_EVENT) {
+        free (ospoll);
+        return NULL;
+    }
+    if (!wsapoll)
+        wsapoll = (wsapoll_proc) GetProcAddress(GetModuleHandleA("ws2_32.dll"),
+                                                "WSAPoll");
+    return ospoll;
+#else
     return calloc(1, sizeof (struct ospoll));
 #endif
+#endif
 }
 
 void
@@ -261,6 +366,10 @@ ospoll_destroy(struct ospoll *ospoll)
 #if POLL
     if (ospoll) {
         assert (ospoll->num == 0);
+#if POLL_WSAEVENT
+        WSACloseEvent(ospoll->wake_event);
+        free (ospoll->wsafds);
+#endif
         free (ospoll->fds);
         free (ospoll->osfds);
         free (ospoll);
@@ -395,11 +504,28 @@ ospoll_add(struct ospoll *ospoll, int fd,
             if (!new_osfds)
                 return FALSE;
             ospoll->osfds = new_osfds;
+#if POLL_WSAEVENT
+            {
+                struct wsapollfd *new_wsafds;
+
+                new_wsafds = reallocarray(ospoll->wsafds, new_size,
+                                          sizeof (ospoll->wsafds[0]));
+                if (!new_wsafds)
+                    return FALSE;
+                ospoll->wsafds = new_wsafds;
+            }
+#endif
             ospoll->size = new_size;
         }
         pos = -pos - 1;
         array_insert(ospoll->fds, ospoll->num, sizeof (ospoll->fds[0]), pos);
         array_insert(ospoll->osfds, ospoll->num, sizeof (ospoll->osfds[0]), pos);
+#if POLL_WSAEVENT
+        array_insert(ospoll->wsafds, ospoll->num, sizeof (ospoll->wsafds[0]), pos);
+        ospoll->wsafds[pos].fd = (SOCKET) fd;
+        ospoll->wsafds[pos].events = 0;
+        ospoll->wsafds[pos].revents = 0;
+#endif
         ospoll->num++;
         ospoll->changed = TRUE;
 
@@ -407,6 +533,14 @@ ospoll_add(struct ospoll *ospoll, int fd,
         ospoll->fds[pos].events = 0;
         ospoll->fds[pos].revents = 0;
         ospoll->osfds[pos].revents = 0;
+#if POLL_WSAEVENT
+        /* The event only serves to end the wait, readiness itself is
+         * still taken from select(), so register for everything once
+         */
+        WSAEventSelect(fd, ospoll->wake_event,
+                       FD_READ | FD_WRITE | FD_OOB | FD_ACCEPT |
+                       FD_CONNECT | FD_CLOSE);
+#endif
     }
     ospoll->osfds[pos].trigger = trigger;
     ospoll->osfds[pos].callback = callback;
@@ -454,8 +588,14 @@ ospoll_remove(struct ospoll *ospoll, int fd)
         xorg_list_add(&osfd->deleted, &ospoll->deleted);
 #endif
 #if POLL
+#if POLL_WSAEVENT
+        WSAEventSelect(fd, NULL, 0);
+#endif
         array_delete(ospoll->fds, ospoll->num, sizeof (ospoll->fds[0]), pos);
         array_delete(ospoll->osfds, ospoll->num, sizeof (ospoll->osfds[0]), pos);
+#if POLL_WSAEVENT
+        array_delete(ospoll->wsafds, ospoll->num, sizeof (ospoll->wsafds[0]), pos);
+#endif
         ospoll->num--;
         ospoll->changed = TRUE;
 #endif
@@ -525,6 +665,9 @@ ospoll_listen(struct ospoll *ospoll, int fd, int xevents)
             ospoll->fds[pos].events |= POLLOUT;
             ospoll->osfds[pos].revents &= ~POLLOUT;
         }
+#if POLL_WSAEVENT
+        ospoll->wsafds[pos].events = wsapoll_events(ospoll->fds[pos].events);
+#endif
 #endif
     }
 }
@@ -561,6 +704,9 @@ ospoll_mute(struct ospoll *ospoll, int fd, int xevents)
             ospoll->fds[pos].events &= ~POLLIN;
         if (xevents & X_NOTIFY_WRITE)
             ospoll->fds[pos].events &= ~POLLOUT;
+#if POLL_WSAEVENT
+        ospoll->wsafds[pos].events = wsapoll_events(ospoll->fds[pos].events);
+#endif
 #endif
     }
 }
@@ -659,7 +805,26 @@ ospoll_wait(struct ospoll *ospoll, int timeout)
     ospoll_clean_deleted(ospoll);
 #endif
 #if POLL
-    nready = xserver_poll(ospoll->fds, ospoll->num, timeout);
+#if POLL_WSAEVENT
+    /* Reset before polling so that activity after the poll still
+     * signals the event and cuts the wait short
+     */
+    WSAResetEvent(ospoll->wake_event);
+    nready = ospoll_poll(ospoll, 0);
+    if (nready == 0 && timeout != 0) {
+        DWORD wait = MsgWaitForMultipleObjectsEx(1, &ospoll->wake_event,
+                                                 timeout < 0 ? INFINITE : timeout,
+                                                 QS_ALLINPUT,
+                                                 MWMO_INPUTAVAILABLE);
+
+        if (wait == WAIT_OBJECT_0)
+            nready = ospoll_poll(ospoll, 0);
+        else if (wait == WAIT_FAILED)
+            nready = -1;
+    }
+#else
+    nready = ospoll_poll(ospoll, timeout);
+#endif
     ospoll->changed = FALSE;
     if (nready > 0) {
         int f;
@@ -740,6 +905,15 @@ ospoll_data(struct ospoll *ospoll, int fd)
 #endif
 }
 
+void
+ospoll_wakeup(struct ospoll *ospoll)
+{
+#if POLL_WSAEVENT
+    if (ospoll)
+        WSASetEvent(ospoll->wake_event);
+#endif
+}
+
 void CheckServerConnections(struct ospoll *server_poll)
 {
   CheckConnections(server_poll->fds, server_poll->num);
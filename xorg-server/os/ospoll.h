@@ -139,4 +139,16 @@ ospoll_reset_events(struct ospoll *ospoll, int fd);
 void *
 ospoll_data(struct ospoll *ospoll, int fd);
 
+/**
+ * Interrupt a wait from another thread
+ *
+ * @param       ospoll          ospoll being waited on
+ *
+ * Makes a concurrent or the next ospoll_wait call return early, so the
+ * caller's wakeup handlers run.  Safe to call from any thread; does
+ * nothing on platforms where the wait cannot be interrupted.
+ */
+void
+ospoll_wakeup(struct ospoll *ospoll);
+
 #endif /* _OSPOLL_H_ */
@@ -0,0 +1,324 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Host name lookups off the dispatch thread.
+ *
+ * getaddrinfo() can take seconds when a name server is slow or down, and
+ * the access control code used to call it from the dispatch loop: for
+ * every connection checked against an "si:hostname:" entry, and for every
+ * name in /etc/X<display>.hosts at each reset.  ResolveHost() answers from
+ * a cache instead.  On a miss the lookup is queued as background work for
+ * the thread pool and the caller is told to try again later; the worker
+ * that runs it wakes the dispatch thread, whose wakeup handler moves the
+ * answer into the cache and runs the completion callbacks.  The cache is
+ * only ever touched by the dispatch thread, so answers stay valid until
+ * the caller returns.
+ *
+ * getaddrinfo() does not report the record TTL.  Answers are reused for
+ * RESOLVE_CACHE_TIME (RESOLVE_NEGATIVE_TIME for failed lookups); after
+ * that a refresh is queued and the old answer is used until it arrives.
+ * The system resolver caches by TTL itself, so refreshes are cheap and
+ * still follow the records as they change.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef WIN32
+#include <X11/Xwinsock.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "misc.h"
+#include "osdep.h"
+#include "dixstruct.h"
+
+#if defined(TCPCONN) && defined(IPv6) && defined(AF_INET6)
+
+#define RESOLVE_CACHE_TIME      (60 * 1000)
+#define RESOLVE_NEGATIVE_TIME   (10 * 1000)
+#define RESOLVE_CACHE_MAX       256
+
+typedef struct _ResolveWaiter {
+    struct _ResolveWaiter *next;
+    HostResolvedProcPtr proc;
+    void *closure;
+} ResolveWaiter;
+
+typedef struct _ResolveEntry {
+    struct _ResolveEntry *next;
+    char *name;
+    int family;
+    struct addrinfo *addrs;     /* NULL when the lookup failed */
+    CARD32 expires;
+    Bool answered;              /* addrs/expires hold an answer */
+    Bool queued;                /* a lookup is with the worker */
+    ResolveWaiter *waiters;
+} ResolveEntry;
+
+/* Handed to the worker; the worker only touches these fields */
+typedef struct _ResolveJob {
+    struct _ResolveJob *next;
+    ThreadPoolWork work;
+    ResolveEntry *entry;
+    char *name;
+    int family;
+    struct addrinfo *addrs;
+    int error;
+} ResolveJob;
+
+static ResolveEntry *resolveCache;
+static int resolveCacheSize;
+static int resolveUnanswered;   /* entries queued without any answer yet */
+
+static pthread_mutex_t resolveMutex = PTHREAD_MUTEX_INITIALIZER;
+static ResolveJob *resolveDone;
+
+static void
+ResolveLookup(void *closure)
+{
+    ResolveJob *job = closure;
+    struct addrinfo hints;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = job->family;
+    job->error = getaddrinfo(job->name, NULL, &hints, &job->addrs);
+    if (job->error)
+        job->addrs = NULL;
+
+    pthread_mutex_lock(&resolveMutex);
+    job->next = resolveDone;
+    resolveDone = job;
+    ospoll_wakeup(server_poll);
+    pthread_mutex_unlock(&resolveMutex);
+}
+
+static Bool
+ResolveQueue(ResolveEntry *entry)
+{
+    ResolveJob *job;
+
+    if (entry->queued)
+        return TRUE;
+
+    job = calloc(1, sizeof(ResolveJob));
+    if (!job)
+        return FALSE;
+    job->name = strdup(entry->name);
+    if (!job->name) {
+        free(job);
+        return FALSE;
+    }
+    job->entry = entry;
+    job->family = entry->family;
+
+    if (!ThreadPoolQueue(&job->work, ThreadPoolBackground,
+                         ResolveLookup, job)) {
+        ErrorF("ResolveHost: no thread to run the lookup on\n");
+        free(job->name);
+        free(job);
+        return FALSE;
+    }
+
+    entry->queued = TRUE;
+    if (!entry->answered)
+        resolveUnanswered++;
+    return TRUE;
+}
+
+static void
+ResolveFreeEntry(ResolveEntry *entry)
+{
+    if (entry->addrs)
+        freeaddrinfo(entry->addrs);
+    free(entry->name);
+    free(entry);
+}
+
+/* Drop answers nobody asked for since they expired */
+static void
+ResolvePrune(CARD32 now)
+{
+    ResolveEntry **prev = &resolveCache, *entry;
+
+    while ((entry = *prev)) {
+        if (!entry->queued && !entry->waiters &&
+            (INT32) (now - entry->expires) >= 0) {
+            *prev = entry->next;
+            ResolveFreeEntry(entry);
+            resolveCacheSize--;
+        }
+        else
+            prev = &entry->next;
+    }
+}
+
+/*
+ * Look NAME up for address family FAMILY (AF_INET, AF_INET6 or AF_UNSPEC).
+ *
+ * Returns TRUE with *addrs set (NULL if the name does not resolve) when an
+ * answer is cached; the list belongs to the cache and stays valid until the
+ * dispatch loop runs again.  Otherwise the lookup is queued and FALSE is
+ * returned; PROC, if given, is called with CLOSURE and the answer once it
+ * arrives, from the dispatch thread and within the current generation.
+ */
+Bool
+ResolveHost(const char *name, int family, struct addrinfo **addrs,
+            HostResolvedProcPtr proc, void *closure)
+{
+    CARD32 now = GetTimeInMillis();
+    ResolveEntry *entry;
+    ResolveWaiter *waiter;
+
+    for (entry = resolveCache; entry; entry = entry->next)
+        if (entry->family == family && !strcmp(entry->name, name))
+            break;
+
+    if (!entry) {
+        if (resolveCacheSize >= RESOLVE_CACHE_MAX)
+            ResolvePrune(now);
+        entry = calloc(1, sizeof(ResolveEntry));
+        if (!entry || !(entry->name = strdup(name))) {
+            free(entry);
+            *addrs = NULL;
+            return TRUE;
+        }
+        entry->family = family;
+        entry->next = resolveCache;
+        resolveCache = entry;
+        resolveCacheSize++;
+    }
+
+    if (entry->answered) {
+        if ((INT32) (now - entry->expires) >= 0)
+            ResolveQueue(entry);
+        *addrs = entry->addrs;
+        return TRUE;
+    }
+
+    if (!ResolveQueue(entry)) {
+        *addrs = NULL;
+        return TRUE;
+    }
+    if (proc && (waiter = malloc(sizeof(ResolveWaiter)))) {
+        waiter->proc = proc;
+        waiter->closure = closure;
+        waiter->next = entry->waiters;
+        entry->waiters = waiter;
+    }
+    return FALSE;
+}
+
+/*
+ * TRUE while a name is being looked up for the first time, so access
+ * checks against it cannot be answered yet.
+ */
+Bool
+ResolvePending(void)
+{
+    return resolveUnanswered > 0;
+}
+
+static void
+ResolveWakeupHandler(void *data, int result)
+{
+    ResolveJob *jobs, *job;
+    CARD32 now;
+
+    pthread_mutex_lock(&resolveMutex);
+    jobs = resolveDone;
+    resolveDone = NULL;
+    pthread_mutex_unlock(&resolveMutex);
+
+    if (!jobs)
+        return;
+
+    now = GetTimeInMillis();
+    while ((job = jobs)) {
+        ResolveEntry *entry = job->entry;
+        ResolveWaiter *waiter;
+
+        jobs = job->next;
+
+        if (!entry->answered)
+            resolveUnanswered--;
+        if (entry->addrs)
+            freeaddrinfo(entry->addrs);
+        entry->addrs = job->addrs;
+        entry->expires = now + (job->addrs ? RESOLVE_CACHE_TIME :
+                                RESOLVE_NEGATIVE_TIME);
+        entry->answered = TRUE;
+        entry->queued = FALSE;
+
+        while ((waiter = entry->waiters)) {
+            entry->waiters = waiter->next;
+            waiter->proc(entry->name, entry->addrs, waiter->closure);
+            free(waiter);
+        }
+
+        free(job->name);
+        free(job);
+    }
+
+    /* connections held back by ClientAuthorized get another look */
+    AttendResolvingClients();
+}
+
+static void
+ResolveBlockHandler(void *data, void *timeout)
+{
+    /* in case ospoll_wakeup() cannot interrupt the wait on this platform */
+    if (resolveUnanswered)
+        AdjustWaitForDelay(timeout, 100);
+}
+
+/*
+ * Called from OsInit for every server generation.  Callbacks belong to
+ * the generation that registered them and are dropped.
+ */
+void
+ResolverInit(void)
+{
+    ResolveEntry *entry;
+    ResolveWaiter *waiter;
+
+    for (entry = resolveCache; entry; entry = entry->next) {
+        while ((waiter = entry->waiters)) {
+            entry->waiters = waiter->next;
+            free(waiter);
+        }
+    }
+
+    RegisterBlockAndWakeupHandlers(ResolveBlockHandler,
+                                   ResolveWakeupHandler, NULL);
+}
+
+#else
+
+Bool
+ResolveHost(const char *name, int family, struct addrinfo **addrs,
+            HostResolvedProcPtr proc, void *closure)
+{
+    *addrs = NULL;
+    return TRUE;
+}
+
+Bool
+ResolvePending(void)
+{
+    return FALSE;
+}
+
+void
+ResolverInit(void)
+{
+}
+
+#endif
@@ -0,0 +1,286 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * One pool of worker threads for the whole server.
+ *
+ * Code that wants work done off the dispatch thread queues it here
+ * instead of starting threads of its own, so a host running many servers
+ * does not end up with every subsystem of every server spinning up a
+ * thread per CPU.  The pool has threadPoolSize workers, or by default one
+ * fewer than the CPUs the process may run on; they are started the first
+ * time work is queued and are kept for the life of the process.
+ *
+ * Work is queued on one of two lanes.  Interactive work is for something
+ * the dispatch thread is waiting on, such as the bands of a composite;
+ * it is always taken first, and callers must be ready to do it
+ * themselves, cancelling whatever no worker has picked up yet.
+ * Background work, such as host name lookups, runs on at most all but
+ * one of the workers, so that one is always free for interactive work
+ * when there is more than one.
+ *
+ * Work items belong to the caller and are linked into the lanes as they
+ * are; the pool never allocates and does not touch an item again once
+ * its procedure has been called, so the procedure may free it.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+
+#include "misc.h"
+#include "os.h"
+#include "osdep.h"
+
+#define THREAD_POOL_MAX 16
+
+int threadPoolSize;             /* 0 sizes the pool from the CPU count */
+
+typedef struct _ThreadPoolLane {
+    ThreadPoolWork *head, **tail;
+    ThreadPoolStats stats;
+} ThreadPoolLaneRec;
+
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolCond = PTHREAD_COND_INITIALIZER;
+static ThreadPoolLaneRec poolLanes[ThreadPoolNumLanes];
+static int poolWorkers = -1;    /* -1 until the pool has been started */
+
+static const char *poolLaneNames[ThreadPoolNumLanes] = {
+    "interactive", "background"
+};
+
+static int
+ThreadPoolDefaultSize(void)
+{
+    int cpus = 1;
+
+#ifdef WIN32
+    DWORD_PTR process, system;
+
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system))
+        for (cpus = 0; process; process &= process - 1)
+            cpus++;
+#elif defined(CPU_COUNT)
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        cpus = CPU_COUNT(&set);
+#elif defined(_SC_NPROCESSORS_ONLN)
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    /* the dispatch thread has a CPU of its own */
+    return max(1, min(cpus - 1, THREAD_POOL_MAX));
+}
+
+/* Pre-condition: Called with poolMutex held */
+static ThreadPoolWork *
+ThreadPoolTake(void)
+{
+    ThreadPoolLaneRec *lane = &poolLanes[ThreadPoolInteractive];
+    ThreadPoolWork *work;
+
+    if (!lane->head) {
+        lane = &poolLanes[ThreadPoolBackground];
+        if (!lane->head || lane->stats.running >= max(1, poolWorkers - 1))
+            return NULL;
+    }
+
+    work = lane->head;
+    lane->head = work->next;
+    if (!lane->head)
+        lane->tail = &lane->head;
+    lane->stats.queued--;
+    lane->stats.running++;
+    work->pending = FALSE;
+    return work;
+}
+
+static void *
+ThreadPoolWorker(void *arg)
+{
+    pthread_mutex_lock(&poolMutex);
+    for (;;) {
+        ThreadPoolWork *work = ThreadPoolTake();
+        ThreadPoolProcPtr proc;
+        void *closure;
+        ThreadPoolStats *stats;
+        CARD32 wait;
+
+        if (!work) {
+            pthread_cond_wait(&poolCond, &poolMutex);
+            continue;
+        }
+
+        stats = &poolLanes[work->lane].stats;
+        wait = GetTimeInMillis() - work->queued;
+        stats->waitMs += wait;
+        if (wait > stats->maxWaitMs)
+            stats->maxWaitMs = wait;
+
+        proc = work->proc;
+        closure = work->closure;
+        pthread_mutex_unlock(&poolMutex);
+        (*proc) (closure);
+        pthread_mutex_lock(&poolMutex);
+
+        stats->running--;
+        stats->done++;
+    }
+    return NULL;
+}
+
+/* Pre-condition: Called with poolMutex held */
+static void
+ThreadPoolStart(void)
+{
+    int size = threadPoolSize > 0 ? min(threadPoolSize, THREAD_POOL_MAX) :
+        ThreadPoolDefaultSize();
+    int i;
+
+#ifdef SIG_BLOCK
+    sigset_t set, old;
+
+    /* Workers inherit the signal mask; keep all signals on the main thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, &old);
+#endif
+
+    for (i = 0; i < ThreadPoolNumLanes; i++)
+        poolLanes[i].tail = &poolLanes[i].head;
+
+    for (poolWorkers = 0; poolWorkers < size; poolWorkers++) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, ThreadPoolWorker, NULL) != 0) {
+            ErrorF("ThreadPool: could only start %d of %d threads\n",
+                   poolWorkers, size);
+            break;
+        }
+        pthread_detach(thread);
+    }
+
+#ifdef SIG_BLOCK
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+#endif
+}
+
+/*
+ * The number of worker threads, starting them if they are not running
+ * yet; 0 if none could be started.
+ */
+int
+ThreadPoolThreads(void)
+{
+    int workers;
+
+    pthread_mutex_lock(&poolMutex);
+    if (poolWorkers < 0)
+        ThreadPoolStart();
+    workers = poolWorkers;
+    pthread_mutex_unlock(&poolMutex);
+    return workers;
+}
+
+/*
+ * Queue WORK to call PROC with CLOSURE on a worker thread.  WORK must
+ * not already be queued.  Returns FALSE if the pool has no threads, in
+ * which case the caller has to do the work some other way.
+ */
+Bool
+ThreadPoolQueue(ThreadPoolWork *work, ThreadPoolLane lane,
+                ThreadPoolProcPtr proc, void *closure)
+{
+    ThreadPoolStats *stats = &poolLanes[lane].stats;
+
+    pthread_mutex_lock(&poolMutex);
+    if (poolWorkers < 0)
+        ThreadPoolStart();
+    if (poolWorkers == 0) {
+        pthread_mutex_unlock(&poolMutex);
+        return FALSE;
+    }
+
+    work->next = NULL;
+    work->proc = proc;
+    work->closure = closure;
+    work->queued = GetTimeInMillis();
+    work->lane = lane;
+    work->pending = TRUE;
+    *poolLanes[lane].tail = work;
+    poolLanes[lane].tail = &work->next;
+
+    if (++stats->queued > stats->maxQueued)
+        stats->maxQueued = stats->queued;
+    pthread_cond_signal(&poolCond);
+    pthread_mutex_unlock(&poolMutex);
+    return TRUE;
+}
+
+/*
+ * Take WORK back off its lane.  Returns TRUE if it had not been picked
+ * up, FALSE if a worker has started or finished it.
+ */
+Bool
+ThreadPoolCancel(ThreadPoolWork *work)
+{
+    ThreadPoolLaneRec *lane;
+    ThreadPoolWork **prev;
+
+    pthread_mutex_lock(&poolMutex);
+    if (!work->pending) {
+        pthread_mutex_unlock(&poolMutex);
+        return FALSE;
+    }
+
+    lane = &poolLanes[work->lane];
+    for (prev = &lane->head; *prev != work; prev = &(*prev)->next)
+        ;
+    *prev = work->next;
+    if (lane->tail == &work->next)
+        lane->tail = prev;
+    lane->stats.queued--;
+    work->pending = FALSE;
+    pthread_mutex_unlock(&poolMutex);
+    return TRUE;
+}
+
+void
+ThreadPoolGetStats(ThreadPoolLane lane, ThreadPoolStats *stats)
+{
+    pthread_mutex_lock(&poolMutex);
+    *stats = poolLanes[lane].stats;
+    pthread_mutex_unlock(&poolMutex);
+}
+
+/* Called from OsCleanup at the end of each server generation */
+void
+ThreadPoolLogStats(void)
+{
+    ThreadPoolStats stats;
+    int i;
+
+    if (poolWorkers <= 0)
+        return;
+
+    for (i = 0; i < ThreadPoolNumLanes; i++) {
+        ThreadPoolGetStats(i, &stats);
+        if (!stats.done)
+            continue;
+        LogMessageVerb(X_INFO, 3,
+                       "ThreadPool: %s: %lu done, queue max %d, "
+                       "wait avg %lu max %lu ms\n", poolLaneNames[i],
+                       stats.done, stats.maxQueued,
+                       stats.waitMs / stats.done, stats.maxWaitMs);
+    }
+}
@@ -145,6 +145,7 @@ Bool noMITShmExtension = FALSE;
 #ifdef RANDR
 Bool noRRExtension = FALSE;
 #endif
+Bool noImageCacheExtension = FALSE;
 Bool noRenderExtension = FALSE;
 Bool noShapeExtension = FALSE;
 
@@ -555,6 +556,8 @@ UseMsg(void)
     ErrorF("-cc int                default color visual class\n");
     ErrorF("-nocursor              disable the cursor\n");
     ErrorF("-core                  generate core dump on fatal error\n");
+    ErrorF("-damageinterval int    merge damage rectangle events over int msec\n");
+    ErrorF("-dispatchprofile       log per-request timings and per-client traffic\n");
     ErrorF("-displayfd fd          file descriptor to write display number to when ready to connect\n");
 #ifdef _MSC_VER
     ErrorF("-dpi [auto|int]        screen resolution set to native or this dpi\n");
@@ -609,9 +612,14 @@ UseMsg(void)
     ErrorF
         ("-dumbSched             Disable smart scheduling and threaded input, enable old behavior\n");
     ErrorF("-schedInterval int     Set scheduler interval in msec\n");
+    ErrorF("-schedInteractive      Cut time slices short for clients sent input\n");
     ErrorF("+extension name        Enable extension\n");
     ErrorF("-extension name        Disable extension\n");
     ListStaticExtensions();
+#ifdef TLSCONN
+    ErrorF("-tlscert file          PEM certificate chain for -listen tls\n");
+    ErrorF("-tlskey file           PEM private key, if not in the -tlscert file\n");
+#endif
 #ifdef HYPERV
     ErrorF("-vmid GUID             Hyper-V VM GUID to accept VSock connections from\n");
     ErrorF("-vsockport port        integer port number to listen for VSock connections.  Default 106000.\n");
@@ -677,6 +685,12 @@ static const char *defaultNoListenList[] = {
 #ifndef LISTEN_TCP
     "tcp",
 #endif
+#ifdef TCPZCONN
+    "tcpz",
+#endif
+#ifdef TLSCONN
+    "tls",
+#endif
 #if !defined(LISTEN_UNIX) && defined(UNIXCONN)
     "unix",
 #endif
@@ -800,6 +814,15 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-damageinterval") == 0) {
+            if (++i < argc)
+                damageReportInterval = (CARD32) atoi(argv[i]);
+            else
+                UseMsg();
+        }
+        else if (strcmp(argv[i], "-dispatchprofile") == 0) {
+            dispatchProfile = TRUE;
+        }
         else if (strcmp(argv[i], "-displayfd") == 0) {
             if (++i < argc) {
                 displayfd = atoi(argv[i]);
@@ -1048,6 +1071,9 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-schedInteractive") == 0) {
+            SmartScheduleInteractive = TRUE;
+        }
         else if (strcmp(argv[i], "-schedMax") == 0) {
             if (++i < argc) {
                 SmartScheduleMaxSlice = atoi(argv[i]);
@@ -1083,6 +1109,20 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+#ifdef TLSCONN
+        else if (strcmp(argv[i], "-tlscert") == 0) {
+            if (++i < argc)
+                TLSCertFile = argv[i];
+            else
+                UseMsg();
+        }
+        else if (strcmp(argv[i], "-tlskey") == 0) {
+            if (++i < argc)
+                TLSKeyFile = argv[i];
+            else
+                UseMsg();
+        }
+#endif
 #ifdef HYPERV
         else if(strcmp(argv[i], "-vmid") == 0)
         {
@@ -0,0 +1,35 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * The TraceLogging provider behind wintrace.h.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include "wintrace.h"
+
+#ifdef _MSC_VER
+
+/*
+ * {1d305b44-0559-5fe2-b730-65f2de4703f3} is the GUID ETW derives from the
+ * name, so tools that only know "VcXsrv.XServer" find the same provider.
+ */
+TRACELOGGING_DEFINE_PROVIDER(WinTraceProvider, "VcXsrv.XServer",
+    (0x1d305b44, 0x0559, 0x5fe2,
+     0xb7, 0x30, 0x65, 0xf2, 0xde, 0x47, 0x03, 0xf3));
+
+void
+WinTraceInit(void)
+{
+    TraceLoggingRegister(WinTraceProvider);
+}
+
+void
+WinTraceFini(void)
+{
+    TraceLoggingUnregister(WinTraceProvider);
+}
+
+#endif
@@ -162,7 +162,9 @@ static void recv_failed_msg(unsigned    length);
 
 static void send_keepalive_msg(void);
 
-static void recv_alive_msg(unsigned     length );
+static void recv_alive_msg(struct sockaddr    *from,
+                           int                fromlen,
+                           unsigned           length );
 
 static void XdmcpFatal(const char       *type,
                        ARRAY8Ptr        status);
@@ -214,6 +216,10 @@ XdmcpRegisterManufacturerDisplayID(const char *name, int length)
 static unsigned short xdm_udp_port = XDM_UDP_PORT;
 static Bool OneSession = FALSE;
 static const char *xdm_from = NULL;
+static int KeepaliveDormancy = XDM_DEF_DORMANCY;
+static int KeepaliveRetries = XDM_KA_RTX_LIMIT;
+static Bool KeepaliveResume = FALSE;
+static Bool SessionLost = FALSE;
 
 void
 XdmcpUseMsg(void)
@@ -233,6 +239,9 @@ XdmcpUseMsg(void)
     ErrorF("-cookie xdm-auth-bits  specify the magic cookie for XDMCP\n");
 #endif
     ErrorF("-displayID display-id  manufacturer display ID for request\n");
+    ErrorF("-xdmcpalive seconds    interval between session keepalives\n");
+    ErrorF("-xdmcpretries count    unanswered keepalives before giving up\n");
+    ErrorF("-xdmcpresume           keep the session when keepalives fail\n");
 }
 
 static void
@@ -313,6 +322,24 @@ XdmcpOptions(int argc, char **argv, int i)
         XdmcpRegisterManufacturerDisplayID(argv[i], strlen(argv[i]));
         return i + 1;
     }
+    if (strcmp(argv[i], "-xdmcpalive") == 0) {
+        if (++i == argc || atoi(argv[i]) <= 0) {
+            FatalError("Xserver: missing keepalive interval in command line\n");
+        }
+        KeepaliveDormancy = atoi(argv[i]);
+        return i + 1;
+    }
+    if (strcmp(argv[i], "-xdmcpretries") == 0) {
+        if (++i == argc || atoi(argv[i]) <= 0) {
+            FatalError("Xserver: missing keepalive retries in command line\n");
+        }
+        KeepaliveRetries = atoi(argv[i]);
+        return i + 1;
+    }
+    if (strcmp(argv[i], "-xdmcpresume") == 0) {
+        KeepaliveResume = TRUE;
+        return i + 1;
+    }
     return i;
 }
 
@@ -572,6 +599,7 @@ static void
 xdmcp_reset(void)
 {
     timeOutRtx = 0;
+    SessionLost = FALSE;
     if (xdmcpSocket >= 0)
         SetNotifyFd(xdmcpSocket, XdmcpSocketNotify, X_NOTIFY_READ, NULL);
 #if defined(IPv6) && defined(AF_INET6)
@@ -658,7 +686,7 @@ XdmcpOpenDisplay(int sock)
     if (state != XDM_AWAIT_MANAGE_RESPONSE)
         return;
     state = XDM_RUN_SESSION;
-    TimerSet(xdmcp_timer, 0, XDM_DEF_DORMANCY * 1000, XdmcpTimerNotify, NULL);
+    TimerSet(xdmcp_timer, 0, KeepaliveDormancy * 1000, XdmcpTimerNotify, NULL);
     sessionSocket = sock;
 }
 
@@ -859,7 +887,7 @@ receive_packet(int socketfd)
         recv_failed_msg(header.length);
         break;
     case ALIVE:
-        recv_alive_msg(header.length);
+        recv_alive_msg((struct sockaddr *) &from, fromlen, header.length);
         break;
     }
 }
@@ -871,7 +899,7 @@ receive_packet(int socketfd)
 static void
 send_packet(void)
 {
-    int rtx;
+    int rtx, i;
 
     switch (state) {
     case XDM_QUERY:
@@ -894,7 +922,9 @@ send_packet(void)
     default:
         break;
     }
-    rtx = (XDM_MIN_RTX << timeOutRtx);
+    rtx = XDM_MIN_RTX;
+    for (i = 0; i < timeOutRtx && rtx < XDM_MAX_RTX; i++)
+        rtx <<= 1;
     if (rtx > XDM_MAX_RTX)
         rtx = XDM_MAX_RTX;
     TimerSet(xdmcp_timer, 0, rtx * 1000, XdmcpTimerNotify, NULL);
@@ -914,9 +944,41 @@ XdmcpDeadSession(const char *reason)
     dispatchException |= (OneSession ? DE_TERMINATE : DE_RESET);
     TimerCancel(xdmcp_timer);
     timeOutRtx = 0;
+    SessionLost = FALSE;
     send_packet();
 }
 
+/*
+ * Keepalives went unanswered and -xdmcpresume was given: keep the session
+ * and its clients, and keep asking at the longest retransmission interval.
+ * The first answer rebinds the session to the address it came from.  If
+ * the manager was queried by name, its other addresses are tried in turn
+ * in case the one it answered on went away.
+ */
+
+static void
+XdmcpSessionLost(void)
+{
+    if (!SessionLost) {
+        ErrorF("XDM: no keepalive response, holding the session\n");
+        SessionLost = TRUE;
+    }
+#if defined(IPv6) && defined(AF_INET6)
+    if (XDM_INIT_STATE == XDM_QUERY && mgrAddrFirst) {
+        for (mgrAddr = mgrAddr ? mgrAddr->ai_next : mgrAddrFirst;;
+             mgrAddr = mgrAddr->ai_next) {
+            if (mgrAddr == NULL) {
+                mgrAddr = mgrAddrFirst;
+            }
+            if (mgrAddr->ai_family == AF_INET || mgrAddr->ai_family == AF_INET6)
+                break;
+        }
+        memcpy(&req_sockaddr, mgrAddr->ai_addr, mgrAddr->ai_addrlen);
+        req_socklen = mgrAddr->ai_addrlen;
+    }
+#endif
+}
+
 /*
  * Timeout waiting for an XDMCP response.
  */
@@ -925,9 +987,14 @@ static void
 timeout(void)
 {
     timeOutRtx++;
-    if (state == XDM_AWAIT_ALIVE_RESPONSE && timeOutRtx >= XDM_KA_RTX_LIMIT) {
-        XdmcpDeadSession("too many keepalive retransmissions");
-        return;
+    if (state == XDM_AWAIT_ALIVE_RESPONSE) {
+        if (timeOutRtx >= KeepaliveRetries) {
+            if (!KeepaliveResume) {
+                XdmcpDeadSession("too many keepalive retransmissions");
+                return;
+            }
+            XdmcpSessionLost();
+        }
     }
     else if (timeOutRtx >= XDM_RTX_LIMIT) {
         /* Quit if "-once" specified, otherwise reset and try again. */
@@ -1416,7 +1483,7 @@ send_keepalive_msg(void)
 }
 
 static void
-recv_alive_msg(unsigned length)
+recv_alive_msg(struct sockaddr *from, int fromlen, unsigned length)
 {
     CARD8 SessionRunning;
     CARD32 AliveSessionID;
@@ -1428,8 +1495,14 @@ recv_alive_msg(unsigned length)
     if (XdmcpReadCARD8(&buffer, &SessionRunning) &&
         XdmcpReadCARD32(&buffer, &AliveSessionID)) {
         if (/*SessionRunning && */ AliveSessionID == SessionID) { // For one reason or another, we always receive 0 for SessionRunning????, even if the session is still running
+            if (SessionLost) {
+                ErrorF("XDM: keepalive answered, session resumed\n");
+                SessionLost = FALSE;
+                memmove(&req_sockaddr, from, fromlen);
+                req_socklen = fromlen;
+            }
             state = XDM_RUN_SESSION;
-            TimerSet(xdmcp_timer, 0, XDM_DEF_DORMANCY * 1000, XdmcpTimerNotify, NULL);
+            TimerSet(xdmcp_timer, 0, KeepaliveDormancy * 1000, XdmcpTimerNotify, NULL);
         }
         else {
             XdmcpDeadSession("Alive response indicates session dead");
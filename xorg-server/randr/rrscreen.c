@@ -65,6 +65,7 @@ RREditConnectionInfo(ScreenPtr pScreen)
     root->pixHeight = pScreen->height;
     root->mmWidth = pScreen->mmWidth;
     root->mmHeight = pScreen->mmHeight;
+    InvalidateConnSetupCache();
 }
 
 void
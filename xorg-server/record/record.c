@@ -61,9 +61,11 @@ and Jim Haggerty of Metheus.
 static RESTYPE RTContext;       /* internal resource type for Record contexts */
 
 /* How many bytes of protocol data to buffer in a context. Don't set to less
- * than 32.
+ * than 32.  A buffer is only written out when it fills, when the recorded
+ * client or category changes, and when the server flushes output, so a
+ * larger buffer means fewer, bigger writes to busy recording clients.
  */
-#define REPLY_BUF_SIZE 1024
+#define REPLY_BUF_SIZE 16384
 
 /* Record Context structure */
 
@@ -750,6 +752,29 @@ RecordSendProtocolEvents(RecordClientsAndProtocolPtr pRCAP,
 
 }                               /* RecordADeviceEvent */
 
+/* RecordSetHasMemberInRange
+ *
+ * Arguments:
+ *	pSet is the set to look in.
+ *	first and last bound the range of possible members.
+ *
+ * Returns: TRUE if any member of pSet is between first and last inclusive.
+ */
+static Bool
+RecordSetHasMemberInRange(RecordSetPtr pSet, int first, int last)
+{
+    RecordSetIteratePtr pIter = NULL;
+    RecordSetInterval interval;
+
+    while ((pIter = RecordIterateSet(pSet, pIter, &interval))) {
+        if (interval.first > last)
+            break;
+        if (interval.last >= first)
+            return TRUE;
+    }
+    return FALSE;
+}                               /* RecordSetHasMemberInRange */
+
 /* RecordADeviceEvent
  *
  * Arguments:
@@ -779,8 +804,19 @@ RecordADeviceEvent(CallbackListPtr *pcbl, void *nulldata, void *calldata)
                 int count;
                 xEvent *xi_events = NULL;
 
+                /* Don't convert the event to protocol that would only be
+                 * thrown away: core input events are KeyPress through
+                 * MotionNotify, the XI ones are all extension events.
+                 */
+                Bool wantCore = RecordSetHasMemberInRange(pRCAP->pDeviceEventSet,
+                                                          KeyPress,
+                                                          MotionNotify);
+                Bool wantXI = RecordSetHasMemberInRange(pRCAP->pDeviceEventSet,
+                                                        EXTENSION_EVENT_BASE,
+                                                        127);
+
                 /* TODO check return values */
-                if (IsMaster(pei->device)) {
+                if (wantCore && IsMaster(pei->device)) {
                     xEvent *core_events;
 
                     EventToCore(pei->event, &core_events, &count);
@@ -789,9 +825,12 @@ RecordADeviceEvent(CallbackListPtr *pcbl, void *nulldata, void *calldata)
                     free(core_events);
                 }
 
-                EventToXI(pei->event, &xi_events, &count);
-                RecordSendProtocolEvents(pRCAP, pContext, xi_events, count);
-                free(xi_events);
+                if (wantXI) {
+                    EventToXI(pei->event, &xi_events, &count);
+                    RecordSendProtocolEvents(pRCAP, pContext, xi_events,
+                                             count);
+                    free(xi_events);
+                }
             }                   /* end this RCAP selects device events */
         }                       /* end for each RCAP on this context */
     }                           /* end for each enabled context */
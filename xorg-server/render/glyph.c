@@ -26,8 +26,6 @@
 #include <dix-config.h>
 #endif
 
-#include "xsha1.h"
-
 #include "misc.h"
 #include "scrnintstr.h"
 #include "os.h"
@@ -46,36 +44,38 @@
 #include "mipict.h"
 
 /*
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
+ * Tables are powers of two kept at most half full, so that a probe starts
+ * at (signature & mask) and open addressing stays short even when a
+ * client adds thousands of glyphs at once.  The global signatures come
+ * from a well mixed hash and the per-set ones are glyph ids, which are
+ * mostly dense, so the low bits are good enough for both.  rehash holds
+ * the mask; an odd step visits every slot of a power of two table.
  */
 static GlyphHashSetRec glyphHashSets[] = {
-    {32, 43, 41},
-    {64, 73, 71},
-    {128, 151, 149},
-    {256, 283, 281},
-    {512, 571, 569},
-    {1024, 1153, 1151},
-    {2048, 2269, 2267},
-    {4096, 4519, 4517},
-    {8192, 9013, 9011},
-    {16384, 18043, 18041},
-    {32768, 36109, 36107},
-    {65536, 72091, 72089},
-    {131072, 144409, 144407},
-    {262144, 288361, 288359},
-    {524288, 576883, 576881},
-    {1048576, 1153459, 1153457},
-    {2097152, 2307163, 2307161},
-    {4194304, 4613893, 4613891},
-    {8388608, 9227641, 9227639},
-    {16777216, 18455029, 18455027},
-    {33554432, 36911011, 36911009},
-    {67108864, 73819861, 73819859},
-    {134217728, 147639589, 147639587},
-    {268435456, 295279081, 295279079},
-    {536870912, 590559793, 590559791}
+    {32, 64, 63},
+    {64, 128, 127},
+    {128, 256, 255},
+    {256, 512, 511},
+    {512, 1024, 1023},
+    {1024, 2048, 2047},
+    {2048, 4096, 4095},
+    {4096, 8192, 8191},
+    {8192, 16384, 16383},
+    {16384, 32768, 32767},
+    {32768, 65536, 65535},
+    {65536, 131072, 131071},
+    {131072, 262144, 262143},
+    {262144, 524288, 524287},
+    {524288, 1048576, 1048575},
+    {1048576, 2097152, 2097151},
+    {2097152, 4194304, 4194303},
+    {4194304, 8388608, 8388607},
+    {8388608, 16777216, 16777215},
+    {16777216, 33554432, 33554431},
+    {33554432, 67108864, 67108863},
+    {67108864, 134217728, 134217727},
+    {134217728, 268435456, 268435455},
+    {268435456, 536870912, 536870911}
 };
 
 #define NGLYPHHASHSETS	ARRAY_SIZE(glyphHashSets)
@@ -124,10 +124,9 @@ FindGlyphRef(GlyphHashPtr hash,
     CARD32 elt, step, s;
     GlyphPtr glyph;
     GlyphRefPtr table, gr, del;
-    CARD32 tableSize = hash->hashSet->size;
 
     table = hash->table;
-    elt = signature % tableSize;
+    elt = signature & hash->hashSet->rehash;
     step = 0;
     del = 0;
     for (;;) {
@@ -149,37 +148,111 @@ FindGlyphRef(GlyphHashPtr hash,
                  (!match || memcmp(glyph->sha1, sha1, 20) == 0)) {
             break;
         }
-        if (!step) {
-            step = signature % hash->hashSet->rehash;
-            if (!step)
-                step = 1;
-        }
-        elt += step;
-        if (elt >= tableSize)
-            elt -= tableSize;
+        if (!step)
+            step = (signature >> 16) | 1;
+        elt = (elt + step) & hash->hashSet->rehash;
     }
     return gr;
 }
 
+/*
+ * Glyph uploads are deduplicated across glyph sets by a 128-bit hash of
+ * the glyph metrics and image, so the hash runs over every byte a client
+ * sends.  It used to be SHA1, which shows up clearly when applications add
+ * thousands of glyphs at startup.  This is MurmurHash3 (x64, 128-bit),
+ * chained over the two pieces of input; it is keyed with a per-server
+ * seed so that a client cannot easily craft another client's glyph.
+ */
+static uint64_t glyphHashSeed;
+
+static inline uint64_t
+GlyphHashRotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+GlyphHashMix(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static void
+GlyphHashBytes(const void *data, size_t len, uint64_t h[2])
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    const CARD8 *p = data;
+    uint64_t h1 = h[0], h2 = h[1];
+    uint64_t k1, k2;
+    size_t n;
+
+    for (n = len / 16; n; n--, p += 16) {
+        memcpy(&k1, p, 8);
+        memcpy(&k2, p + 8, 8);
+
+        k1 *= c1; k1 = GlyphHashRotl(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = GlyphHashRotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = GlyphHashRotl(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = GlyphHashRotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    k1 = k2 = 0;
+    switch (len & 15) {
+    case 15: k2 ^= (uint64_t) p[14] << 48;
+    case 14: k2 ^= (uint64_t) p[13] << 40;
+    case 13: k2 ^= (uint64_t) p[12] << 32;
+    case 12: k2 ^= (uint64_t) p[11] << 24;
+    case 11: k2 ^= (uint64_t) p[10] << 16;
+    case 10: k2 ^= (uint64_t) p[9] << 8;
+    case 9:  k2 ^= (uint64_t) p[8];
+        k2 *= c2; k2 = GlyphHashRotl(k2, 33); k2 *= c1; h2 ^= k2;
+    case 8:  k1 ^= (uint64_t) p[7] << 56;
+    case 7:  k1 ^= (uint64_t) p[6] << 48;
+    case 6:  k1 ^= (uint64_t) p[5] << 40;
+    case 5:  k1 ^= (uint64_t) p[4] << 32;
+    case 4:  k1 ^= (uint64_t) p[3] << 24;
+    case 3:  k1 ^= (uint64_t) p[2] << 16;
+    case 2:  k1 ^= (uint64_t) p[1] << 8;
+    case 1:  k1 ^= (uint64_t) p[0];
+        k1 *= c1; k1 = GlyphHashRotl(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = GlyphHashMix(h1);
+    h2 = GlyphHashMix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    h[0] = h1;
+    h[1] = h2;
+}
+
 int
 HashGlyph(xGlyphInfo * gi,
           CARD8 *bits, unsigned long size, unsigned char sha1[20])
 {
-    void *ctx = x_sha1_init();
-    int success;
-
-    if (!ctx)
-        return BadAlloc;
-
-    success = x_sha1_update(ctx, gi, sizeof(xGlyphInfo));
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_update(ctx, bits, size);
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_final(ctx, sha1);
-    if (!success)
-        return BadAlloc;
+    uint64_t h[2];
+
+    if (!glyphHashSeed)
+        glyphHashSeed = GlyphHashMix(GetTimeInMicros() ^
+                                     (uintptr_t) &glyphHashSeed) | 1;
+
+    h[0] = h[1] = glyphHashSeed;
+    GlyphHashBytes(gi, sizeof(xGlyphInfo), h);
+    GlyphHashBytes(bits, size, h);
+
+    /* The signature used for the hash tables is the first word */
+    memcpy(sha1, h, 16);
+    memset(sha1 + 16, 0, 4);
     return Success;
 }
 
@@ -494,6 +567,47 @@ FreeGlyphSet(void *value, XID gid)
     return Success;
 }
 
+/**
+ * Estimate the memory behind a glyph set: each glyph's bits and its
+ * per-screen pictures.  Glyphs are shared between sets with the same
+ * contents, so every set is charged its share of them.
+ */
+void
+GetGlyphSetBytes(void *value, XID id, ResourceSizePtr size)
+{
+    GlyphSetPtr glyphSet = value;
+    SizeType pixmapSizeFunc = GetResourceTypeSizeFunc(RT_PIXMAP);
+    CARD32 i, tableSize = glyphSet->hash.hashSet->size;
+    GlyphRefPtr table = glyphSet->hash.table;
+    unsigned long bytes = 0;
+
+    for (i = 0; i < tableSize; i++) {
+        GlyphPtr glyph = table[i].glyph;
+        unsigned long glyphBytes;
+        int s;
+
+        if (!glyph || glyph == DeletedGlyph)
+            continue;
+        glyphBytes = glyph->size;
+        for (s = 0; s < screenInfo.numScreens; s++) {
+            PicturePtr picture = GlyphPicture(glyph)[s];
+            ResourceSizeRec pixmapSize = { 0, 0, 0 };
+
+            if (!picture || !picture->pDrawable ||
+                picture->pDrawable->type != DRAWABLE_PIXMAP)
+                continue;
+            pixmapSizeFunc(picture->pDrawable, picture->pDrawable->id,
+                           &pixmapSize);
+            glyphBytes += pixmapSize.resourceSize;
+        }
+        bytes += glyphBytes / glyph->refcnt;
+    }
+
+    size->resourceSize = bytes;
+    size->pixmapRefSize = 0;
+    size->refCnt = glyphSet->refcnt;
+}
+
 static void
 GlyphExtents(int nlist, GlyphListPtr list, GlyphPtr * glyphs, BoxPtr extents)
 {
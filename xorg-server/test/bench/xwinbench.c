@@ -0,0 +1,694 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Fixed workloads against a running server, for comparing builds.
+ *
+ * Each workload is run in batches, with a round trip after every batch,
+ * until it has taken the requested time.  The data drawn is the same on
+ * every run.  One JSON object is written per line: first a description of
+ * the server, then one result per workload.  Run XWin with -shadowlog to
+ * have the server record how long each frame took to reach the screen.
+ *
+ *   xwinbench [-display name] [-time seconds] [workload ...]
+ */
+
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/render.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+#define WIN_SIZE        512
+#define IMAGE_SIZE      128
+#define NUM_CHILDREN    64
+#define NUM_GLYPHS      64
+#define GLYPH_WIDTH     10
+#define GLYPH_HEIGHT    16
+#define PASTE_SIZE      (64 * 1024)
+
+struct bench {
+    const char *display;
+    xcb_connection_t *c;
+    xcb_screen_t *screen;
+    xcb_window_t win;
+    xcb_gcontext_t gc;
+    xcb_font_t font;
+    int bpp, pad;
+
+    /* RENDER */
+    xcb_render_pictformat_t argb32, a8, win_format;
+    xcb_render_picture_t win_pict, src_pict, solid_pict;
+    xcb_render_glyphset_t glyphs;
+
+    /* clipboard */
+    xcb_connection_t *owner;
+    xcb_window_t owner_win;
+    xcb_atom_t clipboard, utf8_string, targets, property;
+    uint8_t *paste;
+
+    /* map storms */
+    xcb_window_t children[NUM_CHILDREN];
+};
+
+struct workload {
+    const char *name;
+    int (*setup)(struct bench *b);
+    void (*run)(struct bench *b, int reps);
+};
+
+static uint32_t seed;
+
+/* Same sequence on every run */
+static uint32_t
+next_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+round_trip(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static xcb_atom_t
+intern(xcb_connection_t *c, const char *name)
+{
+    xcb_intern_atom_reply_t *reply;
+    xcb_atom_t atom = XCB_NONE;
+
+    reply = xcb_intern_atom_reply(c, xcb_intern_atom(c, 0, strlen(name), name),
+                                  NULL);
+    if (reply)
+        atom = reply->atom;
+    free(reply);
+    return atom;
+}
+
+/* core text */
+
+static int
+text_setup(struct bench *b)
+{
+    static const char name[] = "fixed";
+    xcb_generic_error_t *error;
+
+    b->font = xcb_generate_id(b->c);
+    error = xcb_request_check(b->c, xcb_open_font_checked(b->c, b->font,
+                                                          strlen(name), name));
+    if (error) {
+        free(error);
+        return 0;
+    }
+    xcb_change_gc(b->c, b->gc, XCB_GC_FONT, &b->font);
+    return 1;
+}
+
+static void
+text_run(struct bench *b, int reps)
+{
+    char line[80];
+    int i, j;
+
+    for (i = 0; i < reps; i++) {
+        for (j = 0; j < sizeof(line); j++)
+            line[j] = ' ' + next_random() % 95;
+        xcb_image_text_8(b->c, sizeof(line), b->win, b->gc, 0,
+                         13 + (i % 38) * 13, line);
+    }
+}
+
+/* CopyArea scrolling */
+
+static int
+no_setup(struct bench *b)
+{
+    return 1;
+}
+
+static void
+scroll_run(struct bench *b, int reps)
+{
+    int i;
+
+    for (i = 0; i < reps; i++)
+        xcb_copy_area(b->c, b->win, b->win, b->gc, 0, 16, 0, 0,
+                      WIN_SIZE, WIN_SIZE - 16);
+}
+
+/* PutImage and GetImage */
+
+static int
+putimage_setup(struct bench *b)
+{
+    return b->bpp != 0;
+}
+
+static void
+putimage_run(struct bench *b, int reps)
+{
+    int stride = (IMAGE_SIZE * b->bpp + b->pad - 1) / b->pad * b->pad / 8;
+    uint8_t *data = malloc(stride * IMAGE_SIZE);
+    int i, j;
+
+    if (!data)
+        return;
+    for (i = 0; i < reps; i++) {
+        /* stride * IMAGE_SIZE is a multiple of 4 */
+        for (j = 0; j < stride * IMAGE_SIZE; j += 4) {
+            uint32_t v = next_random();
+
+            memcpy(data + j, &v, 4);
+        }
+        xcb_put_image(b->c, XCB_IMAGE_FORMAT_Z_PIXMAP, b->win, b->gc,
+                      IMAGE_SIZE, IMAGE_SIZE,
+                      (i % 4) * IMAGE_SIZE, (i / 4 % 4) * IMAGE_SIZE,
+                      0, b->screen->root_depth, stride * IMAGE_SIZE, data);
+    }
+    free(data);
+}
+
+static void
+getimage_run(struct bench *b, int reps)
+{
+    int i;
+
+    for (i = 0; i < reps; i++)
+        free(xcb_get_image_reply(b->c,
+                                 xcb_get_image(b->c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                               b->win, (i % 4) * IMAGE_SIZE,
+                                               0, IMAGE_SIZE, IMAGE_SIZE,
+                                               ~0),
+                                 NULL));
+}
+
+/* RENDER */
+
+static int
+render_setup(struct bench *b)
+{
+    const xcb_query_extension_reply_t *ext;
+    xcb_render_query_pict_formats_reply_t *formats;
+    xcb_render_pictforminfo_iterator_t fi;
+    xcb_render_pictscreen_iterator_t si;
+    xcb_pixmap_t pixmap;
+    xcb_render_color_t color;
+    xcb_rectangle_t rect;
+    int i;
+
+    if (b->win_pict)
+        return 1;
+
+    ext = xcb_get_extension_data(b->c, &xcb_render_id);
+    if (!ext || !ext->present)
+        return 0;
+    formats = xcb_render_query_pict_formats_reply(b->c,
+                  xcb_render_query_pict_formats(b->c), NULL);
+    if (!formats)
+        return 0;
+
+    for (fi = xcb_render_query_pict_formats_formats_iterator(formats);
+         fi.rem; xcb_render_pictforminfo_next(&fi)) {
+        const xcb_render_directformat_t *d = &fi.data->direct;
+
+        if (fi.data->type != XCB_RENDER_PICT_TYPE_DIRECT ||
+            d->alpha_mask != 0xff)
+            continue;
+        if (fi.data->depth == 32 && d->alpha_shift == 24 &&
+            d->red_shift == 16 && d->green_shift == 8 && d->blue_shift == 0)
+            b->argb32 = fi.data->id;
+        else if (fi.data->depth == 8 && !d->red_mask)
+            b->a8 = fi.data->id;
+    }
+    for (si = xcb_render_query_pict_formats_screens_iterator(formats);
+         si.rem; xcb_render_pictscreen_next(&si)) {
+        xcb_render_pictdepth_iterator_t di;
+
+        for (di = xcb_render_pictscreen_depths_iterator(si.data);
+             di.rem; xcb_render_pictdepth_next(&di)) {
+            xcb_render_pictvisual_iterator_t vi;
+
+            for (vi = xcb_render_pictdepth_visuals_iterator(di.data);
+                 vi.rem; xcb_render_pictvisual_next(&vi))
+                if (vi.data->visual == b->screen->root_visual)
+                    b->win_format = vi.data->format;
+        }
+    }
+    free(formats);
+    if (!b->argb32 || !b->a8 || !b->win_format)
+        return 0;
+
+    b->win_pict = xcb_generate_id(b->c);
+    xcb_render_create_picture(b->c, b->win_pict, b->win, b->win_format,
+                              0, NULL);
+
+    /* Translucent source with some structure */
+    pixmap = xcb_generate_id(b->c);
+    xcb_create_pixmap(b->c, 32, pixmap, b->win, IMAGE_SIZE, IMAGE_SIZE);
+    b->src_pict = xcb_generate_id(b->c);
+    xcb_render_create_picture(b->c, b->src_pict, pixmap, b->argb32, 0, NULL);
+    xcb_free_pixmap(b->c, pixmap);
+    for (i = 0; i < 8; i++) {
+        color.alpha = 0x4000 + i * 0x1000;
+        color.red = color.alpha * (i & 1);
+        color.green = color.alpha * (i >> 1 & 1);
+        color.blue = color.alpha * (i >> 2 & 1);
+        rect.x = i * IMAGE_SIZE / 16;
+        rect.y = i * IMAGE_SIZE / 16;
+        rect.width = IMAGE_SIZE - 2 * rect.x;
+        rect.height = IMAGE_SIZE - 2 * rect.y;
+        xcb_render_fill_rectangles(b->c, XCB_RENDER_PICT_OP_SRC, b->src_pict,
+                                   color, 1, &rect);
+    }
+
+    color.red = 0x2000;
+    color.green = 0x8000;
+    color.blue = 0xc000;
+    color.alpha = 0xffff;
+    b->solid_pict = xcb_generate_id(b->c);
+    xcb_render_create_solid_fill(b->c, b->solid_pict, color);
+    return 1;
+}
+
+static void
+composite_run(struct bench *b, int reps)
+{
+    int i;
+
+    for (i = 0; i < reps; i++)
+        xcb_render_composite(b->c, XCB_RENDER_PICT_OP_OVER, b->src_pict,
+                             XCB_NONE, b->win_pict, 0, 0, 0, 0,
+                             next_random() % (WIN_SIZE - IMAGE_SIZE),
+                             next_random() % (WIN_SIZE - IMAGE_SIZE),
+                             IMAGE_SIZE, IMAGE_SIZE);
+}
+
+static int
+glyphs_setup(struct bench *b)
+{
+    int stride = (GLYPH_WIDTH + 3) & ~3;
+    uint32_t ids[NUM_GLYPHS];
+    xcb_render_glyphinfo_t info[NUM_GLYPHS];
+    uint8_t *data;
+    int i, j;
+
+    if (!render_setup(b))
+        return 0;
+
+    data = calloc(NUM_GLYPHS, stride * GLYPH_HEIGHT);
+    if (!data)
+        return 0;
+    for (i = 0; i < NUM_GLYPHS; i++) {
+        ids[i] = i;
+        info[i].width = GLYPH_WIDTH;
+        info[i].height = GLYPH_HEIGHT;
+        info[i].x = 0;
+        info[i].y = GLYPH_HEIGHT - 4;
+        info[i].x_off = GLYPH_WIDTH;
+        info[i].y_off = 0;
+        for (j = 0; j < GLYPH_HEIGHT * stride; j++)
+            if (j % stride < GLYPH_WIDTH)
+                data[i * stride * GLYPH_HEIGHT + j] = next_random();
+    }
+
+    b->glyphs = xcb_generate_id(b->c);
+    xcb_render_create_glyph_set(b->c, b->glyphs, b->a8);
+    xcb_render_add_glyphs(b->c, b->glyphs, NUM_GLYPHS, ids, info,
+                          NUM_GLYPHS * stride * GLYPH_HEIGHT, data);
+    free(data);
+    return 1;
+}
+
+static void
+glyphs_run(struct bench *b, int reps)
+{
+    /* One element: 8 byte header, then a byte per glyph */
+    uint8_t cmd[8 + 48];
+    int16_t dx, dy;
+    int i, j;
+
+    for (i = 0; i < reps; i++) {
+        memset(cmd, 0, 8);
+        cmd[0] = 48;
+        dx = 0;
+        dy = 13 + (i % 38) * 13;
+        memcpy(cmd + 4, &dx, 2);
+        memcpy(cmd + 6, &dy, 2);
+        for (j = 0; j < 48; j++)
+            cmd[8 + j] = next_random() % NUM_GLYPHS;
+        xcb_render_composite_glyphs_8(b->c, XCB_RENDER_PICT_OP_OVER,
+                                      b->solid_pict, b->win_pict, b->a8,
+                                      b->glyphs, 0, 0, sizeof(cmd), cmd);
+    }
+}
+
+/* Window map storms */
+
+static int
+children_setup(struct bench *b)
+{
+    uint32_t values[1];
+    int i;
+
+    for (i = 0; i < NUM_CHILDREN; i++) {
+        values[0] = next_random() & 0xffffff;
+        b->children[i] = xcb_generate_id(b->c);
+        xcb_create_window(b->c, XCB_COPY_FROM_PARENT, b->children[i], b->win,
+                          (i % 8) * (WIN_SIZE / 8), (i / 8) * (WIN_SIZE / 8),
+                          WIN_SIZE / 8 - 4, WIN_SIZE / 8 - 4, 1,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          XCB_COPY_FROM_PARENT, XCB_CW_BACK_PIXEL, values);
+    }
+    return 1;
+}
+
+static void
+children_run(struct bench *b, int reps)
+{
+    int i;
+
+    for (i = 0; i < reps; i++) {
+        xcb_map_subwindows(b->c, b->win);
+        xcb_unmap_subwindows(b->c, b->win);
+    }
+}
+
+/* Top-level windows, which get a Windows window each in multiwindow mode */
+static void
+toplevel_run(struct bench *b, int reps)
+{
+    uint32_t values[1] = { b->screen->white_pixel };
+    int i;
+
+    for (i = 0; i < reps; i++) {
+        xcb_window_t w = xcb_generate_id(b->c);
+
+        xcb_create_window(b->c, XCB_COPY_FROM_PARENT, w, b->screen->root,
+                          next_random() % 256, next_random() % 256, 200, 150,
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          XCB_COPY_FROM_PARENT, XCB_CW_BACK_PIXEL, values);
+        xcb_map_window(b->c, w);
+        xcb_destroy_window(b->c, w);
+    }
+}
+
+/* Clipboard pastes, between two connections of this process */
+
+static int
+paste_setup(struct bench *b)
+{
+    xcb_get_selection_owner_reply_t *reply;
+    int i;
+
+    b->owner = xcb_connect(b->display, NULL);
+    if (xcb_connection_has_error(b->owner))
+        return 0;
+
+    b->clipboard = intern(b->c, "CLIPBOARD");
+    b->utf8_string = intern(b->c, "UTF8_STRING");
+    b->targets = intern(b->c, "TARGETS");
+    b->property = intern(b->c, "XWINBENCH_PASTE");
+
+    b->paste = malloc(PASTE_SIZE);
+    if (!b->paste)
+        return 0;
+    for (i = 0; i < PASTE_SIZE; i++)
+        b->paste[i] = i % 64 == 63 ? '\n' : ' ' + next_random() % 95;
+
+    b->owner_win = xcb_generate_id(b->owner);
+    xcb_create_window(b->owner, XCB_COPY_FROM_PARENT, b->owner_win,
+                      b->screen->root, 0, 0, 1, 1, 0,
+                      XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT,
+                      0, NULL);
+    xcb_set_selection_owner(b->owner, b->owner_win, b->clipboard,
+                            XCB_CURRENT_TIME);
+
+    reply = xcb_get_selection_owner_reply(b->owner,
+                xcb_get_selection_owner(b->owner, b->clipboard), NULL);
+    if (!reply || reply->owner != b->owner_win) {
+        free(reply);
+        return 0;
+    }
+    free(reply);
+    return 1;
+}
+
+/* Answer a request, from us or from the server's clipboard integration */
+static void
+paste_answer(struct bench *b, xcb_selection_request_event_t *req)
+{
+    char event[32] = { 0 };
+    xcb_selection_notify_event_t notify = {
+        .response_type = XCB_SELECTION_NOTIFY,
+        .time = req->time,
+        .requestor = req->requestor,
+        .selection = req->selection,
+        .target = req->target,
+        .property = req->property ? req->property : req->target,
+    };
+
+    if (req->target == b->utf8_string)
+        xcb_change_property(b->owner, XCB_PROP_MODE_REPLACE, req->requestor,
+                            notify.property, b->utf8_string, 8, PASTE_SIZE,
+                            b->paste);
+    else if (req->target == b->targets)
+        xcb_change_property(b->owner, XCB_PROP_MODE_REPLACE, req->requestor,
+                            notify.property, XCB_ATOM_ATOM, 32, 1,
+                            &b->utf8_string);
+    else
+        notify.property = XCB_NONE;
+
+    memcpy(event, &notify, sizeof(notify));
+    xcb_send_event(b->owner, 0, req->requestor, XCB_EVENT_MASK_NO_EVENT,
+                   event);
+    xcb_flush(b->owner);
+}
+
+static void
+paste_run(struct bench *b, int reps)
+{
+    int i;
+
+    for (i = 0; i < reps; i++) {
+        xcb_generic_event_t *ev;
+        int done = 0;
+
+        xcb_convert_selection(b->c, b->win, b->clipboard, b->utf8_string,
+                              b->property, XCB_CURRENT_TIME);
+        xcb_flush(b->c);
+
+        while (!done) {
+            struct pollfd fds[2] = {
+                { .fd = xcb_get_file_descriptor(b->c), .events = POLLIN },
+                { .fd = xcb_get_file_descriptor(b->owner), .events = POLLIN },
+            };
+
+            while ((ev = xcb_poll_for_event(b->owner))) {
+                if ((ev->response_type & 0x7f) == XCB_SELECTION_REQUEST)
+                    paste_answer(b, (xcb_selection_request_event_t *) ev);
+                else if ((ev->response_type & 0x7f) == XCB_SELECTION_CLEAR) {
+                    /* The clipboard changed under us; take it back */
+                    xcb_set_selection_owner(b->owner, b->owner_win,
+                                            b->clipboard, XCB_CURRENT_TIME);
+                    xcb_flush(b->owner);
+                }
+                free(ev);
+            }
+            while (!done && (ev = xcb_poll_for_event(b->c))) {
+                done = (ev->response_type & 0x7f) == XCB_SELECTION_NOTIFY;
+                free(ev);
+            }
+            if (!done && (xcb_connection_has_error(b->c) ||
+                          xcb_connection_has_error(b->owner)))
+                return;
+            if (!done)
+                poll(fds, 2, -1);
+        }
+
+        free(xcb_get_property_reply(b->c,
+                                    xcb_get_property(b->c, 1, b->win,
+                                                     b->property,
+                                                     XCB_GET_PROPERTY_TYPE_ANY,
+                                                     0, PASTE_SIZE / 4),
+                                    NULL));
+    }
+}
+
+static const struct workload workloads[] = {
+    { "text-core", text_setup, text_run },
+    { "copyarea-scroll", no_setup, scroll_run },
+    { "putimage", putimage_setup, putimage_run },
+    { "getimage", putimage_setup, getimage_run },
+    { "render-composite", render_setup, composite_run },
+    { "render-glyphs", glyphs_setup, glyphs_run },
+    { "map-children", children_setup, children_run },
+    { "map-toplevel", no_setup, toplevel_run },
+    { "clipboard-paste", paste_setup, paste_run },
+};
+
+static int
+bench_init(struct bench *b)
+{
+    const xcb_setup_t *setup;
+    xcb_format_iterator_t fi;
+    uint32_t values[3];
+    xcb_generic_event_t *ev;
+
+    b->c = xcb_connect(b->display, NULL);
+    if (xcb_connection_has_error(b->c)) {
+        fprintf(stderr, "xwinbench: cannot open display\n");
+        return 0;
+    }
+    setup = xcb_get_setup(b->c);
+    b->screen = xcb_setup_roots_iterator(setup).data;
+
+    for (fi = xcb_setup_pixmap_formats_iterator(setup); fi.rem;
+         xcb_format_next(&fi))
+        if (fi.data->depth == b->screen->root_depth) {
+            b->bpp = fi.data->bits_per_pixel;
+            b->pad = fi.data->scanline_pad;
+        }
+
+    b->win = xcb_generate_id(b->c);
+    values[0] = b->screen->black_pixel;
+    values[1] = 1;
+    values[2] = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    xcb_create_window(b->c, XCB_COPY_FROM_PARENT, b->win, b->screen->root,
+                      0, 0, WIN_SIZE, WIN_SIZE, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT |
+                      XCB_CW_EVENT_MASK, values);
+    xcb_map_window(b->c, b->win);
+    xcb_flush(b->c);
+    while ((ev = xcb_wait_for_event(b->c))) {
+        int mapped = (ev->response_type & 0x7f) == XCB_MAP_NOTIFY;
+
+        free(ev);
+        if (mapped)
+            break;
+    }
+
+    b->gc = xcb_generate_id(b->c);
+    values[0] = b->screen->white_pixel;
+    values[1] = b->screen->black_pixel;
+    values[2] = 0;
+    xcb_create_gc(b->c, b->gc, b->win,
+                  XCB_GC_FOREGROUND | XCB_GC_BACKGROUND |
+                  XCB_GC_GRAPHICS_EXPOSURES, values);
+    round_trip(b->c);
+    return 1;
+}
+
+static void
+print_server(struct bench *b)
+{
+    const xcb_setup_t *setup = xcb_get_setup(b->c);
+
+    printf("{\"server\": \"%.*s\", \"release\": %u, "
+           "\"width\": %u, \"height\": %u, \"depth\": %u}\n",
+           xcb_setup_vendor_length(setup), xcb_setup_vendor(setup),
+           setup->release_number, b->screen->width_in_pixels,
+           b->screen->height_in_pixels, b->screen->root_depth);
+}
+
+static void
+run_workload(struct bench *b, const struct workload *w, double seconds)
+{
+    double start, elapsed;
+    long ops = 0;
+    int reps = 1;
+
+    seed = 1;
+    if (!w->setup(b)) {
+        printf("{\"workload\": \"%s\", \"skipped\": true}\n", w->name);
+        return;
+    }
+
+    /* Warm up, and find a batch size that takes about 10ms */
+    for (;;) {
+        start = now();
+        w->run(b, reps);
+        round_trip(b->c);
+        elapsed = now() - start;
+        if (elapsed >= 0.01 || reps >= 1 << 20)
+            break;
+        reps *= 2;
+    }
+
+    seed = 1;
+    start = now();
+    do {
+        w->run(b, reps);
+        round_trip(b->c);
+        ops += reps;
+        elapsed = now() - start;
+    } while (elapsed < seconds && !xcb_connection_has_error(b->c));
+
+    printf("{\"workload\": \"%s\", \"ops\": %ld, \"seconds\": %.6f, "
+           "\"ops_per_second\": %.1f, \"us_per_op\": %.3f}\n",
+           w->name, ops, elapsed, ops / elapsed, elapsed * 1e6 / ops);
+    fflush(stdout);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct bench b = { 0 };
+    double seconds = 2.0;
+    int i, j, first = argc, ran = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-display") && i + 1 < argc)
+            b.display = argv[++i];
+        else if (!strcmp(argv[i], "-time") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [-display name] [-time seconds] "
+                    "[workload ...]\nworkloads:", argv[0]);
+            for (j = 0; j < ARRAY_SIZE(workloads); j++)
+                fprintf(stderr, " %s", workloads[j].name);
+            fprintf(stderr, "\n");
+            return 2;
+        }
+        else {
+            first = i;
+            break;
+        }
+    }
+
+    if (!bench_init(&b))
+        return 1;
+    print_server(&b);
+
+    for (j = 0; j < ARRAY_SIZE(workloads); j++) {
+        int wanted = first == argc;
+
+        for (i = first; i < argc; i++)
+            wanted |= !strcmp(argv[i], workloads[j].name);
+        if (!wanted)
+            continue;
+        run_workload(&b, &workloads[j], seconds);
+        ran++;
+    }
+
+    if (b.owner)
+        xcb_disconnect(b.owner);
+    free(b.paste);
+    xcb_disconnect(b.c);
+    return ran ? 0 : 2;
+}
@@ -318,7 +318,7 @@ int
 ProcXFixesSetRegion(ClientPtr client)
 {
     int things;
-    RegionPtr pRegion, pNew;
+    RegionPtr pRegion;
 
     REQUEST(xXFixesSetRegionReq);
 
@@ -330,14 +330,9 @@ ProcXFixesSetRegion(ClientPtr client)
         return BadLength;
     things >>= 3;
 
-    pNew = RegionFromRects(things, (xRectangle *) (stuff + 1), CT_UNSORTED);
-    if (!pNew)
-        return BadAlloc;
-    if (!RegionCopy(pRegion, pNew)) {
-        RegionDestroy(pNew);
+    if (!RegionSetRects(pRegion, things, (xRectangle *) (stuff + 1),
+                        CT_UNSORTED))
         return BadAlloc;
-    }
-    RegionDestroy(pNew);
     return Success;
 }
 
@@ -787,12 +782,12 @@ ProcXFixesExpandRegion(ClientPtr client)
             pTmp[i].y1 = pSrc[i].y1 - stuff->top;
             pTmp[i].y2 = pSrc[i].y2 + stuff->bottom;
         }
-        RegionEmpty(pDestination);
-        for (i = 0; i < nBoxes; i++) {
-            RegionRec r;
-
-            RegionInit(&r, &pTmp[i], 0);
-            RegionUnion(pDestination, pDestination, &r);
+        /* Build the result from all the boxes at once, rather than
+         * with one union per box */
+        RegionUninit(pDestination);
+        if (!RegionInitBoxes(pDestination, pTmp, nBoxes)) {
+            free(pTmp);
+            return BadAlloc;
         }
         free(pTmp);
     }
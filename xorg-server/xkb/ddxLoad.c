@@ -33,6 +33,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <sys/stat.h>
 #include <X11/X.h>
 #include <X11/Xos.h>
 #include <X11/Xproto.h>
@@ -44,6 +45,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define	XKBSRV_NEED_FILE_FUNCS
 #include <xkbsrv.h>
 #include <X11/extensions/XI.h>
+#include "xsha1.h"
 
 #define	PRE_ERROR_MSG "\"The XKEYBOARD keymap compiler (xkbcomp) reports:\""
 #define	ERROR_PREFIX	"\"> \""
@@ -56,9 +58,20 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define PATHSEPARATOR "/"
 #endif
 
+/*
+ * Compiled keymaps are kept in the output directory as
+ * XKM_CACHE_PREFIX<sha1>.xkm, named after the hash of everything that
+ * went into xkbcomp, so compiling the same keymap again (at every server
+ * start, for one) just reuses the file.
+ */
+#define XKM_CACHE_PREFIX "xkbcache-"
+
 static unsigned
 LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn);
 
+static Bool
+XkmFileName(const char *mapName, char *fileName, size_t size);
+
 static void
 OutputDirectory(char *outdir, size_t size)
 {
@@ -99,15 +112,89 @@ OutputDirectory(char *outdir, size_t size)
  */
 typedef void (*xkbcomp_buffer_callback)(FILE *out, void *userdata);
 
+/**
+ * Let the callback write the keymap source into file, and return a copy
+ * of what it wrote.
+ */
+static char *
+CaptureXkbCompInput(FILE *file, xkbcomp_buffer_callback callback,
+                    void *userdata, size_t *lenRtrn)
+{
+    char *input;
+    long len;
+
+    (*callback)(file, userdata);
+    if (fflush(file) != 0 || (len = ftell(file)) < 0)
+        return NULL;
+
+    input = malloc(len + 1);
+    if (!input)
+        return NULL;
+
+    rewind(file);
+    if (fread(input, 1, len, file) != len) {
+        free(input);
+        return NULL;
+    }
+    input[len] = '\0';
+
+    *lenRtrn = len;
+    return input;
+}
+
+/**
+ * Name the cached keymap for this input, or return FALSE if it can't be
+ * hashed.  The directories are hashed along with it, since they decide
+ * which xkbcomp runs and what the source's include statements resolve to.
+ */
+static Bool
+XkmCacheName(const char *input, size_t len, char *name, size_t size)
+{
+    static const char hex[] = "0123456789abcdef";
+    unsigned char sha1[20];
+    char *p;
+    void *ctx;
+    int i;
+
+    if (size < strlen(XKM_CACHE_PREFIX) + 2 * sizeof(sha1) + 1)
+        return FALSE;
+
+    ctx = x_sha1_init();
+    if (!ctx)
+        return FALSE;
+    x_sha1_update(ctx, (void *) input, len);
+    if (XkbBaseDirectory)
+        x_sha1_update(ctx, XkbBaseDirectory, strlen(XkbBaseDirectory) + 1);
+    if (XkbBinDirectory)
+        x_sha1_update(ctx, XkbBinDirectory, strlen(XkbBinDirectory) + 1);
+    if (!x_sha1_final(ctx, sha1))
+        return FALSE;
+
+    p = name + strlen(strcpy(name, XKM_CACHE_PREFIX));
+    for (i = 0; i < sizeof(sha1); i++) {
+        *p++ = hex[sha1[i] >> 4];
+        *p++ = hex[sha1[i] & 0xf];
+    }
+    *p = '\0';
+
+    return TRUE;
+}
+
 /**
  * Start xkbcomp, let the callback write into xkbcomp's stdin. When done,
- * return a strdup'd copy of the file name we've written to.
+ * return a strdup'd copy of the file name we've written to.  If the same
+ * input was compiled before, xkbcomp is not run at all and the name of
+ * the cached file is returned.
  */
 static char *
 RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 {
     FILE *out;
     char *buf = NULL, keymap[PATH_MAX], xkm_output_dir[PATH_MAX];
+    char cachename[PATH_MAX], cachefile[PATH_MAX], keymapfile[PATH_MAX];
+    char *input = NULL;
+    size_t input_len = 0;
+    Bool cache = FALSE;
 
     const char *emptystring = "";
     char *xkbbasedirflag = NULL;
@@ -131,7 +218,46 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     strcpy(tmpname, Win32TempDir());
     strcat(tmpname, "\\xkb_XXXXXX");
     (void) mktemp(tmpname);
+
+    /* Write the input where xkbcomp will read it, keeping a copy */
+    out = fopen(tmpname, "w+");
+    if (out == NULL) {
+        LogMessage(X_ERROR, "Could not open file %s\n", tmpname);
+        return NULL;
+    }
+    input = CaptureXkbCompInput(out, callback, userdata, &input_len);
+    if (fclose(out) != 0 || !input) {
+        LogMessage(X_ERROR, "Error writing keymap to %s\n", tmpname);
+        free(input);
+        unlink(tmpname);
+        return NULL;
+    }
+#else
+    out = tmpfile();
+    if (out != NULL) {
+        input = CaptureXkbCompInput(out, callback, userdata, &input_len);
+        fclose(out);
+    }
+    if (!input) {
+        LogMessage(X_ERROR, "XKB: Could not buffer keymap for xkbcomp\n");
+        return NULL;
+    }
+#endif
+
+    /* Compiled this before? */
+    if (XkmCacheName(input, input_len, cachename, sizeof(cachename)) &&
+        XkmFileName(cachename, cachefile, sizeof(cachefile)) &&
+        XkmFileName(keymap, keymapfile, sizeof(keymapfile))) {
+        cache = TRUE;
+        if (access(cachefile, R_OK) == 0) {
+            DebugF("[xkb] using cached keymap %s\n", cachefile);
+            free(input);
+#ifdef WIN32
+            unlink(tmpname);
 #endif
+            return xnfstrdup(cachename);
+        }
+    }
 
     if (XkbBaseDirectory != NULL) {
         if (asprintf(&xkbbasedirflag, "\"-R%s\"", XkbBaseDirectory) == -1)
@@ -165,31 +291,43 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     if (!buf) {
         LogMessage(X_ERROR,
                    "XKB: Could not invoke xkbcomp: not enough memory\n");
+        free(input);
+#ifdef WIN32
+        unlink(tmpname);
+#endif
         return NULL;
     }
 
 #ifndef WIN32
     out = Popen(buf, "w");
-#else
-    out = fopen(tmpname, "w");
-#endif
 
     if (out != NULL) {
         /* Now write to xkbcomp */
-        (*callback)(out, userdata);
+        fwrite(input, 1, input_len, out);
 
-#ifndef WIN32
         if (Pclose(out) == 0)
 #else
-        if (fclose(out) == 0 && System(buf) >= 0)
+    {
+        if (System(buf) >= 0)
 #endif
         {
             if (xkbDebugFlags)
                 DebugF("[xkb] xkb executes: %s\n", buf);
             free(buf);
+            free(input);
 #ifdef WIN32
             unlink(tmpname);
 #endif
+            /* Keep it for next time.  Another server may have stored the
+               same keymap meanwhile, which is just as good. */
+            if (cache) {
+                if (rename(keymapfile, cachefile) == 0)
+                    return xnfstrdup(cachename);
+                if (access(cachefile, R_OK) == 0) {
+                    unlink(keymapfile);
+                    return xnfstrdup(cachename);
+                }
+            }
             return xnfstrdup(keymap);
         }
         else {
@@ -201,14 +339,13 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
         unlink(tmpname);
 #endif
     }
-    else {
 #ifndef WIN32
+    else {
         LogMessage(X_ERROR, "XKB: Could not invoke xkbcomp\n");
-#else
-        LogMessage(X_ERROR, "Could not open file %s\n", tmpname);
-#endif
     }
+#endif
     free(buf);
+    free(input);
     return NULL;
 }
 
@@ -301,34 +438,43 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
     return have;
 }
 
+/**
+ * Path of the compiled keymap mapName, as written by xkbcomp
+ */
+static Bool
+XkmFileName(const char *mapName, char *fileName, size_t size)
+{
+    char xkm_output_dir[PATH_MAX];
+
+    fileName[0] = '\0';
+    OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
+    if ((XkbBaseDirectory != NULL) && (xkm_output_dir[0] != '/')
+#ifdef WIN32
+        && (!isalpha(xkm_output_dir[0]) || xkm_output_dir[1] != ':')
+#endif
+        ) {
+        if (snprintf(fileName, size, "%s/%s%s.xkm", XkbBaseDirectory,
+                     xkm_output_dir, mapName) >= size)
+            fileName[0] = '\0';
+    }
+    else {
+        if (snprintf(fileName, size, "%s%s.xkm", xkm_output_dir, mapName)
+            >= size)
+            fileName[0] = '\0';
+    }
+
+    return fileName[0] != '\0';
+}
+
 static FILE *
 XkbDDXOpenConfigFile(const char *mapName, char *fileNameRtrn, int fileNameRtrnLen)
 {
-    char buf[PATH_MAX], xkm_output_dir[PATH_MAX];
+    char buf[PATH_MAX];
     FILE *file;
 
     buf[0] = '\0';
-    if (mapName != NULL) {
-        OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
-        if ((XkbBaseDirectory != NULL) && (xkm_output_dir[0] != '/')
-#ifdef WIN32
-            && (!isalpha(xkm_output_dir[0]) || xkm_output_dir[1] != ':')
-#endif
-            ) {
-            if (snprintf(buf, PATH_MAX, "%s/%s%s.xkm", XkbBaseDirectory,
-                         xkm_output_dir, mapName) >= PATH_MAX)
-                buf[0] = '\0';
-        }
-        else {
-            if (snprintf(buf, PATH_MAX, "%s%s.xkm", xkm_output_dir, mapName)
-                >= PATH_MAX)
-                buf[0] = '\0';
-        }
-        if (buf[0] != '\0')
-            file = fopen(buf, "rb");
-        else
-            file = NULL;
-    }
+    if (mapName != NULL && XkmFileName(mapName, buf, sizeof(buf)))
+        file = fopen(buf, "rb");
     else
         file = NULL;
     if ((fileNameRtrn != NULL) && (fileNameRtrnLen > 0)) {
@@ -352,6 +498,7 @@ LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
     }
     missing = XkmReadFile(file, need, want, xkbRtrn);
     if (*xkbRtrn == NULL) {
+        /* Unreadable, so don't let the cache hand it out again either */
         LogMessage(X_ERROR, "Error loading keymap %s\n", fileName);
         fclose(file);
         (void) unlink(fileName);
@@ -362,7 +509,8 @@ LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
                (*xkbRtrn)->defined);
     }
     fclose(file);
-    (void) unlink(fileName);
+    if (strncmp(keymap, XKM_CACHE_PREFIX, strlen(XKM_CACHE_PREFIX)) != 0)
+        (void) unlink(fileName);
     return (need | want) & (~missing);
 }
 
@@ -397,50 +545,176 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
     return LoadXKM(want, need, nameRtrn, xkbRtrn);
 }
 
-Bool
-XkbDDXNamesFromRules(DeviceIntPtr keybd,
-                     const char *rules_name,
-                     XkbRF_VarDefsPtr defs, XkbComponentNamesPtr names)
+/*
+ * The parsed rules file is kept between keymap loads and server
+ * generations, and read again only when the file changes.  With it are
+ * the components it gave for the last few sets of model, layout, variant
+ * and options, so switching between a user's layouts does not match the
+ * rules again either.
+ */
+#define XKB_RULES_RESULTS 16
+
+typedef struct {
+    char *model;
+    char *layout;
+    char *variant;
+    char *options;
+    XkbComponentNamesRec names;
+} XkbRulesResultRec;
+
+static struct {
+    char *path;
+    time_t mtime;
+    off_t size;
+    XkbRF_RulesPtr rules;
+    XkbRulesResultRec results[XKB_RULES_RESULTS];
+    int next_result;
+} rulesCache;
+
+static void
+XkbFreeRulesResult(XkbRulesResultRec *result)
 {
-    char buf[PATH_MAX];
+    free(result->model);
+    free(result->layout);
+    free(result->variant);
+    free(result->options);
+    XkbFreeComponentNames(&result->names, FALSE);
+    memset(result, 0, sizeof(*result));
+}
+
+static void
+XkbFlushRulesCache(void)
+{
+    int i;
+
+    for (i = 0; i < XKB_RULES_RESULTS; i++)
+        XkbFreeRulesResult(&rulesCache.results[i]);
+    XkbRF_Free(rulesCache.rules, TRUE);
+    free(rulesCache.path);
+    memset(&rulesCache, 0, sizeof(rulesCache));
+}
+
+static Bool
+XkbSameString(const char *a, const char *b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static void
+XkbCopyComponentNames(XkbComponentNamesPtr to, const XkbComponentNamesRec *from)
+{
+    to->keycodes = Xstrdup(from->keycodes);
+    to->types = Xstrdup(from->types);
+    to->compat = Xstrdup(from->compat);
+    to->symbols = Xstrdup(from->symbols);
+    to->geometry = Xstrdup(from->geometry);
+}
+
+/**
+ * The rules in the file at path, parsed now or taken from the cache
+ */
+static XkbRF_RulesPtr
+XkbCachedRules(const char *path, const char *rules_name)
+{
+    struct stat st;
     FILE *file;
-    Bool complete;
     XkbRF_RulesPtr rules;
 
-    if (!rules_name)
-        return FALSE;
-
-    if (snprintf(buf, PATH_MAX, "%s/rules/%s", XkbBaseDirectory, rules_name)
-        >= PATH_MAX) {
-        LogMessage(X_ERROR, "XKB: Rules name is too long\n");
-        return FALSE;
+    if (stat(path, &st) != 0) {
+        LogMessage(X_ERROR, "XKB: Couldn't open rules file %s\n", path);
+        return NULL;
     }
+    if (rulesCache.rules && strcmp(rulesCache.path, path) == 0 &&
+        rulesCache.mtime == st.st_mtime && rulesCache.size == st.st_size)
+        return rulesCache.rules;
 
-    file = fopen(buf, "r");
+    file = fopen(path, "r");
     if (!file) {
-        LogMessage(X_ERROR, "XKB: Couldn't open rules file %s\n", buf);
-        return FALSE;
+        LogMessage(X_ERROR, "XKB: Couldn't open rules file %s\n", path);
+        return NULL;
     }
 
     rules = XkbRF_Create();
     if (!rules) {
         LogMessage(X_ERROR, "XKB: Couldn't create rules struct\n");
         fclose(file);
-        return FALSE;
+        return NULL;
     }
 
     if (!XkbRF_LoadRules(file, rules)) {
         LogMessage(X_ERROR, "XKB: Couldn't parse rules file %s\n", rules_name);
         fclose(file);
         XkbRF_Free(rules, TRUE);
+        return NULL;
+    }
+    fclose(file);
+
+    XkbFlushRulesCache();
+    rulesCache.path = Xstrdup(path);
+    if (!rulesCache.path) {
+        XkbRF_Free(rules, TRUE);
+        return NULL;
+    }
+    rulesCache.mtime = st.st_mtime;
+    rulesCache.size = st.st_size;
+    rulesCache.rules = rules;
+    DebugF("[xkb] parsed rules file %s: %d rules\n", path, rules->num_rules);
+    return rules;
+}
+
+Bool
+XkbDDXNamesFromRules(DeviceIntPtr keybd,
+                     const char *rules_name,
+                     XkbRF_VarDefsPtr defs, XkbComponentNamesPtr names)
+{
+    char buf[PATH_MAX];
+    Bool complete;
+    XkbRF_RulesPtr rules;
+    XkbRulesResultRec *result;
+    int i;
+
+    if (!rules_name)
+        return FALSE;
+
+    if (snprintf(buf, PATH_MAX, "%s/rules/%s", XkbBaseDirectory, rules_name)
+        >= PATH_MAX) {
+        LogMessage(X_ERROR, "XKB: Rules name is too long\n");
         return FALSE;
     }
 
+    rules = XkbCachedRules(buf, rules_name);
+    if (!rules)
+        return FALSE;
+
     memset(names, 0, sizeof(*names));
-    complete = XkbRF_GetComponents(rules, defs, names);
-    fclose(file);
-    XkbRF_Free(rules, TRUE);
+    for (i = 0; i < XKB_RULES_RESULTS; i++) {
+        result = &rulesCache.results[i];
+        if (result->names.keycodes && XkbSameString(result->model, defs->model) &&
+            XkbSameString(result->layout, defs->layout) &&
+            XkbSameString(result->variant, defs->variant) &&
+            XkbSameString(result->options, defs->options))
+            break;
+    }
+
+    if (i < XKB_RULES_RESULTS) {
+        XkbCopyComponentNames(names, &result->names);
+    }
+    else {
+        XkbRF_GetComponents(rules, defs, names);
+
+        result = &rulesCache.results[rulesCache.next_result];
+        rulesCache.next_result = (rulesCache.next_result + 1) %
+            XKB_RULES_RESULTS;
+        XkbFreeRulesResult(result);
+        result->model = Xstrdup(defs->model);
+        result->layout = Xstrdup(defs->layout);
+        result->variant = Xstrdup(defs->variant);
+        result->options = Xstrdup(defs->options);
+        XkbCopyComponentNames(&result->names, names);
+    }
 
+    complete = (names->keycodes && names->symbols && names->types &&
+                names->compat && names->geometry);
     if (!complete)
         LogMessage(X_ERROR, "XKB: Rules returned no components\n");
 
@@ -1229,6 +1229,12 @@ XkbPushLockedStateToSlaves(DeviceIntPtr master, int evtype, int key)
         if (!dev->key || GetMaster(dev, MASTER_KEYBOARD) != master)
             continue;
 
+        /* nothing to do if the slave is in step and not mid-update */
+        if (dev->key->xkbInfo->state.locked_mods ==
+            master->key->xkbInfo->state.locked_mods &&
+            !(dev->key->xkbInfo->flags & _XkbStateNotifyInProgress))
+            continue;
+
         genStateNotify = _XkbEnsureStateChange(dev->key->xkbInfo);
 
         dev->key->xkbInfo->state.locked_mods =
@@ -1238,6 +1244,26 @@ XkbPushLockedStateToSlaves(DeviceIntPtr master, int evtype, int key)
     }
 }
 
+/*
+ * A key without actions, pressed or released while no filter is active,
+ * can neither start nor end an action and leaves the state as it is.
+ * Typing and key repeat are mostly such events.
+ */
+static Bool
+_XkbIsPlainKey(XkbSrvInfoPtr xkbi, int key)
+{
+    int i;
+
+    if (XkbKeycodeInRange(xkbi->desc, key) &&
+        XkbKeyHasActions(xkbi->desc, key))
+        return FALSE;
+    for (i = 0; i < xkbi->szFilters; i++) {
+        if ((xkbi->filters[i].active) && (xkbi->filters[i].filter))
+            return FALSE;
+    }
+    return TRUE;
+}
+
 static void
 XkbActionGetFilter(DeviceIntPtr dev, DeviceEvent *event, KeyCode key,
                    XkbAction *act, int *sendEvent)
@@ -1349,6 +1375,7 @@ XkbHandleActions(DeviceIntPtr dev, DeviceIntPtr kbd, DeviceEvent *event)
     XkbAction act;
     Bool keyEvent;
     Bool pressEvent;
+    Bool plain;
     ProcessInputProc backupproc;
 
     xkbDeviceInfoPtr xkbPrivPtr = XKBDEVICEINFO(dev);
@@ -1366,8 +1393,12 @@ XkbHandleActions(DeviceIntPtr dev, DeviceIntPtr kbd, DeviceEvent *event)
     keyEvent = ((event->type == ET_KeyPress) || (event->type == ET_KeyRelease));
     pressEvent = ((event->type == ET_KeyPress) ||
                   (event->type == ET_ButtonPress));
+    plain = keyEvent && _XkbIsPlainKey(xkbi, key);
 
-    if (pressEvent) {
+    if (plain) {
+        /* no action to look up and no filter to run */
+    }
+    else if (pressEvent) {
         if (keyEvent)
             act = XkbGetKeyAction(xkbi, &xkbi->state, key);
         else {
@@ -1426,7 +1457,12 @@ XkbHandleActions(DeviceIntPtr dev, DeviceIntPtr kbd, DeviceEvent *event)
         FixKeyState(event, dev);
     }
 
-    _XkbApplyState(dev, genStateNotify, event->type, key);
+    /* With the state untouched there is nothing to notify or light up */
+    if (plain && genStateNotify &&
+        !XkbStateChangedFlags(&xkbi->prev_state, &xkbi->state))
+        xkbi->flags &= ~_XkbStateNotifyInProgress;
+    else
+        _XkbApplyState(dev, genStateNotify, event->type, key);
     XkbPushLockedStateToSlaves(dev, event->type, key);
 }
 
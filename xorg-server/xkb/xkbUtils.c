@@ -2000,15 +2000,205 @@ XkbCopyKeymap(XkbDescPtr dst, XkbDescPtr src)
     return TRUE;
 }
 
+/* Whether two arrays of n elements, either of which may be missing, match */
+static Bool
+_XkbSameArray(const void *a, const void *b, size_t n, size_t size)
+{
+    if (!a || !b)
+        return a == b || !n;
+    return !memcmp(a, b, n * size);
+}
+
+static Bool
+_XkbSameTypes(XkbClientMapPtr a, XkbClientMapPtr b)
+{
+    int i;
+
+    if (a->num_types != b->num_types)
+        return FALSE;
+    for (i = 0; i < a->num_types; i++) {
+        XkbKeyTypePtr ta = &a->types[i], tb = &b->types[i];
+
+        if (memcmp(&ta->mods, &tb->mods, sizeof(XkbModsRec)) ||
+            ta->num_levels != tb->num_levels ||
+            ta->map_count != tb->map_count || ta->name != tb->name ||
+            !_XkbSameArray(ta->map, tb->map, ta->map_count,
+                           sizeof(XkbKTMapEntryRec)) ||
+            !_XkbSameArray(ta->preserve, tb->preserve, ta->map_count,
+                           sizeof(XkbModsRec)) ||
+            !_XkbSameArray(ta->level_names, tb->level_names, ta->num_levels,
+                           sizeof(Atom)))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static Bool
+_XkbSameNames(XkbNamesPtr a, XkbNamesPtr b, int min_key, int max_key)
+{
+    if (a->keycodes != b->keycodes || a->geometry != b->geometry ||
+        a->symbols != b->symbols || a->types != b->types ||
+        a->compat != b->compat || a->phys_symbols != b->phys_symbols ||
+        memcmp(a->vmods, b->vmods, sizeof(a->vmods)) ||
+        memcmp(a->indicators, b->indicators, sizeof(a->indicators)) ||
+        memcmp(a->groups, b->groups, sizeof(a->groups)) ||
+        a->num_key_aliases != b->num_key_aliases || a->num_rg != b->num_rg)
+        return FALSE;
+    if (a->keys && b->keys) {
+        if (memcmp(&a->keys[min_key], &b->keys[min_key],
+                   (max_key - min_key + 1) * sizeof(XkbKeyNameRec)))
+            return FALSE;
+    }
+    else if (a->keys != b->keys)
+        return FALSE;
+    return _XkbSameArray(a->key_aliases, b->key_aliases, a->num_key_aliases,
+                         sizeof(XkbKeyAliasRec)) &&
+        _XkbSameArray(a->radio_groups, b->radio_groups, a->num_rg,
+                      sizeof(Atom));
+}
+
+/*
+ * Whether going from keymap a to keymap b changes nothing but the
+ * bindings of individual keys: symbols, actions, behaviors, explicit
+ * components and modifier maps.  Everything else, from the keycode range
+ * to the key types and the compat map, has to match.  Geometries are
+ * compared by name only.
+ */
+static Bool
+_XkbSameKeymapLayout(XkbDescPtr a, XkbDescPtr b)
+{
+    if (a->min_key_code != b->min_key_code ||
+        a->max_key_code != b->max_key_code)
+        return FALSE;
+    if (!a->map || !b->map || !a->server || !b->server ||
+        !a->map->key_sym_map || !b->map->key_sym_map ||
+        !a->server->key_acts || !b->server->key_acts)
+        return FALSE;
+    if (!_XkbSameTypes(a->map, b->map) ||
+        memcmp(a->server->vmods, b->server->vmods, sizeof(a->server->vmods)))
+        return FALSE;
+    if (!_XkbSameArray(a->indicators, b->indicators, 1,
+                       sizeof(XkbIndicatorRec)) ||
+        !_XkbSameArray(a->ctrls, b->ctrls, 1, sizeof(XkbControlsRec)))
+        return FALSE;
+    if (a->compat && b->compat) {
+        if (a->compat->num_si != b->compat->num_si ||
+            memcmp(a->compat->groups, b->compat->groups,
+                   sizeof(a->compat->groups)) ||
+            !_XkbSameArray(a->compat->sym_interpret, b->compat->sym_interpret,
+                           a->compat->num_si, sizeof(XkbSymInterpretRec)))
+            return FALSE;
+    }
+    else if (a->compat != b->compat)
+        return FALSE;
+    if (a->names && b->names) {
+        if (!_XkbSameNames(a->names, b->names, a->min_key_code,
+                           a->max_key_code))
+            return FALSE;
+    }
+    else if (a->names != b->names)
+        return FALSE;
+    if (!a->geom != !b->geom || (a->geom && a->geom->name != b->geom->name))
+        return FALSE;
+    return TRUE;
+}
+
+static void
+_XkbExtendRange(KeyCode *first, CARD8 *num, int key)
+{
+    if (!*num) {
+        *first = key;
+        *num = 1;
+    }
+    else
+        *num = key - *first + 1;
+}
+
+/*
+ * For keymaps that pass _XkbSameKeymapLayout, fill in a MapNotify that
+ * covers the keys whose bindings differ.  Returns the changed mask, which
+ * is 0 if no key changes at all.
+ */
+static CARD16
+_XkbKeymapDelta(XkbDescPtr a, XkbDescPtr b, xkbMapNotify *mn)
+{
+    int key;
+
+    memset(mn, 0, sizeof(xkbMapNotify));
+    for (key = a->min_key_code; key <= a->max_key_code; key++) {
+        XkbSymMapPtr sa = &a->map->key_sym_map[key];
+        XkbSymMapPtr sb = &b->map->key_sym_map[key];
+        int nsyms = XkbKeyNumSyms(a, key);
+
+        if (memcmp(sa->kt_index, sb->kt_index, sizeof(sa->kt_index)) ||
+            sa->group_info != sb->group_info || sa->width != sb->width ||
+            (nsyms && memcmp(XkbKeySymsPtr(a, key), XkbKeySymsPtr(b, key),
+                             nsyms * sizeof(KeySym)))) {
+            mn->changed |= XkbKeySymsMask;
+            _XkbExtendRange(&mn->firstKeySym, &mn->nKeySyms, key);
+        }
+        if (XkbKeyHasActions(a, key) != XkbKeyHasActions(b, key) ||
+            (XkbKeyHasActions(a, key) &&
+             (XkbKeyNumActions(a, key) != XkbKeyNumActions(b, key) ||
+              memcmp(XkbKeyActionsPtr(a, key), XkbKeyActionsPtr(b, key),
+                     XkbKeyNumActions(a, key) * sizeof(XkbAction))))) {
+            mn->changed |= XkbKeyActionsMask;
+            _XkbExtendRange(&mn->firstKeyAct, &mn->nKeyActs, key);
+        }
+        if (!a->server->behaviors != !b->server->behaviors ||
+            (a->server->behaviors &&
+             memcmp(&a->server->behaviors[key], &b->server->behaviors[key],
+                    sizeof(XkbBehavior)))) {
+            mn->changed |= XkbKeyBehaviorsMask;
+            _XkbExtendRange(&mn->firstKeyBehavior, &mn->nKeyBehaviors, key);
+        }
+        if (!a->server->explicit != !b->server->explicit ||
+            (a->server->explicit &&
+             a->server->explicit[key] != b->server->explicit[key])) {
+            mn->changed |= XkbExplicitComponentsMask;
+            _XkbExtendRange(&mn->firstKeyExplicit, &mn->nKeyExplicit, key);
+        }
+        if (!a->map->modmap != !b->map->modmap ||
+            (a->map->modmap && a->map->modmap[key] != b->map->modmap[key])) {
+            mn->changed |= XkbModifierMapMask;
+            _XkbExtendRange(&mn->firstModMapKey, &mn->nModMapKeys, key);
+        }
+        if (!a->server->vmodmap != !b->server->vmodmap ||
+            (a->server->vmodmap &&
+             a->server->vmodmap[key] != b->server->vmodmap[key])) {
+            mn->changed |= XkbVirtualModMapMask;
+            _XkbExtendRange(&mn->firstVModMapKey, &mn->nVModMapKeys, key);
+        }
+    }
+    return mn->changed;
+}
+
+/*
+ * Install desc as dst's keymap and tell clients.  When only some key
+ * bindings change, which is the usual case when the master keyboard takes
+ * over the keymap of another slave, clients get a MapNotify for just those
+ * keys instead of a NewKeyboardNotify that makes them fetch everything, and
+ * nothing at all when the keymaps are the same.
+ */
 Bool
 XkbDeviceApplyKeymap(DeviceIntPtr dst, XkbDescPtr desc)
 {
     xkbNewKeyboardNotify nkn;
+    xkbMapNotify mn;
     Bool ret;
 
     if (!dst->key || !desc)
         return FALSE;
 
+    if (_XkbSameKeymapLayout(dst->key->xkbInfo->desc, desc)) {
+        CARD16 changed = _XkbKeymapDelta(dst->key->xkbInfo->desc, desc, &mn);
+
+        ret = XkbCopyKeymap(dst->key->xkbInfo->desc, desc);
+        if (ret && changed)
+            XkbSendMapNotify(dst, &mn);
+        return ret;
+    }
+
     memset(&nkn, 0, sizeof(xkbNewKeyboardNotify));
     nkn.oldMinKeyCode = dst->key->xkbInfo->desc->min_key_code;
     nkn.oldMaxKeyCode = dst->key->xkbInfo->desc->max_key_code;
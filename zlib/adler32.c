@@ -57,6 +57,88 @@
 #  define MOD63(a) a %= BASE
 #endif
 
+/* On x86, sum whole 32 byte blocks with SSSE3 when the processor has it.
+   The result is the same, so the choice is made at run time. */
+#if !defined(NO_ADLER32_SIMD) && (defined(_M_IX86) || defined(_M_X64) || \
+    ((defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)))
+#  define ADLER32_SSSE3
+#  include <tmmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    define SSSE3_TARGET
+#  else
+#    include <cpuid.h>
+#    define SSSE3_TARGET __attribute__((target("ssse3")))
+#  endif
+
+local int adler32_have_ssse3(void) {
+    static int have = -1;       /* racing threads store the same value */
+
+    if (have < 0) {
+#  ifdef _MSC_VER
+        int info[4];
+
+        __cpuid(info, 1);
+        have = (info[2] >> 9) & 1;
+#  else
+        unsigned a, b, c, d;
+
+        have = __get_cpuid(1, &a, &b, &c, &d) ? (c >> 9) & 1 : 0;
+#  endif
+    }
+    return have;
+}
+
+/* Add len bytes, a multiple of 32, to the sums in *a and *s */
+local SSSE3_TARGET void adler32_ssse3(unsigned long *a, unsigned long *s,
+                                      const Bytef *buf, z_size_t len) {
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    unsigned long adler = *a, sum2 = *s;
+    z_size_t blocks = len >> 5;
+
+    while (blocks) {
+        /* NMAX bytes at most between modulos, as in the scalar code */
+        unsigned n = blocks < NMAX / 32 ? (unsigned)blocks : NMAX / 32;
+        __m128i v_ps = _mm_setr_epi32((int)(adler * n), 0, 0, 0);
+        __m128i v_s2 = _mm_setr_epi32((int)sum2, 0, 0, 0);
+        __m128i v_s1 = zero;
+
+        blocks -= n;
+        do {
+            const __m128i b1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i b2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+
+            /* each block adds 32 times the running sum so far to sum2 */
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b1, zero));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                       _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+            v_s2 = _mm_add_epi32(v_s2,
+                       _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+            buf += 32;
+        } while (--n);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, 0xb1));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, 0x4e));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, 0xb1));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, 0x4e));
+        adler += (unsigned)_mm_cvtsi128_si32(v_s1);
+        sum2 = (unsigned)_mm_cvtsi128_si32(v_s2);
+        MOD(adler);
+        MOD(sum2);
+    }
+    *a = adler;
+    *s = sum2;
+}
+#endif
+
 /* ========================================================================= */
 uLong ZEXPORT adler32_z(uLong adler, const Bytef *buf, z_size_t len) {
     unsigned long sum2;
@@ -93,6 +175,14 @@ uLong ZEXPORT adler32_z(uLong adler, const Bytef *buf, z_size_t len) {
         return adler | (sum2 << 16);
     }
 
+#ifdef ADLER32_SSSE3
+    if (len >= 64 && adler32_have_ssse3()) {
+        adler32_ssse3(&adler, &sum2, buf, len & ~(z_size_t)31);
+        buf += len & ~(z_size_t)31;
+        len &= 31;
+    }
+#endif
+
     /* do length NMAX blocks -- requires just one modulo operation */
     while (len >= NMAX) {
         len -= NMAX;
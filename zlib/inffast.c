@@ -13,6 +13,30 @@
 #  pragma message("Assembler code may have bugs -- use at your own risk")
 #else
 
+/*
+   Copy a match of len bytes from dist bytes back in the output.  When the
+   match overlaps itself, the bytes from out - dist repeat with period dist,
+   so each memcpy() can take twice as much as the one before without its
+   source and destination overlapping.  Short matches are left to the byte
+   loop in inflate_fast(), which beats the calls.
+ */
+#define INFLATE_FAST_COPY_MIN 16
+
+local unsigned char FAR *copy_repeat(unsigned char FAR *out, unsigned dist,
+                                     unsigned len) {
+    unsigned char FAR *from = out - dist;
+    unsigned n = dist;
+
+    while (len > n) {
+        zmemcpy(out, from, n);
+        out += n;
+        len -= n;
+        n = (unsigned)(out - from);
+    }
+    zmemcpy(out, from, len);
+    return out + len;
+}
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -246,6 +270,8 @@ void ZLIB_INTERNAL inflate_fast(z_streamp strm, unsigned start) {
                             *out++ = *from++;
                     }
                 }
+                else if (len >= INFLATE_FAST_COPY_MIN)
+                    out = copy_repeat(out, dist, len);
                 else {
                     from = out - dist;          /* copy direct from output */
                     do {                        /* minimum length is three */